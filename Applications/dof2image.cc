@@ -26,6 +26,9 @@ void usage()
   cerr << "Usage: dof2image [image] [dof] [dx] [dy] [dz] <options>\n" << endl;
   cerr << "where <options> is one or more of the following:\n" << endl;
   cerr << "<-invert>                  Store the inverted displacement field" << endl;
+  cerr << "<-invert-fixed-point>      Store the inverted displacement field computed" << endl;
+  cerr << "                           by fixed-point iteration (tolerance 0.01 mm)" << endl;
+  cerr << "<-flatten>                 Merge levels of a multi-level FFD before evaluation" << endl;
   cerr << "<-image>                   Store the displacement field in terms of image coordinate" << endl;
   cerr << "<-total image>             Store the total displacement in image" << endl;
   cerr << "<-scale factor>            Scale displacement by a factor" << endl;
@@ -42,7 +45,7 @@ void usage()
 
 int main(int argc, char **argv)
 {
-  int x, y, z, t, ok, invert, imaged;
+  int x, y, z, t, ok, invert, fixed_point, imaged, flatten;
   int x1, y1, z1, t1, x2, y2, z2, t2;
   irtkGreyPixel padding;
   double p1[3], p2[3], scale;
@@ -90,7 +93,9 @@ int main(int argc, char **argv)
   scale   = 1;
   padding = MIN_GREY;
   invert  = false;
+  fixed_point = false;
   imaged   = false;
+  flatten  = false;
 
   // Parse arguments
   while (argc > 1) {
@@ -125,6 +130,18 @@ int main(int argc, char **argv)
       invert = true;
       ok = true;
     }
+    if ((ok == false) && (strcmp(argv[1], "-invert-fixed-point") == 0)) {
+      argc--;
+      argv++;
+      invert = fixed_point = true;
+      ok = true;
+    }
+    if ((ok == false) && (strcmp(argv[1], "-flatten") == 0)) {
+      argc--;
+      argv++;
+      flatten = true;
+      ok = true;
+    }
     if ((ok == false) && (strcmp(argv[1], "-image") == 0)) {
       argc--;
       argv++;
@@ -209,6 +226,20 @@ int main(int argc, char **argv)
     }
   }
 
+  // Merge levels of multi-level free-form deformation
+  if (flatten) {
+    irtkMultiLevelFreeFormTransformation *mffd;
+    mffd = dynamic_cast<irtkMultiLevelFreeFormTransformation *>(transform);
+    if (mffd && mffd->NumberOfLevels() > 1) {
+      if (mffd->CanCombineLocalTransformation()) {
+        mffd->CombineLocalTransformation();
+      } else {
+        cerr << "Warning: Cannot flatten multi-level transformation, levels are not"
+                " displacement FFDs of the same type on subdivided lattices" << endl;
+      }
+    }
+  }
+
   // If there is an region of interest, use it
   if ((x1 != 0) || (x2 != image.GetX()) ||
       (y1 != 0) || (y2 != image.GetY()) ||
@@ -228,8 +259,9 @@ int main(int argc, char **argv)
   for (t = 0; t < image.GetT(); t++) {
     double tt = image.ImageToTime(t);
     d = .0;
-    if (invert) transform->InverseDisplacement(d, ts, tt);
-    else        transform->Displacement       (d, ts, tt);
+    if      (fixed_point) transform->FixedPointInverseDisplacement(d, ts, tt);
+    else if (invert)      transform->InverseDisplacement          (d, ts, tt);
+    else                  transform->Displacement                 (d, ts, tt);
     for (z = 0; z < image.GetZ(); z++) {
       for (y = 0; y < image.GetY(); y++) {
         for (x = 0; x < image.GetX(); x++) {
@@ -32,7 +32,12 @@ using namespace irtk::polydata;
 #include <irtkGenericRegistrationLogger.h>
 #include <irtkGenericRegistrationDebugger.h>
 #include <irtkDilation.h>
+#include <irtkFileToImage.h>
 #include <memory>
+#include <atomic>
+#ifdef HAS_TBB
+#  include <tbb/pipeline.h>
+#endif
 
 // =============================================================================
 // Version and help
@@ -46,6 +51,7 @@ void PrintSynopsis(const char *name)
   cout << "       " << name << " -image <image1> <image2>... [options]" << endl;
   cout << "       " << name << " <image1> <image2>... [options]" << endl;
   cout << "       " << name << " <image_sequence> [options]" << endl;
+  cout << "       " << name << " <target> -batch <jobs.lst> [-jobs <n>] [options]" << endl;
 #ifdef HAS_VTK
   cout << "       " << name << " -pset <pointset1> [-dof <dof1>] -pset <pointset2> [-dof <dof2>]... [options]" << endl;
   cout << "       " << name << " <dataset1> <dataset2>... [options]" << endl;
@@ -79,6 +85,8 @@ void PrintUsage(const char* name)
   cout << "  -parin  <file>          Read parameters from configuration file. If \"stdin\" or \"cin\"," << endl;
   cout << "                          the parameters are read from standard input instead. (default: ireg.cfg)" << endl;
   cout << "  -parout <file>          Write parameters to the named configuration file. (default: none)" << endl;
+  cout << "  -batch  <file>          Register each source image listed in the given file. (default: none)" << endl;
+  cout << "  -jobs   <n>             Maximum number of concurrently executed -batch registrations. (default: 1)" << endl;
   cout << "  -v -verbose [n]         Increase/Set verbosity of output messages. (default: " << verbose << ")" << endl;
   cout << "  -h -[-]help             Print complete help and exit." << endl;
   cout << endl;
@@ -156,6 +164,10 @@ void PrintHelp(const char* name)
   cout << "                               energy function (i.e. image similarity). The registered images will" << endl;
   cout << "                               thus be resampled within the corresponding domain of the world system." << endl;
   cout << "                               By default, the foreground of the target image defines this domain." << endl;
+  cout << "  -mmap                        Map uncompressed input image files into memory instead of reading" << endl;
+  cout << "                               them. The image data is then shared with other processes using" << endl;
+  cout << "                               the same files. The input files must not be modified during the" << endl;
+  cout << "                               registration. (default: off)" << endl;
   cout << "  -dofins <file>               Read pairwise transformations from the files specified" << endl;
   cout << "                               in the given text file which lists for each pair-wise" << endl;
   cout << "                               transformation the corresponding target image, followed" << endl;
@@ -178,6 +190,20 @@ void PrintHelp(const char* name)
   cout << "                               written. This file is overwritten once the registration finished with" << endl;
   cout << "                               final configuration used during the course of the registration." << endl;
   cout << "                               (default: none)" << endl;
+  cout << "  -batch <file>                Run one registration for each line of the given text file. Each line" << endl;
+  cout << "                               contains the name of a source image and of the output transformation," << endl;
+  cout << "                               optionally followed by an initial transformation which overrides -dofin." << endl;
+  cout << "                               The source image takes the place of the last input image, i.e., I(2)" << endl;
+  cout << "                               when only the target image is given on the command-line. All other" << endl;
+  cout << "                               input data is read only once and the resolution pyramids of the" << endl;
+  cout << "                               input images are shared by all registrations. If \"stdin\" or \"cin\"," << endl;
+  cout << "                               the jobs are read from standard input and run as they arrive. The start," << endl;
+  cout << "                               end, or failure of each job is reported together with its output name." << endl;
+  cout << "                               A job whose input files cannot be read fails without affecting the other" << endl;
+  cout << "                               jobs. The exit status is non-zero when any job failed. (default: none)" << endl;
+  cout << "  -jobs <n>                    Maximum number of -batch registrations which are run concurrently." << endl;
+  cout << "                               The optimization progress of the individual registrations is only" << endl;
+  cout << "                               reported when the jobs are run one after another. (default: 1)" << endl;
   PrintCommonOptions(cout);
   cout << endl;
 }
@@ -421,7 +447,7 @@ struct ConcurrentImageReader
     for (size_t n = re.begin(); n != re.end(); ++n) {
       std::unique_ptr<irtkBaseImage> &image = (*_Image)[n];
       if (image.get() == NULL) {
-        image.reset(irtkBaseImage::New(_ImageName[n].c_str()));
+        image.reset(irtkBaseImage::New(_ImageName[n].c_str(), _MemoryMapping));
         if (!IsIdentity(_DoFName[n])) {
           std::unique_ptr<irtkTransformation> dof(irtkTransformation::New(_DoFName[n].c_str()));
           lin = dynamic_cast<irtkHomogeneousTransformation *>(dof.get());
@@ -442,14 +468,16 @@ struct ConcurrentImageReader
                   const vector<string>             &tname,
                   const vector<bool>               &tinv,
                   vector<std::unique_ptr<irtkBaseImage> > &image,
-                  Error                            *error)
+                  Error                            *error,
+                  bool                              mmap = false)
   {
     ConcurrentImageReader body;
-    body._ImageName = fname;
-    body._DoFName   = tname;
-    body._DoFInvert = tinv;
-    body._Image     = &image;
-    body._Error     = error;
+    body._ImageName     = fname;
+    body._DoFName       = tname;
+    body._DoFInvert     = tinv;
+    body._Image         = &image;
+    body._Error         = error;
+    body._MemoryMapping = mmap;
     blocked_range<size_t> idx(0, fname.size());
 //    parallel_for(idx, body);
     body(idx);
@@ -462,6 +490,7 @@ private:
   vector<bool>                      _DoFInvert;
   vector<std::unique_ptr<irtkBaseImage> > *_Image;
   Error                            *_Error;
+  bool                              _MemoryMapping;
 };
 
 // -----------------------------------------------------------------------------
@@ -528,6 +557,280 @@ public:
 };
 #endif
 
+// =============================================================================
+// Batch registration
+// =============================================================================
+
+// -----------------------------------------------------------------------------
+/// Registration job read from -batch list
+struct BatchRegistrationJob
+{
+  int    _Index;      ///< Line number of job in batch list
+  string _SourceName; ///< Name of source image file
+  string _DoFOutName; ///< Name of output transformation file
+  string _DoFInName;  ///< Name of initial transformation file (optional)
+};
+
+// -----------------------------------------------------------------------------
+/// Read next registration job from -batch list, invalid jobs are skipped
+/// and counted as failed jobs
+bool ReadBatchRegistrationJob(istream &is, int &line, BatchRegistrationJob &job,
+                              std::atomic<int> &nfailed)
+{
+  string str;
+  while (getline(is, str)) {
+    ++line;
+    istringstream ss(str);
+    job._Index = line;
+    job._SourceName.clear();
+    job._DoFOutName.clear();
+    job._DoFInName .clear();
+    ss >> job._SourceName;
+    if (job._SourceName.empty() || job._SourceName[0] == '#') continue;
+    ss >> job._DoFOutName >> job._DoFInName;
+    if (job._DoFOutName.empty()) {
+      cerr << "Error: Missing output transformation of job on line " << line << " of -batch list!" << endl;
+      ++nfailed;
+      continue;
+    }
+    return true;
+  }
+  return false;
+}
+
+// -----------------------------------------------------------------------------
+/// Input data and settings shared by all registrations of a batch
+struct BatchRegistrationSettings
+{
+  const char                             *_ParInName;     ///< Configuration file
+  string                                  _Params;        ///< Command-line parameters
+  string                                  _StdinParams;   ///< Parameters read from standard input
+  vector<const irtkBaseImage *>           _Image;         ///< Resident input images
+  double                                  _SourceTime;    ///< Time of source images
+#ifdef HAS_VTK
+  vector<vtkSmartPointer<vtkPointSet> >   _PointSet;      ///< Input point sets
+  vector<double>                          _PointSetTime;  ///< Time of input point sets
+#endif
+  const irtkTransformation               *_InitialGuess;  ///< Default initial guess
+  irtkBinaryImage                        *_Domain;        ///< Registration domain
+  bool                                    _MemoryMapping; ///< Whether to memory map source images
+  bool                                    _Log;           ///< Whether to report progress of each registration
+  irtkGenericRegistrationFilter::ImagePyramidCache _PyramidCache; ///< Shared image resolution pyramids
+  std::mutex                              _OutputMutex;    ///< Serializes output of concurrent jobs
+  std::atomic<int>                        _NumberOfFailedJobs; ///< Number of jobs which failed
+
+  BatchRegistrationSettings() : _NumberOfFailedJobs(0) {}
+};
+
+// -----------------------------------------------------------------------------
+/// Task which runs one registration of a batch
+class BatchRegistrationTask
+{
+  BatchRegistrationSettings *_Settings;
+  BatchRegistrationJob       _Job;
+
+public:
+
+  BatchRegistrationTask(BatchRegistrationSettings *settings, const BatchRegistrationJob &job)
+  :
+    _Settings(settings), _Job(job)
+  {}
+
+  void operator ()() const
+  {
+    BatchRegistrationSettings &settings = *_Settings;
+
+#ifdef HAS_TBB
+    tick_count start_time = tick_count::now();
+#else
+    clock_t start_time = clock();
+#endif
+    Report("started");
+
+    // Apply same configuration to each registration
+    irtkGenericRegistrationFilter registration;
+    if (settings._ParInName && !registration.Read(settings._ParInName)) {
+      Failed("failed to read configuration file");
+      return;
+    }
+    istringstream params(settings._Params);
+    istringstream stdin_params(settings._StdinParams);
+    if (!registration.Read(params) || !registration.Read(stdin_params)) {
+      Failed("failed to parse configuration");
+      return;
+    }
+
+    // Read source image of this job, checking the file first as the image
+    // readers terminate the program when the file cannot be read
+    std::unique_ptr<irtkBaseImage> source;
+    if (irtkFileToImage::CheckFormat(_Job._SourceName.c_str())) {
+      source.reset(irtkBaseImage::New(_Job._SourceName.c_str(), settings._MemoryMapping));
+    }
+    if (!source) {
+      Failed("failed to read source image");
+      return;
+    }
+
+    // Set input images, where the source of this job replaces the last image
+    source->PutTOrigin(settings._SourceTime);
+    for (size_t n = 0; n + 1 < settings._Image.size(); ++n) {
+      registration.AddInput(settings._Image[n]);
+    }
+    registration.AddInput(source.get());
+#ifdef HAS_VTK
+    for (size_t n = 0; n < settings._PointSet.size(); ++n) {
+      registration.AddInput(settings._PointSet[n], settings._PointSetTime[n]);
+    }
+#endif
+    registration.PyramidCache(&settings._PyramidCache);
+
+    // Set initial guess and registration domain
+    std::unique_ptr<irtkTransformation> dofin;
+    if (!_Job._DoFInName.empty()) {
+      if (IsIdentity(_Job._DoFInName)) {
+        dofin.reset(new irtkRigidTransformation());
+      } else if (irtkTransformation::CheckHeader(_Job._DoFInName.c_str())) {
+        dofin.reset(irtkTransformation::New(_Job._DoFInName.c_str()));
+      }
+      if (!dofin) {
+        Failed("failed to read initial transformation");
+        return;
+      }
+      registration.InitialGuess(dofin.get());
+    } else {
+      registration.InitialGuess(settings._InitialGuess);
+    }
+    registration.Domain(settings._Domain);
+
+    // Run registration
+    irtkGenericRegistrationLogger logger;
+    logger.Verbosity(verbose - 1);
+    if (settings._Log) registration.AddObserver(logger);
+
+    irtkTransformation *dofout = NULL;
+    registration.Output(&dofout);
+    registration.Run();
+    registration.DeleteObserver(logger);
+    if (!dofout) {
+      Failed("failed to compute transformation");
+      return;
+    }
+
+    // Write final transformation
+    if (dofout->TypeOfClass() == IRTKTRANSFORMATION_SIMILARITY) {
+      irtkAffineTransformation aff(*static_cast<irtkSimilarityTransformation *>(dofout));
+      aff.Write(_Job._DoFOutName.c_str());
+    } else {
+      dofout->Write(_Job._DoFOutName.c_str());
+    }
+    delete dofout;
+
+    if (verbose) {
+      double elapsed_time;
+#ifdef HAS_TBB
+      elapsed_time = (tick_count::now() - start_time).seconds();
+#else
+      elapsed_time = static_cast<double>(clock() - start_time)
+                   / static_cast<double>(CLOCKS_PER_SEC);
+#endif
+      int m = floor(elapsed_time / 60.0);
+      int s = round(elapsed_time - m * 60);
+      if (s == 60) m += 1, s = 0;
+      Report(("finished in " + ToString(m) + " min " + ToString(s) + " sec").c_str());
+    }
+  }
+
+private:
+
+  /// Report progress of job, errors are reported even when verbose is 0
+  void Report(const char *msg, bool error = false) const
+  {
+    if (!error && !verbose) return;
+    std::lock_guard<std::mutex> lock(_Settings->_OutputMutex);
+    ostream &os = (error ? cerr : cout);
+    if (_Settings->_Log && !error) os << "\n";
+    os << "Job " << _Job._Index << ": " << _Job._SourceName << " -> " << _Job._DoFOutName << " " << msg << endl;
+  }
+
+  /// Report failure of job and count it
+  void Failed(const char *msg) const
+  {
+    ++_Settings->_NumberOfFailedJobs;
+    Report(msg, true);
+  }
+};
+
+#ifdef HAS_TBB
+// -----------------------------------------------------------------------------
+/// Input filter of batch pipeline which reads the next job from the -batch list
+class ReadBatchRegistrationJobFilter
+{
+  istream          *_Stream;
+  int              *_Line;
+  std::atomic<int> *_NumberOfFailedJobs;
+
+public:
+
+  ReadBatchRegistrationJobFilter(istream &is, int &line, std::atomic<int> &nfailed)
+  :
+    _Stream(&is), _Line(&line), _NumberOfFailedJobs(&nfailed)
+  {}
+
+  BatchRegistrationJob operator ()(flow_control &fc) const
+  {
+    BatchRegistrationJob job;
+    if (!ReadBatchRegistrationJob(*_Stream, *_Line, job, *_NumberOfFailedJobs)) fc.stop();
+    return job;
+  }
+};
+
+// -----------------------------------------------------------------------------
+/// Parallel filter of batch pipeline which runs a job
+class RunBatchRegistrationJobFilter
+{
+  BatchRegistrationSettings *_Settings;
+
+public:
+
+  RunBatchRegistrationJobFilter(BatchRegistrationSettings *settings)
+  :
+    _Settings(settings)
+  {}
+
+  void operator ()(const BatchRegistrationJob &job) const
+  {
+    BatchRegistrationTask(_Settings, job)();
+  }
+};
+#endif
+
+// -----------------------------------------------------------------------------
+/// Run registrations listed in -batch file, at most njobs at a time
+///
+/// The jobs are processed by a pipeline whose input filter reads one job
+/// at a time. A job starts as soon as it was read and fewer than njobs jobs
+/// are running, i.e., jobs read from standard input start when they arrive.
+void RunBatchRegistration(istream &is, BatchRegistrationSettings &settings, int njobs)
+{
+  BatchRegistrationJob job;
+  int                  line = 0;
+  // The first job runs on its own such that the resolution pyramids of
+  // the resident images are computed only once and cached for the others
+  if (!ReadBatchRegistrationJob(is, line, job, settings._NumberOfFailedJobs)) return;
+  BatchRegistrationTask(&settings, job)();
+#ifdef HAS_TBB
+  parallel_pipeline(njobs,
+    make_filter<void, BatchRegistrationJob>(filter::serial_in_order,
+                                            ReadBatchRegistrationJobFilter(is, line, settings._NumberOfFailedJobs)) &
+    make_filter<BatchRegistrationJob, void>(filter::parallel,
+                                            RunBatchRegistrationJobFilter(&settings)));
+#else
+  while (ReadBatchRegistrationJob(is, line, job, settings._NumberOfFailedJobs)) {
+    BatchRegistrationTask(&settings, job)();
+  }
+#endif
+}
+
 // =============================================================================
 // Main function
 // =============================================================================
@@ -579,6 +882,9 @@ int main(int argc, char **argv)
   const char *parin_name         = NULL;
   const char *parout_name        = NULL;
   const char *mask_name          = NULL;
+  bool        mmap_images        = false;
+  const char *batch_name         = NULL;
+  int         njobs              = 1;
   stringstream params;
 
   enum {
@@ -653,7 +959,16 @@ int main(int argc, char **argv)
     else if (OPTION("-dofin" )) dofin_name      = ARGUMENT;
     else if (OPTION("-dofout")) dofout_name     = ARGUMENT;
     else if (OPTION("-mask"))   mask_name       = ARGUMENT;
+    else if (OPTION("-mmap"))   mmap_images     = true;
     else if (OPTION("-nodebug-level-prefix")) debug_output_level_prefix = false;
+    else if (OPTION("-batch"))  batch_name      = ARGUMENT;
+    else if (OPTION("-jobs")) {
+      const char *arg = ARGUMENT;
+      if (!FromString(arg, njobs) || njobs < 1) {
+        cerr << "Invalid -jobs argument: " << arg << endl;
+        exit(1);
+      }
+    }
     // Parameter
     else if (OPTION("-par"))    params << ARGUMENT << endl;
     else if (OPTION("-parin" )) parin_name      = ARGUMENT;
@@ -676,6 +991,26 @@ int main(int argc, char **argv)
     exit(1);
   }
 
+  // Source image of each -batch job takes the place of the last input image
+  bool batch_stdin = (batch_name && (strcmp(batch_name, "stdin") == 0 ||
+                                     strcmp(batch_name, "STDIN") == 0 ||
+                                     strcmp(batch_name, "cin")   == 0));
+  if (batch_name) {
+    if (parout_name) {
+      cerr << "Option -parout cannot be used together with -batch" << endl;
+      exit(1);
+    }
+    if (batch_stdin && parin_name && (strcmp(parin_name, "stdin") == 0 ||
+                                      strcmp(parin_name, "STDIN") == 0 ||
+                                      strcmp(parin_name, "cin")   == 0)) {
+      cerr << "Options -parin and -batch cannot both read from standard input" << endl;
+      exit(1);
+    }
+    image_names .push_back(string());
+    imdof_names .push_back("identity");
+    imdof_invert.push_back(false);
+  }
+
   // ---------------------------------------------------------------------------
   // Print version information
   if (verbose) {
@@ -700,16 +1035,20 @@ int main(int argc, char **argv)
     exit(1);
   }
   // 2. Set parameters provided as command arguments
+  const string params_text = params.str();
   if (!registration.Read(params, verbose > 2)) {
     cerr << "Failed to parse configuration given as command arguments!" << endl;
     exit(1);
   }
   // 3. Add any parameters read from standard input stream
+  string stdin_params;
   if (parin_stdin) {
     if (verbose) {
       cout << "\nEnter additional parameters now (press Ctrl-D to continue):" << endl;
     }
-    if (!registration.Read(cin, verbose > 2)) {
+    stdin_params.assign(istreambuf_iterator<char>(cin), istreambuf_iterator<char>());
+    istringstream is(stdin_params);
+    if (!registration.Read(is, verbose > 2)) {
       cerr << "Failed to read configuration from standard input stream!" << endl;
       exit(1);
     }
@@ -727,7 +1066,7 @@ int main(int argc, char **argv)
   vector<std::unique_ptr<irtkBaseImage> > images;
 
   if (image_names.size() == 1) {
-    std::unique_ptr<irtkBaseImage> sequence(irtkBaseImage::New(image_names[0].c_str()));
+    std::unique_ptr<irtkBaseImage> sequence(irtkBaseImage::New(image_names[0].c_str(), mmap_images));
     const int nframes = sequence->GetT();
     if (nframes < 2) {
       if (verbose > 1) cout << " failed\n" << endl;
@@ -779,6 +1118,10 @@ int main(int argc, char **argv)
                                   static_cast<int>(pset_names .size()), 1);
 
   const int nimages = registration.NumberOfRequiredImages();
+  if (batch_name && nimages != static_cast<int>(image_names.size())) {
+    cerr << "Error: Source image of -batch jobs must be used by the energy function!" << endl;
+    exit(1);
+  }
   image_names .resize(nimages);
   image_times .resize(nimages);
   imdof_names .resize(nimages);
@@ -816,11 +1159,17 @@ int main(int argc, char **argv)
       cout.flush();
     }
 
+    // Source images of -batch jobs are read by the respective job
+    const int nread = (batch_name ? nimages - 1 : nimages);
+    vector<string> read_names       (image_names .begin(), image_names .begin() + nread);
+    vector<string> read_dof_names   (imdof_names .begin(), imdof_names .begin() + nread);
+    vector<bool>   read_dof_invert  (imdof_invert.begin(), imdof_invert.begin() + nread);
+
     ConcurrentImageReader::Error *errors = new ConcurrentImageReader::Error[nimages];
-    ConcurrentImageReader::Run(image_names, imdof_names, imdof_invert, images, errors);
+    ConcurrentImageReader::Run(read_names, read_dof_names, read_dof_invert, images, errors, mmap_images);
 
     int nerrors = 0;
-    for (int n = 0; n < nimages; ++n) {
+    for (int n = 0; n < nread; ++n) {
       if (errors[n] == ConcurrentImageReader::InvalidDoF) {
         ++nerrors;
         if (verbose > 1 && nerrors == 1) cout << " failed\n" << endl;
@@ -837,6 +1186,7 @@ int main(int argc, char **argv)
 
   // Set input images
   for (int n = 0; n < nimages; ++n) {
+    if (!images[n]) continue; // -batch source image
     images[n]->PutTOrigin(image_times[n]);
     registration.AddInput(images[n].get());
   }
@@ -906,6 +1256,47 @@ int main(int argc, char **argv)
 
   IRTK_DEBUG_TIMING(1, "reading input data");
 
+  // ---------------------------------------------------------------------------
+  // Run batch of registrations which share the input data read so far
+  if (batch_name) {
+    BatchRegistrationSettings settings;
+    settings._ParInName     = (parin_stdin ? NULL : parin_name);
+    settings._Params        = params_text;
+    settings._StdinParams   = stdin_params;
+    settings._SourceTime    = image_times.back();
+    settings._InitialGuess  = dofin.get();
+    settings._Domain        = mask.get();
+    settings._MemoryMapping = mmap_images;
+    settings._Log           = (njobs == 1 && ((debug_time == 0 && verbose > 0) ||
+                                              (debug_time  > 0 && verbose > 1)));
+    for (int n = 0; n < nimages; ++n) {
+      settings._Image.push_back(images[n].get());
+      if (images[n]) settings._PyramidCache.AddImage(images[n].get());
+    }
+#ifdef HAS_VTK
+    settings._PointSet     = psets;
+    settings._PointSetTime = pset_times;
+#endif
+    if (batch_stdin) {
+      RunBatchRegistration(cin, settings, njobs);
+    } else {
+      ifstream is(batch_name);
+      if (!is) {
+        cerr << "Error: Failed to open -batch list file " << batch_name << "!" << endl;
+        exit(1);
+      }
+      RunBatchRegistration(is, settings, njobs);
+    }
+    // Exit with non-zero status if any job failed such that scripts
+    // which submit a batch to a cluster can detect the failure
+    const int nfailed = settings._NumberOfFailedJobs;
+    if (nfailed > 0) {
+      cerr << "Error: " << nfailed << " job(s) of -batch list failed!" << endl;
+      return 1;
+    }
+    return 0;
+  }
+
   // ---------------------------------------------------------------------------
   // Run registration
   irtkGenericRegistrationLogger   logger;
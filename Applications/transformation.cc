@@ -55,6 +55,13 @@ void PrintHelp(const char *name)
   cout << "  -Tp <value>      Target padding value" << endl;
   cout << "  -Sp <value>      Source padding value" << endl;
   cout << "  -invert          Invert transformation" << endl;
+  cout << "  -invert-fixed-point" << endl;
+  cout << "                   Invert transformation by fixed-point iteration on a" << endl;
+  cout << "                   dense displacement field (tolerance 0.01 mm). Faster" << endl;
+  cout << "                   than -invert for free-form deformations." << endl;
+  cout << "  -flatten         Merge levels of a multi-level free-form deformation" << endl;
+  cout << "                   into a single B-spline lattice with the finest" << endl;
+  cout << "                   control point spacing before resampling." << endl;
   cout << "  -nn              Nearst Neighbor interpolation" << endl;
   cout << "  -linear          Linear interpolation" << endl;
   cout << "  -bspline         B-spline interpolation" << endl;
@@ -113,7 +120,9 @@ int main(int argc, char **argv)
   int  target_padding  = MIN_GREY;
   bool matchSourceType = false;
   bool invert          = false;
+  bool fixed_point     = false;
   bool twod            = false;
+  bool flatten         = false;
 
   for (ALL_OPTIONS) {
       if      (OPTION("-dof")    ) dof_name       = ARGUMENT, dof_invert = false;
@@ -143,7 +152,9 @@ int main(int argc, char **argv)
       else if (OPTION("-Tp")     ) target_padding = atoi(ARGUMENT);
       else if (OPTION("-Sp")     ) source_padding = atoi(ARGUMENT);
       else if (OPTION("-invert") ) invert         = true;
+      else if (OPTION("-invert-fixed-point")) invert = fixed_point = true;
       else if (OPTION("-2d")     ) twod           = true;
+      else if (OPTION("-flatten")) flatten        = true;
       else if (OPTION("-nn")     ) interpolation  = Interpolation_NN;
       else if (OPTION("-linear") ) interpolation  = Interpolation_Linear;
       else if (OPTION("-bspline")) interpolation  = Interpolation_BSpline;
@@ -269,6 +280,20 @@ int main(int argc, char **argv)
     transformation.reset(irtkTransformation::New(dofin_name));
   }
 
+  // Merge levels of multi-level free-form deformation
+  if (flatten) {
+    irtkMultiLevelFreeFormTransformation *mffd;
+    mffd = dynamic_cast<irtkMultiLevelFreeFormTransformation *>(transformation.get());
+    if (mffd && mffd->NumberOfLevels() > 1) {
+      if (mffd->CanCombineLocalTransformation()) {
+        mffd->CombineLocalTransformation();
+      } else {
+        cerr << "Warning: Cannot flatten multi-level transformation, levels are not"
+                " displacement FFDs of the same type on subdivided lattices" << endl;
+      }
+    }
+  }
+
   // Create image transformation filter
   std::unique_ptr<irtkImageTransformation> imagetransformation(irtkImageTransformation::New(transformation.get()));
 
@@ -280,6 +305,7 @@ int main(int argc, char **argv)
 
   if (invert) imagetransformation->InvertOn();
   else        imagetransformation->InvertOff();
+  imagetransformation->FixedPointInversion(fixed_point);
 
   if (twod)   imagetransformation->TwoDOn();
   else        imagetransformation->TwoDOff();
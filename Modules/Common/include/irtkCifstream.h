@@ -27,6 +27,12 @@
  *
  * This class defines and implements functions for reading compressed file
  * streams. The file streams can be either uncompressed or compressed.
+ *
+ * Files written by irtkCofstream consist of independently compressed gzip
+ * members whose sizes are recorded in the member headers (see irtkGzip).
+ * For such files, an index of the members is built when the file is opened
+ * and larger reads decompress the members in parallel. Other files are read
+ * sequentially using zlib.
  */
 
 class irtkCifstream : public irtkObject
@@ -40,6 +46,35 @@ class irtkCifstream : public irtkObject
   FILE  *_File;
 #endif
 
+#ifdef HAS_ZLIB
+  /// File pointer to file consisting of indexed gzip members
+  FILE *_Indexed;
+
+  /// Offsets of gzip members in compressed file (plus file size)
+  vector<long> _MemberOffset;
+
+  /// Offsets of gzip members in uncompressed data (plus data size)
+  vector<long> _DataOffset;
+
+  /// Current position in uncompressed data of indexed file
+  long _Position;
+
+  /// Index of gzip member whose uncompressed data is cached
+  int _CachedMember;
+
+  /// Uncompressed data of cached gzip member
+  vector<char> _Cache;
+
+  /// Build index of gzip members, returns false if file is not indexed
+  bool BuildIndex();
+
+  /// Read and decompress gzip member into cache
+  bool CacheMember(int);
+
+  /// Read from indexed file at current position
+  bool ReadIndexed(char *, long);
+#endif
+
   /// Flag indicating whether file bytes are swapped
   irtkPublicAttributeMacro(bool, Swapped);
 
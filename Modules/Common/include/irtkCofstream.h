@@ -27,20 +27,32 @@
  * Class for writing (compressed) file streams.
  *
  * This class defines and implements functions for writing compressed file
- * streams. At the moment only the writing of uncompressed file streams is
- * supported.
+ * streams. Files with extension .gz are compressed in blocks of fixed size
+ * which are deflated in parallel. Each block is written as a separate gzip
+ * member, i.e., the output is a standard gzip file which can be decompressed
+ * by any gzip compatible tool. The header of each member records the size of
+ * the compressed member in an extra field, which allows irtkCifstream to
+ * locate and decompress the members in parallel.
  */
 
 class irtkCofstream : public irtkObject
 {
   irtkObjectMacro(irtkCofstream);
 
-  /// File pointer to uncompressed file
+  /// File pointer to (possibly compressed) output file
   FILE *_File;
 
 #ifdef HAS_ZLIB
-  /// File pointer to compressed file
-  gzFile _ZFile;
+  /// Uncompressed data which has not been written to the compressed file yet
+  vector<char> _Buffer;
+
+  /// Current position in uncompressed data stream
+  long _Position;
+
+  /// Compress and write buffered data
+  ///
+  /// \param[in] all Whether to also write the last incomplete block.
+  bool Flush(bool all);
 #endif
 
   /// Flag whether file is compressed
@@ -107,7 +119,10 @@ public:
   void Open(const char *);
 
   /// Close file
-  void Close();
+  ///
+  /// \returns Whether all buffered data was written successfully. Compressed
+  ///          data may only be written to the file when it is closed.
+  bool Close();
 
   /// Returns whether file is compressed
   /// \deprecated Used Compressed() instead.
@@ -29,6 +29,7 @@
 #include <irtkObservable.h>
 #include <irtkCifstream.h>
 #include <irtkCofstream.h>
+#include <irtkMemoryMappedFile.h>
 #include <irtkIndent.h>
 #include <irtkAllocate.h>
 #include <irtkDeallocate.h>
@@ -29,6 +29,12 @@
 /// 0: single-precision 1: double-precision
 #define USE_FLOAT_BY_DEFAULT 0
 
+/// Precision of the channels of registered images used by image similarities
+/// 0: double-precision 1: single-precision (sums are accumulated in double)
+#ifndef USE_FLOAT_FOR_REGISTERED_IMAGE
+#  define USE_FLOAT_FOR_REGISTERED_IMAGE 0
+#endif
+
 // ===========================================================================
 // CUDA
 // ===========================================================================
@@ -0,0 +1,94 @@
+/* The Image Registration Toolkit (IRTK)
+ *
+ * Copyright 2008-2015 Imperial College London
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+
+#ifndef _IRTKGZIP_H
+#define _IRTKGZIP_H
+
+#ifdef HAS_ZLIB
+
+#include <irtkCxxLib.h>
+
+
+/**
+ * Auxiliary functions for block-parallel gzip compression.
+ *
+ * Compressed data is written as sequence of gzip members, each compressing
+ * one block of at most BlockSize bytes. Concatenated gzip members form a
+ * valid gzip file (RFC 1952). The header of each member contains an extra
+ * subfield with identifier SubfieldId which stores the total size of the
+ * compressed member in bytes (4 byte, little endian). Readers can thus find
+ * all members without decompressing the data and inflate them in parallel.
+ *
+ * \sa irtkCifstream, irtkCofstream
+ */
+
+namespace irtkGzip {
+
+
+/// Size of uncompressed data blocks which are compressed independently
+const long BlockSize = 1 << 20;
+
+/// Number of blocks which are compressed in parallel at a time
+const int BlocksPerBatch = 32;
+
+/// Identifier of extra subfield in gzip member header with member size
+const unsigned char SubfieldId[2] = {'I', 'R'};
+
+/// Size of gzip member header including the extra field
+const int HeaderSize = 10 + 2 + 8;
+
+/// Size of gzip member trailer
+const int TrailerSize = 8;
+
+/// Compress block of data as single gzip member
+///
+/// \param[in]  data Uncompressed data.
+/// \param[in]  size Size of uncompressed data in bytes.
+/// \param[out] out  Compressed gzip member.
+///
+/// \returns Whether the data was compressed successfully.
+bool Deflate(const char *data, long size, vector<char> &out);
+
+/// Parse header of gzip member
+///
+/// \param[in]  data   Start of gzip member.
+/// \param[in]  avail  Number of available bytes.
+/// \param[out] size   Total size of member (header + data + trailer) in bytes.
+/// \param[out] offset Offset of compressed data relative to member start.
+///
+/// \returns Whether the header contains the member size subfield.
+bool ParseHeader(const unsigned char *data, long avail, long &size, long &offset);
+
+/// Inflate gzip member
+///
+/// \param[in]  data  Start of compressed gzip member.
+/// \param[in]  size  Total size of the member in bytes.
+/// \param[out] out   Output buffer of size of the uncompressed data.
+/// \param[in]  usize Size of uncompressed data in bytes.
+///
+/// \returns Whether the member was decompressed successfully.
+bool Inflate(const char *data, long size, char *out, long usize);
+
+/// Read unsigned 32-bit little endian integer, e.g., ISIZE field of trailer
+unsigned long GetLE32(const unsigned char *);
+
+
+} // namespace irtkGzip
+
+#endif // HAS_ZLIB
+
+#endif
@@ -0,0 +1,108 @@
+/* The Image Registration Toolkit (IRTK)
+ *
+ * Copyright 2008-2015 Imperial College London
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+
+#ifndef _IRTKMEMORYMAPPEDFILE_H
+#define _IRTKMEMORYMAPPEDFILE_H
+
+#include <irtkObject.h>
+
+
+/**
+ * Read-only file mapped into the address space of the process.
+ *
+ * The file is mapped privately with copy-on-write semantics. The mapped
+ * memory can thus be modified without affecting the file on disk, and
+ * only modified pages are copied into private memory of the process.
+ * Unmodified pages are backed by the page cache of the operating system
+ * and shared by all processes mapping the same file.
+ *
+ * \attention The file must not be truncated or overwritten while it is
+ *            mapped into memory, e.g., by writing an image to the same file.
+ */
+
+class irtkMemoryMappedFile : public irtkObject
+{
+  irtkObjectMacro(irtkMemoryMappedFile);
+
+  /// Start address of mapped memory
+  char *_Data;
+
+  /// Size of mapped memory in bytes
+  size_t _Size;
+
+  /// Copy constructor
+  /// \note Intentionally not implemented
+  irtkMemoryMappedFile(const irtkMemoryMappedFile &);
+
+  /// Assignment operator
+  /// \note Intentionally not implemented
+  irtkMemoryMappedFile &operator =(const irtkMemoryMappedFile &);
+
+public:
+
+  /// Constructor
+  irtkMemoryMappedFile();
+
+  /// Destructor
+  ~irtkMemoryMappedFile();
+
+  /// Whether memory mapping of files is supported on this platform
+  static bool IsSupported();
+
+  /// Map file into memory
+  ///
+  /// \returns Whether the file was mapped successfully.
+  bool Open(const char *);
+
+  /// Unmap file
+  void Close();
+
+  /// Whether a file is currently mapped
+  bool IsOpen() const;
+
+  /// Start address of mapped file contents
+  char *Data() const;
+
+  /// Size of mapped file in bytes
+  size_t Size() const;
+
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Inline definitions
+////////////////////////////////////////////////////////////////////////////////
+
+// -----------------------------------------------------------------------------
+inline bool irtkMemoryMappedFile::IsOpen() const
+{
+  return _Data != NULL;
+}
+
+// -----------------------------------------------------------------------------
+inline char *irtkMemoryMappedFile::Data() const
+{
+  return _Data;
+}
+
+// -----------------------------------------------------------------------------
+inline size_t irtkMemoryMappedFile::Size() const
+{
+  return _Size;
+}
+
+
+#endif
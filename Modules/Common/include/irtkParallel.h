@@ -68,6 +68,7 @@ void PrintParallelOptions(std::ostream &);
 #include <tbb/blocked_range3d.h>
 #include <tbb/parallel_for.h>
 #include <tbb/parallel_reduce.h>
+#include <tbb/task_group.h>
 #include <tbb/concurrent_queue.h>
 #include <tbb/mutex.h>
 
@@ -187,6 +188,15 @@ extern std::unique_ptr<task_scheduler_init> tbb_scheduler;
     body(range);
   }
 
+  /// task_group dummy class which executes each task serially when it is run
+  class task_group
+  {
+  public:
+    template <class Functor>
+    void run(const Functor &f) { f(); }
+    void wait() {}
+  };
+
 #endif // HAS_TBB
 
 
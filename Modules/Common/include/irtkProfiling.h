@@ -19,6 +19,7 @@
 
 #include <iostream>
 #include <sstream>
+#include <string>
 #include <time.h>
 
 #ifdef HAS_TBB
@@ -80,12 +81,16 @@ void PrintElapsedTime(const char *, double, TimeUnit = TIME_IN_SECONDS);
 /// @sa IRTK_END_TIMING
 #ifdef USE_TIMING
 #  ifdef HAS_TBB
-#    define IRTK_START_TIMING()   tbb::tick_count t_start = tbb::tick_count::now()
+#    define IRTK_START_TIMING()                                                \
+       tbb::tick_count t_start = tbb::tick_count::now();                       \
+       _IRTK_PROFILE_START_TIMING()
 #  else
-#    define IRTK_START_TIMING()   clock_t t_start = clock()
+#    define IRTK_START_TIMING()                                                \
+       clock_t t_start = clock();                                              \
+       _IRTK_PROFILE_START_TIMING()
 #  endif
 #else
-#  define IRTK_START_TIMING()   do {} while (false)
+#  define IRTK_START_TIMING()   _IRTK_PROFILE_START_TIMING()
 #endif
 
 // -----------------------------------------------------------------------------
@@ -105,12 +110,16 @@ void PrintElapsedTime(const char *, double, TimeUnit = TIME_IN_SECONDS);
 /// @sa IRTK_END_TIMING
 #ifdef USE_TIMING
 #  ifdef HAS_TBB
-#    define IRTK_RESET_TIMING()   t_start = tbb::tick_count::now()
+#    define IRTK_RESET_TIMING()                                                \
+       t_start = tbb::tick_count::now();                                       \
+       _IRTK_PROFILE_RESET_TIMING()
 #  else
-#    define IRTK_RESET_TIMING()   t_start = clock()
+#    define IRTK_RESET_TIMING()                                                \
+       t_start = clock();                                                      \
+       _IRTK_PROFILE_RESET_TIMING()
 #  endif
 #else
-#  define IRTK_RESET_TIMING()   do {} while (false)
+#  define IRTK_RESET_TIMING()   _IRTK_PROFILE_RESET_TIMING()
 #endif
 
 // -----------------------------------------------------------------------------
@@ -126,7 +135,8 @@ void PrintElapsedTime(const char *, double, TimeUnit = TIME_IN_SECONDS);
 ///
 /// @note Whether or not the execution time is actually being measured and
 ///       printed to screen is decided at compile time depending on the
-///       USE_TIMING flag.
+///       USE_TIMING flag. The section is recorded by irtkProfiler when
+///       it is enabled, independent of this flag.
 ///
 /// @sa IRTK_START_TIMING
 #ifdef USE_TIMING
@@ -137,6 +147,7 @@ void PrintElapsedTime(const char *, double, TimeUnit = TIME_IN_SECONDS);
          oss << section;                                                       \
          PrintElapsedTime(oss.str().c_str(),                                   \
                           (tbb::tick_count::now() - t_start).seconds());       \
+         _IRTK_PROFILE_END_TIMING(oss.str());                                  \
        } while (false)
 #  else
 #    define IRTK_END_TIMING(section)                                           \
@@ -146,10 +157,18 @@ void PrintElapsedTime(const char *, double, TimeUnit = TIME_IN_SECONDS);
          PrintElapsedTime(oss.str().c_str(),                                   \
                           static_cast<double>(clock() - t_start)               \
                         / static_cast<double>(CLOCKS_PER_SEC));                \
+         _IRTK_PROFILE_END_TIMING(oss.str());                                  \
        } while (false)
 #  endif
 #else
-#  define IRTK_END_TIMING(section)   do {} while (false)
+#  define IRTK_END_TIMING(section)                                             \
+     do {                                                                      \
+       if (irtkProfiler::IsEnabled()) {                                        \
+         std::ostringstream oss;                                               \
+         oss << section;                                                       \
+         _IRTK_PROFILE_END_TIMING(oss.str());                                  \
+       }                                                                       \
+     } while (false)
 #endif
 
 // -----------------------------------------------------------------------------
@@ -178,36 +197,169 @@ void PrintElapsedTime(const char *, double, TimeUnit = TIME_IN_SECONDS);
 ///
 /// @note Whether or not the execution time is actually being measured and
 ///       printed to screen is decided at runtime depending on the global
-///       variable debug_time.
+///       variable debug_time. The section is recorded by irtkProfiler when
+///       it is enabled, independent of the debugging level.
 ///
 /// @sa IRTK_START_TIMING
 #ifdef USE_TIMING
 #  ifdef HAS_TBB
 #    define IRTK_DEBUG_TIMING(level, section)                                  \
        do {                                                                    \
-         if (debug_time >= level) {                                            \
+         if (debug_time >= level || irtkProfiler::IsEnabled()) {               \
            std::ostringstream oss;                                             \
            oss << section;                                                     \
-           PrintElapsedTime(oss.str().c_str(),                                 \
-                            (tbb::tick_count::now() - t_start).seconds());     \
+           if (debug_time >= level) {                                          \
+             PrintElapsedTime(oss.str().c_str(),                               \
+                              (tbb::tick_count::now() - t_start).seconds());   \
+           }                                                                   \
+           _IRTK_PROFILE_END_TIMING(oss.str());                                \
          }                                                                     \
        } while (false)
 #  else
 #    define IRTK_DEBUG_TIMING(level, section)                                  \
        do {                                                                    \
-         if (debug_time >= level) {                                            \
+         if (debug_time >= level || irtkProfiler::IsEnabled()) {               \
            std::ostringstream oss;                                             \
            oss << section;                                                     \
-           PrintElapsedTime(oss.str().c_str(),                                 \
-                            static_cast<double>(clock() - t_start)             \
-                          / static_cast<double>(CLOCKS_PER_SEC));              \
+           if (debug_time >= level) {                                          \
+             PrintElapsedTime(oss.str().c_str(),                               \
+                              static_cast<double>(clock() - t_start)           \
+                            / static_cast<double>(CLOCKS_PER_SEC));            \
+           }                                                                   \
+           _IRTK_PROFILE_END_TIMING(oss.str());                                \
          }                                                                     \
        } while (false)
 #  endif
 #else
-#  define IRTK_DEBUG_TIMING(level, section)   do {} while (false)
+#  define IRTK_DEBUG_TIMING(level, section)   IRTK_END_TIMING(section)
 #endif
 
+// =============================================================================
+// Region profiling
+// =============================================================================
+
+// -----------------------------------------------------------------------------
+/// Hierarchical profiler of named code regions
+///
+/// When enabled, e.g., using the -profile <file> option, the start and end
+/// of each code region instrumented with IRTK_PROFILE_REGION is recorded in
+/// a ring buffer of the executing thread. Code blocks timed with the
+/// IRTK_START_TIMING and IRTK_END_TIMING or IRTK_DEBUG_TIMING macros are
+/// recorded as well, as leaf regions nested in the enclosing region. In addition, the number of calls
+/// and the total, minimum, and maximum execution time are accumulated for
+/// each node of the per-thread tree of nested regions. When the program
+/// terminates, the recorded events and accumulated statistics are written
+/// to a JSON file in the Chrome trace event format (cf. chrome://tracing).
+///
+/// When profiling is disabled, entering a region costs a single branch.
+class irtkProfiler
+{
+public:
+
+  /// Enable profiling and write results to named file upon program exit
+  ///
+  /// \param[in] fname    Name of output JSON file.
+  /// \param[in] capacity Maximum number of events recorded per thread.
+  ///                     Older events are overwritten by newer events.
+  static void Enable(const char *fname, int capacity = 65536);
+
+  /// Whether profiling is enabled
+  static bool IsEnabled() { return _Enabled; }
+
+  /// Start named region
+  ///
+  /// \param[in] name Name of region. The string must not be modified or
+  ///                 destroyed until the program terminates (cf. Intern).
+  static void Enter(const char *name);
+
+  /// End most recently started region of this thread
+  static void Leave();
+
+  /// Current time in seconds since profiling was enabled or -1 if disabled
+  static double Time() { return _Enabled ? Now() : -1.0; }
+
+  /// Record completed execution of named code block of this thread
+  ///
+  /// The code block is recorded as child of the current region unless it
+  /// has the same name as this region, i.e., when the block was also
+  /// instrumented with IRTK_PROFILE_REGION.
+  ///
+  /// \param[in] name  Name of code block.
+  /// \param[in] start Start time of code block as returned by Time().
+  static void Record(const std::string &name, double start);
+
+  /// Get copy of region name which is valid until the program terminates
+  static const char *Intern(const std::string &);
+
+  /// Write recorded events and statistics to output file
+  static void Write();
+
+private:
+
+  /// Current time in seconds since profiling was enabled
+  static double Now();
+
+  static bool _Enabled; ///< Whether profiling is enabled
+};
+
+// -----------------------------------------------------------------------------
+// Record code blocks timed with IRTK_START_TIMING when profiling is enabled
+#define _IRTK_PROFILE_START_TIMING()   double t_profile_start = irtkProfiler::Time()
+#define _IRTK_PROFILE_RESET_TIMING()   t_profile_start = irtkProfiler::Time()
+#define _IRTK_PROFILE_END_TIMING(name)                                         \
+  if (t_profile_start >= .0) irtkProfiler::Record(name, t_profile_start)
+
+// -----------------------------------------------------------------------------
+/// Scoped region recorded by irtkProfiler
+class irtkProfileRegion
+{
+  bool _Active;
+
+public:
+
+  /// Enter region with static name
+  explicit irtkProfileRegion(const char *name)
+  :
+    _Active(irtkProfiler::IsEnabled())
+  {
+    if (_Active) irtkProfiler::Enter(name);
+  }
+
+  /// Enter region with name generated at runtime
+  explicit irtkProfileRegion(const std::string &name)
+  :
+    _Active(irtkProfiler::IsEnabled())
+  {
+    if (_Active) irtkProfiler::Enter(irtkProfiler::Intern(name));
+  }
+
+  /// Leave region
+  ~irtkProfileRegion()
+  {
+    if (_Active) irtkProfiler::Leave();
+  }
+};
+
+// -----------------------------------------------------------------------------
+/// Record execution time of current code block as named region
+///
+/// @code
+/// {
+///   IRTK_PROFILE_REGION("example section");
+///   // do some work here
+///   {
+///     IRTK_PROFILE_REGION("example part");
+///     // do some part of the work here
+///   }
+/// }
+/// @endcode
+///
+/// @sa irtkProfiler
+#define IRTK_PROFILE_REGION(name)                                              \
+  irtkProfileRegion _IRTK_PROFILE_REGION_VAR(__LINE__)(name)
+#define _IRTK_PROFILE_REGION_VAR(line)  _IRTK_PROFILE_REGION_VAR2(line)
+#define _IRTK_PROFILE_REGION_VAR2(line) irtk_profile_region_##line
+
 // =============================================================================
 // GPU Profiling
 // =============================================================================
@@ -15,11 +15,17 @@
  * limitations under the License. */
 
 #include <irtkCifstream.h>
+#include <irtkGzip.h>
+#include <irtkParallel.h>
 
 // -----------------------------------------------------------------------------
 irtkCifstream::irtkCifstream(const char *fname)
 :
-  _File(NULL), _Swapped(true)
+  _File(NULL),
+#ifdef HAS_ZLIB
+  _Indexed(NULL), _Position(0), _CachedMember(-1),
+#endif
+  _Swapped(true)
 {
 #ifdef WORDS_BIGENDIAN
   _Swapped = false;
@@ -37,6 +43,12 @@ irtkCifstream::~irtkCifstream()
 void irtkCifstream::Open(const char *fname)
 {
 #ifdef HAS_ZLIB
+  _Indexed = fopen(fname, "rb");
+  if (_Indexed != NULL) {
+    if (BuildIndex()) return;
+    fclose(_Indexed);
+    _Indexed = NULL;
+  }
   _File = gzopen(fname, "rb");
 #else
   _File = fopen(fname, "rb");
@@ -50,6 +62,17 @@ void irtkCifstream::Open(const char *fname)
 // -----------------------------------------------------------------------------
 void irtkCifstream::Close()
 {
+#ifdef HAS_ZLIB
+  if (_Indexed != NULL) {
+    fclose(_Indexed);
+    _Indexed = NULL;
+  }
+  _MemberOffset.clear();
+  _DataOffset  .clear();
+  _Cache       .clear();
+  _CachedMember = -1;
+  _Position     = 0;
+#endif
   if (_File != NULL) {
 #ifdef HAS_ZLIB
     gzclose(_File);
@@ -60,6 +83,125 @@ void irtkCifstream::Close()
   }
 }
 
+#ifdef HAS_ZLIB
+
+// -----------------------------------------------------------------------------
+bool irtkCifstream::BuildIndex()
+{
+  unsigned char hdr[irtkGzip::HeaderSize];
+  unsigned char trailer[irtkGzip::TrailerSize];
+  long msize, offset, pos = 0, data = 0;
+  if (fseek(_Indexed, 0, SEEK_END) != 0) return false;
+  const long fsize = ftell(_Indexed);
+  if (fsize <= 0) return false;
+  _MemberOffset.clear();
+  _DataOffset  .clear();
+  while (pos < fsize) {
+    // Get size of member from header
+    if (fseek(_Indexed, pos, SEEK_SET) != 0) return false;
+    const long n = static_cast<long>(fread(hdr, 1, irtkGzip::HeaderSize, _Indexed));
+    if (!irtkGzip::ParseHeader(hdr, n, msize, offset) || pos + msize > fsize) return false;
+    // Get size of uncompressed data from trailer
+    if (fseek(_Indexed, pos + msize - irtkGzip::TrailerSize, SEEK_SET) != 0) return false;
+    if (fread(trailer, 1, irtkGzip::TrailerSize, _Indexed) != irtkGzip::TrailerSize) return false;
+    _MemberOffset.push_back(pos);
+    _DataOffset  .push_back(data);
+    pos  += msize;
+    data += static_cast<long>(irtkGzip::GetLE32(trailer + 4));
+  }
+  _MemberOffset.push_back(pos);
+  _DataOffset  .push_back(data);
+  _Position     = 0;
+  _CachedMember = -1;
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+bool irtkCifstream::CacheMember(int i)
+{
+  if (i == _CachedMember) return true;
+  _CachedMember = -1;
+  const long csize = _MemberOffset[i+1] - _MemberOffset[i];
+  const long usize = _DataOffset  [i+1] - _DataOffset  [i];
+  vector<char> member(csize);
+  if (fseek(_Indexed, _MemberOffset[i], SEEK_SET) != 0) return false;
+  if (fread(&member[0], 1, csize, _Indexed) != static_cast<size_t>(csize)) return false;
+  _Cache.resize(usize);
+  if (!irtkGzip::Inflate(&member[0], csize, usize > 0 ? &_Cache[0] : NULL, usize)) return false;
+  _CachedMember = i;
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+/// Body of parallel decompression of consecutive gzip members
+struct irtkCifstreamInflateMembers
+{
+  const char *_Data;
+  char       *_Output;
+  const long *_MemberOffset;
+  const long *_DataOffset;
+  char       *_Failed;
+
+  void operator ()(const blocked_range<int> &re) const
+  {
+    for (int i = re.begin(); i != re.end(); ++i) {
+      const long csize = _MemberOffset[i+1] - _MemberOffset[i];
+      const long usize = _DataOffset  [i+1] - _DataOffset  [i];
+      if (!irtkGzip::Inflate(_Data   + (_MemberOffset[i] - _MemberOffset[0]), csize,
+                             _Output + (_DataOffset  [i] - _DataOffset  [0]), usize)) {
+        _Failed[i] = 1;
+      }
+    }
+  }
+};
+
+// -----------------------------------------------------------------------------
+bool irtkCifstream::ReadIndexed(char *mem, long num)
+{
+  const int nmembers = static_cast<int>(_MemberOffset.size()) - 1;
+  vector<char> buffer;
+  while (num > 0) {
+    // Find member containing current position
+    const int i = static_cast<int>(upper_bound(_DataOffset.begin(), _DataOffset.end(), _Position)
+                                 - _DataOffset.begin()) - 1;
+    if (i < 0 || i >= nmembers) return false;
+    // Determine consecutive members whose data is read entirely
+    int j = i;
+    if (_Position == _DataOffset[i]) {
+      while (j < nmembers && j - i < irtkGzip::BlocksPerBatch && _DataOffset[j+1] <= _Position + num) ++j;
+    }
+    if (j - i > 1) {
+      // Read compressed data at once and decompress members in parallel
+      const long csize = _MemberOffset[j] - _MemberOffset[i];
+      const long usize = _DataOffset  [j] - _DataOffset  [i];
+      buffer.resize(csize);
+      if (fseek(_Indexed, _MemberOffset[i], SEEK_SET) != 0) return false;
+      if (fread(&buffer[0], 1, csize, _Indexed) != static_cast<size_t>(csize)) return false;
+      vector<char> failed(j - i, 0);
+      irtkCifstreamInflateMembers body;
+      body._Data         = &buffer[0];
+      body._Output       = mem;
+      body._MemberOffset = &_MemberOffset[i];
+      body._DataOffset   = &_DataOffset  [i];
+      body._Failed       = &failed[0];
+      parallel_for(blocked_range<int>(0, j - i), body);
+      for (int k = 0; k < j - i; ++k) {
+        if (failed[k]) return false;
+      }
+      mem += usize, num -= usize, _Position += usize;
+    } else {
+      // Copy data from decompressed member
+      if (!CacheMember(i)) return false;
+      const long n = min(num, _DataOffset[i+1] - _Position);
+      memcpy(mem, &_Cache[_Position - _DataOffset[i]], n);
+      mem += n, num -= n, _Position += n;
+    }
+  }
+  return true;
+}
+
+#endif // HAS_ZLIB
+
 // -----------------------------------------------------------------------------
 int irtkCifstream::IsSwapped() const
 {
@@ -76,6 +218,7 @@ void irtkCifstream::IsSwapped(int swapped)
 long irtkCifstream::Tell() const
 {
 #ifdef HAS_ZLIB
+  if (_Indexed) return _Position;
   return gztell(_File);
 #else
   return ftell(_File);
@@ -86,7 +229,8 @@ long irtkCifstream::Tell() const
 void irtkCifstream::Seek(long offset)
 {
 #ifdef HAS_ZLIB
-  gzseek(_File, offset, SEEK_SET);
+  if (_Indexed) _Position = offset;
+  else gzseek(_File, offset, SEEK_SET);
 #else
   fseek(_File, offset, SEEK_SET);
 #endif
@@ -96,6 +240,10 @@ void irtkCifstream::Seek(long offset)
 bool irtkCifstream::Read(char *mem, long start, long num)
 {
 #ifdef HAS_ZLIB
+  if (_Indexed) {
+    if (start != -1) _Position = start;
+    return ReadIndexed(mem, num);
+  }
   if (start != -1) gzseek(_File, start, SEEK_SET);
   return (gzread(_File, mem, num) == num);
 #else
@@ -169,8 +317,21 @@ bool irtkCifstream::ReadAsString(char *data, long length, long offset)
 {
   // Read string
 #ifdef HAS_ZLIB
-  if (offset != -1) gzseek(_File, offset, SEEK_SET);
-  if (gzgets(_File, data, length) == Z_NULL) return false;
+  if (_Indexed) {
+    if (offset != -1) _Position = offset;
+    if (length <= 0) return false;
+    // Read characters up to and including end-of-line like gzgets
+    long n = 0;
+    while (n < length - 1 && _Position < _DataOffset.back()) {
+      if (!ReadIndexed(data + n, 1)) return false;
+      if (data[n++] == '\n') break;
+    }
+    data[n] = '\0';
+    if (n == 0) return false;
+  } else {
+    if (offset != -1) gzseek(_File, offset, SEEK_SET);
+    if (gzgets(_File, data, length) == Z_NULL) return false;
+  }
 #else
   if (offset != -1) fseek(_File, offset, SEEK_SET);
   if (fgets(data, length, _File) == NULL) return false;
@@ -15,13 +15,15 @@
  * limitations under the License. */
 
 #include <irtkCofstream.h>
+#include <irtkGzip.h>
+#include <irtkParallel.h>
 
 // -----------------------------------------------------------------------------
 irtkCofstream::irtkCofstream(const char *fname)
 {
   _File = NULL;
 #ifdef HAS_ZLIB
-  _ZFile = NULL;
+  _Position = 0;
 #endif
 #ifndef WORDS_BIGENDIAN
   _Swapped = true;
@@ -48,11 +50,13 @@ void irtkCofstream::Open(const char *fname)
   }
   if (len > 3 && (strncmp(fname + len-3, ".gz", 3) == 0 || strncmp(fname + len-3, ".GZ", 3) == 0)) {
 #ifdef HAS_ZLIB
-    _ZFile = gzopen(fname, "wb");
-    if (_ZFile == NULL) {
+    _File = fopen(fname, "wb");
+    if (_File == NULL) {
       cerr << "cofstream::Open: Cannot open file " << fname << endl;
       exit(1);
     }
+    _Buffer.clear();
+    _Position   = 0;
     _Compressed = true;
 #else
     cerr << "cofstream::Open: Cannot write compressed file without zlib" << endl;
@@ -69,18 +73,24 @@ void irtkCofstream::Open(const char *fname)
 }
 
 // -----------------------------------------------------------------------------
-void irtkCofstream::Close()
+bool irtkCofstream::Close()
 {
+  bool ok = true;
 #ifdef HAS_ZLIB
-  if (_ZFile) {
-    gzclose(_ZFile);
-    _ZFile = NULL;
+  if (_File && _Compressed) {
+    if (!Flush(true)) {
+      cerr << "cofstream::Close: Failed to write compressed data" << endl;
+      ok = false;
+    }
+    _Buffer.clear();
+    _Position = 0;
   }
 #endif
   if (_File) {
-    fclose(_File);
+    if (fclose(_File) != 0) ok = false;
     _File = NULL;
   }
+  return ok;
 }
 
 // -----------------------------------------------------------------------------
@@ -107,20 +117,84 @@ void irtkCofstream::IsSwapped(int swapped)
   _Swapped = static_cast<bool>(swapped);
 }
 
+#ifdef HAS_ZLIB
+
+// -----------------------------------------------------------------------------
+/// Body of parallel compression of data blocks
+struct irtkCofstreamDeflateBlocks
+{
+  const char           *_Data;
+  long                  _Size;
+  vector<vector<char> > *_Output;
+  char                 *_Failed;
+
+  void operator ()(const blocked_range<int> &re) const
+  {
+    for (int i = re.begin(); i != re.end(); ++i) {
+      const long offset = i * irtkGzip::BlockSize;
+      const long size   = min(irtkGzip::BlockSize, _Size - offset);
+      if (!irtkGzip::Deflate(_Data + offset, size, (*_Output)[i])) _Failed[i] = 1;
+    }
+  }
+};
+
+// -----------------------------------------------------------------------------
+bool irtkCofstream::Flush(bool all)
+{
+  const long size = static_cast<long>(_Buffer.size());
+  int n = static_cast<int>(size / irtkGzip::BlockSize);
+  // Write an empty member when nothing was written before to obtain a valid file
+  if (all && (size % irtkGzip::BlockSize != 0 || (n == 0 && ftell(_File) == 0))) ++n;
+  if (n == 0) return true;
+  // Compress blocks in parallel
+  const long nbytes = min(size, n * irtkGzip::BlockSize);
+  vector<vector<char> > members(n);
+  vector<char> failed(n, 0);
+  irtkCofstreamDeflateBlocks deflate;
+  deflate._Data   = (size > 0 ? &_Buffer[0] : NULL);
+  deflate._Size   = nbytes;
+  deflate._Output = &members;
+  deflate._Failed = &failed[0];
+  parallel_for(blocked_range<int>(0, n), deflate);
+  // Write compressed members in order
+  bool ok = true;
+  for (int i = 0; i < n; ++i) {
+    if (failed[i] || fwrite(&members[i][0], members[i].size(), 1, _File) != 1) {
+      ok = false;
+      break;
+    }
+  }
+  // Keep remaining incomplete block
+  _Buffer.erase(_Buffer.begin(), _Buffer.begin() + nbytes);
+  return ok;
+}
+
+#endif // HAS_ZLIB
+
 // -----------------------------------------------------------------------------
 bool irtkCofstream::Write(const char *data, long offset, long length)
 {
 #ifdef HAS_ZLIB
   if (_Compressed) {
     if (offset != -1) {
-      if (gztell(_ZFile) > offset) {
+      if (_Position > offset) {
         cerr << "Error: Writing compressed files only supports forward seek (pos="
-             << gztell(_ZFile) << ", offset=" << offset << ")" << endl;
+             << _Position << ", offset=" << offset << ")" << endl;
         exit(1);
       }
-      gzseek(_ZFile, offset, SEEK_SET);
+      // Fill gap with zeros as done by gzseek
+      _Buffer.insert(_Buffer.end(), offset - _Position, '\0');
+      _Position = offset;
+    }
+    // Compress data in batches of blocks to limit memory use
+    const long batch = irtkGzip::BlocksPerBatch * irtkGzip::BlockSize;
+    while (length > 0) {
+      const long n = min(length, batch - static_cast<long>(_Buffer.size()));
+      _Buffer.insert(_Buffer.end(), data, data + n);
+      data += n, length -= n, _Position += n;
+      if (static_cast<long>(_Buffer.size()) >= batch && !Flush(false)) return false;
     }
-    return (gzwrite(_ZFile, data, length) == length);
+    return true;
   }
 #endif
   if (offset != -1) fseek(_File, offset, SEEK_SET);
@@ -251,10 +325,7 @@ bool irtkCofstream::WriteAsDouble(double data, long offset)
 bool irtkCofstream::WriteAsString(const char *data, long offset)
 {
 #ifdef HAS_ZLIB
-  if (_Compressed) {
-    if (offset != -1) gzseek(_ZFile, offset, SEEK_SET);
-    return (gzputs(_ZFile, data) > 0);
-  }
+  if (_Compressed) return Write(data, offset, static_cast<long>(strlen(data)));
 #endif
   if (offset != -1) fseek(_File, offset, SEEK_SET);
   return (fputs(data, _File) != EOF);
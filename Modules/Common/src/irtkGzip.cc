@@ -0,0 +1,139 @@
+/* The Image Registration Toolkit (IRTK)
+ *
+ * Copyright 2008-2015 Imperial College London
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+
+#ifdef HAS_ZLIB
+
+#include <irtkGzip.h>
+#include <zlib.h>
+
+
+namespace irtkGzip {
+
+
+// -----------------------------------------------------------------------------
+unsigned long GetLE32(const unsigned char *p)
+{
+  return  static_cast<unsigned long>(p[0])
+       | (static_cast<unsigned long>(p[1]) <<  8)
+       | (static_cast<unsigned long>(p[2]) << 16)
+       | (static_cast<unsigned long>(p[3]) << 24);
+}
+
+// -----------------------------------------------------------------------------
+inline void PutLE32(unsigned char *p, unsigned long v)
+{
+  p[0] = static_cast<unsigned char>( v        & 0xff);
+  p[1] = static_cast<unsigned char>((v >>  8) & 0xff);
+  p[2] = static_cast<unsigned char>((v >> 16) & 0xff);
+  p[3] = static_cast<unsigned char>((v >> 24) & 0xff);
+}
+
+// -----------------------------------------------------------------------------
+bool Deflate(const char *data, long size, vector<char> &out)
+{
+  z_stream strm;
+  memset(&strm, 0, sizeof(strm));
+  // Raw deflate stream, gzip header and trailer are written below
+  if (deflateInit2(&strm, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+    return false;
+  }
+  out.resize(HeaderSize + deflateBound(&strm, static_cast<uLong>(size)) + TrailerSize);
+  unsigned char *hdr = reinterpret_cast<unsigned char *>(&out[0]);
+  // Member header with extra field
+  hdr[0] = 0x1f;          // ID1
+  hdr[1] = 0x8b;          // ID2
+  hdr[2] = 8;             // CM  = deflate
+  hdr[3] = 4;             // FLG = FEXTRA
+  hdr[4] = hdr[5] = hdr[6] = hdr[7] = 0; // MTIME
+  hdr[8] = 0;             // XFL
+  hdr[9] = 3;             // OS  = Unix
+  hdr[10] = 8, hdr[11] = 0;              // XLEN
+  hdr[12] = SubfieldId[0];
+  hdr[13] = SubfieldId[1];
+  hdr[14] = 4, hdr[15] = 0;              // LEN
+  // Deflate data
+  strm.next_in   = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+  strm.avail_in  = static_cast<uInt>(size);
+  strm.next_out  = hdr + HeaderSize;
+  strm.avail_out = static_cast<uInt>(out.size() - HeaderSize - TrailerSize);
+  const int status = deflate(&strm, Z_FINISH);
+  const long csize = static_cast<long>(strm.total_out);
+  deflateEnd(&strm);
+  if (status != Z_STREAM_END) return false;
+  // Trailer with CRC-32 and size of uncompressed data
+  unsigned char *trailer = hdr + HeaderSize + csize;
+  PutLE32(trailer,     crc32(crc32(0L, Z_NULL, 0), reinterpret_cast<const Bytef *>(data), static_cast<uInt>(size)));
+  PutLE32(trailer + 4, static_cast<unsigned long>(size));
+  // Record total member size in extra field
+  const long total = HeaderSize + csize + TrailerSize;
+  PutLE32(hdr + 16, static_cast<unsigned long>(total));
+  out.resize(total);
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+bool ParseHeader(const unsigned char *data, long avail, long &size, long &offset)
+{
+  size = offset = 0;
+  if (avail < 12 || data[0] != 0x1f || data[1] != 0x8b || data[2] != 8) return false;
+  // Only FEXTRA flag set as written by Deflate
+  if (data[3] != 4) return false;
+  const long xlen = static_cast<long>(data[10]) | (static_cast<long>(data[11]) << 8);
+  if (avail < 12 + xlen) return false;
+  offset = 12 + xlen;
+  // Find subfield with member size
+  const unsigned char *p = data + 12;
+  long n = xlen;
+  while (n >= 4) {
+    const long len = static_cast<long>(p[2]) | (static_cast<long>(p[3]) << 8);
+    if (p[0] == SubfieldId[0] && p[1] == SubfieldId[1] && len == 4 && n >= 8) {
+      size = static_cast<long>(GetLE32(p + 4));
+      return size > offset + TrailerSize;
+    }
+    p += 4 + len, n -= 4 + len;
+  }
+  return false;
+}
+
+// -----------------------------------------------------------------------------
+bool Inflate(const char *data, long size, char *out, long usize)
+{
+  long msize, offset;
+  if (!ParseHeader(reinterpret_cast<const unsigned char *>(data), size, msize, offset) || msize != size) {
+    return false;
+  }
+  z_stream strm;
+  memset(&strm, 0, sizeof(strm));
+  if (inflateInit2(&strm, -MAX_WBITS) != Z_OK) return false;
+  strm.next_in   = reinterpret_cast<Bytef *>(const_cast<char *>(data + offset));
+  strm.avail_in  = static_cast<uInt>(size - offset - TrailerSize);
+  strm.next_out  = reinterpret_cast<Bytef *>(out);
+  strm.avail_out = static_cast<uInt>(usize);
+  const int status = inflate(&strm, Z_FINISH);
+  const long total = static_cast<long>(strm.total_out);
+  inflateEnd(&strm);
+  if (status != Z_STREAM_END || total != usize) return false;
+  // Verify checksum
+  const unsigned char *trailer = reinterpret_cast<const unsigned char *>(data + size - TrailerSize);
+  const unsigned long crc = crc32(crc32(0L, Z_NULL, 0), reinterpret_cast<const Bytef *>(out), static_cast<uInt>(usize));
+  return crc == GetLE32(trailer);
+}
+
+
+} // namespace irtkGzip
+
+#endif // HAS_ZLIB
@@ -0,0 +1,83 @@
+/* The Image Registration Toolkit (IRTK)
+ *
+ * Copyright 2008-2015 Imperial College London
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+
+#include <irtkMemoryMappedFile.h>
+
+#if !WINDOWS
+#  include <fcntl.h>
+#  include <unistd.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#endif
+
+// -----------------------------------------------------------------------------
+irtkMemoryMappedFile::irtkMemoryMappedFile()
+:
+  _Data(NULL), _Size(0)
+{
+}
+
+// -----------------------------------------------------------------------------
+irtkMemoryMappedFile::~irtkMemoryMappedFile()
+{
+  Close();
+}
+
+// -----------------------------------------------------------------------------
+bool irtkMemoryMappedFile::IsSupported()
+{
+#if WINDOWS
+  return false;
+#else
+  return true;
+#endif
+}
+
+// -----------------------------------------------------------------------------
+bool irtkMemoryMappedFile::Open(const char *fname)
+{
+  Close();
+#if WINDOWS
+  return false;
+#else
+  const int fd = open(fname, O_RDONLY);
+  if (fd == -1) return false;
+  struct stat info;
+  if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+    close(fd);
+    return false;
+  }
+  void *addr = mmap(NULL, static_cast<size_t>(info.st_size),
+                    PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  // The mapping remains valid after the file descriptor is closed
+  close(fd);
+  if (addr == MAP_FAILED) return false;
+  _Data = reinterpret_cast<char *>(addr);
+  _Size = static_cast<size_t>(info.st_size);
+  return true;
+#endif
+}
+
+// -----------------------------------------------------------------------------
+void irtkMemoryMappedFile::Close()
+{
+#if !WINDOWS
+  if (_Data) munmap(_Data, _Size);
+#endif
+  _Data = NULL;
+  _Size = 0;
+}
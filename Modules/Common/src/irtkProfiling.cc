@@ -16,6 +16,11 @@
 
 #include <irtkCommon.h>
 
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <set>
+
 
 // =============================================================================
 // Global profiling options
@@ -35,16 +40,28 @@ TimeUnit debug_time_unit = TIME_IN_DEFAULT_UNIT;
 bool IsProfilingOption(const char *arg)
 {
   _option = NULL;
-  if      (strcmp(arg, "-profile")      == 0) _option = "-profile";
-  else if (strcmp(arg, "-profile-unit") == 0) _option = "-profile-unit";
+  if      (strcmp(arg, "-profile")       == 0) _option = "-profile";
+  else if (strcmp(arg, "-profile-level") == 0) _option = "-profile-level";
+  else if (strcmp(arg, "-profile-unit")  == 0) _option = "-profile-unit";
   return (_option != NULL);
 }
 
 // -----------------------------------------------------------------------------
 void ParseProfilingOption(int &OPTIDX, int &argc, char *argv[])
 {
+  int level;
   if (OPTION("-profile")) {
-    if (HAS_ARGUMENT) debug_time  = atoi(ARGUMENT);
+    // Former "-profile [n]" option which set the verbosity of time
+    // measurements, still accepted when not followed by a file name
+    if (!HAS_ARGUMENT || FromString(argv[OPTIDX+1], level)) {
+      cerr << "Warning: Option -profile [n] is deprecated, use -profile-level [n] instead." << endl;
+      if (HAS_ARGUMENT) debug_time  = atoi(ARGUMENT);
+      else              debug_time += 1;
+    } else {
+      irtkProfiler::Enable(ARGUMENT);
+    }
+  } else if (OPTION("-profile-level")) {
+    if (HAS_ARGUMENT) debug_time = atoi(ARGUMENT);
     else              debug_time += 1;
   } else if (OPTION("-profile-unit")) {
     const char *arg = ARGUMENT;
@@ -63,7 +80,10 @@ void PrintProfilingOptions(ostream &out)
 {
   out << endl;
   out << "Profiling options:" << endl;
-  out << "  -profile [n]                 Increase/Set verbosity of time measurements. (default: 0)" << endl;
+  out << "  -profile <file>              Write execution time of profiled code regions to JSON file" << endl;
+  out << "                               in Chrome trace event format. (default: none)" << endl;
+  out << "  -profile-level [n]           Increase/Set verbosity of time measurements. (default: 0)" << endl;
+  out << "                               Formerly -profile [n], which is deprecated." << endl;
 #ifdef USE_CUDA
   out << "  -profile-unit <msecs|secs>   Unit of time measurements. (default: secs [CPU], msecs [GPU])" << endl;
 #else
@@ -71,7 +91,13 @@ void PrintProfilingOptions(ostream &out)
 #endif
 }
 #else
-void PrintProfilingOptions(ostream &) {}
+void PrintProfilingOptions(ostream &out)
+{
+  out << endl;
+  out << "Profiling options:" << endl;
+  out << "  -profile <file>              Write execution time of profiled code regions to JSON file" << endl;
+  out << "                               in Chrome trace event format. (default: none)" << endl;
+}
 #endif
 
 // =============================================================================
@@ -111,3 +137,272 @@ void PrintElapsedTime(const char *section, double t, TimeUnit unit)
   printf("Time for %-*s %10.3f %s\n", section_width, section_buffer, t, unit_buffer);
   fflush(stdout);
 }
+
+// =============================================================================
+// Region profiling
+// =============================================================================
+
+namespace irtkProfilerUtils {
+
+typedef std::chrono::steady_clock ProfilerClock;
+
+// -----------------------------------------------------------------------------
+/// Node of per-thread tree of nested regions
+struct ProfileNode
+{
+  const char  *_Name;
+  int          _Parent;
+  vector<int>  _Children;
+  long         _Count;
+  double       _Total;
+  double       _Min;
+  double       _Max;
+};
+
+// -----------------------------------------------------------------------------
+/// Recorded execution of a region
+struct ProfileEvent
+{
+  int    _Node;
+  double _Start; ///< Start time in microseconds since profiling was enabled
+  double _Duration; ///< Duration in microseconds
+};
+
+// -----------------------------------------------------------------------------
+/// Profiling data of one thread
+struct ThreadProfile
+{
+  int                               _Id;
+  vector<ProfileNode>               _Node;    ///< Tree of regions, root at index 0
+  vector<int>                       _Stack;   ///< Currently active nodes
+  vector<ProfilerClock::time_point> _Start;   ///< Start times of active nodes
+  vector<ProfileEvent>              _Event;   ///< Ring buffer of recorded events
+  size_t                            _Next;    ///< Next ring buffer position
+  bool                              _Wrapped; ///< Whether older events were overwritten
+};
+
+std::mutex                                _Mutex;    // Guards following global variables
+vector<std::unique_ptr<ThreadProfile> >   _Thread;   // Profiling data of all threads
+set<string>                               _Names;    // Interned region names
+string                                    _FileName; // Output file name
+int                                       _Capacity; // Capacity of ring buffers
+ProfilerClock::time_point                 _Origin;   // Time when profiling was enabled
+
+thread_local ThreadProfile *_ThisThread = NULL;
+
+// -----------------------------------------------------------------------------
+/// Get profiling data of calling thread
+inline ThreadProfile *GetThreadProfile()
+{
+  if (_ThisThread == NULL) {
+    ThreadProfile *profile = new ThreadProfile;
+    ProfileNode root = {"", -1, vector<int>(), 0, .0, .0, .0};
+    profile->_Node.push_back(root);
+    profile->_Stack.push_back(0);
+    profile->_Next    = 0;
+    profile->_Wrapped = false;
+    std::lock_guard<std::mutex> lock(_Mutex);
+    profile->_Event.resize(_Capacity);
+    profile->_Id = static_cast<int>(_Thread.size());
+    _Thread.push_back(std::unique_ptr<ThreadProfile>(profile));
+    _ThisThread = profile;
+  }
+  return _ThisThread;
+}
+
+// -----------------------------------------------------------------------------
+/// Get child of region node with the given name, adding it if necessary
+int ChildNode(ThreadProfile *profile, int parent, const char *name)
+{
+  const vector<int> &children = profile->_Node[parent]._Children;
+  for (size_t i = 0; i < children.size(); ++i) {
+    const char *child_name = profile->_Node[children[i]]._Name;
+    if (child_name == name || strcmp(child_name, name) == 0) {
+      return children[i];
+    }
+  }
+  ProfileNode child = {name, parent, vector<int>(), 0, .0,
+                       numeric_limits<double>::infinity(), .0};
+  const int node = static_cast<int>(profile->_Node.size());
+  profile->_Node.push_back(child);
+  profile->_Node[parent]._Children.push_back(node);
+  return node;
+}
+
+// -----------------------------------------------------------------------------
+/// Accumulate statistics of region node and record execution in ring buffer
+///
+/// \param[in] start Start time in seconds since profiling was enabled.
+/// \param[in] t     Execution time in seconds.
+void RecordEvent(ThreadProfile *profile, int n, double start, double t)
+{
+  ProfileNode &node = profile->_Node[n];
+  node._Count += 1;
+  node._Total += t;
+  if (t < node._Min) node._Min = t;
+  if (t > node._Max) node._Max = t;
+  ProfileEvent &event = profile->_Event[profile->_Next];
+  event._Node     = n;
+  event._Start    = 1e6 * start;
+  event._Duration = 1e6 * t;
+  if (++profile->_Next == profile->_Event.size()) {
+    profile->_Next    = 0;
+    profile->_Wrapped = true;
+  }
+}
+
+// -----------------------------------------------------------------------------
+/// Write string as quoted JSON string
+void WriteJSONString(ostream &os, const char *str)
+{
+  os << '"';
+  for (const char *c = str; *c; ++c) {
+    switch (*c) {
+      case '"':  os << "\\\""; break;
+      case '\\': os << "\\\\"; break;
+      case '\n': os << "\\n";  break;
+      case '\t': os << "\\t";  break;
+      default:
+        if (static_cast<unsigned char>(*c) < 0x20) os << ' ';
+        else                                       os << *c;
+    }
+  }
+  os << '"';
+}
+
+// -----------------------------------------------------------------------------
+/// Get path of region node, i.e., names of enclosing regions separated by '/'
+string NodePath(const ThreadProfile *profile, int n)
+{
+  string path;
+  while (n > 0) {
+    const ProfileNode &node = profile->_Node[n];
+    path = (path.empty() ? string(node._Name) : string(node._Name) + "/" + path);
+    n = node._Parent;
+  }
+  return path;
+}
+
+// -----------------------------------------------------------------------------
+void WriteAtExit()
+{
+  irtkProfiler::Write();
+}
+
+
+} // namespace irtkProfilerUtils
+using namespace irtkProfilerUtils;
+
+// -----------------------------------------------------------------------------
+bool irtkProfiler::_Enabled = false;
+
+// -----------------------------------------------------------------------------
+void irtkProfiler::Enable(const char *fname, int capacity)
+{
+  std::lock_guard<std::mutex> lock(_Mutex);
+  if (!_Enabled) atexit(WriteAtExit);
+  _FileName = fname;
+  _Capacity = max(1, capacity);
+  _Origin   = ProfilerClock::now();
+  _Enabled  = true;
+}
+
+// -----------------------------------------------------------------------------
+void irtkProfiler::Enter(const char *name)
+{
+  ThreadProfile *profile = GetThreadProfile();
+  const int node = ChildNode(profile, profile->_Stack.back(), name);
+  profile->_Stack.push_back(node);
+  profile->_Start.push_back(ProfilerClock::now());
+}
+
+// -----------------------------------------------------------------------------
+void irtkProfiler::Leave()
+{
+  const ProfilerClock::time_point end = ProfilerClock::now();
+  ThreadProfile *profile = GetThreadProfile();
+  if (profile->_Start.empty()) return;
+  const ProfilerClock::time_point start = profile->_Start.back();
+  const int n = profile->_Stack.back();
+  profile->_Stack.pop_back();
+  profile->_Start.pop_back();
+  RecordEvent(profile, n, std::chrono::duration<double>(start - _Origin).count(),
+                          std::chrono::duration<double>(end   - start  ).count());
+}
+
+// -----------------------------------------------------------------------------
+double irtkProfiler::Now()
+{
+  return std::chrono::duration<double>(ProfilerClock::now() - _Origin).count();
+}
+
+// -----------------------------------------------------------------------------
+void irtkProfiler::Record(const std::string &name, double start)
+{
+  const double end = Now();
+  ThreadProfile *profile = GetThreadProfile();
+  const int parent = profile->_Stack.back();
+  if (name == profile->_Node[parent]._Name) return;
+  const int n = ChildNode(profile, parent, Intern(name));
+  RecordEvent(profile, n, start, end - start);
+}
+
+// -----------------------------------------------------------------------------
+const char *irtkProfiler::Intern(const std::string &name)
+{
+  std::lock_guard<std::mutex> lock(_Mutex);
+  return _Names.insert(name).first->c_str();
+}
+
+// -----------------------------------------------------------------------------
+void irtkProfiler::Write()
+{
+  std::lock_guard<std::mutex> lock(_Mutex);
+  if (!_Enabled) return;
+
+  ofstream os(_FileName.c_str());
+  if (!os) {
+    cerr << "irtkProfiler::Write: Failed to open file " << _FileName << " for writing" << endl;
+    return;
+  }
+  os.precision(3);
+  os << fixed;
+
+  // Recorded events in Chrome trace event format
+  os << "{\n\"traceEvents\": [";
+  bool first = true;
+  for (size_t i = 0; i < _Thread.size(); ++i) {
+    const ThreadProfile *profile = _Thread[i].get();
+    const size_t nevents = (profile->_Wrapped ? profile->_Event.size() : profile->_Next);
+    const size_t begin   = (profile->_Wrapped ? profile->_Next : 0);
+    for (size_t j = 0; j < nevents; ++j) {
+      const ProfileEvent &event = profile->_Event[(begin + j) % profile->_Event.size()];
+      os << (first ? "\n" : ",\n") << "{\"name\": ";
+      WriteJSONString(os, profile->_Node[event._Node]._Name);
+      os << ", \"cat\": \"irtk\", \"ph\": \"X\", \"pid\": 0, \"tid\": " << profile->_Id
+         << ", \"ts\": " << event._Start << ", \"dur\": " << event._Duration << "}";
+      first = false;
+    }
+  }
+  os << "\n],\n\"displayTimeUnit\": \"ms\",\n";
+
+  // Statistics of each region of each thread
+  os.precision(9);
+  os << "\"regions\": [";
+  first = true;
+  for (size_t i = 0; i < _Thread.size(); ++i) {
+    const ThreadProfile *profile = _Thread[i].get();
+    for (size_t n = 1; n < profile->_Node.size(); ++n) {
+      const ProfileNode &node = profile->_Node[n];
+      if (node._Count == 0) continue;
+      os << (first ? "\n" : ",\n") << "{\"thread\": " << profile->_Id << ", \"path\": ";
+      WriteJSONString(os, NodePath(profile, static_cast<int>(n)).c_str());
+      os << ", \"count\": " << node._Count
+         << ", \"total\": " << node._Total
+         << ", \"min\": "   << node._Min
+         << ", \"max\": "   << node._Max << "}";
+      first = false;
+    }
+  }
+  os << "\n]\n}\n";
+}
@@ -52,6 +52,8 @@ public:
   // member access, allows use of construct mat[r][c]
   double*       operator[] (int iRow);
   const double* operator[] (int iRow) const;
+  double&       operator() (int iRow, int iCol);
+  const double& operator() (int iRow, int iCol) const;
   operator double* ();
   irtkVector3 GetColumn (int iCol) const;
 
@@ -99,6 +101,9 @@ public:
   irtkMatrix3x3 Inverse (double fTolerance = 1e-06) const;
   double Determinant () const;
 
+  // adjugate (transposed cofactor matrix) in place, returns determinant
+  irtkMatrix3x3& Adjugate (double& rfDet);
+
   // singular value decomposition
   void SingularValueDecomposition (irtkMatrix3x3& rkL, irtkVector3& rkS,
                                    irtkMatrix3x3& rkR) const;
@@ -171,4 +176,15 @@ protected:
   double m_aafEntry[3][3];
 };
 
+//----------------------------------------------------------------------------
+inline const double& irtkMatrix3x3::operator() (int iRow, int iCol) const
+{
+  return m_aafEntry[iRow][iCol];
+}
+//----------------------------------------------------------------------------
+inline double& irtkMatrix3x3::operator() (int iRow, int iCol)
+{
+  return m_aafEntry[iRow][iCol];
+}
+
 #endif
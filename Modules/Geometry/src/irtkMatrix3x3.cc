@@ -406,6 +406,37 @@ double irtkMatrix3x3::Determinant () const
   return fDet;
 }
 //----------------------------------------------------------------------------
+irtkMatrix3x3& irtkMatrix3x3::Adjugate (double& rfDet)
+{
+  // Unlike irtkMatrix::Adjugate, a singular matrix is not an error here.
+  irtkMatrix3x3 kAdj;
+  kAdj[0][0] = m_aafEntry[1][1]*m_aafEntry[2][2] -
+               m_aafEntry[1][2]*m_aafEntry[2][1];
+  kAdj[0][1] = m_aafEntry[0][2]*m_aafEntry[2][1] -
+               m_aafEntry[0][1]*m_aafEntry[2][2];
+  kAdj[0][2] = m_aafEntry[0][1]*m_aafEntry[1][2] -
+               m_aafEntry[0][2]*m_aafEntry[1][1];
+  kAdj[1][0] = m_aafEntry[1][2]*m_aafEntry[2][0] -
+               m_aafEntry[1][0]*m_aafEntry[2][2];
+  kAdj[1][1] = m_aafEntry[0][0]*m_aafEntry[2][2] -
+               m_aafEntry[0][2]*m_aafEntry[2][0];
+  kAdj[1][2] = m_aafEntry[0][2]*m_aafEntry[1][0] -
+               m_aafEntry[0][0]*m_aafEntry[1][2];
+  kAdj[2][0] = m_aafEntry[1][0]*m_aafEntry[2][1] -
+               m_aafEntry[1][1]*m_aafEntry[2][0];
+  kAdj[2][1] = m_aafEntry[0][1]*m_aafEntry[2][0] -
+               m_aafEntry[0][0]*m_aafEntry[2][1];
+  kAdj[2][2] = m_aafEntry[0][0]*m_aafEntry[1][1] -
+               m_aafEntry[0][1]*m_aafEntry[1][0];
+
+  rfDet = m_aafEntry[0][0]*kAdj[0][0] +
+          m_aafEntry[0][1]*kAdj[1][0] +
+          m_aafEntry[0][2]*kAdj[2][0];
+
+  *this = kAdj;
+  return *this;
+}
+//----------------------------------------------------------------------------
 void irtkMatrix3x3::Bidiagonalize (irtkMatrix3x3& kA, irtkMatrix3x3& kL,
                                    irtkMatrix3x3& kR)
 {
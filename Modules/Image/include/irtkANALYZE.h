@@ -114,7 +114,10 @@ inline void irtkANALYZEHeader::Write(char *filename)
   to.WriteAsInt(glmin, 144);
   to.WriteAsChar(padding7, 168, 148);
   to.WriteAsInt(padding8, 8, 316);
-  to.Close();
+  if (!to.Close()) {
+    cerr << "irtkANALYZEHeader::Write: Failed to write file " << filename << endl;
+    exit(1);
+  }
 }
 
 inline void irtkANALYZEHeader::Read(char *filename)
@@ -109,7 +109,14 @@ public:
   // Initialization
 
   /// Read file and construct image
-  static irtkBaseImage *New(const char *);
+  ///
+  /// \param[in] fname Image file name.
+  /// \param[in] mmap  Whether to use the data of the memory-mapped image file
+  ///                  directly if possible instead of reading it into memory.
+  ///                  The file must then not be modified while the image exists.
+  ///
+  /// \sa irtkFileToImage::MemoryMapping
+  static irtkBaseImage *New(const char *fname, bool mmap = false);
   
   /// Construct image copy of same type
   static irtkBaseImage *New(const irtkBaseImage *);
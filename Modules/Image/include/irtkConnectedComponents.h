@@ -0,0 +1,163 @@
+/* The Image Registration Toolkit (IRTK)
+ *
+ * Copyright 2008-2015 Imperial College London
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#ifndef _IRTKCONNECTEDCOMPONENTS_H
+
+#define _IRTKCONNECTEDCOMPONENTS_H
+
+#include <irtkImage.h>
+
+#include <vector>
+
+
+/**
+ * Connected component labelling of the voxels of an image with a given label
+ *
+ * The components are found by a two-pass union-find algorithm. The image is
+ * divided into slabs of slices which are labelled in parallel. The components
+ * which touch the seams between slabs are merged afterwards. The components
+ * are numbered 1, 2, ... in the order of their first voxel in memory and the
+ * number of voxels of each component is computed along with the labels.
+ *
+ * In 2D mode, each slice is processed independently. CONNECTIVITY_04 and
+ * CONNECTIVITY_06 then correspond to the in-plane 4-neighbourhood, and
+ * CONNECTIVITY_18 and CONNECTIVITY_26 to the in-plane 8-neighbourhood.
+ * In 3D, CONNECTIVITY_04 implies 2D mode.
+ */
+
+template <class VoxelType>
+class irtkConnectedComponents : public irtkObject
+{
+  irtkObjectMacro(irtkConnectedComponents);
+
+  /// Input image
+  irtkPublicAggregateMacro(const irtkGenericImage<VoxelType>, Input);
+
+  /// Label of voxels which are part of a component
+  irtkPublicAttributeMacro(VoxelType, ComponentLabel);
+
+  /// Neighbourhood of voxels which are connected
+  irtkPublicAttributeMacro(irtkConnectivityType, Connectivity);
+
+  /// Whether to find the connected components of each slice separately
+  irtkPublicAttributeMacro(bool, Mode2D);
+
+  /// Component label of each voxel of the first frame (0: background)
+  irtkReadOnlyAttributeMacro(vector<int>, Labels);
+
+  /// Number of voxels of each component
+  irtkReadOnlyAttributeMacro(vector<int>, Sizes);
+
+public:
+
+  /// Constructor
+  irtkConnectedComponents(VoxelType = 0, irtkConnectivityType = CONNECTIVITY_06);
+
+  /// Destructor
+  virtual ~irtkConnectedComponents();
+
+  /// Find connected components of the first frame of the input image
+  void Run();
+
+  /// Number of connected components
+  int NumberOfComponents() const;
+
+  /// Number of voxels of component with given label
+  int ComponentSize(int) const;
+
+  /// Label of largest component or 0 if there are none
+  ///
+  /// Ties are resolved in favour of the component with the smaller label.
+  int LargestComponent() const;
+
+  /// Label of largest component in the given slice (2D mode only)
+  int LargestComponent(int) const;
+
+  /// Number of components with at least the given number of voxels
+  int NumberOfComponents(int) const;
+
+  /// Write binary mask of components with at least the given number of
+  /// voxels to the output image
+  template <class T>
+  void SelectComponents(irtkGenericImage<T> *, int) const;
+
+  /// Write binary mask of component with given label to the output image
+  template <class T>
+  void SelectComponent(irtkGenericImage<T> *, int) const;
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Inline definitions
+////////////////////////////////////////////////////////////////////////////////
+
+// -----------------------------------------------------------------------------
+template <class VoxelType>
+inline int irtkConnectedComponents<VoxelType>::NumberOfComponents() const
+{
+  return static_cast<int>(_Sizes.size());
+}
+
+// -----------------------------------------------------------------------------
+template <class VoxelType>
+inline int irtkConnectedComponents<VoxelType>::ComponentSize(int label) const
+{
+  return (label > 0 && label <= NumberOfComponents()) ? _Sizes[label - 1] : 0;
+}
+
+// -----------------------------------------------------------------------------
+template <class VoxelType>
+inline int irtkConnectedComponents<VoxelType>::LargestComponent() const
+{
+  int label = 0, size = 0;
+  for (int i = 0; i < NumberOfComponents(); ++i) {
+    if (_Sizes[i] > size) label = i + 1, size = _Sizes[i];
+  }
+  return label;
+}
+
+// -----------------------------------------------------------------------------
+template <class VoxelType>
+inline int irtkConnectedComponents<VoxelType>::NumberOfComponents(int minsize) const
+{
+  int n = 0;
+  for (int i = 0; i < NumberOfComponents(); ++i) {
+    if (_Sizes[i] >= minsize) ++n;
+  }
+  return n;
+}
+
+// -----------------------------------------------------------------------------
+template <class VoxelType> template <class T>
+void irtkConnectedComponents<VoxelType>::SelectComponents(irtkGenericImage<T> *output, int minsize) const
+{
+  T *ptr = output->GetPointerToVoxels();
+  for (size_t idx = 0; idx < _Labels.size(); ++idx, ++ptr) {
+    *ptr = ((_Labels[idx] > 0 && _Sizes[_Labels[idx] - 1] >= minsize) ? 1 : 0);
+  }
+}
+
+// -----------------------------------------------------------------------------
+template <class VoxelType> template <class T>
+void irtkConnectedComponents<VoxelType>::SelectComponent(irtkGenericImage<T> *output, int label) const
+{
+  T *ptr = output->GetPointerToVoxels();
+  for (size_t idx = 0; idx < _Labels.size(); ++idx, ++ptr) {
+    *ptr = ((label > 0 && _Labels[idx] == label) ? 1 : 0);
+  }
+}
+
+
+#endif
@@ -36,6 +36,10 @@ protected:
   /// Sigma (standard deviation of Gaussian kernel)
   double _Sigma;
 
+  /// Whether to use recursive filters instead of kernels
+  /// (cf. irtkSeparableConvolution::RecursiveGaussian)
+  bool _Recursive;
+
 public:
 
   /// Constructor
@@ -59,6 +63,12 @@ public:
   /// Get sigma
   GetMacro(Sigma, double);
 
+  /// Set whether to use recursive filters for sigma of at least one voxel
+  SetMacro(Recursive, bool);
+
+  /// Get whether to use recursive filters for sigma of at least one voxel
+  GetMacro(Recursive, bool);
+
 };
 
 
@@ -33,9 +33,6 @@ class irtkConvolutionWithPadding_1D : public irtkConvolution_1D<VoxelType>
 {
   irtkImageFilterMacro(irtkConvolutionWithPadding_1D);
 
-public:
-  using irtkConvolution_1D<VoxelType>::Run;
-
 protected:
 
   /** Padding value. The padding value defines which voxels are ignored
@@ -63,6 +60,9 @@ public:
 
   /// Get the padding value
   VoxelType GetPaddingValue();
+
+  /// Run convolution filter for each voxel
+  virtual void Run();
 };
 
 #endif
@@ -60,6 +60,9 @@ public:
 
   /// Get the padding value
   VoxelType GetPaddingValue();
+
+  /// Run convolution filter
+  virtual void Run();
 };
 
 #endif
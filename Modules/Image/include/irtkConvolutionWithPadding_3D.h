@@ -58,6 +58,9 @@ public:
 
   /// Get the padding value
   VoxelType GetPaddingValue();
+
+  /// Run convolution filter
+  virtual void Run();
 };
 
 #endif
@@ -24,9 +24,12 @@
  * This class defines and implements one-dimensional convolutions of an image
  * with a filter kernel. The convolution is computed along the x-axis. This
  * class assumes that the filter kernel is one-dimensional and its size along
- * the y- and z-axis must be 1.
+ * the y- and z-axis must be 1. The convolution of all image lines is
+ * performed by irtkSeparableConvolution.
  */
 
+class irtkSeparableConvolution;
+
 template <class VoxelType>
 class irtkConvolution_1D : public irtkConvolution<VoxelType>
 {
@@ -42,6 +45,9 @@ protected:
    */
   virtual double Run(int, int, int, int);
 
+  /// Set kernel of separable convolution used by Run()
+  void InitializeConvolution(irtkSeparableConvolution &) const;
+
 public:
 
   /// Constructor
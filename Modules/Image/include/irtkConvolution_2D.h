@@ -24,7 +24,8 @@
  * This class defines and implements two-dimensional convolutions of an image
  * with a filter kernel. The convolution is computed along the x- and y-axis.
  * This class assumes that the filter kernel is two-dimensional and its size
- * along the z-axis must be 1.
+ * along the z-axis must be 1. If the kernel is the outer product of two 1D
+ * kernels, the convolution is performed by irtkSeparableConvolution.
  */
 
 template <class VoxelType>
@@ -52,6 +53,9 @@ public:
 
   /// Initialize the convolution filter
   virtual void Initialize();
+
+  /// Run convolution filter
+  virtual void Run();
 };
 
 #endif
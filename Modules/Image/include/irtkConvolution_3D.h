@@ -23,6 +23,8 @@
  *
  * This class defines and implements three-dimensional convolutions of an
  * image with a filter kernel. The convolution is computed along all axis.
+ * If the kernel is the outer product of three 1D kernels, the convolution
+ * is performed by irtkSeparableConvolution.
  */
 
 template <class VoxelType>
@@ -42,8 +44,6 @@ protected:
 
 public:
 
-  using irtkConvolution<VoxelType>::Run;
-
   /// Constructor
   irtkConvolution_3D(bool = false);
 
@@ -52,6 +52,9 @@ public:
 
   /// Run the convolution filter
   virtual void Initialize();
+
+  /// Run convolution filter
+  virtual void Run();
 };
 
 #endif
@@ -39,8 +39,15 @@ protected:
   /// 2D or 3D distance transform
   irtkDistanceTransformMode _distanceTransformMode;
 
-  /// Calculate the Vornoi diagram
-  int edtVornoiEDT(long *, long);
+  /// Whether to compute the signed distance to the boundary of the object,
+  /// i.e., the non-zero input voxels, instead of the squared distance to
+  /// the object. Distances are negative inside and positive outside.
+  irtkPublicAttributeMacro(bool, SignedDistance);
+
+protected:
+
+  /// Calculate the Vornoi diagram using the given scratch memory
+  int edtVornoiEDT(long *, long, long *, long *);
 
   /// Calculate 2D distance transform
   void edtComputeEDT_2D(char *, long *, long, long);
@@ -48,8 +55,8 @@ protected:
   /// Calculate 3D distance transform
   void edtComputeEDT_3D(char *, long *, long, long, long);
 
-  /// Calculate the Vornoi diagram for anisotripic voxel sizes
-  int edtVornoiEDT_anisotropic(VoxelType *, long, double);
+  /// Calculate the Vornoi diagram for anisotripic voxel sizes using the given scratch memory
+  int edtVornoiEDT_anisotropic(VoxelType *, long, double, float *, float *);
 
   /// Calculate 2D distance transform for anisotripic voxel sizes
   void edtComputeEDT_2D_anisotropic(VoxelType *, VoxelType *, long, long, double, double);
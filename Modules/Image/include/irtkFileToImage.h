@@ -33,7 +33,25 @@ class irtkFileToImage : protected irtkCifstream
   irtkAbstractMacro(irtkFileToImage);
 
   /// File name of image file
-  const char *_imagename;
+  string _imagename;
+
+  /// Whether to map uncompressed image data into memory instead of reading it
+  ///
+  /// When enabled, GetOutput returns an image which directly uses the data of
+  /// the memory-mapped image file if the file is uncompressed, the voxel
+  /// data is suitably aligned, and neither the byte order of the data has to
+  /// be swapped nor the image has to be reflected. Otherwise, the image data
+  /// is read from the file as usual. Only memory pages which are modified by
+  /// the caller are copied into private memory.
+  ///
+  /// \attention The image file must not be modified while the image is in use.
+  irtkPublicAttributeMacro(bool, MemoryMapping);
+
+  /// Whether to set the background value of a memory-mapped floating point
+  /// image to NaN if it contains NaNs, as done when the image is read
+  ///
+  /// Disabled by default, because this check reads the entire image file.
+  irtkPublicAttributeMacro(bool, MappedNaNBackground);
 
 protected:
 
@@ -74,6 +92,11 @@ protected:
    */
   virtual void ReadHeader() = 0;
 
+  /// Create image which uses the data of the memory-mapped image file
+  ///
+  /// \returns Image instance or NULL if image file cannot be mapped.
+  virtual irtkImage *GetMappedOutput();
+
 public:
 
   /// Contructor
@@ -89,6 +112,12 @@ public:
    */
   static irtkFileToImage *New(const char *);
 
+  /** Whether the named file exists and is of a supported image file format.
+   *  Unlike New(), this function does not terminate the program when the
+   *  file cannot be read by any of the derived classes.
+   */
+  static bool CheckFormat(const char *);
+
   /// Set input
   virtual void SetInput (const char *);
 
@@ -19,19 +19,26 @@
 
 #include <irtkImageToImage.h>
 
+class irtkSeparableConvolution;
+
 
 /**
  * Class for Gaussian blurring of images
  *
  * This class defines and implements the Gaussian blurring of images. The
  * blurring is implemented by three successive 1D convolutions with a 1D
- * Gaussian kernel.
+ * Gaussian kernel, which are performed by irtkSeparableConvolution in tiles
+ * of image lines. Only the first convolution writes to the output image,
+ * all others are done in place.
  *
  * By default, if one isotropic Gaussian standard deviation is specified,
  * the first three dimensions of the image are blurred only. Otherwise,
  * the 1D convolution with a 1D Gaussian kernel is performed only for
  * dimensions of more than one voxel size and for which a non-zero
  * standard deviation for the Gaussian kernel has been set.
+ *
+ * Optionally, a recursive approximation of the Gaussian filter can be used
+ * instead of the truncated kernel (see Recursive).
  */
 
 template <class VoxelType>
@@ -51,6 +58,18 @@ class irtkGaussianBlurring : public irtkImageToImage<VoxelType>
   /// Standard deviation of Gaussian kernel in t
   irtkAttributeMacro(double, SigmaT);
 
+  /// Whether to use a recursive filter instead of the Gaussian kernel
+  ///
+  /// The cost per voxel of the recursive filter does not depend on the
+  /// standard deviation, which makes it faster for standard deviations of
+  /// more than about five voxels. In the image interior, the difference to
+  /// the convolution with the sampled Gaussian kernel is less than 1% of
+  /// the maximum filter response (cf. irtkSeparableConvolution::RecursiveGaussian).
+  /// Near the boundary, the image is continued by its boundary values instead
+  /// of truncating and renormalizing the kernel. The kernel is still used for standard
+  /// deviations less than one voxel and when background voxels are ignored.
+  irtkPublicAttributeMacro(bool, Recursive);
+
 protected:
 
   /// Gaussian convolution kernel
@@ -65,6 +84,9 @@ protected:
   /// Finalize filter
   virtual void Finalize();
 
+  /// Convolve image along each dimension with non-zero standard deviation
+  void Convolve(irtkSeparableConvolution &);
+
 public:
 
   /// Constructor
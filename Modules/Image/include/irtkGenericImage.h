@@ -66,6 +66,9 @@ protected:
   /// Whether image data memory itself is owned by this instance
   bool _dataOwner;
 
+  /// Memory-mapped file which holds the (non-owned) image data, if any
+  shared_ptr<irtkMemoryMappedFile> _dataMap;
+
   // ---------------------------------------------------------------------------
   // Construction/Destruction
 
@@ -129,6 +132,14 @@ public:
   /// Initialize an image
   void Initialize(int, int, int = 1, int = 1, VoxelType *data = NULL);
 
+  /// Initialize an image which uses the data of a memory-mapped file
+  ///
+  /// The image data starts at the given byte offset of the mapped file.
+  /// Changes to the image data are not written back to the file, only the
+  /// modified memory pages are copied. The image keeps a reference to the
+  /// mapped file until its memory is reallocated or the image is destroyed.
+  void Initialize(const irtkImageAttributes &, const shared_ptr<irtkMemoryMappedFile> &, size_t);
+
   /// Copy image data from 1D array
   void CopyFrom(const VoxelType *);
 
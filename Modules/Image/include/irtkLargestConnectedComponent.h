@@ -24,7 +24,10 @@
  * Class for extracting the largest connected component from a labelled image
  *
  * This class defines and implements the extraction of the largest connected component
- * from a labelled image.
+ * from a labelled image. The components are found by irtkConnectedComponents.
+ * In 2D mode, the components of each slice are found separately and the output
+ * contains the largest component of every slice which has any voxel with the
+ * cluster label, not only the largest component of the whole image.
  *
  */
 
@@ -35,25 +38,17 @@ class irtkLargestConnectedComponent : public irtkImageToImage<VoxelType>
 
 private:
 
-  /// Size of current cluster
-  int _currentClusterSize;
-
-  /// Size of largest cluster
+  /// Size of largest cluster (of all slices in 2D mode)
   int _largestClusterSize;
 
   /// Label used to identify labels of interest
   VoxelType _ClusterLabel;
 
-  /// Mode
+  /// Whether to select the largest 2D component of each slice
   bool _Mode2D;
 
-protected:
-
-  /// Recursive region growing
-  void Grow2D(int, int, int, int);
-
-  /// Recursive region growing
-  void Grow3D(int, int, int, int);
+  /// What connectivity to assume when running the filter.
+  irtkConnectivityType _Connectivity;
 
 public:
 
@@ -75,6 +70,12 @@ public:
   /// Get mode
   GetMacro(Mode2D, bool);
 
+  /// Set connectivity
+  SetMacro(Connectivity, irtkConnectivityType);
+
+  /// Get connectivity
+  GetMacro(Connectivity, irtkConnectivityType);
+
   /// Run filter
   virtual void Run();
 
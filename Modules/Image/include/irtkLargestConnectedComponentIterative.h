@@ -24,9 +24,10 @@
  * Class for extracting the largest connected component from a labelled image
  *
  * This class defines and implements the extraction of the largest
- * connected component from a labelled image.  Uses an iterative method so
- * takes longer than the class irtkLargestConnectedComponent.  The stack
- * size needed, however, is lower.
+ * connected component from a labelled image.  Unlike the class
+ * irtkLargestConnectedComponent, it can optionally keep all clusters,
+ * each labelled with its own index.  The components are found by
+ * irtkConnectedComponents.
  *
  */
 
@@ -57,19 +58,8 @@ private:
 
   bool _AllClustersMode;
 
-protected:
-
-  /// Run filter
-  virtual void Run3D();
-  virtual void Run2D();
-
-  // Helper functions
-  virtual void ResetMarks();
-
-  virtual void SelectLargestCluster();
-
-  int CheckAdjacency2D(VoxelType& markA, VoxelType& markB);
-  int CheckAdjacency3D(VoxelType& markA, VoxelType& markB);
+  /// What connectivity to assume when running the filter.
+  irtkConnectivityType _Connectivity;
 
 public:
 
@@ -97,6 +87,15 @@ public:
   /// Get mode
   GetMacro(AllClustersMode, bool);
 
+  /// Set connectivity
+  SetMacro(Connectivity, irtkConnectivityType);
+
+  /// Get connectivity
+  GetMacro(Connectivity, irtkConnectivityType);
+
+  /// Get number of clusters found by last run
+  GetMacro(NumberOfClusters, int);
+
   /// Run filter
   virtual void Run();
 };
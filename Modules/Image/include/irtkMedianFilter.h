@@ -23,6 +23,29 @@
 /**
  * Class for median filtering an image
  *
+ * The median of the voxel values within a cubic neighbourhood is computed
+ * using a sliding window histogram. Near the image border, the neighbourhood
+ * is clipped to the image domain. If a mask is set, only voxels inside the
+ * mask are filtered and only the values of voxels inside the mask are
+ * considered. Other voxels keep their input value.
+ *
+ * For integral images whose intensity range n is less than MaxNumberOfBins,
+ * one histogram per image column of the neighbourhood is shifted along y and
+ * z, and the window histogram is updated along x by adding and subtracting
+ * column histograms (Perreault and Hebert, 2007). With a coarse level of
+ * sqrt(n) bins, each voxel costs O(r + sqrt(n)) time. This requires a
+ * histogram of n bins per column of the image and is only done when the
+ * image is small enough along x, and when sqrt(n) <= (2r+1)^2 log2(n).
+ *
+ * Otherwise, the histogram has one bin per voxel rank and is stored as binary
+ * indexed tree. For integral images, the rank is the offset of a value from
+ * the minimum value. For other images, e.g., floating point images, the
+ * distinct values of a few slices at a time are ranked, such that the
+ * histogram stays small enough to be cached. Moving the window by one voxel
+ * adds and removes 2 (2r+1)^2 samples, so each voxel costs O(r^2 log n) time,
+ * plus O(log n) amortized for ranking the values in the latter case. Ranking
+ * does not pay off for neighbourhoods of at most 125 voxels (r <= 2) of
+ * non-integral images, whose median is selected directly from the samples.
  */
 
 template <class VoxelType>
@@ -35,23 +58,28 @@ protected:
   /// Initialize the filter
   virtual void Initialize();
 
-  /// What connectivity to assume when running the filter.
+  /// Radius of cubic neighbourhood in voxels
   int _kernelRadius;
 
+  /// Optional mask of voxels to consider
   irtkRealImage* _mask;
 
 public:
 
+  /// Maximum intensity range of integral images for which the histogram
+  /// has one bin per value in this range
+  static const int MaxNumberOfBins;
+
   /// Constructor
   irtkMedianFilter();
 
   /// Destructor
   ~irtkMedianFilter();
 
-  /// Run dilation
+  /// Run median filter
   virtual void Run();
 
-  /// Set input image for filter
+  /// Set mask image for filter
   void SetMask (irtkRealImage*);
 
   SetMacro(kernelRadius, int);
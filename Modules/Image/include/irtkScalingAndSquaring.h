@@ -85,6 +85,21 @@ private:
   /// Intermediate Jacobian w.r.t. v
   irtkComponentMacro(ImageType, InterimJacobianDOFs);
 
+  /// Displacement field after squaring step, swapped with intermediate field
+  irtkComponentMacro(ImageType, SquaredDisplacement);
+
+  /// Jacobian w.r.t. x after squaring step
+  irtkComponentMacro(ImageType, SquaredJacobian);
+
+  /// Determinant of Jacobian w.r.t. x after squaring step
+  irtkComponentMacro(ImageType, SquaredDetJacobian);
+
+  /// Log of determinant of Jacobian w.r.t. x after squaring step
+  irtkComponentMacro(ImageType, SquaredLogJacobian);
+
+  /// Jacobian w.r.t. v after squaring step
+  irtkComponentMacro(ImageType, SquaredJacobianDOFs);
+
   /// Interpolator of intermediate displacement field
   irtkComponentMacro(DisplacementField, Displacement);
 
@@ -125,6 +140,11 @@ private:
   // Settings
 
   /// Attributes of intermediate images, defaults to output attributes
+  ///
+  /// When these attributes define a coarser grid than the output attributes,
+  /// e.g., the control point lattice of a free-form transformation, the
+  /// squaring steps are performed on this coarser grid and the result is
+  /// only interpolated at the output voxels after the last squaring step.
   irtkPublicAttributeMacro(irtkImageAttributes, InterimAttributes);
 
   /// Attributes of output images, defaults to input attributes
@@ -150,6 +170,11 @@ private:
   /// Number of squaring steps
   irtkPublicAttributeMacro(int, NumberOfSquaringSteps);
 
+  /// Number of squaring steps performed by last run of the filter, which is
+  /// greater than NumberOfSquaringSteps if the velocities had to be scaled
+  /// further to not exceed the MaxScaledVelocity
+  irtkReadOnlyAttributeMacro(int, ActualNumberOfSquaringSteps);
+
   /// Maximum velocity after scaling
   ///
   /// Set to zero in order to scale velocities by exactly
@@ -170,6 +195,10 @@ private:
   // Construction/Destruction
 
   /// Free allocated memory
+  ///
+  /// The intermediate images and interpolators are kept after each run of
+  /// the filter and reused by the next run if the attributes of the
+  /// intermediate images and the interpolation mode are unchanged.
   void Clear();
 
 public:
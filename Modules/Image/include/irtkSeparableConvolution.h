@@ -0,0 +1,452 @@
+/* The Image Registration Toolkit (IRTK)
+ *
+ * Copyright 2008-2015 Imperial College London
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#ifndef _IRTKSEPARABLECONVOLUTION_H
+
+#define _IRTKSEPARABLECONVOLUTION_H
+
+#include <irtkImage.h>
+
+#include <vector>
+
+
+/**
+ * Convolution of the lines of an image along one dimension with a 1D kernel
+ *
+ * This class is the common engine of the separable convolution filters. Instead
+ * of evaluating the convolution sum for each voxel separately, the image lines
+ * are copied in tiles of neighbouring lines to a contiguous buffer, where the
+ * kernel is applied one tap at a time to the entire line such that the inner
+ * loops can be vectorized by the compiler. The taps of symmetric and
+ * antisymmetric kernels are folded. The sum of the kernel weights which
+ * overlap the image or its foreground is accumulated in the same pass and used
+ * to normalize the result at the boundary. Tiles are processed in parallel and
+ * each tile is read before it is written, such that the convolution can be
+ * done in place.
+ *
+ * The kernel is given in the same order as for the functions of the
+ * irtkConvolutionFunction namespace, i.e., the result is the convolution
+ * sum_n k[n] I[i + r - n], where r is the radius of the kernel.
+ *
+ * Instead of a kernel, a recursive approximation of the convolution with a
+ * Gaussian or its first or second derivative can be used (see
+ * RecursiveGaussian). Its cost per voxel is independent of the standard
+ * deviation, which makes it the faster choice for large standard deviations.
+ */
+
+class irtkSeparableConvolution : public irtkObject
+{
+  irtkObjectMacro(irtkSeparableConvolution);
+
+public:
+
+  /// Treatment of image boundary and background voxels
+  enum BoundaryMode
+  {
+    TruncateKernel,     ///< Truncate kernel at image boundary
+    IgnoreBackground,   ///< Skip voxels with value less or equal background
+    TruncateForeground, ///< Truncate kernel at first background voxel
+    ExtendForeground    ///< Extend foreground into background and beyond boundary
+  };
+
+  /// Treatment of image boundary and background voxels
+  irtkPublicAttributeMacro(BoundaryMode, Boundary);
+
+  /// Whether to divide by sum of kernel weights which overlap the foreground
+  irtkPublicAttributeMacro(bool, Normalize);
+
+  /// Background value of image
+  irtkPublicAttributeMacro(double, Background);
+
+  /// Factor by which convolved foreground values are multiplied
+  irtkPublicAttributeMacro(double, Scale);
+
+  /// Downsampling factor, i.e., only every n-th voxel is convolved
+  irtkPublicAttributeMacro(int, Factor);
+
+  /// Kernel weights in reverse order, i.e., centered correlation weights
+  irtkReadOnlyAttributeMacro(vector<double>, Weights);
+
+  /// Radius of kernel
+  irtkReadOnlyAttributeMacro(int, Radius);
+
+  /// Symmetry of kernel (+1: symmetric, -1: antisymmetric, 0: neither)
+  irtkReadOnlyAttributeMacro(int, Symmetry);
+
+  /// Order of recursive Gaussian derivative filter or -1 if kernel is used
+  irtkReadOnlyAttributeMacro(int, RecursiveOrder);
+
+public:
+
+  /// Constructor
+  irtkSeparableConvolution(BoundaryMode = TruncateKernel, bool = true);
+
+  /// Destructor
+  virtual ~irtkSeparableConvolution();
+
+  /// Set convolution kernel of odd size
+  template <class TKernel>
+  void Kernel(const TKernel *, int);
+
+  /// Set convolution kernel of odd size
+  template <class TKernel>
+  void Kernel(const irtkGenericImage<TKernel> *);
+
+  /// Use recursive filter instead of kernel (cf. Deriche 1993)
+  ///
+  /// The lines are filtered by the fourth order recursive approximation of
+  /// the convolution with a Gaussian function or one of its derivatives by
+  /// Deriche, with the normalization of Farneback and Westin (2006) such that
+  /// the filter exactly reproduces the derivative of constant, linear, and
+  /// quadratic functions, respectively. For standard deviations from 1 to 12
+  /// voxels, the impulse response differs from the one of the sampled kernel
+  /// used by irtkGaussianBlurring, irtkConvolutionWithGaussianDerivative, and
+  /// irtkConvolutionWithGaussianDerivative2 by less than 1% of its peak for
+  /// order 0, 0.5% for order 1, and 1.5% for order 2. For order 0, most of
+  /// this difference is due to the truncation of the kernel. For standard
+  /// deviations of less than one voxel, the error grows quickly and a kernel
+  /// should be used instead.
+  ///
+  /// The image is continued beyond its boundary by the value of the first
+  /// and last voxel of each line, respectively. Only the TruncateKernel
+  /// boundary mode is supported.
+  ///
+  /// \param[in] sigma Standard deviation of Gaussian in voxel units.
+  /// \param[in] order Order of derivative (0, 1, or 2).
+  void RecursiveGaussian(double sigma, int order = 0);
+
+  /// Index of first convolved input voxel when downsampling n voxels
+  int Offset(int) const;
+
+  /// Number of output voxels when downsampling n voxels
+  int Size(int) const;
+
+  /// Convolve lines of input image along given dimension (0: x, 1: y, 2: z, 3: t)
+  ///
+  /// The output image must have the same size as the input image except of the
+  /// downsampled dimension. It may be identical to the input image.
+  template <class T1, class T2>
+  void Run(const irtkGenericImage<T1> *, int, irtkGenericImage<T2> *) const;
+
+  /// Convolve lines of image in place along given dimension
+  template <class T>
+  void Run(irtkGenericImage<T> *, int) const;
+
+  /// Apply kernel to contiguous line
+  ///
+  /// \param[in]  in  Input line of \p n voxels.
+  /// \param[in]  n   Number of voxels.
+  /// \param[out] out Convolved voxels (see Factor and Offset).
+  /// \param[in]  buf Scratch memory of size BufferSize(n).
+  void ConvolveLine(const double *in, int n, double *out, double *buf) const;
+
+  /// Size of scratch memory needed by ConvolveLine
+  int BufferSize(int) const;
+
+protected:
+
+  /// Apply kernel at voxels [0, n) of buffer padded by the kernel radius
+  void Fold(const double *, int, double *) const;
+
+  /// Convolve run of voxels [i, j) of line with kernel truncated outside run
+  void ConvolveTruncated(const double *, int, int, double *, double *) const;
+
+  /// Apply recursive filter to line of n voxels using scratch memory of size 3 (n + 8)
+  void ConvolveRecursive(const double *, int, double *, double *) const;
+
+  /// Cumulative sums of kernel weights used to normalize truncated kernel
+  vector<double> _CumulativeWeights;
+
+  double _RecursiveN[4]; ///< Feedforward coefficients of causal filter
+  double _RecursiveM[4]; ///< Feedforward coefficients of anti-causal filter
+  double _RecursiveD[4]; ///< Feedback coefficients of both filters
+  double _RecursiveB[2]; ///< Steady state gain of causal and anti-causal filter
+
+};
+
+////////////////////////////////////////////////////////////////////////////////
+// Auxiliary functors
+////////////////////////////////////////////////////////////////////////////////
+
+namespace irtkSeparableConvolutionUtils {
+
+
+// -----------------------------------------------------------------------------
+/// Convolve tiles of neighbouring image lines
+template <class T1, class T2>
+struct ConvolveLineTiles
+{
+  const irtkSeparableConvolution *_Filter;
+  const T1                       *_Input;
+  T2                             *_Output;
+  int                             _Length;       ///< Number of input voxels along line
+  int                             _OutputLength; ///< Number of output voxels along line
+  int                             _Stride;       ///< Stride between voxels of line
+  int                             _Blocks;       ///< Number of blocks of lines
+  int                             _TileSize;     ///< Maximum number of lines per tile
+  int                             _Tiles;        ///< Number of tiles per block of lines
+
+  void operator ()(const blocked_range<int> &re) const
+  {
+    const int L = _Length, M = _OutputLength, S = _Stride;
+    vector<double> in (_TileSize * L), out(_TileSize * M);
+    vector<double> buf(_Filter->BufferSize(L));
+    int b, w, n, i, k;
+
+    for (int tile = re.begin(); tile != re.end(); ++tile) {
+      // Contiguous lines along x are grouped in tiles of neighbouring lines,
+      // whereas tiles of lines along the other dimensions are made up of
+      // neighbouring lines of the same block such that each row of a tile
+      // is a contiguous section of memory
+      if (S == 1) {
+        b = tile * _TileSize, w = 0;
+        n = min(_TileSize, _Blocks - b);
+        const T1 *ip = _Input + static_cast<size_t>(b) * L;
+        for (k = 0; k < n * L; ++k) in[k] = static_cast<double>(ip[k]);
+      } else {
+        b = tile / _Tiles, w = (tile % _Tiles) * _TileSize;
+        n = min(_TileSize, S - w);
+        const T1 *ip = _Input + static_cast<size_t>(b) * L * S + w;
+        for (i = 0; i < L; ++i, ip += S)
+        for (k = 0; k < n; ++k) {
+          in[k * L + i] = static_cast<double>(ip[k]);
+        }
+      }
+      // Convolve lines of tile
+      for (k = 0; k < n; ++k) {
+        _Filter->ConvolveLine(&in[k * L], L, &out[k * M], &buf[0]);
+      }
+      // Write convolved lines
+      if (S == 1) {
+        T2 *op = _Output + static_cast<size_t>(b) * M;
+        for (k = 0; k < n * M; ++k) op[k] = voxel_cast<T2>(out[k]);
+      } else {
+        T2 *op = _Output + static_cast<size_t>(b) * M * S + w;
+        for (i = 0; i < M; ++i, op += S)
+        for (k = 0; k < n; ++k) {
+          op[k] = voxel_cast<T2>(out[k * M + i]);
+        }
+      }
+    }
+  }
+};
+
+// -----------------------------------------------------------------------------
+/// Factorize kernel of size nx x ny x nz into 1D kernels (in correlation order)
+///
+/// \returns Whether the kernel is the outer product of 1D kernels of odd size.
+template <class TKernel>
+bool FactorizeKernel(const irtkGenericImage<TKernel> *kernel, vector<double> factor[3])
+{
+  const int size[3] = { kernel->X(), kernel->Y(), kernel->Z() };
+  if (size[0] % 2 == 0 || size[1] % 2 == 0 || size[2] % 2 == 0) return false;
+  // Find largest kernel weight
+  int    p[3] = { 0, 0, 0 };
+  double v    = .0;
+  for (int k = 0; k < size[2]; ++k)
+  for (int j = 0; j < size[1]; ++j)
+  for (int i = 0; i < size[0]; ++i) {
+    const double w = static_cast<double>(kernel->Get(i, j, k));
+    if (fabs(w) > fabs(v)) v = w, p[0] = i, p[1] = j, p[2] = k;
+  }
+  if (v == .0) return false;
+  // Rows through largest weight divided by this weight except of first factor
+  factor[0].resize(size[0]);
+  factor[1].resize(size[1]);
+  factor[2].resize(size[2]);
+  for (int i = 0; i < size[0]; ++i) factor[0][i] = kernel->Get(i, p[1], p[2]);
+  for (int j = 0; j < size[1]; ++j) factor[1][j] = kernel->Get(p[0], j, p[2]) / v;
+  for (int k = 0; k < size[2]; ++k) factor[2][k] = kernel->Get(p[0], p[1], k) / v;
+  // Check that kernel is outer product of factors
+  const double tol = 1e-6 * fabs(v);
+  for (int k = 0; k < size[2]; ++k)
+  for (int j = 0; j < size[1]; ++j)
+  for (int i = 0; i < size[0]; ++i) {
+    const double w = factor[0][i] * factor[1][j] * factor[2][k];
+    if (fabs(static_cast<double>(kernel->Get(i, j, k)) - w) > tol) return false;
+  }
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+/// Convolve image with separable 2D or 3D kernel (cf. irtkConvolution_2D/3D)
+///
+/// The kernel is applied without flipping it. If \p pad is true, voxels with
+/// value less or equal the padding value are ignored and set to the padding
+/// value in the output. If \p norm is true, the result is divided by the sum
+/// of the kernel weights at voxels inside the image which are not ignored.
+///
+/// \param[in] factor 1D kernels obtained by FactorizeKernel.
+template <class T>
+void ConvolveWithSeparableKernel(const irtkGenericImage<T> *input, vector<double> factor[3],
+                                 irtkGenericImage<T> *output, int dims, bool norm,
+                                 bool pad = false, double padding = .0)
+{
+  // Numerator and denominator of (normalized) convolution
+  const int n = input->GetNumberOfVoxels();
+  const T  *in = input->GetPointerToVoxels();
+  irtkGenericImage<double> num(input->GetImageAttributes());
+  irtkGenericImage<double> den;
+  if (norm) den.Initialize(input->GetImageAttributes());
+  double *v = num.GetPointerToVoxels();
+  double *w = (norm ? den.GetPointerToVoxels() : NULL);
+  for (int idx = 0; idx < n; ++idx) {
+    const bool fg = (!pad || static_cast<double>(in[idx]) > padding);
+    v[idx] = (fg ? static_cast<double>(in[idx]) : .0);
+    if (w) w[idx] = (fg ? 1.0 : .0);
+  }
+
+  // Convolve both with 1D kernels along each dimension
+  irtkSeparableConvolution conv(irtkSeparableConvolution::TruncateKernel, false);
+  for (int d = 0; d < dims; ++d) {
+    vector<double> &k = factor[d];
+    reverse(k.begin(), k.end());
+    conv.Kernel(&k[0], static_cast<int>(k.size()));
+    conv.Run(&num, d);
+    if (norm) conv.Run(&den, d);
+  }
+
+  // Write result
+  T *out = output->GetPointerToVoxels();
+  for (int idx = 0; idx < n; ++idx) {
+    if (pad && static_cast<double>(in[idx]) <= padding) {
+      out[idx] = voxel_cast<T>(padding);
+    } else if (norm) {
+      out[idx] = voxel_cast<T>(w[idx] > .0 ? v[idx] / w[idx] : .0);
+    } else {
+      out[idx] = voxel_cast<T>(v[idx]);
+    }
+  }
+}
+
+
+} // namespace irtkSeparableConvolutionUtils
+
+////////////////////////////////////////////////////////////////////////////////
+// Inline definitions
+////////////////////////////////////////////////////////////////////////////////
+
+// -----------------------------------------------------------------------------
+template <class TKernel>
+void irtkSeparableConvolution::Kernel(const TKernel *kernel, int size)
+{
+  if (size < 1 || size % 2 == 0) {
+    cerr << this->NameOfClass() << "::Kernel: Kernel size must be odd" << endl;
+    exit(1);
+  }
+  _RecursiveOrder = -1;
+  _Radius = (size - 1) / 2;
+  _Weights.resize(size);
+  for (int n = 0; n < size; ++n) {
+    _Weights[n] = static_cast<double>(kernel[size - 1 - n]);
+  }
+  _CumulativeWeights.resize(size + 1);
+  _CumulativeWeights[0] = .0;
+  for (int n = 0; n < size; ++n) {
+    _CumulativeWeights[n + 1] = _CumulativeWeights[n] + _Weights[n];
+  }
+  _Symmetry = +1;
+  for (int t = 1; t <= _Radius; ++t) {
+    if (_Weights[_Radius - t] != _Weights[_Radius + t]) _Symmetry = 0;
+  }
+  if (_Symmetry == 0 && _Weights[_Radius] == .0) {
+    _Symmetry = -1;
+    for (int t = 1; t <= _Radius; ++t) {
+      if (_Weights[_Radius - t] != -_Weights[_Radius + t]) _Symmetry = 0;
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+template <class TKernel>
+void irtkSeparableConvolution::Kernel(const irtkGenericImage<TKernel> *kernel)
+{
+  Kernel(kernel->GetPointerToVoxels(), kernel->GetNumberOfVoxels());
+}
+
+// -----------------------------------------------------------------------------
+inline int irtkSeparableConvolution::Offset(int n) const
+{
+  return (_Factor > 1 ? (n % _Factor + 1) / 2 : 0);
+}
+
+// -----------------------------------------------------------------------------
+inline int irtkSeparableConvolution::Size(int n) const
+{
+  return (_Factor > 1 ? n / _Factor : n);
+}
+
+// -----------------------------------------------------------------------------
+template <class T1, class T2>
+void irtkSeparableConvolution::Run(const irtkGenericImage<T1> *input, int dim, irtkGenericImage<T2> *output) const
+{
+  using namespace irtkSeparableConvolutionUtils;
+
+  if (dim < 0 || dim > 3) {
+    cerr << this->NameOfClass() << "::Run: Invalid image dimension: " << dim << endl;
+    exit(1);
+  }
+  if (_Weights.empty() && _RecursiveOrder < 0) {
+    cerr << this->NameOfClass() << "::Run: Convolution kernel not set" << endl;
+    exit(1);
+  }
+  if (_RecursiveOrder >= 0 && _Boundary != TruncateKernel) {
+    cerr << this->NameOfClass() << "::Run: Recursive filter supports TruncateKernel boundary mode only" << endl;
+    exit(1);
+  }
+
+  const int size[4] = { input->X(), input->Y(), input->Z(), input->T() };
+  const int outsz[4] = { output->X(), output->Y(), output->Z(), output->T() };
+  for (int d = 0; d < 4; ++d) {
+    if (outsz[d] != (d == dim ? Size(size[d]) : size[d])) {
+      cerr << this->NameOfClass() << "::Run: Output image has invalid size" << endl;
+      exit(1);
+    }
+  }
+
+  ConvolveLineTiles<T1, T2> body;
+  body._Filter       = this;
+  body._Input        = input ->GetPointerToVoxels();
+  body._Output       = output->GetPointerToVoxels();
+  body._Length       = size[dim];
+  body._OutputLength = outsz[dim];
+  body._Stride       = 1;
+  for (int d = 0; d < dim; ++d) body._Stride *= size[d];
+  if (body._Length == 0 || body._OutputLength == 0) return;
+
+  body._Blocks = input->GetNumberOfVoxels() / (body._Length * body._Stride);
+  if (body._Stride == 1) {
+    // Group short lines such that each tile has at least a few thousand voxels
+    body._TileSize = max(1, 4096 / body._Length);
+    body._Tiles    = (body._Blocks + body._TileSize - 1) / body._TileSize;
+  } else {
+    // Read at least one cache line of voxels of each row of a tile
+    body._TileSize = min(16, body._Stride);
+    body._Tiles    = (body._Stride + body._TileSize - 1) / body._TileSize;
+  }
+  const int tiles = (body._Stride == 1 ? body._Tiles : body._Blocks * body._Tiles);
+  parallel_for(blocked_range<int>(0, tiles), body);
+}
+
+// -----------------------------------------------------------------------------
+template <class T>
+void irtkSeparableConvolution::Run(irtkGenericImage<T> *image, int dim) const
+{
+  Run(image, dim, image);
+}
+
+
+#endif
@@ -72,9 +72,10 @@ irtkBaseImage::~irtkBaseImage()
 // =============================================================================
 
 // -----------------------------------------------------------------------------
-irtkBaseImage *irtkBaseImage::New(const char *fname)
+irtkBaseImage *irtkBaseImage::New(const char *fname, bool mmap)
 {
   irtkFileToImage *reader = irtkFileToImage::New(fname);
+  reader->MemoryMapping(mmap);
   irtkBaseImage   *image  = reader->GetOutput();
   delete reader;
   return image;
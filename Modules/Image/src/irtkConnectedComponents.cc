@@ -0,0 +1,239 @@
+/* The Image Registration Toolkit (IRTK)
+ *
+ * Copyright 2008-2015 Imperial College London
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include <irtkConnectedComponents.h>
+
+// =============================================================================
+// Auxiliary functions and functors
+// =============================================================================
+
+namespace irtkConnectedComponentsUtils {
+
+
+// -----------------------------------------------------------------------------
+/// Offset of neighbour which precedes a voxel in memory
+struct NeighbourOffset
+{
+  int _X, _Y, _Z;
+};
+
+// -----------------------------------------------------------------------------
+/// Preceding neighbours of 6-, 18-, and 26-connectivity, ordered such that
+/// the first 3, 9, and 13 offsets correspond to the 6-, 18-, and
+/// 26-neighbourhood, respectively, and the in-plane offsets of the first
+/// 3 and 5 offsets to the 2D 4- and 8-neighbourhood
+const NeighbourOffset _Preceding[13] = {
+  { -1,  0,  0 }, {  0, -1,  0 }, {  0,  0, -1 }, { -1, -1,  0 }, { +1, -1,  0 },
+  {  0, -1, -1 }, {  0, +1, -1 }, { -1,  0, -1 }, { +1,  0, -1 },
+  { -1, -1, -1 }, { +1, -1, -1 }, { -1, +1, -1 }, { +1, +1, -1 }
+};
+
+// -----------------------------------------------------------------------------
+/// Find root of voxel with path halving
+inline int Find(int *parent, int i)
+{
+  while (parent[i] != i) {
+    parent[i] = parent[parent[i]];
+    i = parent[i];
+  }
+  return i;
+}
+
+// -----------------------------------------------------------------------------
+/// Merge sets of two voxels, where the root with the smaller index becomes
+/// the root of the merged set such that parent[i] <= i for all voxels
+inline void Union(int *parent, int i, int j)
+{
+  i = Find(parent, i);
+  j = Find(parent, j);
+  if      (i < j) parent[j] = i;
+  else if (j < i) parent[i] = j;
+}
+
+// -----------------------------------------------------------------------------
+/// Union of each voxel with its preceding neighbours in a range of slabs
+template <class VoxelType>
+class UnionSlabs
+{
+public:
+
+  const VoxelType       *_Input;
+  VoxelType              _Label;
+  int                   *_Parent;
+  const NeighbourOffset *_Offsets;
+  int                    _NumberOfOffsets;
+  int                    _X, _Y, _Z;
+  int                    _NumberOfSlabs;
+  bool                   _Seams;
+
+  /// First slice of slab
+  int Begin(int s) const
+  {
+    return static_cast<int>((static_cast<long>(s) * _Z) / _NumberOfSlabs);
+  }
+
+  /// Union of voxel with its preceding neighbours in the given slice range
+  void UnionNeighbours(int x, int y, int z, int zmin) const
+  {
+    const int idx = (z * _Y + y) * _X + x;
+    int       nx, ny, nz, nbr;
+    for (int n = 0; n < _NumberOfOffsets; ++n) {
+      const NeighbourOffset &o = _Offsets[n];
+      nx = x + o._X, ny = y + o._Y, nz = z + o._Z;
+      if (nx < 0 || nx >= _X || ny < 0 || ny >= _Y || nz < zmin) continue;
+      nbr = (nz * _Y + ny) * _X + nx;
+      if (_Input[nbr] == _Label) Union(_Parent, idx, nbr);
+    }
+  }
+
+  void operator ()(const blocked_range<int> &re) const
+  {
+    for (int s = re.begin(); s != re.end(); ++s) {
+      const int z1 = Begin(s), z2 = Begin(s + 1);
+      // Only neighbours across the seam to the previous slab
+      if (_Seams) {
+        if (z1 == 0 || z1 == z2) continue;
+        for (int y = 0; y < _Y; ++y)
+        for (int x = 0; x < _X; ++x) {
+          if (_Input[(z1 * _Y + y) * _X + x] == _Label) UnionNeighbours(x, y, z1, z1 - 1);
+        }
+      // All neighbours within the slab
+      } else {
+        for (int z = z1; z < z2; ++z)
+        for (int y = 0; y < _Y; ++y)
+        for (int x = 0; x < _X; ++x) {
+          if (_Input[(z * _Y + y) * _X + x] == _Label) UnionNeighbours(x, y, z, z1);
+        }
+      }
+    }
+  }
+};
+
+
+} // namespace irtkConnectedComponentsUtils
+using namespace irtkConnectedComponentsUtils;
+
+// =============================================================================
+// Construction/Destruction
+// =============================================================================
+
+// -----------------------------------------------------------------------------
+template <class VoxelType>
+irtkConnectedComponents<VoxelType>::irtkConnectedComponents(VoxelType label, irtkConnectivityType connectivity)
+:
+  _Input         (NULL),
+  _ComponentLabel(label),
+  _Connectivity  (connectivity),
+  _Mode2D        (false)
+{
+}
+
+// -----------------------------------------------------------------------------
+template <class VoxelType>
+irtkConnectedComponents<VoxelType>::~irtkConnectedComponents()
+{
+}
+
+// =============================================================================
+// Execution
+// =============================================================================
+
+// -----------------------------------------------------------------------------
+template <class VoxelType>
+void irtkConnectedComponents<VoxelType>::Run()
+{
+  const int nx = _Input->GetX();
+  const int ny = _Input->GetY();
+  const int nz = _Input->GetZ();
+  const int n  = nx * ny * nz;
+
+  const bool mode2D = (_Mode2D || nz == 1 || _Connectivity == CONNECTIVITY_04);
+
+  // Preceding neighbours to consider
+  UnionSlabs<VoxelType> body;
+  body._Input   = _Input->GetPointerToVoxels();
+  body._Label   = _ComponentLabel;
+  body._Offsets = _Preceding;
+  body._X       = nx;
+  body._Y       = ny;
+  body._Z       = nz;
+  switch (_Connectivity) {
+    case CONNECTIVITY_04:
+    case CONNECTIVITY_06: body._NumberOfOffsets = 3; break;
+    case CONNECTIVITY_18: body._NumberOfOffsets = (mode2D ? 5 :  9); break;
+    case CONNECTIVITY_26: body._NumberOfOffsets = (mode2D ? 5 : 13); break;
+    default:
+      cerr << "irtkConnectedComponents::Run: Unknown connectivity" << endl;
+      exit(1);
+  }
+
+  // Initialize each voxel as its own set
+  vector<int> parent(n);
+  for (int idx = 0; idx < n; ++idx) parent[idx] = idx;
+  body._Parent = (n > 0 ? &parent[0] : NULL);
+
+  // Union of voxels within slabs of slices which touch disjoint parts of
+  // the parent array and can thus be processed in parallel, followed by
+  // the union of voxels across the seams between slabs. In 2D, each slab
+  // is a single slice such that offsets out of plane are skipped.
+  body._NumberOfSlabs = (mode2D ? nz : min(nz, 64));
+  body._Seams         = false;
+  parallel_for(blocked_range<int>(0, body._NumberOfSlabs), body);
+  if (!mode2D) {
+    body._Seams = true;
+    body(blocked_range<int>(0, body._NumberOfSlabs));
+  }
+
+  // Assign consecutive labels to roots in memory order and count voxels,
+  // where parent[idx] <= idx such that the root of each parent is known
+  _Labels.assign(n, 0);
+  _Sizes.clear();
+  const VoxelType *input = _Input->GetPointerToVoxels();
+  for (int idx = 0; idx < n; ++idx) {
+    if (input[idx] != _ComponentLabel) continue;
+    parent[idx] = parent[parent[idx]];
+    if (parent[idx] == idx) {
+      _Sizes.push_back(0);
+      _Labels[idx] = static_cast<int>(_Sizes.size());
+    } else {
+      _Labels[idx] = _Labels[parent[idx]];
+    }
+    ++_Sizes[_Labels[idx] - 1];
+  }
+}
+
+// -----------------------------------------------------------------------------
+template <class VoxelType>
+int irtkConnectedComponents<VoxelType>::LargestComponent(int z) const
+{
+  const int nxy = _Input->GetX() * _Input->GetY();
+  int label = 0, size = 0, l;
+  for (int idx = z * nxy; idx < (z + 1) * nxy; ++idx) {
+    l = _Labels[idx];
+    if (l > 0 && (_Sizes[l - 1] > size || (_Sizes[l - 1] == size && l < label))) {
+      label = l, size = _Sizes[l - 1];
+    }
+  }
+  return label;
+}
+
+// =============================================================================
+// Explicit template instantiations
+// =============================================================================
+
+template class irtkConnectedComponents<irtkBytePixel>;
+template class irtkConnectedComponents<irtkGreyPixel>;
+template class irtkConnectedComponents<irtkRealPixel>;
@@ -16,16 +16,66 @@
 
 #include <irtkImage.h>
 
-#include <irtkConvolution.h>
+#include <irtkSeparableConvolution.h>
 #include <irtkScalarFunctionToImage.h>
 #include <irtkScalarGaussianDx.h>
-#include <irtkScalarGaussianDy.h>
-#include <irtkScalarGaussianDz.h>
 #include <irtkConvolutionWithGaussianDerivative.h>
 
+// =============================================================================
+// Auxiliary functions
+// =============================================================================
+
+namespace irtkConvolutionWithGaussianDerivativeUtils {
+
+
+// -----------------------------------------------------------------------------
+/// Convolve image along given dimension with 1D kernel sampled from function,
+/// where the kernel is applied without flipping it as by irtkConvolution_1D
+///
+/// Only the Gaussian kernel of derivative order 0 is normalized. If requested,
+/// a recursive filter is used instead of the kernel, which is scaled such that
+/// its response to x^order / order! equals the one of the kernel.
+template <class VoxelType>
+void Convolve(const irtkGenericImage<VoxelType> *input, irtkGenericImage<VoxelType> *output, int dim,
+              irtkScalarFunction &function, int order, double sigma, bool recursive,
+              bool pad, double padding)
+{
+  // Create filter kernel
+  irtkGenericImage<irtkRealPixel> kernel(2*round(4*sigma)+1, 1, 1);
+  irtkScalarFunctionToImage<irtkRealPixel> source;
+  source.SetInput (&function);
+  source.SetOutput(&kernel);
+  source.Run();
+
+  // Convolve image lines
+  irtkSeparableConvolution conv(pad ? irtkSeparableConvolution::IgnoreBackground
+                                    : irtkSeparableConvolution::TruncateKernel, order == 0);
+  conv.Background(padding);
+  const int n = kernel.X();
+  if (recursive && !pad && sigma >= 1.0) {
+    double moment = (order == 0 ? 1.0 : .0);
+    for (int i = 0; order > 0 && i < n; ++i) {
+      moment += kernel(i, 0, 0) * pow(static_cast<double>(i - n / 2), order);
+    }
+    if (order == 2) moment /= 2.0;
+    conv.RecursiveGaussian(sigma, order);
+    conv.Scale(moment);
+  } else {
+    vector<irtkRealPixel> weights(n);
+    for (int i = 0; i < n; ++i) weights[i] = kernel(n - 1 - i, 0, 0);
+    conv.Kernel(&weights[0], n);
+  }
+  conv.Run(input, dim, output);
+}
+
+
+} // namespace irtkConvolutionWithGaussianDerivativeUtils
+using namespace irtkConvolutionWithGaussianDerivativeUtils;
+
 template <class VoxelType> irtkConvolutionWithGaussianDerivative<VoxelType>::irtkConvolutionWithGaussianDerivative(double Sigma)
 {
-  _Sigma = Sigma;
+  _Sigma     = Sigma;
+  _Recursive = false;
 }
 
 template <class VoxelType> irtkConvolutionWithGaussianDerivative<VoxelType>::~irtkConvolutionWithGaussianDerivative()
@@ -34,91 +84,32 @@ template <class VoxelType> irtkConvolutionWithGaussianDerivative<VoxelType>::~ir
 template <class VoxelType> void irtkConvolutionWithGaussianDerivative<VoxelType>::Ix()
 {
   double xsize, ysize, zsize;
-  
+
   // Do the initial set up
   this->Initialize();
 
   // Get voxel dimensions
   this->_input->GetPixelSize(&xsize, &ysize, &zsize);
 
-  // Instantiate convolution filter
-  irtkConvolution_1D<VoxelType> *convolution = NULL;
-  if (this->_input->HasBackgroundValue()) {
-    convolution = new irtkConvolutionWithPadding_1D<VoxelType>(this->_input->GetBackgroundValueAsDouble());
-  } else {
-    convolution = new irtkConvolution_1D<VoxelType>();
-  }
-
-  // Create scalar function which corresponds to a 1D Gaussian function in X
-  irtkScalarGaussianDx gaussianDx(this->_Sigma/xsize, 1, 1, 0, 0, 0);
-  // Create filter kernel for 1D Gaussian function in X
-  irtkGenericImage<irtkRealPixel> kernelX(2*round(4*this->_Sigma/xsize)+1, 1, 1);
-  // Do conversion from  scalar function to filter kernel
-  irtkScalarFunctionToImage<irtkRealPixel> gaussianSourceX;
-  gaussianSourceX.SetInput (&gaussianDx);
-  gaussianSourceX.SetOutput(&kernelX);
-  gaussianSourceX.Run();
-
-  // Do convolution
-  convolution->SetInput ( this->_input);
-  convolution->SetInput2(&kernelX);
-  convolution->SetOutput(this->_output);
-  convolution->irtkImageToImage<VoxelType>::Run();
-
-  // Flip x and y axis of image
-  this->_output->FlipXY(1);
-
-  // Create scalar function which corresponds to a 1D Gaussian function in Y
-  irtkScalarGaussian gaussianY(this->_Sigma/ysize, 1, 1, 0, 0, 0);
-
-  // Create filter kernel for 1D Gaussian function in Y
-  irtkGenericImage<irtkRealPixel> kernelY(2*round(4*this->_Sigma/ysize)+1, 1, 1);
-
-  // Do conversion from  scalar function to filter kernel
-  irtkScalarFunctionToImage<irtkRealPixel> gaussianSourceY;
-  gaussianSourceY.SetInput (&gaussianY);
-  gaussianSourceY.SetOutput(&kernelY);
-  gaussianSourceY.Run();
-
-  // Do convolution
-  convolution->SetInput (this->_output);
-  convolution->SetInput2(&kernelY);
-  convolution->SetOutput(this->_output);
-  convolution->SetNormalization(true);
-  convolution->irtkImageToImage<VoxelType>::Run();
-
-  // Flip x and z axis of image
-  this->_output->FlipXZ(1);
-
-  if (this->_output->GetX() != 1) {
-    // Create scalar function which corresponds to a 1D Gaussian function in Z
-    irtkScalarGaussian gaussianZ(this->_Sigma/zsize, 1, 1, 0, 0, 0);
-
-    // Create filter kernel for 1D Gaussian function in Z
-    irtkGenericImage<irtkRealPixel> kernelZ(2*round(4*this->_Sigma/zsize)+1, 1, 1);
-
-    // Do conversion from  scalar function to filter kernel
-    irtkScalarFunctionToImage<irtkRealPixel> gaussianSourceZ;
-    gaussianSourceZ.SetInput (&gaussianZ);
-    gaussianSourceZ.SetOutput(&kernelZ);
-    gaussianSourceZ.Run();
-
-    // Do convolution
-    convolution->SetInput (this->_output);
-    convolution->SetInput2(&kernelZ);
-    convolution->SetOutput(this->_output);
-    convolution->SetNormalization(true);
-    convolution->irtkImageToImage<VoxelType>::Run();
+  // Ignore background if any
+  const bool   pad     = this->_input->HasBackgroundValue();
+  const double padding = this->_input->GetBackgroundValueAsDouble();
+
+  // Create scalar functions which correspond to 1D Gaussian functions and
+  // the derivative of the 1D Gaussian function in x
+  irtkScalarGaussianDx gaussianX(this->_Sigma/xsize, 1, 1, 0, 0, 0);
+  irtkScalarGaussian   gaussianY(this->_Sigma/ysize, 1, 1, 0, 0, 0);
+  irtkScalarGaussian   gaussianZ(this->_Sigma/zsize, 1, 1, 0, 0, 0);
+
+  // Do convolution, where the derivative kernel is not normalized
+  Convolve(this->_input,  this->_output, 0, gaussianX, 1, this->_Sigma/xsize, this->_Recursive, pad, padding);
+  Convolve(this->_output, this->_output, 1, gaussianY, 0, this->_Sigma/ysize, this->_Recursive, pad, padding);
+  if (this->_output->GetZ() != 1) {
+    Convolve(this->_output, this->_output, 2, gaussianZ, 0, this->_Sigma/zsize, this->_Recursive, pad, padding);
   }
 
-  // Flip image back, first x and z axis, then x and y axis
-  this->_output->FlipXZ(1);
-  this->_output->FlipXY(1);
-
   // Do the final cleaning up
-  delete convolution;
   this->Finalize();
-
 }
 
 template <class VoxelType> void irtkConvolutionWithGaussianDerivative<VoxelType>::Iy()
@@ -131,83 +122,24 @@ template <class VoxelType> void irtkConvolutionWithGaussianDerivative<VoxelType>
   // Get voxel dimensions
   this->_input->GetPixelSize(&xsize, &ysize, &zsize);
 
-  // Instantiate convolution filter
-  irtkConvolution_1D<VoxelType> *convolution = NULL;
-  if (this->_input->HasBackgroundValue()) {
-    convolution = new irtkConvolutionWithPadding_1D<VoxelType>(this->_input->GetBackgroundValueAsDouble());
-  } else {
-    convolution = new irtkConvolution_1D<VoxelType>();
-  }
-
-  // Create scalar function which corresponds to a 1D Gaussian function in X
-  irtkScalarGaussian gaussianX(this->_Sigma/xsize, 1, 1, 0, 0, 0);
-  // Create filter kernel for 1D Gaussian function in X
-  irtkGenericImage<irtkRealPixel> kernelX(2*round(4*this->_Sigma/xsize)+1, 1, 1);
-
-  // Do conversion from  scalar function to filter kernel
-  irtkScalarFunctionToImage<irtkRealPixel> gaussianSourceX;
-  gaussianSourceX.SetInput (&gaussianX);
-  gaussianSourceX.SetOutput(&kernelX);
-  gaussianSourceX.Run();
-
-  // Do convolution
-  convolution->SetInput ( this->_input);
-  convolution->SetInput2(&kernelX);
-  convolution->SetOutput(this->_output);
-  convolution->SetNormalization(true);
-  convolution->irtkImageToImage<VoxelType>::Run();
-
-  // Flip x and y axis of image
-  this->_output->FlipXY(1);
-
-  // Create scalar function which corresponds to a 1D Gaussian function in Y
-  irtkScalarGaussianDx gaussianDy(this->_Sigma/ysize, 1, 1, 0, 0, 0);
-
-  // Create filter kernel for 1D Gaussian function in Y
-  irtkGenericImage<irtkRealPixel> kernelY(2*round(4*this->_Sigma/ysize)+1, 1, 1);
-
-  // Do conversion from  scalar function to filter kernel
-  irtkScalarFunctionToImage<irtkRealPixel> gaussianSourceY;
-  gaussianSourceY.SetInput (&gaussianDy);
-  gaussianSourceY.SetOutput(&kernelY);
-  gaussianSourceY.Run();
-
-  // Do convolution
-  convolution->SetInput (this->_output);
-  convolution->SetInput2(&kernelY);
-  convolution->SetOutput(this->_output);
-  convolution->irtkImageToImage<VoxelType>::Run();
-
-  // Flip x and z axis of image
-  this->_output->FlipXZ(1);
-
-  if (this->_output->GetX() != 1) {
-    // Create scalar function which corresponds to a 1D Gaussian function in Z
-    irtkScalarGaussian gaussianZ(this->_Sigma/zsize, 1, 1, 0, 0, 0);
-
-    // Create filter kernel for 1D Gaussian function in Z
-    irtkGenericImage<irtkRealPixel> kernelZ(2*round(4*this->_Sigma/zsize)+1, 1, 1);
-
-    // Do conversion from  scalar function to filter kernel
-    irtkScalarFunctionToImage<irtkRealPixel> gaussianSourceZ;
-    gaussianSourceZ.SetInput (&gaussianZ);
-    gaussianSourceZ.SetOutput(&kernelZ);
-    gaussianSourceZ.Run();
-
-    // Do convolution
-    convolution->SetInput (this->_output);
-    convolution->SetInput2(&kernelZ);
-    convolution->SetOutput(this->_output);
-    convolution->SetNormalization(true);
-    convolution->irtkImageToImage<VoxelType>::Run();
+  // Ignore background if any
+  const bool   pad     = this->_input->HasBackgroundValue();
+  const double padding = this->_input->GetBackgroundValueAsDouble();
+
+  // Create scalar functions which correspond to 1D Gaussian functions and
+  // the derivative of the 1D Gaussian function in y
+  irtkScalarGaussian   gaussianX(this->_Sigma/xsize, 1, 1, 0, 0, 0);
+  irtkScalarGaussianDx gaussianY(this->_Sigma/ysize, 1, 1, 0, 0, 0);
+  irtkScalarGaussian   gaussianZ(this->_Sigma/zsize, 1, 1, 0, 0, 0);
+
+  // Do convolution, where the derivative kernel is not normalized
+  Convolve(this->_input,  this->_output, 0, gaussianX, 0, this->_Sigma/xsize, this->_Recursive, pad, padding);
+  Convolve(this->_output, this->_output, 1, gaussianY, 1, this->_Sigma/ysize, this->_Recursive, pad, padding);
+  if (this->_output->GetZ() != 1) {
+    Convolve(this->_output, this->_output, 2, gaussianZ, 0, this->_Sigma/zsize, this->_Recursive, pad, padding);
   }
 
-  // Flip image back, first x and z axis, then x and y axis
-  this->_output->FlipXZ(1);
-  this->_output->FlipXY(1);
-
   // Do the final cleaning up
-  delete convolution;
   this->Finalize();
 }
 
@@ -221,83 +153,24 @@ template <class VoxelType> void irtkConvolutionWithGaussianDerivative<VoxelType>
   // Get voxel dimensions
   this->_input->GetPixelSize(&xsize, &ysize, &zsize);
 
-  // Instantiate convolution filter
-  irtkConvolution_1D<VoxelType> *convolution = NULL;
-  if (this->_input->HasBackgroundValue()) {
-    convolution = new irtkConvolutionWithPadding_1D<VoxelType>(this->_input->GetBackgroundValueAsDouble());
-  } else {
-    convolution = new irtkConvolution_1D<VoxelType>();
-  }
-
-  // Create scalar function which corresponds to a 1D Gaussian function in X
-  irtkScalarGaussian gaussianX(this->_Sigma/xsize, 1, 1, 0, 0, 0);
-  // Create filter kernel for 1D Gaussian function in X
-  irtkGenericImage<irtkRealPixel> kernelX(2*round(4*this->_Sigma/xsize)+1, 1, 1);
-
-  // Do conversion from  scalar function to filter kernel
-  irtkScalarFunctionToImage<irtkRealPixel> gaussianSourceX;
-  gaussianSourceX.SetInput (&gaussianX);
-  gaussianSourceX.SetOutput(&kernelX);
-  gaussianSourceX.Run();
-
-  // Do convolution
-  convolution->SetInput ( this->_input);
-  convolution->SetInput2(&kernelX);
-  convolution->SetOutput(this->_output);
-  convolution->SetNormalization(true);
-  convolution->irtkImageToImage<VoxelType>::Run();
-
-  // Flip x and y axis of image
-  this->_output->FlipXY(1);
-
-  // Create scalar function which corresponds to a 1D Gaussian function in Y
-  irtkScalarGaussian gaussianY(this->_Sigma/ysize, 1, 1, 0, 0, 0);
-
-  // Create filter kernel for 1D Gaussian function in Y
-  irtkGenericImage<irtkRealPixel> kernelY(2*round(4*this->_Sigma/ysize)+1, 1, 1);
-
-  // Do conversion from  scalar function to filter kernel
-  irtkScalarFunctionToImage<irtkRealPixel> gaussianSourceY;
-  gaussianSourceY.SetInput (&gaussianY);
-  gaussianSourceY.SetOutput(&kernelY);
-  gaussianSourceY.Run();
-
-  // Do convolution
-  convolution->SetInput (this->_output);
-  convolution->SetInput2(&kernelY);
-  convolution->SetOutput(this->_output);
-  convolution->SetNormalization(true);
-  convolution->irtkImageToImage<VoxelType>::Run();
-
-  // Flip x and z axis of image
-  this->_output->FlipXZ(1);
-
-  if (this->_output->GetX() != 1) {
-    // Create scalar function which corresponds to a 1D Gaussian function in Z
-    irtkScalarGaussianDx gaussianDz(this->_Sigma/zsize, 1, 1, 0, 0, 0);
-
-    // Create filter kernel for 1D Gaussian function in Z
-    irtkGenericImage<irtkRealPixel> kernelZ(2*round(4*this->_Sigma/zsize)+1, 1, 1);
-
-    // Do conversion from  scalar function to filter kernel
-    irtkScalarFunctionToImage<irtkRealPixel> gaussianSourceZ;
-    gaussianSourceZ.SetInput (&gaussianDz);
-    gaussianSourceZ.SetOutput(&kernelZ);
-    gaussianSourceZ.Run();
-
-    // Do convolution
-    convolution->SetInput (this->_output);
-    convolution->SetInput2(&kernelZ);
-    convolution->SetOutput(this->_output);
-    convolution->irtkImageToImage<VoxelType>::Run();
+  // Ignore background if any
+  const bool   pad     = this->_input->HasBackgroundValue();
+  const double padding = this->_input->GetBackgroundValueAsDouble();
+
+  // Create scalar functions which correspond to 1D Gaussian functions and
+  // the derivative of the 1D Gaussian function in z
+  irtkScalarGaussian   gaussianX(this->_Sigma/xsize, 1, 1, 0, 0, 0);
+  irtkScalarGaussian   gaussianY(this->_Sigma/ysize, 1, 1, 0, 0, 0);
+  irtkScalarGaussianDx gaussianZ(this->_Sigma/zsize, 1, 1, 0, 0, 0);
+
+  // Do convolution, where the derivative kernel is not normalized
+  Convolve(this->_input,  this->_output, 0, gaussianX, 0, this->_Sigma/xsize, this->_Recursive, pad, padding);
+  Convolve(this->_output, this->_output, 1, gaussianY, 0, this->_Sigma/ysize, this->_Recursive, pad, padding);
+  if (this->_output->GetZ() != 1) {
+    Convolve(this->_output, this->_output, 2, gaussianZ, 1, this->_Sigma/zsize, this->_Recursive, pad, padding);
   }
 
-  // Flip image back, first x and z axis, then x and y axis
-  this->_output->FlipXZ(1);
-  this->_output->FlipXY(1);
-
   // Do the final cleaning up
-  delete convolution;
   this->Finalize();
 }
 
@@ -16,23 +16,65 @@
 
 #include <irtkImage.h>
 
-#include <irtkConvolution.h>
+#include <irtkSeparableConvolution.h>
 #include <irtkScalarFunctionToImage.h>
 #include <irtkScalarGaussianDx.h>
-#include <irtkScalarGaussianDy.h>
-#include <irtkScalarGaussianDz.h>
 #include <irtkScalarGaussianDxDx.h>
-#include <irtkScalarGaussianDyDy.h>
-#include <irtkScalarGaussianDzDz.h>
-#include <irtkScalarGaussianDxDz.h>
-#include <irtkScalarGaussianDyDz.h>
-#include <irtkScalarGaussianDxDy.h>
 
 #include <irtkConvolutionWithGaussianDerivative2.h>
 
+// =============================================================================
+// Auxiliary functions
+// =============================================================================
+
+namespace irtkConvolutionWithGaussianDerivative2Utils {
+
+
+// -----------------------------------------------------------------------------
+/// Convolve image along given dimension with 1D kernel sampled from function,
+/// where the kernel is applied without flipping it as by irtkConvolution_1D
+///
+/// Only the Gaussian kernel of derivative order 0 is normalized. If requested,
+/// a recursive filter is used instead of the kernel, which is scaled such that
+/// its response to x^order / order! equals the one of the kernel.
+template <class VoxelType>
+void Convolve(const irtkGenericImage<VoxelType> *input, irtkGenericImage<VoxelType> *output, int dim,
+              irtkScalarFunction &function, int order, double sigma, bool recursive)
+{
+  // Create filter kernel
+  irtkGenericImage<irtkRealPixel> kernel(2*round(4*sigma)+1, 1, 1);
+  irtkScalarFunctionToImage<irtkRealPixel> source;
+  source.SetInput (&function);
+  source.SetOutput(&kernel);
+  source.Run();
+
+  // Convolve image lines
+  irtkSeparableConvolution conv(irtkSeparableConvolution::TruncateKernel, order == 0);
+  const int n = kernel.X();
+  if (recursive && sigma >= 1.0) {
+    double moment = (order == 0 ? 1.0 : .0);
+    for (int i = 0; order > 0 && i < n; ++i) {
+      moment += kernel(i, 0, 0) * pow(static_cast<double>(i - n / 2), order);
+    }
+    if (order == 2) moment /= 2.0;
+    conv.RecursiveGaussian(sigma, order);
+    conv.Scale(moment);
+  } else {
+    vector<irtkRealPixel> weights(n);
+    for (int i = 0; i < n; ++i) weights[i] = kernel(n - 1 - i, 0, 0);
+    conv.Kernel(&weights[0], n);
+  }
+  conv.Run(input, dim, output);
+}
+
+
+} // namespace irtkConvolutionWithGaussianDerivative2Utils
+using namespace irtkConvolutionWithGaussianDerivative2Utils;
+
 template <class VoxelType> irtkConvolutionWithGaussianDerivative2<VoxelType>::irtkConvolutionWithGaussianDerivative2(double Sigma)
 {
-  _Sigma = Sigma;
+  _Sigma     = Sigma;
+  _Recursive = false;
 }
 
 template <class VoxelType> irtkConvolutionWithGaussianDerivative2<VoxelType>::~irtkConvolutionWithGaussianDerivative2()
@@ -40,87 +82,29 @@ template <class VoxelType> irtkConvolutionWithGaussianDerivative2<VoxelType>::~i
 
 template <class VoxelType> void irtkConvolutionWithGaussianDerivative2<VoxelType>::Ixx()
 {
-
   double xsize, ysize, zsize;
 
-
   // Do the initial set up
   this->Initialize();
 
   // Get voxel dimensions
   this->_input->GetPixelSize(&xsize, &ysize, &zsize);
 
-  // Create scalar function which corresponds to a 1D Gaussian function in X
-  irtkScalarGaussianDxDx gaussianDxDx(this->_Sigma/xsize, 1, 1, 0, 0, 0);
-  // Create filter kernel for 1D Gaussian function in X
-  irtkGenericImage<irtkRealPixel> kernelX(2*round(4*this->_Sigma/xsize)+1, 1, 1);
-  // Do conversion from  scalar function to filter kernel
-  irtkScalarFunctionToImage<irtkRealPixel> gaussianSourceX;
-  gaussianSourceX.SetInput (&gaussianDxDx);
-  gaussianSourceX.SetOutput(&kernelX);
-  gaussianSourceX.Run();
-
-  // Do convolution
-  irtkConvolution_1D<VoxelType> convolutionX;
-  convolutionX.SetInput ( this->_input);
-  convolutionX.SetInput2(&kernelX);
-  convolutionX.SetOutput(this->_output);
-  convolutionX.irtkImageToImage<VoxelType>::Run();
-
-  // Flip x and y axis of image
-  this->_output->FlipXY(1);
-
-  // Create scalar function which corresponds to a 1D Gaussian function in Y
-  irtkScalarGaussian gaussianY(this->_Sigma/ysize, 1, 1, 0, 0, 0);
-
-  // Create filter kernel for 1D Gaussian function in Y
-  irtkGenericImage<irtkRealPixel> kernelY(2*round(4*this->_Sigma/ysize)+1, 1, 1);
-
-  // Do conversion from  scalar function to filter kernel
-  irtkScalarFunctionToImage<irtkRealPixel> gaussianSourceY;
-  gaussianSourceY.SetInput (&gaussianY);
-  gaussianSourceY.SetOutput(&kernelY);
-  gaussianSourceY.Run();
-
-  // Do convolution
-  irtkConvolution_1D<VoxelType> convolutionY;
-  convolutionY.SetInput (this->_output);
-  convolutionY.SetInput2(&kernelY);
-  convolutionY.SetOutput(this->_output);
-  convolutionY.SetNormalization(true);
-  convolutionY.irtkImageToImage<VoxelType>::Run();
-  // Flip x and z axis of image
-  this->_output->FlipXZ(1);
-
-  if (this->_output->GetX() != 1) {
-    // Create scalar function which corresponds to a 1D Gaussian function in Z
-    irtkScalarGaussian gaussianZ(this->_Sigma/zsize, 1, 1, 0, 0, 0);
-
-    // Create filter kernel for 1D Gaussian function in Z
-    irtkGenericImage<irtkRealPixel> kernelZ(2*round(4*this->_Sigma/zsize)+1, 1, 1);
-
-    // Do conversion from  scalar function to filter kernel
-    irtkScalarFunctionToImage<irtkRealPixel> gaussianSourceZ;
-    gaussianSourceZ.SetInput (&gaussianZ);
-    gaussianSourceZ.SetOutput(&kernelZ);
-    gaussianSourceZ.Run();
-
-    // Do convolution
-    irtkConvolution_1D<VoxelType> convolutionZ;
-    convolutionZ.SetInput (this->_output);
-    convolutionZ.SetInput2(&kernelZ);
-    convolutionZ.SetOutput(this->_output);
-    convolutionZ.SetNormalization(true);
-    convolutionZ.irtkImageToImage<VoxelType>::Run();
-  }
+  // Create scalar functions which correspond to 1D Gaussian functions and
+  // the 2nd order derivative of the 1D Gaussian function in x
+  irtkScalarGaussianDxDx gaussianX(this->_Sigma/xsize, 1, 1, 0, 0, 0);
+  irtkScalarGaussian     gaussianY(this->_Sigma/ysize, 1, 1, 0, 0, 0);
+  irtkScalarGaussian     gaussianZ(this->_Sigma/zsize, 1, 1, 0, 0, 0);
 
-  // Flip image back, first x and z axis, then x and y axis
-  this->_output->FlipXZ(1);
-  this->_output->FlipXY(1);
+  // Do convolution, where the derivative kernels are not normalized
+  Convolve(this->_input,  this->_output, 0, gaussianX, 2, this->_Sigma/xsize, this->_Recursive);
+  Convolve(this->_output, this->_output, 1, gaussianY, 0, this->_Sigma/ysize, this->_Recursive);
+  if (this->_output->GetZ() != 1) {
+    Convolve(this->_output, this->_output, 2, gaussianZ, 0, this->_Sigma/zsize, this->_Recursive);
+  }
 
   // Do the final cleaning up
   this->Finalize();
-
 }
 
 template <class VoxelType> void irtkConvolutionWithGaussianDerivative2<VoxelType>::Ixy()
@@ -133,78 +117,21 @@ template <class VoxelType> void irtkConvolutionWithGaussianDerivative2<VoxelType
   // Get voxel dimensions
   this->_input->GetPixelSize(&xsize, &ysize, &zsize);
 
-  // Create scalar function which corresponds to a 1D Gaussian function in X
-  irtkScalarGaussianDx gaussianDx(this->_Sigma/xsize, 1, 1, 0, 0, 0);
-  // Create filter kernel for 1D Gaussian function in X
-  irtkGenericImage<irtkRealPixel> kernelX(2*round(4*this->_Sigma/xsize)+1, 1, 1);
-
-  // Do conversion from  scalar function to filter kernel
-  irtkScalarFunctionToImage<irtkRealPixel> gaussianSourceX;
-  gaussianSourceX.SetInput (&gaussianDx);
-  gaussianSourceX.SetOutput(&kernelX);
-  gaussianSourceX.Run();
-
-  // Do convolution
-  irtkConvolution_1D<VoxelType> convolutionX;
-  convolutionX.SetInput ( this->_input);
-  convolutionX.SetInput2(&kernelX);
-  convolutionX.SetOutput(this->_output);
-  convolutionX.irtkImageToImage<VoxelType>::Run();
-
-  // Flip x and y axis of image
-  this->_output->FlipXY(1);
-
-  // Create scalar function which corresponds to a 1D Gaussian function in Y
-  irtkScalarGaussianDx gaussianDy(this->_Sigma/ysize, 1, 1, 0, 0, 0);
-
-  // Create filter kernel for 1D Gaussian function in Y
-  irtkGenericImage<irtkRealPixel> kernelY(2*round(4*this->_Sigma/ysize)+1, 1, 1);
-
-  // Do conversion from  scalar function to filter kernel
-  irtkScalarFunctionToImage<irtkRealPixel> gaussianSourceY;
-  gaussianSourceY.SetInput (&gaussianDy);
-  gaussianSourceY.SetOutput(&kernelY);
-  gaussianSourceY.Run();
-
-  // Do convolution
-  irtkConvolution_1D<VoxelType> convolutionY;
-  convolutionY.SetInput (this->_output);
-  convolutionY.SetInput2(&kernelY);
-  convolutionY.SetOutput(this->_output);
-  convolutionY.irtkImageToImage<VoxelType>::Run();
-
-  // Flip x and z axis of image
-  this->_output->FlipXZ(1);
-
-  if (this->_output->GetX() != 1) {
-    // Create scalar function which corresponds to a 1D Gaussian function in Z
-    irtkScalarGaussian gaussianZ(this->_Sigma/zsize, 1, 1, 0, 0, 0);
-
-    // Create filter kernel for 1D Gaussian function in Z
-    irtkGenericImage<irtkRealPixel> kernelZ(2*round(4*this->_Sigma/zsize)+1, 1, 1);
-
-    // Do conversion from  scalar function to filter kernel
-    irtkScalarFunctionToImage<irtkRealPixel> gaussianSourceZ;
-    gaussianSourceZ.SetInput (&gaussianZ);
-    gaussianSourceZ.SetOutput(&kernelZ);
-    gaussianSourceZ.Run();
-
-    // Do convolution
-    irtkConvolution_1D<VoxelType> convolutionZ;
-    convolutionZ.SetInput (this->_output);
-    convolutionZ.SetInput2(&kernelZ);
-    convolutionZ.SetOutput(this->_output);
-    convolutionZ.SetNormalization(true);
-    convolutionZ.irtkImageToImage<VoxelType>::Run();
-  }
+  // Create scalar functions which correspond to 1D Gaussian functions and
+  // the 1st order derivatives of the 1D Gaussian function in x and y
+  irtkScalarGaussianDx   gaussianX(this->_Sigma/xsize, 1, 1, 0, 0, 0);
+  irtkScalarGaussianDx   gaussianY(this->_Sigma/ysize, 1, 1, 0, 0, 0);
+  irtkScalarGaussian     gaussianZ(this->_Sigma/zsize, 1, 1, 0, 0, 0);
 
-  // Flip image back, first x and z axis, then x and y axis
-  this->_output->FlipXZ(1);
-  this->_output->FlipXY(1);
+  // Do convolution, where the derivative kernels are not normalized
+  Convolve(this->_input,  this->_output, 0, gaussianX, 1, this->_Sigma/xsize, this->_Recursive);
+  Convolve(this->_output, this->_output, 1, gaussianY, 1, this->_Sigma/ysize, this->_Recursive);
+  if (this->_output->GetZ() != 1) {
+    Convolve(this->_output, this->_output, 2, gaussianZ, 0, this->_Sigma/zsize, this->_Recursive);
+  }
 
   // Do the final cleaning up
   this->Finalize();
-
 }
 
 template <class VoxelType> void irtkConvolutionWithGaussianDerivative2<VoxelType>::Ixz()
@@ -217,74 +144,18 @@ template <class VoxelType> void irtkConvolutionWithGaussianDerivative2<VoxelType
   // Get voxel dimensions
   this->_input->GetPixelSize(&xsize, &ysize, &zsize);
 
-  // Create scalar function which corresponds to a 1D Gaussian function in X
-  irtkScalarGaussianDx gaussianDx(this->_Sigma/xsize, 1, 1, 0, 0, 0);
-  // Create filter kernel for 1D Gaussian function in X
-  irtkGenericImage<irtkRealPixel> kernelX(2*round(4*this->_Sigma/xsize)+1, 1, 1);
-
-  // Do conversion from  scalar function to filter kernel
-  irtkScalarFunctionToImage<irtkRealPixel> gaussianSourceX;
-  gaussianSourceX.SetInput (&gaussianDx);
-  gaussianSourceX.SetOutput(&kernelX);
-  gaussianSourceX.Run();
-
-  // Do convolution
-  irtkConvolution_1D<VoxelType> convolutionX;
-  convolutionX.SetInput ( this->_input);
-  convolutionX.SetInput2(&kernelX);
-  convolutionX.SetOutput(this->_output);
-  convolutionX.irtkImageToImage<VoxelType>::Run();
-
-  // Flip x and y axis of image
-  this->_output->FlipXY(1);
-
-  // Create scalar function which corresponds to a 1D Gaussian function in Y
-  irtkScalarGaussian gaussianY(this->_Sigma/ysize, 1, 1, 0, 0, 0);
-
-  // Create filter kernel for 1D Gaussian function in Y
-  irtkGenericImage<irtkRealPixel> kernelY(2*round(4*this->_Sigma/ysize)+1, 1, 1);
-
-  // Do conversion from  scalar function to filter kernel
-  irtkScalarFunctionToImage<irtkRealPixel> gaussianSourceY;
-  gaussianSourceY.SetInput (&gaussianY);
-  gaussianSourceY.SetOutput(&kernelY);
-  gaussianSourceY.Run();
-
-  // Do convolution
-  irtkConvolution_1D<VoxelType> convolutionY;
-  convolutionY.SetInput (this->_output);
-  convolutionY.SetInput2(&kernelY);
-  convolutionY.SetOutput(this->_output);
-  convolutionY.SetNormalization(true);
-  convolutionY.irtkImageToImage<VoxelType>::Run();
-
-  // Flip x and z axis of image
-  this->_output->FlipXZ(1);
-
-  if (this->_output->GetX() != 1) {
-    // Create scalar function which corresponds to a 1D Gaussian function in Z
-    irtkScalarGaussianDx gaussianDz(this->_Sigma/zsize, 1, 1, 0, 0, 0);
-
-    // Create filter kernel for 1D Gaussian function in Z
-    irtkGenericImage<irtkRealPixel> kernelZ(2*round(4*this->_Sigma/zsize)+1, 1, 1);
-
-    // Do conversion from  scalar function to filter kernel
-    irtkScalarFunctionToImage<irtkRealPixel> gaussianSourceZ;
-    gaussianSourceZ.SetInput (&gaussianDz);
-    gaussianSourceZ.SetOutput(&kernelZ);
-    gaussianSourceZ.Run();
-
-    // Do convolution
-    irtkConvolution_1D<VoxelType> convolutionZ;
-    convolutionZ.SetInput (this->_output);
-    convolutionZ.SetInput2(&kernelZ);
-    convolutionZ.SetOutput(this->_output);
-    convolutionZ.irtkImageToImage<VoxelType>::Run();
-  }
+  // Create scalar functions which correspond to 1D Gaussian functions and
+  // the 1st order derivatives of the 1D Gaussian function in x and z
+  irtkScalarGaussianDx   gaussianX(this->_Sigma/xsize, 1, 1, 0, 0, 0);
+  irtkScalarGaussian     gaussianY(this->_Sigma/ysize, 1, 1, 0, 0, 0);
+  irtkScalarGaussianDx   gaussianZ(this->_Sigma/zsize, 1, 1, 0, 0, 0);
 
-  // Flip image back, first x and z axis, then x and y axis
-  this->_output->FlipXZ(1);
-  this->_output->FlipXY(1);
+  // Do convolution, where the derivative kernels are not normalized
+  Convolve(this->_input,  this->_output, 0, gaussianX, 1, this->_Sigma/xsize, this->_Recursive);
+  Convolve(this->_output, this->_output, 1, gaussianY, 0, this->_Sigma/ysize, this->_Recursive);
+  if (this->_output->GetZ() != 1) {
+    Convolve(this->_output, this->_output, 2, gaussianZ, 1, this->_Sigma/zsize, this->_Recursive);
+  }
 
   // Do the final cleaning up
   this->Finalize();
@@ -300,75 +171,18 @@ template <class VoxelType> void irtkConvolutionWithGaussianDerivative2<VoxelType
   // Get voxel dimensions
   this->_input->GetPixelSize(&xsize, &ysize, &zsize);
 
-  // Create scalar function which corresponds to a 1D Gaussian function in X
-  irtkScalarGaussian gaussianX(this->_Sigma/xsize, 1, 1, 0, 0, 0);
-  // Create filter kernel for 1D Gaussian function in X
-  irtkGenericImage<irtkRealPixel> kernelX(2*round(4*this->_Sigma/xsize)+1, 1, 1);
-
-  // Do conversion from  scalar function to filter kernel
-  irtkScalarFunctionToImage<irtkRealPixel> gaussianSourceX;
-  gaussianSourceX.SetInput (&gaussianX);
-  gaussianSourceX.SetOutput(&kernelX);
-  gaussianSourceX.Run();
-
-  // Do convolution
-  irtkConvolution_1D<VoxelType> convolutionX;
-  convolutionX.SetInput ( this->_input);
-  convolutionX.SetInput2(&kernelX);
-  convolutionX.SetOutput(this->_output);
-  convolutionX.SetNormalization(true);
-  convolutionX.irtkImageToImage<VoxelType>::Run();
-
-  // Flip x and y axis of image
-  this->_output->FlipXY(1);
-
-  // Create scalar function which corresponds to a 1D Gaussian function in Y
-  irtkScalarGaussianDxDx gaussianDyDy(this->_Sigma/ysize, 1, 1, 0, 0, 0);
-
-  // Create filter kernel for 1D Gaussian function in Y
-  irtkGenericImage<irtkRealPixel> kernelY(2*round(4*this->_Sigma/ysize)+1, 1, 1);
-
-  // Do conversion from  scalar function to filter kernel
-  irtkScalarFunctionToImage<irtkRealPixel> gaussianSourceY;
-  gaussianSourceY.SetInput (&gaussianDyDy);
-  gaussianSourceY.SetOutput(&kernelY);
-  gaussianSourceY.Run();
-
-  // Do convolution
-  irtkConvolution_1D<VoxelType> convolutionY;
-  convolutionY.SetInput (this->_output);
-  convolutionY.SetInput2(&kernelY);
-  convolutionY.SetOutput(this->_output);
-  convolutionY.irtkImageToImage<VoxelType>::Run();
-
-  // Flip x and z axis of image
-  this->_output->FlipXZ(1);
-
-  if (this->_output->GetX() != 1) {
-    // Create scalar function which corresponds to a 1D Gaussian function in Z
-    irtkScalarGaussian gaussianZ(this->_Sigma/zsize, 1, 1, 0, 0, 0);
-
-    // Create filter kernel for 1D Gaussian function in Z
-    irtkGenericImage<irtkRealPixel> kernelZ(2*round(4*this->_Sigma/zsize)+1, 1, 1);
-
-    // Do conversion from  scalar function to filter kernel
-    irtkScalarFunctionToImage<irtkRealPixel> gaussianSourceZ;
-    gaussianSourceZ.SetInput (&gaussianZ);
-    gaussianSourceZ.SetOutput(&kernelZ);
-    gaussianSourceZ.Run();
-
-    // Do convolution
-    irtkConvolution_1D<VoxelType> convolutionZ;
-    convolutionZ.SetInput (this->_output);
-    convolutionZ.SetInput2(&kernelZ);
-    convolutionZ.SetOutput(this->_output);
-    convolutionZ.SetNormalization(true);
-    convolutionZ.irtkImageToImage<VoxelType>::Run();
-  }
+  // Create scalar functions which correspond to 1D Gaussian functions and
+  // the 2nd order derivative of the 1D Gaussian function in y
+  irtkScalarGaussian     gaussianX(this->_Sigma/xsize, 1, 1, 0, 0, 0);
+  irtkScalarGaussianDxDx gaussianY(this->_Sigma/ysize, 1, 1, 0, 0, 0);
+  irtkScalarGaussian     gaussianZ(this->_Sigma/zsize, 1, 1, 0, 0, 0);
 
-  // Flip image back, first x and z axis, then x and y axis
-  this->_output->FlipXZ(1);
-  this->_output->FlipXY(1);
+  // Do convolution, where the derivative kernels are not normalized
+  Convolve(this->_input,  this->_output, 0, gaussianX, 0, this->_Sigma/xsize, this->_Recursive);
+  Convolve(this->_output, this->_output, 1, gaussianY, 2, this->_Sigma/ysize, this->_Recursive);
+  if (this->_output->GetZ() != 1) {
+    Convolve(this->_output, this->_output, 2, gaussianZ, 0, this->_Sigma/zsize, this->_Recursive);
+  }
 
   // Do the final cleaning up
   this->Finalize();
@@ -384,76 +198,19 @@ template <class VoxelType> void irtkConvolutionWithGaussianDerivative2<VoxelType
   // Get voxel dimensions
   this->_input->GetPixelSize(&xsize, &ysize, &zsize);
 
-  // Create scalar function which corresponds to a 1D Gaussian function in X
-  irtkScalarGaussian gaussianX(this->_Sigma/xsize, 1, 1, 0, 0, 0);
-  
-  // Create filter kernel for 1D Gaussian function in X
-  irtkGenericImage<irtkRealPixel> kernelX(2*round(4*this->_Sigma/xsize)+1, 1, 1);
-
-  // Do conversion from  scalar function to filter kernel
-  irtkScalarFunctionToImage<irtkRealPixel> gaussianSourceX;
-  gaussianSourceX.SetInput (&gaussianX);
-  gaussianSourceX.SetOutput(&kernelX);
-  gaussianSourceX.Run();
-
-  // Do convolution
-  irtkConvolution_1D<VoxelType> convolutionX;
-  convolutionX.SetInput ( this->_input);
-  convolutionX.SetInput2(&kernelX);
-  convolutionX.SetOutput(this->_output);
-  convolutionX.SetNormalization(true);
-  convolutionX.irtkImageToImage<VoxelType>::Run();
-
-  // Flip x and y axis of image
-  this->_output->FlipXY(1);
-
-  // Create scalar function which corresponds to a 1D Gaussian function in Y
-  irtkScalarGaussianDx gaussianDy(this->_Sigma/ysize, 1, 1, 0, 0, 0);
-
-  // Create filter kernel for 1D Gaussian function in Y
-  irtkGenericImage<irtkRealPixel> kernelY(2*round(4*this->_Sigma/ysize)+1, 1, 1);
-
-  // Do conversion from  scalar function to filter kernel
-  irtkScalarFunctionToImage<irtkRealPixel> gaussianSourceY;
-  gaussianSourceY.SetInput (&gaussianDy);
-  gaussianSourceY.SetOutput(&kernelY);
-  gaussianSourceY.Run();
-
-  // Do convolution
-  irtkConvolution_1D<VoxelType> convolutionY;
-  convolutionY.SetInput (this->_output);
-  convolutionY.SetInput2(&kernelY);
-  convolutionY.SetOutput(this->_output);
-  convolutionY.irtkImageToImage<VoxelType>::Run();
-
-  // Flip x and z axis of image
-  this->_output->FlipXZ(1);
+  // Create scalar functions which correspond to 1D Gaussian functions and
+  // the 1st order derivatives of the 1D Gaussian function in y and z
+  irtkScalarGaussian     gaussianX(this->_Sigma/xsize, 1, 1, 0, 0, 0);
+  irtkScalarGaussianDx   gaussianY(this->_Sigma/ysize, 1, 1, 0, 0, 0);
+  irtkScalarGaussianDx   gaussianZ(this->_Sigma/zsize, 1, 1, 0, 0, 0);
 
+  // Do convolution, where the derivative kernels are not normalized
+  Convolve(this->_input,  this->_output, 0, gaussianX, 0, this->_Sigma/xsize, this->_Recursive);
+  Convolve(this->_output, this->_output, 1, gaussianY, 1, this->_Sigma/ysize, this->_Recursive);
   if (this->_output->GetZ() != 1) {
-    // Create scalar function which corresponds to a 1D Gaussian function in Z
-    irtkScalarGaussianDx gaussianDz(this->_Sigma/zsize, 1, 1, 0, 0, 0);
-
-    // Create filter kernel for 1D Gaussian function in Z
-    irtkGenericImage<irtkRealPixel> kernelZ(2*round(4*this->_Sigma/zsize)+1, 1, 1);
-
-    // Do conversion from  scalar function to filter kernel
-    irtkScalarFunctionToImage<irtkRealPixel> gaussianSourceZ;
-    gaussianSourceZ.SetInput (&gaussianDz);
-    gaussianSourceZ.SetOutput(&kernelZ);
-    gaussianSourceZ.Run();
-
-    // Do convolution
-    irtkConvolution_1D<VoxelType> convolutionZ;
-    convolutionZ.SetInput (this->_output);
-    convolutionZ.SetInput2(&kernelZ);
-    convolutionZ.SetOutput(this->_output);
-    convolutionZ.irtkImageToImage<VoxelType>::Run();
+    Convolve(this->_output, this->_output, 2, gaussianZ, 1, this->_Sigma/zsize, this->_Recursive);
   }
 
-  // Flip image back, first x and z axis, then x and y axis
-  this->_output->FlipXZ(1);
-  this->_output->FlipXY(1);
-
   // Do the final cleaning up
   this->Finalize();
 }
@@ -468,82 +225,23 @@ template <class VoxelType> void irtkConvolutionWithGaussianDerivative2<VoxelType
   // Get voxel dimensions
   this->_input->GetPixelSize(&xsize, &ysize, &zsize);
 
-  // Create scalar function which corresponds to a 1D Gaussian function in X
-  irtkScalarGaussian gaussianX(this->_Sigma/xsize, 1, 1, 0, 0, 0);
-  
-  // Create filter kernel for 1D Gaussian function in X
-  irtkGenericImage<irtkRealPixel> kernelX(2*round(4*this->_Sigma/xsize)+1, 1, 1);
-
-  // Do conversion from  scalar function to filter kernel
-  irtkScalarFunctionToImage<irtkRealPixel> gaussianSourceX;
-  gaussianSourceX.SetInput (&gaussianX);
-  gaussianSourceX.SetOutput(&kernelX);
-  gaussianSourceX.Run();
-
-  // Do convolution
-  irtkConvolution_1D<VoxelType> convolutionX;
-  convolutionX.SetInput ( this->_input);
-  convolutionX.SetInput2(&kernelX);
-  convolutionX.SetOutput(this->_output);
-  convolutionX.SetNormalization(true);
-  convolutionX.irtkImageToImage<VoxelType>::Run();
-
-  // Flip x and y axis of image
-  this->_output->FlipXY(1);
-
-  // Create scalar function which corresponds to a 1D Gaussian function in Y
-  irtkScalarGaussian gaussianY(this->_Sigma/ysize, 1, 1, 0, 0, 0);
-
-  // Create filter kernel for 1D Gaussian function in Y
-  irtkGenericImage<irtkRealPixel> kernelY(2*round(4*this->_Sigma/ysize)+1, 1, 1);
-
-  // Do conversion from  scalar function to filter kernel
-  irtkScalarFunctionToImage<irtkRealPixel> gaussianSourceY;
-  gaussianSourceY.SetInput (&gaussianY);
-  gaussianSourceY.SetOutput(&kernelY);
-  gaussianSourceY.Run();
-
-  // Do convolution
-  irtkConvolution_1D<VoxelType> convolutionY;
-  convolutionY.SetInput (this->_output);
-  convolutionY.SetInput2(&kernelY);
-  convolutionY.SetOutput(this->_output);
-  convolutionY.SetNormalization(true);
-  convolutionY.irtkImageToImage<VoxelType>::Run();
-
-  // Flip x and z axis of image
-  this->_output->FlipXZ(1);
-
-  if (this->_output->GetX() != 1) {
-    // Create scalar function which corresponds to a 1D Gaussian function in Z
-    irtkScalarGaussianDxDx gaussianDzDz(this->_Sigma/zsize, 1, 1, 0, 0, 0);
-
-    // Create filter kernel for 1D Gaussian function in Z
-    irtkGenericImage<irtkRealPixel> kernelZ(2*round(4*this->_Sigma/zsize)+1, 1, 1);
-
-    // Do conversion from  scalar function to filter kernel
-    irtkScalarFunctionToImage<irtkRealPixel> gaussianSourceZ;
-    gaussianSourceZ.SetInput (&gaussianDzDz);
-    gaussianSourceZ.SetOutput(&kernelZ);
-    gaussianSourceZ.Run();
-
-    // Do convolution
-    irtkConvolution_1D<VoxelType> convolutionZ;
-    convolutionZ.SetInput (this->_output);
-    convolutionZ.SetInput2(&kernelZ);
-    convolutionZ.SetOutput(this->_output);
-    convolutionZ.irtkImageToImage<VoxelType>::Run();
-  }
+  // Create scalar functions which correspond to 1D Gaussian functions and
+  // the 2nd order derivative of the 1D Gaussian function in z
+  irtkScalarGaussian     gaussianX(this->_Sigma/xsize, 1, 1, 0, 0, 0);
+  irtkScalarGaussian     gaussianY(this->_Sigma/ysize, 1, 1, 0, 0, 0);
+  irtkScalarGaussianDxDx gaussianZ(this->_Sigma/zsize, 1, 1, 0, 0, 0);
 
-  // Flip image back, first x and z axis, then x and y axis
-  this->_output->FlipXZ(1);
-  this->_output->FlipXY(1);
+  // Do convolution, where the derivative kernels are not normalized
+  Convolve(this->_input,  this->_output, 0, gaussianX, 0, this->_Sigma/xsize, this->_Recursive);
+  Convolve(this->_output, this->_output, 1, gaussianY, 0, this->_Sigma/ysize, this->_Recursive);
+  if (this->_output->GetZ() != 1) {
+    Convolve(this->_output, this->_output, 2, gaussianZ, 2, this->_Sigma/zsize, this->_Recursive);
+  }
 
   // Do the final cleaning up
   this->Finalize();
 }
 
-
 template class irtkConvolutionWithGaussianDerivative2<irtkBytePixel>;
 template class irtkConvolutionWithGaussianDerivative2<irtkGreyPixel>;
 template class irtkConvolutionWithGaussianDerivative2<float>;
@@ -17,6 +17,7 @@
 #include <irtkImage.h>
 
 #include <irtkConvolution.h>
+#include <irtkSeparableConvolution.h>
 
 template <class VoxelType> irtkConvolutionWithPadding_1D<VoxelType>::irtkConvolutionWithPadding_1D(VoxelType padding,
     bool Normalization) : irtkConvolution_1D<VoxelType>(Normalization)
@@ -117,6 +118,18 @@ template <class VoxelType> double irtkConvolutionWithPadding_1D<VoxelType>::Run(
   }
 }
 
+template <class VoxelType> void irtkConvolutionWithPadding_1D<VoxelType>::Run()
+{
+  IRTK_START_TIMING();
+  this->Initialize();
+  irtkSeparableConvolution conv(irtkSeparableConvolution::IgnoreBackground, this->_Normalization);
+  conv.Background(_padding);
+  this->InitializeConvolution(conv);
+  conv.Run(this->_input, 0, this->_output);
+  this->Finalize();
+  IRTK_DEBUG_TIMING(5, "irtkConvolutionWithPadding1D");
+}
+
 template class irtkConvolutionWithPadding_1D<unsigned char>;
 template class irtkConvolutionWithPadding_1D<short>;
 template class irtkConvolutionWithPadding_1D<unsigned short>;
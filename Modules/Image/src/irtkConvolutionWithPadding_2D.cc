@@ -17,6 +17,9 @@
 #include <irtkImage.h>
 
 #include <irtkConvolution.h>
+#include <irtkSeparableConvolution.h>
+
+using namespace irtkSeparableConvolutionUtils;
 
 template <class VoxelType> irtkConvolutionWithPadding_2D<VoxelType>::irtkConvolutionWithPadding_2D(VoxelType padding,
     bool Normalization) : irtkConvolution_2D<VoxelType>(Normalization)
@@ -126,6 +129,25 @@ template <class VoxelType> double irtkConvolutionWithPadding_2D<VoxelType>::Run(
   }
 }
 
+template <class VoxelType> void irtkConvolutionWithPadding_2D<VoxelType>::Run()
+{
+  // Evaluate convolution sum for each voxel if kernel is not separable
+  vector<double> factor[3];
+  if (this->_input2 == NULL || !FactorizeKernel(this->_input2, factor)) {
+    irtkConvolution<VoxelType>::Run();
+    return;
+  }
+
+  // Do the initial set up
+  this->Initialize();
+
+  // Perform successive 1D convolutions
+  ConvolveWithSeparableKernel(this->_input, factor, this->_output, 2, this->_Normalization, true, _padding);
+
+  // Do the final cleaning up
+  this->Finalize();
+}
+
 template class irtkConvolutionWithPadding_2D<unsigned char>;
 template class irtkConvolutionWithPadding_2D<short>;
 template class irtkConvolutionWithPadding_2D<unsigned short>;
@@ -17,6 +17,9 @@
 #include <irtkImage.h>
 
 #include <irtkConvolution.h>
+#include <irtkSeparableConvolution.h>
+
+using namespace irtkSeparableConvolutionUtils;
 
 template <class VoxelType> irtkConvolutionWithPadding_3D<VoxelType>::irtkConvolutionWithPadding_3D(VoxelType padding,
     bool Normalization) : irtkConvolution_3D<VoxelType>(Normalization)
@@ -142,6 +145,25 @@ template <class VoxelType> double irtkConvolutionWithPadding_3D<VoxelType>::Run(
   }
 }
 
+template <class VoxelType> void irtkConvolutionWithPadding_3D<VoxelType>::Run()
+{
+  // Evaluate convolution sum for each voxel if kernel is not separable
+  vector<double> factor[3];
+  if (this->_input2 == NULL || !FactorizeKernel(this->_input2, factor)) {
+    irtkConvolution<VoxelType>::Run();
+    return;
+  }
+
+  // Do the initial set up
+  this->Initialize();
+
+  // Perform successive 1D convolutions
+  ConvolveWithSeparableKernel(this->_input, factor, this->_output, 3, this->_Normalization, true, _padding);
+
+  // Do the final cleaning up
+  this->Finalize();
+}
+
 template class irtkConvolutionWithPadding_3D<unsigned char>;
 template class irtkConvolutionWithPadding_3D<short>;
 template class irtkConvolutionWithPadding_3D<unsigned short>;
@@ -17,6 +17,7 @@
 #include <irtkImage.h>
 
 #include <irtkConvolution.h>
+#include <irtkSeparableConvolution.h>
 
 
 #ifdef USE_CUDA
@@ -154,11 +155,24 @@ template <class VoxelType> void irtkConvolution_1D<VoxelType>::Run()
 #endif
   {
     IRTK_START_TIMING();
-    irtkConvolution<VoxelType>::Run();
+    this->Initialize();
+    irtkSeparableConvolution conv(irtkSeparableConvolution::TruncateKernel, this->_Normalization);
+    this->InitializeConvolution(conv);
+    conv.Run(this->_input, 0, this->_output);
+    this->Finalize();
     IRTK_DEBUG_TIMING(5, "irtkConvolution1D");
   }
 }
 
+template <class VoxelType> void irtkConvolution_1D<VoxelType>::InitializeConvolution(irtkSeparableConvolution &conv) const
+{
+  // Kernel is applied without flipping it (cf. Run(int, int, int, int))
+  const int n = this->_input2->GetX();
+  vector<irtkRealPixel> kernel(n);
+  for (int i = 0; i < n; ++i) kernel[i] = this->_input2->Get(n - 1 - i, 0, 0);
+  conv.Kernel(&kernel[0], n);
+}
+
 template class irtkConvolution_1D<unsigned char>;
 template class irtkConvolution_1D<short>;
 template class irtkConvolution_1D<unsigned short>;
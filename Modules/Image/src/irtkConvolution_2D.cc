@@ -17,6 +17,9 @@
 #include <irtkImage.h>
 
 #include <irtkConvolution.h>
+#include <irtkSeparableConvolution.h>
+
+using namespace irtkSeparableConvolutionUtils;
 
 
 template <class VoxelType> irtkConvolution_2D<VoxelType>::irtkConvolution_2D(bool Normalization) :
@@ -132,6 +135,25 @@ template <class VoxelType> void irtkConvolution_2D<VoxelType>::Initialize()
   this->irtkImageToImage<VoxelType>::Initialize();
 }
 
+template <class VoxelType> void irtkConvolution_2D<VoxelType>::Run()
+{
+  // Evaluate convolution sum for each voxel if kernel is not separable
+  vector<double> factor[3];
+  if (this->_input2 == NULL || !FactorizeKernel(this->_input2, factor)) {
+    irtkConvolution<VoxelType>::Run();
+    return;
+  }
+
+  // Do the initial set up
+  this->Initialize();
+
+  // Perform successive 1D convolutions
+  ConvolveWithSeparableKernel(this->_input, factor, this->_output, 2, this->_Normalization);
+
+  // Do the final cleaning up
+  this->Finalize();
+}
+
 template class irtkConvolution_2D<unsigned char>;
 template class irtkConvolution_2D<short>;
 template class irtkConvolution_2D<unsigned short>;
@@ -17,6 +17,9 @@
 #include <irtkImage.h>
 
 #include <irtkConvolution.h>
+#include <irtkSeparableConvolution.h>
+
+using namespace irtkSeparableConvolutionUtils;
 
 template <class VoxelType> irtkConvolution_3D<VoxelType>::irtkConvolution_3D(bool Normalization) :
     irtkConvolution<VoxelType>(Normalization)
@@ -141,6 +144,25 @@ template <class VoxelType> void irtkConvolution_3D<VoxelType>::Initialize()
   this->irtkImageToImage<VoxelType>::Initialize();
 }
 
+template <class VoxelType> void irtkConvolution_3D<VoxelType>::Run()
+{
+  // Evaluate convolution sum for each voxel if kernel is not separable
+  vector<double> factor[3];
+  if (this->_input2 == NULL || !FactorizeKernel(this->_input2, factor)) {
+    irtkConvolution<VoxelType>::Run();
+    return;
+  }
+
+  // Do the initial set up
+  this->Initialize();
+
+  // Perform successive 1D convolutions
+  ConvolveWithSeparableKernel(this->_input, factor, this->_output, 3, this->_Normalization);
+
+  // Do the final cleaning up
+  this->Finalize();
+}
+
 template class irtkConvolution_3D<unsigned char>;
 template class irtkConvolution_3D<short>;
 template class irtkConvolution_3D<unsigned short>;
@@ -18,9 +18,343 @@
 
 #include <irtkEuclideanDistanceTransform.h>
 
+// =============================================================================
+// Auxiliary functions and functors
+// =============================================================================
+
+namespace irtkEuclideanDistanceTransformUtils {
+
+
+// -----------------------------------------------------------------------------
+template <class VoxelType>
+void edtRowEDT_anisotropic(VoxelType *edt, long n, double w)
+/*
+ * This procedure computes D_1 of a single row of voxels in the array edt, i.e.,
+ * the squared distance to the closest feature voxel in this row.
+ */
+{
+  long i;
+  VoxelType d, *p;
+
+  /* compute D_1 as simple forward-and-reverse distance propagation */
+  /* (instead of calling edtVornoiEDT) */
+  /* it is possible to use a simple distance propagation for D_1  because */
+  /* L_1 and L_2 norms are equivalent for 1D case */
+  /* forward pass */
+  p = edt;
+  d = EDT_MAX_DISTANCE_SQUARED_ANISOTROPIC;
+  for (i = 0; i < n; i++, p++) {
+    /* set d = 0 when we encounter a feature voxel */
+    if (*p) {
+      *p = d = 0;
+    }
+    /* increment distance ... */
+    else if (d != EDT_MAX_DISTANCE_SQUARED_ANISOTROPIC) {
+      *p = ++d;
+    }
+    /* ... unless we haven't encountered a feature voxel yet */
+    else {
+      *p = EDT_MAX_DISTANCE_SQUARED_ANISOTROPIC;
+    }
+  }
+  /* reverse pass */
+  if (*(--p) != EDT_MAX_DISTANCE_SQUARED_ANISOTROPIC) {
+    d = EDT_MAX_DISTANCE_SQUARED_ANISOTROPIC;
+    for (i = n - 1; i >= 0; i--, p--) {
+      /* set d = 0 when we encounter a feature voxel */
+      if (*p == 0) {
+        d = 0;
+      }
+      /* increment distance after encountering a feature voxel */
+      else if (d != EDT_MAX_DISTANCE_SQUARED_ANISOTROPIC) {
+        /* compare forward and reverse distances */
+        if (++d < *p) {
+          *p = d;
+        }
+      }
+      /* square distance */
+      /* (we use squared distance in rest of algorithm) */
+      *p *= w;
+      *p *= *p;
+    }
+  }
+} /* edtRowEDT_anisotropic */
+
+// -----------------------------------------------------------------------------
+template <class VoxelType>
+int edtVornoiEDT_anisotropic(VoxelType *f, long n, double w, float *g, float *h)
+/*
+ * This is Procedure edtVornoiEDT() in tPAMI paper.
+ *
+ * The arrays g and h of size n are scratch memory provided by the caller.
+ */
+{
+  long i, l, n_S;
+  float a, b, c, v, lhs, rhs;
+
+  /* construct partial Vornoi diagram */
+  /* this loop is lines 1-14 in Procedure edtVornoiEDT() in tPAMI paper */
+  /* note we use 0 indexing in this program whereas paper uses 1 indexing */
+  for (i = 0, l = -1; i < n; i++) {
+    /* line 4 */
+    if (f[i] != EDT_MAX_DISTANCE_SQUARED_ANISOTROPIC) {
+      /* line 5 */
+      if (l < 1) {
+        /* line 6 */
+        g[++l] = f[i];
+        h[l] = w * i;
+      }
+      /* line 7 */
+      else {
+        /* line 8 */
+        while (l >= 1) {
+          /* compute removeEDT() in line 8 */
+          v = h[l];
+          a = v - h[l-1];
+          b = w * i - v;
+          c = a + b;
+          /* compute Eq. 2 */
+          if ((c*g[l] - b*g[l-1] - a*f[i] - a*b*c) > 0) {
+            /* line 9 */
+            l--;
+          } else {
+            break;
+          }
+        }
+        /* line 11 */
+        g[++l] = f[i];
+        h[l] = w * i;
+      }
+    }
+  }
+  /* query partial Vornoi diagram */
+  /* this is lines 15-25 in Procedure edtVornoiEDT() in tPAMI paper */
+  /* lines 15-17 */
+  if ((n_S = l + 1) == 0) {
+    return (0);
+  }
+  /* lines 18-19 */
+  for (i = 0, l = 0; i < n; i++) {
+    /* line 20 */
+    /* we reduce number of arithmetic operations by taking advantage of */
+    /* similarities in successive computations instead of treating them as */
+    /* independent ones */
+    a = h[l] - w * i;
+    lhs = g[l] + a * a;
+    while (l < n_S - 1) {
+      a = h[l+1] - w * i;
+      rhs = g[l+1] + a * a;
+      if (lhs > rhs) {
+        /* line 21 */
+        l++;
+        lhs = rhs;
+      } else {
+        break;
+      }
+    }
+    /* line 23 */
+    /* we put distance into the 1D array that was passed; */
+    /* must copy into EDT in calling procedure */
+    f[i] = lhs;
+  }
+  /* line 25 */
+  /* return 1 if we queried diagram, 0 if we returned because n_S = 0 */
+  return (1);
+} /* edtVornoiEDT_anisotropic */
+
+// -----------------------------------------------------------------------------
+/// Common attributes of the parallel 1D passes of the distance transform
+///
+/// A pass processes a set of lines of voxels with \c _Length voxels each which
+/// are \c _Stride voxels apart. The line with index l starts at the voxel with
+/// index (l / _Lines) * _Block + (l % _Lines), i.e., there are \c _Lines lines
+/// in each block of \c _Block consecutive voxels. When a second output image
+/// is given, the complement of the input is transformed simultaneously which
+/// yields the distance of object voxels to the background.
+template <class VoxelType>
+struct EDTPass
+{
+  const VoxelType *_Input;   ///< Binary input image or NULL
+  VoxelType       *_Output;  ///< Squared distance to object
+  VoxelType       *_Inside;  ///< Squared distance to background or NULL
+  long             _Lines;   ///< Number of lines per block
+  long             _Block;   ///< Number of voxels per block
+  long             _Length;  ///< Number of voxels per line
+  long             _Stride;  ///< Offset between voxels of a line
+  double           _Weight;  ///< Voxel size along lines
+
+  long Offset(long l) const
+  {
+    return (l / _Lines) * _Block + (l % _Lines);
+  }
+};
+
+// -----------------------------------------------------------------------------
+/// Compute D_1 along rows (x direction), rows are contiguous in memory
+template <class VoxelType>
+class EDTRowPass : public EDTPass<VoxelType>
+{
+public:
+
+  void operator ()(const blocked_range<int> &re) const
+  {
+    const VoxelType *c;
+    VoxelType       *p, *q;
+    long             i;
+
+    for (int l = re.begin(); l != re.end(); ++l) {
+      p = this->_Output + l * this->_Length;
+      /* copy binary image and its complement to edt which is effectively */
+      /* equivalent to computing D_0 */
+      if (this->_Inside) {
+        c = (this->_Input ? this->_Input + l * this->_Length : p);
+        q = this->_Inside + l * this->_Length;
+        for (i = 0; i < this->_Length; i++) {
+          q[i] = (c[i] ? 0 : 1);
+        }
+        edtRowEDT_anisotropic(q, this->_Length, this->_Weight);
+      }
+      if (this->_Input && this->_Input + l * this->_Length != p) {
+        c = this->_Input + l * this->_Length;
+        for (i = 0; i < this->_Length; i++) {
+          p[i] = c[i];
+        }
+      }
+      edtRowEDT_anisotropic(p, this->_Length, this->_Weight);
+    }
+  }
+};
+
+// -----------------------------------------------------------------------------
+/// Compute D_2 along columns (y direction) or D_3 along slices (z direction)
+///
+/// When this is the last pass and signed distances are requested, the
+/// squared distances of both channels are converted into the signed distance
+/// of each voxel to the object boundary while the line is still in memory.
+template <class VoxelType>
+class EDTVornoiPass : public EDTPass<VoxelType>
+{
+public:
+
+  bool _SignedDistance; ///< Whether to compute signed distance in this pass
+
+  void operator ()(const blocked_range<int> &re) const
+  {
+    const long n = this->_Length;
+    VoxelType *p, *f, *e;
+    float     *g, *h;
+    long       i;
+
+    /* scratch memory is allocated per range of lines such that */
+    /* concurrent passes do not interfere with each other */
+    f = new VoxelType[2 * n];
+    e = f + n;
+    g = new float[2 * n];
+    h = g + n;
+
+    for (int l = re.begin(); l != re.end(); ++l) {
+      /* fill array f with D_{d-1} distances in line */
+      /* this is essentially line 4 in Procedure VoronoiEDT() in tPAMI paper */
+      p = this->_Output + this->Offset(l);
+      for (i = 0; i < n; i++, p += this->_Stride) f[i] = *p;
+      edtVornoiEDT_anisotropic(f, n, this->_Weight, g, h);
+      if (this->_Inside) {
+        p = this->_Inside + this->Offset(l);
+        for (i = 0; i < n; i++, p += this->_Stride) e[i] = *p;
+        edtVornoiEDT_anisotropic(e, n, this->_Weight, g, h);
+      }
+      /* copy result back to edt, f is unchanged if line has no features */
+      p = this->_Output + this->Offset(l);
+      if (_SignedDistance) {
+        for (i = 0; i < n; i++, p += this->_Stride) {
+          *p = static_cast<VoxelType>(sqrt(f[i]) - sqrt(e[i]));
+        }
+      } else {
+        for (i = 0; i < n; i++, p += this->_Stride) *p = f[i];
+        if (this->_Inside) {
+          p = this->_Inside + this->Offset(l);
+          for (i = 0; i < n; i++, p += this->_Stride) *p = e[i];
+        }
+      }
+    }
+
+    delete[] f;
+    delete[] g;
+  }
+};
+
+// -----------------------------------------------------------------------------
+/// Compute squared or signed EDT of nT stacks of nZ slices with anisotropic
+/// voxels, where the 1D passes along each dimension are run in parallel.
+/// When edt3D is false, a 2D EDT is computed for each of the nZ * nT slices.
+template <class VoxelType>
+void edtComputeEDT_anisotropic(const VoxelType *img, VoxelType *edt, bool sgn,
+                               long nX, long nY, long nZ, long nT,
+                               double wX, double wY, double wZ, bool edt3D)
+{
+  const long nXY  = nX  * nY;
+  const long nXYZ = nXY * nZ;
+
+  /* with signed distance, the transform of the complement is computed */
+  /* simultaneously in a second image such that each line is read only once */
+  VoxelType *inside = (sgn ? new VoxelType[nXYZ * nT] : NULL);
+
+  /* compute D_1 for each row (x direction) */
+  EDTRowPass<VoxelType> rows;
+  rows._Input  = img;
+  rows._Output = edt;
+  rows._Inside = inside;
+  rows._Lines  = 1;
+  rows._Block  = nX;
+  rows._Length = nX;
+  rows._Stride = 1;
+  rows._Weight = wX;
+  parallel_for(blocked_range<int>(0, static_cast<int>(nY * nZ * nT)), rows);
+
+  /* compute D_2 for each column (y direction) */
+  EDTVornoiPass<VoxelType> cols;
+  cols._Input          = NULL;
+  cols._Output         = edt;
+  cols._Inside         = inside;
+  cols._Lines          = nX;
+  cols._Block          = nXY;
+  cols._Length         = nY;
+  cols._Stride         = nX;
+  cols._Weight         = wY;
+  cols._SignedDistance = (sgn && !edt3D);
+  parallel_for(blocked_range<int>(0, static_cast<int>(nX * nZ * nT)), cols);
+
+  /* compute D_3 for each column (z direction) */
+  if (edt3D) {
+    EDTVornoiPass<VoxelType> slices;
+    slices._Input          = NULL;
+    slices._Output         = edt;
+    slices._Inside         = inside;
+    slices._Lines          = nXY;
+    slices._Block          = nXYZ;
+    slices._Length         = nZ;
+    slices._Stride         = nXY;
+    slices._Weight         = wZ;
+    slices._SignedDistance = sgn;
+    parallel_for(blocked_range<int>(0, static_cast<int>(nXY * nT)), slices);
+  }
+
+  delete[] inside;
+}
+
+
+} // namespace irtkEuclideanDistanceTransformUtils
+using namespace irtkEuclideanDistanceTransformUtils;
+
+// =============================================================================
+// irtkEuclideanDistanceTransform
+// =============================================================================
+
+// -----------------------------------------------------------------------------
 template <class VoxelType> irtkEuclideanDistanceTransform<VoxelType>::irtkEuclideanDistanceTransform(irtkDistanceTransformMode distanceTransformMode) : irtkImageToImage<VoxelType>()
 {
   _distanceTransformMode = distanceTransformMode;
+  _SignedDistance        = false;
 }
 
 /*
@@ -117,7 +451,8 @@ template <class VoxelType> void irtkEuclideanDistanceTransform<VoxelType>::edtCo
 
   /* compute D_2 = squared EDT */
   /* solve 1D problem for each column (y direction) */
-  f = (long *)malloc(nY * sizeof(long));
+  /* f is followed by the scratch memory g and h of edtVornoiEDT */
+  f = (long *)malloc(3 * nY * sizeof(long));
   if (f == NULL) {
     fprintf(stderr, "Error in edtComputeEDT_2D()\n");
     fprintf(stderr, "Cannot malloc f\n");
@@ -132,7 +467,7 @@ template <class VoxelType> void irtkEuclideanDistanceTransform<VoxelType>::edtCo
       *q = *p;
     }
     /* call edtVornoiEDT */
-    if (edtVornoiEDT(f, nY)) {
+    if (edtVornoiEDT(f, nY, f + nY, f + 2 * nY)) {
       p = edt + i;
       q = f;
       for (j = 0; j < nY; j++, p += nX, q++) {
@@ -176,7 +511,8 @@ template <class VoxelType> void irtkEuclideanDistanceTransform<VoxelType>::edtCo
 
   /* compute D_3 */
   /* solve 1D problem for each column (z direction) */
-  f = (long *)malloc(nZ * sizeof(long));
+  /* f is followed by the scratch memory g and h of edtVornoiEDT */
+  f = (long *)malloc(3 * nZ * sizeof(long));
   if (f == NULL) {
     fprintf(stderr, "Error in edtComputeEDT_3D()\n");
     fprintf(stderr, "Cannot malloc f\n");
@@ -191,7 +527,7 @@ template <class VoxelType> void irtkEuclideanDistanceTransform<VoxelType>::edtCo
       *q = *p;
     }
     /* call edtVornoiEDT */
-    if (edtVornoiEDT(f, nZ)) {
+    if (edtVornoiEDT(f, nZ, f + nZ, f + 2 * nZ)) {
       p = edt + i;
       q = f;
       for (k = 0; k < nZ; k++, p += nXY, q++) {
@@ -202,43 +538,15 @@ template <class VoxelType> void irtkEuclideanDistanceTransform<VoxelType>::edtCo
   free(f);
 } /* edtComputeEDT_3D */
 
-template <class VoxelType> int irtkEuclideanDistanceTransform<VoxelType>::edtVornoiEDT(long *f, long n)
+template <class VoxelType> int irtkEuclideanDistanceTransform<VoxelType>::edtVornoiEDT(long *f, long n, long *g, long *h)
 /*
  * This is Procedure edtVornoiEDT() in tPAMI paper.
+ *
+ * The arrays g and h of size n are scratch memory provided by the caller.
+ * Unlike static arrays, this keeps the procedure reentrant.
  */
 {
   long i, l, a, b, c, v, n_S, lhs, rhs;
-  static int firstCall = 1;
-  static long *g, *h, size_gh = 0;
-
-  /* this procedure is called often */
-  /* we keep static arrays to avoid frequent calls to malloc() */
-  /* the downside is that this memory is never freed, */
-  /* but it is not so much memory: max(nX,nY,nZ)*sizeof(long) */
-  /* need to check if arrays are sufficiently large */
-  if (n > size_gh && !firstCall) {
-    free(g);
-    free(h);
-    firstCall = 1;
-  }
-  /* malloc arrays if this is first call to procedure, or if arrays */
-  /* are too small and need to be reallocated */
-  if (firstCall) {
-    g = (long *)malloc(n * sizeof(long));
-    if (g == NULL) {
-      fprintf(stderr, "Error in edtVornoiEDT()\n");
-      fprintf(stderr, "Cannot malloc g\n");
-      exit(EXIT_FAILURE);
-    }
-    h = (long *)malloc(n * sizeof(long));
-    if (h == NULL) {
-      fprintf(stderr, "Error in edtVornoiEDT()\n");
-      fprintf(stderr, "Cannot malloc h\n");
-      exit(EXIT_FAILURE);
-    }
-    size_gh = n;
-    firstCall = 0;
-  }
 
   /* construct partial Vornoi diagram */
   /* this loop is lines 1-14 in Procedure edtVornoiEDT() in tPAMI paper */
@@ -310,115 +618,9 @@ template <class VoxelType> int irtkEuclideanDistanceTransform<VoxelType>::edtVor
   return (1);
 } /* edtVornoiEDT */
 
-
-template <class VoxelType> int irtkEuclideanDistanceTransform<VoxelType>::edtVornoiEDT_anisotropic(VoxelType *f, long n, double w)
-/*
- * This is Procedure edtVornoiEDT() in tPAMI paper.
- */
+template <class VoxelType> int irtkEuclideanDistanceTransform<VoxelType>::edtVornoiEDT_anisotropic(VoxelType *f, long n, double w, float *g, float *h)
 {
-  long i, l, n_S;
-  float a, b, c, v, lhs, rhs;
-  static int firstCall = 1;
-  static long size_gh = 0;
-  static float *g, *h;
-
-  /* this procedure is called often */
-  /* we keep static arrays to avoid frequent calls to malloc() */
-  /* the downside is that this memory is never freed, */
-  /* but it is not so much memory: max(nX,nY,nZ)*sizeof(long) */
-  /* need to check if arrays are sufficiently large */
-  if (n > size_gh && !firstCall) {
-    free(g);
-    free(h);
-    firstCall = 1;
-  }
-  /* malloc arrays if this is first call to procedure, or if arrays */
-  /* are too small and need to be reallocated */
-  if (firstCall) {
-    g = (float *)malloc(n * sizeof(float));
-    if (g == NULL) {
-      fprintf(stderr, "Error in edtVornoiEDT()\n");
-      fprintf(stderr, "Cannot malloc g\n");
-      exit(EXIT_FAILURE);
-    }
-    h = (float *)malloc(n * sizeof(float));
-    if (h == NULL) {
-      fprintf(stderr, "Error in edtVornoiEDT()\n");
-      fprintf(stderr, "Cannot malloc h\n");
-      exit(EXIT_FAILURE);
-    }
-    size_gh = n;
-    firstCall = 0;
-  }
-
-  /* construct partial Vornoi diagram */
-  /* this loop is lines 1-14 in Procedure edtVornoiEDT() in tPAMI paper */
-  /* note we use 0 indexing in this program whereas paper uses 1 indexing */
-  for (i = 0, l = -1; i < n; i++) {
-    /* line 4 */
-    if (f[i] != EDT_MAX_DISTANCE_SQUARED_ANISOTROPIC) {
-      /* line 5 */
-      if (l < 1) {
-        /* line 6 */
-        g[++l] = f[i];
-        h[l] = w * i;
-      }
-      /* line 7 */
-      else {
-        /* line 8 */
-        while (l >= 1) {
-          /* compute removeEDT() in line 8 */
-          v = h[l];
-          a = v - h[l-1];
-          b = w * i - v;
-          c = a + b;
-          /* compute Eq. 2 */
-          if ((c*g[l] - b*g[l-1] - a*f[i] - a*b*c) > 0) {
-            /* line 9 */
-            l--;
-          } else {
-            break;
-          }
-        }
-        /* line 11 */
-        g[++l] = f[i];
-        h[l] = w * i;
-      }
-    }
-  }
-  /* query partial Vornoi diagram */
-  /* this is lines 15-25 in Procedure edtVornoiEDT() in tPAMI paper */
-  /* lines 15-17 */
-  if ((n_S = l + 1) == 0) {
-    return (0);
-  }
-  /* lines 18-19 */
-  for (i = 0, l = 0; i < n; i++) {
-    /* line 20 */
-    /* we reduce number of arithmetic operations by taking advantage of */
-    /* similarities in successive computations instead of treating them as */
-    /* independent ones */
-    a = h[l] - w * i;
-    lhs = g[l] + a * a;
-    while (l < n_S - 1) {
-      a = h[l+1] - w * i;
-      rhs = g[l+1] + a * a;
-      if (lhs > rhs) {
-        /* line 21 */
-        l++;
-        lhs = rhs;
-      } else {
-        break;
-      }
-    }
-    /* line 23 */
-    /* we put distance into the 1D array that was passed; */
-    /* must copy into EDT in calling procedure */
-    f[i] = lhs;
-  }
-  /* line 25 */
-  /* return 1 if we queried diagram, 0 if we returned because n_S = 0 */
-  return (1);
+  return irtkEuclideanDistanceTransformUtils::edtVornoiEDT_anisotropic(f, n, w, g, h);
 } /* edtVornoiEDT_anisotropic */
 
 template <class VoxelType> void irtkEuclideanDistanceTransform<VoxelType>::edtComputeEDT_2D_anisotropic(VoxelType *img, VoxelType *edt, long nX, long nY, double wX, double wY)
@@ -429,95 +631,7 @@ template <class VoxelType> void irtkEuclideanDistanceTransform<VoxelType>::edtCo
  * additional parameters for the image voxel dimensions wX and wY.
  */
 {
-  VoxelType *c;
-  long i, j, nXY;
-  VoxelType d, *p, *q, *f;
-
-  /* nXY is number of voxels in 2D image */
-  nXY = nX * nY;
-
-  /* if binary image is provided in the array img, copy it to the arry edt */
-  /* this is effectively equivalent to computing D_0 */
-  if (img != NULL) {
-    c = img;
-    p = edt;
-    for (i = 0; i < nXY; i++, c++, p++) {
-      *p = *c;
-    }
-  }
-
-  /* compute D_1 as simple forward-and-reverse distance propagation */
-  /* (instead of calling edtVornoiEDT) */
-  /* D_1 is distance to closest feature voxel in row (x direction) */
-  /* it is possible to use a simple distance propagation for D_1  because */
-  /* L_1 and L_2 norms are equivalent for 1D case */
-  for (j = 0; j < nY; j++) {
-    /* forward pass */
-    p = edt + j * nX;
-    d = EDT_MAX_DISTANCE_SQUARED_ANISOTROPIC;
-    for (i = 0; i < nX; i++, p++) {
-      /* set d = 0 when we encounter a feature voxel */
-      if (*p) {
-        *p = d = 0;
-      }
-      /* increment distance ... */
-      else if (d != EDT_MAX_DISTANCE_SQUARED_ANISOTROPIC) {
-        *p = ++d;
-      }
-      /* ... unless we haven't encountered a feature voxel yet */
-      else {
-        *p = EDT_MAX_DISTANCE_SQUARED_ANISOTROPIC;
-      }
-    }
-    /* reverse pass */
-    if (*(--p) != EDT_MAX_DISTANCE_SQUARED_ANISOTROPIC) {
-      d = EDT_MAX_DISTANCE_SQUARED_ANISOTROPIC;
-      for (i = nX - 1; i >= 0; i--, p--) {
-        /* set d = 0 when we encounter a feature voxel */
-        if (*p == 0) {
-          d = 0;
-        }
-        /* increment distance after encountering a feature voxel */
-        else if (d != EDT_MAX_DISTANCE_SQUARED_ANISOTROPIC) {
-          /* compare forward and reverse distances */
-          if (++d < *p) {
-            *p = d;
-          }
-        }
-        /* square distance */
-        /* (we use squared distance in rest of algorithm) */
-        *p *= wX;
-        *p *= *p;
-      }
-    }
-  }
-
-  /* compute D_2 = squared EDT */
-  /* solve 1D problem for each column (y direction) */
-  f = (VoxelType *)malloc(nY * sizeof(VoxelType));
-  if (f == NULL) {
-    fprintf(stderr, "Error in edtComputeEDT_2D()\n");
-    fprintf(stderr, "Cannot malloc f\n");
-    exit(EXIT_FAILURE);
-  }
-  for (i = 0; i < nX; i++) {
-    /* fill array f with D_1 distances in column */
-    /* this is essentially line 4 in Procedure VoronoiEDT() in tPAMI paper */
-    p = edt + i;
-    q = f;
-    for (j = 0; j < nY; j++, p += nX, q++) {
-      *q = *p;
-    }
-    /* call edtVornoiEDT */
-    if (edtVornoiEDT_anisotropic(f, nY, wY)) {
-      p = edt + i;
-      q = f;
-      for (j = 0; j < nY; j++, p += nX, q++) {
-        *p = *q;
-      }
-    }
-  }
-  free(f);
+  edtComputeEDT_anisotropic(img, edt, false, nX, nY, 1, 1, wX, wY, 1.0, false);
 } /* edtComputeEDT_2D_anisotropic */
 
 
@@ -528,63 +642,12 @@ template <class VoxelType> void irtkEuclideanDistanceTransform<VoxelType>::edtCo
 
 template <class VoxelType> void irtkEuclideanDistanceTransform<VoxelType>::edtComputeEDT_3D_anisotropic(VoxelType *img, VoxelType *edt, long nX, long nY, long nZ, double wX, double wY, double wZ)
 {
-  VoxelType *c;
-  long i, k, nXY, nXYZ;
-  VoxelType *p, *q, *f;
-
-  /* nXY is number of voxels in each plane (xy) */
-  /* nXYZ is number of voxels in 3D image */
-  nXY = nX * nY;
-  nXYZ = nX * nY * nZ;
-
-  /* if binary image is provided in the array img, copy it to the arry edt */
-  /* this is effectively equivalent to computing D_0 */
-  if (img != NULL) {
-    c = img;
-    p = edt;
-    for (i = 0; i < nXYZ; i++, c++, p++) {
-      *p = *c;
-    }
-  }
-
-  /* compute D_2 */
-  /* call edtComputeEDT_2D for each plane */
-  p = edt;
-  for (k = 0; k < nZ; k++, p += nXY) {
-    edtComputeEDT_2D_anisotropic(NULL, p, nX, nY, wX, wY);
-  }
-
-  /* compute D_3 */
-  /* solve 1D problem for each column (z direction) */
-  f = (VoxelType *)malloc(nZ * sizeof(VoxelType));
-  if (f == NULL) {
-    fprintf(stderr, "Error in edtComputeEDT_3D()\n");
-    fprintf(stderr, "Cannot malloc f\n");
-    exit(EXIT_FAILURE);
-  }
-  for (i = 0; i < nXY; i++) {
-    /* fill array f with D_2 distances in column */
-    /* this is essentially line 4 in Procedure VoronoiEDT() in tPAMI paper */
-    p = edt + i;
-    q = f;
-    for (k = 0; k < nZ; k++, p += nXY, q++) {
-      *q = *p;
-    }
-    /* call edtVornoiEDT */
-    if (edtVornoiEDT_anisotropic(f, nZ, wZ)) {
-      p = edt + i;
-      q = f;
-      for (k = 0; k < nZ; k++, p += nXY, q++) {
-	*p = *q;
-      }
-    }
-  }
-  free(f);
+  edtComputeEDT_anisotropic(img, edt, false, nX, nY, nZ, 1, wX, wY, wZ, true);
 } /* edtComputeEDT_3D_anisotropic */
 
 template <class VoxelType> void irtkEuclideanDistanceTransform<VoxelType>::Run()
 {
-  int nx, ny, nz, nt, z, t;
+  int nx, ny, nz, nt;
   double wx, wy, wz;
 
   // Do the initial set up
@@ -598,21 +661,13 @@ template <class VoxelType> void irtkEuclideanDistanceTransform<VoxelType>::Run()
 
   // Calculate voxel size
   this->_input->GetPixelSize(&wx, &wy, &wz);
-  for ( t = 0; t < nt; t++){
-	  if (this->_distanceTransformMode == irtkEuclideanDistanceTransform::irtkDistanceTransform3D) {
-		  // Calculate 3D distance transform
-		  edtComputeEDT_3D_anisotropic( this->_input->GetPointerToVoxels(0,0,0,t),
-			  this->_output->GetPointerToVoxels(0,0,0,t),
-			  nx, ny, nz, wx, wy, wz);
-	  } else {
-		  for (z = 0; z < nz; z++) {
-			  // Calculate 2D distance transform slice by slice
-			  edtComputeEDT_2D_anisotropic( this->_input->GetPointerToVoxels(0, 0, z, t),
-				  this->_output->GetPointerToVoxels(0, 0, z, t),
-				  nx, ny, wx, wy);
-		  }
-	  }
-  }
+
+  // Calculate 3D distance transform or 2D distance transform slice by slice,
+  // where the 1D passes of all slices and frames are processed in parallel
+  edtComputeEDT_anisotropic(this->_input ->GetPointerToVoxels(),
+                            this->_output->GetPointerToVoxels(),
+                            _SignedDistance, nx, ny, nz, nt, wx, wy, wz,
+                            this->_distanceTransformMode == irtkEuclideanDistanceTransform::irtkDistanceTransform3D);
 
   // Do the final cleaning up
   this->Finalize();
@@ -28,8 +28,8 @@ irtkFileToImage::irtkFileToImage()
   _reflectZ = false;
   _debug = true;
   _start = 0;
-  _imagename = NULL;
-
+  _MemoryMapping = false;
+  _MappedNaNBackground = false;
 }
 
 irtkFileToImage::~irtkFileToImage()
@@ -42,61 +42,53 @@ irtkFileToImage::~irtkFileToImage()
   _reflectZ = false;
   _debug = true;
   _start = 0;
-  if (_imagename != NULL) 
-      _imagename = NULL;
 }
 
-irtkFileToImage *irtkFileToImage::New(const char *imagename)
+/// Allocate reader for the file format of the named image or return NULL
+static irtkFileToImage *NewReader(const char *imagename)
 {
-  irtkFileToImage *reader = NULL;
-
   // Check format for GIPL
   if (irtkFileGIPLToImage::CheckHeader(imagename)) {
-    reader = new irtkFileGIPLToImage;
-    reader->SetInput(imagename);
-    return reader;
+    return new irtkFileGIPLToImage;
   }
 
 #ifdef HAS_NIFTI
   // Check format for NIFTI
   if (irtkFileNIFTIToImage::CheckHeader(imagename)) {
-    reader = new irtkFileNIFTIToImage;
-    reader->SetInput(imagename);
-    return reader;
+    return new irtkFileNIFTIToImage;
   }
 #endif
 
   // Check format for ANALYZE
   if (irtkFileANALYZEToImage::CheckHeader(imagename)) {
-    reader = new irtkFileANALYZEToImage;
-    reader->SetInput(imagename);
-    return reader;
+    return new irtkFileANALYZEToImage;
   }
 
 #ifdef HAS_VTK
   // Check format for VTK
   if (irtkFileVTKToImage::CheckHeader(imagename)) {
-    reader = new irtkFileVTKToImage;
-    reader->SetInput(imagename);
-    return reader;
+    return new irtkFileVTKToImage;
   }
 #endif
 
   // Check format for PGM
   if (irtkFilePGMToImage::CheckHeader(imagename)) {
-    reader = new irtkFilePGMToImage;
-    reader->SetInput(imagename);
-    return reader;
+    return new irtkFilePGMToImage;
   }
 
 #ifdef HAS_OPENCV
   if (irtkFileOpenCVToImage::CheckHeader(imagename)) {
-      reader = new irtkFileOpenCVToImage;
-      reader->SetInput(imagename);
-      return reader;
+    return new irtkFileOpenCVToImage;
   }
 #endif
 
+  return NULL;
+}
+
+irtkFileToImage *irtkFileToImage::New(const char *imagename)
+{
+  irtkFileToImage *reader = NewReader(imagename);
+
   // Check for error
   if (reader == NULL) {
     cerr << "irtkFileToImage::New: Unknown file format " << imagename
@@ -104,9 +96,21 @@ irtkFileToImage *irtkFileToImage::New(const char *imagename)
     exit(1);
   }
 
+  reader->SetInput(imagename);
   return reader;
 }
 
+bool irtkFileToImage::CheckFormat(const char *imagename)
+{
+  // The header checks of the readers exit if the file cannot be opened
+  FILE *fp = fopen(imagename, "rb");
+  if (fp == NULL) return false;
+  fclose(fp);
+  irtkFileToImage *reader = NewReader(imagename);
+  delete reader;
+  return (reader != NULL);
+}
+
 int irtkFileToImage::GetDebugFlag()
 {
   return _debug;
@@ -126,18 +130,89 @@ void irtkFileToImage::SetInput(const char *imagename)
   _imagename = imagename;
 
   // Open new file for reading
-  this->Open(_imagename);
+  this->Open(_imagename.c_str());
 
   // Read header
   this->ReadHeader();
 }
 
+template <class VoxelType>
+irtkImage *NewMappedImage(const irtkImageAttributes &attr,
+                          const shared_ptr<irtkMemoryMappedFile> &file, size_t offset)
+{
+  irtkGenericImage<VoxelType> *image = new irtkGenericImage<VoxelType>;
+  image->Initialize(attr, file, offset);
+  return image;
+}
+
+template <class VoxelType>
+void SetNaNBackgroundValue(irtkImage *output)
+{
+  const VoxelType *p = reinterpret_cast<const VoxelType *>(output->GetDataPointer());
+  for (int i = 0; i < output->NumberOfVoxels(); ++i, ++p) {
+    if (IsNaN(*p)) {
+      output->PutBackgroundValueAsDouble(numeric_limits<VoxelType>::quiet_NaN());
+      break;
+    }
+  }
+}
+
+irtkImage *irtkFileToImage::GetMappedOutput()
+{
+  if (!irtkMemoryMappedFile::IsSupported()) return NULL;
+
+  // Voxel data must be aligned in memory
+  if (_bytes <= 0 || _start < 0 || _start % _bytes != 0) return NULL;
+
+  // Swapping the byte order or reflecting the image would modify, and thus
+  // copy, every page of the private mapping, use the read path instead
+  if (this->Swapped() || _reflectX || _reflectY || _reflectZ) return NULL;
+
+  // Map image file into memory
+  shared_ptr<irtkMemoryMappedFile> file(new irtkMemoryMappedFile());
+  if (!file->Open(_imagename.c_str())) return NULL;
+
+  // Compressed files cannot be mapped
+  const unsigned char *magic = reinterpret_cast<const unsigned char *>(file->Data());
+  if (file->Size() >= 2 && magic[0] == 0x1f && (magic[1] == 0x8b || magic[1] == 0x9d)) {
+    return NULL;
+  }
+
+  // Check that file contains all image data
+  const size_t size = static_cast<size_t>(_attr.NumberOfLatticePoints()) * _bytes;
+  if (static_cast<size_t>(_start) + size > file->Size()) return NULL;
+
+  irtkImage *output = NULL;
+  switch (_type) {
+    case IRTK_VOXEL_CHAR:           output = NewMappedImage<char>          (_attr, file, _start); break;
+    case IRTK_VOXEL_UNSIGNED_CHAR:  output = NewMappedImage<unsigned char> (_attr, file, _start); break;
+    case IRTK_VOXEL_SHORT:          output = NewMappedImage<short>         (_attr, file, _start); break;
+    case IRTK_VOXEL_UNSIGNED_SHORT: output = NewMappedImage<unsigned short>(_attr, file, _start); break;
+    case IRTK_VOXEL_INT:            output = NewMappedImage<int>           (_attr, file, _start); break;
+    case IRTK_VOXEL_FLOAT:          output = NewMappedImage<float>         (_attr, file, _start); break;
+    case IRTK_VOXEL_DOUBLE:         output = NewMappedImage<double>        (_attr, file, _start); break;
+    default: return NULL;
+  }
+
+  // Set background value to NaN if image contains NaNs, which reads the
+  // entire file and is therefore only done when requested
+  if (_MappedNaNBackground) {
+    if (_type == IRTK_VOXEL_FLOAT)  SetNaNBackgroundValue<float> (output);
+    if (_type == IRTK_VOXEL_DOUBLE) SetNaNBackgroundValue<double>(output);
+  }
+
+  return output;
+}
+
 irtkImage *irtkFileToImage::GetOutput()
 {
   irtkImage *output = NULL;
 
+  // Use data of memory-mapped file if requested and possible
+  if (_MemoryMapping) output = this->GetMappedOutput();
+
   // Bring image to correct size
-  switch (_type) {
+  if (output == NULL) switch (_type) {
   case IRTK_VOXEL_CHAR: {
 
       // Allocate image
@@ -202,13 +277,7 @@ irtkImage *irtkFileToImage::GetOutput()
       this->ReadAsFloat((float *)output->GetScalarPointer(), output->GetNumberOfVoxels(), _start);
 
       // Set background value to NaN if image contains NaNs
-      float *p = reinterpret_cast<float *>(output->GetDataPointer());
-      for (int i = 0; i < output->NumberOfVoxels(); ++i, ++p) {
-        if (IsNaN(*p)) {
-          output->PutBackgroundValueAsDouble(numeric_limits<float>::quiet_NaN());
-          break;
-        }
-      }
+      SetNaNBackgroundValue<float>(output);
     }
     break;
 
@@ -221,13 +290,7 @@ irtkImage *irtkFileToImage::GetOutput()
       this->ReadAsDouble((double *)output->GetScalarPointer(), output->GetNumberOfVoxels(), _start);
 
       // Set background value to NaN if image contains NaNs
-      double *p = reinterpret_cast<double *>(output->GetDataPointer());
-      for (int i = 0; i < output->NumberOfVoxels(); ++i, ++p) {
-        if (IsNaN(*p)) {
-          output->PutBackgroundValueAsDouble(numeric_limits<double>::quiet_NaN());
-          break;
-        }
-      }
+      SetNaNBackgroundValue<double>(output);
     }
     break;
 
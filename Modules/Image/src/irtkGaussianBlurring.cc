@@ -17,15 +17,13 @@
 #include <irtkGaussianBlurring.h>
 
 #include <irtkImage.h>
-#include <irtkConvolutionFunction.h>
+#include <irtkSeparableConvolution.h>
 #include <irtkScalarFunctionToImage.h>
 
 #ifdef USE_CUDA
 # include <irtkCUImage.h>
 #endif
 
-using namespace irtkConvolutionFunction;
-
 
 template <class VoxelType> irtkGaussianBlurring<VoxelType>::irtkGaussianBlurring(double sigma)
 :
@@ -33,6 +31,7 @@ template <class VoxelType> irtkGaussianBlurring<VoxelType>::irtkGaussianBlurring
   _SigmaY(sigma),
   _SigmaZ(sigma),
   _SigmaT(.0),
+  _Recursive(false),
   _Kernel(NULL)
 {
 }
@@ -43,6 +42,7 @@ template <class VoxelType> irtkGaussianBlurring<VoxelType>::irtkGaussianBlurring
   _SigmaY(ysigma),
   _SigmaZ(zsigma),
   _SigmaT(tsigma),
+  _Recursive(false),
   _Kernel(NULL)
 {
 }
@@ -106,71 +106,47 @@ void irtkGaussianBlurring<VoxelType>::InitializeKernel(double sigma)
   }
 }
 
-template <class VoxelType> void irtkGaussianBlurring<VoxelType>::Run()
+template <class VoxelType>
+void irtkGaussianBlurring<VoxelType>::Convolve(irtkSeparableConvolution &conv)
 {
-  IRTK_START_TIMING();
-
-  // Do the initial set up
-  this->Initialize();
-
-  irtkGenericImage<VoxelType> *input  = this->GetInput();
-  irtkGenericImage<VoxelType> *output = this->GetOutput();
-
-  const irtkImageAttributes &attr = input->Attributes();
-  const int N = ((attr._dt == .0) ? attr._t : 1);
-
-  // Blur along x axis
-  if (_SigmaX != .0 && input->X() > 1) {
-    if (output == this->GetInput()) output = new irtkGenericImage<VoxelType>(attr);
-    this->InitializeKernel(_SigmaX / input->GetXSize());
-    for (int n = 0; n < N; ++n) {
-      ConvolveInX<irtkRealPixel> conv(input, _Kernel->Data(), _Kernel->X(), true, n);
-      ParallelForEachVoxel(attr, input, output, conv);
+  const irtkGenericImage<VoxelType> *input  = this->GetInput();
+  irtkGenericImage<VoxelType>       *output = this->GetOutput();
+
+  const double sigma[4] = { _SigmaX, _SigmaY, _SigmaZ, _SigmaT };
+  const int    size [4] = { input->X(), input->Y(), input->Z(), input->T() };
+  double       voxel[4];
+  input->GetPixelSize(&voxel[0], &voxel[1], &voxel[2], &voxel[3]);
+
+  // Blur along each axis, where the first convolution writes the output
+  // and all subsequent ones are done in place without temporary image
+  for (int d = 0; d < 4; ++d) {
+    if (sigma[d] != .0 && size[d] > 1) {
+      const double s = sigma[d] / voxel[d];
+      if (_Recursive && s >= 1.0 && conv.Boundary() == irtkSeparableConvolution::TruncateKernel) {
+        conv.RecursiveGaussian(s);
+      } else {
+        this->InitializeKernel(s);
+        conv.Kernel(_Kernel->Data(), _Kernel->X());
+      }
+      conv.Run(input, d, output);
+      input = output;
     }
-    swap(input, output);
   }
 
-  // Blur along y axis
-  if (_SigmaY != .0 && input->Y() > 1) {
-    if (output == this->GetInput()) output = new irtkGenericImage<VoxelType>(attr);
-    this->InitializeKernel(_SigmaY / input->GetYSize());
-    for (int n = 0; n < N; ++n) {
-      ConvolveInY<irtkRealPixel> conv(input, _Kernel->Data(), _Kernel->X(), true, n);
-      ParallelForEachVoxel(attr, input, output, conv);
-    }
-    swap(input, output);
-  }
+  // Copy input if no convolution was performed
+  if (input != output) output->CopyFrom(input->Data());
+}
 
-  // Blur along z axis
-  if (_SigmaZ != .0 && input->Z() > 1) {
-    if (output == this->GetInput()) output = new irtkGenericImage<VoxelType>(attr);
-    this->InitializeKernel(_SigmaZ / input->GetZSize());
-    for (int n = 0; n < N; ++n) {
-      ConvolveInZ<irtkRealPixel> conv(input, _Kernel->Data(), _Kernel->X(), true, n);
-      ParallelForEachVoxel(attr, input, output, conv);
-    }
-    swap(input, output);
-  }
+template <class VoxelType> void irtkGaussianBlurring<VoxelType>::Run()
+{
+  IRTK_START_TIMING();
 
-  // Blur along t axis
-  if (_SigmaT != .0 && input->T() > 1) {
-    if (output == this->GetInput()) output = new irtkGenericImage<VoxelType>(attr);
-    this->InitializeKernel(_SigmaT / input->GetTSize());
-    ConvolveInT<irtkRealPixel> conv(input, _Kernel->Data(), _Kernel->X(), true);
-    ParallelForEachVoxel(attr, input, output, conv);
-    swap(input, output);
-  }
+  // Do the initial set up
+  this->Initialize();
 
-  // Copy result if last output (i.e., after swap input pointer) was not filter
-  // output image and delete possibly additionally allocated image
-  if (input != output) {
-    if (input == this->GetOutput()) {
-      if (output != this->GetInput()) Delete(output);
-    } else {
-      this->GetOutput()->CopyFrom(input->Data());
-      if (input != this->GetInput ()) Delete(input);
-    }
-  }
+  // Convolve image with 1D Gaussian kernels
+  irtkSeparableConvolution conv(irtkSeparableConvolution::TruncateKernel, true);
+  this->Convolve(conv);
 
   // Do the final cleaning up
   this->Finalize();
@@ -16,8 +16,7 @@
 
 #include <irtkGaussianBlurringWithPadding.h>
 
-#include <irtkConvolutionFunction.h>
-using namespace irtkConvolutionFunction;
+#include <irtkSeparableConvolution.h>
 
 
 template <class VoxelType> irtkGaussianBlurringWithPadding<VoxelType>
@@ -59,68 +58,10 @@ template <class VoxelType> void irtkGaussianBlurringWithPadding<VoxelType>::Run(
   // Do the initial set up
   this->Initialize();
 
-  irtkGenericImage<VoxelType> *input  = this->GetInput();
-  irtkGenericImage<VoxelType> *output = this->GetOutput();
-
-  const irtkImageAttributes &attr = input->Attributes();
-  const int N = ((attr._dt == .0) ? attr._t : 1);
-
-  // Blur along x axis
-  if (this->_SigmaX != .0 && input->X() > 1) {
-    if (output == this->GetInput()) output = new irtkGenericImage<VoxelType>(attr);
-    this->InitializeKernel(this->_SigmaX / input->GetXSize());
-    typedef ConvolveTruncatedForegroundInX<irtkRealPixel> Conv;
-    for (int n = 0; n < N; ++n) {
-      Conv conv(input, _PaddingValue, this->_Kernel->Data(), this->_Kernel->X(), true, n);
-      ParallelForEachVoxel(attr, input, output, conv);
-    }
-    swap(input, output);
-  }
-
-  // Blur along y axis
-  if (this->_SigmaY != .0 && input->Y() > 1) {
-    if (output == this->GetInput()) output = new irtkGenericImage<VoxelType>(attr);
-    this->InitializeKernel(this->_SigmaY / input->GetYSize());
-    typedef ConvolveTruncatedForegroundInY<irtkRealPixel> Conv;
-    for (int n = 0; n < N; ++n) {
-      Conv conv(input, _PaddingValue, this->_Kernel->Data(), this->_Kernel->X(), true, n);
-      ParallelForEachVoxel(attr, input, output, conv);
-    }
-    swap(input, output);
-  }
-
-  // Blur along z axis
-  if (this->_SigmaZ != .0 && input->Z() > 1) {
-    if (output == this->GetInput()) output = new irtkGenericImage<VoxelType>(attr);
-    this->InitializeKernel(this->_SigmaZ / input->GetZSize());
-    typedef ConvolveTruncatedForegroundInZ<irtkRealPixel> Conv;
-    for (int n = 0; n < N; ++n) {
-      Conv conv(input, _PaddingValue, this->_Kernel->Data(), this->_Kernel->X(), true, n);
-      ParallelForEachVoxel(attr, input, output, conv);
-    }
-    swap(input, output);
-  }
-
-  // Blur along t axis
-  if (this->_SigmaT != .0 && input->T() > 1) {
-    if (output == this->GetInput()) output = new irtkGenericImage<VoxelType>(attr);
-    this->InitializeKernel(this->_SigmaT / input->GetTSize());
-    typedef ConvolveTruncatedForegroundInT<irtkRealPixel> Conv;
-    Conv conv(input, _PaddingValue, this->_Kernel->Data(), this->_Kernel->X(), true);
-    ParallelForEachVoxel(attr, input, output, conv);
-    swap(input, output);
-  }
-
-  // Copy result if last output (i.e., after swap input pointer) was not filter
-  // output image and delete possibly additionally allocated image
-  if (input != output) {
-    if (input == this->GetOutput()) {
-      if (output != this->GetInput()) Delete(output);
-    } else {
-      this->GetOutput()->CopyFrom(input->Data());
-      if (input != this->GetInput ()) Delete(input);
-    }
-  }
+  // Convolve foreground with 1D Gaussian kernels
+  irtkSeparableConvolution conv(irtkSeparableConvolution::TruncateForeground, true);
+  conv.Background(_PaddingValue);
+  this->Convolve(conv);
 
   // Do the final cleaning up
   this->Finalize();
@@ -16,11 +16,7 @@
 
 #include <irtkImage.h>
 #include <irtkGaussianPyramidFilter.h>
-#include <irtkUnaryVoxelFunction.h>
-#include <irtkConvolutionFunction.h>
-
-using namespace irtkUnaryVoxelFunction;
-using namespace irtkConvolutionFunction;
+#include <irtkSeparableConvolution.h>
 
 
 // ---------------------------------------------------------------------------
@@ -65,11 +61,6 @@ void irtkGaussianPyramidFilter<VoxelType>::Downsample()
     output->PutBackgroundValueAsDouble(input->GetBackgroundValueAsDouble());
   }
 
-  // Type of downsampling voxel function
-  typedef DownsampleConvolvedExtendedForegroundInX<VoxelType, irtkRealPixel> DownsampleInX;
-  typedef DownsampleConvolvedExtendedForegroundInY<VoxelType, irtkRealPixel> DownsampleInY;
-  typedef DownsampleConvolvedExtendedForegroundInZ<VoxelType, irtkRealPixel> DownsampleInZ;
-
   // FIXME: The irtkGaussianPyramidFilter shifts the image origin incorrectly!
   cerr << "WARNING: The irtkGaussianPyramidFilter shifts the image origin" << endl;
 
@@ -78,6 +69,12 @@ void irtkGaussianPyramidFilter<VoxelType>::Downsample()
   irtkRealPixel kernel[size] = {1, 4, 6, 4, 1};
   const double  norm         = 1.0 / 16.0;
 
+  // Smooth and downsample foreground extended into background in one step
+  irtkSeparableConvolution conv(irtkSeparableConvolution::ExtendForeground, false);
+  conv.Kernel    (kernel, size);
+  conv.Scale     (norm);
+  conv.Factor    (2);
+
   for (int i = _InputLevel; i < _OutputLevel; ++i) {
     // Set output of previous iteration as input
     if (i != _InputLevel) {
@@ -85,45 +82,47 @@ void irtkGaussianPyramidFilter<VoxelType>::Downsample()
       output = new irtkGenericImage<VoxelType>();
     }
 
-    // Input image attributes
+    // Input image attributes, where all frames or vector components
+    // of the image are downsampled
     irtkImageAttributes attr = input->GetImageAttributes();
-    const int n = attr._dt ? 1 : attr._t;
-    attr._dt = 1.0; // s.t. ParallelForEachVoxel downsamples each component
 
     // Downsample x dimension
     if (attr._x > 1) {
-      DownsampleInX downsampleX(input, 2, kernel, size, norm);
+      const int offset = conv.Offset(attr._x);
       attr._x  /= 2;
       attr._dx *= 2;
-      attr._xorigin += attr._xaxis[0] * downsampleX._Offset * attr._dx;
-      attr._yorigin += attr._yaxis[0] * downsampleX._Offset * attr._dx;
-      attr._zorigin += attr._zaxis[0] * downsampleX._Offset * attr._dx;
-      output->Initialize(attr, n);
-      ParallelForEachVoxel(attr, output, downsampleX);
+      attr._xorigin += attr._xaxis[0] * offset * attr._dx;
+      attr._yorigin += attr._yaxis[0] * offset * attr._dx;
+      attr._zorigin += attr._zaxis[0] * offset * attr._dx;
+      output->Initialize(attr);
+      conv.Background(input->GetBackgroundValueAsDouble());
+      conv.Run(input, 0, output);
     }
 
     // Downsample y dimension
     if (attr._y > 1) {
-      DownsampleInY downsampleY(output, 2, kernel, size, norm);
+      const int offset = conv.Offset(attr._y);
       attr._y  /= 2;
       attr._dy *= 2;
-      attr._xorigin += attr._xaxis[1] * downsampleY._Offset * attr._dy;
-      attr._yorigin += attr._yaxis[1] * downsampleY._Offset * attr._dy;
-      attr._zorigin += attr._zaxis[1] * downsampleY._Offset * attr._dy;
-      temp->Initialize(attr, n);
-      ParallelForEachVoxel(attr, temp, downsampleY);
+      attr._xorigin += attr._xaxis[1] * offset * attr._dy;
+      attr._yorigin += attr._yaxis[1] * offset * attr._dy;
+      attr._zorigin += attr._zaxis[1] * offset * attr._dy;
+      temp->Initialize(attr);
+      conv.Background(output->GetBackgroundValueAsDouble());
+      conv.Run(output, 1, temp);
     }
 
     // Downsample z dimension
     if (attr._z > 1) {
-      DownsampleInZ downsampleZ(temp, 2, kernel, size, norm);
+      const int offset = conv.Offset(attr._z);
       attr._z  /= 2;
       attr._dz *= 2;
-      attr._xorigin += attr._xaxis[2] * downsampleZ._Offset * attr._dz;
-      attr._yorigin += attr._yaxis[2] * downsampleZ._Offset * attr._dz;
-      attr._zorigin += attr._zaxis[2] * downsampleZ._Offset * attr._dz;
-      output->Initialize(attr, n);
-      ParallelForEachVoxel(attr, output, downsampleZ);
+      attr._xorigin += attr._xaxis[2] * offset * attr._dz;
+      attr._yorigin += attr._yaxis[2] * offset * attr._dz;
+      attr._zorigin += attr._zaxis[2] * offset * attr._dz;
+      output->Initialize(attr);
+      conv.Background(temp->GetBackgroundValueAsDouble());
+      conv.Run(temp, 2, output);
     }
 
     // Delete intermediate input
@@ -35,6 +35,7 @@ void irtkGenericImage<VoxelType>::AllocateImage(VoxelType *data)
   Deallocate(_matrix, _data);
   if (_dataOwner) Deallocate(_data);
   _dataOwner = false;
+  _dataMap.reset();
   // Initialize memory
   const int nvox = _attr.NumberOfLatticePoints();
   if (nvox > 0) {
@@ -165,6 +166,7 @@ irtkGenericImage<VoxelType>::irtkGenericImage(const irtkGenericImage &image)
     memcpy(_data, image._data, _NumberOfVoxels * sizeof(VoxelType));
   } else {
     AllocateImage(const_cast<VoxelType *>(image.Data()));
+    _dataMap = image._dataMap;
   }
 }
 
@@ -261,6 +263,22 @@ void irtkGenericImage<VoxelType>::Initialize(int x, int y, int z, int t, VoxelTy
   this->Initialize(x, y, z, t, 1, data);
 }
 
+// -----------------------------------------------------------------------------
+template <class VoxelType>
+void irtkGenericImage<VoxelType>::Initialize(const irtkImageAttributes &attr,
+                                             const shared_ptr<irtkMemoryMappedFile> &file,
+                                             size_t offset)
+{
+  const size_t size = static_cast<size_t>(attr.NumberOfLatticePoints()) * sizeof(VoxelType);
+  if (!file || !file->IsOpen() || offset + size > file->Size()) {
+    cerr << this->NameOfClass() << "::Initialize: Memory-mapped file too small for image data" << endl;
+    exit(1);
+  }
+  PutAttributes(attr);
+  AllocateImage(reinterpret_cast<VoxelType *>(file->Data() + offset));
+  _dataMap = file;
+}
+
 // -----------------------------------------------------------------------------
 template <class VoxelType>
 void irtkGenericImage<VoxelType>::CopyFrom(const VoxelType *data)
@@ -352,6 +370,8 @@ template <class VoxelType> void irtkGenericImage<VoxelType>::Clear()
 {
   Deallocate(_matrix, _data);
   if (_dataOwner) Deallocate(_data);
+  _dataOwner = false;
+  _dataMap.reset();
   if (_maskOwner) Delete(_mask);
   _attr = irtkImageAttributes();
 }
@@ -144,7 +144,10 @@ void irtkImageToFile::Initialize()
 void irtkImageToFile::Finalize()
 {
   // Close file
-  this->Close();
+  if (!this->Close()) {
+    cerr << this->NameOfClass() << "::Run: Failed to write file " << _output << endl;
+    exit(1);
+  }
 
   // Reflect back if necessary
   if (_reflectX == true) _input->ReflectX();
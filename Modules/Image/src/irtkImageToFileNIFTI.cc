@@ -207,14 +207,47 @@ void irtkImageToFileNIFTI::Run()
 
   void * const data = _hdr.nim->data; // Keep copy of data pointer
   _hdr.nim->data    = NULL;           // Free nifti_image, but not data
-  nifti_image_free(_hdr.nim);
+  nifti_image *prev = _hdr.nim;       // Keep extensions of previous nifti_image
 
 	_hdr.nim               = nifti_convert_nhdr2nim(nhdr, _output); // This sets fname and iname
 	_hdr.nim->iname_offset = 352;       // Some nifti versions lose this on the way!
   _hdr.nim->data         = data;      // Restore data pointer
+  nifti_copy_extensions(_hdr.nim, prev);
+  nifti_image_free(prev);
 
 	// Write hdr and data
-	nifti_image_write(_hdr.nim);
+  const size_t len = strlen(_output);
+  if (_hdr.nim->nifti_type == NIFTI_FTYPE_NIFTI1_1 && len > 3 &&
+      (strcmp(_output + len - 3, ".gz") == 0 || strcmp(_output + len - 3, ".GZ") == 0)) {
+    // Compress single .nii.gz file in parallel
+    //
+    // The file layout is the one written by nifti_image_write, i.e., the
+    // header is followed by the extender, the extensions, and the image data
+    // starting at the next multiple of 16 bytes.
+    nifti_image * const nim = _hdr.nim;
+    int offset = static_cast<int>(sizeof(nhdr)) + 4;
+    for (int i = 0; i < nim->num_ext; ++i) offset += nim->ext_list[i].esize;
+    if (offset % 16 != 0) offset = ((offset + 0xf) / 16) * 16;
+    nim->iname_offset = offset;
+    nhdr = nifti_convert_nim2nhdr(nim);
+    const char extender[4] = {static_cast<char>(nim->num_ext > 0 ? 1 : 0), 0, 0, 0};
+    const long nbytes = static_cast<long>(nim->nvox) * nim->nbyper;
+    irtkCofstream to(_output);
+    bool ok = to.Write(reinterpret_cast<const char *>(&nhdr), 0, sizeof(nhdr)) &&
+              to.Write(extender, sizeof(nhdr), 4);
+    for (int i = 0; ok && i < nim->num_ext; ++i) {
+      const nifti1_extension &ext = nim->ext_list[i];
+      ok = to.Write(reinterpret_cast<const char *>(&ext.esize), -1, sizeof(int)) &&
+           to.Write(reinterpret_cast<const char *>(&ext.ecode), -1, sizeof(int)) &&
+           to.Write(ext.edata, -1, ext.esize - 8);
+    }
+    if (!ok || !to.Write(reinterpret_cast<const char *>(data), offset, nbytes) || !to.Close()) {
+      cerr << "irtkImageToFileNIFTI::Run: Failed to write file " << _output << endl;
+      exit(1);
+    }
+  } else {
+    nifti_image_write(_hdr.nim);
+  }
 
 	// Finalize filter
 	this->Finalize();
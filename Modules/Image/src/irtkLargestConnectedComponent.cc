@@ -17,53 +17,22 @@
 #include <irtkImage.h>
 
 #include <irtkLargestConnectedComponent.h>
+#include <irtkConnectedComponents.h>
 
 template <class VoxelType> irtkLargestConnectedComponent<VoxelType>::irtkLargestConnectedComponent(VoxelType ClusterLabel)
 {
-  _currentClusterSize = 0;
   _largestClusterSize = 0;
   _Mode2D = false;
   _ClusterLabel = ClusterLabel;
+  _Connectivity = CONNECTIVITY_06;
 }
 
 template <class VoxelType> irtkLargestConnectedComponent<VoxelType>::~irtkLargestConnectedComponent(void)
 {}
 
-template <class VoxelType> void irtkLargestConnectedComponent<VoxelType>::Grow2D(int x, int y, int z, int t)
-{
-  if ((x >= 0) && (x < this->_input->GetX()) && (y >= 0) && (y < this->_input->GetY()) &&
-      (z >= 0) && (z < this->_input->GetZ()) && (t >= 0) && (t < this->_input->GetT())) {
-    if ((this->_input->Get(x, y, z, t) == this->_ClusterLabel) && (this->_output->Get(x, y, z, t) == 0)) {
-      this->_output->Put(x, y, z, t, 1);
-      this->_currentClusterSize++;
-      this->Grow2D(x-1, y  , z, t);
-      this->Grow2D(x+1, y  , z, t);
-      this->Grow2D(x  , y-1, z, t);
-      this->Grow2D(x  , y+1, z, t);
-    }
-  }
-}
-
-template <class VoxelType> void irtkLargestConnectedComponent<VoxelType>::Grow3D(int x, int y, int z, int t)
-{
-  if ((x >= 0) && (x < this->_input->GetX()) && (y >= 0) && (y < this->_input->GetY()) &&
-      (z >= 0) && (z < this->_input->GetZ()) && (t >= 0) && (t < this->_input->GetT())) {
-    if ((this->_input->Get(x, y, z, t) == this->_ClusterLabel) && (this->_output->Get(x, y, z, t) == 0)) {
-      this->_output->Put(x, y, z, t, 1);
-      this->_currentClusterSize++;
-      this->Grow3D(x-1, y  , z  , t);
-      this->Grow3D(x+1, y  , z  , t);
-      this->Grow3D(x  , y-1, z  , t);
-      this->Grow3D(x  , y+1, z  , t);
-      this->Grow3D(x  , y  , z-1, t);
-      this->Grow3D(x  , y  , z+1, t);
-    }
-  }
-}
-
 template <class VoxelType> void irtkLargestConnectedComponent<VoxelType>::Run()
 {
-  int x, y, z, t = 0, largestClusterSeed_x, largestClusterSeed_y, largestClusterSeed_z;
+  int z, idx, nxy, label;
 
   // Do the initial set up
   this->Initialize();
@@ -75,72 +44,29 @@ template <class VoxelType> void irtkLargestConnectedComponent<VoxelType>::Run()
   }
 
   // Do conneted component analysis
-  for (z = 0; z < this->_input->GetZ(); z++) {
-    for (y = 0; y < this->_input->GetY(); y++) {
-      for (x = 0; x < this->_input->GetX(); x++) {
-        this->_output->Put(x, y, z, t, 0);
-      }
-    }
-  }
+  irtkConnectedComponents<VoxelType> components(_ClusterLabel, _Connectivity);
+  components.Input(this->_input);
+  components.Mode2D(_Mode2D);
+  components.Run();
 
-  if (this->_Mode2D == true) {
+  const vector<int> &labels = components.Labels();
+  VoxelType         *output = this->_output->GetPointerToVoxels();
 
+  if (this->_Mode2D == true) {
+    // Select largest component of each slice
+    nxy = this->_input->GetX() * this->_input->GetY();
+    _largestClusterSize = 0;
     for (z = 0; z < this->_input->GetZ(); z++) {
-      largestClusterSeed_x = 0;
-      largestClusterSeed_y = 0;
-      largestClusterSeed_z = z;
-
-      for (y = 0; y < this->_input->GetY(); y++) {
-        for (x = 0; x < this->_input->GetX(); x++) {
-          this->_currentClusterSize = 0;
-          this->Grow2D(x, y, z, t);
-          if (this->_currentClusterSize > this->_largestClusterSize) {
-            this->_largestClusterSize   = this->_currentClusterSize;
-            largestClusterSeed_x = x;
-            largestClusterSeed_y = y;
-            largestClusterSeed_z = z;
-          }
-        }
-      }
-
-      for (y = 0; y < this->_input->GetY(); y++) {
-        for (x = 0; x < this->_input->GetX(); x++) {
-          this->_output->Put(x, y, z, t, 0);
-        }
+      label = components.LargestComponent(z);
+      _largestClusterSize = max(_largestClusterSize, components.ComponentSize(label));
+      for (idx = z * nxy; idx < (z + 1) * nxy; idx++) {
+        output[idx] = ((label > 0 && labels[idx] == label) ? 1 : 0);
       }
-
-      this->Grow2D(largestClusterSeed_x, largestClusterSeed_y, largestClusterSeed_z, t);
     }
   } else {
-
-    largestClusterSeed_x = 0;
-    largestClusterSeed_y = 0;
-    largestClusterSeed_z = 0;
-
-    for (z = 0; z < this->_input->GetZ(); z++) {
-      for (y = 0; y < this->_input->GetY(); y++) {
-        for (x = 0; x < this->_input->GetX(); x++) {
-          this->_currentClusterSize = 0;
-          this->Grow3D(x, y, z, t);
-          if (this->_currentClusterSize > this->_largestClusterSize) {
-            this->_largestClusterSize   = this->_currentClusterSize;
-            largestClusterSeed_x = x;
-            largestClusterSeed_y = y;
-            largestClusterSeed_z = z;
-          }
-        }
-      }
-    }
-
-    for (z = 0; z < this->_input->GetZ(); z++) {
-      for (y = 0; y < this->_input->GetY(); y++) {
-        for (x = 0; x < this->_input->GetX(); x++) {
-          this->_output->Put(x, y, z, t, 0);
-        }
-      }
-    }
-
-    this->Grow3D(largestClusterSeed_x, largestClusterSeed_y, largestClusterSeed_z, t);
+    label = components.LargestComponent();
+    _largestClusterSize = components.ComponentSize(label);
+    components.SelectComponent(this->_output, label);
   }
 
   // Do the final cleaning up
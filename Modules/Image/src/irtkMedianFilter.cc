@@ -18,8 +18,464 @@
 #include <irtkMedianFilter.h>
 #include <vector>
 #include <algorithm>
-#include <set>
+#include <limits>
 
+// =============================================================================
+// Auxiliary functors
+// =============================================================================
+
+namespace irtkMedianFilterUtils {
+
+
+// -----------------------------------------------------------------------------
+/// Histogram of voxel ranks with logarithmic time insertion, removal, and
+/// selection of the k-th smallest rank (binary indexed tree)
+class RankHistogram
+{
+  vector<int> _Count;
+  int         _Size;
+  int         _Step;
+  int         _Total;
+
+public:
+
+  RankHistogram(int n) : _Count(n + 1, 0), _Size(n), _Step(1), _Total(0)
+  {
+    while (2 * _Step <= _Size) _Step *= 2;
+  }
+
+  void Add(int r)
+  {
+    ++_Total;
+    for (int i = r + 1; i <= _Size; i += (i & -i)) ++_Count[i];
+  }
+
+  void Remove(int r)
+  {
+    --_Total;
+    for (int i = r + 1; i <= _Size; i += (i & -i)) --_Count[i];
+  }
+
+  int Total() const
+  {
+    return _Total;
+  }
+
+  /// Rank of k-th smallest sample (zero-based)
+  int Select(int k) const
+  {
+    int pos = 0;
+    for (int step = _Step; step > 0; step /= 2) {
+      if (pos + step <= _Size && _Count[pos + step] <= k) {
+        pos += step;
+        k   -= _Count[pos];
+      }
+    }
+    return pos;
+  }
+};
+
+// -----------------------------------------------------------------------------
+/// Sliding window median filter of a slab of slices
+///
+/// The window is moved along each row of the image. Instead of collecting
+/// and sorting all samples of the neighbourhood of each voxel, only the
+/// samples of the column entering and the column leaving the window are
+/// added to and removed from the rank histogram, respectively. Near the
+/// image border, the window is clipped to the image domain.
+///
+/// The histogram has one bin per rank. For integral images with a small
+/// intensity range, the rank of a voxel is the offset of its value from the
+/// minimum value. Otherwise, the ranks are the indices into the sorted list of
+/// distinct values of the slices covered by the windows of the slab, such that
+/// the histogram of each task has at most as many bins as there are voxels in
+/// these slices regardless of the number of distinct values of the image.
+template <class VoxelType>
+class MedianFilter
+{
+public:
+
+  const VoxelType *_Input;
+  VoxelType       *_Output;
+  const char      *_Mask;
+  VoxelType        _Min;    ///< Minimum intensity of integral image
+  int              _Range;  ///< Intensity range of integral image or zero
+  int              _X, _Y, _Z;
+  int              _Radius;
+
+  /// Maximum number of voxels whose values are ranked at once when the
+  /// ranks are not the offsets of integral values from the minimum value
+  static const int MaxNumberOfRankedVoxels = 65536;
+
+  /// Index of first slice covered by the window of the given slice
+  int FirstSlice(int s) const
+  {
+    return s - min(s % _Z, _Radius);
+  }
+
+  /// Index of last slice covered by the window of the given slice
+  int LastSlice(int s) const
+  {
+    return s + min(_Z - 1 - s % _Z, _Radius);
+  }
+
+  /// Determine ranks of the voxels of the slices [s1, s2]
+  void Rank(int s1, int s2, vector<int> &rank, vector<VoxelType> &value) const
+  {
+    const int        n     = (s2 - s1 + 1) * _X * _Y;
+    const VoxelType *input = _Input + s1 * _X * _Y;
+    rank.resize(n);
+    if (_Range > 0) {
+      value.resize(_Range);
+      for (int r = 0; r < _Range; ++r) value[r] = static_cast<VoxelType>(_Min + r);
+      for (int idx = 0; idx < n; ++idx) rank[idx] = static_cast<int>(input[idx] - _Min);
+    } else {
+      value.assign(input, input + n);
+      sort(value.begin(), value.end());
+      value.erase(unique(value.begin(), value.end()), value.end());
+      for (int idx = 0; idx < n; ++idx) {
+        rank[idx] = static_cast<int>(lower_bound(value.begin(), value.end(), input[idx]) - value.begin());
+      }
+    }
+  }
+
+  void AddColumn(RankHistogram &hist, const int *rank, int offset,
+                 int x, int y1, int y2, int z1, int z2, int t) const
+  {
+    int idx;
+    for (int z = z1; z <= z2; ++z)
+    for (int y = y1; y <= y2; ++y) {
+      idx = ((t * _Z + z) * _Y + y) * _X + x;
+      if (!_Mask || _Mask[idx]) hist.Add(rank[idx - offset]);
+    }
+  }
+
+  void RemoveColumn(RankHistogram &hist, const int *rank, int offset,
+                    int x, int y1, int y2, int z1, int z2, int t) const
+  {
+    int idx;
+    for (int z = z1; z <= z2; ++z)
+    for (int y = y1; y <= y2; ++y) {
+      idx = ((t * _Z + z) * _Y + y) * _X + x;
+      if (!_Mask || _Mask[idx]) hist.Remove(rank[idx - offset]);
+    }
+  }
+
+  /// Filter slices [s1, s2) using the given ranks of slices [FirstSlice(s1), ...]
+  void Filter(int s1, int s2, const int *rank, const VoxelType *value, int nbins) const
+  {
+    int y1, y2, z1, z2, idx, t, z;
+    const int offset = FirstSlice(s1) * _X * _Y;
+
+    RankHistogram hist(nbins);
+    for (int s = s1; s != s2; ++s) {
+      t  = s / _Z;
+      z  = s % _Z;
+      z1 = max(0,      z - _Radius);
+      z2 = min(_Z - 1, z + _Radius);
+      for (int y = 0; y < _Y; ++y) {
+        y1 = max(0,      y - _Radius);
+        y2 = min(_Y - 1, y + _Radius);
+        idx = ((t * _Z + z) * _Y + y) * _X;
+        for (int x = 0; x < _X; ++x, ++idx) {
+          if (x == 0) {
+            for (int i = 0; i <= min(_X - 1, _Radius); ++i) {
+              AddColumn(hist, rank, offset, i, y1, y2, z1, z2, t);
+            }
+          } else {
+            if (x + _Radius < _X) AddColumn   (hist, rank, offset, x + _Radius,     y1, y2, z1, z2, t);
+            if (x - _Radius > 0)  RemoveColumn(hist, rank, offset, x - _Radius - 1, y1, y2, z1, z2, t);
+          }
+          if ((_Mask && !_Mask[idx]) || hist.Total() == 0) {
+            _Output[idx] = _Input[idx];
+          } else {
+            _Output[idx] = value[hist.Select(hist.Total() / 2)];
+          }
+        }
+        for (int i = max(0, _X - 1 - _Radius); i < _X; ++i) {
+          RemoveColumn(hist, rank, offset, i, y1, y2, z1, z2, t);
+        }
+      }
+    }
+  }
+
+  void operator ()(const blocked_range<int> &re) const
+  {
+    vector<int>       rank;
+    vector<VoxelType> value;
+    if (_Range > 0) {
+      const int s1 = FirstSlice(re.begin());
+      Rank(s1, LastSlice(re.end() - 1), rank, value);
+      Filter(re.begin(), re.end(), &rank[0], &value[0], _Range);
+    } else {
+      // Rank the values of a few slices at a time such that the histogram
+      // stays small, re-ranking the slices shared by consecutive sub-slabs
+      const int n = max(2 * _Radius + 1, MaxNumberOfRankedVoxels / (_X * _Y) - 2 * _Radius);
+      for (int s1 = re.begin(); s1 < re.end(); s1 += n) {
+        const int s2 = min(s1 + n, re.end());
+        Rank(FirstSlice(s1), LastSlice(s2 - 1), rank, value);
+        Filter(s1, s2, &rank[0], &value[0], static_cast<int>(value.size()));
+      }
+    }
+  }
+};
+
+
+// -----------------------------------------------------------------------------
+/// Sliding window median filter of a slab of slices of an integral image with
+/// one histogram per image column (cf. Perreault and Hebert, 2007)
+///
+/// A column histogram counts the values of the voxels with equal x coordinate
+/// within the y and z extent of the window. When the window moves to the next
+/// row, each column histogram is shifted by removing the voxels of the row
+/// which leaves and adding the voxels of the row which enters the window. The
+/// rows of consecutive slices are visited in alternating order such that the
+/// column histograms are likewise shifted along z when the window moves to the
+/// next slice. Along a row, the window histogram is updated by adding the
+/// histogram of the column which enters and subtracting the histogram of the
+/// column which leaves the window.
+///
+/// All histograms have a coarse level with one bin per segment of about
+/// sqrt(n) values, where n is the intensity range. The fine bins of the window
+/// histogram are only brought up to date for the segment which contains the
+/// median. Each voxel thus costs O(r + sqrt(n)) time.
+template <class VoxelType>
+class ColumnMedianFilter
+{
+public:
+
+  const VoxelType *_Input;
+  VoxelType       *_Output;
+  const char      *_Mask;
+  VoxelType        _Min;    ///< Minimum intensity of integral image
+  int              _Range;  ///< Intensity range of integral image
+  int              _X, _Y, _Z;
+  int              _Radius;
+
+  /// Maximum total number of bins of the column histograms of one task
+  static const int MaxNumberOfColumnBins = 4194304;
+
+  /// Column and window histograms of a task
+  struct Histograms
+  {
+    int         _SegmentSize;  ///< Number of fine bins per coarse bin
+    int         _Segments;     ///< Number of coarse bins
+    vector<int> _ColumnFine;   ///< Fine bins of column histograms
+    vector<int> _ColumnCoarse; ///< Coarse bins of column histograms
+    vector<int> _WindowFine;   ///< Fine bins of window histogram
+    vector<int> _WindowCoarse; ///< Coarse bins of window histogram
+    vector<int> _Updated;      ///< Column at which the fine bins of a segment
+                               ///< of the window histogram were last updated
+    int         _T, _Y1, _Y2, _Z1, _Z2; ///< Extent of column histograms
+  };
+
+  /// Allocate empty histograms
+  void Initialize(Histograms &h) const
+  {
+    h._SegmentSize = static_cast<int>(ceil(sqrt(static_cast<double>(_Range))));
+    h._Segments    = (_Range + h._SegmentSize - 1) / h._SegmentSize;
+    h._ColumnFine  .assign(_X * _Range,      0);
+    h._ColumnCoarse.assign(_X * h._Segments, 0);
+    h._WindowFine  .assign(_Range,           0);
+    h._WindowCoarse.assign(h._Segments,      0);
+    h._Updated     .assign(h._Segments,     -1);
+    h._T = -1, h._Y1 = h._Y2 = h._Z1 = h._Z2 = 0;
+  }
+
+  /// Add (delta = 1) or remove (delta = -1) the voxels of rows [y1, y2] of
+  /// slices [z1, z2] of frame t to or from the column histograms
+  void UpdateColumns(Histograms &h, int t, int y1, int y2, int z1, int z2, int delta) const
+  {
+    int idx, bin;
+    for (int z = z1; z <= z2; ++z)
+    for (int y = y1; y <= y2; ++y) {
+      idx = ((t * _Z + z) * _Y + y) * _X;
+      for (int x = 0; x < _X; ++x, ++idx) {
+        if (!_Mask || _Mask[idx]) {
+          bin = static_cast<int>(_Input[idx] - _Min);
+          h._ColumnFine  [x * _Range      + bin                 ] += delta;
+          h._ColumnCoarse[x * h._Segments + bin / h._SegmentSize] += delta;
+        }
+      }
+    }
+  }
+
+  /// Shift column histograms to rows [y1, y2] of slices [z1, z2] of frame t
+  void MoveColumns(Histograms &h, int t, int y1, int y2, int z1, int z2) const
+  {
+    if (t != h._T || y1 > h._Y2 || y2 < h._Y1 || z1 > h._Z2 || z2 < h._Z1) {
+      fill(h._ColumnFine  .begin(), h._ColumnFine  .end(), 0);
+      fill(h._ColumnCoarse.begin(), h._ColumnCoarse.end(), 0);
+      UpdateColumns(h, t, y1, y2, z1, z2, +1);
+    } else {
+      // Shift along y
+      UpdateColumns(h, t, h._Y1, min(h._Y2, y1 - 1), h._Z1, h._Z2, -1);
+      UpdateColumns(h, t, max(h._Y1, y2 + 1), h._Y2, h._Z1, h._Z2, -1);
+      UpdateColumns(h, t, y1, min(y2, h._Y1 - 1),    h._Z1, h._Z2, +1);
+      UpdateColumns(h, t, max(y1, h._Y2 + 1), y2,    h._Z1, h._Z2, +1);
+      // Shift along z
+      UpdateColumns(h, t, y1, y2, h._Z1, min(h._Z2, z1 - 1), -1);
+      UpdateColumns(h, t, y1, y2, max(h._Z1, z2 + 1), h._Z2, -1);
+      UpdateColumns(h, t, y1, y2, z1, min(z2, h._Z1 - 1),    +1);
+      UpdateColumns(h, t, y1, y2, max(z1, h._Z2 + 1), z2,    +1);
+    }
+    h._T = t, h._Y1 = y1, h._Y2 = y2, h._Z1 = z1, h._Z2 = z2;
+  }
+
+  /// Add (delta = 1) or subtract (delta = -1) coarse bins of column histogram
+  void AddColumn(Histograms &h, int x, int delta) const
+  {
+    const int *coarse = &h._ColumnCoarse[x * h._Segments];
+    for (int b = 0; b < h._Segments; ++b) h._WindowCoarse[b] += delta * coarse[b];
+  }
+
+  /// Add (delta = 1) or subtract (delta = -1) fine bins [bin1, bin2) of
+  /// column histogram
+  void AddColumn(Histograms &h, int x, int bin1, int bin2, int delta) const
+  {
+    const int *fine = &h._ColumnFine[x * _Range];
+    for (int bin = bin1; bin < bin2; ++bin) h._WindowFine[bin] += delta * fine[bin];
+  }
+
+  /// Update fine bins of segment b of window histogram centered at column x
+  void UpdateSegment(Histograms &h, int b, int x) const
+  {
+    const int bin1 = b * h._SegmentSize;
+    const int bin2 = min(bin1 + h._SegmentSize, _Range);
+    int &last = h._Updated[b];
+    if (last < 0 || x - last > 2 * _Radius + 1) {
+      for (int bin = bin1; bin < bin2; ++bin) h._WindowFine[bin] = 0;
+      for (int i = max(0, x - _Radius); i <= min(_X - 1, x + _Radius); ++i) {
+        AddColumn(h, i, bin1, bin2, +1);
+      }
+    } else {
+      for (int i = last + 1; i <= x; ++i) {
+        if (i + _Radius < _X) AddColumn(h, i + _Radius,     bin1, bin2, +1);
+        if (i - _Radius > 0)  AddColumn(h, i - _Radius - 1, bin1, bin2, -1);
+      }
+    }
+    last = x;
+  }
+
+  void operator ()(const blocked_range<int> &re) const
+  {
+    int y, y1, y2, z1, z2, idx, t, z, k, b, bin, total;
+
+    Histograms h;
+    Initialize(h);
+    for (int s = re.begin(); s != re.end(); ++s) {
+      t  = s / _Z;
+      z  = s % _Z;
+      z1 = max(0,      z - _Radius);
+      z2 = min(_Z - 1, z + _Radius);
+      for (int j = 0; j < _Y; ++j) {
+        y  = ((s - re.begin()) % 2 == 0 ? j : _Y - 1 - j);
+        y1 = max(0,      y - _Radius);
+        y2 = min(_Y - 1, y + _Radius);
+        MoveColumns(h, t, y1, y2, z1, z2);
+        fill(h._WindowCoarse.begin(), h._WindowCoarse.end(), 0);
+        fill(h._Updated     .begin(), h._Updated     .end(), -1);
+        for (int i = 0; i <= min(_X - 1, _Radius); ++i) AddColumn(h, i, +1);
+        idx = ((t * _Z + z) * _Y + y) * _X;
+        for (int x = 0; x < _X; ++x, ++idx) {
+          if (x > 0) {
+            if (x + _Radius < _X) AddColumn(h, x + _Radius,     +1);
+            if (x - _Radius > 0)  AddColumn(h, x - _Radius - 1, -1);
+          }
+          if (_Mask && !_Mask[idx]) {
+            _Output[idx] = _Input[idx];
+            continue;
+          }
+          total = 0;
+          for (b = 0; b < h._Segments; ++b) total += h._WindowCoarse[b];
+          if (total == 0) {
+            _Output[idx] = _Input[idx];
+            continue;
+          }
+          k = total / 2;
+          for (b = 0; k >= h._WindowCoarse[b]; ++b) k -= h._WindowCoarse[b];
+          UpdateSegment(h, b, x);
+          for (bin = b * h._SegmentSize; k >= h._WindowFine[bin]; ++bin) k -= h._WindowFine[bin];
+          _Output[idx] = static_cast<VoxelType>(_Min + bin);
+        }
+      }
+    }
+  }
+};
+
+
+// -----------------------------------------------------------------------------
+/// Median filter of a slab of slices which selects the median of the samples
+/// of each neighbourhood, used for small neighbourhoods of images whose voxels
+/// are ranked by MedianFilter, where selection is faster than ranking
+template <class VoxelType>
+class SortMedianFilter
+{
+public:
+
+  /// Maximum number of samples of neighbourhoods filtered by selection
+  static const int MaxNumberOfSamples = 125;
+
+  const VoxelType *_Input;
+  VoxelType       *_Output;
+  const char      *_Mask;
+  int              _X, _Y, _Z;
+  int              _Radius;
+
+  void operator ()(const blocked_range<int> &re) const
+  {
+    int x1, x2, y1, y2, z1, z2, idx, i, t, z;
+    vector<VoxelType> samples;
+    samples.reserve((2 * _Radius + 1) * (2 * _Radius + 1) * (2 * _Radius + 1));
+
+    for (int s = re.begin(); s != re.end(); ++s) {
+      t  = s / _Z;
+      z  = s % _Z;
+      z1 = max(0,      z - _Radius);
+      z2 = min(_Z - 1, z + _Radius);
+      for (int y = 0; y < _Y; ++y) {
+        y1 = max(0,      y - _Radius);
+        y2 = min(_Y - 1, y + _Radius);
+        idx = ((t * _Z + z) * _Y + y) * _X;
+        for (int x = 0; x < _X; ++x, ++idx) {
+          if (_Mask && !_Mask[idx]) {
+            _Output[idx] = _Input[idx];
+            continue;
+          }
+          x1 = max(0,      x - _Radius);
+          x2 = min(_X - 1, x + _Radius);
+          samples.clear();
+          for (int k = z1; k <= z2; ++k)
+          for (int j = y1; j <= y2; ++j) {
+            i = ((t * _Z + k) * _Y + j) * _X + x1;
+            for (int l = x1; l <= x2; ++l, ++i) {
+              if (!_Mask || _Mask[i]) samples.push_back(_Input[i]);
+            }
+          }
+          if (samples.empty()) {
+            _Output[idx] = _Input[idx];
+          } else {
+            nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+            _Output[idx] = samples[samples.size() / 2];
+          }
+        }
+      }
+    }
+  }
+};
+
+
+} // namespace irtkMedianFilterUtils
+using namespace irtkMedianFilterUtils;
+
+// =============================================================================
+// irtkMedianFilter
+// =============================================================================
+
+// -----------------------------------------------------------------------------
+template <class VoxelType> const int irtkMedianFilter<VoxelType>::MaxNumberOfBins = 65536;
+
+// -----------------------------------------------------------------------------
 template <class VoxelType> irtkMedianFilter<VoxelType>::irtkMedianFilter()
 {
 	// Default kernel radius.
@@ -29,16 +485,28 @@ template <class VoxelType> irtkMedianFilter<VoxelType>::irtkMedianFilter()
 	this->_mask = NULL;
 }
 
+// -----------------------------------------------------------------------------
 template <class VoxelType> irtkMedianFilter<VoxelType>::~irtkMedianFilter(void)
 {
 }
 
+// -----------------------------------------------------------------------------
 template <class VoxelType> void irtkMedianFilter<VoxelType>::Initialize()
 {
   // Do the initial set up
   this->irtkImageToImage<VoxelType>::Initialize();
+
+  // Check mask
+  if (_mask != NULL && (_mask->GetX() != this->_input->GetX() ||
+                        _mask->GetY() != this->_input->GetY() ||
+                        _mask->GetZ() != this->_input->GetZ() ||
+                       (_mask->GetT() != this->_input->GetT() && _mask->GetT() != 1))) {
+    cerr << "irtkMedianFilter::Initialize: Mask must have same dimensions as input image" << endl;
+    exit(1);
+  }
 }
 
+// -----------------------------------------------------------------------------
 template <class VoxelType> void irtkMedianFilter<VoxelType>::SetMask(irtkRealImage *mask)
 {
   if (mask != NULL) {
@@ -49,54 +517,96 @@ template <class VoxelType> void irtkMedianFilter<VoxelType>::SetMask(irtkRealIma
   }
 }
 
+// -----------------------------------------------------------------------------
 template <class VoxelType> void irtkMedianFilter<VoxelType>::Run()
 {
-  int x, y, z, t;
-
-  //int dim = 2*_kernelRadius + 1;
-
   // Do the initial set up
   this->Initialize();
 
-  multiset<VoxelType> voxels;
+  const int        n     = this->_input->GetNumberOfVoxels();
+  const VoxelType *input = this->_input->GetPointerToVoxels();
 
-  for (t = 0; t < this->_input->GetT(); t++) {
-    for (z = 0; z < this->_input->GetZ(); z++) {
-      for (y = 0; y < this->_input->GetY(); y++) {
-        for (x = 0; x < this->_input->GetX(); x++) {
-          if ((x < _kernelRadius) || (x > this->_input->GetX() - 1 - _kernelRadius) ||
-              (y < _kernelRadius) || (y > this->_input->GetY() - 1 - _kernelRadius) ||
-              (z < _kernelRadius) || (z > this->_input->GetZ() - 1 - _kernelRadius)) {
-            this->_output->Put(x, y, z, t, this->_input->Get(x, y, z, t));
-          } else {
-        	  vector<VoxelType> voxels;
-        	  for( int zz = z - _kernelRadius; zz <= z + _kernelRadius; ++zz )
-        	  {
-        		  for( int yy = y - _kernelRadius; yy <= y + _kernelRadius; ++yy )
-        		  {
-        			  for( int xx = x - _kernelRadius; xx <= x + _kernelRadius; ++xx )
-        			  {
-        				  if( this->_mask->Get(xx,yy,zz,t) ) {
-        					  voxels.push_back( this->_input->Get(xx,yy,zz,t) );
-        				  }
-        			  }
-        		  }
-        	  }
-        	  if( voxels.size() )
-        	  {
-        		  sort(voxels.begin(), voxels.end());
-        		  this->_output->Put(x, y, z, t, voxels[voxels.size()/2]);
-        	  }
-          }
-        }
-      }
+  // Binary mask of voxels to consider, where a mask with a single frame
+  // is applied to all frames of the input image
+  vector<char> mask;
+  if (_mask) {
+    mask.resize(n);
+    const int nvox = this->_input->GetX() * this->_input->GetY() * this->_input->GetZ();
+    for (int idx = 0; idx < n; ++idx) {
+      mask[idx] = (_mask->GetPointerToVoxels()[_mask->GetT() > 1 ? idx : idx % nvox] != 0);
+    }
+  }
+
+  // For integral voxel types with small intensity range, the rank of a voxel
+  // is the offset of its value from the minimum value. Otherwise, each task
+  // ranks the distinct values of the slices covered by its windows. Column
+  // histograms are used unless the O(sqrt(n)) cost of merging them exceeds
+  // the O(r^2 log n) cost of updating a binary indexed tree.
+  VoxelType vmin = VoxelType(), vmax = VoxelType();
+  int       range = 0;
+  if (numeric_limits<VoxelType>::is_integer) {
+    this->_input->GetMinMax(vmin, vmax);
+    if (static_cast<double>(vmax) - static_cast<double>(vmin) < MaxNumberOfBins) {
+      range = static_cast<int>(vmax) - static_cast<int>(vmin) + 1;
     }
   }
 
+  // Filter slabs of slices in parallel
+  const blocked_range<int> slices(0, this->_input->GetZ() * this->_input->GetT());
+  const int                width = 2 * _kernelRadius + 1;
+  if (range == 0 && width * width * width <= SortMedianFilter<VoxelType>::MaxNumberOfSamples) {
+
+    // Select median of few neighbourhood samples without ranking all voxels
+    SortMedianFilter<VoxelType> body;
+    body._Input  = input;
+    body._Output = this->_output->GetPointerToVoxels();
+    body._Mask   = (mask.empty() ? NULL : &mask[0]);
+    body._X      = this->_input->GetX();
+    body._Y      = this->_input->GetY();
+    body._Z      = this->_input->GetZ();
+    body._Radius = _kernelRadius;
+    parallel_for(slices, body);
+
+  } else if (range > 0 && static_cast<double>(this->_input->GetX()) * range
+                          <= ColumnMedianFilter<VoxelType>::MaxNumberOfColumnBins
+                       && sqrt(static_cast<double>(range))
+                          <= width * width * log(static_cast<double>(range)) / log(2.0)) {
+
+    // Sliding window median using column histograms of intensities
+    ColumnMedianFilter<VoxelType> body;
+    body._Input  = input;
+    body._Output = this->_output->GetPointerToVoxels();
+    body._Mask   = (mask.empty() ? NULL : &mask[0]);
+    body._Min    = vmin;
+    body._Range  = range;
+    body._X      = this->_input->GetX();
+    body._Y      = this->_input->GetY();
+    body._Z      = this->_input->GetZ();
+    body._Radius = _kernelRadius;
+    parallel_for(slices, body);
+
+  } else {
+
+    // Sliding window median using histogram of voxel ranks
+    MedianFilter<VoxelType> body;
+    body._Input  = input;
+    body._Output = this->_output->GetPointerToVoxels();
+    body._Mask   = (mask.empty() ? NULL : &mask[0]);
+    body._Min    = vmin;
+    body._Range  = range;
+    body._X      = this->_input->GetX();
+    body._Y      = this->_input->GetY();
+    body._Z      = this->_input->GetZ();
+    body._Radius = _kernelRadius;
+    parallel_for(slices, body);
+
+  }
+
   // Do the final cleaning up
   this->Finalize();
 }
 
+// -----------------------------------------------------------------------------
 template class irtkMedianFilter<irtkBytePixel>;
 template class irtkMedianFilter<irtkGreyPixel>;
 template class irtkMedianFilter<irtkRealPixel>;
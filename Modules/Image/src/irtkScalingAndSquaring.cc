@@ -27,22 +27,62 @@
 namespace irtkScalingAndSquaringUtils {
 
 
+// -----------------------------------------------------------------------------
+/// Base class of voxel functions which map voxel indices of the given domain
+/// to world coordinates and vice versa, where the transformation matrices are
+/// computed once instead of by each irtkImageAttributes::LatticeToWorld call
+struct LatticeVoxelFunction : public irtkVoxelFunction
+{
+  irtkMatrix _matL2W, _matW2L;
+
+  LatticeVoxelFunction() {}
+
+  LatticeVoxelFunction(const irtkImageAttributes &domain)
+  {
+    Initialize(domain);
+  }
+
+  inline void Initialize(const irtkImageAttributes &domain)
+  {
+    _matL2W = domain.GetImageToWorldMatrix();
+    _matW2L = domain.GetWorldToImageMatrix();
+  }
+
+  inline void LatticeToWorld(double &x, double &y, double &z) const
+  {
+    const irtkMatrix &m = _matL2W;
+    double a = m(0, 0) * x + m(0, 1) * y + m(0, 2) * z + m(0, 3);
+    double b = m(1, 0) * x + m(1, 1) * y + m(1, 2) * z + m(1, 3);
+    double c = m(2, 0) * x + m(2, 1) * y + m(2, 2) * z + m(2, 3);
+    x = a, y = b, z = c;
+  }
+
+  inline void WorldToLattice(double &x, double &y, double &z) const
+  {
+    const irtkMatrix &m = _matW2L;
+    double a = m(0, 0) * x + m(0, 1) * y + m(0, 2) * z + m(0, 3);
+    double b = m(1, 0) * x + m(1, 1) * y + m(1, 2) * z + m(1, 3);
+    double c = m(2, 0) * x + m(2, 1) * y + m(2, 2) * z + m(2, 3);
+    x = a, y = b, z = c;
+  }
+};
+
 // -----------------------------------------------------------------------------
 template <class TReal>
-struct ConvertToDisplacement3D : public irtkVoxelFunction
+struct ConvertToDisplacement3D : public LatticeVoxelFunction
 {
-  const int                  _x, _y, _z;
-  const irtkImageAttributes &_Domain;
+  const int _x, _y, _z;
 
   ConvertToDisplacement3D(const irtkImageAttributes &domain)
   :
-    _x(0), _y(domain.NumberOfSpatialPoints()), _z(2 * _y), _Domain(domain)
+    LatticeVoxelFunction(domain),
+    _x(0), _y(domain.NumberOfSpatialPoints()), _z(2 * _y)
   {}
 
   void operator()(int i, int j, int k, int, const TReal *d, TReal *u)
   {
     double x = i, y = j, z = k;
-    _Domain.LatticeToWorld(x, y, z);
+    LatticeToWorld(x, y, z);
     u[_x] = d[_x] - x;
     u[_y] = d[_y] - y;
     u[_z] = d[_z] - z;
@@ -51,20 +91,20 @@ struct ConvertToDisplacement3D : public irtkVoxelFunction
 
 // -----------------------------------------------------------------------------
 template <class TReal>
-struct ConvertToDeformation3D : public irtkVoxelFunction
+struct ConvertToDeformation3D : public LatticeVoxelFunction
 {
-  const int                  _x, _y, _z;
-  const irtkImageAttributes &_Domain;
+  const int _x, _y, _z;
 
   ConvertToDeformation3D(const irtkImageAttributes &domain)
   :
-    _x(0), _y(domain.NumberOfSpatialPoints()), _z(2 * _y), _Domain(domain)
+    LatticeVoxelFunction(domain),
+    _x(0), _y(domain.NumberOfSpatialPoints()), _z(2 * _y)
   {}
 
   void operator()(int i, int j, int k, int, const TReal *u, TReal *d)
   {
     double x = i, y = j, z = k;
-    _Domain.LatticeToWorld(x, y, z);
+    LatticeToWorld(x, y, z);
     d[_x] = x + u[_x];
     d[_y] = y + u[_y];
     d[_z] = z + u[_z];
@@ -73,22 +113,22 @@ struct ConvertToDeformation3D : public irtkVoxelFunction
 
 // -----------------------------------------------------------------------------
 template <class TReal>
-struct ConvertToVoxelUnits3D : public irtkVoxelFunction
+struct ConvertToVoxelUnits3D : public LatticeVoxelFunction
 {
-  const int                  _x, _y, _z;
-  const irtkImageAttributes &_Domain;
+  const int _x, _y, _z;
 
   ConvertToVoxelUnits3D(const irtkImageAttributes &domain)
   :
-    _x(0), _y(domain.NumberOfSpatialPoints()), _z(2 * _y), _Domain(domain)
+    LatticeVoxelFunction(domain),
+    _x(0), _y(domain.NumberOfSpatialPoints()), _z(2 * _y)
   {}
 
   void operator()(int i, int j, int k, int, const TReal *d, TReal *u)
   {
     double x = i, y = j, z = k;
-    _Domain.LatticeToWorld(x, y, z);
+    LatticeToWorld(x, y, z);
     x += d[_x], y += d[_y], z += d[_z];
-    _Domain.WorldToLattice(x, y, z);
+    WorldToLattice(x, y, z);
     u[_x] = x - i;
     u[_y] = y - j;
     u[_z] = z - k;
@@ -97,24 +137,24 @@ struct ConvertToVoxelUnits3D : public irtkVoxelFunction
 
 // -----------------------------------------------------------------------------
 template <class TReal>
-struct ConvertToWorldUnits3D : public irtkVoxelFunction
+struct ConvertToWorldUnits3D : public LatticeVoxelFunction
 {
-  const int                  _x, _y, _z;
-  const irtkImageAttributes &_Domain;
+  const int _x, _y, _z;
 
   ConvertToWorldUnits3D(const irtkImageAttributes &domain)
   :
-    _x(0), _y(domain.NumberOfSpatialPoints()), _z(2 * _y), _Domain(domain)
+    LatticeVoxelFunction(domain),
+    _x(0), _y(domain.NumberOfSpatialPoints()), _z(2 * _y)
   {}
 
   void operator()(int i, int j, int k, int, const TReal *u, TReal *d)
   {
     double x1 = i, y1 = j, z1 = k;
-    _Domain.LatticeToWorld(x1, y1, z1);
+    LatticeToWorld(x1, y1, z1);
     double x2 = i + u[_x];
     double y2 = j + u[_y];
     double z2 = k + u[_z];
-    _Domain.LatticeToWorld(x2, y2, z2);
+    LatticeToWorld(x2, y2, z2);
     d[_x] = x2 - x1;
     d[_y] = y2 - y1;
     d[_z] = z2 - z1;
@@ -124,14 +164,12 @@ struct ConvertToWorldUnits3D : public irtkVoxelFunction
 // -----------------------------------------------------------------------------
 /// Voxel function for the evaluation of the Jacobian w.r.t. x during scaling step
 template <class TReal>
-struct EvaluateJacobianBase : public irtkVoxelFunction
+struct EvaluateJacobianBase : public LatticeVoxelFunction
 {
   typedef typename irtkScalingAndSquaring<TReal>::VelocityField VelocityField;
 
   static const int     _xx = 0;
   int                  _xy, _xz, _yx, _yy, _yz, _zx, _zy, _zz;
-  irtkImageAttributes  _Domain;
-  irtkMatrix           _matW2L;
   const VelocityField *_VelocityField;
   double               _Scale;
 
@@ -144,8 +182,7 @@ struct EvaluateJacobianBase : public irtkVoxelFunction
                  _xy = 1 * n; _xz = 2 * n;
     _yx = 3 * n; _yy = 4 * n; _yz = 5 * n;
     _zx = 6 * n; _zy = 7 * n; _zz = 8 * n;
-    _Domain        = domain;
-    _matW2L        = domain.GetWorldToLatticeMatrix();
+    LatticeVoxelFunction::Initialize(domain);
     _VelocityField = v;
     _Scale         = s;
   }
@@ -164,7 +201,7 @@ struct EvaluateJacobianBase : public irtkVoxelFunction
   {
     // Convert output voxel indices to velocity field voxel coordinates
     double x = i, y = j, z = k;
-    _Domain.LatticeToWorld(x, y, z);
+    LatticeToWorld(x, y, z);
     _VelocityField->Input()->WorldToImage(x, y, z);
     // Evaluate Jacobian of velocity field
     irtkMatrix dvx, dvy, dvz;
@@ -326,7 +363,8 @@ struct UpdateDisplacement : public irtkVoxelFunction
 };
 
 // -----------------------------------------------------------------------------
-/// Voxel function for update of Jacobian w.r.t. x at each squaring step
+/// Voxel function for update of displacement and Jacobian w.r.t. x at each
+/// squaring step, where both are updated in the same sweep over the voxels
 template <class TInterpolator>
 struct UpdateJacobianBase : public irtkVoxelFunction
 {
@@ -334,19 +372,18 @@ struct UpdateJacobianBase : public irtkVoxelFunction
 
   static const int     _x = 0, _xx = 0;
   int                  _y, _z, _xy, _xz, _yx, _yy, _yz, _zx, _zy, _zz;
+  const TInterpolator *_Displacement;
   const TInterpolator *_Jacobian;
   const TInterpolator *_DetJacobian;
   const TInterpolator *_LogJacobian;
 
-  inline void Initialize(const TInterpolator *j,
+  inline void Initialize(const TInterpolator *d,
+                         const TInterpolator *j,
                          const TInterpolator *dj,
                          const TInterpolator *lj)
   {
     // number of voxels
-    int n = 0;
-    if (j ) n = j ->Input()->NumberOfSpatialVoxels();
-    if (dj) n = dj->Input()->NumberOfSpatialVoxels();
-    if (lj) n = lj->Input()->NumberOfSpatialVoxels();
+    const int n = d->Input()->NumberOfSpatialVoxels();
     // vector element offsets
     /* _x  = 0 */_y  = 1 * n; _z  = 2 * n;
     // matrix element offsets
@@ -354,9 +391,10 @@ struct UpdateJacobianBase : public irtkVoxelFunction
     _yx = 3 * n; _yy = 4 * n; _yz = 5 * n;
     _zx = 6 * n; _zy = 7 * n; _zz = 8 * n;
     // interpolators
-    _Jacobian    = j;
-    _DetJacobian = dj;
-    _LogJacobian = lj;
+    _Displacement = d;
+    _Jacobian     = j;
+    _DetJacobian  = dj;
+    _LogJacobian  = lj;
   }
 
   // ---------------------------------------------------------------------------
@@ -365,6 +403,16 @@ struct UpdateJacobianBase : public irtkVoxelFunction
     x += u[_x], y += u[_y], z += u[_z];
   }
 
+  // ---------------------------------------------------------------------------
+  inline void UpdateDisp(double x, double y, double z, const TReal *u_in, TReal *u_out)
+  {
+    double u[3] = {.0, .0, .0};
+    _Displacement->Evaluate(u, x, y, z);
+    u_out[_x] = u_in[_x] + u[0];
+    u_out[_y] = u_in[_y] + u[1];
+    u_out[_z] = u_in[_z] + u[2];
+  }
+
   // ---------------------------------------------------------------------------
   inline void UpdateJac(double x, double y, double z, const TReal *in, TReal *out)
   {
@@ -401,7 +449,7 @@ struct UpdateJacobianBase : public irtkVoxelFunction
   inline void UpdateLog(double x, double y, double z, const TReal *lj_in, TReal *lj_out)
   {
     if (_LogJacobian->IsInside(x, y, z)) {
-      (*lj_out) = (*lj_in) + max(/*log(.0001)=*/-4, _LogJacobian->EvaluateInside(x, y, z));
+      (*lj_out) = (*lj_in) + max(/*log(.0001)=*/-4.0, _LogJacobian->EvaluateInside(x, y, z));
     } else {
       (*lj_out) = (*lj_in);
     }
@@ -430,12 +478,13 @@ template <class TInterpolator>
 struct UpdateJacobian : public UpdateJacobianBase<TInterpolator>
 {
   typedef typename TInterpolator::VoxelType TReal;
-  void operator()(int i, int j, int k, int,
-                  const TReal *u, const TReal *in, TReal *out)
+  void operator()(int i, int j, int k, int, const TReal *u, const TReal *in,
+                  const TReal *u_out, TReal *out)
   {
     double x = i, y = j, z = k;
     this->Transform(x, y, z, u);
-    this->UpdateJac(x, y, z, in, out);
+    this->UpdateDisp(x, y, z, u, const_cast<TReal *>(u_out));
+    this->UpdateJac (x, y, z, in, out);
   }
 };
 
@@ -444,12 +493,13 @@ template <class TInterpolator>
 struct UpdateDetJacobian : public UpdateJacobianBase<TInterpolator>
 {
   typedef typename TInterpolator::VoxelType TReal;
-  void operator()(int i, int j, int k, int,
-                  const TReal *u, const TReal *dj_in, TReal *dj_out)
+  void operator()(int i, int j, int k, int, const TReal *u, const TReal *dj_in,
+                  const TReal *u_out, TReal *dj_out)
   {
     double x = i, y = j, z = k;
     this->Transform(x, y, z, u);
-    this->UpdateDet(x, y, z, dj_in, dj_out);
+    this->UpdateDisp(x, y, z, u, const_cast<TReal *>(u_out));
+    this->UpdateDet (x, y, z, dj_in, dj_out);
   }
 };
 
@@ -458,12 +508,13 @@ template <class TInterpolator>
 struct UpdateLogJacobian : public UpdateJacobianBase<TInterpolator>
 {
   typedef typename TInterpolator::VoxelType TReal;
-  void operator()(int i, int j, int k, int,
-                  const TReal *u, const TReal *lj_in, TReal *lj_out)
+  void operator()(int i, int j, int k, int, const TReal *u, const TReal *lj_in,
+                  const TReal *u_out, TReal *lj_out)
   {
     double x = i, y = j, z = k;
     this->Transform(x, y, z, u);
-    this->UpdateLog(x, y, z, lj_in, lj_out);
+    this->UpdateDisp(x, y, z, u, const_cast<TReal *>(u_out));
+    this->UpdateLog (x, y, z, lj_in, lj_out);
   }
 };
 
@@ -473,11 +524,12 @@ struct UpdateDetJacobianAndLog : public UpdateJacobianBase<TInterpolator>
 {
   typedef typename TInterpolator::VoxelType TReal;
   void operator()(int i, int j, int k, int, const TReal *u,
-                  const TReal *dj_in,  const TReal *lj_in,
+                  const TReal *dj_in,  const TReal *lj_in,  const TReal *u_out,
                   const TReal *dj_out, TReal       *lj_out)
   {
     double x = i, y = j, z = k;
     this->Transform(x, y, z, u);
+    this->UpdateDisp(x, y, z, u, const_cast<TReal *>(u_out));
     this->UpdateDetAndLog(x, y, z, dj_in, lj_in, const_cast<TReal *>(dj_out), lj_out);
   }
 };
@@ -488,13 +540,14 @@ struct UpdateJacobianAndDet : public UpdateJacobianBase<TInterpolator>
 {
   typedef typename TInterpolator::VoxelType TReal;
   void operator()(int i, int j, int k, int, const TReal *u,
-                  const TReal *in,  const TReal *dj_in,
+                  const TReal *in,  const TReal *dj_in, const TReal *u_out,
                   const TReal *out, TReal       *dj_out)
   {
     double x = i, y = j, z = k;
     this->Transform(x, y, z, u);
-    this->UpdateJac(x, y, z, in, const_cast<TReal *>(out));
-    this->UpdateDet(x, y, z, dj_in, dj_out);
+    this->UpdateDisp(x, y, z, u, const_cast<TReal *>(u_out));
+    this->UpdateJac (x, y, z, in, const_cast<TReal *>(out));
+    this->UpdateDet (x, y, z, dj_in, dj_out);
   }
 };
 
@@ -504,13 +557,14 @@ struct UpdateJacobianAndLog : public UpdateJacobianBase<TInterpolator>
 {
   typedef typename TInterpolator::VoxelType TReal;
   void operator()(int i, int j, int k, int, const TReal *u,
-                  const TReal *in,  const TReal *lj_in,
+                  const TReal *in,  const TReal *lj_in, const TReal *u_out,
                   const TReal *out, TReal       *lj_out)
   {
     double x = i, y = j, z = k;
     this->Transform(x, y, z, u);
-    this->UpdateJac(x, y, z, in, const_cast<TReal *>(out));
-    this->UpdateLog(x, y, z, lj_in, lj_out);
+    this->UpdateDisp(x, y, z, u, const_cast<TReal *>(u_out));
+    this->UpdateJac (x, y, z, in, const_cast<TReal *>(out));
+    this->UpdateLog (x, y, z, lj_in, lj_out);
   }
 };
 
@@ -520,12 +574,13 @@ struct UpdateJacobianAndDetAndLog : public UpdateJacobianBase<TInterpolator>
 {
   typedef typename TInterpolator::VoxelType TReal;
   void operator()(int i, int j, int k, int, const TReal *u,
-                  const TReal *in,  const TReal *dj_in,  const TReal *lj_in,
+                  const TReal *in,  const TReal *dj_in,  const TReal *lj_in, const TReal *u_out,
                   const TReal *out, const TReal *dj_out, TReal       *lj_out)
   {
     double x = i, y = j, z = k;
     this->Transform(x, y, z, u);
-    this->UpdateJac(x, y, z, in, const_cast<TReal *>(out));
+    this->UpdateDisp(x, y, z, u, const_cast<TReal *>(u_out));
+    this->UpdateJac (x, y, z, in, const_cast<TReal *>(out));
     this->UpdateDetAndLog(x, y, z, dj_in, lj_in, const_cast<TReal *>(dj_out), lj_out);
   }
 };
@@ -571,25 +626,25 @@ struct UpdateJacobianDOFs : public irtkVoxelFunction
 // -----------------------------------------------------------------------------
 /// Voxel function for composition of output displacement with input displacement
 template <class TInterpolator>
-struct ApplyInputDisplacement : public irtkVoxelFunction
+struct ApplyInputDisplacement : public LatticeVoxelFunction
 {
   typedef typename TInterpolator::VoxelType TReal;
 
-  const int                  _x, _y, _z;
-  const irtkImageAttributes &_Domain;
-  const TInterpolator       *_Image;
-  const int                  _NumberOfComponents;
+  const int            _x, _y, _z;
+  const TInterpolator *_Image;
+  const int            _NumberOfComponents;
 
   ApplyInputDisplacement(const irtkImageAttributes &domain, const TInterpolator *f)
   :
+    LatticeVoxelFunction(domain),
     _x(0), _y(domain.NumberOfSpatialPoints()), _z(2 * _y),
-    _Domain(domain), _Image(f), _NumberOfComponents(_Image->Input()->T())
+    _Image(f), _NumberOfComponents(_Image->Input()->T())
   {}
 
   void operator()(int i, int j, int k, int, const TReal *d, TReal *out)
   {
     double x = i, y = j, z = k;
-    _Domain.LatticeToWorld(x, y, z);
+    LatticeToWorld(x, y, z);
     x += d[_x], y += d[_y], z += d[_z];
     _Image->Input()->WorldToImage(x, y, z);
     for (int l = 0; l < _NumberOfComponents; ++l, out += _y /* =X*Y*Z */) {
@@ -628,18 +683,17 @@ struct ApplyInputDeformation : public irtkVoxelFunction
 // -----------------------------------------------------------------------------
 /// Voxel function for resampling of output images
 template <class TInterpolator>
-struct ResampleOutput : public irtkVoxelFunction
+struct ResampleOutput : public LatticeVoxelFunction
 {
   typedef typename TInterpolator::VoxelType TReal;
 
-  const irtkImageAttributes &_Domain;
-  const TInterpolator       *_Image;
-  const int                  _NumberOfVoxels;
-  const int                  _NumberOfComponents;
+  const TInterpolator *_Image;
+  const int            _NumberOfVoxels;
+  const int            _NumberOfComponents;
 
   ResampleOutput(const irtkImageAttributes &domain, const TInterpolator *f)
   :
-    _Domain(domain), _Image(f),
+    LatticeVoxelFunction(domain), _Image(f),
     _NumberOfVoxels(domain.NumberOfSpatialPoints()),
     _NumberOfComponents(_Image->Input()->T())
   {}
@@ -647,7 +701,7 @@ struct ResampleOutput : public irtkVoxelFunction
   void operator()(int i, int j, int k, int, TReal *value)
   {
     double x = i, y = j, z = k;
-    _Domain.LatticeToWorld(x, y, z);
+    LatticeToWorld(x, y, z);
     _Image->Input()->WorldToImage(x, y, z);
     for (int l = 0; l < _NumberOfComponents; ++l, value += _NumberOfVoxels) {
       (*value) = _Image->Evaluate(x, y, z, l);
@@ -656,6 +710,32 @@ struct ResampleOutput : public irtkVoxelFunction
 };
 
 
+// =============================================================================
+// Auxiliary functions
+// =============================================================================
+
+// -----------------------------------------------------------------------------
+/// Allocate image of workspace or reuse previously allocated memory
+template <class TReal>
+void InitializeWorkspace(irtkGenericImage<TReal> *&image, const irtkImageAttributes &attr, int n)
+{
+  if (!image) image = new irtkGenericImage<TReal>;
+  image->Initialize(attr, n);
+}
+
+// -----------------------------------------------------------------------------
+/// Create interpolator of workspace image or reuse previously created one
+template <class TInterpolator>
+void InitializeInterpolator(TInterpolator *&f, irtkInterpolationMode imode,
+                            irtkExtrapolationMode emode,
+                            const typename TInterpolator::ImageType *image)
+{
+  if (f && f->InterpolationMode() != InterpolationWithoutPadding(imode)) Delete(f);
+  if (f) f->Input(image);
+  else   f = TInterpolator::New(imode, emode, image);
+}
+
+
 } // namespace irtkScalingAndSquaringUtils
 using namespace irtkScalingAndSquaringUtils;
 
@@ -675,6 +755,11 @@ irtkScalingAndSquaring<TReal>::irtkScalingAndSquaring()
   _InterimDetJacobian(NULL),
   _InterimLogJacobian(NULL),
   _InterimJacobianDOFs(NULL),
+  _SquaredDisplacement(NULL),
+  _SquaredJacobian(NULL),
+  _SquaredDetJacobian(NULL),
+  _SquaredLogJacobian(NULL),
+  _SquaredJacobianDOFs(NULL),
   _Displacement(NULL),
   _Jacobian(NULL),
   _DetJacobian(NULL),
@@ -692,6 +777,7 @@ irtkScalingAndSquaring<TReal>::irtkScalingAndSquaring()
   _IntegrationLimit(1.0),
   _NumberOfSteps(0),
   _NumberOfSquaringSteps(0),
+  _ActualNumberOfSquaringSteps(0),
   _MaxScaledVelocity(.0),
   _Upsample(false),
   _SmoothBeforeDownsampling(false)
@@ -712,6 +798,11 @@ void irtkScalingAndSquaring<TReal>::Clear()
   Delete(_InterimDetJacobian);
   Delete(_InterimLogJacobian);
   Delete(_InterimJacobianDOFs);
+  Delete(_SquaredDisplacement);
+  Delete(_SquaredJacobian);
+  Delete(_SquaredDetJacobian);
+  Delete(_SquaredLogJacobian);
+  Delete(_SquaredJacobianDOFs);
 }
 
 // -----------------------------------------------------------------------------
@@ -756,9 +847,6 @@ void irtkScalingAndSquaring<TReal>::Initialize()
     exit(1);
   }
 
-  // Leave no potential memory leaks
-  Clear();
-
   // Initialize input interpolator
   VelocityField velocity;
   velocity.Input     (_InputVelocity);
@@ -786,21 +874,28 @@ void irtkScalingAndSquaring<TReal>::Initialize()
     if (attr._z > 1) attr._z *= 2, attr._dz /= 2;
   }
 
+  // Free workspace of previous run if attributes of intermediate images changed
+  if (_InterimDisplacement && !_InterimDisplacement->Attributes().EqualInSpace(attr)) {
+    Clear();
+  }
+
   // Number of squaring steps
-  if (_NumberOfSquaringSteps <= 0) {
-    _NumberOfSquaringSteps = ceil(log(static_cast<double>(_NumberOfSteps)) / log(2.0));
+  _ActualNumberOfSquaringSteps = _NumberOfSquaringSteps;
+  if (_ActualNumberOfSquaringSteps <= 0) {
+    _ActualNumberOfSquaringSteps = ceil(log(static_cast<double>(_NumberOfSteps)) / log(2.0));
   }
-  if (_NumberOfSquaringSteps < 0) {
-    _NumberOfSquaringSteps = 0; // i.e., 1 integration step only
+  if (_ActualNumberOfSquaringSteps < 0) {
+    _ActualNumberOfSquaringSteps = 0; // i.e., 1 integration step only
   }
 
   // Initialize deformation field and increase number of squaring steps if needed
   // Note that input image may contain precomputed interpolation coefficients!
-  _InterimDisplacement = new ImageType(attr, 3);
+  InitializeWorkspace(_InterimDisplacement, attr, 3);
+  InitializeWorkspace(_SquaredDisplacement, attr, 3);
   velocity.Evaluate(*_InterimDisplacement);
 
   TReal  vmax  = .0;
-  TReal  scale = _IntegrationLimit / pow(2.0, _NumberOfSquaringSteps);
+  TReal  scale = _IntegrationLimit / pow(2.0, _ActualNumberOfSquaringSteps);
   TReal *v     = _InterimDisplacement->Data();
   const int n  = 3 * attr.NumberOfSpatialPoints();
   for (int idx = 0; idx < n; ++idx, ++v) {
@@ -814,7 +909,7 @@ void irtkScalingAndSquaring<TReal>::Initialize()
     TReal s = 1.0;
     while ((vmax * s) > _MaxScaledVelocity) {
       s *= 0.5;
-      _NumberOfSquaringSteps++;
+      _ActualNumberOfSquaringSteps++;
     }
     if (s != 1.0) {
       (*_InterimDisplacement) *= s;
@@ -823,18 +918,36 @@ void irtkScalingAndSquaring<TReal>::Initialize()
     }
   }
 
-  // Update number of steps
-  _NumberOfSteps = pow(2.0, _NumberOfSquaringSteps);
-
   // Compute derivatives of initial deformation w.r.t. x and/or its (log) determinant
   int jac_mode = 0;
   if (_OutputJacobian || _OutputJacobianDOFs) jac_mode += 1;
   if (_OutputDetJacobian                    ) jac_mode += 2;
   if (_OutputLogJacobian                    ) jac_mode += 4;
 
-  if (jac_mode & 1) _InterimJacobian    = new ImageType(attr, 9);
-  if (jac_mode & 2) _InterimDetJacobian = new ImageType(attr);
-  if (jac_mode & 4) _InterimLogJacobian = new ImageType(attr);
+  if (jac_mode & 1) {
+    InitializeWorkspace(_InterimJacobian, attr, 9);
+    InitializeWorkspace(_SquaredJacobian, attr, 9);
+  } else {
+    Delete(_InterimJacobian);
+    Delete(_SquaredJacobian);
+    Delete(_Jacobian);
+  }
+  if (jac_mode & 2) {
+    InitializeWorkspace(_InterimDetJacobian, attr, 1);
+    InitializeWorkspace(_SquaredDetJacobian, attr, 1);
+  } else {
+    Delete(_InterimDetJacobian);
+    Delete(_SquaredDetJacobian);
+    Delete(_DetJacobian);
+  }
+  if (jac_mode & 4) {
+    InitializeWorkspace(_InterimLogJacobian, attr, 1);
+    InitializeWorkspace(_SquaredLogJacobian, attr, 1);
+  } else {
+    Delete(_InterimLogJacobian);
+    Delete(_SquaredLogJacobian);
+    Delete(_LogJacobian);
+  }
 
   switch (jac_mode) {
     case 1: {
@@ -876,8 +989,8 @@ void irtkScalingAndSquaring<TReal>::Initialize()
 
   // Compute derivatives of initial deformation w.r.t. v
   if (_OutputJacobianDOFs) {
-    _InterimJacobianDOFs = new ImageType;
-    _InterimJacobianDOFs->Initialize(attr, 9);
+    InitializeWorkspace(_InterimJacobianDOFs, attr, 9);
+    InitializeWorkspace(_SquaredJacobianDOFs, attr, 9);
     TReal *dxx = _InterimJacobianDOFs->Data(0, 0, 0, 0);
     TReal *dyy = _InterimJacobianDOFs->Data(0, 0, 0, 4);
     TReal *dzz = _InterimJacobianDOFs->Data(0, 0, 0, 8);
@@ -885,6 +998,10 @@ void irtkScalingAndSquaring<TReal>::Initialize()
     for (int i = 0; i < n; ++i) {
       dxx[i] = dyy[i] = dzz[i] = scale;
     }
+  } else {
+    Delete(_InterimJacobianDOFs);
+    Delete(_SquaredJacobianDOFs);
+    Delete(_JacobianDOFs);
   }
 
   // Initialize interpolators used during squaring steps
@@ -893,11 +1010,11 @@ void irtkScalingAndSquaring<TReal>::Initialize()
                                  imode == Interpolation_CubicBSpline ||
                                  imode == Interpolation_FastCubicBSpline)
                                 ? Extrapolation_Mirror : Extrapolation_NN;
-  _Displacement = DisplacementField::New(imode, emode, _InterimDisplacement);
-  if (_InterimJacobian    ) _Jacobian     = JacobianField::New(imode, emode, _InterimJacobian);
-  if (_InterimDetJacobian ) _DetJacobian  = JacobianField::New(imode, emode, _InterimDetJacobian);
-  if (_InterimLogJacobian ) _LogJacobian  = JacobianField::New(imode, emode, _InterimLogJacobian);
-  if (_InterimJacobianDOFs) _JacobianDOFs = JacobianField::New(imode, emode, _InterimJacobianDOFs);
+  InitializeInterpolator(_Displacement, imode, emode, _InterimDisplacement);
+  if (_InterimJacobian    ) InitializeInterpolator(_Jacobian,     imode, emode, _InterimJacobian);
+  if (_InterimDetJacobian ) InitializeInterpolator(_DetJacobian,  imode, emode, _InterimDetJacobian);
+  if (_InterimLogJacobian ) InitializeInterpolator(_LogJacobian,  imode, emode, _InterimLogJacobian);
+  if (_InterimJacobianDOFs) InitializeInterpolator(_JacobianDOFs, imode, emode, _InterimJacobianDOFs);
 
   // Use output deformation field as temporary output displacement field
   if (!_OutputDisplacement) _OutputDisplacement = _OutputDeformation;
@@ -984,9 +1101,6 @@ void irtkScalingAndSquaring<TReal>::Finalize()
     exit(1);
   }
 
-  // Free allocated memory
-  Clear();
-
   IRTK_DEBUG_TIMING(5, "finalization of scaling and squaring");
 }
 
@@ -1007,43 +1121,21 @@ void irtkScalingAndSquaring<TReal>::Run()
   if (_InterimDetJacobian) jac_mode += 2;
   if (_InterimLogJacobian) jac_mode += 4;
 
-  // Either allocate required temporary images or use provided output
-  ImageType *disp   = _OutputDisplacement;
-  ImageType *jac3x3 = NULL;
-  ImageType *detjac = NULL;
-  ImageType *logjac = NULL;
-  ImageType *dofjac = NULL;
-
-  if (!disp) disp = new ImageType;
-  disp->Initialize(attr, 3);
-
-  if (_InterimJacobian) {
-    if (_OutputJacobian) jac3x3 = _OutputJacobian;
-    else                 jac3x3 = new ImageType;
-    jac3x3->Initialize(attr, 9);
-  }
-  if (_InterimDetJacobian) {
-    if (_OutputDetJacobian) detjac = _OutputDetJacobian;
-    else                    detjac = new ImageType;
-    detjac->Initialize(attr, 1);
-  }
-  if (_InterimLogJacobian) {
-    if (_OutputLogJacobian) logjac = _OutputLogJacobian;
-    else                    logjac = new ImageType;
-    logjac->Initialize(attr, 1);
-  }
-  if (_InterimJacobianDOFs) {
-    if (_OutputJacobianDOFs) dofjac = _OutputJacobianDOFs;
-    else                     dofjac = new ImageType;
-    dofjac->Initialize(attr, 9);
-  }
-
   // Convert scaled displacements to voxel units
   ConvertToVoxelUnits3D<TReal> w2i(attr);
   ParallelForEachVoxel(attr, _InterimDisplacement, _InterimDisplacement, w2i);
 
-  // Do the squaring steps
-  int n = _NumberOfSquaringSteps;
+  // Do the squaring steps, where the displacements and their derivatives
+  // w.r.t. x are updated in the same pass and the result of each step is
+  // written to the workspace images which are then swapped with the input
+  // images of the next squaring step instead of copying the result
+  ImageType *&disp   = _SquaredDisplacement;
+  ImageType *&jac3x3 = _SquaredJacobian;
+  ImageType *&detjac = _SquaredDetJacobian;
+  ImageType *&logjac = _SquaredLogJacobian;
+  ImageType *&dofjac = _SquaredJacobianDOFs;
+
+  int n = _ActualNumberOfSquaringSteps;
   while (n--) {
     // (Re-)initialize interpolators
     _Displacement                   ->Initialize();
@@ -1052,57 +1144,70 @@ void irtkScalingAndSquaring<TReal>::Run()
     if (_LogJacobian ) _LogJacobian ->Initialize();
     if (_JacobianDOFs) _JacobianDOFs->Initialize();
     // Compute updates
-    {
-      UpdateDisplacement<DisplacementField> update(_Displacement);
-      ParallelForEachVoxel(attr, _InterimDisplacement, disp, update);
-    }
     switch (jac_mode) {
+      case 0: {
+        UpdateDisplacement<DisplacementField> update(_Displacement);
+        ParallelForEachVoxel(attr, _InterimDisplacement, disp, update);
+      } break;
       case 1: {
         UpdateJacobian<JacobianField> update;
-        update.Initialize(_Jacobian, NULL, NULL);
-        ParallelForEachVoxel(attr, _InterimDisplacement, _InterimJacobian, jac3x3, update);
+        update.Initialize(_Displacement, _Jacobian, NULL, NULL);
+        ParallelForEachVoxel(attr, _InterimDisplacement, _InterimJacobian, disp, jac3x3, update);
       } break;
       case 2: {
         UpdateDetJacobian<JacobianField> update;
-        update.Initialize(NULL, _DetJacobian, NULL);
-        ParallelForEachVoxel(attr, _InterimDisplacement, _InterimDetJacobian, detjac, update);
+        update.Initialize(_Displacement, NULL, _DetJacobian, NULL);
+        ParallelForEachVoxel(attr, _InterimDisplacement, _InterimDetJacobian, disp, detjac, update);
       } break;
       case 3: {
         UpdateJacobianAndDet<JacobianField> update;
-        update.Initialize(_Jacobian, _DetJacobian, NULL);
-        ParallelForEachVoxel(attr, _InterimDisplacement, _InterimJacobian, _InterimDetJacobian, jac3x3, detjac, update);
+        update.Initialize(_Displacement, _Jacobian, _DetJacobian, NULL);
+        ParallelForEachVoxel(attr, _InterimDisplacement, _InterimJacobian, _InterimDetJacobian, disp, jac3x3, detjac, update);
       } break;
       case 4: {
         UpdateLogJacobian<JacobianField> update;
-        update.Initialize(NULL, NULL, _LogJacobian);
-        ParallelForEachVoxel(attr, _InterimDisplacement, _InterimLogJacobian, logjac, update);
+        update.Initialize(_Displacement, NULL, NULL, _LogJacobian);
+        ParallelForEachVoxel(attr, _InterimDisplacement, _InterimLogJacobian, disp, logjac, update);
       } break;
       case 5: {
         UpdateJacobianAndLog<JacobianField> update;
-        update.Initialize(_Jacobian, NULL, _LogJacobian);
-        ParallelForEachVoxel(attr, _InterimDisplacement, _InterimJacobian, _InterimLogJacobian, jac3x3, logjac, update);
+        update.Initialize(_Displacement, _Jacobian, NULL, _LogJacobian);
+        ParallelForEachVoxel(attr, _InterimDisplacement, _InterimJacobian, _InterimLogJacobian, disp, jac3x3, logjac, update);
       } break;
       case 6: {
         UpdateDetJacobianAndLog<JacobianField> update;
-        update.Initialize(NULL, _DetJacobian, _LogJacobian);
-        ParallelForEachVoxel(attr, _InterimDisplacement, _InterimDetJacobian, _InterimLogJacobian, detjac, logjac, update);
+        update.Initialize(_Displacement, NULL, _DetJacobian, _LogJacobian);
+        ParallelForEachVoxel(attr, _InterimDisplacement, _InterimDetJacobian, _InterimLogJacobian, disp, detjac, logjac, update);
       } break;
       case 7: {
         UpdateJacobianAndDetAndLog<JacobianField> update;
-        update.Initialize(_Jacobian, _DetJacobian, _LogJacobian);
-        ParallelForEachVoxel(attr, _InterimDisplacement, _InterimJacobian, _InterimDetJacobian, _InterimLogJacobian, jac3x3, detjac, logjac, update);
+        update.Initialize(_Displacement, _Jacobian, _DetJacobian, _LogJacobian);
+        ParallelForEachVoxel(attr, _InterimDisplacement, _InterimJacobian, _InterimDetJacobian, _InterimLogJacobian, disp, jac3x3, detjac, logjac, update);
       } break;
     }
     if (_InterimJacobianDOFs) {
       UpdateJacobianDOFs<JacobianField> update(_Jacobian, _JacobianDOFs);
       ParallelForEachVoxel(attr, _InterimDisplacement, _InterimJacobianDOFs, dofjac, update);
     }
-    // Update intermediate output images
-    _InterimDisplacement                          ->CopyFrom(disp  ->Data());
-    if (_InterimJacobian    ) _InterimJacobian    ->CopyFrom(jac3x3->Data());
-    if (_InterimDetJacobian ) _InterimDetJacobian ->CopyFrom(detjac->Data());
-    if (_InterimLogJacobian ) _InterimLogJacobian ->CopyFrom(logjac->Data());
-    if (_InterimJacobianDOFs) _InterimJacobianDOFs->CopyFrom(dofjac->Data());
+    // Swap intermediate images and workspace
+    swap(_InterimDisplacement, disp);
+    _Displacement->Input(_InterimDisplacement);
+    if (_InterimJacobian) {
+      swap(_InterimJacobian, jac3x3);
+      _Jacobian->Input(_InterimJacobian);
+    }
+    if (_InterimDetJacobian) {
+      swap(_InterimDetJacobian, detjac);
+      _DetJacobian->Input(_InterimDetJacobian);
+    }
+    if (_InterimLogJacobian) {
+      swap(_InterimLogJacobian, logjac);
+      _LogJacobian->Input(_InterimLogJacobian);
+    }
+    if (_InterimJacobianDOFs) {
+      swap(_InterimJacobianDOFs, dofjac);
+      _JacobianDOFs->Input(_InterimJacobianDOFs);
+    }
   }
 
   // Convert final displacements back to world units if output requested
@@ -1111,13 +1216,6 @@ void irtkScalingAndSquaring<TReal>::Run()
     ParallelForEachVoxel(attr, _InterimDisplacement, _InterimDisplacement, i2w);
   }
 
-  // Do the final cleaning up
-  if (disp   != _OutputDisplacement) Delete(disp);
-  if (jac3x3 != _OutputJacobian    ) Delete(jac3x3);
-  if (detjac != _OutputDetJacobian ) Delete(detjac);
-  if (logjac != _OutputLogJacobian ) Delete(logjac);
-  if (dofjac != _OutputJacobianDOFs) Delete(dofjac);
-
   IRTK_DEBUG_TIMING(5, "squaring steps"
                           " (d="    << (_OutputDisplacement ? "on" : "off")
                        << ", J="    << (_OutputJacobian     ? "on" : "off")
@@ -0,0 +1,339 @@
+/* The Image Registration Toolkit (IRTK)
+ *
+ * Copyright 2008-2015 Imperial College London
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include <irtkSeparableConvolution.h>
+
+// =============================================================================
+// Construction/Destruction
+// =============================================================================
+
+// -----------------------------------------------------------------------------
+irtkSeparableConvolution::irtkSeparableConvolution(BoundaryMode boundary, bool norm)
+:
+  _Boundary  (boundary),
+  _Normalize (norm),
+  _Background(.0),
+  _Scale     (1.0),
+  _Factor    (1),
+  _Radius    (0),
+  _Symmetry  (0),
+  _RecursiveOrder(-1)
+{
+}
+
+// -----------------------------------------------------------------------------
+irtkSeparableConvolution::~irtkSeparableConvolution()
+{
+}
+
+// =============================================================================
+// Recursive filter
+// =============================================================================
+
+namespace irtkSeparableConvolutionUtils {
+
+
+// -----------------------------------------------------------------------------
+/// Compute feedforward coefficients of causal Deriche filter and their moments
+void DericheCoefficients(double sigma, double A1, double B1, double W1, double L1,
+                         double A2, double B2, double W2, double L2,
+                         double N[4], double &SN, double &DN, double &EN)
+{
+  const double S1 = sin(W1 / sigma), C1 = cos(W1 / sigma), E1 = exp(L1 / sigma);
+  const double S2 = sin(W2 / sigma), C2 = cos(W2 / sigma), E2 = exp(L2 / sigma);
+  N[0]  = A1 + A2;
+  N[1]  = E2 * (B2 * S2 - (A2 + 2.0 * A1) * C2);
+  N[1] += E1 * (B1 * S1 - (A1 + 2.0 * A2) * C1);
+  N[2]  = 2.0 * E1 * E2 * ((A1 + A2) * C2 * C1 - B1 * C2 * S1 - B2 * C1 * S2);
+  N[2] += A2 * E1 * E1 + A1 * E2 * E2;
+  N[3]  = E2 * E1 * E1 * (B2 * S2 - A2 * C2);
+  N[3] += E1 * E2 * E2 * (B1 * S1 - A1 * C1);
+  SN = N[0] + N[1] + N[2] + N[3];
+  DN = N[1] + 2.0 * N[2] + 3.0 * N[3];
+  EN = N[1] + 4.0 * N[2] + 9.0 * N[3];
+}
+
+
+} // namespace irtkSeparableConvolutionUtils
+using namespace irtkSeparableConvolutionUtils;
+
+// -----------------------------------------------------------------------------
+void irtkSeparableConvolution::RecursiveGaussian(double sigma, int order)
+{
+  if (sigma <= .0) {
+    cerr << this->NameOfClass() << "::RecursiveGaussian: Standard deviation must be positive" << endl;
+    exit(1);
+  }
+  if (order < 0 || order > 2) {
+    cerr << this->NameOfClass() << "::RecursiveGaussian: Order of derivative must be 0, 1, or 2" << endl;
+    exit(1);
+  }
+
+  // Parameters of fourth order approximation of Gaussian derivatives
+  const double A1[3] = { 1.3530, -0.6724, -1.3563 }, A2[3] = { -0.3531, 0.6724,  0.3446 };
+  const double B1[3] = { 1.8151, -3.4327,  5.2318 }, B2[3] = {  0.0902, 0.6100, -2.2355 };
+  const double W1 = 0.6681, L1 = -1.3932;
+  const double W2 = 2.0787, L2 = -1.3732;
+
+  // Feedback coefficients, which are the same for all orders
+  const double C1 = cos(W1 / sigma), E1 = exp(L1 / sigma);
+  const double C2 = cos(W2 / sigma), E2 = exp(L2 / sigma);
+  double *D = _RecursiveD;
+  D[0] = -2.0 * (E2 * C2 + E1 * C1);
+  D[1] =  4.0 * C2 * C1 * E1 * E2 + E1 * E1 + E2 * E2;
+  D[2] = -2.0 * C1 * E1 * E2 * E2 - 2.0 * C2 * E2 * E1 * E1;
+  D[3] = E1 * E1 * E2 * E2;
+  const double SD = 1.0 + D[0] + D[1] + D[2] + D[3];
+  const double DD = D[0] + 2.0 * D[1] + 3.0 * D[2] + 4.0 * D[3];
+  const double ED = D[0] + 4.0 * D[1] + 9.0 * D[2] + 16.0 * D[3];
+
+  // Feedforward coefficients normalized such that the filter response to
+  // x^order / order! is exactly one
+  double *N = _RecursiveN, SN, DN, EN, alpha;
+  switch (order) {
+    case 0: {
+      DericheCoefficients(sigma, A1[0], B1[0], W1, L1, A2[0], B2[0], W2, L2, N, SN, DN, EN);
+      alpha = 2.0 * SN / SD - N[0];
+    } break;
+    case 1: {
+      DericheCoefficients(sigma, A1[1], B1[1], W1, L1, A2[1], B2[1], W2, L2, N, SN, DN, EN);
+      alpha = 2.0 * (SN * DD - DN * SD) / (SD * SD);
+    } break;
+    default: {
+      double N0[4], SN0, DN0, EN0;
+      DericheCoefficients(sigma, A1[0], B1[0], W1, L1, A2[0], B2[0], W2, L2, N0, SN0, DN0, EN0);
+      DericheCoefficients(sigma, A1[2], B1[2], W1, L1, A2[2], B2[2], W2, L2, N,  SN,  DN,  EN);
+      // Remove response to constant function
+      const double beta = - (2.0 * SN - SD * N[0]) / (2.0 * SN0 - SD * N0[0]);
+      for (int i = 0; i < 4; ++i) N[i] += beta * N0[i];
+      SN += beta * SN0, DN += beta * DN0, EN += beta * EN0;
+      alpha  = EN * SD * SD - ED * SN * SD - 2.0 * DN * DD * SD + 2.0 * DD * DD * SN;
+      alpha /= SD * SD * SD;
+    } break;
+  }
+  for (int i = 0; i < 4; ++i) N[i] /= alpha;
+
+  // Anti-causal filter is mirrored causal filter, with opposite sign for odd order
+  const double sign = (order == 1 ? -1.0 : 1.0);
+  double *M = _RecursiveM;
+  M[0] = sign * (N[1] - D[0] * N[0]);
+  M[1] = sign * (N[2] - D[1] * N[0]);
+  M[2] = sign * (N[3] - D[2] * N[0]);
+  M[3] = sign * (     - D[3] * N[0]);
+
+  // Steady state output for constant input used as initial condition
+  _RecursiveB[0] = (N[0] + N[1] + N[2] + N[3]) / SD;
+  _RecursiveB[1] = (M[0] + M[1] + M[2] + M[3]) / SD;
+
+  _RecursiveOrder = order;
+  _Radius         = 0;
+  _Symmetry       = (order == 1 ? -1 : +1);
+  _Weights          .clear();
+  _CumulativeWeights.clear();
+}
+
+// -----------------------------------------------------------------------------
+void irtkSeparableConvolution::ConvolveRecursive(const double *in, int n, double *out, double *buf) const
+{
+  const double *N = _RecursiveN, *M = _RecursiveM, *D = _RecursiveD;
+  int i, k;
+
+  // Lines shorter than the order of the filter are extended by the values of
+  // the end points, which is consistent with the initial conditions below
+  if (n < 4) {
+    const int m = n + 8;
+    double *ext = buf, *res = buf + m;
+    for (i = 0; i < 4; ++i) ext[i] = in[0], ext[n + 4 + i] = in[n - 1];
+    memcpy(ext + 4, in, n * sizeof(double));
+    ConvolveRecursive(ext, m, res, res + m);
+    memcpy(out, res + 4, n * sizeof(double));
+    return;
+  }
+
+  // Causal filter, where the line is continued by its first value before
+  // the start, for which the filter output is in the steady state
+  const double yc = _RecursiveB[0] * in[0];
+  for (i = 0; i < 4; ++i) {
+    out[i] = .0;
+    for (k = 0; k < 4; ++k) {
+      out[i] += N[k] * in[max(i - k, 0)];
+      out[i] -= D[k] * (i - 1 - k >= 0 ? out[i - 1 - k] : yc);
+    }
+  }
+  for (i = 4; i < n; ++i) {
+    out[i] = N[0] * in[i    ] + N[1] * in[i - 1] + N[2] * in[i - 2] + N[3] * in[i - 3]
+           - D[0] * out[i - 1] - D[1] * out[i - 2] - D[2] * out[i - 3] - D[3] * out[i - 4];
+  }
+
+  // Anti-causal filter, where the line is continued by its last value
+  const double ya = _RecursiveB[1] * in[n - 1];
+  double *y = buf;
+  for (i = n - 1; i >= n - 4; --i) {
+    y[i] = .0;
+    for (k = 0; k < 4; ++k) {
+      y[i] += M[k] * in[min(i + 1 + k, n - 1)];
+      y[i] -= D[k] * (i + 1 + k < n ? y[i + 1 + k] : ya);
+    }
+  }
+  for (i = n - 5; i >= 0; --i) {
+    y[i] = M[0] * in[i + 1] + M[1] * in[i + 2] + M[2] * in[i + 3] + M[3] * in[i + 4]
+         - D[0] * y[i + 1] - D[1] * y[i + 2] - D[2] * y[i + 3] - D[3] * y[i + 4];
+  }
+
+  // Sum of causal and anti-causal filter outputs
+  for (i = 0; i < n; ++i) out[i] += y[i];
+}
+
+// =============================================================================
+// Convolution of single line
+// =============================================================================
+
+// -----------------------------------------------------------------------------
+int irtkSeparableConvolution::BufferSize(int n) const
+{
+  // Padded values and mask, convolved values and sum of weights,
+  // where the latter is scratch memory of the recursive filter
+  if (_RecursiveOrder >= 0) return 3 * n + 3 * (n + 8);
+  return 2 * (n + 2 * _Radius) + 2 * n;
+}
+
+// -----------------------------------------------------------------------------
+void irtkSeparableConvolution::Fold(const double *in, int n, double *out) const
+{
+  const double *w = &_Weights[_Radius];
+  int           i, t;
+  if (_Symmetry > 0) {
+    for (i = 0; i < n; ++i) out[i] = w[0] * in[i];
+    for (t = 1; t <= _Radius; ++t) {
+      const double c = w[t];
+      for (i = 0; i < n; ++i) out[i] += c * (in[i - t] + in[i + t]);
+    }
+  } else if (_Symmetry < 0) {
+    for (i = 0; i < n; ++i) out[i] = .0;
+    for (t = 1; t <= _Radius; ++t) {
+      const double c = w[t];
+      for (i = 0; i < n; ++i) out[i] += c * (in[i + t] - in[i - t]);
+    }
+  } else {
+    for (i = 0; i < n; ++i) out[i] = .0;
+    for (t = -_Radius; t <= _Radius; ++t) {
+      const double c = w[t];
+      for (i = 0; i < n; ++i) out[i] += c * in[i + t];
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+void irtkSeparableConvolution::ConvolveTruncated(const double *in, int i1, int i2,
+                                                 double *pad, double *acc) const
+{
+  const int r = _Radius, n = i2 - i1;
+  int       i;
+  // Copy run to buffer padded by zeros
+  for (i = i1 - r; i < i1;     ++i) pad[i] = .0;
+  for (i = i1;     i < i2;     ++i) pad[i] = in[i];
+  for (i = i2;     i < i2 + r; ++i) pad[i] = .0;
+  // Apply kernel
+  Fold(pad + i1, n, acc + i1);
+  // Normalize by sum of kernel weights which overlap the run, which is
+  // only different from the sum of all weights within the kernel radius
+  // of the end points of the run
+  if (_Normalize) {
+    const double *C = &_CumulativeWeights[r];
+    const double  s = C[r + 1] - C[-r];
+    for (i = 0; i < n; ++i) {
+      const double w = ((i < r || n - i <= r) ? C[min(r, n - 1 - i) + 1] - C[-min(r, i)] : s);
+      if (w != .0) acc[i1 + i] /= w;
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+void irtkSeparableConvolution::ConvolveLine(const double *in, int n, double *out, double *buf) const
+{
+  const int r = _Radius;
+  double   *pad = buf + r;
+  double   *msk = pad + n + 2 * r;
+  double   *acc = msk + n + r;
+  double   *sum = acc + n;
+  int       i, j;
+
+  switch (_Boundary) {
+
+    // Truncate kernel at image boundary, or extend image for recursive filter
+    case TruncateKernel: {
+      if (_RecursiveOrder >= 0) ConvolveRecursive(in, n, acc, sum);
+      else                      ConvolveTruncated(in, 0, n, pad, acc);
+      for (i = 0; i < n; ++i) acc[i] *= _Scale;
+    } break;
+
+    // Ignore background voxels, i.e., convolve product of image and mask
+    case IgnoreBackground: {
+      for (i = -r; i < 0; ++i) pad[i] = msk[i] = .0;
+      for (i =  0; i < n; ++i) {
+        if (in[i] > _Background) pad[i] = in[i], msk[i] = 1.0;
+        else                     pad[i] = msk[i] = .0;
+      }
+      for (i = n; i < n + r; ++i) pad[i] = msk[i] = .0;
+      Fold(pad, n, acc);
+      if (_Normalize) Fold(msk, n, sum);
+      for (i = 0; i < n; ++i) {
+        if (msk[i] == .0) {
+          acc[i] = _Background;
+        } else if (_Normalize) {
+          acc[i] = (sum[i] != .0 ? _Scale * acc[i] / sum[i] : _Background);
+        } else {
+          acc[i] *= _Scale;
+        }
+      }
+    } break;
+
+    // Truncate kernel at boundary of foreground runs
+    case TruncateForeground: {
+      for (i = 0; i < n; i = j + 1) {
+        for (j = i; j < n && in[j] != _Background; ++j);
+        if (j > i) {
+          ConvolveTruncated(in, i, j, pad, acc);
+          for (int k = i; k < j; ++k) acc[k] *= _Scale;
+        }
+        if (j < n) acc[j] = _Background;
+      }
+    } break;
+
+    // Replicate end points of foreground runs
+    case ExtendForeground: {
+      for (i = 0; i < n; i = j + 1) {
+        for (j = i; j < n && in[j] != _Background; ++j);
+        if (j > i) {
+          for (int k = i - r; k < i;     ++k) pad[k] = in[i];
+          for (int k = i;     k < j;     ++k) pad[k] = in[k];
+          for (int k = j;     k < j + r; ++k) pad[k] = in[j - 1];
+          Fold(pad + i, j - i, acc + i);
+          for (int k = i; k < j; ++k) acc[k] *= _Scale;
+        }
+        if (j < n) acc[j] = _Background;
+      }
+    } break;
+  }
+
+  // Output convolved voxels, possibly downsampled
+  if (_Factor > 1) {
+    const int m = Size(n);
+    for (i = 0, j = Offset(n); i < m; ++i, j += _Factor) out[i] = acc[j];
+  } else {
+    memcpy(out, acc, n * sizeof(double));
+  }
+}
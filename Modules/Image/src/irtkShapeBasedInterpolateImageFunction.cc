@@ -91,45 +91,27 @@ void irtkShapeBasedInterpolateImageFunction::Refine()
     if (sumcount > 0) {
       // Dmap _tinput to _dmap
       {
-        irtkRealImage inputA, inputB, outputA, outputB;
+        irtkRealImage input;
 
-        // Default mode
-        irtkEuclideanDistanceTransform<irtkRealPixel> *edt = new irtkEuclideanDistanceTransform<irtkRealPixel>(irtkEuclideanDistanceTransform<irtkRealPixel>::irtkDistanceTransform3D);
+        // Signed distance to object boundary in one run
+        irtkEuclideanDistanceTransform<irtkRealPixel> edt(irtkEuclideanDistanceTransform<irtkRealPixel>::irtkDistanceTransform3D);
+        edt.SignedDistance(true);
 
         // Threshold image
-        inputA = _tinput;
-        inputB = _tinput;
+        input = _tinput;
         for (t = 0; t < _tinput.GetT(); t++) {
           for (z = 0; z < _tinput.GetZ(); z++) {
             for (y = 0; y < _tinput.GetY(); y++) {
               for (x = 0; x < _tinput.GetX(); x++) {
-                if (_tinput(x, y, z, t) > 0.5) {
-                  inputA(x, y, z, t) = 1;
-                  inputB(x, y, z, t) = 0;
-                } else {
-                  inputA(x, y, z, t) = 0;
-                  inputB(x, y, z, t) = 1;
-                }
+                input(x, y, z, t) = (_tinput(x, y, z, t) > 0.5 ? 1 : 0);
               }
             }
           }
         }
 
-        edt->SetInput (& inputA);
-        edt->SetOutput(&outputA);
-        edt->Run();		  
-        edt->SetInput (& inputB);
-        edt->SetOutput(&outputB);
-        edt->Run();
-        for (t = 0 ; t < _tinput.GetT(); t++) {
-          for (z = 0; z < _tinput.GetZ(); z++) {
-            for (y = 0; y < _tinput.GetY(); y++) {
-              for (x = 0; x < _tinput.GetX(); x++) {
-                _dmap(x, y, z, t)  = sqrt(outputA(x, y, z, t)) - sqrt(outputB(x, y, z, t));
-              }
-            }
-          }
-        }
+        edt.SetInput (&input);
+        edt.SetOutput(&_dmap);
+        edt.Run();
       }
 
       // Linear Interpolate Dmap _dmap to _rdmap
@@ -328,46 +310,28 @@ void irtkShapeBasedInterpolateImageFunction::Initialize(bool coeff)
       labelcount ++;
       // Dmap _tinput to _dmap
       {
-        irtkRealImage inputA, inputB, outputA, outputB;
+        irtkRealImage input;
 
-        // Default mode
-        irtkEuclideanDistanceTransform<irtkRealPixel> *edt = new irtkEuclideanDistanceTransform<irtkRealPixel>(irtkEuclideanDistanceTransform<irtkRealPixel>::irtkDistanceTransform3D);
+        // Signed distance to object boundary in one run
+        irtkEuclideanDistanceTransform<irtkRealPixel> edt(irtkEuclideanDistanceTransform<irtkRealPixel>::irtkDistanceTransform3D);
+        edt.SignedDistance(true);
 
         // Threshold image
-        inputA = _tinput;
-        inputB = _tinput;
+        input = _tinput;
         for (t = 0; t < _tinput.GetT(); t++) {
           for (z = 0; z < _tinput.GetZ(); z++) {
             for (y = 0; y < _tinput.GetY(); y++) {
               for (x = 0; x < _tinput.GetX(); x++) {
-                if (_tinput(x, y, z, t) > 0.5) {
-                  inputA(x, y, z, t) = 1;
-                  inputB(x, y, z, t) = 0;
-                } else {
-                  inputA(x, y, z, t) = 0;
-                  inputB(x, y, z, t) = 1;
-                }
+                input(x, y, z, t) = (_tinput(x, y, z, t) > 0.5 ? 1 : 0);
               }
             }
           }
         }
 
         // Calculate EDT
-        edt->SetInput (& inputA);
-        edt->SetOutput(&outputA);
-        edt->Run();		  
-        edt->SetInput (& inputB);
-        edt->SetOutput(&outputB);
-        edt->Run();
-        for (t = 0 ; t < _tinput.GetT(); t++) {
-          for (z = 0; z < _tinput.GetZ(); z++) {
-            for (y = 0; y < _tinput.GetY(); y++) {
-              for (x = 0; x < _tinput.GetX(); x++) {
-                _dmap(x, y, z, t)  = sqrt(outputA(x, y, z, t)) - sqrt(outputB(x, y, z, t));
-              }
-            }
-          }
-        }
+        edt.SetInput (&input);
+        edt.SetOutput(&_dmap);
+        edt.Run();
       }
 
       // Linear Interpolate Dmap _dmap to _rdmap
@@ -0,0 +1,262 @@
+/* The Image Registration Toolkit (IRTK)
+ *
+ * Copyright 2008-2015 Imperial College London
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include <gtest/gtest.h>
+
+#include <irtkImage.h>
+#include <irtkConnectedComponents.h>
+#include <irtkLargestConnectedComponent.h>
+
+#include <queue>
+
+typedef irtkGenericImage<irtkGreyPixel> Image;
+
+// ===========================================================================
+// Auxiliary functions
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+/// Image with random voxels set to the given label
+Image RandomImage(int x, int y, int z, double fill, irtkGreyPixel label)
+{
+  Image image(x, y, z);
+  irtkGreyPixel *p = image.GetPointerToVoxels();
+  for (int idx = 0; idx < image.NumberOfVoxels(); ++idx, ++p) {
+    *p = (static_cast<double>(rand()) / RAND_MAX < fill ? label : 0);
+  }
+  return image;
+}
+
+// ---------------------------------------------------------------------------
+/// Whether two voxels at the given offset are neighbours
+bool IsNeighbour(int di, int dj, int dk, irtkConnectivityType connectivity, bool mode2D)
+{
+  if (mode2D && dk != 0) return false;
+  const int n = abs(di) + abs(dj) + abs(dk);
+  if (n == 0) return false;
+  switch (connectivity) {
+    case CONNECTIVITY_04: return n == 1 && dk == 0;
+    case CONNECTIVITY_06: return n == 1;
+    case CONNECTIVITY_18: return n <= 2;
+    case CONNECTIVITY_26: return true;
+  }
+  return false;
+}
+
+// ---------------------------------------------------------------------------
+/// Label components by flood filling from each unlabelled voxel in scan order
+///
+/// This grows the components like the former recursive implementation of
+/// irtkLargestConnectedComponent, but uses a queue to not overflow the stack.
+int FloodFill(const Image &image, irtkGreyPixel label, irtkConnectivityType connectivity,
+              bool mode2D, vector<int> &labels, vector<int> &sizes)
+{
+  const int nx = image.X(), ny = image.Y(), nz = image.Z();
+  if (connectivity == CONNECTIVITY_04) mode2D = true;
+  labels.assign(image.NumberOfVoxels(), 0);
+  sizes.clear();
+  for (int idx = 0; idx < image.NumberOfVoxels(); ++idx) {
+    if (image(idx) != label || labels[idx] != 0) continue;
+    sizes.push_back(0);
+    const int n = static_cast<int>(sizes.size());
+    queue<int> active;
+    labels[idx] = n;
+    active.push(idx);
+    while (!active.empty()) {
+      const int cur = active.front();
+      active.pop();
+      ++sizes.back();
+      const int i = cur % nx, j = (cur / nx) % ny, k = cur / (nx * ny);
+      for (int dk = -1; dk <= 1; ++dk)
+      for (int dj = -1; dj <= 1; ++dj)
+      for (int di = -1; di <= 1; ++di) {
+        if (!IsNeighbour(di, dj, dk, connectivity, mode2D)) continue;
+        const int a = i + di, b = j + dj, c = k + dk;
+        if (a < 0 || a >= nx || b < 0 || b >= ny || c < 0 || c >= nz) continue;
+        const int nbr = image.VoxelToIndex(a, b, c);
+        if (image(nbr) == label && labels[nbr] == 0) {
+          labels[nbr] = n;
+          active.push(nbr);
+        }
+      }
+    }
+  }
+  return static_cast<int>(sizes.size());
+}
+
+// ---------------------------------------------------------------------------
+/// Compare union-find labelling with flood fill labelling
+void TestComponents(const Image &image, irtkGreyPixel label,
+                    irtkConnectivityType connectivity, bool mode2D)
+{
+  vector<int> labels, sizes;
+  const int n = FloodFill(image, label, connectivity, mode2D, labels, sizes);
+  irtkConnectedComponents<irtkGreyPixel> components(label, connectivity);
+  components.Input(&image);
+  components.Mode2D(mode2D);
+  components.Run();
+  ASSERT_EQ(n, components.NumberOfComponents())
+      << "connectivity=" << connectivity << ", mode2D=" << mode2D;
+  // Components are numbered in order of their first voxel in both cases
+  for (int i = 0; i < n; ++i) {
+    ASSERT_EQ(sizes[i], components.ComponentSize(i + 1)) << "component " << i + 1;
+  }
+  const vector<int> &result = components.Labels();
+  ASSERT_EQ(labels.size(), result.size());
+  for (size_t idx = 0; idx < labels.size(); ++idx) {
+    ASSERT_EQ(labels[idx], result[idx]) << "voxel " << idx;
+  }
+}
+
+// ---------------------------------------------------------------------------
+/// Compare largest component with flood fill result
+void TestLargestComponent(const Image &image, irtkGreyPixel label,
+                          irtkConnectivityType connectivity, bool mode2D)
+{
+  Image input(image), output;
+  irtkLargestConnectedComponent<irtkGreyPixel> filter(label);
+  filter.SetConnectivity(connectivity);
+  filter.SetMode2D(mode2D);
+  filter.SetInput (&input);
+  filter.SetOutput(&output);
+  filter.Run();
+
+  vector<int> labels, sizes;
+  FloodFill(image, label, connectivity, mode2D, labels, sizes);
+  const int nxy = image.X() * image.Y();
+  const int nz  = (mode2D ? image.Z() : 1);
+  const int n   = (mode2D ? nxy : image.NumberOfVoxels());
+  for (int z = 0; z < nz; ++z) {
+    // First component in scan order with the most voxels
+    int largest = 0;
+    for (int idx = z * n; idx < (z + 1) * n; ++idx) {
+      if (labels[idx] > 0 && (largest == 0 || sizes[labels[idx] - 1] > sizes[largest - 1])) {
+        largest = labels[idx];
+      }
+    }
+    for (int idx = z * n; idx < (z + 1) * n; ++idx) {
+      const int expected = (largest > 0 && labels[idx] == largest ? 1 : 0);
+      ASSERT_EQ(expected, output(idx)) << "voxel " << idx << ", mode2D=" << mode2D;
+    }
+  }
+}
+
+// ===========================================================================
+// Tests
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+TEST(irtkConnectedComponents, Connectivity3D)
+{
+  srand(42);
+  const Image image = RandomImage(37, 29, 23, .3, 1);
+  TestComponents(image, 1, CONNECTIVITY_06, false);
+  TestComponents(image, 1, CONNECTIVITY_18, false);
+  TestComponents(image, 1, CONNECTIVITY_26, false);
+}
+
+// ---------------------------------------------------------------------------
+TEST(irtkConnectedComponents, Connectivity2D)
+{
+  srand(42);
+  const Image image = RandomImage(37, 29, 23, .4, 1);
+  TestComponents(image, 1, CONNECTIVITY_04, false);
+  TestComponents(image, 1, CONNECTIVITY_06, true);
+  TestComponents(image, 1, CONNECTIVITY_26, true);
+}
+
+// ---------------------------------------------------------------------------
+TEST(irtkConnectedComponents, ComponentLabel)
+{
+  srand(42);
+  Image image = RandomImage(31, 27, 19, .6, 3);
+  for (int idx = 0; idx < image.NumberOfVoxels(); ++idx) {
+    if (image(idx) != 0 && rand() % 4 == 0) image(idx) = 5;
+  }
+  TestComponents(image, 3, CONNECTIVITY_06, false);
+  TestComponents(image, 5, CONNECTIVITY_26, false);
+  TestComponents(image, 0, CONNECTIVITY_06, false);
+}
+
+// ---------------------------------------------------------------------------
+TEST(irtkConnectedComponents, SingleLargeComponent)
+{
+  // Component of this size overflowed the stack of the recursive growing
+  Image image(128, 128, 128);
+  image = 1;
+  irtkConnectedComponents<irtkGreyPixel> components(1, CONNECTIVITY_06);
+  components.Input(&image);
+  components.Run();
+  ASSERT_EQ(1, components.NumberOfComponents());
+  EXPECT_EQ(image.NumberOfVoxels(), components.ComponentSize(1));
+}
+
+// ---------------------------------------------------------------------------
+TEST(irtkLargestConnectedComponent, Mode3D)
+{
+  srand(42);
+  const Image image = RandomImage(37, 29, 23, .3, 1);
+  TestLargestComponent(image, 1, CONNECTIVITY_06, false);
+  TestLargestComponent(image, 1, CONNECTIVITY_26, false);
+}
+
+// ---------------------------------------------------------------------------
+TEST(irtkLargestConnectedComponent, Mode2D)
+{
+  srand(42);
+  const Image image = RandomImage(37, 29, 23, .4, 1);
+  TestLargestComponent(image, 1, CONNECTIVITY_06, true);
+  TestLargestComponent(image, 1, CONNECTIVITY_18, true);
+}
+
+// ---------------------------------------------------------------------------
+TEST(irtkLargestConnectedComponent, Mode2DPerSlice)
+{
+  // Largest component of second slice is smaller than that of the first
+  Image image(8, 6, 3);
+  for (int i = 0; i < 8; ++i) image(i, 0, 0) = image(i, 1, 0) = 1;
+  for (int i = 0; i < 3; ++i) image(i, 2, 1) = image(i, 3, 1) = 1;
+  image(6, 5, 0) = 1;
+  image(6, 5, 1) = image(7, 5, 1) = 1;
+
+  Image input(image), output;
+  irtkLargestConnectedComponent<irtkGreyPixel> filter(1);
+  filter.SetConnectivity(CONNECTIVITY_06);
+  filter.SetMode2D(true);
+  filter.SetInput (&input);
+  filter.SetOutput(&output);
+  filter.Run();
+
+  for (int k = 0; k < image.Z(); ++k)
+  for (int j = 0; j < image.Y(); ++j)
+  for (int i = 0; i < image.X(); ++i) {
+    int expected = 0;
+    if (k == 0 && j <= 1)                      expected = 1;
+    if (k == 1 && (j == 2 || j == 3) && i < 3) expected = 1;
+    EXPECT_EQ(expected, output(i, j, k)) << "voxel (" << i << ", " << j << ", " << k << ")";
+  }
+}
+
+// ===========================================================================
+// Main
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
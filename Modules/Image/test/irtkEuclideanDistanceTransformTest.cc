@@ -0,0 +1,177 @@
+/* The Image Registration Toolkit (IRTK)
+ *
+ * Copyright 2008-2015 Imperial College London
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include <gtest/gtest.h>
+
+#include <irtkImage.h>
+#include <irtkEuclideanDistanceTransform.h>
+
+#include <thread>
+
+// Squared distances are computed with single precision scratch memory
+static const double tol = 1e-5;
+
+typedef irtkEuclideanDistanceTransform<double> EDT;
+
+// ===========================================================================
+// Auxiliary functions
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+/// Binary image with a few random object voxels and one larger box
+irtkGenericImage<double> RandomObject(int x, int y, int z, double dx, double dy, double dz)
+{
+  irtkImageAttributes attr;
+  attr._x  = x,  attr._y  = y,  attr._z  = z;
+  attr._dx = dx, attr._dy = dy, attr._dz = dz;
+  irtkGenericImage<double> image(attr);
+  for (int n = 0; n < 6; ++n) image(rand() % x, rand() % y, rand() % z) = 1.0;
+  for (int k = z / 4; k < z / 2; ++k)
+  for (int j = y / 3; j < y / 2; ++j)
+  for (int i = x / 4; i < x / 2; ++i) {
+    image(i, j, k) = 1.0;
+  }
+  return image;
+}
+
+// ---------------------------------------------------------------------------
+/// Brute force squared distance in mm of each voxel to the nearest voxel
+/// whose value differs from zero if inside is false, or is zero otherwise
+irtkGenericImage<double> BruteForce(const irtkGenericImage<double> &image, bool inside, bool edt3D)
+{
+  double dx, dy, dz;
+  image.GetPixelSize(&dx, &dy, &dz);
+  irtkGenericImage<double> output(image.Attributes());
+  for (int k = 0; k < image.Z(); ++k)
+  for (int j = 0; j < image.Y(); ++j)
+  for (int i = 0; i < image.X(); ++i) {
+    double d2, min_d2 = numeric_limits<double>::infinity();
+    for (int c = (edt3D ? 0 : k); c < (edt3D ? image.Z() : k + 1); ++c)
+    for (int b = 0; b < image.Y(); ++b)
+    for (int a = 0; a < image.X(); ++a) {
+      if ((image(a, b, c) != .0) != inside) {
+        d2 = pow((a - i) * dx, 2) + pow((b - j) * dy, 2) + pow((c - k) * dz, 2);
+        if (d2 < min_d2) min_d2 = d2;
+      }
+    }
+    output(i, j, k) = min_d2;
+  }
+  return output;
+}
+
+// ---------------------------------------------------------------------------
+/// Run distance transform filter
+irtkGenericImage<double> Transform(irtkGenericImage<double> &image, bool sgn, bool edt3D)
+{
+  irtkGenericImage<double> output;
+  EDT edt(edt3D ? EDT::irtkDistanceTransform3D : EDT::irtkDistanceTransform2D);
+  edt.SignedDistance(sgn);
+  edt.SetInput (&image);
+  edt.SetOutput(&output);
+  edt.Run();
+  return output;
+}
+
+// ---------------------------------------------------------------------------
+/// Compare squared distances with brute force distances
+void TestSquaredDistance(irtkGenericImage<double> image, bool edt3D)
+{
+  irtkGenericImage<double> expected = BruteForce(image, false, edt3D);
+  irtkGenericImage<double> output   = Transform(image, false, edt3D);
+  for (int idx = 0; idx < image.NumberOfVoxels(); ++idx) {
+    ASSERT_NEAR(expected(idx), output(idx), tol * max(1.0, expected(idx))) << "voxel " << idx;
+  }
+}
+
+// ---------------------------------------------------------------------------
+/// Compare signed distances with brute force distances
+void TestSignedDistance(irtkGenericImage<double> image, bool edt3D)
+{
+  irtkGenericImage<double> outside = BruteForce(image, false, edt3D);
+  irtkGenericImage<double> inside  = BruteForce(image, true,  edt3D);
+  irtkGenericImage<double> output  = Transform(image, true, edt3D);
+  for (int idx = 0; idx < image.NumberOfVoxels(); ++idx) {
+    const double expected = sqrt(outside(idx)) - sqrt(inside(idx));
+    ASSERT_NEAR(expected, output(idx), tol * max(1.0, fabs(expected))) << "voxel " << idx;
+  }
+}
+
+// ===========================================================================
+// Tests
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+TEST(irtkEuclideanDistanceTransform, Isotropic3D)
+{
+  srand(42);
+  TestSquaredDistance(RandomObject(21, 17, 13, 1.0, 1.0, 1.0), true);
+}
+
+// ---------------------------------------------------------------------------
+TEST(irtkEuclideanDistanceTransform, Anisotropic3D)
+{
+  srand(42);
+  TestSquaredDistance(RandomObject(21, 17, 13, 0.8, 1.2, 2.5), true);
+}
+
+// ---------------------------------------------------------------------------
+TEST(irtkEuclideanDistanceTransform, Anisotropic2D)
+{
+  srand(42);
+  TestSquaredDistance(RandomObject(21, 17, 5, 0.8, 1.2, 2.5), false);
+}
+
+// ---------------------------------------------------------------------------
+TEST(irtkEuclideanDistanceTransform, SignedDistance)
+{
+  srand(42);
+  TestSignedDistance(RandomObject(21, 17, 13, 0.8, 1.2, 2.5), true);
+  TestSignedDistance(RandomObject(21, 17, 5,  0.8, 1.2, 2.5), false);
+}
+
+// ---------------------------------------------------------------------------
+TEST(irtkEuclideanDistanceTransform, Concurrent)
+{
+  // Distance transforms of different images run at the same time
+  srand(42);
+  const int n = 4;
+  irtkGenericImage<double> image[n], output[n];
+  for (int i = 0; i < n; ++i) image[i] = RandomObject(40, 36, 32, 1.0, 1.0, 1.0);
+  vector<std::thread> threads;
+  for (int i = 0; i < n; ++i) {
+    threads.push_back(std::thread([&image, &output, i]() {
+      output[i] = Transform(image[i], false, true);
+    }));
+  }
+  for (int i = 0; i < n; ++i) threads[i].join();
+  for (int i = 0; i < n; ++i) {
+    irtkGenericImage<double> expected = Transform(image[i], false, true);
+    for (int idx = 0; idx < expected.NumberOfVoxels(); ++idx) {
+      ASSERT_EQ(expected(idx), output[i](idx)) << "image " << i << ", voxel " << idx;
+    }
+  }
+}
+
+// ===========================================================================
+// Main
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
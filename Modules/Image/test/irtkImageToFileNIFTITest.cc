@@ -0,0 +1,105 @@
+/* The Image Registration Toolkit (IRTK)
+ *
+ * Copyright 2008-2015 Imperial College London
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include <gtest/gtest.h>
+
+#include <irtkImage.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+// ===========================================================================
+// Auxiliary functions
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+/// Image with random intensities which spans several compressed blocks
+irtkGenericImage<float> RandomImage()
+{
+  irtkImageAttributes attr;
+  attr._x  = 97,  attr._y  = 83,  attr._z  = 61;
+  attr._dx = 1.2, attr._dy = 0.9, attr._dz = 2.5;
+  attr._xorigin = 3.0, attr._yorigin = -7.5, attr._zorigin = 11.0;
+  irtkGenericImage<float> image(attr);
+  float *p = image.GetPointerToVoxels();
+  for (int idx = 0; idx < image.NumberOfVoxels(); ++idx, ++p) {
+    *p = static_cast<float>(rand()) / RAND_MAX;
+  }
+  return image;
+}
+
+// ---------------------------------------------------------------------------
+/// Read entire file
+string ReadFile(const char *name)
+{
+  ifstream is(name, ios::binary);
+  return string(istreambuf_iterator<char>(is), istreambuf_iterator<char>());
+}
+
+// ---------------------------------------------------------------------------
+/// Compare image attributes and voxel values
+void ExpectEqual(const irtkGenericImage<float> &expected, const irtkGenericImage<float> &image)
+{
+  ASSERT_TRUE(expected.GetImageAttributes() == image.GetImageAttributes());
+  const float *p = expected.GetPointerToVoxels();
+  const float *q = image   .GetPointerToVoxels();
+  int ndiff = 0;
+  for (int idx = 0; idx < expected.NumberOfVoxels(); ++idx, ++p, ++q) {
+    if (*p != *q) ++ndiff;
+  }
+  EXPECT_EQ(0, ndiff) << "number of voxels with different value";
+}
+
+// ===========================================================================
+// Tests
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+TEST(irtkImageToFileNIFTI, ParallelCompression)
+{
+  srand(42);
+  const char *nii_gz  = "irtkImageToFileNIFTITest.nii.gz";
+  const char *gunzip  = "irtkImageToFileNIFTITest_gunzip.nii";
+  const char *nii     = "irtkImageToFileNIFTITest.nii";
+  irtkGenericImage<float> image = RandomImage();
+  image.Write(nii_gz);
+  image.Write(nii);
+  // Read compressed file
+  irtkGenericImage<float> output(nii_gz);
+  ExpectEqual(image, output);
+  // Decompress with plain gzip
+  const string cmd = string("gzip -dc ") + nii_gz + " > " + gunzip;
+  ASSERT_EQ(0, system(cmd.c_str()));
+  output.Read(gunzip);
+  ExpectEqual(image, output);
+  // Decompressed file is identical to the one written by nifti_image_write
+  EXPECT_TRUE(ReadFile(gunzip) == ReadFile(nii));
+  remove(nii_gz);
+  remove(gunzip);
+  remove(nii);
+}
+
+// ===========================================================================
+// Main
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,192 @@
+/* The Image Registration Toolkit (IRTK)
+ *
+ * Copyright 2008-2015 Imperial College London
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include <gtest/gtest.h>
+
+#include <irtkImage.h>
+#include <irtkMedianFilter.h>
+
+// ===========================================================================
+// Auxiliary functions
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+/// Image with random intensities in [0, max]
+template <class VoxelType>
+irtkGenericImage<VoxelType> RandomImage(int x, int y, int z, int t, double max)
+{
+  irtkGenericImage<VoxelType> image(x, y, z, t);
+  VoxelType *p = image.GetPointerToVoxels();
+  for (int idx = 0; idx < image.NumberOfVoxels(); ++idx, ++p) {
+    *p = static_cast<VoxelType>(max * rand() / RAND_MAX);
+  }
+  return image;
+}
+
+// ---------------------------------------------------------------------------
+/// Random mask with about 3/4 of the voxels inside
+irtkRealImage RandomMask(int x, int y, int z)
+{
+  irtkRealImage mask(x, y, z);
+  irtkRealPixel *p = mask.GetPointerToVoxels();
+  for (int idx = 0; idx < mask.NumberOfVoxels(); ++idx, ++p) {
+    *p = (rand() % 4 != 0 ? 1.0 : .0);
+  }
+  return mask;
+}
+
+// ---------------------------------------------------------------------------
+/// Sort-based median of the clipped neighbourhood of each voxel
+template <class VoxelType>
+irtkGenericImage<VoxelType> SortMedian(const irtkGenericImage<VoxelType> &image,
+                                       int radius, const irtkRealImage *mask = NULL)
+{
+  irtkGenericImage<VoxelType> output(image);
+  vector<VoxelType> samples;
+  for (int t = 0; t < image.GetT(); ++t)
+  for (int k = 0; k < image.GetZ(); ++k)
+  for (int j = 0; j < image.GetY(); ++j)
+  for (int i = 0; i < image.GetX(); ++i) {
+    if (mask && mask->Get(i, j, k) == .0) continue;
+    samples.clear();
+    for (int z = max(0, k - radius); z <= min(image.GetZ() - 1, k + radius); ++z)
+    for (int y = max(0, j - radius); y <= min(image.GetY() - 1, j + radius); ++y)
+    for (int x = max(0, i - radius); x <= min(image.GetX() - 1, i + radius); ++x) {
+      if (!mask || mask->Get(x, y, z) != .0) samples.push_back(image(x, y, z, t));
+    }
+    sort(samples.begin(), samples.end());
+    output(i, j, k, t) = samples[samples.size() / 2];
+  }
+  return output;
+}
+
+// ---------------------------------------------------------------------------
+/// Compare output of irtkMedianFilter with sort-based median
+template <class VoxelType>
+void TestMedianFilter(irtkGenericImage<VoxelType> image, int radius, irtkRealImage *mask = NULL)
+{
+  irtkGenericImage<VoxelType> expected = SortMedian(image, radius, mask);
+  irtkGenericImage<VoxelType> output;
+  irtkMedianFilter<VoxelType> filter;
+  filter.SetInput (&image);
+  filter.SetOutput(&output);
+  filter.SetkernelRadius(radius);
+  if (mask) filter.SetMask(mask);
+  filter.Run();
+  ASSERT_EQ(expected.NumberOfVoxels(), output.NumberOfVoxels());
+  int ndiff = 0;
+  const VoxelType *p = expected.GetPointerToVoxels();
+  const VoxelType *q = output  .GetPointerToVoxels();
+  for (int idx = 0; idx < expected.NumberOfVoxels(); ++idx, ++p, ++q) {
+    if (*p != *q) ++ndiff;
+  }
+  EXPECT_EQ(0, ndiff) << "number of voxels which differ from sort-based median"
+                      << " (radius=" << radius << ", mask=" << (mask ? "yes" : "no") << ")";
+}
+
+// ===========================================================================
+// Tests
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+TEST(irtkMedianFilter, BytePixel)
+{
+  srand(42);
+  irtkGenericImage<irtkBytePixel> image = RandomImage<irtkBytePixel>(23, 19, 11, 1, 255);
+  irtkRealImage                   mask  = RandomMask(23, 19, 11);
+  for (int r = 1; r <= 3; ++r) {
+    TestMedianFilter(image, r);
+    TestMedianFilter(image, r, &mask);
+  }
+}
+
+// ---------------------------------------------------------------------------
+TEST(irtkMedianFilter, GreyPixel)
+{
+  srand(42);
+  irtkGenericImage<irtkGreyPixel> image = RandomImage<irtkGreyPixel>(21, 17, 9, 2, 4000);
+  irtkRealImage                   mask  = RandomMask(21, 17, 9);
+  for (int r = 1; r <= 3; ++r) {
+    TestMedianFilter(image, r);
+    TestMedianFilter(image, r, &mask);
+  }
+}
+
+// ---------------------------------------------------------------------------
+TEST(irtkMedianFilter, GreyPixelLargeRange)
+{
+  // Intensity range for which the histograms of all image columns would take
+  // up too much memory, such that ranks are counted in a binary indexed tree
+  srand(42);
+  irtkGenericImage<irtkGreyPixel> image = RandomImage<irtkGreyPixel>(131, 13, 7, 1, 32000);
+  irtkRealImage                   mask  = RandomMask(131, 13, 7);
+  image(0, 0, 0) = -28000;
+  for (int r = 1; r <= 3; ++r) {
+    TestMedianFilter(image, r);
+    TestMedianFilter(image, r, &mask);
+  }
+}
+
+// ---------------------------------------------------------------------------
+TEST(irtkMedianFilter, RealPixelFewValues)
+{
+  srand(42);
+  irtkGenericImage<irtkRealPixel> image = RandomImage<irtkRealPixel>(21, 17, 9, 1, 100);
+  irtkRealImage                   mask  = RandomMask(21, 17, 9);
+  for (int r = 1; r <= 3; ++r) {
+    TestMedianFilter(image, r);
+    TestMedianFilter(image, r, &mask);
+  }
+}
+
+// ---------------------------------------------------------------------------
+TEST(irtkMedianFilter, RealPixelManyValues)
+{
+  // More distinct values than MaxNumberOfBins, where small neighbourhoods are
+  // filtered by selection and larger ones using ranks of subsets of slices
+  srand(42);
+  const int x = 48, y = 44, z = 36;
+  ASSERT_GT(x * y * z, irtkMedianFilter<irtkRealPixel>::MaxNumberOfBins);
+  irtkGenericImage<irtkRealPixel> image = RandomImage<irtkRealPixel>(x, y, z, 1, 1.0);
+  irtkRealImage                   mask  = RandomMask(x, y, z);
+  for (int r = 1; r <= 4; ++r) {
+    TestMedianFilter(image, r);
+    TestMedianFilter(image, r, &mask);
+  }
+}
+
+// ---------------------------------------------------------------------------
+TEST(irtkMedianFilter, RealPixelManyValues4D)
+{
+  srand(42);
+  irtkGenericImage<irtkRealPixel> image = RandomImage<irtkRealPixel>(19, 15, 7, 3, 1.0);
+  irtkRealImage                   mask  = RandomMask(19, 15, 7);
+  for (int r = 1; r <= 4; ++r) {
+    TestMedianFilter(image, r);
+    TestMedianFilter(image, r, &mask);
+  }
+}
+
+// ===========================================================================
+// Main
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
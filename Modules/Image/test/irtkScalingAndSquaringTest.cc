@@ -0,0 +1,292 @@
+/* The Image Registration Toolkit (IRTK)
+ *
+ * Copyright 2008-2015 Imperial College London
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include <gtest/gtest.h>
+
+#include <irtkImage.h>
+#include <irtkScalingAndSquaring.h>
+#include <irtkInterpolateImageFunction.hxx>
+
+// Only the order of floating point operations differs from the reference
+static const double tol = 1e-9;
+
+typedef irtkGenericImage<double>                       ImageType;
+typedef irtkScalingAndSquaring<double>                 FilterType;
+typedef irtkGenericInterpolateImageFunction<ImageType> InterpolatorType;
+
+// ===========================================================================
+// Auxiliary functions
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+/// Attributes of anisotropic test domain
+irtkImageAttributes Domain(int x, int y, int z)
+{
+  irtkImageAttributes attr;
+  attr._x  = x,   attr._y  = y,   attr._z  = z;
+  attr._dx = 1.2, attr._dy = 0.9, attr._dz = 1.5;
+  return attr;
+}
+
+// ---------------------------------------------------------------------------
+/// Smooth random velocity field
+ImageType RandomVelocity(const irtkImageAttributes &attr, double s)
+{
+  ImageType v(attr, 3);
+  double p[3][3];
+  for (int c = 0; c < 3; ++c)
+  for (int d = 0; d < 3; ++d) {
+    p[c][d] = 2.0 * M_PI * rand() / RAND_MAX;
+  }
+  for (int c = 0; c < 3; ++c)
+  for (int k = 0; k < attr._z; ++k)
+  for (int j = 0; j < attr._y; ++j)
+  for (int i = 0; i < attr._x; ++i) {
+    v(i, j, k, c) = s * sin(.3 * i + p[c][0]) * cos(.25 * j + p[c][1]) * sin(.2 * k + p[c][2]);
+  }
+  return v;
+}
+
+// ---------------------------------------------------------------------------
+/// Run scaling and squaring filter
+void Exponentiate(FilterType &filter, const ImageType &v, double T, int n,
+                  ImageType *d, ImageType *jac, ImageType *dj, ImageType *lj)
+{
+  filter.InputVelocity        (&v);
+  filter.OutputAttributes     (v.Attributes());
+  filter.InterimAttributes    (v.Attributes());
+  filter.IntegrationLimit     (T);
+  filter.NumberOfSteps        (n > 0 ? 0 : 1);
+  filter.NumberOfSquaringSteps(n);
+  filter.MaxScaledVelocity    (.0);
+  filter.Interpolation        (Interpolation_Linear);
+  filter.Upsample             (false);
+  filter.OutputDisplacement   (d);
+  filter.OutputJacobian       (jac);
+  filter.OutputDetJacobian    (dj);
+  filter.OutputLogJacobian    (lj);
+  filter.ComputeInterpolationCoefficients(false);
+  filter.Run();
+}
+
+// ---------------------------------------------------------------------------
+/// Scaling and squaring as implemented before the displacement and Jacobian
+/// updates were fused, where each squaring step first updates the
+/// displacements and then the derivatives in a separate pass
+///
+/// The scaled velocities and their derivatives are obtained by the filter
+/// itself without squaring step, i.e., only the squaring steps are redone.
+/// The log of the determinant is updated using the determinant, as done when
+/// both are requested, and by interpolating the log itself, which is stored
+/// in lo and is the output of the filter when the determinant is not requested.
+void PerStepExponentiate(const ImageType &v, double T, int n,
+                         ImageType &d, ImageType &jac, ImageType &dj, ImageType &lj,
+                         ImageType &lo)
+{
+  const irtkImageAttributes &attr = v.Attributes();
+  {
+    FilterType scaling;
+    Exponentiate(scaling, v, T / pow(2.0, n), 0, &d, &jac, &dj, &lj);
+  }
+  lo = lj;
+  // Convert scaled displacements to voxel units
+  for (int k = 0; k < attr._z; ++k)
+  for (int j = 0; j < attr._y; ++j)
+  for (int i = 0; i < attr._x; ++i) {
+    double x = i, y = j, z = k;
+    attr.LatticeToWorld(x, y, z);
+    x += d(i, j, k, 0), y += d(i, j, k, 1), z += d(i, j, k, 2);
+    attr.WorldToLattice(x, y, z);
+    d(i, j, k, 0) = x - i, d(i, j, k, 1) = y - j, d(i, j, k, 2) = z - k;
+  }
+  // Squaring steps
+  ImageType d2(d), jac2(jac), dj2(dj), lj2(lj), lo2(lo);
+  for (int s = 0; s < n; ++s) {
+    InterpolatorType *fd   = InterpolatorType::New(Interpolation_Linear, Extrapolation_NN, &d);
+    InterpolatorType *fjac = InterpolatorType::New(Interpolation_Linear, Extrapolation_NN, &jac);
+    InterpolatorType *fdj  = InterpolatorType::New(Interpolation_Linear, Extrapolation_NN, &dj);
+    InterpolatorType *flo  = InterpolatorType::New(Interpolation_Linear, Extrapolation_NN, &lo);
+    fd->Initialize(), fjac->Initialize(), fdj->Initialize(), flo->Initialize();
+    // Update displacements
+    for (int k = 0; k < attr._z; ++k)
+    for (int j = 0; j < attr._y; ++j)
+    for (int i = 0; i < attr._x; ++i) {
+      double u[3] = {.0, .0, .0};
+      fd->Evaluate(u, i + d(i, j, k, 0), j + d(i, j, k, 1), k + d(i, j, k, 2));
+      for (int c = 0; c < 3; ++c) d2(i, j, k, c) = d(i, j, k, c) + u[c];
+    }
+    // Update derivatives
+    for (int k = 0; k < attr._z; ++k)
+    for (int j = 0; j < attr._y; ++j)
+    for (int i = 0; i < attr._x; ++i) {
+      const double x = i + d(i, j, k, 0);
+      const double y = j + d(i, j, k, 1);
+      const double z = k + d(i, j, k, 2);
+      if (fjac->IsInside(x, y, z)) {
+        double J[9];
+        fjac->EvaluateInside(J, x, y, z);
+        for (int r = 0; r < 3; ++r)
+        for (int c = 0; c < 3; ++c) {
+          jac2(i, j, k, 3 * r + c) = J[3 * r    ] * jac(i, j, k,     c)
+                                   + J[3 * r + 1] * jac(i, j, k, 3 + c)
+                                   + J[3 * r + 2] * jac(i, j, k, 6 + c);
+        }
+      } else {
+        for (int c = 0; c < 9; ++c) jac2(i, j, k, c) = jac(i, j, k, c);
+      }
+      if (fdj->IsInside(x, y, z)) {
+        lj2(i, j, k) = lj(i, j, k) + log(max(.0001, fdj->EvaluateInside(x, y, z)));
+        dj2(i, j, k) = exp(lj2(i, j, k));
+      } else {
+        lj2(i, j, k) = lj(i, j, k);
+        dj2(i, j, k) = dj(i, j, k);
+      }
+      if (flo->IsInside(x, y, z)) {
+        lo2(i, j, k) = lo(i, j, k) + max(-4.0, flo->EvaluateInside(x, y, z));
+      } else {
+        lo2(i, j, k) = lo(i, j, k);
+      }
+    }
+    delete fd, delete fjac, delete fdj, delete flo;
+    d = d2, jac = jac2, dj = dj2, lj = lj2, lo = lo2;
+  }
+  // Convert displacements back to world units
+  for (int k = 0; k < attr._z; ++k)
+  for (int j = 0; j < attr._y; ++j)
+  for (int i = 0; i < attr._x; ++i) {
+    double x1 = i, y1 = j, z1 = k;
+    attr.LatticeToWorld(x1, y1, z1);
+    double x2 = i + d(i, j, k, 0);
+    double y2 = j + d(i, j, k, 1);
+    double z2 = k + d(i, j, k, 2);
+    attr.LatticeToWorld(x2, y2, z2);
+    d(i, j, k, 0) = x2 - x1, d(i, j, k, 1) = y2 - y1, d(i, j, k, 2) = z2 - z1;
+  }
+}
+
+// ---------------------------------------------------------------------------
+/// Compare images voxel by voxel
+void ExpectNear(const ImageType &expected, const ImageType &actual, const char *name)
+{
+  ASSERT_EQ(expected.NumberOfVoxels(), actual.NumberOfVoxels()) << name;
+  for (int idx = 0; idx < expected.NumberOfVoxels(); ++idx) {
+    ASSERT_NEAR(expected(idx), actual(idx), tol * max(1.0, fabs(expected(idx))))
+        << name << " at index " << idx;
+  }
+}
+
+// ===========================================================================
+// Tests
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+TEST(irtkScalingAndSquaring, FusedUpdateMatchesPerStepUpdate)
+{
+  srand(42);
+  const ImageType v = RandomVelocity(Domain(17, 15, 11), 3.0);
+
+  ImageType d0, jac0, dj0, lj0, lo0;
+  PerStepExponentiate(v, 1.0, 5, d0, jac0, dj0, lj0, lo0);
+
+  ImageType d, jac, dj, lj;
+  FilterType filter;
+  Exponentiate(filter, v, 1.0, 5, &d, &jac, &dj, &lj);
+  EXPECT_EQ(5, filter.ActualNumberOfSquaringSteps());
+  ExpectNear(d0,   d,   "displacement");
+  ExpectNear(jac0, jac, "Jacobian");
+  ExpectNear(dj0,  dj,  "det(Jacobian)");
+  ExpectNear(lj0,  lj,  "log(det(Jacobian))");
+}
+
+// ---------------------------------------------------------------------------
+TEST(irtkScalingAndSquaring, OutputSubsets)
+{
+  srand(42);
+  const ImageType v = RandomVelocity(Domain(17, 15, 11), 3.0);
+
+  ImageType d0, jac0, dj0, lj0, lo0;
+  PerStepExponentiate(v, 1.0, 4, d0, jac0, dj0, lj0, lo0);
+
+  // Each combination of outputs selects a different fused update
+  ImageType d, jac, dj, lj;
+  FilterType filter;
+  Exponentiate(filter, v, 1.0, 4, &d, NULL, NULL, NULL);
+  ExpectNear(d0, d, "displacement");
+  Exponentiate(filter, v, 1.0, 4, &d, &jac, NULL, NULL);
+  ExpectNear(d0,   d,   "displacement");
+  ExpectNear(jac0, jac, "Jacobian");
+  Exponentiate(filter, v, 1.0, 4, &d, NULL, &dj, NULL);
+  ExpectNear(d0,  d,  "displacement");
+  ExpectNear(dj0, dj, "det(Jacobian)");
+  Exponentiate(filter, v, 1.0, 4, &d, NULL, NULL, &lj);
+  ExpectNear(d0,  d,  "displacement");
+  ExpectNear(lo0, lj, "log(det(Jacobian))");
+  Exponentiate(filter, v, 1.0, 4, &d, &jac, NULL, &lj);
+  ExpectNear(d0,   d,   "displacement");
+  ExpectNear(jac0, jac, "Jacobian");
+  ExpectNear(lo0,  lj,  "log(det(Jacobian))");
+}
+
+// ---------------------------------------------------------------------------
+TEST(irtkScalingAndSquaring, ReusedWorkspace)
+{
+  srand(42);
+  const ImageType v1 = RandomVelocity(Domain(17, 15, 11), 3.0);
+  const ImageType v2 = RandomVelocity(Domain(17, 15, 11), 2.0);
+  const ImageType v3 = RandomVelocity(Domain(13, 12,  9), 2.5);
+
+  // Results of a filter used for the first time
+  ImageType d1, jac1, dj1, lj1, d2, jac2, dj2, lj2, d3, jac3, dj3, lj3;
+  {
+    FilterType filter;
+    Exponentiate(filter, v1, 1.0, 5, &d1, &jac1, &dj1, &lj1);
+  }
+  {
+    FilterType filter;
+    Exponentiate(filter, v2, 0.5, 3, &d2, &jac2, &dj2, &lj2);
+  }
+  {
+    FilterType filter;
+    Exponentiate(filter, v3, 1.0, 4, &d3, &jac3, &dj3, &lj3);
+  }
+
+  // Results of one filter whose workspace is kept between runs, including
+  // a change of the lattice and of the number of squaring steps
+  FilterType filter;
+  ImageType d, jac, dj, lj;
+  for (int iter = 0; iter < 2; ++iter) {
+    Exponentiate(filter, v1, 1.0, 5, &d, &jac, &dj, &lj);
+    ExpectNear(d1, d, "displacement"), ExpectNear(jac1, jac, "Jacobian");
+    ExpectNear(dj1, dj, "det(Jacobian)"), ExpectNear(lj1, lj, "log(det(Jacobian))");
+    Exponentiate(filter, v2, 0.5, 3, &d, &jac, &dj, &lj);
+    ExpectNear(d2, d, "displacement"), ExpectNear(jac2, jac, "Jacobian");
+    ExpectNear(dj2, dj, "det(Jacobian)"), ExpectNear(lj2, lj, "log(det(Jacobian))");
+    Exponentiate(filter, v3, 1.0, 4, &d, &jac, &dj, &lj);
+    ExpectNear(d3, d, "displacement"), ExpectNear(jac3, jac, "Jacobian");
+    ExpectNear(dj3, dj, "det(Jacobian)"), ExpectNear(lj3, lj, "log(det(Jacobian))");
+  }
+}
+
+// ===========================================================================
+// Main
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
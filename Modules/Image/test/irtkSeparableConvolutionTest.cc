@@ -0,0 +1,394 @@
+/* The Image Registration Toolkit (IRTK)
+ *
+ * Copyright 2008-2015 Imperial College London
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include <gtest/gtest.h>
+
+#include <irtkImage.h>
+#include <irtkSeparableConvolution.h>
+#include <irtkConvolutionFunction.h>
+#include <irtkGaussianBlurring.h>
+#include <irtkConvolutionWithGaussianDerivative.h>
+#include <irtkConvolutionWithGaussianDerivative2.h>
+
+// Maximum difference of recursive filter and kernel impulse responses relative
+// to their peak for each order of derivative (cf. irtkSeparableConvolution::RecursiveGaussian)
+static const double recursive_tol[3] = {0.01, 0.005, 0.015};
+
+// Standard deviations in voxel units for which recursive filters are tested
+static const double sigmas[] = {1.0, 1.5, 2.0, 3.0, 5.0, 8.0, 12.0};
+
+// Maximum difference of tiled and voxel-wise convolution, which only differ
+// in the order of summation
+static const double tol = 1e-12;
+
+using namespace irtkConvolutionFunction;
+
+typedef irtkSeparableConvolution Conv;
+
+// ===========================================================================
+// Auxiliary functions
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+/// Image line with single non-zero voxel at its center
+irtkGenericImage<double> Impulse(double sigma)
+{
+  const int n = 2 * static_cast<int>(ceil(6.0 * sigma)) + 1;
+  irtkGenericImage<double> image(n, 1, 1);
+  image(n / 2, 0, 0) = 1.0;
+  return image;
+}
+
+// ---------------------------------------------------------------------------
+/// Maximum difference of filter responses relative to peak of expected response
+double MaxRelativeError(const irtkGenericImage<double> &expected,
+                        const irtkGenericImage<double> &output)
+{
+  double peak = .0, error = .0;
+  const double *p = expected.GetPointerToVoxels();
+  const double *q = output  .GetPointerToVoxels();
+  for (int idx = 0; idx < expected.NumberOfVoxels(); ++idx, ++p, ++q) {
+    peak  = max(peak,  fabs(*p));
+    error = max(error, fabs(*q - *p));
+  }
+  return error / peak;
+}
+
+// ---------------------------------------------------------------------------
+/// Impulse response of Gaussian blurring
+irtkGenericImage<double> Blur(double sigma, bool recursive)
+{
+  irtkGenericImage<double> input = Impulse(sigma);
+  irtkGenericImage<double> output;
+  irtkGaussianBlurring<double> filter(sigma);
+  filter.Recursive(recursive);
+  filter.SetInput (&input);
+  filter.SetOutput(&output);
+  filter.Run();
+  return output;
+}
+
+// ---------------------------------------------------------------------------
+/// Impulse response of convolution with first derivative of Gaussian in x
+irtkGenericImage<double> Derivative(double sigma, bool recursive)
+{
+  irtkGenericImage<double> input = Impulse(sigma);
+  irtkGenericImage<double> output;
+  irtkConvolutionWithGaussianDerivative<double> filter(sigma);
+  filter.SetRecursive(recursive);
+  filter.SetInput (&input);
+  filter.SetOutput(&output);
+  filter.Ix();
+  return output;
+}
+
+// ---------------------------------------------------------------------------
+/// Impulse response of convolution with second derivative of Gaussian in x
+irtkGenericImage<double> Derivative2(double sigma, bool recursive)
+{
+  irtkGenericImage<double> input = Impulse(sigma);
+  irtkGenericImage<double> output;
+  irtkConvolutionWithGaussianDerivative2<double> filter(sigma);
+  filter.SetRecursive(recursive);
+  filter.SetInput (&input);
+  filter.SetOutput(&output);
+  filter.Ixx();
+  return output;
+}
+
+// ---------------------------------------------------------------------------
+/// 4D image with random foreground values in [1, 2] and background value 0
+///
+/// The size is chosen such that the lines do not fill up the last tile.
+irtkGenericImage<double> RandomImage(double background_fraction)
+{
+  irtkGenericImage<double> image(37, 23, 19, 3);
+  double *p = image.GetPointerToVoxels();
+  for (int idx = 0; idx < image.NumberOfVoxels(); ++idx, ++p) {
+    if (static_cast<double>(rand()) / RAND_MAX < background_fraction) *p = .0;
+    else *p = 1.0 + static_cast<double>(rand()) / RAND_MAX;
+  }
+  image.PutBackgroundValueAsDouble(.0);
+  return image;
+}
+
+// ---------------------------------------------------------------------------
+/// Kernel with random weights in [0, 1] and given symmetry
+vector<double> RandomKernel(int radius, int symmetry)
+{
+  vector<double> kernel(2 * radius + 1);
+  for (int n = 0; n <= 2 * radius; ++n) {
+    kernel[n] = static_cast<double>(rand()) / RAND_MAX;
+  }
+  for (int n = 0; n < radius; ++n) {
+    if      (symmetry > 0) kernel[2 * radius - n] =  kernel[n];
+    else if (symmetry < 0) kernel[2 * radius - n] = -kernel[n];
+  }
+  if (symmetry < 0) kernel[radius] = .0;
+  return kernel;
+}
+
+// ---------------------------------------------------------------------------
+/// Convolve image along given dimension with voxel function
+template <class Function>
+irtkGenericImage<double> VoxelWise(const irtkGenericImage<double> &image, Function f)
+{
+  irtkGenericImage<double> output(image.Attributes());
+  ParallelForEachVoxel(image.Attributes(), image, output, f);
+  return output;
+}
+
+// ---------------------------------------------------------------------------
+/// Former voxel-wise convolution with kernel truncated at image boundary
+irtkGenericImage<double> ConvolveTruncated(const irtkGenericImage<double> &image, int dim,
+                                           const vector<double> &k, bool norm)
+{
+  const int n = static_cast<int>(k.size());
+  switch (dim) {
+    case 0:  return VoxelWise(image, ConvolveInX<>(&image, &k[0], n, norm));
+    case 1:  return VoxelWise(image, ConvolveInY<>(&image, &k[0], n, norm));
+    case 2:  return VoxelWise(image, ConvolveInZ<>(&image, &k[0], n, norm));
+    default: return VoxelWise(image, ConvolveInT<>(&image, &k[0], n, norm));
+  }
+}
+
+// ---------------------------------------------------------------------------
+/// Former voxel-wise convolution with kernel truncated at foreground boundary
+irtkGenericImage<double> ConvolveTruncatedForeground(const irtkGenericImage<double> &image, int dim,
+                                                     const vector<double> &k, bool norm)
+{
+  const int    n  = static_cast<int>(k.size());
+  const double bg = image.GetBackgroundValueAsDouble();
+  switch (dim) {
+    case 0:  return VoxelWise(image, ConvolveTruncatedForegroundInX<>(&image, bg, &k[0], n, norm));
+    case 1:  return VoxelWise(image, ConvolveTruncatedForegroundInY<>(&image, bg, &k[0], n, norm));
+    case 2:  return VoxelWise(image, ConvolveTruncatedForegroundInZ<>(&image, bg, &k[0], n, norm));
+    default: return VoxelWise(image, ConvolveTruncatedForegroundInT<>(&image, bg, &k[0], n, norm));
+  }
+}
+
+// ---------------------------------------------------------------------------
+/// Former voxel-wise convolution with foreground extended by its end points
+irtkGenericImage<double> ConvolveExtendedForeground(const irtkGenericImage<double> &image, int dim,
+                                                    const vector<double> &k)
+{
+  const int n = static_cast<int>(k.size());
+  switch (dim) {
+    case 0:  return VoxelWise(image, ConvolveExtendedForegroundInX<>(&image, &k[0], n));
+    case 1:  return VoxelWise(image, ConvolveExtendedForegroundInY<>(&image, &k[0], n));
+    case 2:  return VoxelWise(image, ConvolveExtendedForegroundInZ<>(&image, &k[0], n));
+    default: return VoxelWise(image, ConvolveExtendedForegroundInT<>(&image, &k[0], n));
+  }
+}
+
+// ---------------------------------------------------------------------------
+/// Voxel-wise convolution ignoring background voxels as done by the former
+/// irtkConvolutionWithPadding_1D, but with the kernel in convolution order
+irtkGenericImage<double> ConvolveIgnoringBackground(const irtkGenericImage<double> &image, int dim,
+                                                    const vector<double> &k, bool norm)
+{
+  const int    r  = static_cast<int>(k.size()) / 2;
+  const double bg = image.GetBackgroundValueAsDouble();
+  const int size[4] = {image.X(), image.Y(), image.Z(), image.T()};
+  irtkGenericImage<double> output(image.Attributes());
+  int p[4];
+  for (p[3] = 0; p[3] < image.T(); ++p[3])
+  for (p[2] = 0; p[2] < image.Z(); ++p[2])
+  for (p[1] = 0; p[1] < image.Y(); ++p[1])
+  for (p[0] = 0; p[0] < image.X(); ++p[0]) {
+    double &out = output(p[0], p[1], p[2], p[3]);
+    if (image(p[0], p[1], p[2], p[3]) <= bg) {
+      out = bg;
+      continue;
+    }
+    double acc = .0, sum = .0;
+    int q[4] = {p[0], p[1], p[2], p[3]};
+    for (int n = 0; n <= 2 * r; ++n) {
+      q[dim] = p[dim] + r - n;
+      if (q[dim] < 0 || q[dim] >= size[dim]) continue;
+      const double v = image(q[0], q[1], q[2], q[3]);
+      if (v > bg) acc += k[n] * v, sum += k[n];
+    }
+    if (norm) out = (sum != .0 ? acc / sum : bg);
+    else      out = acc;
+  }
+  return output;
+}
+
+// ---------------------------------------------------------------------------
+/// Convolve image along given dimension with tiled convolution
+irtkGenericImage<double> Tiled(const irtkGenericImage<double> &image, int dim,
+                               const vector<double> &k, Conv::BoundaryMode mode, bool norm)
+{
+  irtkGenericImage<double> output(image.Attributes());
+  Conv conv(mode, norm);
+  conv.Background(image.GetBackgroundValueAsDouble());
+  conv.Kernel(&k[0], static_cast<int>(k.size()));
+  conv.Run(&image, dim, &output);
+  return output;
+}
+
+// ---------------------------------------------------------------------------
+/// Maximum absolute difference of two images
+double MaxAbsoluteError(const irtkGenericImage<double> &expected,
+                        const irtkGenericImage<double> &output)
+{
+  double error = .0;
+  for (int idx = 0; idx < expected.NumberOfVoxels(); ++idx) {
+    error = max(error, fabs(output(idx) - expected(idx)));
+  }
+  return error;
+}
+
+// ---------------------------------------------------------------------------
+/// Compare tiled convolution with voxel-wise convolution for each dimension
+/// and kernels of each symmetry
+///
+/// Antisymmetric kernels are not normalized, because the sum of their weights
+/// which overlap the image is close to zero.
+void TestTiledConvolution(Conv::BoundaryMode mode, bool norm, double background_fraction)
+{
+  srand(42);
+  const irtkGenericImage<double> image = RandomImage(background_fraction);
+  for (int symmetry = (norm ? 0 : -1); symmetry <= 1; ++symmetry)
+  for (int dim = 0; dim < 4; ++dim) {
+    const vector<double> k = RandomKernel(dim < 3 ? 4 : 1, symmetry);
+    irtkGenericImage<double> expected;
+    switch (mode) {
+      case Conv::TruncateKernel:     expected = ConvolveTruncated          (image, dim, k, norm); break;
+      case Conv::IgnoreBackground:   expected = ConvolveIgnoringBackground (image, dim, k, norm); break;
+      case Conv::TruncateForeground: expected = ConvolveTruncatedForeground(image, dim, k, norm); break;
+      case Conv::ExtendForeground:   expected = ConvolveExtendedForeground (image, dim, k);       break;
+    }
+    const irtkGenericImage<double> output = Tiled(image, dim, k, mode, norm);
+    EXPECT_LT(MaxAbsoluteError(expected, output), tol)
+        << "dim=" << dim << ", symmetry=" << symmetry << ", normalize=" << norm;
+  }
+}
+
+// ===========================================================================
+// Tests
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+TEST(irtkSeparableConvolution, RecursiveGaussian)
+{
+  for (size_t i = 0; i < sizeof(sigmas) / sizeof(sigmas[0]); ++i) {
+    const double error = MaxRelativeError(Blur(sigmas[i], false), Blur(sigmas[i], true));
+    EXPECT_LT(error, recursive_tol[0]) << "sigma=" << sigmas[i];
+  }
+}
+
+// ---------------------------------------------------------------------------
+TEST(irtkSeparableConvolution, RecursiveGaussianDerivative)
+{
+  for (size_t i = 0; i < sizeof(sigmas) / sizeof(sigmas[0]); ++i) {
+    const double error = MaxRelativeError(Derivative(sigmas[i], false), Derivative(sigmas[i], true));
+    EXPECT_LT(error, recursive_tol[1]) << "sigma=" << sigmas[i];
+  }
+}
+
+// ---------------------------------------------------------------------------
+TEST(irtkSeparableConvolution, RecursiveGaussianDerivative2)
+{
+  for (size_t i = 0; i < sizeof(sigmas) / sizeof(sigmas[0]); ++i) {
+    const double error = MaxRelativeError(Derivative2(sigmas[i], false), Derivative2(sigmas[i], true));
+    EXPECT_LT(error, recursive_tol[2]) << "sigma=" << sigmas[i];
+  }
+}
+
+// ---------------------------------------------------------------------------
+TEST(irtkSeparableConvolution, TruncateKernel)
+{
+  TestTiledConvolution(Conv::TruncateKernel, false, .0);
+  TestTiledConvolution(Conv::TruncateKernel, true,  .0);
+}
+
+// ---------------------------------------------------------------------------
+TEST(irtkSeparableConvolution, IgnoreBackground)
+{
+  TestTiledConvolution(Conv::IgnoreBackground, false, .2);
+  TestTiledConvolution(Conv::IgnoreBackground, true,  .2);
+}
+
+// ---------------------------------------------------------------------------
+TEST(irtkSeparableConvolution, TruncateForeground)
+{
+  TestTiledConvolution(Conv::TruncateForeground, false, .2);
+  TestTiledConvolution(Conv::TruncateForeground, true,  .2);
+}
+
+// ---------------------------------------------------------------------------
+TEST(irtkSeparableConvolution, ExtendForeground)
+{
+  TestTiledConvolution(Conv::ExtendForeground, false, .2);
+}
+
+// ---------------------------------------------------------------------------
+TEST(irtkSeparableConvolution, InPlace)
+{
+  srand(42);
+  const irtkGenericImage<double> image = RandomImage(.0);
+  const vector<double> k = RandomKernel(3, 0);
+  for (int dim = 0; dim < 4; ++dim) {
+    Conv conv(Conv::TruncateKernel, true);
+    conv.Kernel(&k[0], static_cast<int>(k.size()));
+    irtkGenericImage<double> output(image);
+    conv.Run(&output, dim);
+    EXPECT_EQ(.0, MaxAbsoluteError(Tiled(image, dim, k, Conv::TruncateKernel, true), output))
+        << "dim=" << dim;
+  }
+}
+
+// ---------------------------------------------------------------------------
+TEST(irtkSeparableConvolution, Downsample)
+{
+  srand(42);
+  const irtkGenericImage<double> image = RandomImage(.2);
+  const vector<double> k = RandomKernel(2, 1);
+  for (int dim = 0; dim < 3; ++dim) {
+    const irtkGenericImage<double> full = Tiled(image, dim, k, Conv::ExtendForeground, false);
+    Conv conv(Conv::ExtendForeground, false);
+    conv.Kernel(&k[0], static_cast<int>(k.size()));
+    conv.Factor(2);
+    irtkImageAttributes attr = image.Attributes();
+    int *size[3] = {&attr._x, &attr._y, &attr._z};
+    const int n = *size[dim];
+    *size[dim] = conv.Size(n);
+    irtkGenericImage<double> output(attr);
+    conv.Run(&image, dim, &output);
+    int p[4];
+    for (p[3] = 0; p[3] < output.T(); ++p[3])
+    for (p[2] = 0; p[2] < output.Z(); ++p[2])
+    for (p[1] = 0; p[1] < output.Y(); ++p[1])
+    for (p[0] = 0; p[0] < output.X(); ++p[0]) {
+      int q[4] = {p[0], p[1], p[2], p[3]};
+      q[dim] = conv.Offset(n) + 2 * p[dim];
+      ASSERT_EQ(full(q[0], q[1], q[2], q[3]), output(p[0], p[1], p[2], p[3])) << "dim=" << dim;
+    }
+  }
+}
+
+// ===========================================================================
+// Main
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
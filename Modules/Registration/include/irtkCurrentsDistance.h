@@ -23,6 +23,8 @@
 
 #include <irtkPointSetDistance.h>
 
+class vtkAbstractPointLocator;
+
 
 /**
  * Currents distance measure of
@@ -33,8 +35,71 @@ class irtkCurrentsDistance : public irtkPointSetDistance
 {
   irtkObjectMacro(irtkCurrentsDistance);
 
+  // ---------------------------------------------------------------------------
+  // Types
+public:
+
+  /// Enumeration of methods used to evaluate sums of kernel weighted currents
+  enum KernelEvaluationMethod
+  {
+    KE_Exact, ///< Direct summation over points within truncated kernel support
+    KE_Grid   ///< Separable convolution of currents splatted onto regular grid
+  };
+
+  /// Kernel weighted sums of a current sampled on a regular grid
+  ///
+  /// The weights of the current are splatted onto the grid using trilinear
+  /// weights, convolved with a separable Gaussian kernel, and interpolated
+  /// at the query points. The variance of the discrete kernel is reduced to
+  /// compensate for the additional smoothing due to splatting/interpolation.
+  /// For a grid spacing h, the relative error of the interpolated kernel sums
+  /// and their derivatives is at most about 0.4 (h/sigma)^2. For small h, it
+  /// is limited to about 1% by the truncation of the exact kernel at 2.5 sigma.
+  ///
+  /// The grid arrays of both currents are released when the currents are
+  /// updated, and a grid which would exceed MaxMemorySize is not allocated.
+  struct KernelGrid
+  {
+    /// Maximum memory in bytes of a grid including its derivatives and
+    /// temporary buffers, larger grids are not allocated
+    static const size_t MaxMemorySize;
+
+    int            _Size[3];     ///< Number of grid points along each axis
+    double         _Origin[3];   ///< World coordinates of first grid point
+    double         _Spacing;     ///< Grid spacing
+    double         _Sigma;       ///< Sigma value of currents kernel
+    int            _Components;  ///< Number of components of current weights
+    vector<double> _Weights;     ///< Current weights splatted onto grid
+    vector<double> _Sum;         ///< Kernel weighted sum of current weights
+    vector<double> _Gradient[3]; ///< Derivatives of kernel weighted sums
+    bool           _TooLarge;    ///< Whether grid exceeds MaxMemorySize
+
+    /// Constructor
+    KernelGrid();
+
+    /// Whether grid is uninitialized
+    bool Empty() const;
+
+    /// Clear grid and release its memory
+    void Clear();
+
+    /// Splat current onto grid and compute kernel weighted sums
+    ///
+    /// \returns Whether grid was initialized. If the grid would need more
+    ///          than MaxMemorySize bytes, it is left empty instead.
+    bool Initialize(vtkPolyData *, double sigma, double spacing);
+
+    /// Compute spatial derivatives of kernel weighted sums
+    void ComputeGradient();
+
+    /// Interpolate kernel weighted sums and optionally their derivatives
+    /// with respect to each spatial dimension at given world point
+    void Evaluate(const double p[3], double *sum, double *gradient = NULL) const;
+  };
+
   // ---------------------------------------------------------------------------
   // Attributes
+private:
 
   /// Current representation of target data set
   irtkAttributeMacro(vtkSmartPointer<vtkPolyData>, TargetCurrent);
@@ -48,9 +113,28 @@ class irtkCurrentsDistance : public irtkPointSetDistance
   /// Whether to ensure symmetry of currents dot product
   irtkPublicAttributeMacro(bool, Symmetric);
 
+  /// Method used to evaluate sums of kernel weighted currents
+  irtkPublicAttributeMacro(KernelEvaluationMethod, KernelEvaluation);
+
+  /// Maximum relative approximation error of kernel weighted sums which
+  /// determines the grid spacing used by KE_Grid
+  irtkPublicAttributeMacro(double, KernelTolerance);
+
   /// Sum of squared norm of fixed (i.e., untransformed) data set(s)
   irtkAttributeMacro(double, TargetNormSquared);
 
+  /// Point locator of target current used by KE_Exact
+  mutable vtkSmartPointer<vtkAbstractPointLocator> _TargetLocator;
+
+  /// Point locator of source current used by KE_Exact
+  mutable vtkSmartPointer<vtkAbstractPointLocator> _SourceLocator;
+
+  /// Kernel weighted sums of target current used by KE_Grid
+  mutable KernelGrid _TargetGrid;
+
+  /// Kernel weighted sums of source current used by KE_Grid
+  mutable KernelGrid _SourceGrid;
+
   // ---------------------------------------------------------------------------
   // Currents representation
 protected:
@@ -61,6 +145,24 @@ protected:
   /// Convert surface mesh to current
   static vtkSmartPointer<vtkPolyData> SurfaceToCurrent(vtkPolyData *);
 
+  /// Get point locator of target or source current
+  ///
+  /// The locator is built upon first request after the current was updated
+  /// and reused by all subsequent evaluations of energy and gradient.
+  vtkAbstractPointLocator *Locator(vtkPolyData *) const;
+
+  /// Get kernel weighted sums of target or source current sampled on grid
+  ///
+  /// \param[in] current  Target or source current.
+  /// \param[in] gradient Whether derivatives of kernel sums are required.
+  ///
+  /// \returns Kernel grid or NULL if the grid would be too large, in which
+  ///          case the exact kernel sums must be evaluated instead.
+  const KernelGrid *Grid(vtkPolyData *current, bool gradient = false) const;
+
+  /// Compute dot product of target and/or source currents
+  double DotProduct(vtkPolyData *, vtkPolyData *, vtkDataArray * = NULL) const;
+
   // ---------------------------------------------------------------------------
   // Construction/Destruction
 public:
@@ -132,5 +234,28 @@ public:
 
 };
 
+////////////////////////////////////////////////////////////////////////////////
+// Inline definitions
+////////////////////////////////////////////////////////////////////////////////
+
+// -----------------------------------------------------------------------------
+inline string ToString(const irtkCurrentsDistance::KernelEvaluationMethod &m)
+{
+  switch (m) {
+    case irtkCurrentsDistance::KE_Exact: return "Exact";
+    case irtkCurrentsDistance::KE_Grid:  return "Grid";
+    default:                             return "Unknown";
+  }
+}
+
+// -----------------------------------------------------------------------------
+inline bool FromString(const char *str, irtkCurrentsDistance::KernelEvaluationMethod &m)
+{
+  if      (strcmp(str, "Exact") == 0) m = irtkCurrentsDistance::KE_Exact;
+  else if (strcmp(str, "Grid")  == 0) m = irtkCurrentsDistance::KE_Grid;
+  else return false;
+  return true;
+}
+
 
 #endif
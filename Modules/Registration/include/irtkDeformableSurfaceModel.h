@@ -28,6 +28,8 @@
 #include <irtkTransformationConstraint.h>
 #include <irtkEdgeTable.h>
 
+class irtkSurfaceCollisions;
+
 
 /**
  * Energy function describing a deformable surface model
@@ -89,6 +91,10 @@ private:
   /// Cached values of individual energy terms
   vector<double> _Value;
 
+  /// Self-collision detection filter used to enforce hard non-self-intersection
+  /// constraint, kept between iterations to update its broad phase incrementally
+  mutable irtkSurfaceCollisions *_SurfaceCollisions;
+
 public:
 
   /// Output surface mesh
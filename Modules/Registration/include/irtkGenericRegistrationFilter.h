@@ -26,6 +26,8 @@
 #include <irtkLocalOptimizer.h>
 #include <irtkEventDelegate.h>
 
+#include <mutex>
+
 #ifdef HAS_VTK
 #  include <vtkSmartPointer.h>
 #  include <vtkPointSet.h>
@@ -190,6 +192,61 @@ public:
     TransformationInfo _Transformation;
   };
 
+  /// Resolution pyramid of an input image and the settings it was computed with
+  struct ImagePyramid
+  {
+    int                           _NumberOfLevels;               ///< Number of resolution levels
+    double                        _Padding;                      ///< Image padding value
+    double                        _Background;                   ///< Image background value
+    bool                          _DownsampleWithPadding;        ///< Whether background was considered
+    bool                          _CropPadImages;                ///< Whether image was cropped/padded
+    int                           _UseGaussianResolutionPyramid; ///< Whether levels form a Gaussian pyramid
+    vector<double>                _Blurring;                     ///< Blurring of each level
+    vector<irtkVector3D<double> > _Resolution;                   ///< Requested resolution of each level
+    vector<irtkVector3D<double> > _OutputResolution;             ///< Actual resolution of each level
+    vector<ResampledImageType>    _Image;                        ///< Image of each level
+
+    /// Whether the pyramid was computed with the same settings as another
+    bool SameSettings(const ImagePyramid &) const;
+  };
+
+  /// Cache of resolution pyramids of input images shared by multiple filters
+  ///
+  /// Only pyramids of the input images which were added to the cache using
+  /// AddImage are stored, i.e., those input images which remain resident in
+  /// memory while several registrations are being performed, such as the
+  /// common target image of a batch of registrations. The cache may be used
+  /// by concurrently running registration filters.
+  class ImagePyramidCache
+  {
+  public:
+
+    /// Keep resolution pyramids of given input image
+    void AddImage(const irtkBaseImage *);
+
+    /// Whether resolution pyramids of given input image are kept
+    bool Contains(const irtkBaseImage *) const;
+
+    /// Get copy of cached resolution pyramid computed with the given settings
+    ///
+    /// \param[in]     image   Input image.
+    /// \param[in,out] pyramid Settings of pyramid on input and cached pyramid on output.
+    ///
+    /// \returns Whether a matching pyramid was found.
+    bool Find(const irtkBaseImage *image, ImagePyramid &pyramid) const;
+
+    /// Store copy of resolution pyramid of input image
+    void Insert(const irtkBaseImage *, const ImagePyramid &);
+
+    /// Remove all cached pyramids
+    void Clear();
+
+  private:
+
+    map<const irtkBaseImage *, vector<ImagePyramid> > _Pyramid; ///< Cached pyramids
+    mutable std::mutex                                 _Mutex;   ///< Guards cache access
+  };
+
   // ---------------------------------------------------------------------------
   // Attributes
 
@@ -244,6 +301,9 @@ public:
   /// Whether to adaptively remesh surfaces before each gradient step
   irtkPublicAttributeMacro(bool, AdaptiveRemeshing);
 
+  /// Cache of image resolution pyramids shared with other registrations
+  irtkPublicAggregateMacro(ImagePyramidCache, PyramidCache);
+
 protected:
 
   /// Common attributes of (untransformed) input target data sets
@@ -97,6 +97,14 @@ public:
   /// measure implements the NonParametricGradient function
   irtkPublicAttributeMacro(bool, UseApproximateGradient);
 
+  /// Whether to re-evaluate the similarity without gradient, e.g., during a
+  /// line search, by updating only those regions of the moving image(s)
+  /// which are affected by the changed transformation parameters
+  ///
+  /// Only used by similarity measures which implement Exclude and Include.
+  /// Otherwise, the moving image(s) and similarity are always fully updated.
+  irtkPublicAttributeMacro(bool, IncrementalUpdate);
+
   /// Voxel-wise gradient preconditioning sigma used to supress noise.
   /// A non-positive value disables the voxel-wise preconditioning all together.
   ///
@@ -115,6 +123,17 @@ public:
   /// Whether Update has not been called since initialization
   irtkAttributeMacro(bool, InitialUpdate);
 
+private:
+
+  /// Parameters of target transformation at last update of target image
+  vector<double> _TargetDOFs;
+
+  /// Parameters of source transformation at last update of source image
+  vector<double> _SourceDOFs;
+
+  /// Record current parameters of transformation(s) of moving image(s)
+  void RecordDOFs();
+
   // ---------------------------------------------------------------------------
   // Construction/Destruction
 protected:
@@ -204,6 +223,43 @@ public:
 
 protected:
 
+  /// Exclude regions from similarity evaluation
+  ///
+  /// Called by UpdateChangedRegions \b before the regions of the moving
+  /// image(s) are updated. The default implementation calls Exclude for
+  /// each region.
+  ///
+  /// \sa UpdateChangedRegions, Exclude
+  virtual void ExcludeRegions(const vector<blocked_range3d<int> > &);
+
+  /// Include regions in similarity evaluation
+  ///
+  /// Called by UpdateChangedRegions \b after the regions of the moving
+  /// image(s) are updated. The default implementation calls Include for
+  /// each region. Override in subclass if the similarity measure has to
+  /// do some further processing only once all regions were included.
+  ///
+  /// \sa UpdateChangedRegions, Include
+  virtual void IncludeRegions(const vector<blocked_range3d<int> > &);
+
+  /// Update moving image(s) only within regions affected by changed parameters
+  ///
+  /// This function compares the current parameters of the transformation(s)
+  /// with those at the last update of the moving image(s). The image support
+  /// of each changed control point, i.e., the DOFBoundingBox of its
+  /// parameters, is marked as changed in a coarse grid of image tiles.
+  /// Only these tiles are excluded from the similarity evaluation, resampled
+  /// and included again. It is intended for use by the Update function of
+  /// subclasses which implement Exclude and Include to re-evaluate the
+  /// similarity without gradient more efficiently, in particular during
+  /// a line search following a local change of fine FFD control points.
+  ///
+  /// \returns Whether the moving image(s) and similarity were updated.
+  ///          If \c false, a full update of the similarity is required,
+  ///          e.g., when the transformation does not have a local support
+  ///          or the changed regions cover most of the image domain.
+  bool UpdateChangedRegions();
+
   /// Multiply voxel-wise similarity gradient by transformed image gradient
   ///
   /// This function is intended for use by subclass implementations to compute
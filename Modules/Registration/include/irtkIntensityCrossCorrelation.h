@@ -27,6 +27,27 @@ class irtkIntensityCrossCorrelation : public irtkImageSimilarity
 {
   irtkObjectMacro(irtkIntensityCrossCorrelation);
 
+  // ---------------------------------------------------------------------------
+  // Attributes
+
+  /// Sum of target intensities
+  double _SumT;
+
+  /// Sum of source intensities
+  double _SumS;
+
+  /// Sum of products of target and source intensities
+  double _SumTS;
+
+  /// Sum of squared target intensities
+  double _SumT2;
+
+  /// Sum of squared source intensities
+  double _SumS2;
+
+  /// Number of foreground voxels for which similarity is evaluated
+  int _N;
+
   // ---------------------------------------------------------------------------
   // Construction/Destruction
 public:
@@ -43,10 +64,31 @@ public:
   /// Destructor
   ~irtkIntensityCrossCorrelation();
 
+  // ---------------------------------------------------------------------------
+  // Initialization
+
+  /// Initialize similarity measure
+  virtual void Initialize();
+
+  /// Update moving input image(s) and internal state of similarity measure
+  virtual void Update(bool = true);
+
   // ---------------------------------------------------------------------------
   // Evaluation
 protected:
 
+  /// Exclude region from similarity evaluation
+  ///
+  /// Called by ApproximateGradient \b before the registered image region of
+  /// the transformed image is updated.
+  virtual void Exclude(const blocked_range3d<int> &);
+
+  /// Include region in similarity evaluation
+  ///
+  /// Called by ApproximateGradient \b after the registered image region of
+  /// the transformed image is updated.
+  virtual void Include(const blocked_range3d<int> &);
+
   /// Evaluate similarity of images
   virtual double Evaluate();
 
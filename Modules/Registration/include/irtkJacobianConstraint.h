@@ -33,7 +33,7 @@ class irtkJacobianConstraint : public irtkTransformationConstraint
 protected:
 
   double     *_DetJacobian; ///< Determinant of Jacobian at each control point
-  irtkMatrix *_AdjJacobian; ///< Adjugate of Jacobian at each control point
+  irtkMatrix3x3 *_AdjJacobian; ///< Adjugate of Jacobian at each control point
   int         _NumberOfCPs; ///< Number of control points
 
   // ---------------------------------------------------------------------------
@@ -60,7 +60,7 @@ public:
   /// either compute a different Jacobian or to threshold the determinant value.
   virtual double Jacobian(const irtkFreeFormTransformation *ffd,
                           double x, double y, double z, double t,
-                          irtkMatrix &adj) const
+                          irtkMatrix3x3 &adj) const
   {
     double det;
     ffd->Jacobian(adj, x, y, z, t, t);
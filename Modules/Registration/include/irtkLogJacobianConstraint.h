@@ -51,7 +51,7 @@ public:
   /// Compute determinant and adjugate of Jacobian of transformation
   virtual double Jacobian(const irtkFreeFormTransformation *ffd,
                           double x, double y, double z, double t,
-                          irtkMatrix &adj) const
+                          irtkMatrix3x3 &adj) const
   {
     double det;
     ffd->FFDJacobianWorld(adj, x, y, z, t, t);
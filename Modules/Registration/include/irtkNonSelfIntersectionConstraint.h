@@ -18,6 +18,7 @@
 #define _IRTKNONSELFINTERSECTINGSURFACECONSTRAINT_H
 
 #include <irtkSurfaceConstraint.h>
+#include <irtkSurfaceCollisions.h>
 
 #include <vtkSmartPointer.h>
 #include <vtkPolyData.h>
@@ -67,6 +68,18 @@ protected:
   /// Computed vertex normals
   irtkAttributeMacro(vtkSmartPointer<vtkDataArray>, Normals);
 
+  /// Point coordinates of surface at last update of broad phase
+  vector<double> _Points;
+
+  /// Center points and radii of bounding spheres of cells [x, y, z, r]
+  vector<double> _Spheres;
+
+  /// Axis-aligned bounding boxes of cells [xmin, xmax, ymin, ymax, zmin, zmax]
+  vector<double> _Bounds;
+
+  /// Uniform grid of surface points used to find points near each cell
+  irtkSurfaceCollisions::PointGrid _Grid;
+
   // ---------------------------------------------------------------------------
   // Construction/Destruction
 
@@ -113,6 +126,13 @@ protected:
   /// Common (re-)initialization steps of this class (non-virtual function!)
   void Init();
 
+  /// Update bounding volumes and point grid of (partially) moved surface
+  ///
+  /// Only the bounding volumes of cells with displaced vertices are
+  /// recomputed and only displaced points are re-binned, unless the grid
+  /// has to be rebuilt because a point left it or the cell size changed.
+  void UpdateBroadPhase();
+
   /// Compute penalty for current transformation estimate
   virtual double Evaluate();
 
@@ -58,6 +58,28 @@ public:
   /// Number of histogram bins for source image intensities
   irtkPublicAttributeMacro(int, NumberOfSourceBins);
 
+private:
+
+  /// Precomputed histogram bins of target intensities (if target is fixed)
+  vector<int> _TargetBins;
+
+  /// Bitset of foreground voxels which does not depend on the moving image(s)
+  vector<unsigned int> _FixedForeground;
+
+  /// Pool of histograms of image tiles reused by subsequent updates
+  vector<int> _TileHistograms;
+
+  /// Update precomputed target bins and fixed foreground mask
+  void UpdateTargetBins();
+
+  /// Fill joint histogram samples using tiled histogram accumulation
+  void FillSamples();
+
+  /// Add joint histogram samples of foreground voxels in image region
+  ///
+  /// \returns Whether any sample was added.
+  bool AddSamples(const blocked_range3d<int> &);
+
   // ---------------------------------------------------------------------------
   // Construction/Destruction
 protected:
@@ -111,6 +133,15 @@ public:
   /// the transformed image is updated.
   virtual void Include(const blocked_range3d<int> &);
 
+protected:
+
+  /// Include regions in similarity evaluation
+  ///
+  /// Adds the samples of all regions before the joint histogram is smoothed.
+  virtual void IncludeRegions(const vector<blocked_range3d<int> > &);
+
+public:
+
   // ---------------------------------------------------------------------------
   // Debugging
 
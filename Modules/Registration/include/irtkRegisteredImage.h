@@ -24,6 +24,18 @@
 #include <irtkTransformation.h>
 
 
+/// Voxel type of registered image channels
+///
+/// The resampled intensities and derivatives are stored in single-precision
+/// when IRTK is configured with USE_FLOAT_FOR_REGISTERED_IMAGE. This halves
+/// the memory footprint and bandwidth of the similarity evaluation, whereas
+/// similarity measures accumulate their sums in double-precision regardless.
+#if USE_FLOAT_FOR_REGISTERED_IMAGE
+typedef float  irtkRegisteredPixel;
+#else
+typedef double irtkRegisteredPixel;
+#endif
+
 /**
  * Registered image such as fixed target image or transformed source image
  *
@@ -57,15 +69,17 @@
  * - t=7: Transformed 2nd order derivative w.r.t yy
  * - t=8: Transformed 2nd order derivative w.r.t yz
  * - t=9: Transformed 2nd order derivative w.r.t zz
+ *
+ * \sa irtkRegisteredPixel
  */
-class irtkRegisteredImage : public irtkGenericImage<double>
+class irtkRegisteredImage : public irtkGenericImage<irtkRegisteredPixel>
 {
   irtkObjectMacro(irtkRegisteredImage);
 
 public:
 
   // Do not override other base class overloads
-  using irtkGenericImage<double>::ImageToWorld;
+  using irtkGenericImage<irtkRegisteredPixel>::ImageToWorld;
 
   // ---------------------------------------------------------------------------
   // Types
@@ -45,7 +45,14 @@ extern const double EPSILON;
 // Bipartite graph matching / Optimal assignment problem
 // =============================================================================
 
-/// Find optimal assignment given cost matrix using the Hungarian method
+/// Find optimal assignment given dense cost matrix
+///
+/// Solves the linear assignment problem using the shortest augmenting path
+/// method (Hungarian/Jonker-Volgenant) in O(n^2 m) time, where n <= m are the
+/// matrix dimensions. When the matrix has more rows than columns, the rows
+/// which are not assigned to any column are mapped to -1.
+///
+/// \returns Index of column assigned to each row.
 vector<int> WeightedMatching(const irtkMatrix &cost);
 
 // =============================================================================
@@ -22,6 +22,9 @@
 
 class vtkPolyData;
 class vtkDataArray;
+class vtkCellArray;
+
+namespace irtkSurfaceCollisionsUtils { class FindCollisions; }
 
 
 /**
@@ -37,6 +40,8 @@ class irtkSurfaceCollisions : public irtkObject
 {
   irtkObjectMacro(irtkSurfaceCollisions);
 
+  friend class irtkSurfaceCollisionsUtils::FindCollisions;
+
   // ---------------------------------------------------------------------------
   // Types
 public:
@@ -161,7 +166,7 @@ public:
   // Attributes
 private:
 
-  /// Triangulated input surface mesh
+  /// Triangulated input surface mesh whose cell links have been built
   irtkPublicAttributeMacro(vtkSmartPointer<vtkPolyData>, Input);
 
   /// Annotated output surface mesh
@@ -212,6 +217,87 @@ private:
   /// Found collisions per face
   vector<set<CollisionInfo> > _Collisions;
 
+  // ---------------------------------------------------------------------------
+  // Broad phase
+public:
+
+  /// Uniform grid of surface points used to find nearby triangles
+  ///
+  /// Points are stored in a doubly linked list per grid cell such that a
+  /// point which moved into another grid cell can be re-binned in O(1).
+  /// The grid is also used by irtkNonSelfIntersectionConstraint.
+  struct PointGrid
+  {
+    double            _Origin[3];  ///< Lower corner of first grid cell
+    double            _Spacing;    ///< Side length of (cubic) grid cells
+    double            _MinSpacing; ///< Requested side length of grid cells
+    int               _Size[3];    ///< Number of grid cells along each axis
+    vector<vtkIdType> _Head;       ///< First point in each grid cell or -1
+    vector<vtkIdType> _Next;       ///< Next point in same grid cell or -1
+    vector<vtkIdType> _Prev;       ///< Previous point in same grid cell or -1
+    vector<int>       _Bin;        ///< Index of grid cell containing each point
+
+    /// Constructor
+    PointGrid();
+
+    /// Whether grid is empty
+    bool Empty() const;
+
+    /// Requested side length of grid cells passed to Build
+    ///
+    /// The actual side length _Spacing may be larger when the number of grid
+    /// cells had to be limited. Use this value to decide whether the grid of a
+    /// moved point set is still suitable or must be rebuilt.
+    double CellSize() const;
+
+    /// Whether point lies within the grid bounds
+    bool Contains(const double p[3]) const;
+
+    /// Index of grid cell containing the given point
+    int Bin(const double p[3]) const;
+
+    /// (Re-)build grid from array of point coordinates
+    void Build(const double *p, vtkIdType n, double spacing);
+
+    /// Re-bin point after it was moved to the given position
+    void Move(vtkIdType ptId, const double p[3]);
+
+    /// Find points within radius of given center point
+    void FindPointsWithinRadius(const double *p, const double c[3], double r,
+                                vector<vtkIdType> &ptIds) const;
+  };
+
+protected:
+
+  /// Triangles of output surface of previous run
+  vtkSmartPointer<vtkCellArray> _Polys;
+
+  /// Modification time of triangles of output surface of previous run
+  unsigned long _PolysMTime;
+
+  /// Point coordinates of output surface of previous run
+  vector<double> _Points;
+
+  /// Persistent cell data array storing center points of bounding spheres
+  vtkSmartPointer<vtkDataArray> _Center;
+
+  /// Persistent cell data array storing radii of bounding spheres
+  vtkSmartPointer<vtkDataArray> _Radius;
+
+  /// Axis-aligned bounding boxes of triangles [xmin, xmax, ymin, ymax, zmin, zmax]
+  vector<double> _Bounds;
+
+  /// Uniform grid of output surface points
+  PointGrid _Grid;
+
+  /// Update bounding volumes and point grid of (partially) moved surface
+  ///
+  /// When the topology of the output surface is unchanged since the previous
+  /// run, e.g., between the iterations of a deformable surface model, only the
+  /// bounding volumes of triangles with displaced vertices are recomputed and
+  /// only displaced points are re-binned. Otherwise, everything is rebuilt.
+  void UpdateBroadPhase();
+
   // ---------------------------------------------------------------------------
   // Construction/destruction
 private:
@@ -53,7 +53,7 @@ public:
   /// Compute determinant and adjugate of Jacobian of transformation
   virtual double Jacobian(const irtkFreeFormTransformation *ffd,
                           double x, double y, double z, double t,
-                          irtkMatrix &adj) const
+                          irtkMatrix3x3 &adj) const
   {
     double det;
     ffd->LocalJacobian(adj, x, y, z, t, t);
@@ -30,6 +30,8 @@
 
 #include <irtkCurrentsDistance.h>
 
+typedef irtkCurrentsDistance::KernelGrid KernelGrid;
+
 
 // =============================================================================
 // Construction/Destruction
@@ -41,6 +43,8 @@ irtkCurrentsDistance::irtkCurrentsDistance(const char *name, double weight)
   irtkPointSetDistance(name, weight),
   _Sigma(-0.05),
   _Symmetric(true),
+  _KernelEvaluation(KE_Exact),
+  _KernelTolerance(.01),
   _TargetNormSquared(.0)
 {
 }
@@ -49,6 +53,8 @@ irtkCurrentsDistance::irtkCurrentsDistance(const char *name, double weight)
 irtkCurrentsDistance::irtkCurrentsDistance(const irtkCurrentsDistance &other)
 :
   irtkPointSetDistance(other),
+  _KernelEvaluation(other._KernelEvaluation),
+  _KernelTolerance(other._KernelTolerance),
   _TargetNormSquared(other._TargetNormSquared)
 {
   if (other._TargetCurrent) {
@@ -65,7 +71,13 @@ irtkCurrentsDistance::irtkCurrentsDistance(const irtkCurrentsDistance &other)
 irtkCurrentsDistance &irtkCurrentsDistance::operator =(const irtkCurrentsDistance &other)
 {
   irtkPointSetDistance::operator =(other);
+  _KernelEvaluation  = other._KernelEvaluation;
+  _KernelTolerance   = other._KernelTolerance;
   _TargetNormSquared = other._TargetNormSquared;
+  _TargetLocator     = NULL;
+  _SourceLocator     = NULL;
+  _TargetGrid.Clear();
+  _SourceGrid.Clear();
   if (other._TargetCurrent) {
     _TargetCurrent = vtkSmartPointer<vtkPolyData>::New();
     _TargetCurrent->DeepCopy(other._TargetCurrent);
@@ -148,6 +160,271 @@ vtkSmartPointer<vtkPolyData> irtkCurrentsDistance::ToCurrent(vtkPointSet *data)
   return SurfaceToCurrent(surface);
 }
 
+// -----------------------------------------------------------------------------
+/// Get weights of n-current (i.e., normals, segments, or point weights)
+static vtkDataArray *GetCurrentWeights(vtkPolyData *current)
+{
+  vtkDataArray *weights = current->GetPointData()->GetArray("normals");
+  if (!weights) weights = current->GetPointData()->GetArray("segments");
+  if (!weights) weights = current->GetPointData()->GetArray("weights");
+  return weights;
+}
+
+// -----------------------------------------------------------------------------
+/// Convolve grid data with 1D kernel along one dimension
+class irtkCurrentsDistanceGridConvolution
+{
+private:
+
+  const double         *_Input;
+  double               *_Output;
+  const int            *_Size;
+  int                   _Components;
+  int                   _Dimension;
+  const vector<double> *_Kernel;
+
+public:
+
+  /// Convolve each line of the grid along the specified dimension
+  static void Run(const vector<double> &input, vector<double> &output,
+                  const int size[3], int nc, int dim, const vector<double> &kernel)
+  {
+    output.resize(input.size());
+    irtkCurrentsDistanceGridConvolution body;
+    body._Input      = &input [0];
+    body._Output     = &output[0];
+    body._Size       = size;
+    body._Components = nc;
+    body._Dimension  = dim;
+    body._Kernel     = &kernel;
+    const int nlines = size[0] * size[1] * size[2] / size[dim];
+    parallel_for(blocked_range<int>(0, nlines), body);
+  }
+
+  void operator ()(const blocked_range<int> &re) const
+  {
+    const int d1 = (_Dimension + 1) % 3;
+    const int d2 = (_Dimension + 2) % 3;
+    int stride[3];
+    stride[0] = _Components;
+    stride[1] = _Components * _Size[0];
+    stride[2] = _Components * _Size[0] * _Size[1];
+
+    const int     n      = _Size[_Dimension];
+    const int     s      = stride[_Dimension];
+    const int     radius = static_cast<int>(_Kernel->size()) / 2;
+    const double *kernel = &(*_Kernel)[radius];
+
+    for (int line = re.begin(); line != re.end(); ++line) {
+      const size_t offset = static_cast<size_t>(line % _Size[d1]) * stride[d1]
+                          + static_cast<size_t>(line / _Size[d1]) * stride[d2];
+      const double *in  = _Input  + offset;
+      double       *out = _Output + offset;
+      for (int i = 0; i < n; ++i, out += s) {
+        for (int c = 0; c < _Components; ++c) out[c] = .0;
+        const int o1 = max(i - n + 1, -radius);
+        const int o2 = min(i,          radius);
+        for (int o = o1; o <= o2; ++o) {
+          const double  w = kernel[o];
+          const double *v = in + static_cast<size_t>(i - o) * s;
+          for (int c = 0; c < _Components; ++c) out[c] += w * v[c];
+        }
+      }
+    }
+  }
+};
+
+// =============================================================================
+// Kernel sums sampled on regular grid
+// =============================================================================
+
+// -----------------------------------------------------------------------------
+const size_t irtkCurrentsDistance::KernelGrid::MaxMemorySize = 128 << 20;
+
+// -----------------------------------------------------------------------------
+/// Number of grid arrays, i.e., splatted weights, kernel sums, derivatives
+/// of kernel sums along each axis, and two temporary convolution buffers
+static const int NumberOfGridArrays = 7;
+
+// -----------------------------------------------------------------------------
+irtkCurrentsDistance::KernelGrid::KernelGrid()
+:
+  _Spacing(.0), _Sigma(.0), _Components(0), _TooLarge(false)
+{
+  _Size  [0] = _Size  [1] = _Size  [2] = 0;
+  _Origin[0] = _Origin[1] = _Origin[2] = .0;
+}
+
+// -----------------------------------------------------------------------------
+bool irtkCurrentsDistance::KernelGrid::Empty() const
+{
+  return _Sum.empty();
+}
+
+// -----------------------------------------------------------------------------
+void irtkCurrentsDistance::KernelGrid::Clear()
+{
+  _Size[0] = _Size[1] = _Size[2] = 0;
+  _TooLarge = false;
+  // Release memory, clear() would keep the capacity of the vectors
+  vector<double>().swap(_Weights);
+  vector<double>().swap(_Sum);
+  for (int d = 0; d < 3; ++d) vector<double>().swap(_Gradient[d]);
+}
+
+// -----------------------------------------------------------------------------
+/// Sample Gaussian kernel exp(-x^2/sigma^2) and its derivative on grid
+///
+/// The variance of the discrete kernel is reduced by the variance added by
+/// the trilinear splatting and interpolation, i.e., the kernel sampled on
+/// the grid is deconvolved approximately, and the amplitude is adjusted to
+/// preserve the integral of the kernel. Splatting and interpolation each add
+/// on average a variance of h^2/6 along each axis. The variance of the kernel
+/// exp(-x^2/sigma^2) is sigma^2/2, hence sigma^2 is reduced by 2/3 h^2.
+static void SampleKernel(double sigma, double h, vector<double> &k, vector<double> &dk)
+{
+  const double var    = sigma * sigma - 2.0 * h * h / 3.0;
+  const double scale  = sigma / sqrt(var);
+  const int    radius = static_cast<int>(floor(2.5 * sigma / h));
+  k .resize(2 * radius + 1);
+  dk.resize(2 * radius + 1);
+  for (int o = -radius; o <= radius; ++o) {
+    const double x = o * h;
+    k [o + radius] = scale * exp(- x * x / var);
+    dk[o + radius] = -2.0 * x / var * k[o + radius];
+  }
+}
+
+// -----------------------------------------------------------------------------
+bool irtkCurrentsDistance::KernelGrid::Initialize(vtkPolyData *current, double sigma, double h)
+{
+  IRTK_START_TIMING();
+
+  vtkPoints    *centers = current->GetPoints();
+  vtkDataArray *weights = GetCurrentWeights(current);
+
+  // Grid which covers the support of the kernel centered at each point
+  double bounds[6], size[3];
+  centers->GetBounds(bounds);
+  const int radius = static_cast<int>(floor(2.5 * sigma / h));
+  Clear();
+  for (int d = 0; d < 3; ++d) {
+    _Origin[d] = bounds[2*d] - (radius + 1) * h;
+    size   [d] = ceil((bounds[2*d+1] - _Origin[d]) / h) + radius + 2;
+  }
+  _Components = (weights ? weights->GetNumberOfComponents() : 1);
+  const double nbytes = size[0] * size[1] * size[2] * _Components
+                      * NumberOfGridArrays * sizeof(double);
+  if (nbytes > static_cast<double>(MaxMemorySize)) {
+    _TooLarge = true;
+    return false;
+  }
+  _Sigma      = sigma;
+  _Spacing    = h;
+  for (int d = 0; d < 3; ++d) _Size[d] = static_cast<int>(size[d]);
+  const size_t nnodes = static_cast<size_t>(_Size[0]) * _Size[1] * _Size[2];
+
+  // Splat weights of current onto grid
+  const int nc = _Components;
+  vector<double> w(nc, .0);
+  double p[3], f[3];
+  int    i[3];
+  w[0] = 1.0;
+  _Weights.assign(nnodes * nc, .0);
+  for (vtkIdType ptId = 0; ptId < centers->GetNumberOfPoints(); ++ptId) {
+    centers->GetPoint(ptId, p);
+    if (weights) weights->GetTuple(ptId, &w[0]);
+    for (int d = 0; d < 3; ++d) {
+      f[d] = (p[d] - _Origin[d]) / h;
+      i[d] = static_cast<int>(floor(f[d]));
+      f[d] -= i[d];
+    }
+    for (int c = 0; c < 8; ++c) {
+      const double wc = ((c & 1) ? f[0] : 1.0 - f[0])
+                      * ((c & 2) ? f[1] : 1.0 - f[1])
+                      * ((c & 4) ? f[2] : 1.0 - f[2]);
+      const size_t idx = ((static_cast<size_t>(i[2] + ((c & 4) ? 1 : 0))  * _Size[1]
+                                             + i[1] + ((c & 2) ? 1 : 0)) * _Size[0]
+                                             + i[0] + ((c & 1) ? 1 : 0)) * nc;
+      for (int k = 0; k < nc; ++k) _Weights[idx + k] += wc * w[k];
+    }
+  }
+
+  // Convolve with separable Gaussian kernel
+  vector<double> k, dk, tmp;
+  SampleKernel(_Sigma, _Spacing, k, dk);
+  irtkCurrentsDistanceGridConvolution::Run(_Weights, _Sum, _Size, nc, 0, k);
+  irtkCurrentsDistanceGridConvolution::Run(_Sum,     tmp,  _Size, nc, 1, k);
+  irtkCurrentsDistanceGridConvolution::Run(tmp,      _Sum, _Size, nc, 2, k);
+  for (int d = 0; d < 3; ++d) _Gradient[d].clear();
+
+  IRTK_DEBUG_TIMING(3, "splatting and convolution of current");
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+void irtkCurrentsDistance::KernelGrid::ComputeGradient()
+{
+  IRTK_START_TIMING();
+  const int nc = _Components;
+  vector<double> k, dk, tmp1, tmp2;
+  SampleKernel(_Sigma, _Spacing, k, dk);
+  // Convolution with kernel along z (shared by derivatives along x and y)
+  irtkCurrentsDistanceGridConvolution::Run(_Weights, tmp1, _Size, nc, 2, k);
+  // Derivative along x
+  irtkCurrentsDistanceGridConvolution::Run(tmp1, tmp2,         _Size, nc, 1, k);
+  irtkCurrentsDistanceGridConvolution::Run(tmp2, _Gradient[0], _Size, nc, 0, dk);
+  // Derivative along y
+  irtkCurrentsDistanceGridConvolution::Run(tmp1, tmp2,         _Size, nc, 1, dk);
+  irtkCurrentsDistanceGridConvolution::Run(tmp2, _Gradient[1], _Size, nc, 0, k);
+  // Derivative along z
+  irtkCurrentsDistanceGridConvolution::Run(_Weights, tmp1,         _Size, nc, 2, dk);
+  irtkCurrentsDistanceGridConvolution::Run(tmp1,     tmp2,         _Size, nc, 1, k);
+  irtkCurrentsDistanceGridConvolution::Run(tmp2,     _Gradient[2], _Size, nc, 0, k);
+  IRTK_DEBUG_TIMING(3, "convolution of current with kernel derivatives");
+}
+
+// -----------------------------------------------------------------------------
+void irtkCurrentsDistance::KernelGrid::Evaluate(const double p[3], double *sum, double *gradient) const
+{
+  const int nc = _Components;
+  for (int k = 0; k < nc; ++k) sum[k] = .0;
+  if (gradient) {
+    for (int k = 0; k < 3 * nc; ++k) gradient[k] = .0;
+  }
+
+  // Kernel sums are zero outside the grid
+  double f[3];
+  int    i[3];
+  for (int d = 0; d < 3; ++d) {
+    f[d] = (p[d] - _Origin[d]) / _Spacing;
+    i[d] = static_cast<int>(floor(f[d]));
+    if (i[d] < 0 || i[d] >= _Size[d] - 1) return;
+    f[d] -= i[d];
+  }
+
+  // Trilinear interpolation
+  for (int c = 0; c < 8; ++c) {
+    const double wc = ((c & 1) ? f[0] : 1.0 - f[0])
+                    * ((c & 2) ? f[1] : 1.0 - f[1])
+                    * ((c & 4) ? f[2] : 1.0 - f[2]);
+    const size_t idx = ((static_cast<size_t>(i[2] + ((c & 4) ? 1 : 0))  * _Size[1]
+                                           + i[1] + ((c & 2) ? 1 : 0)) * _Size[0]
+                                           + i[0] + ((c & 1) ? 1 : 0)) * nc;
+    for (int k = 0; k < nc; ++k) sum[k] += wc * _Sum[idx + k];
+    if (gradient) {
+      for (int d = 0; d < 3; ++d)
+      for (int k = 0; k < nc; ++k) {
+        gradient[d * nc + k] += wc * _Gradient[d][idx + k];
+      }
+    }
+  }
+}
+
+// =============================================================================
+// Auxiliary functors
+// =============================================================================
+
 // -----------------------------------------------------------------------------
 class irtkCurrentsDistanceDotProduct
 {
@@ -158,6 +435,7 @@ private:
   vtkPoints               *_CentersB;
   vtkFloatArray           *_WeightsB;
   vtkAbstractPointLocator *_LocatorB;
+  const KernelGrid        *_GridB;
   double                   _Variance;
   double                   _Radius;
   vtkDataArray            *_Value;
@@ -168,12 +446,16 @@ public:
   irtkCurrentsDistanceDotProduct(double sigma)
   :
     _CentersA(NULL), _WeightsA(NULL),
-    _CentersB(NULL), _WeightsB(NULL), _LocatorB(NULL),
+    _CentersB(NULL), _WeightsB(NULL), _LocatorB(NULL), _GridB(NULL),
     _Variance(sigma * sigma), _Radius(2.5 * sigma),
     _Value(NULL), _Sum(.0)
   {}
 
-  inline double Evaluate(vtkPolyData *a, vtkPolyData *b, vtkDataArray *value = NULL)
+  /// Evaluate dot product of currents using either the point locator
+  /// or the kernel weighted sums sampled on a grid of the second current
+  inline double Evaluate(vtkPolyData *a, vtkPolyData *b,
+                         vtkAbstractPointLocator *locator, const KernelGrid *grid,
+                         vtkDataArray *value = NULL)
   {
     IRTK_START_TIMING();
     // Get centers of n-currents
@@ -198,17 +480,15 @@ public:
       cerr << "Cannot compute inner product between different types of currents" << endl;
       exit(1);
     }
-    // Initialize point locator
-    _LocatorB = vtkOctreePointLocator::New();
-    _LocatorB->SetDataSet(b);
-    _LocatorB->BuildLocator();
     // Evaluate inner product
-    _Value = value;
-    _Sum   = .0;
+    _LocatorB = locator;
+    _GridB    = grid;
+    _Value    = value;
+    _Sum      = .0;
     blocked_range<vtkIdType> cellsA(0, _CentersA->GetNumberOfPoints());
     parallel_reduce(cellsA, *this);
-    // Free point locator
-    _LocatorB->Delete(), _LocatorB = NULL;
+    _LocatorB = NULL;
+    _GridB    = NULL;
     IRTK_DEBUG_TIMING(3, "evaluation of dot product of currents");
     return _Sum;
   }
@@ -222,6 +502,7 @@ public:
     _CentersB(other._CentersB),
     _WeightsB(other._WeightsB),
     _LocatorB(other._LocatorB),
+    _GridB   (other._GridB),
     _Variance(other._Variance),
     _Radius  (other._Radius),
     _Value   (other._Value),
@@ -249,13 +530,18 @@ public:
     for (vtkIdType i = re.begin(); i != re.end(); ++i) {
       _CentersA->GetPoint(i, ca);
       _WeightsA->GetTuple(i, da);
-      _LocatorB->FindPointsWithinRadius(_Radius, ca, ids);
       double value = .0;
-      for (vtkIdType k = 0; k < ids->GetNumberOfIds(); ++k) {
-        vtkIdType j = ids->GetId(k);
-        _CentersB->GetPoint(j, cb);
-        _WeightsB->GetTuple(j, db);
-        value += EvaluateKernel(ca, cb) * vtkMath::Dot(da, db);
+      if (_GridB) {
+        _GridB->Evaluate(ca, db);
+        for (int d = 0; d < _GridB->_Components; ++d) value += da[d] * db[d];
+      } else {
+        _LocatorB->FindPointsWithinRadius(_Radius, ca, ids);
+        for (vtkIdType k = 0; k < ids->GetNumberOfIds(); ++k) {
+          vtkIdType j = ids->GetId(k);
+          _CentersB->GetPoint(j, cb);
+          _WeightsB->GetTuple(j, db);
+          value += EvaluateKernel(ca, cb) * vtkMath::Dot(da, db);
+        }
       }
       if (_Value) _Value->SetTuple1(i, _Value->GetTuple1(i) + value);
       _Sum += value;
@@ -272,10 +558,12 @@ private:
   vtkPoints               *_CentersA;
   vtkFloatArray           *_WeightsA;
   vtkAbstractPointLocator *_LocatorA;
+  const KernelGrid        *_GridA;
   vtkPointSet             *_SurfaceB;
   vtkPoints               *_CentersB;
   vtkFloatArray           *_WeightsB;
   vtkAbstractPointLocator *_LocatorB;
+  const KernelGrid        *_GridB;
   double                   _Variance;
   double                   _Radius;
   irtkVector3D<double>    *_Gradient;
@@ -284,13 +572,17 @@ public:
 
   irtkCurrentsDistanceGradient(double sigma)
   :
-    _SurfaceA(NULL), _CentersA(NULL), _WeightsA(NULL), _LocatorA(NULL),
-    _SurfaceB(NULL), _CentersB(NULL), _WeightsB(NULL), _LocatorB(NULL),
+    _SurfaceA(NULL), _CentersA(NULL), _WeightsA(NULL), _LocatorA(NULL), _GridA(NULL),
+    _SurfaceB(NULL), _CentersB(NULL), _WeightsB(NULL), _LocatorB(NULL), _GridB(NULL),
     _Variance(sigma * sigma), _Radius(2.5 * sigma), _Gradient(NULL)
   {}
 
+  /// Evaluate gradient using either the point locators or the kernel
+  /// weighted sums and their derivatives sampled on a grid of the currents
   inline void EvaluateGradient(vtkPointSet *sa, vtkPolyData *ca,
+                               vtkAbstractPointLocator *la, const KernelGrid *ga,
                                vtkPointSet *sb, vtkPolyData *cb,
+                               vtkAbstractPointLocator *lb, const KernelGrid *gb,
                                irtkVector3D<double> *g)
   {
     IRTK_START_TIMING();
@@ -318,23 +610,17 @@ public:
       cerr << "Cannot compute inner product between different types of currents" << endl;
       exit(1);
     }
-    // Initialize point locators
-    _LocatorA = vtkOctreePointLocator::New();
-    _LocatorA->SetDataSet(ca);
-    _LocatorA->BuildLocator();
-    _LocatorB = vtkOctreePointLocator::New();
-    _LocatorB->SetDataSet(cb);
-    _LocatorB->BuildLocator();
     // Evaluate gradient of currents distance measure
+    _LocatorA = la, _GridA = ga;
+    _LocatorB = lb, _GridB = gb;
     _Gradient = g;
     for (int i = 0; i < _SurfaceA->GetNumberOfPoints(); ++i) {
       _Gradient[i]._x = _Gradient[i]._y = _Gradient[i]._z = .0;
     }
     blocked_range<vtkIdType> cellsA(0, _SurfaceA->GetNumberOfCells());
     parallel_reduce(cellsA, *this);
-    // Free point locators
-    _LocatorA->Delete(), _LocatorA = NULL;
-    _LocatorB->Delete(), _LocatorB = NULL;
+    _LocatorA = _LocatorB = NULL;
+    _GridA    = _GridB    = NULL;
     IRTK_DEBUG_TIMING(3, "evaluation of gradient of currents distance");
   }
 
@@ -346,10 +632,12 @@ public:
     _CentersA(other._CentersA),
     _WeightsA(other._WeightsA),
     _LocatorA(other._LocatorA),
+    _GridA   (other._GridA),
     _SurfaceB(other._SurfaceB),
     _CentersB(other._CentersB),
     _WeightsB(other._WeightsB),
     _LocatorB(other._LocatorB),
+    _GridB   (other._GridB),
     _Variance(other._Variance),
     _Radius  (other._Radius),
     _Gradient(other._Gradient)
@@ -361,10 +649,12 @@ public:
     _CentersA(lhs._CentersA),
     _WeightsA(lhs._WeightsA),
     _LocatorA(lhs._LocatorA),
+    _GridA   (lhs._GridA),
     _SurfaceB(lhs._SurfaceB),
     _CentersB(lhs._CentersB),
     _WeightsB(lhs._WeightsB),
     _LocatorB(lhs._LocatorB),
+    _GridB   (lhs._GridB),
     _Variance(lhs._Variance),
     _Radius  (lhs._Radius)
   {
@@ -430,38 +720,43 @@ public:
       _WeightsA->GetTuple(i, n1);
       // Compute kds = KtauS and dks = gradKtauS.transpose()
       // (cf. Deformetrica 2.0 OrientedSurfaceMesh::ComputeMatchGradient)
-      _LocatorA->FindPointsWithinRadius(_Radius, c1, ids);
-      memset(kws, 0, 3 * sizeof(double));
-      memset(dks, 0, 9 * sizeof(double));
-      for (vtkIdType k = 0; k < ids->GetNumberOfIds(); ++k) {
-        j = ids->GetId(k);
-        _CentersA->GetPoint(j, c2);
-        _WeightsA->GetTuple(j, n2);
-        w = EvaluateKernel(c1, c2);
-        EvaluateKernelGradient(g, c1, c2);
-        for (int d = 0; d < 3; ++d) {
-          kws   [d] += w    * n2[d];
-          dks[0][d] += g[0] * n2[d];
-          dks[1][d] += g[1] * n2[d];
-          dks[2][d] += g[2] * n2[d];
+      if (_GridA) {
+        _GridA->Evaluate(c1, kws, &dks[0][0]);
+        _GridB->Evaluate(c1, kwt, &dkt[0][0]);
+      } else {
+        _LocatorA->FindPointsWithinRadius(_Radius, c1, ids);
+        memset(kws, 0, 3 * sizeof(double));
+        memset(dks, 0, 9 * sizeof(double));
+        for (vtkIdType k = 0; k < ids->GetNumberOfIds(); ++k) {
+          j = ids->GetId(k);
+          _CentersA->GetPoint(j, c2);
+          _WeightsA->GetTuple(j, n2);
+          w = EvaluateKernel(c1, c2);
+          EvaluateKernelGradient(g, c1, c2);
+          for (int d = 0; d < 3; ++d) {
+            kws   [d] += w    * n2[d];
+            dks[0][d] += g[0] * n2[d];
+            dks[1][d] += g[1] * n2[d];
+            dks[2][d] += g[2] * n2[d];
+          }
         }
-      }
-      // Compute kwt = KtauT and dkt = gradKtauT.transpose()
-      // (cf. Deformetrica 2.0 OrientedSurfaceMesh::ComputeMatchGradient)
-      _LocatorB->FindPointsWithinRadius(_Radius, c1, ids);
-      memset(kwt, 0, 3 * sizeof(double));
-      memset(dkt, 0, 9 * sizeof(double));
-      for (vtkIdType k = 0; k < ids->GetNumberOfIds(); ++k) {
-        j = ids->GetId(k);
-        _CentersB->GetPoint(j, c2);
-        _WeightsB->GetTuple(j, n2);
-        w = EvaluateKernel(c1, c2);
-        EvaluateKernelGradient(g, c1, c2);
-        for (int d = 0; d < 3; ++d) {
-          kwt   [d] += w    * n2[d];
-          dkt[0][d] += g[0] * n2[d];
-          dkt[1][d] += g[1] * n2[d];
-          dkt[2][d] += g[2] * n2[d];
+        // Compute kwt = KtauT and dkt = gradKtauT.transpose()
+        // (cf. Deformetrica 2.0 OrientedSurfaceMesh::ComputeMatchGradient)
+        _LocatorB->FindPointsWithinRadius(_Radius, c1, ids);
+        memset(kwt, 0, 3 * sizeof(double));
+        memset(dkt, 0, 9 * sizeof(double));
+        for (vtkIdType k = 0; k < ids->GetNumberOfIds(); ++k) {
+          j = ids->GetId(k);
+          _CentersB->GetPoint(j, c2);
+          _WeightsB->GetTuple(j, n2);
+          w = EvaluateKernel(c1, c2);
+          EvaluateKernelGradient(g, c1, c2);
+          for (int d = 0; d < 3; ++d) {
+            kwt   [d] += w    * n2[d];
+            dkt[0][d] += g[0] * n2[d];
+            dkt[1][d] += g[1] * n2[d];
+            dkt[2][d] += g[2] * n2[d];
+          }
         }
       }
       // Add gradient
@@ -482,6 +777,53 @@ public:
   }
 };
 
+// =============================================================================
+// Kernel evaluation
+// =============================================================================
+
+// -----------------------------------------------------------------------------
+vtkAbstractPointLocator *irtkCurrentsDistance::Locator(vtkPolyData *current) const
+{
+  vtkSmartPointer<vtkAbstractPointLocator> &locator = (current == _SourceCurrent ? _SourceLocator : _TargetLocator);
+  if (!locator) {
+    locator = vtkSmartPointer<vtkOctreePointLocator>::New();
+    locator->SetDataSet(current);
+    locator->BuildLocator();
+  }
+  return locator;
+}
+
+// -----------------------------------------------------------------------------
+const irtkCurrentsDistance::KernelGrid *
+irtkCurrentsDistance::Grid(vtkPolyData *current, bool gradient) const
+{
+  KernelGrid &grid = (current == _SourceCurrent ? _SourceGrid : _TargetGrid);
+  if (grid.Empty() && !grid._TooLarge) {
+    // Relative error of kernel sums and their derivatives is at most about
+    // 0.4 (h/sigma)^2, apart from the effect of truncating the kernel at 2.5 sigma
+    const double h = _Sigma * min(sqrt(2.5 * _KernelTolerance), .5);
+    if (!grid.Initialize(current, _Sigma, h) && debug) {
+      cout << NameOfClass() << "::Grid: Kernel grid would exceed "
+           << (KernelGrid::MaxMemorySize >> 20) << " MB, using exact kernel sums" << endl;
+    }
+  }
+  if (grid._TooLarge) return NULL;
+  if (gradient && grid._Gradient[0].empty()) grid.ComputeGradient();
+  return &grid;
+}
+
+// -----------------------------------------------------------------------------
+double irtkCurrentsDistance::DotProduct(vtkPolyData *a, vtkPolyData *b, vtkDataArray *value) const
+{
+  irtkCurrentsDistanceDotProduct dot_product(_Sigma);
+  const KernelGrid *grid = (_KernelEvaluation == KE_Grid ? Grid(b) : NULL);
+  if (grid) {
+    return dot_product.Evaluate(a, b, NULL, grid, value);
+  } else {
+    return dot_product.Evaluate(a, b, Locator(b), NULL, value);
+  }
+}
+
 // =============================================================================
 // Initialization
 // =============================================================================
@@ -505,18 +847,25 @@ void irtkCurrentsDistance::Init()
     _Sigma = 0.5 * (ra + rb) * fabs(_Sigma);
   }
 
+  if (_KernelTolerance <= .0) {
+    cerr << "irtkCurrentsDistance::Initialize: Kernel tolerance must be positive!" << endl;
+    exit(1);
+  }
+
   // Get currents representation of input data sets
   _TargetCurrent = ToCurrent(_Target->InputPointSet());
   _SourceCurrent = ToCurrent(_Source->InputPointSet());
+  _TargetLocator = _SourceLocator = NULL;
+  _TargetGrid.Clear();
+  _SourceGrid.Clear();
 
   // Compute squared norm of fixed current(s)
   _TargetNormSquared = .0;
-  irtkCurrentsDistanceDotProduct dot_product(_Sigma);
   if (!_Target->Transformation()) {
-    _TargetNormSquared += dot_product.Evaluate(_TargetCurrent, _TargetCurrent);
+    _TargetNormSquared += DotProduct(_TargetCurrent, _TargetCurrent);
   }
   if (!_Source->Transformation()) {
-    _TargetNormSquared += dot_product.Evaluate(_SourceCurrent, _SourceCurrent);
+    _TargetNormSquared += DotProduct(_SourceCurrent, _SourceCurrent);
   }
 }
 
@@ -549,11 +898,19 @@ bool irtkCurrentsDistance::Set(const char *param, const char *value)
     return FromString(value, _Sigma) && _Sigma != .0;
   } else if (strcmp(param, "Symmetric currents distance") == 0) {
     return FromString(value, _Symmetric);
+  } else if (strcmp(param, "Currents kernel evaluation") == 0) {
+    return FromString(value, _KernelEvaluation);
+  } else if (strcmp(param, "Currents kernel tolerance") == 0) {
+    return FromString(value, _KernelTolerance) && _KernelTolerance > .0;
   } else if (!_Name.empty()) {
     if (_Name + " kernel width" == param) {
       return FromString(value, _Sigma) && _Sigma != .0;
     } else if (_Name + " symmetric" == param) {
       return FromString(value, _Symmetric);
+    } else if (_Name + " kernel evaluation" == param) {
+      return FromString(value, _KernelEvaluation);
+    } else if (_Name + " kernel tolerance" == param) {
+      return FromString(value, _KernelTolerance) && _KernelTolerance > .0;
     }
   }
   return irtkPointSetDistance::Set(param, value);
@@ -566,6 +923,8 @@ irtkParameterList irtkCurrentsDistance::Parameter() const
   if (!_Name.empty()) {
     Insert(params, _Name + " kernel width", ToString(_Sigma));
     Insert(params, _Name + " symmetric",    ToString(_Symmetric));
+    Insert(params, _Name + " kernel evaluation", ToString(_KernelEvaluation));
+    Insert(params, _Name + " kernel tolerance",  ToString(_KernelTolerance));
   }
   return params;
 }
@@ -580,10 +939,14 @@ void irtkCurrentsDistance::Update(bool)
   if (_Target->Transformation()) {
     _Target->Update();
     _TargetCurrent = ToCurrent(_Target->PointSet());
+    _TargetLocator = NULL;
+    _TargetGrid.Clear();
   }
   if (_Source->Transformation()) {
     _Source->Update();
     _SourceCurrent = ToCurrent(_Source->PointSet());
+    _SourceLocator = NULL;
+    _SourceGrid.Clear();
   }
 }
 
@@ -592,18 +955,17 @@ double irtkCurrentsDistance::Evaluate()
 {
   IRTK_START_TIMING();
   double d = _TargetNormSquared;
-  irtkCurrentsDistanceDotProduct dot_product(_Sigma);
   if (_Target->Transformation()) {
-    d += dot_product.Evaluate(_TargetCurrent, _TargetCurrent);
+    d += DotProduct(_TargetCurrent, _TargetCurrent);
   }
   if (_Source->Transformation()) {
-    d += dot_product.Evaluate(_SourceCurrent, _SourceCurrent);
+    d += DotProduct(_SourceCurrent, _SourceCurrent);
   }
   if (_Symmetric) {
-    d -= dot_product.Evaluate(_TargetCurrent, _SourceCurrent);
-    d -= dot_product.Evaluate(_SourceCurrent, _TargetCurrent);
+    d -= DotProduct(_TargetCurrent, _SourceCurrent);
+    d -= DotProduct(_SourceCurrent, _TargetCurrent);
   } else {
-    d -= 2.0 * dot_product.Evaluate(_TargetCurrent, _SourceCurrent);
+    d -= 2.0 * DotProduct(_TargetCurrent, _SourceCurrent);
   }
   IRTK_DEBUG_TIMING(2, "evaluation of currents distance");
   return d / ((_TargetCurrent->GetNumberOfPoints() + _SourceCurrent->GetNumberOfPoints()) / 2);
@@ -619,7 +981,16 @@ void irtkCurrentsDistance::NonParametricGradient(const irtkRegisteredPointSet *t
   vtkPolyData *cb = _SourceCurrent;
   if (target == _Source) swap(sa, sb), swap(ca, cb);
   irtkCurrentsDistanceGradient d(_Sigma);
-  d.EvaluateGradient(sa, ca, sb, cb, gradient);
+  const KernelGrid *ga = NULL, *gb = NULL;
+  if (_KernelEvaluation == KE_Grid) {
+    ga = Grid(ca, true);
+    gb = Grid(cb, true);
+  }
+  if (ga && gb) {
+    d.EvaluateGradient(sa, ca, NULL, ga, sb, cb, NULL, gb, gradient);
+  } else {
+    d.EvaluateGradient(sa, ca, Locator(ca), NULL, sb, cb, Locator(cb), NULL, gradient);
+  }
 }
 
 // =============================================================================
@@ -645,15 +1016,14 @@ void irtkCurrentsDistance::WriteDataSets(const char *p, const char *suffix, bool
   if (_Target->Transformation() || all) {
     vtkSmartPointer<vtkFloatArray> dist;
     if (_Target->Transformation()) {
-      irtkCurrentsDistanceDotProduct dot_product(_Sigma);
       dist = vtkSmartPointer<vtkFloatArray>::New();
       dist->SetName("distance");
       dist->SetNumberOfComponents(1);
       dist->SetNumberOfTuples(_TargetCurrent->GetNumberOfPoints());
       dist->FillComponent(0, .0);
-      dot_product.Evaluate(_TargetCurrent, _SourceCurrent, dist);
+      DotProduct(_TargetCurrent, _SourceCurrent, dist);
       NegateTuples1(dist);
-      dot_product.Evaluate(_TargetCurrent, _TargetCurrent, dist);
+      DotProduct(_TargetCurrent, _TargetCurrent, dist);
     }
     snprintf(fname, sz, "%starget%s%s", prefix, suffix, _Target->DefaultExtension());
     _Target->Write(fname, NULL, dist);
@@ -662,15 +1032,14 @@ void irtkCurrentsDistance::WriteDataSets(const char *p, const char *suffix, bool
   if (_Source->Transformation() || all) {
     vtkSmartPointer<vtkFloatArray> dist;
     if (_Source->Transformation()) {
-      irtkCurrentsDistanceDotProduct dot_product(_Sigma);
       dist = vtkSmartPointer<vtkFloatArray>::New();
       dist->SetName("distance");
       dist->SetNumberOfComponents(1);
       dist->SetNumberOfTuples(_SourceCurrent->GetNumberOfPoints());
       dist->FillComponent(0, .0);
-      dot_product.Evaluate(_SourceCurrent, _TargetCurrent, dist);
+      DotProduct(_SourceCurrent, _TargetCurrent, dist);
       NegateTuples1(dist);
-      dot_product.Evaluate(_SourceCurrent, _SourceCurrent, dist);
+      DotProduct(_SourceCurrent, _SourceCurrent, dist);
     }
     snprintf(fname, sz, "%ssource%s%s", prefix, suffix, _Source->DefaultExtension());
     _Source->Write(fname, NULL, dist);
@@ -163,7 +163,8 @@ irtkDeformableSurfaceModel::irtkDeformableSurfaceModel()
   _MinFeatureAngle(20.0),
   _MaxFeatureAngle(60.0),
   _RemeshInterval(0),
-  _RemeshCounter(0)
+  _RemeshCounter(0),
+  _SurfaceCollisions(NULL)
 {
 }
 
@@ -171,6 +172,7 @@ irtkDeformableSurfaceModel::irtkDeformableSurfaceModel()
 irtkDeformableSurfaceModel::~irtkDeformableSurfaceModel()
 {
   Clear();
+  delete _SurfaceCollisions;
 }
 
 // =============================================================================
@@ -752,7 +754,8 @@ void irtkDeformableSurfaceModel::EnforceHardConstraints(double *dx) const
     surface->ShallowCopy(_Surface.Surface());
     surface->SetPoints(points);
 
-    irtkSurfaceCollisions nsi;
+    if (!_SurfaceCollisions) _SurfaceCollisions = new irtkSurfaceCollisions();
+    irtkSurfaceCollisions &nsi = *_SurfaceCollisions;
     nsi.Input(surface);
     nsi.AdjacentIntersectionTest(true);
     nsi.NonAdjacentIntersectionTest(true);
@@ -15,6 +15,7 @@
  * limitations under the License. */
 
 #include <cctype>
+#include <chrono>
 
 #include <irtkGenericRegistrationFilter.h>
 
@@ -416,6 +417,175 @@ public:
   }
 };
 
+// -----------------------------------------------------------------------------
+/// Stages of image pyramid construction whose execution time is reported
+enum PyramidStage
+{
+  PyramidCrop,       ///< Crop/pad input images
+  PyramidDownsample, ///< Downsample, crop or copy images of coarser levels
+  PyramidBlur,       ///< Blur images
+  PyramidResample,   ///< Resample images
+  NumberOfPyramidStages
+};
+
+// -----------------------------------------------------------------------------
+/// Wall clock time in seconds used to measure the time of pyramid stages
+inline double PyramidTime()
+{
+#ifdef HAS_TBB
+  return (tbb::tick_count::now() - tbb::tick_count()).seconds();
+#else
+  typedef std::chrono::steady_clock Clock;
+  return std::chrono::duration<double>(Clock::now().time_since_epoch()).count();
+#endif
+}
+
+// -----------------------------------------------------------------------------
+/// Settings and data shared by the tasks constructing the image pyramid
+struct ImagePyramidTaskData
+{
+  const vector<const irtkBaseImage *>  *_Input;
+  vector<double>                       *_Padding;
+  vector<double>                       *_Background;
+  const vector<double>                 *_DownsamplePadding;
+  vector<double>                       *_Blurring;
+  vector<irtkVector3D<double> >        *_Resolution;
+  vector<ResampledImageList>           *_Image;
+  int                                   _NumberOfLevels;
+  bool                                  _CropPadImages;
+  bool                                  _UseGaussianResolutionPyramid;
+  vector<double>                        _StageTime[NumberOfPyramidStages];
+
+  /// Record execution time of stage for given level and image
+  void Time(PyramidStage stage, int l, int n, double t)
+  {
+    _StageTime[stage][l * _Input->size() + n] += t;
+  }
+};
+
+// -----------------------------------------------------------------------------
+/// Task which derives the image of a coarser level from the first level
+class DownsampleImageTask
+{
+  ImagePyramidTaskData *_Data;
+  int                   _Level;
+  int                   _Index;
+
+public:
+
+  DownsampleImageTask(ImagePyramidTaskData *data, int l, int n)
+  :
+    _Data(data), _Level(l), _Index(n)
+  {}
+
+  void operator ()() const
+  {
+    const double t = PyramidTime();
+    blocked_range<int> image(_Index, _Index + 1);
+    if (_Data->_UseGaussianResolutionPyramid) {
+      DownsampleImages downsample(*_Data->_Image, _Level, _Data->_DownsamplePadding);
+      downsample(image);
+    } else if (_Data->_CropPadImages) {
+      CropImages crop(*_Data->_Input, *_Data->_Background, _Data->_Blurring[_Level], (*_Data->_Image)[_Level]);
+      crop(image);
+    } else {
+      CopyImages copy((*_Data->_Image)[1], (*_Data->_Image)[_Level]);
+      copy(image);
+    }
+    _Data->Time(PyramidDownsample, _Level, _Index, PyramidTime() - t);
+  }
+};
+
+// -----------------------------------------------------------------------------
+/// Task which blurs and resamples the image of one level
+class BlurAndResampleImageTask
+{
+  ImagePyramidTaskData *_Data;
+  int                   _Level;
+  int                   _Index;
+
+public:
+
+  BlurAndResampleImageTask(ImagePyramidTaskData *data, int l, int n)
+  :
+    _Data(data), _Level(l), _Index(n)
+  {}
+
+  void operator ()() const
+  {
+    const int &l = _Level, &n = _Index;
+    blocked_range2d<int> image(l, l + 1, n, n + 1);
+    ResampledImageType &output = (*_Data->_Image)[l][n];
+    // Blur image (by default only if no Gaussian pyramid is used)
+    double t = PyramidTime();
+    if (_Data->_Blurring[l][n] > .0) {
+      BlurImages blur(*_Data->_Image, _Data->_Blurring, _Data->_DownsamplePadding);
+      blur(image);
+    }
+    _Data->Time(PyramidBlur, l, n, PyramidTime() - t);
+    // Resample image after blurring if no Gaussian pyramid is used
+    t = PyramidTime();
+    if (_Data->_UseGaussianResolutionPyramid) {
+      _Data->_Resolution[l][n]._x = output.GetXSize();
+      _Data->_Resolution[l][n]._y = output.GetYSize();
+      _Data->_Resolution[l][n]._z = output.GetZSize();
+    } else {
+      ResampleImages resample(*_Data->_Image, _Data->_Resolution, _Data->_DownsamplePadding);
+      resample(image);
+    }
+    // From now on, use padding value as background value
+    output.PutBackgroundValueAsDouble((*_Data->_Padding)[n]);
+    _Data->Time(PyramidResample, l, n, PyramidTime() - t);
+  }
+};
+
+// -----------------------------------------------------------------------------
+/// Task which constructs the resolution pyramid of one input image
+///
+/// The images of the coarser levels are derived from the first level in
+/// parallel, before all levels are blurred and resampled in parallel.
+/// The image filters executed by these tasks are themselves parallelized.
+class ImagePyramidTask
+{
+  ImagePyramidTaskData *_Data;
+  int                   _Index;
+
+public:
+
+  ImagePyramidTask(ImagePyramidTaskData *data, int n)
+  :
+    _Data(data), _Index(n)
+  {}
+
+  void operator ()() const
+  {
+    const int &n = _Index;
+    // Copy/cast foreground of input image
+    const double t = PyramidTime();
+    blocked_range<int> image(n, n + 1);
+    if (_Data->_CropPadImages) {
+      CropImages crop(*_Data->_Input, *_Data->_Background, _Data->_Blurring[1], (*_Data->_Image)[1]);
+      crop(image);
+    } else {
+      PadImages pad(*_Data->_Input, *_Data->_Background, (*_Data->_Image)[1]);
+      pad(image);
+    }
+    _Data->Time(PyramidCrop, 1, n, PyramidTime() - t);
+    // Derive coarser levels from first level
+    task_group downsample;
+    for (int l = 2; l <= _Data->_NumberOfLevels; ++l) {
+      downsample.run(DownsampleImageTask(_Data, l, n));
+    }
+    downsample.wait();
+    // Blur and resample all levels
+    task_group resample;
+    for (int l = 1; l <= _Data->_NumberOfLevels; ++l) {
+      resample.run(BlurAndResampleImageTask(_Data, l, n));
+    }
+    resample.wait();
+  }
+};
+
 // -----------------------------------------------------------------------------
 // Functor types used by InitializePointSets
 // -----------------------------------------------------------------------------
@@ -593,6 +763,84 @@ public:
 } // namespace irtkGenericRegistrationFilterUtils
 using namespace irtkGenericRegistrationFilterUtils;
 
+// =============================================================================
+// Image pyramid cache
+// =============================================================================
+
+// -----------------------------------------------------------------------------
+bool irtkGenericRegistrationFilter::ImagePyramid
+::SameSettings(const ImagePyramid &other) const
+{
+  if (_NumberOfLevels               != other._NumberOfLevels               ||
+      _Padding                      != other._Padding                      ||
+      _Background                   != other._Background                   ||
+      _DownsampleWithPadding        != other._DownsampleWithPadding        ||
+      _CropPadImages                != other._CropPadImages                ||
+      _UseGaussianResolutionPyramid != other._UseGaussianResolutionPyramid ||
+      _Blurring                     != other._Blurring) {
+    return false;
+  }
+  if (_Resolution.size() != other._Resolution.size()) return false;
+  for (size_t l = 0; l < _Resolution.size(); ++l) {
+    if (_Resolution[l] != other._Resolution[l]) return false;
+  }
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+void irtkGenericRegistrationFilter::ImagePyramidCache
+::AddImage(const irtkBaseImage *image)
+{
+  std::lock_guard<std::mutex> lock(_Mutex);
+  _Pyramid[image];
+}
+
+// -----------------------------------------------------------------------------
+bool irtkGenericRegistrationFilter::ImagePyramidCache
+::Contains(const irtkBaseImage *image) const
+{
+  std::lock_guard<std::mutex> lock(_Mutex);
+  return _Pyramid.find(image) != _Pyramid.end();
+}
+
+// -----------------------------------------------------------------------------
+bool irtkGenericRegistrationFilter::ImagePyramidCache
+::Find(const irtkBaseImage *image, ImagePyramid &pyramid) const
+{
+  std::lock_guard<std::mutex> lock(_Mutex);
+  map<const irtkBaseImage *, vector<ImagePyramid> >::const_iterator it = _Pyramid.find(image);
+  if (it != _Pyramid.end()) {
+    for (size_t i = 0; i < it->second.size(); ++i) {
+      if (it->second[i].SameSettings(pyramid)) {
+        pyramid = it->second[i];
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+// -----------------------------------------------------------------------------
+void irtkGenericRegistrationFilter::ImagePyramidCache
+::Insert(const irtkBaseImage *image, const ImagePyramid &pyramid)
+{
+  std::lock_guard<std::mutex> lock(_Mutex);
+  map<const irtkBaseImage *, vector<ImagePyramid> >::iterator it = _Pyramid.find(image);
+  if (it != _Pyramid.end()) {
+    for (size_t i = 0; i < it->second.size(); ++i) {
+      if (it->second[i].SameSettings(pyramid)) return;
+    }
+    it->second.push_back(pyramid);
+  }
+}
+
+// -----------------------------------------------------------------------------
+void irtkGenericRegistrationFilter::ImagePyramidCache::Clear()
+{
+  std::lock_guard<std::mutex> lock(_Mutex);
+  _Pyramid.clear();
+}
+
 // =============================================================================
 // Construction/Destruction
 // =============================================================================
@@ -685,6 +933,7 @@ irtkGenericRegistrationFilter::irtkGenericRegistrationFilter()
   irtkRegistrationFilter(),
   _InitialGuess  (NULL),
   _Domain        (NULL),
+  _PyramidCache  (NULL),
   _Transformation(NULL),
   _Optimizer     (NULL)
 {
@@ -2075,13 +2324,17 @@ void irtkGenericRegistrationFilter::Write(const char *fname) const
 // -----------------------------------------------------------------------------
 void irtkGenericRegistrationFilter::Run()
 {
+  IRTK_PROFILE_REGION("registration");
   IRTK_START_TIMING();
 
   // Guess parameters not specified by user
   this->GuessParameter();
 
   // Initialize image resolution pyramid
-  this->InitializePyramid();
+  {
+    IRTK_PROFILE_REGION("initialization of image pyramid");
+    this->InitializePyramid();
+  }
   this->InitializePointSets();
 
   // Make initial guess of transformation if none provided
@@ -2094,6 +2347,7 @@ void irtkGenericRegistrationFilter::Run()
   irtkIteration model(0, _TransformationModel.size());
   while (!model.End()) {
     _CurrentModel = _TransformationModel[model.Iter()];
+    IRTK_PROFILE_REGION(ToString(_CurrentModel) + " model");
 
     // Broadcast status message
     if (_TransformationModel.size() > 1) {
@@ -2132,19 +2386,29 @@ void irtkGenericRegistrationFilter::MultiResolutionOptimization()
   irtkIteration level(_NumberOfLevels, 0);
   while (!level.End()) {
     _CurrentLevel = level.Iter();
+    IRTK_PROFILE_REGION("level " + ToString(_CurrentLevel));
     IRTK_START_TIMING();
 
     // Initialize registration at current resolution
     Broadcast(InitEvent, &level);
-    this->Initialize();
+    {
+      IRTK_PROFILE_REGION("initialization");
+      this->Initialize();
+    }
 
     // Solve registration problem by optimizing energy function
     Broadcast(StartEvent, &level);
-    _Optimizer->Run();
+    {
+      IRTK_PROFILE_REGION("optimization");
+      _Optimizer->Run();
+    }
     Broadcast(EndEvent, &level);
 
     // Finalize registration at current resolution
-    this->Finalize();
+    {
+      IRTK_PROFILE_REGION("finalization");
+      this->Finalize();
+    }
     Broadcast(FinishEvent, &level);
 
     IRTK_DEBUG_TIMING(2, "registration at level " << level.Iter());
@@ -2194,10 +2458,8 @@ void irtkGenericRegistrationFilter::InitializePyramid()
   _Image.resize(_NumberOfLevels + 1);
 
   // Note: Level indices are in the range [1, N]
-  blocked_range  <int> images (0,  NumberOfImages());
-  blocked_range  <int> levels (1, _NumberOfLevels+1);
-  blocked_range2d<int> pyramid(1, _NumberOfLevels+1, 0, NumberOfImages());
-  const blocked_range<int> &level = images;
+  blocked_range<int> images(0,  NumberOfImages());
+  blocked_range<int> levels(1, _NumberOfLevels+1);
 
   if (NumberOfImages() > 0) {
 
@@ -2218,21 +2480,8 @@ void irtkGenericRegistrationFilter::InitializePyramid()
       _Image[l].resize(NumberOfImages());
     }
 
-    // Copy/cast foreground of input images
-    if (_CropPadImages) {
-      Broadcast(LogEvent, "Crop/pad images .........");
-      CropImages crop(_Input, _Background, _Blurring[1], _Image[1]);
-      parallel_for(images, crop);
-    } else {
-      Broadcast(LogEvent, "Padding images ..........");
-      PadImages pad(_Input, _Background, _Image[1]);
-      parallel_for(images, pad);
-    }
-    Broadcast(LogEvent, " done\n");
-
-    IRTK_DEBUG_TIMING(1, (_CropPadImages ? "cropping" : "padding") << " of images");
-    IRTK_RESET_TIMING();
-
+    // Construct resolution pyramid of each image in parallel
+    //
     // Resample images to current resolution
     //
     // The images are in fact resampled after each step by the respective
@@ -2252,69 +2501,91 @@ void irtkGenericRegistrationFilter::InitializePyramid()
     // the foreground and is faster. However, in particular for low resolutions,
     // the edges of the images downsampled without considering the background
     // are smoother and may therefore better guide the optimization.
-    const vector<double> *padding = _DownsampleWithPadding ? &_Padding : NULL;
-
+    //
     // Downsample (blur and resample by factor 2) if Gaussian pyramid is used
     // Otherwise just copy first level to remaining levels which will be
     // blurred and resampled by the following processing steps. Optionally,
     // the images are cropped to minimal foreground size while being copied.
-    if (_UseGaussianResolutionPyramid && _NumberOfLevels > 1) {
-      Broadcast(LogEvent, "Downsample images .......");
-      if (debug_time) Broadcast(LogEvent, "\n");
-    }
-    for (int l = 2; l <= _NumberOfLevels; ++l) {
-      if (_UseGaussianResolutionPyramid) {
-        DownsampleImages downsample(_Image, l, padding);
-        parallel_for(level, downsample);
-      } else if (_CropPadImages) {
-        CropImages crop(_Input, _Background, _Blurring[l], _Image[l]);
-        parallel_for(level, crop);
-      } else {
-        CopyImages copy(_Image[1], _Image[l]);
-        parallel_for(level, copy);
+    //
+    // The steps are executed as tasks per image and level such that all
+    // cores are used even when only few images are registered.
+    Broadcast(LogEvent, "Build image pyramid .....");
+
+    // Copy pyramids of resident input images shared with other registrations
+    vector<ImagePyramid> pyramid(NumberOfImages());
+    vector<bool>         cached (NumberOfImages(), false);
+    if (_PyramidCache) {
+      for (int n = 0; n < NumberOfImages(); ++n) {
+        ImagePyramid &p = pyramid[n];
+        p._NumberOfLevels               = _NumberOfLevels;
+        p._Padding                      = _Padding[n];
+        p._Background                   = _Background[n];
+        p._DownsampleWithPadding        = _DownsampleWithPadding;
+        p._CropPadImages                = _CropPadImages;
+        p._UseGaussianResolutionPyramid = _UseGaussianResolutionPyramid;
+        p._Blurring  .resize(_NumberOfLevels + 1, .0);
+        p._Resolution.resize(_NumberOfLevels + 1);
+        for (int l = 1; l <= _NumberOfLevels; ++l) {
+          p._Blurring  [l] = _Blurring  [l][n];
+          p._Resolution[l] = _Resolution[l][n];
+        }
+        if (_PyramidCache->Find(_Input[n], p)) {
+          for (int l = 1; l <= _NumberOfLevels; ++l) {
+            _Image     [l][n] = p._Image[l];
+            _Resolution[l][n] = p._OutputResolution[l];
+          }
+          cached[n] = true;
+        }
       }
     }
-    if (_UseGaussianResolutionPyramid && _NumberOfLevels > 1) {
-      if (debug_time) Broadcast(LogEvent, "Downsample images .......");
-      Broadcast(LogEvent, " done\n");
-    }
 
-    // Blur images (by default only if no Gaussian pyramid is used)
-    bool anything_to_blur = false;
-    for (int l = 1; l <= _NumberOfLevels;   ++l)
-    for (int n = 0; n <   NumberOfImages(); ++n) {
-      if (_Blurring[l][n] > .0) anything_to_blur = true;
+    ImagePyramidTaskData data;
+    data._Input                        = &_Input;
+    data._Padding                      = &_Padding;
+    data._Background                   = &_Background;
+    data._DownsamplePadding            = _DownsampleWithPadding ? &_Padding : NULL;
+    data._Blurring                     = _Blurring;
+    data._Resolution                   = _Resolution;
+    data._Image                        = &_Image;
+    data._NumberOfLevels               = _NumberOfLevels;
+    data._CropPadImages                = _CropPadImages;
+    data._UseGaussianResolutionPyramid = _UseGaussianResolutionPyramid;
+    for (int i = 0; i < NumberOfPyramidStages; ++i) {
+      data._StageTime[i].resize((_NumberOfLevels + 1) * NumberOfImages(), .0);
     }
-    if (anything_to_blur) {
-      Broadcast(LogEvent, "Blurring images .........");
-      if (debug_time) Broadcast(LogEvent, "\n");
-      BlurImages blur(_Image, _Blurring, padding);
-      parallel_for(pyramid, blur);
-      if (debug_time) Broadcast(LogEvent, "Blurring images .........");
-      Broadcast(LogEvent, " done\n");
+    task_group pyramid_tasks;
+    for (int n = 0; n < NumberOfImages(); ++n) {
+      if (!cached[n]) pyramid_tasks.run(ImagePyramidTask(&data, n));
     }
+    pyramid_tasks.wait();
 
-    // Resample images after blurring if no Gaussian pyramid is used
-    if (_UseGaussianResolutionPyramid) {
-      for (int l = 1; l <= _NumberOfLevels;   ++l)
-      for (int n = 0; n <   NumberOfImages(); ++n) {
-        _Resolution[l][n]._x = _Image[l][n].GetXSize();
-        _Resolution[l][n]._y = _Image[l][n].GetYSize();
-        _Resolution[l][n]._z = _Image[l][n].GetZSize();
+    // Store pyramids of resident input images for use by other registrations
+    if (_PyramidCache) {
+      for (int n = 0; n < NumberOfImages(); ++n) {
+        if (cached[n] || !_PyramidCache->Contains(_Input[n])) continue;
+        ImagePyramid &p = pyramid[n];
+        p._Image           .resize(_NumberOfLevels + 1);
+        p._OutputResolution.resize(_NumberOfLevels + 1);
+        for (int l = 1; l <= _NumberOfLevels; ++l) {
+          p._Image           [l] = _Image     [l][n];
+          p._OutputResolution[l] = _Resolution[l][n];
+        }
+        _PyramidCache->Insert(_Input[n], p);
       }
-    } else {
-      Broadcast(LogEvent, "Resample images .........");
-      if (debug_time) Broadcast(LogEvent, "\n");
-      ResampleImages resample(_Image, _Resolution, padding);
-      parallel_for(pyramid, resample);
-      if (debug_time) Broadcast(LogEvent, "Resample images .........");
-      Broadcast(LogEvent, " done\n");
     }
+    Broadcast(LogEvent, " done\n");
 
-    // From now on, use padding value as background value
-    for (int l = 1; l <= _NumberOfLevels;   ++l)
-    for (int n = 0; n <   NumberOfImages(); ++n) {
-      _Image[l][n].PutBackgroundValueAsDouble(_Padding[n]);
+    // Report accumulated execution time of each stage
+    if (debug_time >= 2) {
+      const char *stage_name[NumberOfPyramidStages] = {
+        _CropPadImages ? "cropping of images" : "padding of images",
+        "downsampling of images", "blurring of images", "resampling of images"
+      };
+      for (int i = 0; i < NumberOfPyramidStages; ++i) {
+        double t = .0;
+        for (size_t j = 0; j < data._StageTime[i].size(); ++j) t += data._StageTime[i][j];
+        PrintElapsedTime((string(stage_name[i]) + " (sum over tasks)").c_str(), t);
+      }
     }
   } // if (NumberOfImages() > 0)
 
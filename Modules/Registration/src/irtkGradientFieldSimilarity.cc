@@ -346,6 +346,16 @@ public:
 
 }; // AddOtherPartialDerivativesOfFFD
 
+// -----------------------------------------------------------------------------
+/// Copy transformed 1st order derivatives of registered image
+void CopyTransformedGradient(irtkGenericImage<double> &dIdy, const irtkRegisteredImage *image)
+{
+  const irtkRegisteredImage::VoxelType *dI = image->Data(0, 0, 0, 1);
+  double                               *g  = dIdy.Data();
+  const int                             n  = dIdy.NumberOfVoxels();
+  for (int idx = 0; idx < n; ++idx) g[idx] = static_cast<double>(dI[idx]);
+}
+
 
 } // namespace irtkGradientFieldSimilarityUtils
 using namespace irtkGradientFieldSimilarityUtils;
@@ -614,7 +624,7 @@ void irtkGradientFieldSimilarity::Update(bool hessian)
       if (_InitialUpdate) {
         _TargetTransformedGradient.Initialize(_Target->Attributes(), 3);
       }
-      _TargetTransformedGradient.CopyFrom(_Target->Data(0, 0, 0, 1));
+      CopyTransformedGradient(_TargetTransformedGradient, _Target);
     }
 
     // Reorient gradient and hessian (if needed) of the target image according
@@ -630,7 +640,7 @@ void irtkGradientFieldSimilarity::Update(bool hessian)
       if (_InitialUpdate) {
         _SourceTransformedGradient.Initialize(_Source->Attributes(), 3);
       }
-      _SourceTransformedGradient.CopyFrom(_Source->Data(0, 0, 0, 1));
+      CopyTransformedGradient(_SourceTransformedGradient, _Source);
     }
 
     // Reorient gradient and hessian (if needed) of the source image according
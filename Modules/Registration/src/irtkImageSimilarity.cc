@@ -262,6 +262,149 @@ public:
 };
 
 
+// -----------------------------------------------------------------------------
+/// Edge length of image tiles used to track changed image regions
+const int ChangedTileSize = 8;
+
+// -----------------------------------------------------------------------------
+/// Maximum fraction of voxels for which the similarity is updated incrementally
+const double MaxChangedFraction = .5;
+
+// -----------------------------------------------------------------------------
+/// Coarse grid of image tiles which need to be updated
+class ChangedTiles
+{
+  int          _X, _Y, _Z;
+  int          _NumberOfTilesX;
+  int          _NumberOfTilesY;
+  int          _NumberOfTilesZ;
+  vector<char> _Changed;
+
+public:
+
+  /// Constructor
+  ChangedTiles(int nx, int ny, int nz)
+  :
+    _X(nx), _Y(ny), _Z(nz),
+    _NumberOfTilesX((nx + ChangedTileSize - 1) / ChangedTileSize),
+    _NumberOfTilesY((ny + ChangedTileSize - 1) / ChangedTileSize),
+    _NumberOfTilesZ((nz + ChangedTileSize - 1) / ChangedTileSize),
+    _Changed(_NumberOfTilesX * _NumberOfTilesY * _NumberOfTilesZ, 0)
+  {}
+
+  /// Mark tiles overlapping with the given voxel box [i1, i2] x [j1, j2] x [k1, k2]
+  void Mark(int i1, int j1, int k1, int i2, int j2, int k2)
+  {
+    i1 /= ChangedTileSize, i2 /= ChangedTileSize;
+    j1 /= ChangedTileSize, j2 /= ChangedTileSize;
+    k1 /= ChangedTileSize, k2 /= ChangedTileSize;
+    for (int k = k1; k <= k2; ++k)
+    for (int j = j1; j <= j2; ++j) {
+      char *changed = &_Changed[(k * _NumberOfTilesY + j) * _NumberOfTilesX];
+      for (int i = i1; i <= i2; ++i) changed[i] = 1;
+    }
+  }
+
+  /// Mark tiles affected by changed parameters of the given FFD
+  ///
+  /// \param[in] image Moving image.
+  /// \param[in] ffd   Free-form deformation.
+  /// \param[in] dofs  Parameters of \p ffd at last update of \p image.
+  void Mark(const irtkRegisteredImage        *image,
+            const irtkFreeFormTransformation *ffd,
+            const double                     *dofs)
+  {
+    int x, y, z, i1, j1, k1, i2, j2, k2;
+    for (int cp = 0; cp < ffd->NumberOfCPs(); ++cp) {
+      ffd->IndexToDOFs(cp, x, y, z);
+      if (ffd->Get(x) != dofs[x] || ffd->Get(y) != dofs[y] || ffd->Get(z) != dofs[z]) {
+        if (ffd->BoundingBox(image, cp, i1, j1, k1, i2, j2, k2)) {
+          Mark(i1, j1, k1, i2, j2, k2);
+        }
+      }
+    }
+  }
+
+  /// Mark tiles affected by changed parameters of the image transformation
+  ///
+  /// \param[in] image Moving image.
+  /// \param[in] dofs  Transformation parameters at last update of \p image.
+  ///
+  /// \returns Whether the changed image regions are confined to the support
+  ///          of the changed control points of a free-form deformation.
+  bool Mark(const irtkRegisteredImage *image, const vector<double> &dofs)
+  {
+    const irtkTransformation *T = image->Transformation();
+    if (!image->SelfUpdate() || T->RequiresCachingOfDisplacements()) return false;
+    if (static_cast<int>(dofs.size()) != T->NumberOfDOFs()) return false;
+    if (dofs.empty()) return true;
+
+    const irtkMultiLevelFreeFormTransformation *mffd = NULL;
+    const irtkFreeFormTransformation           *ffd  = NULL;
+    (mffd = dynamic_cast<const irtkMultiLevelFreeFormTransformation *>(T)) ||
+    (ffd  = dynamic_cast<const irtkFreeFormTransformation           *>(T));
+
+    if (mffd) {
+      for (int i = 0; i < mffd->NumberOfLevels(); ++i) {
+        if (mffd->LocalTransformationIsActive(i)) {
+          if (!mffd->GetLocalTransformation(i)->IsDisplacementParameterized()) return false;
+        }
+      }
+      const double *level_dofs = &dofs[0];
+      for (int i = 0; i < mffd->NumberOfLevels(); ++i) {
+        if (mffd->LocalTransformationIsActive(i)) {
+          ffd = mffd->GetLocalTransformation(i);
+          Mark(image, ffd, level_dofs);
+          level_dofs += ffd->NumberOfDOFs();
+        }
+      }
+    } else if (ffd) {
+      if (!ffd->IsDisplacementParameterized()) return false;
+      Mark(image, ffd, &dofs[0]);
+    } else {
+      return false;
+    }
+    return true;
+  }
+
+  /// Number of voxels within changed tiles
+  int NumberOfVoxels() const
+  {
+    int n = 0;
+    for (int k = 0; k < _NumberOfTilesZ; ++k)
+    for (int j = 0; j < _NumberOfTilesY; ++j)
+    for (int i = 0; i < _NumberOfTilesX; ++i) {
+      if (_Changed[(k * _NumberOfTilesY + j) * _NumberOfTilesX + i]) {
+        n += (min((i + 1) * ChangedTileSize, _X) - i * ChangedTileSize) *
+             (min((j + 1) * ChangedTileSize, _Y) - j * ChangedTileSize) *
+             (min((k + 1) * ChangedTileSize, _Z) - k * ChangedTileSize);
+      }
+    }
+    return n;
+  }
+
+  /// Get changed image regions, consecutive tiles along x are merged
+  void Regions(vector<blocked_range3d<int> > &regions) const
+  {
+    regions.clear();
+    for (int k = 0; k < _NumberOfTilesZ; ++k)
+    for (int j = 0; j < _NumberOfTilesY; ++j) {
+      const char *changed = &_Changed[(k * _NumberOfTilesY + j) * _NumberOfTilesX];
+      for (int i = 0; i < _NumberOfTilesX; ++i) {
+        if (!changed[i]) continue;
+        const int i1 = i;
+        while (i + 1 < _NumberOfTilesX && changed[i + 1]) ++i;
+        regions.push_back(blocked_range3d<int>(
+          k  * ChangedTileSize, min((k + 1) * ChangedTileSize, _Z),
+          j  * ChangedTileSize, min((j + 1) * ChangedTileSize, _Y),
+          i1 * ChangedTileSize, min((i + 1) * ChangedTileSize, _X)
+        ));
+      }
+    }
+  }
+};
+
+
 } // namespace irtkImageSimilarityUtils
 using namespace irtkImageSimilarityUtils;
 
@@ -275,11 +418,13 @@ irtkImageSimilarity::irtkImageSimilarity(const char *name, double weight)
   irtkDataFidelity(name, weight),
   _Target                  (new irtkRegisteredImage()),
   _Source                  (new irtkRegisteredImage()),
+  _Mask                    (NULL),
   _GradientWrtTarget       (NULL),
   _GradientWrtSource       (NULL),
   _Gradient                (NULL),
   _NumberOfVoxels          (0),
   _UseApproximateGradient  (false),
+  _IncrementalUpdate       (true),
   _VoxelWisePreconditioning(.0),
   _NodeBasedPreconditioning(.0),
   _InitialUpdate           (false)
@@ -298,11 +443,14 @@ irtkImageSimilarity::irtkImageSimilarity(const irtkImageSimilarity &other)
   irtkDataFidelity(other),
   _Target           (other._Target ? new irtkRegisteredImage(*other._Target) : NULL),
   _Source           (other._Source ? new irtkRegisteredImage(*other._Source) : NULL),
+  _Domain                  (other._Domain),
+  _Mask                    (other._Mask),
   _GradientWrtTarget       (NULL),
   _GradientWrtSource       (NULL),
   _Gradient                (NULL),
   _NumberOfVoxels          (other._NumberOfVoxels),
   _UseApproximateGradient  (other._UseApproximateGradient),
+  _IncrementalUpdate       (other._IncrementalUpdate),
   _VoxelWisePreconditioning(other._VoxelWisePreconditioning),
   _NodeBasedPreconditioning(other._NodeBasedPreconditioning),
   _InitialUpdate           (other._InitialUpdate)
@@ -320,11 +468,16 @@ irtkImageSimilarity &irtkImageSimilarity::operator =(const irtkImageSimilarity &
   Deallocate(_Gradient);
   _Target = other._Target ? new irtkRegisteredImage(*other._Target) : NULL;
   _Source = other._Source ? new irtkRegisteredImage(*other._Source) : NULL;
+  _Domain                   = other._Domain;
+  _Mask                     = other._Mask;
   _NumberOfVoxels           = other._NumberOfVoxels;
   _UseApproximateGradient   = other._UseApproximateGradient;
+  _IncrementalUpdate        = other._IncrementalUpdate;
   _VoxelWisePreconditioning = other._VoxelWisePreconditioning;
   _NodeBasedPreconditioning = other._NodeBasedPreconditioning;
   _InitialUpdate            = other._InitialUpdate;
+  _TargetDOFs.clear();
+  _SourceDOFs.clear();
   return *this;
 }
 
@@ -376,6 +529,8 @@ void irtkImageSimilarity::Initialize()
   // Initialize registered images
   this->InitializeInput(_Mask ? _Mask->Attributes() : _Domain);
   _InitialUpdate = true; // i.e., initialize image content upon first Update
+  _TargetDOFs.clear();
+  _SourceDOFs.clear();
   // Allocate memory for temporary similarity gradient
   if (_NodeBasedPreconditioning > .0) {
     const irtkTransformation *T1 = _Target->Transformation();
@@ -400,6 +555,9 @@ bool irtkImageSimilarity::Set(const char *param, const char *value)
   if (name == "Approximate gradient") {
     return FromString(value, _UseApproximateGradient);
   }
+  if (name == "Incremental update") {
+    return FromString(value, _IncrementalUpdate);
+  }
   if (name == "Preconditioning (voxel-wise)") {
     return FromString(value, _VoxelWisePreconditioning);
   }
@@ -434,6 +592,7 @@ irtkParameterList irtkImageSimilarity::Parameter() const
   irtkParameterList params = irtkDataFidelity::Parameter();
   if (!_Name.empty()) {
     Insert(params, _Name + " approximate gradient",         ToString(_UseApproximateGradient));
+    Insert(params, _Name + " incremental update",           ToString(_IncrementalUpdate));
     Insert(params, _Name + " preconditioning (voxel-wise)", ToString(_VoxelWisePreconditioning));
     Insert(params, _Name + " preconditioning (node-based)", ToString(_NodeBasedPreconditioning));
     Insert(params, _Name + " blurring of image gradient",   ToString(_Target->GradientSigma()));
@@ -456,6 +615,60 @@ void irtkImageSimilarity::Update(bool gradient)
     _Source->Update(true, gradient, false, _InitialUpdate);
   }
   _InitialUpdate = false;
+  RecordDOFs();
+}
+
+// -----------------------------------------------------------------------------
+void irtkImageSimilarity::RecordDOFs()
+{
+  if (!_IncrementalUpdate) return;
+  const irtkTransformation *T1 = _Target->Transformation();
+  const irtkTransformation *T2 = _Source->Transformation();
+  if (T1) {
+    _TargetDOFs.resize(T1->NumberOfDOFs());
+    if (!_TargetDOFs.empty()) T1->Get(&_TargetDOFs[0]);
+  }
+  if (T2) {
+    _SourceDOFs.resize(T2->NumberOfDOFs());
+    if (!_SourceDOFs.empty()) T2->Get(&_SourceDOFs[0]);
+  }
+}
+
+// -----------------------------------------------------------------------------
+bool irtkImageSimilarity::UpdateChangedRegions()
+{
+  if (!_IncrementalUpdate || _InitialUpdate) return false;
+
+  const irtkTransformation *T1 = _Target->Transformation();
+  const irtkTransformation *T2 = _Source->Transformation();
+  if (!T1 && !T2) return false;
+
+  IRTK_START_TIMING();
+
+  // Determine image regions affected by changed transformation parameters
+  ChangedTiles tiles(_Target->X(), _Target->Y(), _Target->Z());
+  if (T1 && !tiles.Mark(_Target, _TargetDOFs)) return false;
+  if (T2 && !tiles.Mark(_Source, _SourceDOFs)) return false;
+
+  // Fall back to full update if most of the image domain has changed
+  const int n = tiles.NumberOfVoxels();
+  if (n > MaxChangedFraction * _Target->NumberOfSpatialVoxels()) return false;
+
+  // Exclude changed regions, resample moving image(s) and include them again
+  if (n > 0) {
+    vector<blocked_range3d<int> > regions;
+    tiles.Regions(regions);
+    this->ExcludeRegions(regions);
+    for (size_t r = 0; r < regions.size(); ++r) {
+      if (T1) _Target->Update(regions[r], true, false, false);
+      if (T2) _Source->Update(regions[r], true, false, false);
+    }
+    this->IncludeRegions(regions);
+  }
+  RecordDOFs();
+
+  IRTK_DEBUG_TIMING(2, "incremental update of " << n << " voxels");
+  return true;
 }
 
 // -----------------------------------------------------------------------------
@@ -470,6 +683,18 @@ void irtkImageSimilarity::Include(const blocked_range3d<int> &)
   this->Update(false);
 }
 
+// -----------------------------------------------------------------------------
+void irtkImageSimilarity::ExcludeRegions(const vector<blocked_range3d<int> > &regions)
+{
+  for (size_t r = 0; r < regions.size(); ++r) this->Exclude(regions[r]);
+}
+
+// -----------------------------------------------------------------------------
+void irtkImageSimilarity::IncludeRegions(const vector<blocked_range3d<int> > &regions)
+{
+  for (size_t r = 0; r < regions.size(); ++r) this->Include(regions[r]);
+}
+
 // -----------------------------------------------------------------------------
 void irtkImageSimilarity::MultiplyByImageGradient(const irtkRegisteredImage *image,
                                                   GradientImageType         *gradient)
@@ -17,6 +17,76 @@
 #include <irtkIntensityCrossCorrelation.h>
 
 
+// =============================================================================
+// Auxiliary functors
+// =============================================================================
+
+namespace irtkIntensityCrossCorrelationUtils {
+
+
+// -----------------------------------------------------------------------------
+// Types
+typedef irtkIntensityCrossCorrelation::VoxelType VoxelType;
+
+// -----------------------------------------------------------------------------
+/// Sum the intensities, their products and squares
+struct EvaluateCrossCorrelationSums : public irtkVoxelReduction
+{
+  irtkIntensityCrossCorrelation *_Sim;
+  double                         _SumT, _SumS, _SumTS, _SumT2, _SumS2;
+  int                            _Cnt;
+
+  EvaluateCrossCorrelationSums(irtkIntensityCrossCorrelation *sim)
+  :
+    _Sim(sim), _SumT(.0), _SumS(.0), _SumTS(.0), _SumT2(.0), _SumS2(.0), _Cnt(0)
+  {}
+
+  EvaluateCrossCorrelationSums(const EvaluateCrossCorrelationSums &rhs)
+  :
+    _Sim  (rhs._Sim),
+    _SumT (rhs._SumT),
+    _SumS (rhs._SumS),
+    _SumTS(rhs._SumTS),
+    _SumT2(rhs._SumT2),
+    _SumS2(rhs._SumS2),
+    _Cnt  (rhs._Cnt)
+  {}
+
+  void split(const EvaluateCrossCorrelationSums &)
+  {
+    _SumT = _SumS = _SumTS = _SumT2 = _SumS2 = .0;
+    _Cnt  = 0;
+  }
+
+  void join(const EvaluateCrossCorrelationSums &rhs)
+  {
+    _SumT  += rhs._SumT;
+    _SumS  += rhs._SumS;
+    _SumTS += rhs._SumTS;
+    _SumT2 += rhs._SumT2;
+    _SumS2 += rhs._SumS2;
+    _Cnt   += rhs._Cnt;
+  }
+
+  void operator ()(int i, int j, int k, int, const VoxelType *t, const VoxelType *s)
+  {
+    if (_Sim->IsForeground(i, j, k)) {
+      const double a = static_cast<double>(*t);
+      const double b = static_cast<double>(*s);
+      _SumT  += a;
+      _SumS  += b;
+      _SumTS += a * b;
+      _SumT2 += a * a;
+      _SumS2 += b * b;
+      ++_Cnt;
+    }
+  }
+};
+
+
+} // namespace irtkIntensityCrossCorrelationUtils
+using namespace irtkIntensityCrossCorrelationUtils;
+
 // =============================================================================
 // Construction/Destruction
 // =============================================================================
@@ -25,7 +95,8 @@
 irtkIntensityCrossCorrelation
 ::irtkIntensityCrossCorrelation(const char *name)
 :
-  irtkImageSimilarity(name)
+  irtkImageSimilarity(name),
+  _SumT(.0), _SumS(.0), _SumTS(.0), _SumT2(.0), _SumS2(.0), _N(0)
 {
 }
 
@@ -33,7 +104,13 @@ irtkIntensityCrossCorrelation
 irtkIntensityCrossCorrelation
 ::irtkIntensityCrossCorrelation(const irtkIntensityCrossCorrelation &other)
 :
-  irtkImageSimilarity(other)
+  irtkImageSimilarity(other),
+  _SumT (other._SumT),
+  _SumS (other._SumS),
+  _SumTS(other._SumTS),
+  _SumT2(other._SumT2),
+  _SumS2(other._SumS2),
+  _N    (other._N)
 {
 }
 
@@ -42,31 +119,75 @@ irtkIntensityCrossCorrelation::~irtkIntensityCrossCorrelation()
 {
 }
 
+// =============================================================================
+// Initialization
+// =============================================================================
+
+// -----------------------------------------------------------------------------
+void irtkIntensityCrossCorrelation::Initialize()
+{
+  // Initialize base class
+  irtkImageSimilarity::Initialize();
+  // Reset sums
+  _SumT = _SumS = _SumTS = _SumT2 = _SumS2 = .0;
+  _N    = 0;
+}
+
 // =============================================================================
 // Evaluation
 // =============================================================================
 
 // -----------------------------------------------------------------------------
-double irtkIntensityCrossCorrelation::Evaluate()
+void irtkIntensityCrossCorrelation::Update(bool gradient)
 {
-  VoxelType *tgt = Target()->GetPointerToVoxels();
-  VoxelType *src = Source()->GetPointerToVoxels();
-
-  double x = .0, y = .0, xy = .0, x2 = .0, y2 = .0;
-  int    n =  0;
-  for (int idx = 0; idx < NumberOfVoxels(); ++idx) {
-    if (IsForeground(idx)) {
-      x  += *tgt;
-      y  += *src;
-      xy += (*tgt) * (*src);
-      x2 += (*tgt) * (*tgt);
-      y2 += (*tgt) * (*tgt);
-      ++n;
-    }
-  }
+  // Update only changed image regions and their sums if possible
+  if (!gradient && UpdateChangedRegions()) return;
+  // Update base class and moving image(s)
+  irtkImageSimilarity::Update(gradient);
+  // Evaluate sums over all voxels
+  EvaluateCrossCorrelationSums sums(this);
+  ParallelForEachVoxel(_Domain, _Target, _Source, sums);
+  _SumT  = sums._SumT;
+  _SumS  = sums._SumS;
+  _SumTS = sums._SumTS;
+  _SumT2 = sums._SumT2;
+  _SumS2 = sums._SumS2;
+  _N     = sums._Cnt;
+}
 
-  if (n == 0) return .0;
-  return (xy - (x * y) / n) / (sqrt(x2 - x * x / n) * sqrt(y2 - y *y / n));
+// -----------------------------------------------------------------------------
+void irtkIntensityCrossCorrelation::Exclude(const blocked_range3d<int> &region)
+{
+  EvaluateCrossCorrelationSums sums(this);
+  ParallelForEachVoxel(region, _Target, _Source, sums);
+  _SumT  -= sums._SumT;
+  _SumS  -= sums._SumS;
+  _SumTS -= sums._SumTS;
+  _SumT2 -= sums._SumT2;
+  _SumS2 -= sums._SumS2;
+  _N     -= sums._Cnt;
+}
+
+// -----------------------------------------------------------------------------
+void irtkIntensityCrossCorrelation::Include(const blocked_range3d<int> &region)
+{
+  EvaluateCrossCorrelationSums sums(this);
+  ParallelForEachVoxel(region, _Target, _Source, sums);
+  _SumT  += sums._SumT;
+  _SumS  += sums._SumS;
+  _SumTS += sums._SumTS;
+  _SumT2 += sums._SumT2;
+  _SumS2 += sums._SumS2;
+  _N     += sums._Cnt;
+}
+
+// -----------------------------------------------------------------------------
+double irtkIntensityCrossCorrelation::Evaluate()
+{
+  if (_N == 0) return .0;
+  const double n = static_cast<double>(_N);
+  return (_SumTS - (_SumT * _SumS) / n) / (sqrt(_SumT2 - _SumT * _SumT / n) *
+                                           sqrt(_SumS2 - _SumS * _SumS / n));
 }
 
 // -----------------------------------------------------------------------------
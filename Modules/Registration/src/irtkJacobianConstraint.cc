@@ -32,7 +32,7 @@ private:
 
   const irtkJacobianConstraint     *_This;
   const irtkFreeFormTransformation *_FFD;
-  irtkMatrix                       *_AdjJacobian;
+  irtkMatrix3x3                    *_AdjJacobian;
   double                           *_DetJacobian;
 
 public:
@@ -52,7 +52,7 @@ public:
   static void Run(const irtkJacobianConstraint     *obj,
                   const irtkFreeFormTransformation *ffd,
                   double                           *det,
-                  irtkMatrix                       *adj)
+                  irtkMatrix3x3                    *adj)
   {
     irtkJacobianConstraintUpdate body;
     body._This        = obj;
@@ -113,12 +113,12 @@ void irtkJacobianConstraint::Update(bool)
     Deallocate(_AdjJacobian);
     _NumberOfCPs = ncps;
     _DetJacobian = Allocate<double>    (ncps);
-    _AdjJacobian = Allocate<irtkMatrix>(ncps);
+    _AdjJacobian = Allocate<irtkMatrix3x3>(ncps);
   }
 
   if (mffd) {
     double     *det = _DetJacobian;
-    irtkMatrix *adj = _AdjJacobian;
+    irtkMatrix3x3 *adj = _AdjJacobian;
     for (int n = 0; n < mffd->NumberOfLevels(); ++n) {
       if (mffd->LocalTransformationIsActive(n)) {
         ffd = mffd->GetLocalTransformation(n);
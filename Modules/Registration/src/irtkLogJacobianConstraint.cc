@@ -31,7 +31,7 @@ private:
 
   const irtkLogJacobianConstraint  *_This;
   const irtkFreeFormTransformation *_FFD;
-  const irtkMatrix                 *_AdjJacobian;
+  const irtkMatrix3x3              *_AdjJacobian;
   const double                     *_DetJacobian;
   double                            _Penalty;
   int                               _N;
@@ -69,7 +69,7 @@ public:
   static void Run(const irtkLogJacobianConstraint  *obj,
                   const irtkFreeFormTransformation *ffd,
                   const double                     *det,
-                  const irtkMatrix                 *adj,
+                  const irtkMatrix3x3              *adj,
                   double                           &penalty,
                   int                              &num)
   {
@@ -92,16 +92,16 @@ struct irtkLogJacobianConstraintEvaluateGradient
 {
   const irtkBSplineFreeFormTransformation3D *_FFD;
   const double                              *_DetJacobian;
-  const irtkMatrix                          *_AdjJacobian;
+  const irtkMatrix3x3                       *_AdjJacobian;
   double                                    *_Gradient;
   double                                     _Weight;
   bool                                       _ConstrainPassiveDoFs;
 
   void operator()(const blocked_range3d<int> &re) const
   {
-    int        xdof, ydof, zdof, n, cp, i1, j1, k1, i2, j2, k2;
-    double     pendrv, pengrad[3];
-    irtkMatrix detdrv[3];
+    int           xdof, ydof, zdof, n, cp, i1, j1, k1, i2, j2, k2;
+    double        pendrv, pengrad[3];
+    irtkMatrix3x3 detdrv[3];
 
     // Loop over control points
     for (int ck = re.pages().begin(); ck != re.pages().end(); ++ck)
@@ -134,7 +134,7 @@ struct irtkLogJacobianConstraintEvaluateGradient
 
           // Apply chain rule and Jacobi's formula
           // (cf. https://en.wikipedia.org/wiki/Jacobi's_formula )
-          const irtkMatrix &adj = _AdjJacobian[cp];
+          const irtkMatrix3x3 &adj = _AdjJacobian[cp];
           pengrad[0] += pendrv * (adj(0, 0) * detdrv[0](0, 0) +
                                   adj(1, 0) * detdrv[0](0, 1) +
                                   adj(2, 0) * detdrv[0](0, 2));
@@ -156,7 +156,7 @@ struct irtkLogJacobianConstraintEvaluateGradient
 
   static void Run(const irtkFreeFormTransformation *ffd,
                   const double                     *det,
-                  const irtkMatrix                 *adj,
+                  const irtkMatrix3x3              *adj,
                   double                           *gradient,
                   double                            weight,
                   bool                              incl_passive)
@@ -217,7 +217,7 @@ double irtkLogJacobianConstraint::Evaluate()
 
   if (mffd) {
     double     *det = _DetJacobian;
-    irtkMatrix *adj = _AdjJacobian;
+    irtkMatrix3x3 *adj = _AdjJacobian;
     for (int n = 0; n < mffd->NumberOfLevels(); ++n) {
       if (mffd->LocalTransformationIsActive(n)) {
         ffd = mffd->GetLocalTransformation(n);
@@ -259,7 +259,7 @@ void irtkLogJacobianConstraint::EvaluateGradient(double *gradient, double, doubl
 
   if (mffd) {
     double     *det = _DetJacobian;
-    irtkMatrix *adj = _AdjJacobian;
+    irtkMatrix3x3 *adj = _AdjJacobian;
     for (int n = 0; n < mffd->NumberOfLevels(); ++n) {
       if (mffd->LocalTransformationIsActive(n)) {
         ffd = mffd->GetLocalTransformation(n);
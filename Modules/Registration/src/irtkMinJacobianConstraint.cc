@@ -94,7 +94,7 @@ struct irtkMinJacobianConstraintEvaluateGradient
 {
   const irtkBSplineFreeFormTransformation3D *_FFD;
   const double                              *_DetJacobian;
-  const irtkMatrix                          *_AdjJacobian;
+  const irtkMatrix3x3                       *_AdjJacobian;
   double                                     _Gamma;
   double                                    *_Gradient;
   double                                     _Weight;
@@ -102,9 +102,9 @@ struct irtkMinJacobianConstraintEvaluateGradient
 
   void operator()(const blocked_range3d<int> &re) const
   {
-    int        xdof, ydof, zdof, n, cp, i1, j1, k1, i2, j2, k2;
-    double     pendrv, pengrad[3];
-    irtkMatrix detdrv[3];
+    int           xdof, ydof, zdof, n, cp, i1, j1, k1, i2, j2, k2;
+    double        pendrv, pengrad[3];
+    irtkMatrix3x3 detdrv[3];
 
     // Loop over control points
     for (int ck = re.pages().begin(); ck != re.pages().end(); ++ck)
@@ -138,7 +138,7 @@ struct irtkMinJacobianConstraintEvaluateGradient
 
           // Apply chain rule and Jacobi's formula
           // (cf. https://en.wikipedia.org/wiki/Jacobi's_formula )
-          const irtkMatrix &adj = _AdjJacobian[cp];
+          const irtkMatrix3x3 &adj = _AdjJacobian[cp];
           pengrad[0] += pendrv * (adj(0, 0) * detdrv[0](0, 0) +
                                   adj(1, 0) * detdrv[0](0, 1) +
                                   adj(2, 0) * detdrv[0](0, 2));
@@ -160,7 +160,7 @@ struct irtkMinJacobianConstraintEvaluateGradient
 
   static void Run(const irtkFreeFormTransformation *ffd,
                   const double                     *det,
-                  const irtkMatrix                 *adj,
+                  const irtkMatrix3x3              *adj,
                   double                            gamma,
                   double                           *gradient,
                   double                            weight,
@@ -287,7 +287,7 @@ void irtkMinJacobianConstraint::EvaluateGradient(double *gradient, double, doubl
 
   if (mffd) {
     double     *det = _DetJacobian;
-    irtkMatrix *adj = _AdjJacobian;
+    irtkMatrix3x3 *adj = _AdjJacobian;
     for (int n = 0; n < mffd->NumberOfLevels(); ++n) {
       if (mffd->LocalTransformationIsActive(n)) {
         ffd = mffd->GetLocalTransformation(n);
@@ -22,7 +22,6 @@
 #include <vtkIdList.h>
 #include <vtkMath.h>
 #include <vtkLine.h>
-#include <vtkAbstractPointLocator.h>
 #include <vtkOctreePointLocator.h>
 #include <vtkPolyDataNormals.h>
 
@@ -101,22 +100,104 @@ inline double GetBoundingSphereRadius(vtkGenericCell *cell, double c[3])
 
 #ifdef APPROXIMATE_NSI
 
+// -----------------------------------------------------------------------------
+/// Compute bounding spheres and boxes of cells
+struct ComputeBoundingVolumes
+{
+  vtkPolyData  *_DataSet;
+  const double *_Points;
+  const char   *_Moved;
+  double       *_Spheres;
+  double       *_Bounds;
+
+  void operator ()(const blocked_range<vtkIdType> &re) const
+  {
+    vtkIdType npts, *pts;
+    for (vtkIdType cellId = re.begin(); cellId != re.end(); ++cellId) {
+      _DataSet->GetCellPoints(cellId, npts, pts);
+      if (npts == 0) continue;
+      // Skip cells whose vertices did not move since previous update
+      if (_Moved) {
+        bool moved = false;
+        for (vtkIdType i = 0; i < npts; ++i) {
+          if (_Moved[pts[i]]) {
+            moved = true;
+            break;
+          }
+        }
+        if (!moved) continue;
+      }
+      // Center of vertices and axis-aligned bounding box
+      double * const s = _Spheres + 4 * cellId;
+      double * const b = _Bounds  + 6 * cellId;
+      const double *p = _Points + 3 * pts[0];
+      for (int d = 0; d < 3; ++d) {
+        s[d] = b[2*d] = b[2*d+1] = p[d];
+      }
+      for (vtkIdType i = 1; i < npts; ++i) {
+        p = _Points + 3 * pts[i];
+        for (int d = 0; d < 3; ++d) {
+          s[d] += p[d];
+          b[2*d  ] = min(b[2*d  ], p[d]);
+          b[2*d+1] = max(b[2*d+1], p[d]);
+        }
+      }
+      for (int d = 0; d < 3; ++d) s[d] /= npts;
+      // Radius of bounding sphere
+      s[3] = .0;
+      for (vtkIdType i = 0; i < npts; ++i) {
+        s[3] = max(s[3], vtkMath::Distance2BetweenPoints(s, _Points + 3 * pts[i]));
+      }
+      s[3] = sqrt(s[3]);
+    }
+  }
+};
+
+// -----------------------------------------------------------------------------
+/// Discard points whose distance to the bounding box of a cell is not less
+/// than the given maximum distance (branch-free loop)
+inline void DiscardDistantPoints(const double *points, const double bounds[6], double maxdist,
+                                 vector<vtkIdType> &ptIds, vector<double> &gap)
+{
+  const int n = static_cast<int>(ptIds.size());
+  gap.resize(n);
+  for (int i = 0; i < n; ++i) {
+    const double * const p = points + 3 * ptIds[i];
+    gap[i] = max(max(max(bounds[0] - p[0], p[0] - bounds[1]),
+                     max(bounds[2] - p[1], p[1] - bounds[3])),
+                     max(bounds[4] - p[2], p[2] - bounds[5]));
+  }
+  int m = 0;
+  for (int i = 0; i < n; ++i) {
+    if (gap[i] < maxdist) ptIds[m++] = ptIds[i];
+  }
+  ptIds.resize(m);
+}
+
 // -----------------------------------------------------------------------------
 /// Evaluate non-self-intersection penalty
 struct Evaluate
 {
-  vtkPolyData             *_DataSet;
-  vtkAbstractPointLocator *_Locator;
-  double                   _Distance;
-  double                   _Sum;
-  int                      _Num;
+  typedef irtkSurfaceCollisions::PointGrid PointGrid;
+
+  vtkPolyData     *_DataSet;
+  const PointGrid *_Grid;
+  const double    *_Points;
+  const double    *_Spheres;
+  const double    *_Bounds;
+  double           _Distance;
+  double           _Sum;
+  int              _Num;
 
   Evaluate() : _Sum(.0), _Num(0) {}
 
   Evaluate(const Evaluate &other, split)
   :
     _DataSet (other._DataSet),
-    _Locator (other._Locator),
+    _Grid    (other._Grid),
+    _Points  (other._Points),
+    _Spheres (other._Spheres),
+    _Bounds  (other._Bounds),
     _Distance(other._Distance),
     _Sum(.0), _Num(0)
   {}
@@ -131,24 +212,27 @@ struct Evaluate
   {
     int       subId;
     vtkIdType ptId;
-    double    p1[3], p2[3], c[3], r, pcoords[3], dist2;
+    double    p1[3], p2[3], pcoords[3], dist2;
     double   *weights = new double[_DataSet->GetMaxCellSize()];
 
     vtkSmartPointer<vtkGenericCell> cell      = vtkSmartPointer<vtkGenericCell>::New();
     vtkSmartPointer<vtkIdList>      cellPtIds = vtkSmartPointer<vtkIdList>::New();
-    vtkSmartPointer<vtkIdList>      ptIds     = vtkSmartPointer<vtkIdList>::New();
+    vector<vtkIdType>               ptIds;
+    vector<double>                  gap;
 
     const double maxdist2 = _Distance * _Distance;
 
     for (vtkIdType cellId = re.begin(); cellId != re.end(); ++cellId) {
+      const double * const s = _Spheres + 4 * cellId;
+      _Grid->FindPointsWithinRadius(_Points, s, 3 * s[3] + _Distance, ptIds);
+      DiscardDistantPoints(_Points, _Bounds + 6 * cellId, _Distance, ptIds, gap);
+      if (ptIds.empty()) continue;
       _DataSet->GetCell(cellId, cell);
       _DataSet->GetCellPoints(cellId, cellPtIds);
-      r = GetBoundingSphereRadius(cell, c);
-      _Locator->FindPointsWithinRadius(3 * r + _Distance, c, ptIds);
-      for (vtkIdType i = 0; i < ptIds->GetNumberOfIds(); ++i) {
-        ptId = ptIds->GetId(i);
+      for (size_t i = 0; i < ptIds.size(); ++i) {
+        ptId = ptIds[i];
         if (cellPtIds->IsId(ptId) == -1) {
-          _DataSet->GetPoint(ptId, p1);
+          memcpy(p1, _Points + 3 * ptId, 3 * sizeof(double));
           if (cell->EvaluatePosition(p1, p2, subId, pcoords, dist2, weights) == 1 && dist2 < maxdist2) {
             _Sum += pow(sqrt(dist2) - _Distance, 2);
             ++_Num;
@@ -164,19 +248,27 @@ struct Evaluate
 // -----------------------------------------------------------------------------
 struct EvaluateGradient
 {
-  vtkPolyData             *_DataSet;
-  vtkAbstractPointLocator *_Locator;
-  double                   _Distance;
-  Force                   *_Gradient;
-  int                     *_Count;
-  int                      _Num;
+  typedef irtkSurfaceCollisions::PointGrid PointGrid;
+
+  vtkPolyData     *_DataSet;
+  const PointGrid *_Grid;
+  const double    *_Points;
+  const double    *_Spheres;
+  const double    *_Bounds;
+  double           _Distance;
+  Force           *_Gradient;
+  int             *_Count;
+  int              _Num;
 
   EvaluateGradient() : _Gradient(NULL), _Count(NULL), _Num(0) {}
 
   EvaluateGradient(const EvaluateGradient &other, split)
   :
     _DataSet (other._DataSet),
-    _Locator (other._Locator),
+    _Grid    (other._Grid),
+    _Points  (other._Points),
+    _Spheres (other._Spheres),
+    _Bounds  (other._Bounds),
     _Distance(other._Distance)
   {
     _Gradient = CAllocate<Force>(_DataSet->GetNumberOfPoints());
@@ -199,24 +291,27 @@ struct EvaluateGradient
   {
     int       subId;
     vtkIdType ptId;
-    double    p1[3], p2[3], c[3], r, pcoords[3], dist2, d, w;
+    double    p1[3], p2[3], pcoords[3], dist2, d, w;
     double   *weights = new double[_DataSet->GetMaxCellSize()];
 
     vtkSmartPointer<vtkGenericCell> cell      = vtkSmartPointer<vtkGenericCell>::New();
     vtkSmartPointer<vtkIdList>      cellPtIds = vtkSmartPointer<vtkIdList>::New();
-    vtkSmartPointer<vtkIdList>      ptIds     = vtkSmartPointer<vtkIdList>::New();
+    vector<vtkIdType>               ptIds;
+    vector<double>                  gap;
 
     const double maxdist2 = _Distance * _Distance;
 
     for (vtkIdType cellId = re.begin(); cellId != re.end(); ++cellId) {
+      const double * const s = _Spheres + 4 * cellId;
+      _Grid->FindPointsWithinRadius(_Points, s, 3 * s[3] + _Distance, ptIds);
+      DiscardDistantPoints(_Points, _Bounds + 6 * cellId, _Distance, ptIds, gap);
+      if (ptIds.empty()) continue;
       _DataSet->GetCell(cellId, cell);
       _DataSet->GetCellPoints(cellId, cellPtIds);
-      r = GetBoundingSphereRadius(cell, c);
-      _Locator->FindPointsWithinRadius(3 * r + _Distance, c, ptIds);
-      for (vtkIdType i = 0; i < ptIds->GetNumberOfIds(); ++i) {
-        ptId = ptIds->GetId(i);
+      for (size_t i = 0; i < ptIds.size(); ++i) {
+        ptId = ptIds[i];
         if (cellPtIds->IsId(ptId) == -1) {
-          _DataSet->GetPoint(ptId, p1);
+          memcpy(p1, _Points + 3 * ptId, 3 * sizeof(double));
           if (cell->EvaluatePosition(p1, p2, subId, pcoords, dist2, weights) == 1 && dist2 < maxdist2) {
             d = sqrt(dist2);
             w = 2.0 * (d - _Distance) / (d + 1e-6);
@@ -635,7 +730,11 @@ irtkNonSelfIntersectionConstraint
 :
   irtkSurfaceConstraint(other),
   _MinDistance(other._MinDistance),
-  _Candidates (other._Candidates)
+  _Candidates (other._Candidates),
+  _Points     (other._Points),
+  _Spheres    (other._Spheres),
+  _Bounds     (other._Bounds),
+  _Grid       (other._Grid)
 {
 }
 
@@ -646,6 +745,10 @@ irtkNonSelfIntersectionConstraint &irtkNonSelfIntersectionConstraint
   irtkSurfaceConstraint::operator =(other);
   _MinDistance = other._MinDistance;
   _Candidates  = other._Candidates;
+  _Points      = other._Points;
+  _Spheres     = other._Spheres;
+  _Bounds      = other._Bounds;
+  _Grid        = other._Grid;
   return *this;
 }
 
@@ -689,6 +792,8 @@ irtkParameterList irtkNonSelfIntersectionConstraint::Parameter() const
 void irtkNonSelfIntersectionConstraint::Init()
 {
   AllocateCount(_NumberOfPoints);
+  _Points.clear();
+  _Grid = irtkSurfaceCollisions::PointGrid();
 }
 
 // -----------------------------------------------------------------------------
@@ -718,10 +823,78 @@ void irtkNonSelfIntersectionConstraint::Reinitialize()
   irtkNonSelfIntersectionConstraint::Init();
 }
 
+// -----------------------------------------------------------------------------
+void irtkNonSelfIntersectionConstraint::UpdateBroadPhase()
+{
+  vtkPolyData * const surface = _PointSet->Surface();
+  vtkPoints   * const points  = surface->GetPoints();
+  const vtkIdType npoints = surface->GetNumberOfPoints();
+  const vtkIdType ncells  = surface->GetNumberOfCells();
+
+  // Incremental update only possible if surface topology is unchanged,
+  // which is the case unless Reinitialize was called
+  const bool update = (!_Grid.Empty() && _Points.size() == static_cast<size_t>(3 * npoints));
+
+  // Determine which points moved since the previous update
+  vector<char> moved(npoints, 1);
+  double p[3];
+  _Points.resize(3 * npoints);
+  for (vtkIdType ptId = 0; ptId < npoints; ++ptId) {
+    points->GetPoint(ptId, p);
+    double * const q = &_Points[3 * ptId];
+    if (update) moved[ptId] = (p[0] != q[0] || p[1] != q[1] || p[2] != q[2]);
+    q[0] = p[0], q[1] = p[1], q[2] = p[2];
+  }
+  if (!update) {
+    _Spheres.resize(4 * ncells);
+    _Bounds .resize(6 * ncells);
+  }
+  if (ncells == 0) {
+    _Grid.Build((npoints > 0 ? &_Points[0] : NULL), npoints, 1.0);
+    return;
+  }
+
+  // Update bounding volumes of cells with moved vertices
+  irtkNonSelfIntersectionConstraintUtils::ComputeBoundingVolumes eval;
+  eval._DataSet = surface;
+  eval._Points  = (npoints > 0 ? &_Points[0] : NULL);
+  eval._Moved   = (update ? &moved[0] : NULL);
+  eval._Spheres = &_Spheres[0];
+  eval._Bounds  = &_Bounds [0];
+  parallel_for(blocked_range<vtkIdType>(0, ncells), eval);
+
+  // Size of grid cells such that search radius spans at most three cells
+  double max_radius = .0;
+  for (vtkIdType cellId = 0; cellId < ncells; ++cellId) {
+    max_radius = max(max_radius, _Spheres[4 * cellId + 3]);
+  }
+  double spacing = 3.0 * max_radius + _MinDistance;
+  if (!(spacing > .0) || IsInf(spacing)) spacing = 1.0;
+
+  // Re-bin moved points unless grid must be rebuilt
+  bool rebuild = !update || spacing < .5 * _Grid.CellSize() || spacing > 2.0 * _Grid.CellSize();
+  if (!rebuild) {
+    for (vtkIdType ptId = 0; ptId < npoints; ++ptId) {
+      if (moved[ptId] && !_Grid.Contains(&_Points[3 * ptId])) {
+        rebuild = true;
+        break;
+      }
+    }
+  }
+  if (rebuild) {
+    _Grid.Build((npoints > 0 ? &_Points[0] : NULL), npoints, spacing);
+  } else {
+    for (vtkIdType ptId = 0; ptId < npoints; ++ptId) {
+      if (moved[ptId]) _Grid.Move(ptId, &_Points[3 * ptId]);
+    }
+  }
+}
+
 // -----------------------------------------------------------------------------
 void irtkNonSelfIntersectionConstraint::Update(bool gradient)
 {
 #if APPROXIMATE_NSI
+  if (_NumberOfPoints > 0) UpdateBroadPhase();
 #else
 //  if (gradient) {
     _Candidates = FindCandidates::Run(_PointSet->Surface(), _MinDistance);
@@ -739,15 +912,15 @@ double irtkNonSelfIntersectionConstraint::Evaluate()
 {
 #if APPROXIMATE_NSI
   if (_NumberOfPoints == 0) return .0;
-
-  // TODO: Build Octree in Update function and use for both Evaluate and EvaluateGradient
-  vtkSmartPointer<vtkOctreePointLocator> octree = vtkSmartPointer<vtkOctreePointLocator>::New();
-  octree->SetDataSet(_PointSet->Surface());
-  octree->BuildLocator();
+  if (_Grid.Empty()) UpdateBroadPhase();
+  if (_Spheres.empty()) return .0;
 
   irtkNonSelfIntersectionConstraintUtils::Evaluate eval;
   eval._DataSet  = _PointSet->Surface();
-  eval._Locator  = octree;
+  eval._Grid     = &_Grid;
+  eval._Points   = &_Points [0];
+  eval._Spheres  = &_Spheres[0];
+  eval._Bounds   = &_Bounds [0];
   eval._Distance = _MinDistance;
   parallel_reduce(blocked_range<vtkIdType>(0, _PointSet->NumberOfSurfaceCells()), eval);
 
@@ -769,15 +942,16 @@ void irtkNonSelfIntersectionConstraint::EvaluateGradient(double *gradient, doubl
 {
 #if APPROXIMATE_NSI
   if (_NumberOfPoints == 0) return;
-
-  vtkSmartPointer<vtkOctreePointLocator> octree = vtkSmartPointer<vtkOctreePointLocator>::New();
-  octree->SetDataSet(_PointSet->Surface());
-  octree->BuildLocator();
+  if (_Grid.Empty()) UpdateBroadPhase();
+  if (_Spheres.empty()) return;
 
   irtkNonSelfIntersectionConstraintUtils::EvaluateGradient eval;
   eval._DataSet  = _PointSet->Surface();
   eval._Distance = _MinDistance;
-  eval._Locator  = octree;
+  eval._Grid     = &_Grid;
+  eval._Points   = &_Points [0];
+  eval._Spheres  = &_Spheres[0];
+  eval._Bounds   = &_Bounds [0];
   eval._Gradient = _Gradient;
   eval._Count    = _Count;
   parallel_reduce(blocked_range<vtkIdType>(0, _PointSet->NumberOfSurfaceCells()), eval);
@@ -89,7 +89,9 @@ double irtkNormalizedGradientFieldSimilarity::NormalizationFactor(irtkRegistered
 
   for (int idx = 0; idx < NumberOfVoxels(); ++idx, ++dx, ++dy, ++dz) {
     if (IsForeground(idx)) {
-      norm += sqrt((*dx) * (*dx) + (*dy) * (*dy) + (*dz) * (*dz));
+      norm += sqrt(static_cast<double>(*dx) * static_cast<double>(*dx) +
+                   static_cast<double>(*dy) * static_cast<double>(*dy) +
+                   static_cast<double>(*dz) * static_cast<double>(*dz));
       ++n;
     }
   }
@@ -283,10 +283,11 @@ struct EvaluateLNCCGradient : public irtkVoxelFunction
     }
   }
 
-  template <class TImage, class T1, class T2>
-  void operator()(const TImage &, int, const T1 *tgt, const T1 *src, const T2 *g1, const T2 *g2, const T2 *g3, T2 *g)
+  template <class TImage, class T1, class T2, class TGradient>
+  void operator()(const TImage &, int, const T1 *tgt, const T1 *src, const T2 *g1, const T2 *g2, const T2 *g3, TGradient *g)
   {
-    (*g) = (*g1) * (*tgt) - (*g2) * (*src) + (*g3);
+    (*g) = static_cast<double>(*g1) * static_cast<double>(*tgt)
+         - static_cast<double>(*g2) * static_cast<double>(*src) + static_cast<double>(*g3);
   }
 };
 
@@ -295,54 +296,259 @@ struct EvaluateLNCCGradient : public irtkVoxelFunction
 // -----------------------------------------------------------------------------
 
 // -----------------------------------------------------------------------------
-template <class VoxelType>
-struct UpdateBoxWindowLNCC : public irtkVoxelFunction
+/// Compute local dot products of box window LNCC using separable window sums
+///
+/// The window sums of t, s, t^2, s^2, and t*s are computed in three passes
+/// (x, y, z) whose cost per voxel is independent of the window size. Rather
+/// than using a running sum, which accumulates rounding errors depending on
+/// where it was started, a window sum is composed of the suffix and prefix
+/// sums of two adjacent blocks of length 2r+1 (van Herk/Gil-Werman). These
+/// blocks are aligned with the image grid such that the result at a given
+/// voxel does not depend on the image region being updated (cf. Include).
+///
+/// The xy plane is processed in tiles. For each tile, the 2D window sums of
+/// the slices are streamed along the z axis, keeping the suffix sums of the
+/// previous block of slices and the raw sums of the current block only.
+class UpdateBoxWindowLNCC
 {
-  irtkNormalizedIntensityCrossCorrelation *_This;
+  typedef irtkNormalizedIntensityCrossCorrelation::VoxelType VoxelType;
+  typedef irtkNormalizedIntensityCrossCorrelation::RealType  RealType;
+
+  /// Number of local sums
+  static const int NSUMS = 5;
+
+  /// Size of tiles in the xy plane
+  static const int TILE = 64;
+
+  const irtkNormalizedIntensityCrossCorrelation *_This;
+  const VoxelType                               *_Target;
+  const VoxelType                               *_Source;
+  RealType *_A, *_B, *_C, *_S, *_T;
+  int       _X, _Y, _Z, _rx, _ry, _rz;
+  int       _i1, _i2, _j1, _j2, _k1, _k2, _TilesX;
+
+  /// Temporary buffers of each task
+  struct Buffers
+  {
+    vector<double> line, pre, suf, rows, prefix, prev, cur, sum;
+  };
 
   // ---------------------------------------------------------------------------
-  UpdateBoxWindowLNCC(irtkNormalizedIntensityCrossCorrelation *_this)
-  :
-    _This(_this)
-  {}
+  /// Index of position p within its block of length w
+  static int PosInBlock(int p, int w)
+  {
+    const int m = p % w;
+    return m < 0 ? m + w : m;
+  }
 
   // ---------------------------------------------------------------------------
-  void operator()(int i, int j, int k, int, const VoxelType *tgt, const VoxelType *src,
-                  VoxelType *a, VoxelType *b, VoxelType *c, VoxelType *s, VoxelType *t)
+  /// Compute window sums out[i] of in[p] for p in [i - r, i + r] and i in [i1, i2)
+  ///
+  /// \param[in]  in      Input values at positions [i1 - r, i2 + r).
+  /// \param[in]  istride Stride between input vectors.
+  /// \param[out] out     Window sums at positions [i1, i2).
+  /// \param[in]  ostride Stride between output vectors.
+  static void WindowSum(const double *in, int istride, double *out, int ostride,
+                        int i1, int i2, int r, double *pre, double *suf)
   {
-    int    cnt  =  0;
-    double sumt = .0, sums = .0, sumss = .0, sumts = .0, sumtt = .0;
-
-    if (_This->IsForeground(i, j, k)) {
-      const irtkVector3D<int> &radius = _This->NeighborhoodRadius();
-      irtkGenericImageIterator<VoxelType> _TargetNeighborhood(_This->Target());
-      irtkGenericImageIterator<VoxelType> _SourceNeighborhood(_This->Source());
-      _TargetNeighborhood.SetNeighborhood(i, j, k, radius._x, radius._y, radius._z);
-      _SourceNeighborhood.SetNeighborhood(i, j, k, radius._x, radius._y, radius._z);
-      _TargetNeighborhood.GoToBegin();
-      _SourceNeighborhood.GoToBegin();
-      while (!_TargetNeighborhood.IsAtEnd()) {
-        sums  += _SourceNeighborhood.Value();
-        sumt  += _TargetNeighborhood.Value();
-        sumss += _SourceNeighborhood.Value() * _SourceNeighborhood.Value();
-        sumts += _TargetNeighborhood.Value() * _SourceNeighborhood.Value();
-        sumtt += _TargetNeighborhood.Value() * _TargetNeighborhood.Value();
-        ++_TargetNeighborhood;
-        ++_SourceNeighborhood;
-        ++cnt;
+    const int w = 2 * r + 1;
+    const int n = i2 - i1 + 2 * r;
+    const int p = i1 - r;
+    // Prefix sums within blocks
+    for (int q = 0; q < n; ++q) {
+      const double *v = in  + q * istride;
+      double       *s = pre + q * NSUMS;
+      if (q == 0 || PosInBlock(p + q, w) == 0) {
+        for (int c = 0; c < NSUMS; ++c) s[c] = v[c];
+      } else {
+        for (int c = 0; c < NSUMS; ++c) s[c] = s[c - NSUMS] + v[c];
       }
     }
+    // Suffix sums within blocks
+    for (int q = n - 1; q >= 0; --q) {
+      const double *v = in  + q * istride;
+      double       *s = suf + q * NSUMS;
+      if (q == n - 1 || PosInBlock(p + q + 1, w) == 0) {
+        for (int c = 0; c < NSUMS; ++c) s[c] = v[c];
+      } else {
+        for (int c = 0; c < NSUMS; ++c) s[c] = v[c] + s[c + NSUMS];
+      }
+    }
+    // Window sums
+    for (int q = 0; q < i2 - i1; ++q) {
+      const double *s1 = suf + q * NSUMS;
+      const double *s2 = pre + (q + 2 * r) * NSUMS;
+      double       *o  = out + q * ostride;
+      if (PosInBlock(p + q, w) == 0) {
+        for (int c = 0; c < NSUMS; ++c) o[c] = s1[c];
+      } else {
+        for (int c = 0; c < NSUMS; ++c) o[c] = s1[c] + s2[c];
+      }
+    }
+  }
 
-    if (cnt) {
-      const double ms = sums / cnt;
-      const double mt = sumt / cnt;
-      *a = voxel_cast<VoxelType>(sumts - ms * sumt - mt * sums + cnt * ms * mt); // <T, S>
-      *b = voxel_cast<VoxelType>(sumss -       2.0 * ms * sums + cnt * ms * ms); // <S, S>
-      *c = voxel_cast<VoxelType>(sumtt -       2.0 * mt * sumt + cnt * mt * mt); // <T, T>
-      *s = voxel_cast<VoxelType>((*src) - ms);
-      *t = voxel_cast<VoxelType>((*tgt) - mt);
-    } else {
-      *a = *b = *c = *s = *t = voxel_cast<VoxelType>(.0);
+  // ---------------------------------------------------------------------------
+  /// Compute 2D window sums of slice k for each voxel in [i1, i2) x [j1, j2)
+  void SumSlice(int k, int i1, int i2, int j1, int j2, double *sums, Buffers &buf) const
+  {
+    const int nx = i2 - i1;
+    const int ny = j2 - j1;
+    if (k < 0 || k >= _Z) {
+      memset(sums, 0, nx * ny * NSUMS * sizeof(double));
+      return;
+    }
+    // Sum along x axis
+    const int stride = nx * NSUMS;
+    for (int j = j1 - _ry; j < j2 + _ry; ++j) {
+      double *row = &buf.rows[(j - j1 + _ry) * stride];
+      if (j < 0 || j >= _Y) {
+        memset(row, 0, stride * sizeof(double));
+        continue;
+      }
+      const VoxelType *tgt = _Target + (k * _Y + j) * _X;
+      const VoxelType *src = _Source + (k * _Y + j) * _X;
+      double          *v   = &buf.line[0];
+      for (int i = i1 - _rx; i < i2 + _rx; ++i, v += NSUMS) {
+        if (0 <= i && i < _X) {
+          const double t = tgt[i], s = src[i];
+          v[0] = t, v[1] = s, v[2] = t * t, v[3] = s * s, v[4] = t * s;
+        } else {
+          v[0] = v[1] = v[2] = v[3] = v[4] = .0;
+        }
+      }
+      WindowSum(&buf.line[0], NSUMS, row, NSUMS, i1, i2, _rx, &buf.pre[0], &buf.suf[0]);
+    }
+    // Sum along y axis
+    for (int i = 0; i < nx; ++i) {
+      WindowSum(&buf.rows[i * NSUMS], stride, sums + i * NSUMS, stride,
+                j1, j2, _ry, &buf.pre[0], &buf.suf[0]);
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  /// Compute dot products of slice k from window sums
+  void Evaluate(int k, int i1, int i2, int j1, int j2, const double *sum) const
+  {
+    const int nk = min(_Z - 1, k + _rz) - max(0, k - _rz) + 1;
+    for (int j = j1; j < j2; ++j) {
+      const int nj = min(_Y - 1, j + _ry) - max(0, j - _ry) + 1;
+      for (int i = i1; i < i2; ++i, sum += NSUMS) {
+        const int idx = (k * _Y + j) * _X + i;
+        if (_This->IsForeground(i, j, k)) {
+          const int    ni  = min(_X - 1, i + _rx) - max(0, i - _rx) + 1;
+          const int    cnt = ni * nj * nk;
+          const double mt  = sum[0] / cnt;
+          const double ms  = sum[1] / cnt;
+          _A[idx] = voxel_cast<RealType>(sum[4] - ms * sum[0] - mt * sum[1] + cnt * ms * mt); // <T, S>
+          _B[idx] = voxel_cast<RealType>(sum[3] -       2.0 * ms * sum[1] + cnt * ms * ms); // <S, S>
+          _C[idx] = voxel_cast<RealType>(sum[2] -       2.0 * mt * sum[0] + cnt * mt * mt); // <T, T>
+          _S[idx] = voxel_cast<RealType>(_Source[idx] - ms);
+          _T[idx] = voxel_cast<RealType>(_Target[idx] - mt);
+        } else {
+          _A[idx] = _B[idx] = _C[idx] = _S[idx] = _T[idx] = voxel_cast<RealType>(.0);
+        }
+      }
+    }
+  }
+
+public:
+
+  // ---------------------------------------------------------------------------
+  /// Update dot product images within the given image region
+  static void Run(const irtkNormalizedIntensityCrossCorrelation *_this,
+                  const blocked_range3d<int> &region,
+                  RealImage *a, RealImage *b, RealImage *c, RealImage *s, RealImage *t)
+  {
+    if (region.cols ().begin() >= region.cols ().end() ||
+        region.rows ().begin() >= region.rows ().end() ||
+        region.pages().begin() >= region.pages().end()) return;
+    UpdateBoxWindowLNCC body;
+    body._This   = _this;
+    body._Target = _this->Target()->Data();
+    body._Source = _this->Source()->Data();
+    body._A  = a->Data(), body._B = b->Data(), body._C = c->Data();
+    body._S  = s->Data(), body._T = t->Data();
+    body._X  = _this->Target()->X();
+    body._Y  = _this->Target()->Y();
+    body._Z  = _this->Target()->Z();
+    body._rx = max(0, _this->NeighborhoodRadius()._x);
+    body._ry = max(0, _this->NeighborhoodRadius()._y);
+    body._rz = max(0, _this->NeighborhoodRadius()._z);
+    body._i1 = region.cols ().begin(), body._i2 = region.cols ().end();
+    body._j1 = region.rows ().begin(), body._j2 = region.rows ().end();
+    body._k1 = region.pages().begin(), body._k2 = region.pages().end();
+    body._TilesX = (body._i2 - body._i1 + TILE - 1) / TILE;
+    const int ntiles = body._TilesX * ((body._j2 - body._j1 + TILE - 1) / TILE);
+    parallel_for(blocked_range<int>(0, ntiles), body);
+  }
+
+  // ---------------------------------------------------------------------------
+  void operator ()(const blocked_range<int> &re) const
+  {
+    const int w    = 2 * _rz + 1;
+    const int nx   = min(TILE, _i2 - _i1);
+    const int ny   = min(TILE, _j2 - _j1);
+    const int size = nx * ny * NSUMS;
+
+    Buffers buf;
+    buf.line  .resize((nx + 2 * _rx) * NSUMS);
+    buf.pre   .resize(max(nx + 2 * _rx, ny + 2 * _ry) * NSUMS);
+    buf.suf   .resize(buf.pre.size());
+    buf.rows  .resize((ny + 2 * _ry) * nx * NSUMS);
+    buf.prefix.resize(size);
+    buf.prev  .resize(w * size);
+    buf.cur   .resize(w * size);
+    buf.sum   .resize(size);
+
+    double *pre = &buf.prefix[0];
+    double *sum = &buf.sum   [0];
+
+    for (int tile = re.begin(); tile != re.end(); ++tile) {
+      const int i1 = _i1 + (tile % _TilesX) * TILE, i2 = min(_i2, i1 + TILE);
+      const int j1 = _j1 + (tile / _TilesX) * TILE, j2 = min(_j2, j1 + TILE);
+      const int n  = (i2 - i1) * (j2 - j1) * NSUMS;
+
+      // Start of block of slices containing the leading slice k + rz of the window
+      int b = _k1 + _rz - PosInBlock(_k1 + _rz, w);
+
+      // Suffix sums of previous block as far as needed
+      for (int q = w - 1; q >= 0 && b - w + q >= _k1 - _rz; --q) {
+        double *s = &buf.prev[q * size];
+        SumSlice(b - w + q, i1, i2, j1, j2, s, buf);
+        if (q < w - 1) {
+          for (int l = 0; l < n; ++l) s[l] += s[l + size];
+        }
+      }
+      // Prefix sums of current block up to the first leading slice
+      for (int m = b; m < _k1 + _rz; ++m) {
+        double *s = &buf.cur[(m - b) * size];
+        SumSlice(m, i1, i2, j1, j2, s, buf);
+        if (m == b) memcpy(pre, s, n * sizeof(double));
+        else for (int l = 0; l < n; ++l) pre[l] += s[l];
+      }
+
+      for (int k = _k1; k < _k2; ++k) {
+        const int m  = k + _rz;
+        const int pm = m - b;
+        double   *s  = &buf.cur[pm * size];
+        SumSlice(m, i1, i2, j1, j2, s, buf);
+        if (pm == 0) memcpy(pre, s, n * sizeof(double));
+        else for (int l = 0; l < n; ++l) pre[l] += s[l];
+        if (pm == w - 1) {
+          // Window coincides with current block, convert to suffix sums
+          for (int q = w - 2; q >= 0; --q) {
+            double *s1 = &buf.cur[q * size], *s2 = s1 + size;
+            for (int l = 0; l < n; ++l) s1[l] += s2[l];
+          }
+          Evaluate(k, i1, i2, j1, j2, &buf.cur[0]);
+          buf.prev.swap(buf.cur);
+          b += w;
+        } else {
+          const double *s1 = &buf.prev[(pm + 1) * size];
+          for (int l = 0; l < n; ++l) sum[l] = s1[l] + pre[l];
+          Evaluate(k, i1, i2, j1, j2, sum);
+        }
+      }
     }
   }
 };
@@ -425,10 +631,11 @@ private:
 // -----------------------------------------------------------------------------
 struct EvaluateBoxWindowLNCCGradient : public irtkVoxelFunction
 {
-  template <class TImage, class T>
-  void operator()(const TImage &, int, const T *a, const T *b, const T *c, const T *s, const T *t, T *g)
+  template <class TImage, class T, class TGradient>
+  void operator()(const TImage &, int, const T *a, const T *b, const T *c, const T *s, const T *t, TGradient *g)
   {
-    (*g) = 2.0 * ((*a) / ((*b) * (*c))) * ((*t) - ((*a) / (*b)) * (*s));
+    const double ab = static_cast<double>(*a) / static_cast<double>(*b);
+    (*g) = 2.0 * (ab / static_cast<double>(*c)) * (static_cast<double>(*t) - ab * static_cast<double>(*s));
     if (IsNaN(*g) || IsInf(*g)) (*g) = .0;
   }
 };
@@ -523,9 +730,9 @@ irtkNormalizedIntensityCrossCorrelation
 :
   irtkImageSimilarity(other),
   _KernelType(other._KernelType),
-  _KernelX(other._KernelX ? new RealImage(*other._KernelX) : NULL),
-  _KernelY(other._KernelY ? new RealImage(*other._KernelY) : NULL),
-  _KernelZ(other._KernelZ ? new RealImage(*other._KernelZ) : NULL),
+  _KernelX(other._KernelX ? new KernelImage(*other._KernelX) : NULL),
+  _KernelY(other._KernelY ? new KernelImage(*other._KernelY) : NULL),
+  _KernelZ(other._KernelZ ? new KernelImage(*other._KernelZ) : NULL),
   _A      (other._A       ? new RealImage(*other._A      ) : NULL),
   _B      (other._B       ? new RealImage(*other._B      ) : NULL),
   _C      (other._C       ? new RealImage(*other._C      ) : NULL),
@@ -785,7 +992,7 @@ void irtkNormalizedIntensityCrossCorrelation::ClearKernel()
 }
 
 // -----------------------------------------------------------------------------
-irtkNormalizedIntensityCrossCorrelation::RealImage *
+irtkNormalizedIntensityCrossCorrelation::KernelImage *
 irtkNormalizedIntensityCrossCorrelation::CreateGaussianKernel(double sigma)
 {
   // Ignore sign of standard deviation parameter (negative --> voxel units)
@@ -796,10 +1003,10 @@ irtkNormalizedIntensityCrossCorrelation::CreateGaussianKernel(double sigma)
 
   // Create filter kernel for 1D Gaussian function
   const int  size   = 2 * static_cast<int>(3.0 * sigma) + 1;
-  RealImage *kernel = new RealImage(size, 1, 1);
+  KernelImage *kernel = new KernelImage(size, 1, 1);
 
   // Sample scalar function at discrete kernel positions
-  irtkScalarFunctionToImage<RealType> sampler;
+  irtkScalarFunctionToImage<irtkRealPixel> sampler;
   sampler.SetInput (&func);
   sampler.SetOutput(kernel);
   sampler.Run();
@@ -812,16 +1019,16 @@ void irtkNormalizedIntensityCrossCorrelation
 ::ComputeWeightedAverage(const blocked_range3d<int> &region, RealImage *image)
 {
   // Average along x axis
-  ConvolveTruncatedForegroundInX<RealType> convX(image, _KernelX->Data(), _KernelX->X());
+  ConvolveTruncatedForegroundInX<irtkRealPixel> convX(image, _KernelX->Data(), _KernelX->X());
   ParallelForEachVoxel(region, image, &_Temp, convX);
 
   // Average along y axis
-  ConvolveTruncatedForegroundInY<RealType> convY(image, _KernelY->Data(), _KernelY->X());
+  ConvolveTruncatedForegroundInY<irtkRealPixel> convY(image, _KernelY->Data(), _KernelY->X());
   ParallelForEachVoxel(region, &_Temp, image, convY);
 
   // Average along z axis
   if (_KernelZ) {
-    ConvolveTruncatedForegroundInZ<RealType> convZ(image, _KernelZ->Data(), _KernelZ->X());
+    ConvolveTruncatedForegroundInZ<irtkRealPixel> convZ(image, _KernelZ->Data(), _KernelZ->X());
     ParallelForEachVoxel(region, image, &_Temp, convZ);
     ParallelForEachVoxel(irtkBinaryVoxelFunction::Copy(), region, &_Temp, image);
   }
@@ -945,8 +1152,7 @@ void irtkNormalizedIntensityCrossCorrelation::Update(bool gradient)
   if (_KernelType == BoxWindow) {
 
     // Compute dot products
-    UpdateBoxWindowLNCC<RealType> update(this);
-    ParallelForEachVoxel(domain, _Target, _Source, _A, _B, _C, _S, _T, update);
+    UpdateBoxWindowLNCC::Run(this, domain, _A, _B, _C, _S, _T);
     // Evaluate LNCC value
     EvaluateBoxWindowLNCC cc;
     ParallelForEachVoxel(domain, _A, _B, _C, cc);
@@ -1015,8 +1221,7 @@ void irtkNormalizedIntensityCrossCorrelation::Include(const blocked_range3d<int>
   if (_KernelType == BoxWindow) {
 
     // Compute dot products
-    UpdateBoxWindowLNCC<RealType> update(this);
-    ParallelForEachVoxel(region, _Target, _Source, _A, _B, _C, _S, _T, update);
+    UpdateBoxWindowLNCC::Run(this, region, _A, _B, _C, _S, _T);
     // Add LNCC values for specified region
     EvaluateBoxWindowLNCC cc;
     ParallelForEachVoxel(region, _A, _B, _C, cc);
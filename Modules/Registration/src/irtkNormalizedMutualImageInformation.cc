@@ -16,6 +16,8 @@
 
 #include <irtkNormalizedMutualImageInformation.h>
 
+#include <irtkParallel.h>
+
 
 // =============================================================================
 // Auxiliary functors
@@ -36,65 +38,93 @@ inline double ValToRange(const irtkHistogram_1D<double> &hist, double val)
 }
 
 // -----------------------------------------------------------------------------
-class CalculateGradient : public irtkVoxelFunction
+/// Number of voxels processed at once by CalculateGradient
+const int GradientBatchSize = 256;
+
+// -----------------------------------------------------------------------------
+/// Evaluate NMI gradient using precomputed table of joint histogram derivatives
+///
+/// The table stores for each pair of target and source bins (t, s) the value
+/// log p(t) + log p(s) - NMI * log p(t, s), with a border of zeros such that
+/// the 4x4 cubic B-spline Parzen window of each voxel never needs clamping.
+class CalculateGradient
 {
   const irtkNormalizedMutualImageInformation *_This;
-  const irtkHistogram_2D<double>             &_LogJointHistogram;
-  const irtkHistogram_1D<double>             &_LogMarginalXHistogram;
-  const irtkHistogram_1D<double>             &_LogMarginalYHistogram;
-  double                                      _JointEntropy;
-  double                                      _NormalizedMutualInformation;
+  const irtkRegisteredImage::VoxelType       *_Fixed;
+  const irtkRegisteredImage::VoxelType       *_Moving;
+  irtkImageSimilarity::GradientType          *_Gradient;
+  const irtkHistogram_1D<double>             &_TargetHistogram;
+  const irtkHistogram_1D<double>             &_SourceHistogram;
+  const double                               *_Table;
+  int                                         _Stride;
+  int                                         _TargetBins;
+  int                                         _SourceBins;
+  double                                      _Denominator;
+  int                                         _NumberOfVoxels;
 
 public:
 
   CalculateGradient(const irtkNormalizedMutualImageInformation *_this,
-                    const irtkHistogram_2D<double> &logJointHistogram,
-                    const irtkHistogram_1D<double> &logMarginalXHistogram,
-                    const irtkHistogram_1D<double> &logMarginalYHistogram,
-                    double je, double nmi)
+                    const irtkRegisteredImage *fixed, const irtkRegisteredImage *moving,
+                    irtkImageSimilarity::GradientImageType *gradient,
+                    const irtkHistogram_1D<double> &targetHistogram,
+                    const irtkHistogram_1D<double> &sourceHistogram,
+                    const double *table, int stride, double denominator, int n)
   :
     _This(_this),
-    _LogJointHistogram(logJointHistogram),
-    _LogMarginalXHistogram(logMarginalXHistogram),
-    _LogMarginalYHistogram(logMarginalYHistogram),
-    _JointEntropy(je),
-    _NormalizedMutualInformation(nmi)
+    _Fixed(fixed->Data()),
+    _Moving(moving->Data()),
+    _Gradient(gradient->Data()),
+    _TargetHistogram(targetHistogram),
+    _SourceHistogram(sourceHistogram),
+    _Table(table),
+    _Stride(stride),
+    _TargetBins(targetHistogram.NumberOfBins()),
+    _SourceBins(sourceHistogram.NumberOfBins()),
+    _Denominator(denominator),
+    _NumberOfVoxels(n)
   {}
 
-  template <class TImage, class TIntensity, class TGradient>
-  void operator ()(const TImage &, int idx, const TIntensity *tgt, const TIntensity *src, TGradient *deriv)
+  void operator ()(const blocked_range<int> &re) const
   {
-    if (_This->IsForeground(idx)) {
-      const int    target_nbins = _LogMarginalXHistogram.NumberOfBins();
-      const int    source_nbins = _LogMarginalYHistogram.NumberOfBins();
-      const double target_value = ValToRange(_LogMarginalXHistogram, *tgt);
-      const double source_value = ValToRange(_LogMarginalYHistogram, *src);
-
-      int t1 = static_cast<int>(     target_value ) - 1;
-      int t2 = static_cast<int>(ceil(target_value)) + 1;
-      int s1 = static_cast<int>(     source_value ) - 1;
-      int s2 = static_cast<int>(ceil(source_value)) + 1;
-
-      if (t1 <  0           ) t1 = 0;
-      if (t2 >= target_nbins) t2 = target_nbins - 1;
-      if (s1 <  0           ) s1 = 0;
-      if (s2 >= source_nbins) s2 = source_nbins - 1;
-
-      double jointEntropyGrad  = .0;
-      double targetEntropyGrad = .0;
-      double sourceEntropyGrad = .0;
-      double w;
-
-      for (int t = t1; t <= t2; ++t)
-      for (int s = s1; s <= s2; ++s) {
-        w = irtkBSpline<double>::B  (static_cast<double>(t) - target_value) *
-            irtkBSpline<double>::B_I(static_cast<double>(s) - source_value);
-        jointEntropyGrad  += w * _LogJointHistogram(t, s);
-        targetEntropyGrad += w * _LogMarginalXHistogram(t);
-        sourceEntropyGrad += w * _LogMarginalYHistogram(s);
+    double target_value[GradientBatchSize];
+    double source_value[GradientBatchSize];
+    double wt[4], ws[4], sum;
+    for (int begin = re.begin(); begin < re.end(); begin += GradientBatchSize) {
+      const int n = min(GradientBatchSize, re.end() - begin);
+      for (int i = 0; i < n; ++i) {
+        target_value[i] = ValToRange(_TargetHistogram, _Fixed [begin + i]);
+        source_value[i] = ValToRange(_SourceHistogram, _Moving[begin + i]);
+      }
+      for (int i = 0, idx = begin; i < n; ++i, ++idx) {
+        if (!_This->IsForeground(idx)) continue;
+        const int t0 = static_cast<int>(target_value[i]);
+        const int s0 = static_cast<int>(source_value[i]);
+        for (int a = 0; a < 4; ++a) {
+          wt[a] = irtkBSpline<double>::B  (static_cast<double>(t0 - 1 + a) - target_value[i]);
+          ws[a] = irtkBSpline<double>::B_I(static_cast<double>(s0 - 1 + a) - source_value[i]);
+        }
+        sum = .0;
+        if (0 <= t0 && t0 < _TargetBins && 0 <= s0 && s0 < _SourceBins) {
+          // Table row of bin t0 - 1 starts at index t0 due to the zero border
+          const double *row = _Table + t0 * _Stride + s0;
+          for (int a = 0; a < 4; ++a, row += _Stride) {
+            sum += wt[a] * (ws[0] * row[0] + ws[1] * row[1] + ws[2] * row[2] + ws[3] * row[3]);
+          }
+        } else {
+          // Values outside histogram range (version < 2.2 only)
+          for (int a = 0; a < 4; ++a) {
+            const int t = t0 + a;
+            if (t < 0 || t >= _TargetBins + 3) continue;
+            for (int b = 0; b < 4; ++b) {
+              const int s = s0 + b;
+              if (s < 0 || s >= _SourceBins + 3) continue;
+              sum += wt[a] * ws[b] * _Table[t * _Stride + s];
+            }
+          }
+        }
+        _Gradient[idx] = sum / _Denominator;
       }
-
-      (*deriv) = (targetEntropyGrad + sourceEntropyGrad - _NormalizedMutualInformation * jointEntropyGrad) / _JointEntropy;
     }
   }
 };
@@ -178,13 +208,10 @@ bool irtkNormalizedMutualImageInformation
   const double je  = _Histogram->JointEntropy();
   const double nmi = (_Histogram->EntropyX() + _Histogram->EntropyY()) / je;
 
-  // Log transform histograms
-  irtkHistogram_2D<double>  logJointHistogram(tbin, sbin);
-  irtkHistogram_1D<double>  logMarginalXHistogram(tbin);
-  irtkHistogram_1D<double>  logMarginalYHistogram(sbin);
+  // Log transform marginal histograms
+  irtkHistogram_1D<double> logMarginalXHistogram(tbin);
+  irtkHistogram_1D<double> logMarginalYHistogram(sbin);
 
-  logJointHistogram.PutMin(tmin, smin);
-  logJointHistogram.PutMax(tmax, smax);
   logMarginalXHistogram.PutMin(tmin);
   logMarginalXHistogram.PutMax(tmax);
   logMarginalYHistogram.PutMin(smin);
@@ -193,22 +220,35 @@ bool irtkNormalizedMutualImageInformation
   for (int s = 0; s < sbin; s++)
   for (int t = 0; t < tbin; t++) {
     double num = ((image == Target()) ? (*_Histogram)(s, t) : (*_Histogram)(t, s));
-    logJointHistogram.Add(t, s, num);
     logMarginalXHistogram.Add(t, num);
     logMarginalYHistogram.Add(s, num);
   }
 
-  logJointHistogram    .Log();
+  const double nsamples = logMarginalXHistogram.NumberOfSamples();
   logMarginalXHistogram.Log();
   logMarginalYHistogram.Log();
 
+  // Precompute derivative table with zero border of one bin before and two
+  // bins after the histogram range in each dimension
+  const int stride = sbin + 3;
+  vector<double> table((tbin + 3) * stride, .0);
+  for (int t = 0; t < tbin; t++)
+  for (int s = 0; s < sbin; s++) {
+    double num = ((image == Target()) ? (*_Histogram)(s, t) : (*_Histogram)(t, s));
+    num = (num > .0 ? log(num / nsamples) : .0); // cf. irtkHistogram_2D::Log
+    table[(t + 1) * stride + (s + 1)] = logMarginalXHistogram(t)
+                                      + logMarginalYHistogram(s)
+                                      - nmi * num;
+  }
+
   // Evaluate similarity gradient w.r.t given transformed image
-  CalculateGradient eval(this, logJointHistogram,
-                               logMarginalXHistogram,
-                               logMarginalYHistogram,
-     /* denominator = */ sign * je * _Histogram->NumberOfSamples(), nmi);
+  CalculateGradient eval(this, fixed, image, gradient,
+                         logMarginalXHistogram, logMarginalYHistogram,
+                         &table[0], stride,
+     /* denominator = */ sign * je * _Histogram->NumberOfSamples(),
+                         _NumberOfVoxels);
   memset(gradient->Data(), 0, _NumberOfVoxels * sizeof(GradientType));
-  ParallelForEachVoxel(fixed, image, gradient, eval);
+  parallel_for(blocked_range<int>(0, _NumberOfVoxels, GradientBatchSize), eval);
 
   // Apply chain rule to obtain gradient w.r.t y = T(x)
   MultiplyByImageGradient(image, gradient);
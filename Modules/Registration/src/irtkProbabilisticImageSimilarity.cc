@@ -28,109 +28,143 @@ namespace irtkProbabilisticImageSimilarityUtils {
 
 
 // -----------------------------------------------------------------------------
-/// Add rescaled samples to joint histogram
-class FillHistogram_v1
+/// Map intensity value to joint histogram bin
+///
+/// When the intensities are rescaled, the bin index is computed as done by
+/// irtkHistogram_2D::ValToBinX/Y. Otherwise, the intensities of the images
+/// are already bin indices (version < 2.2), which are truncated or rounded.
+/// Unlike irtkHistogram_2D, no range check is done such that the mapping
+/// can be vectorized by the compiler.
+struct BinIndex
 {
-  const irtkProbabilisticImageSimilarity               *_Similarity;
-  irtkProbabilisticImageSimilarity::JointHistogramType *_Histogram;
-  irtkProbabilisticImageSimilarity::JointHistogramType *_Output;
-
-public:
-
-  FillHistogram_v1(const irtkProbabilisticImageSimilarity               *sim,
-                   irtkProbabilisticImageSimilarity::JointHistogramType *hist)
+  bool   _Rescale;
+  double _Min;
+  double _HalfWidth;
+  double _Range;
+  double _NumberOfBins;
+  double _Offset;
+  int    _MaxBin;
+
+  BinIndex(double min, double max, double width, int nbins)
   :
-    _Similarity(sim), _Histogram(hist), _Output(hist)
+    _Rescale(true), _Min(min), _HalfWidth(.5 * width), _Range(max - min),
+    _NumberOfBins(static_cast<double>(nbins)), _Offset(.5), _MaxBin(nbins - 1)
   {}
 
-  FillHistogram_v1(const FillHistogram_v1 &lhs, split)
+  BinIndex(int nbins, bool round)
   :
-    _Similarity(lhs._Similarity), _Histogram(NULL), _Output(lhs._Output)
-  {
-    _Histogram = new irtkProbabilisticImageSimilarity::JointHistogramType(_Output->NumberOfBinsX(),
-                                                                          _Output->NumberOfBinsY());
-  }
+    _Rescale(false), _Min(.0), _HalfWidth(.0), _Range(1.0),
+    _NumberOfBins(static_cast<double>(nbins)), _Offset(round ? .5 : .0), _MaxBin(nbins - 1)
+  {}
 
-  ~FillHistogram_v1()
+  inline int operator ()(double value) const
   {
-    if (_Histogram != _Output) Delete(_Histogram);
+    if (_Rescale) value = _NumberOfBins * (value - _Min - _HalfWidth) / _Range;
+    int bin = static_cast<int>(value + _Offset);
+    bin = (bin < 0 ? 0 : bin);
+    return (bin > _MaxBin ? _MaxBin : bin);
   }
+};
 
-  void join(const FillHistogram_v1 &rhs)
-  {
-    const int nbins = _Histogram->NumberOfBins();
-    irtkProbabilisticImageSimilarity::JointHistogramType::BinType *l = _Histogram->RawPointer();
-    irtkProbabilisticImageSimilarity::JointHistogramType::BinType *r = rhs._Histogram->RawPointer();
-    for (int i = 0; i < nbins; ++i, ++l, ++r) (*l) += (*r);
-    _Histogram->NumberOfSamples(_Histogram->NumberOfSamples() + rhs._Histogram->NumberOfSamples());
-  }
+// -----------------------------------------------------------------------------
+/// Number of voxels per word of foreground bitset
+const int BitsPerWord = 32;
+
+// -----------------------------------------------------------------------------
+/// Number of voxels whose source bins are computed at once
+const int BinBatchSize = 256;
 
-  void operator ()(const blocked_range<int> &re)
+// -----------------------------------------------------------------------------
+/// Compute target bin indices and foreground bitset of fixed voxels
+struct ComputeTargetBins
+{
+  const irtkRegisteredImage *_Target;
+  const irtkBaseImage       *_Foreground;
+  const irtkBinaryImage     *_Mask;
+  const irtkImageSimilarity *_Similarity;
+  BinIndex                  *_Bin;
+  int                       *_Bins;
+  unsigned int              *_Bits;
+  int                        _NumberOfVoxels;
+
+  void operator ()(const blocked_range<int> &re) const
   {
-    const irtkRegisteredImage::VoxelType *tgt = _Similarity->Target()->Data(re.begin());
-    const irtkRegisteredImage::VoxelType *src = _Similarity->Source()->Data(re.begin());
-    for (int idx = re.begin(); idx != re.end(); ++idx, ++tgt, ++src) {
-      if (_Similarity->IsForeground(idx)) {
-        _Histogram->Add(*tgt, round(*src));
+    for (int w = re.begin(); w != re.end(); ++w) {
+      const int begin = w * BitsPerWord;
+      const int end   = min(begin + BitsPerWord, _NumberOfVoxels);
+      const irtkRegisteredImage::VoxelType *tgt = _Target->Data(begin);
+      unsigned int bits = 0;
+      for (int idx = begin; idx < end; ++idx, ++tgt) {
+        bool fg;
+        if (_Foreground) fg = (!_Mask || _Mask->Get(idx)) && _Foreground->IsForeground(idx);
+        else             fg = _Similarity->IsForeground(idx);
+        if (fg) {
+          bits |= (1u << (idx - begin));
+          _Bins[idx] = (*_Bin)(*tgt);
+        } else {
+          _Bins[idx] = -1;
+        }
       }
+      _Bits[w] = bits;
     }
   }
 };
 
 // -----------------------------------------------------------------------------
-/// Add samples to joint histogram (no rescaling required)
-class FillHistogram_v2
+/// Accumulate joint histogram samples of image tiles
+struct FillTileHistograms
 {
-  const irtkProbabilisticImageSimilarity               *_Similarity;
-  irtkProbabilisticImageSimilarity::JointHistogramType *_Histogram;
-  irtkProbabilisticImageSimilarity::JointHistogramType *_Output;
-
-public:
-
-  FillHistogram_v2(const irtkProbabilisticImageSimilarity               *sim,
-                   irtkProbabilisticImageSimilarity::JointHistogramType *hist)
-  :
-    _Similarity(sim), _Histogram(hist), _Output(hist)
-  {}
-
-  FillHistogram_v2(const FillHistogram_v2 &lhs, split)
-  :
-    _Similarity(lhs._Similarity), _Histogram(NULL), _Output(lhs._Output)
+  const irtkRegisteredImage *_Source;
+  const irtkBaseImage       *_Moving;
+  const int                 *_TargetBins;
+  const unsigned int        *_Foreground;
+  BinIndex                  *_Bin;
+  int                       *_Histograms;
+  int                        _NumberOfBins;
+  int                        _NumberOfTargetBins;
+  int                        _NumberOfVoxels;
+  int                        _TileSize;
+
+  void operator ()(const blocked_range<int> &re) const
   {
-    double xmin, ymin, xmax, ymax, xwidth, ywidth;
-    _Output->GetMin  (&xmin,   &ymin);
-    _Output->GetMax  (&xmax,   &ymax);
-    _Output->GetWidth(&xwidth, &ywidth);
-    _Histogram = new irtkProbabilisticImageSimilarity::JointHistogramType(xmin, xmax, xwidth,
-                                                                          ymin, ymax, ywidth);
-    if (_Histogram->NumberOfBinsX() != _Output->NumberOfBinsX() ||
-        _Histogram->NumberOfBinsY() != _Output->NumberOfBinsY()) {
-      _Histogram->PutNumberOfBins(_Output->NumberOfBinsX(), _Output->NumberOfBinsY());
+    int bins[BinBatchSize];
+    for (int t = re.begin(); t != re.end(); ++t) {
+      int *hist = _Histograms + t * _NumberOfBins;
+      memset(hist, 0, _NumberOfBins * sizeof(int));
+      const int tile_begin = t * _TileSize;
+      const int tile_end   = min(tile_begin + _TileSize, _NumberOfVoxels);
+      for (int begin = tile_begin; begin < tile_end; begin += BinBatchSize) {
+        const int n = min(BinBatchSize, tile_end - begin);
+        // Compute bin indices of source intensities (vectorizable)
+        const irtkRegisteredImage::VoxelType *src = _Source->Data(begin);
+        for (int i = 0; i < n; ++i) bins[i] = (*_Bin)(src[i]);
+        // Add samples of foreground voxels
+        for (int i = 0, idx = begin; i < n; ++i, ++idx) {
+          if ((_Foreground[idx / BitsPerWord] & (1u << (idx % BitsPerWord))) == 0) continue;
+          if (_Moving && !_Moving->IsForeground(idx)) continue;
+          ++hist[bins[i] * _NumberOfTargetBins + _TargetBins[idx]];
+        }
+      }
     }
   }
+};
 
-  ~FillHistogram_v2()
-  {
-    if (_Histogram != _Output) Delete(_Histogram);
-  }
-
-  void join(const FillHistogram_v2 &rhs)
-  {
-    const int nbins = _Histogram->NumberOfBins();
-    irtkProbabilisticImageSimilarity::JointHistogramType::BinType *l = _Histogram->RawPointer();
-    irtkProbabilisticImageSimilarity::JointHistogramType::BinType *r = rhs._Histogram->RawPointer();
-    for (int i = 0; i < nbins; ++i, ++l, ++r) (*l) += (*r);
-    _Histogram->NumberOfSamples(_Histogram->NumberOfSamples() + rhs._Histogram->NumberOfSamples());
-  }
+// -----------------------------------------------------------------------------
+/// Sum histograms of image tiles
+struct SumTileHistograms
+{
+  const int *_Histograms;
+  int        _NumberOfTiles;
+  int        _NumberOfBins;
+  double    *_Output;
 
-  void operator ()(const blocked_range<int> &re)
+  void operator ()(const blocked_range<int> &re) const
   {
-    const irtkRegisteredImage::VoxelType *tgt = _Similarity->Target()->Data(re.begin());
-    const irtkRegisteredImage::VoxelType *src = _Similarity->Source()->Data(re.begin());
-    for (int idx = re.begin(); idx != re.end(); ++idx, ++tgt, ++src) {
-      if (_Similarity->IsForeground(idx)) {
-        _Histogram->Add(_Histogram->ValToBinX(*tgt), _Histogram->ValToBinY(*src));
-      }
+    for (int b = re.begin(); b != re.end(); ++b) {
+      int sum = 0;
+      const int *hist = _Histograms + b;
+      for (int t = 0; t < _NumberOfTiles; ++t, hist += _NumberOfBins) sum += *hist;
+      _Output[b] = static_cast<double>(sum);
     }
   }
 };
@@ -173,6 +207,8 @@ irtkProbabilisticImageSimilarity &irtkProbabilisticImageSimilarity::operator =(c
   _Histogram          = other._Histogram ? new JointHistogramType(*other._Histogram) : NULL;
   _NumberOfTargetBins = other._NumberOfTargetBins;
   _NumberOfSourceBins = other._NumberOfSourceBins;
+  _TargetBins     .clear();
+  _FixedForeground.clear();
   return *this;
 }
 
@@ -274,11 +310,103 @@ void irtkProbabilisticImageSimilarity::Initialize()
 
   // Initialize joint histogram
   if (!_Histogram) _Histogram = new JointHistogramType(*_Samples);
+
+  // Discard precomputed bins of previous initialization
+  _TargetBins     .clear();
+  _FixedForeground.clear();
+}
+
+// -----------------------------------------------------------------------------
+void irtkProbabilisticImageSimilarity::UpdateTargetBins()
+{
+  double xmin, ymin, xmax, ymax, xwidth, ywidth;
+  _Samples->GetMin  (&xmin,   &ymin);
+  _Samples->GetMax  (&xmax,   &ymax);
+  _Samples->GetWidth(&xwidth, &ywidth);
+  BinIndex bin = (version >= irtkVersion(2, 2))
+               ? BinIndex(xmin, xmax, xwidth, _Samples->NumberOfBinsX())
+               : BinIndex(_Samples->NumberOfBinsX(), false);
+
+  // Foreground of fixed voxels, see irtkImageSimilarity::IsForeground.
+  // When only the source is transformed and has no mask, the source
+  // foreground is checked by FillSamples for each update instead.
+  const irtkBaseImage *fg = NULL;
+  if (_Source->Transformation() && !_Target->Transformation() && !_Source->HasMask()) {
+    fg = _Target;
+  }
+
+  const int nwords = (_NumberOfVoxels + BitsPerWord - 1) / BitsPerWord;
+  _TargetBins     .resize(_NumberOfVoxels);
+  _FixedForeground.resize(nwords);
+
+  ComputeTargetBins body;
+  body._Target         = _Target;
+  body._Foreground     = fg;
+  body._Mask           = _Mask;
+  body._Similarity     = this;
+  body._Bin            = &bin;
+  body._Bins           = &_TargetBins[0];
+  body._Bits           = &_FixedForeground[0];
+  body._NumberOfVoxels = _NumberOfVoxels;
+  parallel_for(blocked_range<int>(0, nwords), body);
+}
+
+// -----------------------------------------------------------------------------
+void irtkProbabilisticImageSimilarity::FillSamples()
+{
+  // Precompute bins of target intensities only once unless target is moving
+  if (_TargetBins.empty() || _Target->Transformation()) UpdateTargetBins();
+
+  double xmin, ymin, xmax, ymax, xwidth, ywidth;
+  _Samples->GetMin  (&xmin,   &ymin);
+  _Samples->GetMax  (&xmax,   &ymax);
+  _Samples->GetWidth(&xwidth, &ywidth);
+  BinIndex bin = (version >= irtkVersion(2, 2))
+               ? BinIndex(ymin, ymax, ywidth, _Samples->NumberOfBinsY())
+               : BinIndex(_Samples->NumberOfBinsY(), true);
+
+  // Fixed number of tiles such that histogram pool is allocated only once
+  const int nbins    = _Samples->NumberOfBins();
+  const int tilesize = max(BinBatchSize, (_NumberOfVoxels + 63) / 64);
+  const int ntiles   = (_NumberOfVoxels + tilesize - 1) / tilesize;
+  if (ntiles == 0) return;
+  _TileHistograms.resize(ntiles * nbins);
+
+  FillTileHistograms fill;
+  fill._Source             = _Source;
+  fill._Moving             = NULL;
+  fill._TargetBins         = &_TargetBins[0];
+  fill._Foreground         = &_FixedForeground[0];
+  fill._Bin                = &bin;
+  fill._Histograms         = &_TileHistograms[0];
+  fill._NumberOfBins       = nbins;
+  fill._NumberOfTargetBins = _Samples->NumberOfBinsX();
+  fill._NumberOfVoxels     = _NumberOfVoxels;
+  fill._TileSize           = tilesize;
+  if (_Source->Transformation() && !_Target->Transformation() && !_Source->HasMask()) {
+    fill._Moving = _Source;
+  }
+  parallel_for(blocked_range<int>(0, ntiles), fill);
+
+  SumTileHistograms sum;
+  sum._Histograms    = &_TileHistograms[0];
+  sum._NumberOfTiles = ntiles;
+  sum._NumberOfBins  = nbins;
+  sum._Output        = _Samples->RawPointer();
+  parallel_for(blocked_range<int>(0, nbins), sum);
+
+  double nsamples = .0;
+  const double *hist = _Samples->RawPointer();
+  for (int b = 0; b < nbins; ++b) nsamples += hist[b];
+  _Samples->NumberOfSamples(nsamples);
 }
 
 // -----------------------------------------------------------------------------
 void irtkProbabilisticImageSimilarity::Update(bool gradient)
 {
+  // Update only samples of changed image regions if possible
+  if (!gradient && UpdateChangedRegions()) return;
+
   // Update base class and moving image(s)
   irtkImageSimilarity::Update(gradient);
 
@@ -288,14 +416,7 @@ void irtkProbabilisticImageSimilarity::Update(bool gradient)
   _Samples->Reset();
 
   // Add histogram samples
-  blocked_range<int> voxels(0, _NumberOfVoxels, _NumberOfVoxels / 8);
-  if (version >= irtkVersion(2, 2)) {
-    FillHistogram_v2 add(this, _Samples);
-    parallel_reduce(voxels, add);
-  } else {
-    FillHistogram_v1 add(this, _Samples);
-    parallel_reduce(voxels, add);
-  }
+  FillSamples();
 
   // Smooth histogram
   //
@@ -332,7 +453,7 @@ void irtkProbabilisticImageSimilarity::Exclude(const blocked_range3d<int> &regio
 }
 
 // -----------------------------------------------------------------------------
-void irtkProbabilisticImageSimilarity::Include(const blocked_range3d<int> &region)
+bool irtkProbabilisticImageSimilarity::AddSamples(const blocked_range3d<int> &region)
 {
   bool changed = false;
   if (version >= irtkVersion(2, 2)) {
@@ -355,12 +476,27 @@ void irtkProbabilisticImageSimilarity::Include(const blocked_range3d<int> &regio
       }
     }
   }
-  if (changed) {
+  return changed;
+}
+
+// -----------------------------------------------------------------------------
+void irtkProbabilisticImageSimilarity::Include(const blocked_range3d<int> &region)
+{
+  if (AddSamples(region)) {
     _Histogram->Reset(*_Samples);
     _Histogram->Smooth();
   }
 }
 
+// -----------------------------------------------------------------------------
+void irtkProbabilisticImageSimilarity::IncludeRegions(const vector<blocked_range3d<int> > &regions)
+{
+  // Always smooth histogram as samples of excluded regions were removed
+  for (size_t r = 0; r < regions.size(); ++r) AddSamples(regions[r]);
+  _Histogram->Reset(*_Samples);
+  _Histogram->Smooth();
+}
+
 // =============================================================================
 // Debugging
 // =============================================================================
@@ -58,7 +58,7 @@ irtkRegisteredImage::irtkRegisteredImage()
 // -----------------------------------------------------------------------------
 irtkRegisteredImage::irtkRegisteredImage(const irtkRegisteredImage &other)
 :
-  irtkGenericImage<double>(other),
+  irtkGenericImage<irtkRegisteredPixel>(other),
   _InputImage            (other._InputImage),
   _InputGradient         (other._InputGradient  ? new GradientImageType(*other._InputGradient)  : NULL),
   _InputHessian          (other._InputHessian   ? new GradientImageType(*other._InputHessian)   : NULL),
@@ -88,7 +88,7 @@ irtkRegisteredImage::irtkRegisteredImage(const irtkRegisteredImage &other)
 // -----------------------------------------------------------------------------
 irtkRegisteredImage &irtkRegisteredImage::operator =(const irtkRegisteredImage &other)
 {
-  irtkGenericImage<double>::operator =(other);
+  irtkGenericImage<irtkRegisteredPixel>::operator =(other);
   _InputImage             = other._InputImage;
   _InputGradient          = other._InputGradient  ? new GradientImageType(*other._InputGradient)  : NULL;
   _InputHessian           = other._InputHessian   ? new GradientImageType(*other._InputHessian)   : NULL;
@@ -149,7 +149,7 @@ void irtkRegisteredImage::Initialize(const irtkImageAttributes &attr, int t)
     cerr << "irtkRegisteredImage::Initialize: Number of registered image channels must be either 1, 4, 10 or 13" << endl;
     exit(1);
   }
-  irtkGenericImage<double>::Initialize(attr, t);
+  irtkGenericImage<irtkRegisteredPixel>::Initialize(attr, t);
 
   // Set background value/foreground mask
   if (_InputImage->HasBackgroundValue()) {
@@ -563,6 +563,8 @@ class Interpolator
 {
 protected:
 
+  typedef irtkRegisteredImage::VoxelType VoxelType;
+
   IntensityFunction   *_IntensityFunction;
   GradientFunction    *_GradientFunction;
   HessianFunction     *_HessianFunction;
@@ -708,32 +710,34 @@ public:
   /// Interpolate input intensity function
   ///
   /// \return The interpolation mode, i.e., result of inside/outside domain check.
-  int InterpolateIntensity(double x, double y, double z, double *o)
+  int InterpolateIntensity(double x, double y, double z, VoxelType *o)
   {
+    double v;
     // Check if location is inside image domain
     int mode = InterpolationMode(x, y, z, false);
     if (mode == 1) {
       // Either interpolate using the input padding value to exclude background
       if (_InterpolateWithPadding) {
-        *o = _IntensityFunction->EvaluateWithPaddingInside(x, y, z);
+        v = _IntensityFunction->EvaluateWithPaddingInside(x, y, z);
       // or simply ignore the input background value as done by nreg2
       } else {
-        *o = _IntensityFunction->EvaluateInside(x, y, z);
+        v = _IntensityFunction->EvaluateInside(x, y, z);
       }
       // Set background to output padding value
-      if (*o == _IntensityFunction->DefaultValue()) {
-        *o = _PaddingValue;
-        if (_InterpolateWithPadding) return -1;
+      if (v == _IntensityFunction->DefaultValue()) {
+        v = _PaddingValue;
+        if (_InterpolateWithPadding) mode = -1;
       // Rescale foreground to desired [min, max] range
       } else if (_RescaleSlope != 1.0 || _RescaleIntercept != .0) {
-        *o = (*o) * _RescaleSlope + _RescaleIntercept;
-        if      (*o < _MinIntensity) *o = _MinIntensity;
-        else if (*o > _MaxIntensity) *o = _MaxIntensity;
+        v = v * _RescaleSlope + _RescaleIntercept;
+        if      (v < _MinIntensity) v = _MinIntensity;
+        else if (v > _MaxIntensity) v = _MaxIntensity;
       }
     // Otherwise, set output intensity to outside value
     } else {
-      *o = _PaddingValue;
+      v = _PaddingValue;
     }
+    *o = static_cast<VoxelType>(v);
     // Pass inside/outside check result on to derivative interpolation
     // functions such that these boundary checks are only done once.
     // This requires the same interpolation mode for all channels.
@@ -741,38 +745,42 @@ public:
   }
 
   /// Interpolate 1st order derivatives of input intensity function
-  void InterpolateGradient(double x, double y, double z, double *o, int mode = 0)
+  void InterpolateGradient(double x, double y, double z, VoxelType *o, int mode = 0)
   {
     o += _NumberOfVoxels;
     switch (mode) {
       // Inside
-      case 1:
+      case 1: {
+        double g[3];
         if (_InterpolateWithPadding) {
-          _GradientFunction->EvaluateWithPaddingInside(o, x, y, z, _NumberOfVoxels);
+          _GradientFunction->EvaluateWithPaddingInside(g, x, y, z);
         } else {
-          _GradientFunction->EvaluateInside(o, x, y, z, _NumberOfVoxels);
+          _GradientFunction->EvaluateInside(g, x, y, z);
         }
-        break;
+        for (int c = 0; c < 3; ++c, o += _NumberOfVoxels) *o = static_cast<VoxelType>(g[c]);
+      } break;
       // Outside/Boundary
-      default: for (int c = 1; c <= 3; ++c, o += _NumberOfVoxels) *o = .0;
+      default: for (int c = 1; c <= 3; ++c, o += _NumberOfVoxels) *o = VoxelType(0);
     }
   }
 
   /// Interpolate 2nd order derivatives of input intensity function
-  void InterpolateHessian(double x, double y, double z, double *o, int mode = 0)
+  void InterpolateHessian(double x, double y, double z, VoxelType *o, int mode = 0)
   {
     o += 4 * _NumberOfVoxels;
     switch (mode) {
       // Inside
-      case 1:
+      case 1: {
+        double h[9];
         if (_InterpolateWithPadding) {
-          _HessianFunction->EvaluateWithPaddingInside(o, x, y, z, _NumberOfVoxels);
+          _HessianFunction->EvaluateWithPaddingInside(h, x, y, z);
         } else {
-          _HessianFunction->EvaluateInside(o, x, y, z, _NumberOfVoxels);
+          _HessianFunction->EvaluateInside(h, x, y, z);
         }
-        break;
+        for (int c = 4; c < _NumberOfChannels; ++c, o += _NumberOfVoxels) *o = static_cast<VoxelType>(h[c-4]);
+      } break;
       // Outside/Boundary
-      default: for (int c = 4; c < _NumberOfChannels; ++c, o += _NumberOfVoxels) *o = .0;
+      default: for (int c = 4; c < _NumberOfChannels; ++c, o += _NumberOfVoxels) *o = VoxelType(0);
     }
   }
 };
@@ -782,7 +790,7 @@ public:
 template <class IntensityFunction, class GradientFunction, class HessianFunction>
 struct IntensityInterpolator : public Interpolator<IntensityFunction, GradientFunction, HessianFunction>
 {
-  void operator()(double x, double y, double z, double *o)
+  void operator()(double x, double y, double z, irtkRegisteredImage::VoxelType *o)
   {
     this->InterpolateIntensity(x, y, z, o);
   }
@@ -793,7 +801,7 @@ struct IntensityInterpolator : public Interpolator<IntensityFunction, GradientFu
 template <class IntensityFunction, class GradientFunction, class HessianFunction>
 struct GradientInterpolator : public Interpolator<IntensityFunction, GradientFunction, HessianFunction>
 {
-  void operator()(double x, double y, double z, double *o)
+  void operator()(double x, double y, double z, irtkRegisteredImage::VoxelType *o)
   {
     int mode = this->InterpolationMode  (x, y, z);
     this           ->InterpolateGradient(x, y, z, o, mode);
@@ -805,7 +813,7 @@ struct GradientInterpolator : public Interpolator<IntensityFunction, GradientFun
 template <class IntensityFunction, class GradientFunction, class HessianFunction>
 struct HessianInterpolator : public Interpolator<IntensityFunction, GradientFunction, HessianFunction>
 {
-  void operator()(double x, double y, double z, double *o)
+  void operator()(double x, double y, double z, irtkRegisteredImage::VoxelType *o)
   {
     int mode = this->InterpolationMode (x, y, z);
     this           ->InterpolateHessian(x, y, z, o, mode);
@@ -817,7 +825,7 @@ struct HessianInterpolator : public Interpolator<IntensityFunction, GradientFunc
 template <class IntensityFunction, class GradientFunction, class HessianFunction>
 struct IntensityAndGradientInterpolator : public Interpolator<IntensityFunction, GradientFunction, HessianFunction>
 {
-  void operator()(double x, double y, double z, double *o)
+  void operator()(double x, double y, double z, irtkRegisteredImage::VoxelType *o)
   {
     int mode = this->InterpolateIntensity(x, y, z, o);
     this           ->InterpolateGradient (x, y, z, o, mode);
@@ -829,7 +837,7 @@ struct IntensityAndGradientInterpolator : public Interpolator<IntensityFunction,
 template <class IntensityFunction, class GradientFunction, class HessianFunction>
 struct IntensityAndHessianInterpolator : public Interpolator<IntensityFunction, GradientFunction, HessianFunction>
 {
-  void operator()(double x, double y, double z, double *o)
+  void operator()(double x, double y, double z, irtkRegisteredImage::VoxelType *o)
   {
     int mode = this->InterpolateIntensity(x, y, z, o);
     this           ->InterpolateHessian  (x, y, z, o, mode);
@@ -841,7 +849,7 @@ struct IntensityAndHessianInterpolator : public Interpolator<IntensityFunction,
 template <class IntensityFunction, class GradientFunction, class HessianFunction>
 struct GradientAndHessianInterpolator : public Interpolator<IntensityFunction, GradientFunction, HessianFunction>
 {
-  void operator()(double x, double y, double z, double *o)
+  void operator()(double x, double y, double z, irtkRegisteredImage::VoxelType *o)
   {
     int mode = this->InterpolationMode  (x, y, z);
     this           ->InterpolateGradient(x, y, z, o, mode);
@@ -854,7 +862,7 @@ struct GradientAndHessianInterpolator : public Interpolator<IntensityFunction, G
 template <class IntensityFunction, class GradientFunction, class HessianFunction>
 struct IntensityAndGradientAndHessianInterpolator : public Interpolator<IntensityFunction, GradientFunction, HessianFunction>
 {
-  void operator()(double x, double y, double z, double *o)
+  void operator()(double x, double y, double z, irtkRegisteredImage::VoxelType *o)
   {
     int mode = this->InterpolateIntensity(x, y, z, o);
     this           ->InterpolateGradient (x, y, z, o, mode);
@@ -870,6 +878,7 @@ struct UpdateFunction : public irtkVoxelFunction
 private:
 
   typedef typename Transformer::CoordType CoordType;
+  typedef irtkRegisteredImage::VoxelType  VoxelType;
 
   Transformer  _Transform;
   Interpolator _Interpolate;
@@ -890,7 +899,7 @@ public:
   }
 
   /// Resample input without pre-computed maps
-  void operator ()(int i, int j, int k, int, double *o)
+  void operator ()(int i, int j, int k, int, VoxelType *o)
   {
     double x = i, y = j, z = k;
     _Transform  (x, y, z);
@@ -898,7 +907,7 @@ public:
   }
 
   /// Resample input using pre-computed world coordinates
-  void operator ()(int i, int j, int k, int, const CoordType *wc, double *o)
+  void operator ()(int i, int j, int k, int, const CoordType *wc, VoxelType *o)
   {
     double x = i, y = j, z = k;
     _Transform  (x, y, z, wc);
@@ -906,7 +915,7 @@ public:
   }
 
   /// Resample input using pre-computed world coordinates and displacements
-  void operator ()(int i, int j, int k, int, const CoordType *wc, const double *dx, double *o)
+  void operator ()(int i, int j, int k, int, const CoordType *wc, const double *dx, VoxelType *o)
   {
     double x = i, y = j, z = k;
     _Transform  (x, y, z, wc, dx);
@@ -914,7 +923,7 @@ public:
   }
 
   /// Resample input using pre-computed world coordinates and additive displacements
-  void operator ()(int i, int j, int k, int, const CoordType *wc, const double *d1, const double *d2, double *o)
+  void operator ()(int i, int j, int k, int, const CoordType *wc, const double *d1, const double *d2, VoxelType *o)
   {
     double x = i, y = j, z = k;
     _Transform  (x, y, z, wc, d1, d2);
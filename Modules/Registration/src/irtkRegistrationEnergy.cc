@@ -317,6 +317,7 @@ void irtkRegistrationEnergy::Update(bool gradient)
   //            in this case to avoid another unnecessary update of the input.
   //            E.g., irtkRegisteredImage::SelfUpdate(false) for image similarities.
   if (_PreUpdateFunction) {
+    IRTK_PROFILE_REGION("preupdate of energy function");
     IRTK_START_TIMING();
     _PreUpdateFunction(gradient);
     IRTK_DEBUG_TIMING(3, "preupdate of function");
@@ -341,9 +342,13 @@ void irtkRegistrationEnergy::Update(bool gradient)
   // to just use an external update handler which has a reference to all the
   // input moving images and updates them all at once in predefined order.
   if (_Transformation->Changed() || gradient) {
+    IRTK_PROFILE_REGION("update of energy function");
     IRTK_START_TIMING();
     for (size_t i = 0; i < _Term.size(); ++i) {
-      if (_Term[i]->Weight() != .0) _Term[i]->Update(gradient);
+      if (_Term[i]->Weight() != .0) {
+        IRTK_PROFILE_REGION(_Term[i]->Name());
+        _Term[i]->Update(gradient);
+      }
     }
     // Mark transformation as unchanged
     _Transformation->Changed(false);
@@ -418,11 +423,13 @@ double irtkRegistrationEnergy::RawValue(int i)
 // -----------------------------------------------------------------------------
 double irtkRegistrationEnergy::InitialValue()
 {
+  IRTK_PROFILE_REGION("initial evaluation of energy function");
   IRTK_START_TIMING();
 
   double sum = .0;
   for (size_t i = 0; i < _Term.size(); ++i) {
     if (_Term[i]->Weight() != .0) {
+      IRTK_PROFILE_REGION(_Term[i]->Name());
       sum += _Term[i]->InitialValue();
     } else {
       _Value[i] = .0;
@@ -442,12 +449,16 @@ double irtkRegistrationEnergy::InitialValue(int i)
 // -----------------------------------------------------------------------------
 double irtkRegistrationEnergy::Value()
 {
+  IRTK_PROFILE_REGION("evaluation of energy function");
   IRTK_START_TIMING();
 
   double sum = .0;
   for (size_t i = 0; i < _Term.size(); ++i) {
     if (_Term[i]->Weight() != .0) {
-      if (IsNaN(_Value[i])) _Value[i] = _Term[i]->Value();
+      if (IsNaN(_Value[i])) {
+        IRTK_PROFILE_REGION(_Term[i]->Name());
+        _Value[i] = _Term[i]->Value();
+      }
       sum += _Value[i];
     } else {
       _Value[i] = .0;
@@ -476,6 +487,7 @@ void irtkRegistrationEnergy::NormalizeGradient(double *gradient)
   const int nlevels = (mffd ? mffd->NumberOfLevels() : (affd ? 1 : 0));
   if (nlevels == 0) return; // Skip if transformation is not a FFD
 
+  IRTK_PROFILE_REGION("normalization of energy gradient");
   IRTK_START_TIMING();
 
   for (int lvl = 0; lvl < nlevels; ++lvl) {
@@ -508,6 +520,7 @@ void irtkRegistrationEnergy::NormalizeGradient(double *gradient)
 // -----------------------------------------------------------------------------
 void irtkRegistrationEnergy::Gradient(double *gradient, double step, bool *sgn_chg)
 {
+  IRTK_PROFILE_REGION("evaluation of energy gradient");
   IRTK_START_TIMING();
 
   const int ndofs = _Transformation->NumberOfDOFs();
@@ -544,6 +557,7 @@ void irtkRegistrationEnergy::Gradient(double *gradient, double step, bool *sgn_c
       if (w != .0) {
         sparsity = dynamic_cast<irtkSparsityConstraint *>(_Term[i]);
         if (sparsity) continue;
+        IRTK_PROFILE_REGION(_Term[i]->Name());
         _Term[i]->Weight(w / W);
         _Term[i]->NormalizedGradient(gradient, step);
         _Term[i]->Weight(w);
@@ -554,6 +568,7 @@ void irtkRegistrationEnergy::Gradient(double *gradient, double step, bool *sgn_c
       if (_Term[i]->Weight() != .0) {
         sparsity = dynamic_cast<irtkSparsityConstraint *>(_Term[i]);
         if (sparsity) continue;
+        IRTK_PROFILE_REGION(_Term[i]->Name());
         _Term[i]->Gradient(gradient, step);
       }
     }
@@ -564,6 +579,7 @@ void irtkRegistrationEnergy::Gradient(double *gradient, double step, bool *sgn_c
     if (_Term[i]->Weight() != .0) {
       sparsity = dynamic_cast<irtkSparsityConstraint *>(_Term[i]);
       if (sparsity) {
+        IRTK_PROFILE_REGION(sparsity->Name());
         sparsity->Gradient(gradient, step, sgn_chg);
         break; // Ignore additional sparsity terms
       }
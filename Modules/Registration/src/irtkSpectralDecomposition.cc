@@ -24,12 +24,6 @@
 #include <vtkOctreePointLocator.h>
 #include <vtkPolyData.h>
 
-#define USE_mlxHungarian 0
-//#ifdef HAVE_MATLAB
-//#  define USE_mlxHungarian 1
-//#  include <libirtkmwutils.h>
-//#endif
-
 using namespace irtk::polydata;
 
 
@@ -251,8 +245,8 @@ public:
     const int n = static_cast<int>(_J   .size());
     const int k = static_cast<int>(_J[0].size());
     double c1, c2, sum1, sum2;
-    for (int c = re.rows().begin(); c != re.rows().end(); ++c) {
-    for (int r = re.cols().begin(); r != re.cols().end(); ++r) {
+    for (int r = re.rows().begin(); r != re.rows().end(); ++r) {
+    for (int c = re.cols().begin(); c != re.cols().end(); ++c) {
       c1 = c2 = .0;
       for (int i = 0; i < n; ++i) {
         sum1 = sum2 = .0;
@@ -267,12 +261,15 @@ public:
         _C(r, c) = sqrt(c1) / n;
       } else {
         _C(r, c) = sqrt(c2) / n;
-        _S.push_back(_C.Index(r, c));
+        _S.push_back(r * _C.Cols() + c);
       }
     }
     }
   }
 
+  /// Compute dense assignment cost matrix
+  ///
+  /// \param[out] flip Sorted indices r * m2.Cols() + c of pairs with sign flip.
   static irtkMatrix Run(const irtkPointSet &p1, const irtkMatrix &m1,
                         const irtkPointSet &p2, const irtkMatrix &m2,
                         const vector<vector<int> > &r12, vector<int> *flip = NULL)
@@ -289,35 +286,72 @@ public:
   }
 };
 
+// -----------------------------------------------------------------------------
+/// Solve dense linear assignment problem with n <= m using the shortest
+/// augmenting path method with dual variables (Hungarian/Jonker-Volgenant)
+///
+/// \param[in] cost Cost matrix, accessed as cost(i, j) for i < n and j < m,
+///                 or cost(j, i) if \p transpose is true.
+///
+/// \returns Column index assigned to each row.
+vector<int> DenseAssignment(const irtkMatrix &cost, int n, int m, bool transpose)
+{
+  const double inf = numeric_limits<double>::infinity();
+  // Dual variables and matching of 1-based rows/columns, where column 0 is
+  // a virtual column which is used to start the search from a free row
+  vector<double> u(n + 1, .0), v(m + 1, .0), minv(m + 1);
+  vector<int>    p(m + 1, 0), way(m + 1, 0);
+  vector<char>   used(m + 1);
+  double c, delta;
+  int    i0, j0, j1;
+  for (int i = 1; i <= n; ++i) {
+    p[0] = i, j0 = 0;
+    fill(minv.begin(), minv.end(), inf);
+    fill(used.begin(), used.end(), false);
+    do {
+      used[j0] = true;
+      i0 = p[j0], delta = inf, j1 = 0;
+      for (int j = 1; j <= m; ++j) {
+        if (!used[j]) {
+          c = (transpose ? cost(j - 1, i0 - 1) : cost(i0 - 1, j - 1)) - u[i0] - v[j];
+          if (c < minv[j]) minv[j] = c, way[j] = j0;
+          if (minv[j] < delta) delta = minv[j], j1 = j;
+        }
+      }
+      for (int j = 0; j <= m; ++j) {
+        if (used[j]) u[p[j]] += delta, v[j] -= delta;
+        else         minv[j] -= delta;
+      }
+      j0 = j1;
+    } while (p[j0] != 0);
+    // Augment matching along alternating path
+    do {
+      j1 = way[j0];
+      p[j0] = p[j1];
+      j0 = j1;
+    } while (j0 != 0);
+  }
+  vector<int> match(n, -1);
+  for (int j = 1; j <= m; ++j) {
+    if (p[j] != 0) match[p[j] - 1] = j - 1;
+  }
+  return match;
+}
+
 // -----------------------------------------------------------------------------
 vector<int> WeightedMatching(const irtkMatrix &cost)
 {
-  vector<int> match(cost.Rows(), -1); // Maps row index to matching column index
   IRTK_START_TIMING();
-#if USE_mlxHungarian
-  const int nlhs = 1, nrhs = 1; // M = hungarian(cost)
-  mxArray *lhs[nlhs] = { NULL };
-  mxArray *rhs[nrhs] = { cost.MxArray() };
-  bool ok = mlxHungarian(nlhs, lhs, nrhs, rhs);
-  for (int i = 0; i < nrhs; ++i) mxDestroyArray(rhs[i]);
-  if (!ok) {
-    cerr << "WeightedMatching: Failed to call mlxHungarian, ensure that libirtkmwutilsInitialize was called" << endl;
-    exit(1);
-  }
-  irtkAssert(mxIsDouble(lhs[0]), "mlxHungarian returns match in matrix of type DOUBLE");
-  irtkAssert(static_cast<int>(mxGetM(lhs[0])) == cost.Rows(), "same size as cost matrix");
-  irtkAssert(static_cast<int>(mxGetN(lhs[0])) == cost.Cols(), "same size as cost matrix");
-  double *m = mxGetPr(lhs[0]);
-  for (int c = 0; c < cost.Cols(); ++c) {
-    for (int r = 0; r < cost.Rows(); ++r) {
-      if (*m++ != .0) match[r] = c;
-    }
+  const int rows = cost.Rows();
+  const int cols = cost.Cols();
+  vector<int> match; // Maps row index to matching column index
+  if (rows <= cols) {
+    match = DenseAssignment(cost, rows, cols, false);
+  } else {
+    vector<int> col2row = DenseAssignment(cost, cols, rows, true);
+    match.resize(rows, -1);
+    for (int c = 0; c < cols; ++c) match[col2row[c]] = c;
   }
-  for (int i = 0; i < nlhs; ++i) mxDestroyArray(lhs[i]);
-#else
-  cerr << "No C/C++ hungarian implementation selected during build configuration" << endl;
-  exit(1);
-#endif
   IRTK_DEBUG_TIMING(10, "bipartite matching");
   return match;
 }
@@ -1061,16 +1095,18 @@ irtkVector MatchEigenmodes(const irtkPointSet &lp1, irtkMatrix       &lm1,
   vector<int> flip;
   vector<vector<int> > r12 = FindClosestNPoints::Run(lp1, lp2, 1);
   irtkMatrix w12 = ComputeAssignmentCosts::Run(lp1, lm1, lp2, lm2, r12, &flip);
-  // Find optimal assignment
+  // Find optimal assignment, the k x k problem is small enough to be solved
+  // exactly using the dense solver
   vector<int> c12 = WeightedMatching(w12);
   // Flip signs
+  const int n = w12.Cols();
   vector<int> idx(k);
-  for (int i = 0; i < k; ++i) idx[i] = w12.Index(i, c12[i]);
+  for (int i = 0; i < k; ++i) idx[i] = i * n + c12[i];
   sort(idx.begin(), idx.end());
   flip.resize(set_intersection(flip.begin(), flip.end(),
                                idx .begin(), idx .end(),
                                flip.begin()) - flip.begin());
-  for (size_t i = 0; i < flip.size(); ++i) flip[i] = w12.ColIndex(flip[i]);
+  for (size_t i = 0; i < flip.size(); ++i) flip[i] %= n;
   FlipSign(m2, flip);
   // Reorder eigenmodes
   m2.PermuteCols(c12);
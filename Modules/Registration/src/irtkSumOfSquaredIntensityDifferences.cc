@@ -62,7 +62,8 @@ struct EvaluateSumOfSquaredDifferences : public irtkVoxelReduction
   void operator ()(int i, int j, int k, int, VoxelType *t, VoxelType *s)
   {
     if (_Sim->IsForeground(i, j, k)) {
-      _Sum += static_cast<double>(pow(*t - *s, 2));
+      const double d = static_cast<double>(*t) - static_cast<double>(*s);
+      _Sum += d * d;
       ++_Cnt;
     }
   }
@@ -82,7 +83,7 @@ struct EvaluateSumOfSquaredDifferencesGradient : public irtkVoxelFunction
   void operator ()(int i, int j, int k, int, const VoxelType *t, const VoxelType *s, GradientType *g)
   {
     if (_Sim->IsForeground(i, j, k)) {
-      *g = -2.0 * static_cast<double>(*t - *s);
+      *g = -2.0 * (static_cast<double>(*t) - static_cast<double>(*s));
     } else {
       *g = .0;
     }
@@ -147,6 +148,8 @@ void irtkSumOfSquaredIntensityDifferences::Initialize()
 // -----------------------------------------------------------------------------
 void irtkSumOfSquaredIntensityDifferences::Update(bool gradient)
 {
+  // Update only changed image regions and their sums if possible
+  if (!gradient && UpdateChangedRegions()) return;
   // Upate base class and moving image(s)
   irtkImageSimilarity::Update(gradient);
   // Evaluate sum of squared differences over all voxels
@@ -31,8 +31,8 @@
 #include <vtkFloatArray.h>
 #include <vtkUnsignedCharArray.h>
 
-#include <vtkAbstractPointLocator.h>
-#include <vtkOctreePointLocator.h>
+#include <vtkPoints.h>
+#include <vtkCellArray.h>
 #include <vtkIntersectionPolyDataFilter.h>
 
 using namespace irtk::polydata;
@@ -50,12 +50,17 @@ namespace irtkSurfaceCollisionsUtils {
 class ComputeBoundingSpheres
 {
   vtkPolyData  *_Surface;
+  const double *_Points;
+  const char   *_Moved;
   vtkDataArray *_Center;
   vtkDataArray *_Radius;
+  double       *_Bounds;
 
-  ComputeBoundingSpheres(vtkPolyData *surface, vtkDataArray *center, vtkDataArray *radius)
+  ComputeBoundingSpheres(vtkPolyData *surface, const double *points, const char *moved,
+                         vtkDataArray *center, vtkDataArray *radius, double *bounds)
   :
-    _Surface(surface), _Center(center), _Radius(radius)
+    _Surface(surface), _Points(points), _Moved(moved),
+    _Center(center), _Radius(radius), _Bounds(bounds)
   {}
 
 public:
@@ -64,20 +69,23 @@ public:
   void operator ()(const blocked_range<vtkIdType> &re) const
   {
     vtkIdType npts, *pts;
-    double a[3], b[3], c[3], origin[3], radius;
+    double origin[3], radius;
 
     for (vtkIdType cellId = re.begin(); cellId != re.end(); ++cellId) {
       // Get triangle vertices
       _Surface->GetCellPoints(cellId, npts, pts);
       irtkAssert(npts == 3, "surface is triangular mesh");
 
+      // Skip triangles whose vertices did not move since previous update
+      if (_Moved && !_Moved[pts[0]] && !_Moved[pts[1]] && !_Moved[pts[2]]) continue;
+
       // Get triangle vertex positions
-      _Surface->GetPoint(pts[0], a);
-      _Surface->GetPoint(pts[1], b);
-      _Surface->GetPoint(pts[2], c);
+      const double *a = _Points + 3 * pts[0];
+      const double *b = _Points + 3 * pts[1];
+      const double *c = _Points + 3 * pts[2];
 
       // Get center of bounding sphere
-      vtkTriangle::TriangleCenter(a, b, c, origin);
+      for (int i = 0; i < 3; ++i) origin[i] = (a[i] + b[i] + c[i]) / 3.0;
       _Center->SetTuple(cellId, origin);
 
       // Compute radius of bounding sphere
@@ -85,19 +93,25 @@ public:
                             vtkMath::Distance2BetweenPoints(b, origin)),
                             vtkMath::Distance2BetweenPoints(c, origin)));
       _Radius->SetTuple1(cellId, radius);
+
+      // Get axis-aligned bounding box
+      double *bounds = _Bounds + 6 * cellId;
+      for (int i = 0; i < 3; ++i) {
+        bounds[2*i  ] = min(min(a[i], b[i]), c[i]);
+        bounds[2*i+1] = max(max(a[i], b[i]), c[i]);
+      }
     }
   }
 
-  /// Compute bounding spheres of surface faces
-  static void Run(vtkPolyData *surface, vtkDataArray *center, vtkDataArray *radius)
+  /// Compute bounding spheres of surface faces with at least one moved vertex
+  static void Run(vtkPolyData *surface, const double *points, const char *moved,
+                  vtkDataArray *center, vtkDataArray *radius, double *bounds)
   {
-    center->SetNumberOfComponents(3);
-    center->SetNumberOfTuples(surface->GetNumberOfCells());
-    radius->SetNumberOfComponents(1);
-    radius->SetNumberOfTuples(surface->GetNumberOfCells());
     if (surface->GetNumberOfCells() == 0) return;
-    ComputeBoundingSpheres eval(surface, center, radius);
+    ComputeBoundingSpheres eval(surface, points, moved, center, radius, bounds);
     parallel_for(blocked_range<vtkIdType>(0, surface->GetNumberOfCells()), eval);
+    center->Modified();
+    radius->Modified();
   }
 };
 
@@ -110,7 +124,6 @@ class FindCollisions
   typedef irtkSurfaceCollisions::CollisionInfo    CollisionInfo;
 
   irtkSurfaceCollisions          *_Filter;
-  vtkAbstractPointLocator        *_Locator;
   vector<set<IntersectionInfo> > *_Intersections;
   vector<set<CollisionInfo> >    *_Collisions;
   double                          _MaxRadius;
@@ -136,6 +149,14 @@ public:
 
     const double R = _MaxRadius + 1.1 * _Filter->MinDistance();
 
+    // Triangles whose bounding boxes are further apart than this cannot
+    // intersect or be closer to each other than the minimum distance
+    const double max_gap = max(_MinDistance, TOL);
+
+    const irtkSurfaceCollisions::PointGrid &grid = _Filter->_Grid;
+    const double * const points = &_Filter->_Points[0];
+    const double * const bounds = &_Filter->_Bounds[0];
+
     double         tri1[3][3], tri2[3][3], tri1_2D[3][2], tri2_2D[3][2];
     double         n1[3], n2[3], p1[3], p2[3], r1, c1[3], v[3], search_radius, dot;
     int            tri12[3], i1, i2, shared_vertex1, shared_vertex2, coplanar, s1, s2;
@@ -144,8 +165,8 @@ public:
     CollisionInfo  collision;
     CollisionType  type;
 
-    vtkSmartPointer<vtkIdList> ptIds   = vtkSmartPointer<vtkIdList>::New();
-    vtkSmartPointer<vtkIdList> cellIds = vtkSmartPointer<vtkIdList>::New();
+    vector<vtkIdType> ptIds, cellIds;
+    vector<double>    gap;
 
     for (cellId1 = re.begin(); cellId1 != re.end(); ++cellId1) {
 
@@ -158,9 +179,9 @@ public:
       type = CollisionType::NoCollision;
 
       // Get vertices and normal of this triangle
-      surface->GetPoint(pts1[0], tri1[0]);
-      surface->GetPoint(pts1[1], tri1[1]);
-      surface->GetPoint(pts1[2], tri1[2]);
+      memcpy(tri1[0], points + 3 * pts1[0], 3 * sizeof(double));
+      memcpy(tri1[1], points + 3 * pts1[1], 3 * sizeof(double));
+      memcpy(tri1[2], points + 3 * pts1[2], 3 * sizeof(double));
       vtkTriangle::ComputeNormal(tri1[0], tri1[1], tri1[2], n1);
 
       // Get bounding sphere
@@ -169,24 +190,43 @@ public:
 
       // Find other triangles within search radius
       search_radius = min(max(_Filter->MinSearchRadius(), r1 + R), _Filter->MaxSearchRadius());
-      _Locator->FindPointsWithinRadius(search_radius, c1, ptIds);
-      cellIds->Reset();
-      for (vtkIdType i = 0; i < ptIds->GetNumberOfIds(); ++i) {
-        surface->GetPointCells(ptIds->GetId(i), ncells, cells);
+      grid.FindPointsWithinRadius(points, c1, search_radius, ptIds);
+      cellIds.clear();
+      for (size_t i = 0; i < ptIds.size(); ++i) {
+        surface->GetPointCells(ptIds[i], ncells, cells);
         for (unsigned short j = 0; j < ncells; ++j) {
-          if (cells[j] != cellId1) cellIds->InsertUniqueId(cells[j]);
+          if (cells[j] != cellId1) cellIds.push_back(cells[j]);
         }
       }
+      sort(cellIds.begin(), cellIds.end());
+      cellIds.erase(unique(cellIds.begin(), cellIds.end()), cellIds.end());
+
+      // Discard candidate triangles whose bounding box is too far away from
+      // the bounding box of this triangle (branch-free, vectorizable loop)
+      const double * const b1 = bounds + 6 * cellId1;
+      const int ncandidates = static_cast<int>(cellIds.size());
+      gap.resize(ncandidates);
+      for (int i = 0; i < ncandidates; ++i) {
+        const double * const b2 = bounds + 6 * cellIds[i];
+        gap[i] = max(max(max(b2[0] - b1[1], b1[0] - b2[1]),
+                         max(b2[2] - b1[3], b1[2] - b2[3])),
+                         max(b2[4] - b1[5], b1[4] - b2[5]));
+      }
+      int ncells2 = 0;
+      for (int i = 0; i < ncandidates; ++i) {
+        if (gap[i] <= max_gap) cellIds[ncells2++] = cellIds[i];
+      }
+      cellIds.resize(ncells2);
 
       // Check for collisions between this triangle and the found nearby triangles
-      for (vtkIdType i = 0; i < cellIds->GetNumberOfIds(); ++i) {
-        cellId2 = cellIds->GetId(i);
+      for (size_t i = 0; i < cellIds.size(); ++i) {
+        cellId2 = cellIds[i];
 
         // Get vertex positions of nearby candidate triangle
         surface->GetCellPoints(cellId2, npts, pts2);
-        surface->GetPoint(pts2[0], tri2[0]);
-        surface->GetPoint(pts2[1], tri2[1]);
-        surface->GetPoint(pts2[2], tri2[2]);
+        memcpy(tri2[0], points + 3 * pts2[0], 3 * sizeof(double));
+        memcpy(tri2[1], points + 3 * pts2[1], 3 * sizeof(double));
+        memcpy(tri2[2], points + 3 * pts2[2], 3 * sizeof(double));
 
         // Get corresponding indices of shared vertices
         for (i1 = 0; i1 < 3; ++i1) {
@@ -349,13 +389,8 @@ public:
                   vector<set<CollisionInfo   > > &collisions)
   {
     vtkDataArray *radius = filter->GetRadiusArray();
-    vtkSmartPointer<vtkAbstractPointLocator> locator;
-    locator = vtkSmartPointer<vtkOctreePointLocator>::New();
-    locator->SetDataSet(filter->Output());
-    locator->BuildLocator();
     FindCollisions body;
     body._Filter        = filter;
-    body._Locator       = locator;
     body._Intersections = &intersections;
     body._Collisions    = &collisions;
     body._MaxRadius     = radius->GetRange(0)[1];
@@ -373,6 +408,143 @@ public:
 } // namespace irtkSurfaceCollisionsUtils
 using namespace irtkSurfaceCollisionsUtils;
 
+// =============================================================================
+// Point grid
+// =============================================================================
+
+// -----------------------------------------------------------------------------
+irtkSurfaceCollisions::PointGrid::PointGrid()
+:
+  _Spacing(.0),
+  _MinSpacing(.0)
+{
+  _Origin[0] = _Origin[1] = _Origin[2] = .0;
+  _Size  [0] = _Size  [1] = _Size  [2] = 0;
+}
+
+// -----------------------------------------------------------------------------
+bool irtkSurfaceCollisions::PointGrid::Empty() const
+{
+  return _Head.empty();
+}
+
+// -----------------------------------------------------------------------------
+double irtkSurfaceCollisions::PointGrid::CellSize() const
+{
+  return _MinSpacing;
+}
+
+// -----------------------------------------------------------------------------
+bool irtkSurfaceCollisions::PointGrid::Contains(const double p[3]) const
+{
+  for (int d = 0; d < 3; ++d) {
+    const double x = (p[d] - _Origin[d]) / _Spacing;
+    if (!(x >= .0 && x < static_cast<double>(_Size[d]))) return false;
+  }
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+int irtkSurfaceCollisions::PointGrid::Bin(const double p[3]) const
+{
+  int idx[3];
+  for (int d = 0; d < 3; ++d) {
+    idx[d] = static_cast<int>(floor((p[d] - _Origin[d]) / _Spacing));
+    if      (idx[d] <  0       ) idx[d] = 0;
+    else if (idx[d] >= _Size[d]) idx[d] = _Size[d] - 1;
+  }
+  return (idx[2] * _Size[1] + idx[1]) * _Size[0] + idx[0];
+}
+
+// -----------------------------------------------------------------------------
+void irtkSurfaceCollisions::PointGrid::Build(const double *p, vtkIdType n, double spacing)
+{
+  // Bounding box of points
+  double bounds[6] = {.0, .0, .0, .0, .0, .0};
+  if (n > 0) {
+    for (int d = 0; d < 3; ++d) bounds[2*d] = bounds[2*d+1] = p[d];
+    for (vtkIdType ptId = 1; ptId < n; ++ptId) {
+      const double *x = p + 3 * ptId;
+      for (int d = 0; d < 3; ++d) {
+        if      (x[d] < bounds[2*d  ]) bounds[2*d  ] = x[d];
+        else if (x[d] > bounds[2*d+1]) bounds[2*d+1] = x[d];
+      }
+    }
+  }
+
+  // Limit total number of grid cells to a multiple of the number of points
+  double extent[3], ncells = 1.0;
+  for (int d = 0; d < 3; ++d) {
+    extent[d] = bounds[2*d+1] - bounds[2*d];
+    ncells *= extent[d] / spacing + 5.0;
+  }
+  const double max_ncells = 8.0 * static_cast<double>(n) + 64.0;
+  _MinSpacing = spacing;
+  if (ncells > max_ncells) spacing *= pow(ncells / max_ncells, 1.0 / 3.0);
+
+  // Grid with a margin of two cells such that small point displacements
+  // do not immediately require a rebuild of the grid
+  _Spacing = spacing;
+  for (int d = 0; d < 3; ++d) {
+    _Size  [d] = static_cast<int>(floor(extent[d] / _Spacing)) + 5;
+    _Origin[d] = bounds[2*d] - 2.0 * _Spacing;
+  }
+
+  // Insert points into grid cells
+  _Head.assign(static_cast<size_t>(_Size[0]) * _Size[1] * _Size[2], -1);
+  _Next.resize(n);
+  _Prev.resize(n);
+  _Bin .resize(n);
+  for (vtkIdType ptId = 0; ptId < n; ++ptId) {
+    const int bin = Bin(p + 3 * ptId);
+    _Bin [ptId] = bin;
+    _Prev[ptId] = -1;
+    _Next[ptId] = _Head[bin];
+    if (_Head[bin] != -1) _Prev[_Head[bin]] = ptId;
+    _Head[bin] = ptId;
+  }
+}
+
+// -----------------------------------------------------------------------------
+void irtkSurfaceCollisions::PointGrid::Move(vtkIdType ptId, const double p[3])
+{
+  const int bin = Bin(p);
+  if (bin == _Bin[ptId]) return;
+  // Remove point from list of previous grid cell
+  if (_Prev[ptId] != -1) _Next[_Prev[ptId]] = _Next[ptId];
+  else                   _Head[_Bin [ptId]] = _Next[ptId];
+  if (_Next[ptId] != -1) _Prev[_Next[ptId]] = _Prev[ptId];
+  // Insert point into list of new grid cell
+  _Bin [ptId] = bin;
+  _Prev[ptId] = -1;
+  _Next[ptId] = _Head[bin];
+  if (_Head[bin] != -1) _Prev[_Head[bin]] = ptId;
+  _Head[bin] = ptId;
+}
+
+// -----------------------------------------------------------------------------
+void irtkSurfaceCollisions::PointGrid
+::FindPointsWithinRadius(const double *p, const double c[3], double r,
+                         vector<vtkIdType> &ptIds) const
+{
+  ptIds.clear();
+  int i1[3], i2[3];
+  for (int d = 0; d < 3; ++d) {
+    i1[d] = static_cast<int>(max(floor((c[d] - r - _Origin[d]) / _Spacing), .0));
+    i2[d] = static_cast<int>(min(floor((c[d] + r - _Origin[d]) / _Spacing), _Size[d] - 1.0));
+  }
+  const double r2 = r * r;
+  for (int k = i1[2]; k <= i2[2]; ++k)
+  for (int j = i1[1]; j <= i2[1]; ++j)
+  for (int i = i1[0]; i <= i2[0]; ++i) {
+    vtkIdType ptId = _Head[(k * _Size[1] + j) * _Size[0] + i];
+    while (ptId != -1) {
+      if (vtkMath::Distance2BetweenPoints(p + 3 * ptId, c) <= r2) ptIds.push_back(ptId);
+      ptId = _Next[ptId];
+    }
+  }
+}
+
 // =============================================================================
 // Construction/destruction
 // =============================================================================
@@ -387,7 +559,8 @@ irtkSurfaceCollisions::irtkSurfaceCollisions()
   _AdjacentIntersectionTest(false),
   _NonAdjacentIntersectionTest(false),
   _FrontfaceCollisionTest(false),
-  _BackfaceCollisionTest(false)
+  _BackfaceCollisionTest(false),
+  _PolysMTime(0)
 {
 }
 
@@ -457,26 +630,93 @@ void irtkSurfaceCollisions::Initialize()
     _Output = Triangulate(_Input);
   }
 
-  vtkSmartPointer<vtkDataArray> center = vtkSmartPointer<vtkFloatArray>::New();
-  vtkSmartPointer<vtkDataArray> radius = vtkSmartPointer<vtkFloatArray>::New();
-  vtkSmartPointer<vtkDataArray> types  = vtkSmartPointer<vtkUnsignedCharArray>::New();
-
-  center->SetName("BoundingSphereCenter");
-  radius->SetName("BoundingSphereRadius");
-  types ->SetName("CollisionType");
+  UpdateBroadPhase();
 
-  ComputeBoundingSpheres::Run(_Output, center, radius);
+  vtkSmartPointer<vtkDataArray> types = vtkSmartPointer<vtkUnsignedCharArray>::New();
+  types->SetName("CollisionType");
   types->SetNumberOfComponents(1);
   types->SetNumberOfTuples(_Output->GetNumberOfCells());
 
-  _Output->GetCellData()->AddArray(center);
-  _Output->GetCellData()->AddArray(radius);
+  _Output->GetCellData()->AddArray(_Center);
+  _Output->GetCellData()->AddArray(_Radius);
   _Output->GetCellData()->AddArray(types);
 
   _Intersections.resize(_Output->GetNumberOfCells());
   _Collisions   .resize(_Output->GetNumberOfCells());
 }
 
+// -----------------------------------------------------------------------------
+void irtkSurfaceCollisions::UpdateBroadPhase()
+{
+  const vtkIdType npoints = _Output->GetNumberOfPoints();
+  const vtkIdType ncells  = _Output->GetNumberOfCells();
+  vtkCellArray * const polys = _Output->GetPolys();
+  vtkPoints    * const pts   = _Output->GetPoints();
+
+  // Incremental update only possible if surface topology is unchanged
+  const bool update = (_Center && _Radius &&
+                       _Polys == polys && _PolysMTime == polys->GetMTime() &&
+                       _Points.size() == static_cast<size_t>(3 * npoints) &&
+                       _Center->GetNumberOfTuples() == ncells &&
+                       !_Grid.Empty());
+
+  // Determine which points moved since the previous run
+  vector<char> moved(npoints, 1);
+  double p[3];
+  if (update) {
+    for (vtkIdType ptId = 0; ptId < npoints; ++ptId) {
+      pts->GetPoint(ptId, p);
+      double * const q = &_Points[3 * ptId];
+      moved[ptId] = (p[0] != q[0] || p[1] != q[1] || p[2] != q[2]);
+      if (moved[ptId]) q[0] = p[0], q[1] = p[1], q[2] = p[2];
+    }
+  } else {
+    _Points.resize(3 * npoints);
+    for (vtkIdType ptId = 0; ptId < npoints; ++ptId) {
+      pts->GetPoint(ptId, &_Points[3 * ptId]);
+    }
+    _Center = vtkSmartPointer<vtkFloatArray>::New();
+    _Radius = vtkSmartPointer<vtkFloatArray>::New();
+    _Center->SetName("BoundingSphereCenter");
+    _Radius->SetName("BoundingSphereRadius");
+    _Center->SetNumberOfComponents(3);
+    _Center->SetNumberOfTuples(ncells);
+    _Radius->SetNumberOfComponents(1);
+    _Radius->SetNumberOfTuples(ncells);
+    _Bounds.resize(6 * ncells);
+    _Polys      = polys;
+    _PolysMTime = polys->GetMTime();
+  }
+
+  // Update bounding volumes of triangles with moved vertices
+  ComputeBoundingSpheres::Run(_Output, (npoints > 0 ? &_Points[0] : NULL),
+                              (update ? &moved[0] : NULL),
+                              _Center, _Radius, (ncells > 0 ? &_Bounds[0] : NULL));
+
+  // Size of grid cells such that search radius spans at most three cells
+  const double max_radius = (ncells > 0 ? _Radius->GetRange(0)[1] : .0);
+  double spacing = min(max(_MinSearchRadius, 2.0 * max_radius + 1.1 * _MinDistance), _MaxSearchRadius);
+  if (!(spacing > .0) || IsInf(spacing)) spacing = (max_radius > .0 ? 2.0 * max_radius : 1.0);
+
+  // Re-bin moved points unless grid must be rebuilt
+  bool rebuild = !update || spacing < .5 * _Grid.CellSize() || spacing > 2.0 * _Grid.CellSize();
+  if (!rebuild) {
+    for (vtkIdType ptId = 0; ptId < npoints; ++ptId) {
+      if (moved[ptId] && !_Grid.Contains(&_Points[3 * ptId])) {
+        rebuild = true;
+        break;
+      }
+    }
+  }
+  if (rebuild) {
+    _Grid.Build((npoints > 0 ? &_Points[0] : NULL), npoints, spacing);
+  } else {
+    for (vtkIdType ptId = 0; ptId < npoints; ++ptId) {
+      if (moved[ptId]) _Grid.Move(ptId, &_Points[3 * ptId]);
+    }
+  }
+}
+
 // -----------------------------------------------------------------------------
 void irtkSurfaceCollisions::Finalize()
 {
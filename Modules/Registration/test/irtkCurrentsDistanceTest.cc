@@ -0,0 +1,167 @@
+/* The Image Registration Toolkit (IRTK)
+ *
+ * Copyright 2008-2015 Imperial College London
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include <gtest/gtest.h>
+
+#include <irtkCurrentsDistance.h>
+
+#include <vtkSmartPointer.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkPointData.h>
+#include <vtkDoubleArray.h>
+#include <vtkMath.h>
+
+static const int    number_of_points  = 2000;
+static const int    number_of_queries = 1000;
+static const double sigma             = 1.0;
+
+// Truncation of the exact kernel sums at 2.5 sigma limits the accuracy of
+// the grid approximation for small grid spacings
+static const double value_floor    = 0.005;
+static const double gradient_floor = 0.015;
+
+// ===========================================================================
+// Auxiliary functions
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+/// Current with points on a sphere and random signed normals
+vtkSmartPointer<vtkPolyData> RandomCurrent()
+{
+  vtkSmartPointer<vtkPoints>      points  = vtkSmartPointer<vtkPoints>::New();
+  vtkSmartPointer<vtkDoubleArray> normals = vtkSmartPointer<vtkDoubleArray>::New();
+  normals->SetName("normals");
+  normals->SetNumberOfComponents(3);
+  normals->SetNumberOfTuples(number_of_points);
+  points->SetNumberOfPoints(number_of_points);
+  for (int i = 0; i < number_of_points; ++i) {
+    const double u = 2.0 * rand() / RAND_MAX - 1.0;
+    const double t = 2.0 * M_PI * rand() / RAND_MAX;
+    const double s = sqrt(1.0 - u * u);
+    points->SetPoint(i, 3.0 * s * cos(t), 3.0 * s * sin(t), 3.0 * u);
+    for (int k = 0; k < 3; ++k) {
+      normals->SetComponent(i, k, 2.0 * rand() / RAND_MAX - 1.0);
+    }
+  }
+  vtkSmartPointer<vtkPolyData> current = vtkSmartPointer<vtkPolyData>::New();
+  current->SetPoints(points);
+  current->GetPointData()->AddArray(normals);
+  return current;
+}
+
+// ---------------------------------------------------------------------------
+/// Exact kernel weighted sum of normals and its derivatives at given point
+void ExactSum(vtkPolyData *current, const double p[3], double sum[3], double gradient[9])
+{
+  vtkDataArray *normals = current->GetPointData()->GetArray("normals");
+  double c[3], n[3], d2, w;
+  for (int k = 0; k < 3; ++k) sum[k] = .0;
+  for (int k = 0; k < 9; ++k) gradient[k] = .0;
+  for (vtkIdType i = 0; i < current->GetNumberOfPoints(); ++i) {
+    current->GetPoint(i, c);
+    d2 = vtkMath::Distance2BetweenPoints(p, c);
+    if (d2 > 6.25 * sigma * sigma) continue;
+    normals->GetTuple(i, n);
+    w = exp(- d2 / (sigma * sigma));
+    for (int k = 0; k < 3; ++k) {
+      sum[k] += w * n[k];
+      for (int d = 0; d < 3; ++d) {
+        gradient[d * 3 + k] -= 2.0 * (p[d] - c[d]) / (sigma * sigma) * w * n[k];
+      }
+    }
+  }
+}
+
+// ---------------------------------------------------------------------------
+/// Compare interpolated kernel sums with exact kernel sums
+void TestKernelGrid(double h)
+{
+  vtkSmartPointer<vtkPolyData> current = RandomCurrent();
+  irtkCurrentsDistance::KernelGrid grid;
+  ASSERT_TRUE(grid.Initialize(current, sigma, h));
+  grid.ComputeGradient();
+
+  double p[3], sum[3], gradient[9], exact_sum[3], exact_gradient[9];
+  double max_value = .0, max_value_error = .0, max_gradient = .0, max_gradient_error = .0;
+  for (int q = 0; q < number_of_queries; ++q) {
+    for (int d = 0; d < 3; ++d) p[d] = 8.0 * rand() / RAND_MAX - 4.0;
+    grid.Evaluate(p, sum, gradient);
+    ExactSum(current, p, exact_sum, exact_gradient);
+    for (int k = 0; k < 3; ++k) {
+      max_value       = max(max_value,       fabs(exact_sum[k]));
+      max_value_error = max(max_value_error, fabs(sum[k] - exact_sum[k]));
+    }
+    for (int k = 0; k < 9; ++k) {
+      max_gradient       = max(max_gradient,       fabs(exact_gradient[k]));
+      max_gradient_error = max(max_gradient_error, fabs(gradient[k] - exact_gradient[k]));
+    }
+  }
+  const double rho2 = (h / sigma) * (h / sigma);
+  EXPECT_LT(max_value_error    / max_value,    0.4 * rho2 + value_floor)    << "h/sigma=" << h / sigma;
+  EXPECT_LT(max_gradient_error / max_gradient, 0.4 * rho2 + gradient_floor) << "h/sigma=" << h / sigma;
+}
+
+// ===========================================================================
+// Tests
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+TEST(irtkCurrentsDistance, KernelGrid)
+{
+  srand(42);
+  TestKernelGrid(0.2 * sigma);
+  TestKernelGrid(0.3 * sigma);
+  TestKernelGrid(0.5 * sigma);
+}
+
+// ---------------------------------------------------------------------------
+TEST(irtkCurrentsDistance, KernelGridClear)
+{
+  srand(42);
+  vtkSmartPointer<vtkPolyData> current = RandomCurrent();
+  irtkCurrentsDistance::KernelGrid grid;
+  ASSERT_TRUE(grid.Initialize(current, sigma, 0.5 * sigma));
+  grid.ComputeGradient();
+  grid.Clear();
+  EXPECT_TRUE(grid.Empty());
+  EXPECT_EQ(0u, grid._Weights.capacity());
+  EXPECT_EQ(0u, grid._Sum    .capacity());
+  for (int d = 0; d < 3; ++d) EXPECT_EQ(0u, grid._Gradient[d].capacity());
+}
+
+// ---------------------------------------------------------------------------
+TEST(irtkCurrentsDistance, KernelGridTooLarge)
+{
+  srand(42);
+  vtkSmartPointer<vtkPolyData> current = RandomCurrent();
+  irtkCurrentsDistance::KernelGrid grid;
+  EXPECT_FALSE(grid.Initialize(current, sigma, 0.01 * sigma));
+  EXPECT_TRUE (grid._TooLarge);
+  EXPECT_TRUE (grid.Empty());
+  EXPECT_EQ(0u, grid._Weights.capacity());
+}
+
+// ===========================================================================
+// Main
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,317 @@
+/* The Image Registration Toolkit (IRTK)
+ *
+ * Copyright 2008-2015 Imperial College London
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include <gtest/gtest.h>
+
+#include <irtkSumOfSquaredIntensityDifferences.h>
+#include <irtkIntensityCrossCorrelation.h>
+#include <irtkNormalizedMutualImageInformation.h>
+
+#include "irtkTransformationTestUtils.h"
+
+static const double tol = 1e-8;
+
+// ===========================================================================
+// Auxiliary functions
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+/// Similarity measure which counts the number of incremental updates
+template <class Similarity>
+class CountingSimilarity : public Similarity
+{
+public:
+
+  int _NumberOfIncrementalUpdates;
+
+  CountingSimilarity() : _NumberOfIncrementalUpdates(0) {}
+
+protected:
+
+  virtual void ExcludeRegions(const vector<blocked_range3d<int> > &regions)
+  {
+    ++_NumberOfIncrementalUpdates;
+    Similarity::ExcludeRegions(regions);
+  }
+};
+
+// ---------------------------------------------------------------------------
+/// NMI with non-parametric gradient evaluated by the former per-voxel formula
+///
+/// Sums the 4x4 cubic B-spline Parzen window weighted log histogram values of
+/// each voxel directly instead of using the precomputed table of derivatives.
+class FormerNormalizedMutualImageInformation : public irtkNormalizedMutualImageInformation
+{
+protected:
+
+  static double ValToRange(const irtkHistogram_1D<double> &hist, double val)
+  {
+    if (version >= irtkVersion(2, 2)) {
+      if (val < hist.Min()) return .0;
+      if (val > hist.Max()) return static_cast<double>(hist.NumberOfBins() - 1);
+      return hist.ValToRange(val);
+    }
+    return val;
+  }
+
+  virtual bool NonParametricGradient(const irtkRegisteredImage *image, GradientImageType *gradient)
+  {
+    const double sign = ((version < irtkVersion(3, 1)) ? 1.0 : -1.0);
+
+    const irtkRegisteredImage *fixed = Target();
+    int tbin = Histogram()->NumberOfBinsX();
+    int sbin = Histogram()->NumberOfBinsY();
+    double tmin, smin, tmax, smax;
+    Histogram()->GetMin(&tmin, &smin);
+    Histogram()->GetMax(&tmax, &smax);
+    if (image == Target()) {
+      fixed = Source();
+      swap(tbin, sbin);
+      swap(tmin, smin);
+      swap(tmax, smax);
+    }
+
+    const double je  = _Histogram->JointEntropy();
+    const double nmi = (_Histogram->EntropyX() + _Histogram->EntropyY()) / je;
+
+    irtkHistogram_2D<double> logJointHistogram(tbin, sbin);
+    irtkHistogram_1D<double> logMarginalXHistogram(tbin);
+    irtkHistogram_1D<double> logMarginalYHistogram(sbin);
+    logJointHistogram.PutMin(tmin, smin);
+    logJointHistogram.PutMax(tmax, smax);
+    logMarginalXHistogram.PutMin(tmin);
+    logMarginalXHistogram.PutMax(tmax);
+    logMarginalYHistogram.PutMin(smin);
+    logMarginalYHistogram.PutMax(smax);
+    for (int s = 0; s < sbin; ++s)
+    for (int t = 0; t < tbin; ++t) {
+      double num = ((image == Target()) ? (*_Histogram)(s, t) : (*_Histogram)(t, s));
+      logJointHistogram.Add(t, s, num);
+      logMarginalXHistogram.Add(t, num);
+      logMarginalYHistogram.Add(s, num);
+    }
+    logJointHistogram    .Log();
+    logMarginalXHistogram.Log();
+    logMarginalYHistogram.Log();
+
+    const double denominator = sign * je * _Histogram->NumberOfSamples();
+    memset(gradient->Data(), 0, _NumberOfVoxels * sizeof(GradientType));
+    for (int idx = 0; idx < _NumberOfVoxels; ++idx) {
+      if (!IsForeground(idx)) continue;
+      const double target_value = ValToRange(logMarginalXHistogram, fixed->Data()[idx]);
+      const double source_value = ValToRange(logMarginalYHistogram, image->Data()[idx]);
+      int t1 = static_cast<int>(     target_value ) - 1;
+      int t2 = static_cast<int>(ceil(target_value)) + 1;
+      int s1 = static_cast<int>(     source_value ) - 1;
+      int s2 = static_cast<int>(ceil(source_value)) + 1;
+      if (t1 <  0   ) t1 = 0;
+      if (t2 >= tbin) t2 = tbin - 1;
+      if (s1 <  0   ) s1 = 0;
+      if (s2 >= sbin) s2 = sbin - 1;
+      double jointEntropyGrad = .0, targetEntropyGrad = .0, sourceEntropyGrad = .0, w;
+      for (int t = t1; t <= t2; ++t)
+      for (int s = s1; s <= s2; ++s) {
+        w = irtkBSpline<double>::B  (static_cast<double>(t) - target_value) *
+            irtkBSpline<double>::B_I(static_cast<double>(s) - source_value);
+        jointEntropyGrad  += w * logJointHistogram(t, s);
+        targetEntropyGrad += w * logMarginalXHistogram(t);
+        sourceEntropyGrad += w * logMarginalYHistogram(s);
+      }
+      gradient->Data()[idx] = (targetEntropyGrad + sourceEntropyGrad - nmi * jointEntropyGrad) / denominator;
+    }
+
+    MultiplyByImageGradient(image, gradient);
+    return true;
+  }
+};
+
+// ---------------------------------------------------------------------------
+/// Image domain of test images
+irtkImageAttributes Domain()
+{
+  irtkImageAttributes attr;
+  attr._x  = 48,  attr._y  = 44,  attr._z  = 40;
+  attr._dx = 1.0, attr._dy = 1.0, attr._dz = 1.0;
+  return attr;
+}
+
+// ---------------------------------------------------------------------------
+/// Smooth image made up of random Gaussian blobs
+///
+/// Intensities are rescaled to [0, 15] because the joint histogram of the
+/// probabilistic measures expects bin indices as intensities before v2.2,
+/// which is the range of the default 16 bins.
+irtkGenericImage<double> BlobImage(const irtkImageAttributes &attr, int nblobs)
+{
+  vector<double> cx(nblobs), cy(nblobs), cz(nblobs), a(nblobs);
+  for (int n = 0; n < nblobs; ++n) {
+    cx[n] = attr._x * static_cast<double>(rand()) / RAND_MAX;
+    cy[n] = attr._y * static_cast<double>(rand()) / RAND_MAX;
+    cz[n] = attr._z * static_cast<double>(rand()) / RAND_MAX;
+    a [n] = 20.0 + 80.0 * static_cast<double>(rand()) / RAND_MAX;
+  }
+  irtkGenericImage<double> image(attr);
+  for (int k = 0; k < attr._z; ++k)
+  for (int j = 0; j < attr._y; ++j)
+  for (int i = 0; i < attr._x; ++i) {
+    double v = 10.0;
+    for (int n = 0; n < nblobs; ++n) {
+      v += a[n] * exp(-(pow(i - cx[n], 2) + pow(j - cy[n], 2) + pow(k - cz[n], 2)) / 50.0);
+    }
+    image(i, j, k) = v;
+  }
+  double min, max;
+  image.GetMinMax(&min, &max);
+  double *p = image.GetPointerToVoxels();
+  for (int idx = 0; idx < image.NumberOfVoxels(); ++idx, ++p) {
+    *p = 15.0 * (*p - min) / (max - min);
+  }
+  return image;
+}
+
+// ---------------------------------------------------------------------------
+/// Initialize similarity of target and deformed source image
+void Initialize(irtkImageSimilarity &sim, irtkGenericImage<double> &target,
+                irtkGenericImage<double> &source, irtkFreeFormTransformation *ffd,
+                bool incremental)
+{
+  sim.Domain(target.Attributes());
+  sim.Transformation(ffd);
+  sim.Target()->InputImage(&target);
+  sim.Source()->InputImage(&source);
+  sim.Source()->InterpolationMode(Interpolation_Linear);
+  sim.Source()->Transformation(ffd);
+  sim.IncrementalUpdate(incremental);
+  sim.Initialize();
+  sim.Update(true);
+}
+
+// ---------------------------------------------------------------------------
+/// Evaluate gradient of similarity w.r.t. free-form deformation parameters
+vector<double> Gradient(irtkImageSimilarity &sim, const irtkFreeFormTransformation *ffd)
+{
+  vector<double> gradient(ffd->NumberOfDOFs(), .0);
+  sim.irtkEnergyTerm::Gradient(&gradient[0], 1.0);
+  return gradient;
+}
+
+// ---------------------------------------------------------------------------
+/// Compare incremental update after local change of control points with
+/// full update of a similarity measure of same type
+template <class Similarity>
+void TestIncrementalUpdate(bool with_gradient = true)
+{
+  srand(42);
+  irtkGenericImage<double> target = BlobImage(Domain(), 20);
+  irtkGenericImage<double> source = BlobImage(Domain(), 20);
+  irtkBSplineFreeFormTransformation3D ffd(target.Attributes(), 6.0, 6.0, 6.0);
+  Randomize(&ffd, 1.0);
+
+  CountingSimilarity<Similarity> sim;
+  Initialize(sim, target, source, &ffd, true);
+  sim.Value();
+
+  // Move control points with local support one at a time
+  double x, y, z;
+  const int cp[2][3] = {{ffd.X() / 2, ffd.Y() / 2, ffd.Z() / 2}, {2, 3, ffd.Z() - 3}};
+  for (int n = 0; n < 2; ++n) {
+    ffd.Get(cp[n][0], cp[n][1], cp[n][2], x, y, z);
+    ffd.Put(cp[n][0], cp[n][1], cp[n][2], x + 1.5, y - 1.0, z + .5);
+    sim.Update(false);
+    EXPECT_EQ(n + 1, sim._NumberOfIncrementalUpdates) << "incremental update not used";
+
+    Similarity ref;
+    Initialize(ref, target, source, &ffd, false);
+    const double value = ref.Value();
+    EXPECT_NEAR(value, sim.Value(), tol * max(1.0, fabs(value))) << "control point " << n;
+  }
+
+  // Gradient after full update following incremental updates
+  if (!with_gradient) return;
+  Similarity ref;
+  Initialize(ref, target, source, &ffd, false);
+  sim.Update(true);
+  vector<double> expected = Gradient(ref, &ffd);
+  vector<double> gradient = Gradient(sim, &ffd);
+  double max_gradient = .0, max_error = .0;
+  for (size_t i = 0; i < gradient.size(); ++i) {
+    max_gradient = max(max_gradient, fabs(expected[i]));
+    max_error    = max(max_error,    fabs(gradient[i] - expected[i]));
+  }
+  EXPECT_GT(max_gradient, .0);
+  EXPECT_LE(max_error, tol * max(1.0, max_gradient));
+}
+
+// ===========================================================================
+// Tests
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+TEST(irtkImageSimilarity, IncrementalUpdateSSD)
+{
+  TestIncrementalUpdate<irtkSumOfSquaredIntensityDifferences>();
+}
+
+// ---------------------------------------------------------------------------
+TEST(irtkImageSimilarity, IncrementalUpdateCC)
+{
+  // Analytic gradient of CC is not implemented
+  TestIncrementalUpdate<irtkIntensityCrossCorrelation>(false);
+}
+
+// ---------------------------------------------------------------------------
+TEST(irtkImageSimilarity, IncrementalUpdateNMI)
+{
+  TestIncrementalUpdate<irtkNormalizedMutualImageInformation>();
+}
+
+// ---------------------------------------------------------------------------
+TEST(irtkImageSimilarity, GradientNMI)
+{
+  // Compare table-based NMI gradient to former per-voxel formula
+  srand(7);
+  irtkGenericImage<double> target = BlobImage(Domain(), 20);
+  irtkGenericImage<double> source = BlobImage(Domain(), 20);
+  irtkBSplineFreeFormTransformation3D ffd(target.Attributes(), 6.0, 6.0, 6.0);
+  Randomize(&ffd, 2.0);
+
+  irtkNormalizedMutualImageInformation   sim;
+  FormerNormalizedMutualImageInformation ref;
+  Initialize(sim, target, source, &ffd, false);
+  Initialize(ref, target, source, &ffd, false);
+  EXPECT_NEAR(ref.Value(), sim.Value(), tol);
+
+  vector<double> expected = Gradient(ref, &ffd);
+  vector<double> gradient = Gradient(sim, &ffd);
+  double max_gradient = .0, max_error = .0;
+  for (size_t i = 0; i < gradient.size(); ++i) {
+    max_gradient = max(max_gradient, fabs(expected[i]));
+    max_error    = max(max_error,    fabs(gradient[i] - expected[i]));
+  }
+  EXPECT_GT(max_gradient, .0);
+  EXPECT_LE(max_error, tol * max(1.0, max_gradient));
+}
+
+// ===========================================================================
+// Main
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,120 @@
+/* The Image Registration Toolkit (IRTK)
+ *
+ * Copyright 2008-2015 Imperial College London
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include <gtest/gtest.h>
+
+#include <irtkIntensityCrossCorrelation.h>
+
+static const double tol = 1e-9;
+
+// ===========================================================================
+// Auxiliary functions
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+/// Image domain of test images
+irtkImageAttributes Domain()
+{
+  irtkImageAttributes attr;
+  attr._x  = 24,  attr._y  = 20,  attr._z  = 16;
+  attr._dx = 1.0, attr._dy = 1.0, attr._dz = 1.5;
+  return attr;
+}
+
+// ---------------------------------------------------------------------------
+/// Image with random positive intensities
+irtkGenericImage<double> RandomImage(const irtkImageAttributes &attr)
+{
+  irtkGenericImage<double> image(attr);
+  double *p = image.GetPointerToVoxels();
+  for (int idx = 0; idx < image.NumberOfVoxels(); ++idx, ++p) {
+    *p = 10.0 + 100.0 * rand() / RAND_MAX;
+  }
+  return image;
+}
+
+// ---------------------------------------------------------------------------
+/// Pearson correlation coefficient of voxel values
+double Correlation(const irtkGenericImage<double> &a, const irtkGenericImage<double> &b)
+{
+  const int n = a.NumberOfVoxels();
+  const double *p = a.GetPointerToVoxels();
+  const double *q = b.GetPointerToVoxels();
+  double ma = .0, mb = .0;
+  for (int idx = 0; idx < n; ++idx) ma += p[idx], mb += q[idx];
+  ma /= n, mb /= n;
+  double cov = .0, va = .0, vb = .0;
+  for (int idx = 0; idx < n; ++idx) {
+    cov += (p[idx] - ma) * (q[idx] - mb);
+    va  += (p[idx] - ma) * (p[idx] - ma);
+    vb  += (q[idx] - mb) * (q[idx] - mb);
+  }
+  return cov / sqrt(va * vb);
+}
+
+// ---------------------------------------------------------------------------
+/// Evaluate unweighted cross-correlation of two images
+double CrossCorrelation(irtkGenericImage<double> &target, irtkGenericImage<double> &source)
+{
+  irtkIntensityCrossCorrelation sim;
+  sim.Domain(target.Attributes());
+  sim.Target()->InputImage(&target);
+  sim.Source()->InputImage(&source);
+  sim.Initialize();
+  sim.Update(true);
+  return sim.RawValue(sim.Value());
+}
+
+// ===========================================================================
+// Tests
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+TEST(irtkIntensityCrossCorrelation, LinearIntensityRelation)
+{
+  // Source intensities have a different variance than target intensities
+  srand(42);
+  irtkGenericImage<double> target = RandomImage(Domain());
+  irtkGenericImage<double> source(target.Attributes());
+  for (int idx = 0; idx < target.NumberOfVoxels(); ++idx) {
+    source(idx) = 3.0 * target(idx) + 5.0;
+  }
+  EXPECT_NEAR(1.0, CrossCorrelation(target, source), tol);
+}
+
+// ---------------------------------------------------------------------------
+TEST(irtkIntensityCrossCorrelation, PearsonCorrelation)
+{
+  srand(42);
+  irtkGenericImage<double> target = RandomImage(Domain());
+  irtkGenericImage<double> noise  = RandomImage(Domain());
+  irtkGenericImage<double> source(target.Attributes());
+  for (int idx = 0; idx < target.NumberOfVoxels(); ++idx) {
+    source(idx) = .5 * target(idx) + 2.0 * noise(idx);
+  }
+  EXPECT_NEAR(Correlation(target, source), CrossCorrelation(target, source), tol);
+}
+
+// ===========================================================================
+// Main
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
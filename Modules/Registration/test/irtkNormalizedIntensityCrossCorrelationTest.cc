@@ -0,0 +1,236 @@
+/* The Image Registration Toolkit (IRTK)
+ *
+ * Copyright 2008-2015 Imperial College London
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include <gtest/gtest.h>
+
+#include <irtkNormalizedIntensityCrossCorrelation.h>
+
+#include "irtkTransformationTestUtils.h"
+
+// Maximum difference of separable and brute force window sums relative to the
+// maximum magnitude of each image, which depends on the registered image type
+static const double tol = (sizeof(irtkRegisteredPixel) == sizeof(float) ? 1e-4 : 1e-9);
+
+// ===========================================================================
+// Auxiliary functions
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+/// LNCC which provides access to its local dot product images and raw value
+class LNCC : public irtkNormalizedIntensityCrossCorrelation
+{
+public:
+
+  using irtkNormalizedIntensityCrossCorrelation::A;
+  using irtkNormalizedIntensityCrossCorrelation::B;
+  using irtkNormalizedIntensityCrossCorrelation::C;
+  using irtkNormalizedIntensityCrossCorrelation::S;
+  using irtkNormalizedIntensityCrossCorrelation::T;
+  using irtkNormalizedIntensityCrossCorrelation::Evaluate;
+};
+
+// ---------------------------------------------------------------------------
+/// Local dot products of box window LNCC at each voxel
+struct LocalDotProducts
+{
+  irtkGenericImage<double> A, B, C, S, T;
+  double                   Value;
+};
+
+// ---------------------------------------------------------------------------
+/// Image domain of test images
+///
+/// The extent along x is larger than one tile of the separable window sums.
+irtkImageAttributes Domain()
+{
+  irtkImageAttributes attr;
+  attr._x  = 70,  attr._y  = 22,  attr._z  = 17;
+  attr._dx = 1.0, attr._dy = 1.0, attr._dz = 1.0;
+  return attr;
+}
+
+// ---------------------------------------------------------------------------
+/// Smooth image made up of random Gaussian blobs plus noise
+irtkGenericImage<double> BlobImage(const irtkImageAttributes &attr, int nblobs)
+{
+  vector<double> cx(nblobs), cy(nblobs), cz(nblobs), a(nblobs);
+  for (int n = 0; n < nblobs; ++n) {
+    cx[n] = attr._x * static_cast<double>(rand()) / RAND_MAX;
+    cy[n] = attr._y * static_cast<double>(rand()) / RAND_MAX;
+    cz[n] = attr._z * static_cast<double>(rand()) / RAND_MAX;
+    a [n] = 20.0 + 80.0 * static_cast<double>(rand()) / RAND_MAX;
+  }
+  irtkGenericImage<double> image(attr);
+  for (int k = 0; k < attr._z; ++k)
+  for (int j = 0; j < attr._y; ++j)
+  for (int i = 0; i < attr._x; ++i) {
+    double v = 10.0 + 5.0 * static_cast<double>(rand()) / RAND_MAX;
+    for (int n = 0; n < nblobs; ++n) {
+      v += a[n] * exp(-(pow(i - cx[n], 2) + pow(j - cy[n], 2) + pow(k - cz[n], 2)) / 50.0);
+    }
+    image(i, j, k) = v;
+  }
+  return image;
+}
+
+// ---------------------------------------------------------------------------
+/// Initialize box window LNCC of target and deformed source image
+void Initialize(LNCC &sim, irtkGenericImage<double> &target,
+                irtkGenericImage<double> &source, irtkFreeFormTransformation *ffd,
+                int rx, int ry, int rz)
+{
+  sim.SetKernelToBoxWindow(rx, ry, rz, LNCC::UNITS_Voxel);
+  sim.Domain(target.Attributes());
+  sim.Transformation(ffd);
+  sim.Target()->InputImage(&target);
+  sim.Source()->InputImage(&source);
+  sim.Source()->InterpolationMode(Interpolation_Linear);
+  sim.Source()->Transformation(ffd);
+  sim.IncrementalUpdate(true);
+  sim.Initialize();
+  sim.Update(true);
+}
+
+// ---------------------------------------------------------------------------
+/// Compute local dot products by summing over the window of each voxel as
+/// done by the former implementation using neighborhood iterators
+LocalDotProducts BruteForce(const LNCC &sim)
+{
+  const irtkRegisteredImage *tgt = sim.Target();
+  const irtkRegisteredImage *src = sim.Source();
+  const irtkVector3D<int>   &r   = sim.NeighborhoodRadius();
+  const int nx = tgt->X(), ny = tgt->Y(), nz = tgt->Z();
+  irtkImageAttributes attr = tgt->Attributes();
+  attr._t = 1;
+  LocalDotProducts p;
+  p.A.Initialize(attr), p.B.Initialize(attr), p.C.Initialize(attr);
+  p.S.Initialize(attr), p.T.Initialize(attr);
+  double sum = .0;
+  int    num = 0;
+  for (int k = 0; k < nz; ++k)
+  for (int j = 0; j < ny; ++j)
+  for (int i = 0; i < nx; ++i) {
+    if (!sim.IsForeground(i, j, k)) continue;
+    int    cnt  =  0;
+    double sumt = .0, sums = .0, sumss = .0, sumts = .0, sumtt = .0;
+    for (int c = max(0, k - r._z); c <= min(nz - 1, k + r._z); ++c)
+    for (int b = max(0, j - r._y); b <= min(ny - 1, j + r._y); ++b)
+    for (int a = max(0, i - r._x); a <= min(nx - 1, i + r._x); ++a) {
+      const double t = tgt->Get(a, b, c), s = src->Get(a, b, c);
+      sumt += t, sums += s, sumtt += t * t, sumss += s * s, sumts += t * s;
+      ++cnt;
+    }
+    const double ms = sums / cnt;
+    const double mt = sumt / cnt;
+    p.A(i, j, k) = sumts - ms * sumt - mt * sums + cnt * ms * mt;
+    p.B(i, j, k) = sumss -       2.0 * ms * sums + cnt * ms * ms;
+    p.C(i, j, k) = sumtt -       2.0 * mt * sumt + cnt * mt * mt;
+    p.S(i, j, k) = src->Get(i, j, k) - ms;
+    p.T(i, j, k) = tgt->Get(i, j, k) - mt;
+    const double cc = p.A(i, j, k) * p.A(i, j, k) / (p.B(i, j, k) * p.C(i, j, k));
+    if (!IsNaN(cc) && fabs(cc) <= 1.0) sum += cc, ++num;
+  }
+  p.Value = (num > 0 ? sum / num : 1.0);
+  if (version >= irtkVersion(3, 1)) p.Value = 1.0 - p.Value;
+  return p;
+}
+
+// ---------------------------------------------------------------------------
+/// Maximum difference of images relative to maximum magnitude of expected image
+template <class TImage>
+double MaxRelativeError(const irtkGenericImage<double> &expected, const TImage *output)
+{
+  double peak = .0, error = .0;
+  for (int idx = 0; idx < expected.NumberOfVoxels(); ++idx) {
+    peak  = max(peak,  fabs(expected(idx)));
+    error = max(error, fabs(static_cast<double>(output->Get(idx)) - expected(idx)));
+  }
+  return error / peak;
+}
+
+// ---------------------------------------------------------------------------
+/// Compare local dot products and LNCC value with brute force results
+void Compare(LNCC &sim, const char *msg)
+{
+  LocalDotProducts expected = BruteForce(sim);
+  EXPECT_LT(MaxRelativeError(expected.A, sim.A()), tol) << msg << ": A";
+  EXPECT_LT(MaxRelativeError(expected.B, sim.B()), tol) << msg << ": B";
+  EXPECT_LT(MaxRelativeError(expected.C, sim.C()), tol) << msg << ": C";
+  EXPECT_LT(MaxRelativeError(expected.S, sim.S()), tol) << msg << ": S";
+  EXPECT_LT(MaxRelativeError(expected.T, sim.T()), tol) << msg << ": T";
+  EXPECT_NEAR(expected.Value, sim.Evaluate(), tol) << msg << ": LNCC";
+}
+
+// ---------------------------------------------------------------------------
+/// Compare box window LNCC after full and incremental updates with brute force
+void TestBoxWindow(int rx, int ry, int rz)
+{
+  srand(42);
+  irtkGenericImage<double> target = BlobImage(Domain(), 10);
+  irtkGenericImage<double> source = BlobImage(Domain(), 10);
+  irtkBSplineFreeFormTransformation3D ffd(target.Attributes(), 5.0, 5.0, 5.0);
+  Randomize(&ffd, 1.0);
+
+  LNCC sim;
+  Initialize(sim, target, source, &ffd, rx, ry, rz);
+  ASSERT_EQ(rx, sim.NeighborhoodRadius()._x);
+  ASSERT_EQ(ry, sim.NeighborhoodRadius()._y);
+  ASSERT_EQ(rz, sim.NeighborhoodRadius()._z);
+  Compare(sim, "full update");
+
+  // Move control points with local support one at a time
+  double x, y, z;
+  const int cp[2][3] = {{ffd.X() / 2, ffd.Y() / 2, ffd.Z() / 2}, {1, 2, ffd.Z() - 2}};
+  for (int n = 0; n < 2; ++n) {
+    ffd.Get(cp[n][0], cp[n][1], cp[n][2], x, y, z);
+    ffd.Put(cp[n][0], cp[n][1], cp[n][2], x + 1.5, y - 1.0, z + .5);
+    sim.Update(false);
+    Compare(sim, n == 0 ? "incremental update 1" : "incremental update 2");
+  }
+}
+
+// ===========================================================================
+// Tests
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+TEST(irtkNormalizedIntensityCrossCorrelation, BoxWindow)
+{
+  TestBoxWindow(2, 2, 2);
+}
+
+// ---------------------------------------------------------------------------
+TEST(irtkNormalizedIntensityCrossCorrelation, AnisotropicBoxWindow)
+{
+  TestBoxWindow(4, 1, 3);
+}
+
+// ---------------------------------------------------------------------------
+TEST(irtkNormalizedIntensityCrossCorrelation, BoxWindowWithoutExtentInZ)
+{
+  TestBoxWindow(3, 3, 0);
+}
+
+// ===========================================================================
+// Main
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
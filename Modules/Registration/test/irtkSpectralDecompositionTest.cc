@@ -0,0 +1,118 @@
+/* The Image Registration Toolkit (IRTK)
+ *
+ * Copyright 2008-2015 Imperial College London
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include <gtest/gtest.h>
+
+#include <irtkSpectralDecomposition.h>
+using namespace irtkSpectralDecomposition;
+
+static const int    number_of_problems = 300;
+static const int    max_size           = 6;
+static const double tol                = 1e-9;
+
+// ===========================================================================
+// Auxiliary functions
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+/// Minimum cost of assigning rows r, r+1, ... to unused columns
+double BruteForceAssignment(const irtkMatrix &cost, int r, vector<bool> &used)
+{
+  const double inf = numeric_limits<double>::infinity();
+  if (r == cost.Rows()) return .0;
+  double min_cost = inf;
+  for (int c = 0; c < cost.Cols(); ++c) {
+    if (used[c]) continue;
+    used[c] = true;
+    min_cost = min(min_cost, cost(r, c) + BruteForceAssignment(cost, r + 1, used));
+    used[c] = false;
+  }
+  return min_cost;
+}
+
+// ---------------------------------------------------------------------------
+/// Minimum cost of complete assignment of the rows (or columns if there are
+/// fewer columns than rows) found by enumerating all possible assignments
+double BruteForceAssignment(const irtkMatrix &cost)
+{
+  if (cost.Rows() > cost.Cols()) {
+    irtkMatrix cost_t(cost);
+    cost_t.Transpose();
+    return BruteForceAssignment(cost_t);
+  }
+  vector<bool> used(cost.Cols(), false);
+  return BruteForceAssignment(cost, 0, used);
+}
+
+// ---------------------------------------------------------------------------
+/// Check that assignment is one-to-one and return its total cost
+double AssignmentCost(const irtkMatrix &cost, const vector<int> &match)
+{
+  double sum = .0;
+  int    num = 0;
+  vector<bool> used(cost.Cols(), false);
+  EXPECT_EQ(cost.Rows(), static_cast<int>(match.size()));
+  for (size_t r = 0; r < match.size(); ++r) {
+    if (match[r] == -1) continue;
+    EXPECT_FALSE(used[match[r]]) << "column " << match[r] << " assigned twice";
+    used[match[r]] = true;
+    sum += cost(r, match[r]);
+    ++num;
+  }
+  EXPECT_EQ(min(cost.Rows(), cost.Cols()), num) << "incomplete assignment";
+  return sum;
+}
+
+// ---------------------------------------------------------------------------
+/// Generate random cost matrix with integral and thus often tied costs
+irtkMatrix RandomCostMatrix(int m, int n)
+{
+  irtkMatrix cost(m, n);
+  for (int r = 0; r < m; ++r)
+  for (int c = 0; c < n; ++c) {
+    cost(r, c) = static_cast<double>(rand() % 10);
+  }
+  return cost;
+}
+
+// ===========================================================================
+// Tests
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+TEST(irtkSpectralDecomposition, DenseWeightedMatching)
+{
+  srand(42);
+  for (int i = 0; i < number_of_problems; ++i) {
+    const int  m = 1 + rand() % max_size;
+    const int  n = 1 + rand() % max_size;
+    irtkMatrix  cost  = RandomCostMatrix(m, n);
+    vector<int> match = WeightedMatching(cost);
+    EXPECT_NEAR(BruteForceAssignment(cost), AssignmentCost(cost, match), tol)
+        << "problem " << i << " of size " << m << " x " << n;
+  }
+}
+
+// ===========================================================================
+// Main
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,188 @@
+/* The Image Registration Toolkit (IRTK)
+ *
+ * Copyright 2008-2015 Imperial College London
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include <gtest/gtest.h>
+
+#include <irtkSurfaceCollisions.h>
+
+#include <vtkSmartPointer.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSphereSource.h>
+
+static const int number_of_steps = 6;
+
+// ===========================================================================
+// Auxiliary functions
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+/// Triangulated unit sphere
+///
+/// The cell links required by irtkSurfaceCollisions are built as done for
+/// the surface of a deformable model. Shallow copies share these links and
+/// deep copies rebuild them.
+vtkSmartPointer<vtkPolyData> Sphere()
+{
+  vtkSmartPointer<vtkSphereSource> source = vtkSmartPointer<vtkSphereSource>::New();
+  source->SetRadius(1.0);
+  source->SetThetaResolution(48);
+  source->SetPhiResolution(48);
+  source->Update();
+  vtkSmartPointer<vtkPolyData> sphere = vtkSmartPointer<vtkPolyData>::New();
+  sphere->DeepCopy(source->GetOutput());
+  sphere->BuildLinks();
+  return sphere;
+}
+
+// ---------------------------------------------------------------------------
+/// Copy of surface with randomly displaced points in the upper cap
+///
+/// The cells are shared with the input surface such that the topology is
+/// unchanged, as is the case between iterations of a deformable surface model.
+/// The noise amplitude is in the order of the edge length such that triangles
+/// intersect and come close to each other. A large amplitude moves points
+/// beyond the margin of the point grid, which requires a rebuild.
+vtkSmartPointer<vtkPolyData> Displace(vtkPolyData *surface, double z, double amplitude)
+{
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  points->DeepCopy(surface->GetPoints());
+  double p[3];
+  for (vtkIdType ptId = 0; ptId < points->GetNumberOfPoints(); ++ptId) {
+    points->GetPoint(ptId, p);
+    if (p[2] < z) continue;
+    for (int d = 0; d < 3; ++d) {
+      p[d] += amplitude * (2.0 * rand() / RAND_MAX - 1.0);
+    }
+    points->SetPoint(ptId, p);
+  }
+  vtkSmartPointer<vtkPolyData> output = vtkSmartPointer<vtkPolyData>::New();
+  output->ShallowCopy(surface);
+  output->SetPoints(points);
+  return output;
+}
+
+// ---------------------------------------------------------------------------
+/// Set collision filter parameters
+void Configure(irtkSurfaceCollisions &filter, double min_distance)
+{
+  filter.AdjacentIntersectionTest(true);
+  filter.NonAdjacentIntersectionTest(true);
+  filter.FrontfaceCollisionTest(min_distance > .0);
+  filter.BackfaceCollisionTest(min_distance > .0);
+  filter.MinDistance(min_distance);
+  filter.MaxAngle(45.0);
+}
+
+// ---------------------------------------------------------------------------
+/// Compare results of incrementally updated filter with those of new filter
+void ExpectEqualCollisions(const irtkSurfaceCollisions &a, const irtkSurfaceCollisions &b)
+{
+  EXPECT_EQ(a.NumberOfIntersections(), b.NumberOfIntersections());
+  EXPECT_EQ(a.NumberOfCollisions(),    b.NumberOfCollisions());
+  EXPECT_TRUE(a.IntersectionCells() == b.IntersectionCells());
+  EXPECT_TRUE(a.CollisionCells()    == b.CollisionCells());
+
+  const int ncells = static_cast<int>(a.Output()->GetNumberOfCells());
+  ASSERT_EQ(ncells, static_cast<int>(b.Output()->GetNumberOfCells()));
+  for (int cellId = 0; cellId < ncells; ++cellId) {
+    typedef irtkSurfaceCollisions::IntersectionInfo IntersectionInfo;
+    typedef irtkSurfaceCollisions::CollisionInfo    CollisionInfo;
+    const set<IntersectionInfo> &ia = a.Intersections(cellId);
+    const set<IntersectionInfo> &ib = b.Intersections(cellId);
+    ASSERT_EQ(ia.size(), ib.size()) << "cell " << cellId;
+    set<IntersectionInfo>::const_iterator i = ia.begin(), j = ib.begin();
+    for (; i != ia.end(); ++i, ++j) {
+      EXPECT_EQ(i->_CellId,   j->_CellId)   << "cell " << cellId;
+      EXPECT_EQ(i->_Adjacent, j->_Adjacent) << "cell " << cellId;
+    }
+    const set<CollisionInfo> &ca = a.Collisions(cellId);
+    const set<CollisionInfo> &cb = b.Collisions(cellId);
+    ASSERT_EQ(ca.size(), cb.size()) << "cell " << cellId;
+    set<CollisionInfo>::const_iterator k = ca.begin(), l = cb.begin();
+    for (; k != ca.end(); ++k, ++l) {
+      EXPECT_EQ    (k->_CellId,   l->_CellId) << "cell " << cellId;
+      EXPECT_EQ    (k->_Type,     l->_Type)   << "cell " << cellId;
+      EXPECT_DOUBLE_EQ(k->_Distance, l->_Distance) << "cell " << cellId;
+    }
+  }
+  for (int cellId = 0; cellId < ncells; ++cellId) {
+    EXPECT_EQ(a.GetCollisionTypeArray()->GetComponent(cellId, 0),
+              b.GetCollisionTypeArray()->GetComponent(cellId, 0)) << "cell " << cellId;
+  }
+}
+
+// ---------------------------------------------------------------------------
+/// Run filter on sequence of deformed surfaces and compare each result
+/// with the one obtained from scratch by a new filter instance
+void TestIncrementalUpdate(double min_distance)
+{
+  srand(42);
+  vtkSmartPointer<vtkPolyData> sphere = Sphere();
+
+  irtkSurfaceCollisions incremental;
+  Configure(incremental, min_distance);
+
+  int total = 0;
+  for (int step = 0; step < number_of_steps; ++step) {
+    // Every third step moves points far enough to require a new grid
+    const double amplitude = (step % 3 == 2 ? .5 : .04);
+    vtkSmartPointer<vtkPolyData> surface = Displace(sphere, .5, amplitude);
+
+    incremental.Input(surface);
+    incremental.Run();
+
+    vtkSmartPointer<vtkPolyData> copy = vtkSmartPointer<vtkPolyData>::New();
+    copy->DeepCopy(surface);
+    irtkSurfaceCollisions scratch;
+    Configure(scratch, min_distance);
+    scratch.Input(copy);
+    scratch.Run();
+
+    SCOPED_TRACE(::testing::Message() << "step " << step);
+    ExpectEqualCollisions(incremental, scratch);
+    total += scratch.NumberOfIntersections() + scratch.NumberOfCollisions();
+  }
+  // Otherwise the comparison above would be trivially satisfied
+  EXPECT_GT(total, 0);
+}
+
+// ===========================================================================
+// Tests
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+TEST(irtkSurfaceCollisions, IncrementalIntersectionsEqualFromScratch)
+{
+  TestIncrementalUpdate(.0);
+}
+
+// ---------------------------------------------------------------------------
+TEST(irtkSurfaceCollisions, IncrementalCollisionsEqualFromScratch)
+{
+  TestIncrementalUpdate(.02);
+}
+
+// ===========================================================================
+// Main
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -195,6 +195,7 @@ public:
   // ---------------------------------------------------------------------------
   // Derivatives
   using irtkTransformation::JacobianDOFs;
+  using irtkSimilarityTransformation::DeriveJacobianWrtDOF;
 
   /// Calculates the Jacobian of the transformation w.r.t the parameters
   virtual void JacobianDOFs(double [3], int, double, double, double, double = 0, double = -1) const;
@@ -176,6 +176,12 @@ public:
   /// Calculates the Jacobian of the FFD at a point in lattice coordinates
   void EvaluateJacobian(irtkMatrix &, double, double, double) const;
 
+  /// Calculates the Jacobian of the FFD at a point in lattice coordinates
+  void EvaluateJacobian(irtkMatrix3x3 &, double, double) const;
+
+  /// Calculates the Jacobian of the FFD at a point in lattice coordinates
+  void EvaluateJacobian(irtkMatrix3x3 &, double, double, double) const;
+
   /// Calculates the Jacobian of the FFD at a point in lattice coordinates
   /// and converts the resulting Jacobian to derivatives w.r.t world coordinates
   void EvaluateJacobianWorld(irtkMatrix &, double, double) const;
@@ -184,6 +190,14 @@ public:
   /// and converts the resulting Jacobian to derivatives w.r.t world coordinates
   void EvaluateJacobianWorld(irtkMatrix &, double, double, double) const;
 
+  /// Calculates the Jacobian of the FFD at a point in lattice coordinates
+  /// and converts the resulting Jacobian to derivatives w.r.t world coordinates
+  void EvaluateJacobianWorld(irtkMatrix3x3 &, double, double) const;
+
+  /// Calculates the Jacobian of the FFD at a point in lattice coordinates
+  /// and converts the resulting Jacobian to derivatives w.r.t world coordinates
+  void EvaluateJacobianWorld(irtkMatrix3x3 &, double, double, double) const;
+
   /// Calculates the Jacobian of the FFD at a point in lattice coordinates
   /// w.r.t the control point with lattice coordinates (i, j)
   void EvaluateJacobianDOFs(double [3], int, int, double, double) const;
@@ -236,6 +250,12 @@ public:
   /// Transforms a single point using the local transformation component only
   virtual void LocalTransform(double &, double &, double &, double = 0, double = -1) const;
 
+  /// Transforms a batch of points in the calling thread
+  ///
+  /// The world to lattice mapping and the evaluation of the B-spline function
+  /// are inlined into a single loop over the points of the batch.
+  virtual void TransformBatch(int, double *, double *, double *, double = 0, double = -1) const;
+
   /// Whether this transformation implements a more efficient update of a given
   /// displacement field given the desired change of a transformation parameter
   virtual bool CanModifyDisplacement(int = -1) const;
@@ -259,13 +279,20 @@ public:
   using irtkFreeFormTransformation3D::LocalJacobian;
   using irtkFreeFormTransformation3D::LocalHessian;
   using irtkFreeFormTransformation3D::JacobianDOFs;
+  using irtkFreeFormTransformation3D::DeriveJacobianWrtDOF;
 
   /// Calculates the Jacobian of the transformation w.r.t either control point displacements or velocities
   virtual void FFDJacobianWorld(irtkMatrix &, double, double, double, double = 0, double = -1) const;
 
+  /// Calculates the Jacobian of the transformation w.r.t either control point displacements or velocities
+  virtual void FFDJacobianWorld(irtkMatrix3x3 &, double, double, double, double = 0, double = -1) const;
+
   /// Calculates the Jacobian of the local transformation w.r.t world coordinates
   virtual void LocalJacobian(irtkMatrix &, double, double, double, double = 0, double = -1) const;
 
+  /// Calculates the Jacobian of the local transformation w.r.t world coordinates
+  virtual void LocalJacobian(irtkMatrix3x3 &, double, double, double, double = 0, double = -1) const;
+
   /// Calculates the Hessian for each component of the local transformation w.r.t world coordinates
   virtual void LocalHessian(irtkMatrix [3], double, double, double, double = 0, double = -1) const;
 
@@ -275,12 +302,21 @@ public:
   /// Calculates the Jacobian of the local transformation
   virtual void JacobianDetDerivative(irtkMatrix *, int, int, int) const;
 
+  /// Calculates the Jacobian of the local transformation
+  virtual void JacobianDetDerivative(irtkMatrix3x3 *, int, int, int) const;
+
   /// Calculates the derivative of the Jacobian of the transformation (w.r.t. world coordinates) w.r.t. a transformation parameter
   virtual void DeriveJacobianWrtDOF(irtkMatrix &, int, double, double, double, double = 0, double = -1) const;
 
   // ---------------------------------------------------------------------------
   // Properties
 
+  /// Whether the parameters are the coefficients of the displacement field
+  virtual bool IsDisplacementParameterized() const;
+
+  /// Whether Subdivide refines the lattice without changing the displacements
+  virtual bool CanSubdivide() const;
+
   /// Size of support region of the used kernel
   virtual int KernelSize() const;
 
@@ -411,6 +447,26 @@ inline void irtkBSplineFreeFormTransformation3D
   JacobianToWorld(jac);
 }
 
+// -----------------------------------------------------------------------------
+inline void irtkBSplineFreeFormTransformation3D
+::EvaluateJacobianWorld(irtkMatrix3x3 &jac, double x, double y) const
+{
+  // Compute 1st order derivatives
+  EvaluateJacobian(jac, x, y);
+  // Convert derivatives to world coordinates
+  JacobianToWorld(jac);
+}
+
+// -----------------------------------------------------------------------------
+inline void irtkBSplineFreeFormTransformation3D
+::EvaluateJacobianWorld(irtkMatrix3x3 &jac, double x, double y, double z) const
+{
+  // Compute 1st order derivatives
+  EvaluateJacobian(jac, x, y, z);
+  // Convert derivatives to world coordinates
+  JacobianToWorld(jac);
+}
+
 // -----------------------------------------------------------------------------
 inline void irtkBSplineFreeFormTransformation3D
 ::EvaluateJacobianDOFs(double jac[3], int i, int j, double x, double y) const
@@ -488,6 +544,36 @@ inline void irtkBSplineFreeFormTransformation3D
   x += dx, y += dy, z += dz;
 }
 
+// -----------------------------------------------------------------------------
+inline void irtkBSplineFreeFormTransformation3D
+::TransformBatch(int no, double *x, double *y, double *z, double, double) const
+{
+  const irtkMatrix &w2l = _CPImage.GetWorldToImageMatrix();
+  const double a00 = w2l(0, 0), a01 = w2l(0, 1), a02 = w2l(0, 2), a03 = w2l(0, 3);
+  const double a10 = w2l(1, 0), a11 = w2l(1, 1), a12 = w2l(1, 2), a13 = w2l(1, 3);
+  const double a20 = w2l(2, 0), a21 = w2l(2, 1), a22 = w2l(2, 2), a23 = w2l(2, 3);
+
+  double u, v, w;
+  Vector d;
+
+  if (_z == 1) {
+    for (int i = 0; i < no; ++i) {
+      u = a00 * x[i] + a01 * y[i] + a02 * z[i] + a03;
+      v = a10 * x[i] + a11 * y[i] + a12 * z[i] + a13;
+      d = _FFD2D(u, v);
+      x[i] += d._x, y[i] += d._y, z[i] += d._z;
+    }
+  } else {
+    for (int i = 0; i < no; ++i) {
+      u = a00 * x[i] + a01 * y[i] + a02 * z[i] + a03;
+      v = a10 * x[i] + a11 * y[i] + a12 * z[i] + a13;
+      w = a20 * x[i] + a21 * y[i] + a22 * z[i] + a23;
+      d = _FFD(u, v, w);
+      x[i] += d._x, y[i] += d._y, z[i] += d._z;
+    }
+  }
+}
+
 // =============================================================================
 // Derivatives
 // =============================================================================
@@ -506,12 +592,32 @@ inline void irtkBSplineFreeFormTransformation3D::FFDJacobianWorld(irtkMatrix &ja
   jac(2, 2) += 1.0;
 }
 
+// -----------------------------------------------------------------------------
+inline void irtkBSplineFreeFormTransformation3D::FFDJacobianWorld(irtkMatrix3x3 &jac, double x, double y, double z, double, double) const
+{
+  // Convert to lattice coordinates
+  this->WorldToLattice(x, y, z);
+  // Compute 1st order derivatives
+  if (_z == 1) EvaluateJacobianWorld(jac, x, y);
+  else         EvaluateJacobianWorld(jac, x, y, z);
+  // Add derivatives of "x" term in T(x) = x + FFD(x)
+  jac(0, 0) += 1.0;
+  jac(1, 1) += 1.0;
+  jac(2, 2) += 1.0;
+}
+
 // -----------------------------------------------------------------------------
 inline void irtkBSplineFreeFormTransformation3D::LocalJacobian(irtkMatrix &jac, double x, double y, double z, double t, double t0) const
 {
   irtkBSplineFreeFormTransformation3D::FFDJacobianWorld(jac, x, y, z, t, t0);
 }
 
+// -----------------------------------------------------------------------------
+inline void irtkBSplineFreeFormTransformation3D::LocalJacobian(irtkMatrix3x3 &jac, double x, double y, double z, double t, double t0) const
+{
+  irtkBSplineFreeFormTransformation3D::FFDJacobianWorld(jac, x, y, z, t, t0);
+}
+
 // -----------------------------------------------------------------------------
 inline void irtkBSplineFreeFormTransformation3D::LocalHessian(irtkMatrix hessian[3], double x, double y, double z, double, double) const
 {
@@ -157,6 +157,10 @@ public:
   /// Evaluates the FFD at a point in lattice coordinates inside the FFD domain
   void EvaluateInside(double &, double &, double &, double) const;
 
+  /// Evaluates the FFD at a batch of points in lattice coordinates which all
+  /// share the same temporal lattice coordinate (e.g., a Runge-Kutta stage)
+  void EvaluateBatch(int, double *, double *, double *, double) const;
+
   /// Calculates the spatial Jacobian of the FFD at a point in lattice coordinates
   void EvaluateJacobian(irtkMatrix &, int, int, int, int) const;
 
@@ -206,6 +210,13 @@ public:
   /// Transforms a single point using the local transformation component only
   virtual void LocalTransform(double &, double &, double &, double, double = -1) const;
 
+  /// Transforms a batch of points in the calling thread
+  ///
+  /// The world to lattice mapping and the evaluation of the B-spline function
+  /// are inlined into a single loop over the points of the batch. The time
+  /// is mapped to the lattice only once for all points.
+  virtual void TransformBatch(int, double *, double *, double *, double = 0, double = -1) const;
+
   // ---------------------------------------------------------------------------
   // Derivatives
 
@@ -239,6 +250,9 @@ public:
   // Properties
   using irtkFreeFormTransformation4D::BendingEnergy;
 
+  /// Whether the parameters are the coefficients of the displacement field
+  virtual bool IsDisplacementParameterized() const;
+
   /// Size of support region of the used kernel
   virtual int KernelSize() const;
 
@@ -397,6 +411,29 @@ inline void irtkBSplineFreeFormTransformation4D
   x += dx, y += dy, z += dz;
 }
 
+// -----------------------------------------------------------------------------
+inline void irtkBSplineFreeFormTransformation4D
+::TransformBatch(int no, double *x, double *y, double *z, double t, double) const
+{
+  const irtkMatrix &w2l = _CPImage.GetWorldToImageMatrix();
+  const double a00 = w2l(0, 0), a01 = w2l(0, 1), a02 = w2l(0, 2), a03 = w2l(0, 3);
+  const double a10 = w2l(1, 0), a11 = w2l(1, 1), a12 = w2l(1, 2), a13 = w2l(1, 3);
+  const double a20 = w2l(2, 0), a21 = w2l(2, 1), a22 = w2l(2, 2), a23 = w2l(2, 3);
+
+  t = this->TimeToLattice(t);
+
+  double u, v, w;
+  Vector d;
+
+  for (int i = 0; i < no; ++i) {
+    u = a00 * x[i] + a01 * y[i] + a02 * z[i] + a03;
+    v = a10 * x[i] + a11 * y[i] + a12 * z[i] + a13;
+    w = a20 * x[i] + a21 * y[i] + a22 * z[i] + a23;
+    d = _FFD(u, v, w, t);
+    x[i] += d._x, y[i] += d._y, z[i] += d._z;
+  }
+}
+
 // =============================================================================
 // Derivatives
 // =============================================================================
@@ -22,6 +22,10 @@
 
 #include <irtkEnums.h> // FFDIntegrationMethods
 
+#include <atomic>
+
+template <class TReal> class irtkScalingAndSquaring;
+
 
 /**
  * Free-form transformation parameterized by a stationary velocity field.
@@ -82,6 +86,13 @@ class irtkBSplineFreeFormTransformationSV : public irtkBSplineFreeFormTransforma
   mutable irtkGenericImage<double> *_JacobianDOFs;
   mutable double                    _JacobianDOFsIntervalLength;
 
+  /// Scaling and squaring filter whose workspace is reused by consecutive
+  /// exponentiations of the velocity field in double precision
+  mutable irtkScalingAndSquaring<double> *_ScalingAndSquaring;
+
+  /// Whether the shared scaling and squaring filter is in use
+  mutable std::atomic<bool> _ScalingAndSquaringInUse;
+
   // ---------------------------------------------------------------------------
   // Construction/Destruction
 
@@ -209,6 +220,9 @@ public:
   /// Evaluates the FFD at a point in lattice coordinates
   void Evaluate(double &, double &, double &, double) const;
 
+  /// Evaluates the FFD at a batch of points in lattice coordinates
+  void EvaluateBatch(int, double *, double *, double *, double) const;
+
   /// Calculates the Jacobian of the FFD at a point in lattice coordinates
   /// and converts the resulting Jacobian to derivatives w.r.t world coordinates
   void EvaluateJacobianWorld(irtkMatrix &, double, double, double, double) const;
@@ -262,6 +276,11 @@ public:
   /// \param[in] T Upper integration limit, i.e., length of time interval.
   void IntegrateVelocities(double &, double &, double &, double T = 1.0) const;
 
+  /// Transforms a batch of points using a Runge-Kutta integration
+  ///
+  /// \param[in] T Upper integration limit, i.e., length of time interval.
+  void IntegrateVelocities(int, double *, double *, double *, double T = 1.0) const;
+
   /// Compute displacement field using the scaling and squaring (SS) method
   ///
   /// \attention If an input/output displacement field is provided, the resulting
@@ -311,9 +330,18 @@ public:
   /// for the scaling and squaring method.
   virtual bool RequiresCachingOfDisplacements() const;
 
+  /// Whether the parameters are the coefficients of the displacement field
+  virtual bool IsDisplacementParameterized() const;
+
+  /// Whether Subdivide refines the lattice without changing the displacements
+  virtual bool CanSubdivide() const;
+
   /// Transforms a single point using the local transformation component only
   virtual void LocalTransform(double &, double &, double &, double = 0, double = -1) const;
 
+  /// Transforms a batch of points in the calling thread
+  virtual void TransformBatch(int, double *, double *, double *, double = 0, double = -1) const;
+
   /// Transforms a single point using the inverse of the local transformation only
   virtual bool LocalInverse(double &, double &, double &, double = 0, double = -1) const;
 
@@ -370,6 +398,9 @@ public:
   /// Calculates the Jacobian of the local transformation w.r.t world coordinates
   virtual void LocalJacobian(irtkMatrix &, double, double, double, double = 0, double = -1) const;
 
+  /// Calculates the Jacobian of the local transformation w.r.t world coordinates
+  virtual void LocalJacobian(irtkMatrix3x3 &, double, double, double, double = 0, double = -1) const;
+
   /// Calculates the Hessian for each component of the local transformation w.r.t world coordinates
   virtual void LocalHessian(irtkMatrix [3], double, double, double, double = 0, double = -1) const;
 
@@ -688,6 +719,15 @@ inline void irtkBSplineFreeFormTransformationSV::Evaluate(double &x, double &y,
   irtkBSplineFreeFormTransformation3D::Evaluate(x, y, z);
 }
 
+// -----------------------------------------------------------------------------
+inline void irtkBSplineFreeFormTransformationSV
+::EvaluateBatch(int no, double *x, double *y, double *z, double) const
+{
+  for (int n = 0; n < no; ++n) {
+    irtkBSplineFreeFormTransformation3D::Evaluate(x[n], y[n], z[n]);
+  }
+}
+
 // -----------------------------------------------------------------------------
 inline void irtkBSplineFreeFormTransformationSV::EvaluateJacobianWorld(irtkMatrix &jac, double x, double y, double z, double) const
 {
@@ -713,6 +753,18 @@ inline bool irtkBSplineFreeFormTransformationSV::RequiresCachingOfDisplacements(
   return (_IntegrationMethod == FFDIM_SS || _IntegrationMethod == FFDIM_FastSS);
 }
 
+// -----------------------------------------------------------------------------
+inline bool irtkBSplineFreeFormTransformationSV::IsDisplacementParameterized() const
+{
+  return false;
+}
+
+// -----------------------------------------------------------------------------
+inline bool irtkBSplineFreeFormTransformationSV::CanSubdivide() const
+{
+  return false;
+}
+
 // -----------------------------------------------------------------------------
 inline double irtkBSplineFreeFormTransformationSV::UpperIntegrationLimit(double t, double t0) const
 {
@@ -145,6 +145,12 @@ public:
   // ---------------------------------------------------------------------------
   // Properties
 
+  /// Whether the parameters are the coefficients of the displacement field
+  virtual bool IsDisplacementParameterized() const;
+
+  /// Whether Subdivide refines the lattice without changing the displacements
+  virtual bool CanSubdivide() const;
+
   /// Calculates the gradient of the bending energy w.r.t the transformation parameters
   virtual void BendingEnergyGradient(double *, double = 1, bool = false, bool = true) const;
 
@@ -214,4 +220,20 @@ inline void irtkBSplineFreeFormTransformationStatistical::Add(const DOFValue *dx
   this->UpdateCPs();
 }
 
+// =============================================================================
+// Properties
+// =============================================================================
+
+// -----------------------------------------------------------------------------
+inline bool irtkBSplineFreeFormTransformationStatistical::IsDisplacementParameterized() const
+{
+  return false;
+}
+
+// -----------------------------------------------------------------------------
+inline bool irtkBSplineFreeFormTransformationStatistical::CanSubdivide() const
+{
+  return false;
+}
+
 #endif
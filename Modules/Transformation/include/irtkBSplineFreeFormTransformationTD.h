@@ -129,6 +129,13 @@ public:
   /// Transforms a single point
   virtual void LocalTransform(double &, double &, double &, double, double) const;
 
+  /// Transforms a batch of points in the calling thread
+  ///
+  /// The points are integrated in blocks which share the same time steps,
+  /// where the step size of the adaptive integration methods is chosen
+  /// such that the local error of each point of a block is within tolerance.
+  virtual void TransformBatch(int, double *, double *, double *, double = 0, double = -1) const;
+
   /// Transforms a single point using the inverse transformation
   virtual bool LocalInverse(double &, double &, double &, double, double) const;
 
@@ -152,6 +159,7 @@ public:
 
   // ---------------------------------------------------------------------------
   // Derivatives
+  using irtkBSplineFreeFormTransformation4D::LocalJacobian;
   using irtkBSplineFreeFormTransformation4D::JacobianDOFs;
   using irtkBSplineFreeFormTransformation4D::ParametricGradient;
 
@@ -198,6 +206,12 @@ public:
   virtual void ParametricGradient(const irtkPointSet &, const irtkVector3D<double> *,
                                   double *, double = 0, double = -1, double = 1) const;
 
+  // ---------------------------------------------------------------------------
+  // Properties
+
+  /// Whether the parameters are the coefficients of the displacement field
+  virtual bool IsDisplacementParameterized() const;
+
   // ---------------------------------------------------------------------------
   // I/O
 
@@ -311,5 +325,15 @@ void irtkBSplineFreeFormTransformationTD
 }
 */
 
+// =============================================================================
+// Properties
+// =============================================================================
+
+// -----------------------------------------------------------------------------
+inline bool irtkBSplineFreeFormTransformationTD::IsDisplacementParameterized() const
+{
+  return false;
+}
+
 
 #endif
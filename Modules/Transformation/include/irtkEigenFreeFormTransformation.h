@@ -103,6 +103,15 @@ public:
   /// Gets an element by allocating array and performing overloaded call
   int *GetElement(int) const;
 
+  // ---------------------------------------------------------------------------
+  // Properties
+
+  /// Whether the parameters are the coefficients of the displacement field
+  virtual bool IsDisplacementParameterized() const;
+
+  /// Whether Subdivide refines the lattice without changing the displacements
+  virtual bool CanSubdivide() const;
+
   // ---------------------------------------------------------------------------
   // I/O
 
@@ -220,5 +229,21 @@ inline int *irtkEigenFreeFormTransformation::GetElement(int index) const
   return element;
 }
 
+// =============================================================================
+// Properties
+// =============================================================================
+
+// -----------------------------------------------------------------------------
+inline bool irtkEigenFreeFormTransformation::IsDisplacementParameterized() const
+{
+  return false;
+}
+
+// -----------------------------------------------------------------------------
+inline bool irtkEigenFreeFormTransformation::CanSubdivide() const
+{
+  return false;
+}
+
 
 #endif
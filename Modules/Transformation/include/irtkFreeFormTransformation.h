@@ -587,8 +587,10 @@ public:
 
   // ---------------------------------------------------------------------------
   // Derivatives
+  using irtkTransformation::LocalJacobian;
   using irtkTransformation::Jacobian;
   using irtkTransformation::GlobalJacobian;
+  using irtkTransformation::DeriveJacobianWrtDOF;
   using irtkTransformation::JacobianDOFs;
   using irtkTransformation::ParametricGradient;
 
@@ -604,6 +606,10 @@ public:
   /// derivatives w.r.t world coordinates
   void JacobianToWorld(irtkMatrix &) const;
 
+  /// Convert 1st order derivatives computed w.r.t 3D lattice coordinates to
+  /// derivatives w.r.t world coordinates
+  void JacobianToWorld(irtkMatrix3x3 &) const;
+
   /// Convert 2nd order derivatives computed w.r.t 2D lattice coordinates to
   /// derivatives w.r.t world coordinates
   void HessianToWorld(double &, double &, double &) const;
@@ -623,12 +629,18 @@ public:
   /// Calculates the Jacobian of the transformation w.r.t either control point displacements or velocities
   virtual void FFDJacobianWorld(irtkMatrix &, double, double, double, double = 0, double = -1) const;
 
+  /// Calculates the Jacobian of the transformation w.r.t either control point displacements or velocities
+  virtual void FFDJacobianWorld(irtkMatrix3x3 &, double, double, double, double = 0, double = -1) const;
+
   /// Calculates the Jacobian of the global transformation w.r.t world coordinates
   virtual void GlobalJacobian(irtkMatrix &, double, double, double, double = 0, double = -1) const;
 
   /// Calculates the Jacobian of the transformation w.r.t world coordinates
   virtual void Jacobian(irtkMatrix &, double, double, double, double = 0, double = -1) const;
 
+  /// Calculates the Jacobian of the transformation w.r.t world coordinates
+  virtual void Jacobian(irtkMatrix3x3 &, double, double, double, double = 0, double = -1) const;
+
   /// Calculates the Hessian for each component of the global transformation w.r.t world coordinates
   virtual void GlobalHessian(irtkMatrix [3], double, double, double, double = 0, double = -1) const;
 
@@ -669,6 +681,19 @@ public:
   // ---------------------------------------------------------------------------
   // Properties
 
+  /// Whether the parameters of this FFD are the coefficients of its displacement
+  /// field, such that a change of the coefficients of a control point only
+  /// affects the displacements within the support region of this control point
+  /// and the sum of the coefficients of two FFDs of this type defined on the
+  /// same lattice is the sum of their displacements. This is not the case for
+  /// FFDs whose displacements are obtained by integrating a velocity field
+  /// or whose parameters are not the control point coefficients.
+  virtual bool IsDisplacementParameterized() const;
+
+  /// Whether Subdivide refines the lattice of this FFD without changing its
+  /// displacements, i.e., the subdivided FFD is the same transformation
+  virtual bool CanSubdivide() const;
+
   /// Calculates the bending of the transformation given the 2nd order derivatives
   static double Bending3D(const irtkMatrix [3]);
 
@@ -1070,6 +1095,18 @@ inline void irtkFreeFormTransformation::Subdivide(bool subdivide_x, bool subdivi
   }
 }
 
+// -----------------------------------------------------------------------------
+inline bool irtkFreeFormTransformation::IsDisplacementParameterized() const
+{
+  return false;
+}
+
+// -----------------------------------------------------------------------------
+inline bool irtkFreeFormTransformation::CanSubdivide() const
+{
+  return false;
+}
+
 // -----------------------------------------------------------------------------
 inline void irtkFreeFormTransformation::Subdivide2D()
 {
@@ -1456,6 +1493,14 @@ inline void irtkFreeFormTransformation::JacobianToWorld(irtkMatrix &jac) const
   }
 }
 
+// -----------------------------------------------------------------------------
+inline void irtkFreeFormTransformation::JacobianToWorld(irtkMatrix3x3 &jac) const
+{
+  JacobianToWorld(jac(0, 0), jac(0, 1), jac(0, 2));
+  JacobianToWorld(jac(1, 0), jac(1, 1), jac(1, 2));
+  JacobianToWorld(jac(2, 0), jac(2, 1), jac(2, 2));
+}
+
 // -----------------------------------------------------------------------------
 inline void
 irtkFreeFormTransformation::HessianToWorld(double &duu, double &duv, double &dvv) const
@@ -1550,6 +1595,14 @@ inline void irtkFreeFormTransformation::FFDJacobianWorld(irtkMatrix &, double, d
   exit(1);
 }
 
+// -----------------------------------------------------------------------------
+inline void irtkFreeFormTransformation::FFDJacobianWorld(irtkMatrix3x3 &jac, double x, double y, double z, double t, double t0) const
+{
+  irtkMatrix m(3, 3);
+  this->FFDJacobianWorld(m, x, y, z, t, t0);
+  irtkCopyJacobian(jac, m);
+}
+
 // -----------------------------------------------------------------------------
 inline void irtkFreeFormTransformation::GlobalJacobian(irtkMatrix &jac, double, double, double, double, double) const
 {
@@ -1566,6 +1619,12 @@ inline void irtkFreeFormTransformation::Jacobian(irtkMatrix &jac, double x, doub
   this->LocalJacobian(jac, x, y, z, t, t0);
 }
 
+// -----------------------------------------------------------------------------
+inline void irtkFreeFormTransformation::Jacobian(irtkMatrix3x3 &jac, double x, double y, double z, double t, double t0) const
+{
+  this->LocalJacobian(jac, x, y, z, t, t0);
+}
+
 // -----------------------------------------------------------------------------
 inline void irtkFreeFormTransformation::GlobalHessian(irtkMatrix hessian[3], double, double, double, double, double) const
 {
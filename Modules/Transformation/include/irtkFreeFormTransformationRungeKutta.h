@@ -38,6 +38,9 @@ class irtkFreeFormTransformationRungeKutta
 {
 protected:
 
+  /// Maximum number of points integrated together by TransformBatch
+  static const int BlockSize = 64;
+
   // -------------------------------------------------------------------------
   /// Helper for computation of Jacobian w.r.t spatial coordinates
   static void dkdx(irtkMatrix &dk, const irtkMatrix &Dv, const irtkMatrix &dx, double h)
@@ -83,6 +86,7 @@ protected:
  * - Evaluate
  * - EvaluateJacobianWorld
  * - EvaluateJacobianDOFs
+ * - EvaluateBatch (only required by TransformBatch)
  *
  * The second template argument is a struct of the respective Butcher tableau
  * of the Runge-Kutta method which has been defined using the macro
@@ -141,6 +145,75 @@ public:
     }
   }
 
+  // -------------------------------------------------------------------------
+  /// Integrates a batch of points, advancing blocks of points together such
+  /// that the velocities of each stage are evaluated by a single call of
+  /// TFreeFormTransformation::EvaluateBatch. The result is identical to
+  /// calling Transform for each point.
+  static void TransformBatch(const TFreeFormTransformation *v, int no,
+                             double *x, double *y, double *z,
+                             double t1, double t2, double dt)
+  {
+    if (t1 == t2) return;
+
+    double       kx[BT::s][BlockSize];           // Intermediate evaluations
+    double       ky[BT::s][BlockSize];
+    double       kz[BT::s][BlockSize];
+    const double d = copysign(1.0, t2 - t1);     // Direction of integration
+    int          i, j, p;                        // Butcher tableau and point indices
+    double       h, t, l;                        // Step size, time, and temporal lattice coordinate
+
+    for (int b = 0, n; b < no; b += n, x += n, y += n, z += n) {
+      n = no - b;
+      if (n > BlockSize) n = BlockSize;
+      // Integrate from t=t1 to t=t2
+      h = d * fabs(dt), t = t1;
+      while (d * t < d * t2) {
+        // Ensure that last step ends at t2
+        if (d * (t + h) > d * t2) h = t2 - t;
+        // Evaluate velocities at intermediate steps
+        // Note: memcpy would be instantiated with overlapping arguments for s=1
+        if (BT::fsal && BT::s > 1 && t != t1) {
+          for (p = 0; p < n; p++) {
+            kx[0][p] = kx[BT::s - 1][p];
+            ky[0][p] = ky[BT::s - 1][p];
+            kz[0][p] = kz[BT::s - 1][p];
+          }
+          i = 1;
+        } else {
+          i = 0;
+        }
+        for (/*i = 0|1*/; i < BT::s; i++) {
+          // Lattice coordinates of current intermediate step
+          for (p = 0; p < n; p++) {
+            kx[i][p] = x[p], ky[i][p] = y[p], kz[i][p] = z[p];
+            for (j = 0; j < i; j++) {
+              kx[i][p] += kx[j][p] * BT::a[i][j];
+              ky[i][p] += ky[j][p] * BT::a[i][j];
+              kz[i][p] += kz[j][p] * BT::a[i][j];
+            }
+            v->WorldToLattice(kx[i][p], ky[i][p], kz[i][p]);
+          }
+          l = v->TimeToLattice(t + BT::c[i] * h);
+          // Evaluate velocities at intermediate points
+          v->EvaluateBatch(n, kx[i], ky[i], kz[i], l);
+          for (p = 0; p < n; p++) {
+            kx[i][p] *= h, ky[i][p] *= h, kz[i][p] *= h;
+          }
+        }
+        // Perform step
+        for (i = 0; i < BT::s; i++) {
+          for (p = 0; p < n; p++) {
+            x[p] += kx[i][p] * BT::b[i];
+            y[p] += ky[i][p] * BT::b[i];
+            z[p] += kz[i][p] * BT::b[i];
+          }
+        }
+        t += h;
+      }
+    }
+  }
+
   // -------------------------------------------------------------------------
   static void Jacobian(const TFreeFormTransformation *v,
                        irtkMatrix &jac,
@@ -342,6 +415,7 @@ public:
  * - Evaluate
  * - EvaluateJacobianWorld
  * - EvaluateJacobianDOFs
+ * - EvaluateBatch (only required by TransformBatch)
  *
  * The second template argument is a struct of the respective Butcher tableau
  * of the Runge-Kutta method which has been defined using the macro
@@ -432,6 +506,120 @@ public:
     }
   }
 
+  // -------------------------------------------------------------------------
+  /// Integrates a batch of points, advancing blocks of points together such
+  /// that the velocities of each stage are evaluated by a single call of
+  /// TFreeFormTransformation::EvaluateBatch. The step size is adapted per
+  /// block using the maximum local error of its points. Given a fixed step
+  /// size, i.e., mindt == maxdt, the result is identical to calling
+  /// Transform for each point.
+  static void TransformBatch(const TFreeFormTransformation *v, int no,
+                             double *x, double *y, double *z,
+                             double t1, double t2, double mindt, double maxdt, double tol)
+  {
+    if (t1 == t2) return;
+
+    double       kx[BT::s][BlockSize];                 // Intermediate evaluations
+    double       ky[BT::s][BlockSize];
+    double       kz[BT::s][BlockSize];
+    double       nx[BlockSize];                        // Solution of order p
+    double       ny[BlockSize];
+    double       nz[BlockSize];
+    double       tx, ty, tz;                           // Solution of order p-1
+    double       error;                                // Local error estimate of block
+    double       h, hnext, t, l;                       // Step size, time, and temporal lattice coordinate
+    const double d = copysign(1.0, t2 - t1);           // Direction of integration
+    const double e = 1.0 / static_cast<double>(BT::p); // Exponent for step size scaling factor
+    int          i, j, p;                              // Butcher tableau and point indices
+
+    for (int b = 0, n; b < no; b += n, x += n, y += n, z += n) {
+      n = no - b;
+      if (n > BlockSize) n = BlockSize;
+      // Decrease initial step size if necessary
+      h = t2 - t1;
+      if (fabs(h) > maxdt) h = copysign(maxdt, d);
+      // Integrate from t=t1 to t=t2
+      t = t1;
+      while (d * t < d * t2) {
+        // Ensure that last step ends at t2
+        if (d * (t + h) > d * t2) h = t2 - t;
+        // Evaluate velocities at intermediate steps
+        // Note: memcpy would be instantiated with overlapping arguments for s=1
+        if (BT::fsal && BT::s > 1 && t != t1) {
+          for (p = 0; p < n; p++) {
+            kx[0][p] = kx[BT::s - 1][p];
+            ky[0][p] = ky[BT::s - 1][p];
+            kz[0][p] = kz[BT::s - 1][p];
+          }
+          i = 1;
+        } else {
+          i = 0;
+        }
+        for (/*i = 0|1*/; i < BT::s; i++) {
+          for (p = 0; p < n; p++) {
+            kx[i][p] = x[p], ky[i][p] = y[p], kz[i][p] = z[p];
+            for (j = 0; j < i; j++) {
+              kx[i][p] += kx[j][p] * BT::a[i][j];
+              ky[i][p] += ky[j][p] * BT::a[i][j];
+              kz[i][p] += kz[j][p] * BT::a[i][j];
+            }
+            v->WorldToLattice(kx[i][p], ky[i][p], kz[i][p]);
+          }
+          l = v->TimeToLattice(t + BT::c[i] * h);
+          v->EvaluateBatch(n, kx[i], ky[i], kz[i], l);
+          for (p = 0; p < n; p++) {
+            kx[i][p] *= h, ky[i][p] *= h, kz[i][p] *= h;
+          }
+        }
+        // Calculate solution of order p
+        for (p = 0; p < n; p++) {
+          nx[p] = x[p], ny[p] = y[p], nz[p] = z[p];
+          for (i = 0; i < BT::s; i++) {
+            nx[p] += kx[i][p] * BT::b[1][i];
+            ny[p] += ky[i][p] * BT::b[1][i];
+            nz[p] += kz[i][p] * BT::b[1][i];
+          }
+        }
+        // Adapt step size
+        if (mindt < maxdt) {
+          // Estimate local error of block from solution of order p-1
+          error = .0;
+          for (p = 0; p < n; p++) {
+            tx = x[p], ty = y[p], tz = z[p];
+            for (i = 0; i < BT::s; i++) {
+              tx += kx[i][p] * BT::b[0][i];
+              ty += ky[i][p] * BT::b[0][i];
+              tz += kz[i][p] * BT::b[0][i];
+            }
+            error = std::max(error, std::max(std::max(fabs(nx[p] - tx), fabs(ny[p] - ty)), fabs(nz[p] - tz)));
+          }
+          // If local error exceeds tolerance...
+          if (fabs(h) > mindt && error > tol) {
+            // ...decrease step size
+            h *= 0.8 * pow(tol / error, e);
+            if (fabs(h) < mindt) h = copysign(mindt, d);
+            // ...and redo current step
+            continue;
+          // Otherwise, increase step size
+          } else {
+            hnext = 0.8 * pow(tol / error, e) * h;
+            if      (fabs(hnext) < mindt) hnext = copysign(mindt, d);
+            else if (fabs(hnext) > maxdt) hnext = copysign(maxdt, d);
+          }
+        } else {
+          hnext = h;
+        }
+        // Perform step with local extrapolation
+        memcpy(x, nx, n * sizeof(double));
+        memcpy(y, ny, n * sizeof(double));
+        memcpy(z, nz, n * sizeof(double));
+        t += h;
+        // Update step size
+        h = hnext;
+      }
+    }
+  }
+
   // -------------------------------------------------------------------------
   static void Jacobian(const TFreeFormTransformation *v,
                        irtkMatrix &jac, double &x, double &y, double &z,
@@ -195,6 +195,9 @@ public:
   /// Transforms a single point
   virtual void Transform(double &, double &, double &, double = 0, double = -1) const;
 
+  /// Transforms a batch of points in the calling thread
+  virtual void TransformBatch(int, double *, double *, double *, double = 0, double = -1) const;
+
   /// Transforms a single point using the inverse of the global transformation only
   virtual void GlobalInverse(double &, double &, double &, double = 0, double = -1) const;
 
@@ -207,6 +210,10 @@ public:
   // ---------------------------------------------------------------------------
   // Derivatives
 
+  // Do not hide methods of base class
+  using irtkTransformation::LocalJacobian;
+  using irtkTransformation::Jacobian;
+
   /// Calculates the Jacobian of the global transformation w.r.t world coordinates
   virtual void GlobalJacobian(irtkMatrix &, double, double, double, double = 0, double = -1) const;
 
@@ -368,6 +375,22 @@ inline void irtkHomogeneousTransformation::Transform(double &x, double &y, doubl
   this->GlobalTransform(x, y, z, t, t0);
 }
 
+// -----------------------------------------------------------------------------
+inline void irtkHomogeneousTransformation::TransformBatch(int no, double *x, double *y, double *z, double, double) const
+{
+  const double a00 = _matrix(0, 0), a01 = _matrix(0, 1), a02 = _matrix(0, 2), a03 = _matrix(0, 3);
+  const double a10 = _matrix(1, 0), a11 = _matrix(1, 1), a12 = _matrix(1, 2), a13 = _matrix(1, 3);
+  const double a20 = _matrix(2, 0), a21 = _matrix(2, 1), a22 = _matrix(2, 2), a23 = _matrix(2, 3);
+
+  double a, b, c;
+  for (int i = 0; i < no; ++i) {
+    a = a00 * x[i] + a01 * y[i] + a02 * z[i] + a03;
+    b = a10 * x[i] + a11 * y[i] + a12 * z[i] + a13;
+    c = a20 * x[i] + a21 * y[i] + a22 * z[i] + a23;
+    x[i] = a, y[i] = b, z[i] = c;
+  }
+}
+
 // -----------------------------------------------------------------------------
 inline void irtkHomogeneousTransformation::GlobalInverse(double &x, double &y, double &z, double, double) const
 {
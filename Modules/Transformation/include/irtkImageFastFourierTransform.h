@@ -22,22 +22,16 @@ void four1NR(float data[], unsigned long nn, int isign);
 
 /// * Fast Fourier transform of the complex image contained in 'RealSignal' and 'ImaginarySignal'
 ///(real and imaginary part).
-// * RealSignal and ImaginarySignal MUST have the same size and the size on each dimension MUST
-// be a power of 2. (NOT TESTED IN THE FUNCTION)
-// * Remark: The FFT of Numerical recipies is called here. Using this function the treated
-// signal at the identifier "i" must be in "2*i+1" for the real part and (2*i+2) for the
-// imaginary part. If the size of the treated signal is 'S' the size of the input vector
-// is "2*s+1" and its value at '0' is not treated (strange notations of numerical recipies!!!).
+// * RealSignal and ImaginarySignal MUST have the same size. (NOT TESTED IN THE FUNCTION)
+// * Remark: The 1D transforms of all lines along each axis are computed in parallel. Transforms
+// of sizes which are a power of 2 are fastest, other sizes are computed by Bluestein's algorithm.
+// The tables of each transform size are computed once and shared by all subsequent calls.
 void DirectFFT(irtkGenericImage<float> * RealSignal,irtkGenericImage<float> * ImaginarySignal);
 
 /// * Inverse Fast Fourier transform of the complex image contained in 'RealSignal' and 'ImaginarySignal'
 /// (real and imaginary part).
-// * RealSignal and ImaginarySignal MUST have the same size and the size on each dimension MUST
-// be a power of 2. (NOT TESTED IN THE FUNCTION)
-// * Remark: The FFT of Numerical recipies is called here. Using this function the treated
-// signal at the identifier "i" must be in "2*i+1" for the real part and (2*i+2) for the
-// imaginary part. If the size of the treated signal is 'S' the size of the input vector
-// is "2*s+1" and its value at '0' is not treated (strange notations of numerical recipies!!!).
+// * RealSignal and ImaginarySignal MUST have the same size. (NOT TESTED IN THE FUNCTION)
+// * Remark: See DirectFFT.
 void InverseFFT(irtkGenericImage<float> * RealSignal,irtkGenericImage<float> * ImaginarySignal);
 
 
@@ -55,8 +49,8 @@ void InverseFFT(irtkGenericImage<float> * RealSignal,irtkGenericImage<float> * I
 //     RealPartFilter->Put(NBX-1,0,0,0,1./7.);  ImaginaryPartFilter->Put(NBX-1,0,0,0,0.);
 //     RealPartFilter->Put(0,NBY-1,0,0,1./7.);  ImaginaryPartFilter->Put(0,NBY-1,0,0,0.);
 //     RealPartFilter->Put(0,0,NBZ-1,0,1./7.);  ImaginaryPartFilter->Put(0,0,NBZ-1,0,0.);
-// * RealPartSignal, ImaginaryPartSignal, RealPartFilter and ImaginaryPartFilter MUST have the same size 
-// and the size on each dimension MUST be a power of 2. (NOT TESTED IN THE FUNCTION)
+// * RealPartSignal, ImaginaryPartSignal, RealPartFilter and ImaginaryPartFilter MUST have the same size.
+// (NOT TESTED IN THE FUNCTION)
 void ConvolutionInFourier(irtkGenericImage<float> * RealPartSignal,irtkGenericImage<float> * ImaginaryPartSignal,irtkGenericImage<float> * RealPartFilter,irtkGenericImage<float> * ImaginaryPartFilter);
 
 
@@ -71,8 +65,8 @@ void ConvolutionInFourierNoFilterTransfo(irtkGenericImage<float> * RealPartSigna
 
 /// * Deconvolution in Fourier spaces of the 3D complex image in ('RealPartSignal','ImaginaryPartSignal')
 /// by the complex filter in ('RealPartFilter','ImaginaryPartFilter')
-// * RealPartSignal, ImaginaryPartSignal, RealPartFilter and ImaginaryPartFilter MUST have the same size 
-// and the size on each dimension MUST be a power of 2. (NOT TESTED IN THE FUNCTION)
+// * RealPartSignal, ImaginaryPartSignal, RealPartFilter and ImaginaryPartFilter MUST have the same size.
+// (NOT TESTED IN THE FUNCTION)
 void DeconvolutionInFourier(irtkGenericImage<float> * RealPartSignal,irtkGenericImage<float> * ImaginaryPartSignal,irtkGenericImage<float> * RealPartFilter,irtkGenericImage<float> * ImaginaryPartFilter);
 
 
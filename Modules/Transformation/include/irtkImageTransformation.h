@@ -88,6 +88,10 @@ class irtkImageTransformation : public irtkObject
   /// Number of points for which the required inverse transformation was invalid
   irtkReadOnlyAttributeMacro(int, NumberOfSingularPoints);
 
+  /// Whether to invert the transformation by fixed-point iteration on a cached
+  /// dense displacement field instead of inverting it at each output voxel
+  irtkReadOnlyAttributeMacro(bool, FixedPointInversion);
+
 protected:
 
   /// Input for the image to image filter
@@ -197,6 +201,9 @@ public:
   /// Invert off
   virtual void InvertOff(void);
 
+  /// Set whether to invert the transformation by fixed-point iteration
+  virtual void FixedPointInversion(bool);
+
   /// 2D mode on
   virtual void TwoDOn(void);
 
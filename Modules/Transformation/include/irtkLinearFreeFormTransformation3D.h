@@ -146,6 +146,9 @@ public:
   // Properties
   using irtkFreeFormTransformation3D::BendingEnergy;
 
+  /// Whether the parameters are the coefficients of the displacement field
+  virtual bool IsDisplacementParameterized() const;
+
   /// Size of support region of the used kernel
   virtual int KernelSize() const;
 
@@ -120,6 +120,12 @@ public:
   /// Transforms a single point using the inverse transformation
   virtual bool LocalInverse(double &, double &, double &, double, double) const;
 
+  // ---------------------------------------------------------------------------
+  // Properties
+
+  /// Whether the parameters are the coefficients of the displacement field
+  virtual bool IsDisplacementParameterized() const;
+
   // ---------------------------------------------------------------------------
   // I/O
 
@@ -221,5 +227,15 @@ inline bool irtkLinearFreeFormTransformationTD::LocalInverse(double &x, double &
   return true;
 }
 
+// =============================================================================
+// Properties
+// =============================================================================
+
+// -----------------------------------------------------------------------------
+inline bool irtkLinearFreeFormTransformationTD::IsDisplacementParameterized() const
+{
+  return false;
+}
+
 
 #endif
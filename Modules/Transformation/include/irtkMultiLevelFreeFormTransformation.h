@@ -51,7 +51,17 @@ public:
   // ---------------------------------------------------------------------------
   // Levels
 
+  /// Whether all local transformations can be merged into a single level,
+  /// i.e., are of the same type, are parameterized by displacements rather
+  /// than velocities, and either defined on the same lattice or on a lattice
+  /// which is refined to the finest level by subdivision
+  bool CanCombineLocalTransformation() const;
+
   /// Combine local transformations on stack
+  ///
+  /// Coarser B-spline levels are subdivided to the control point spacing of
+  /// the finest level before their coefficients are added, which results in
+  /// a single free-form deformation that is cheaper to evaluate.
   virtual void CombineLocalTransformation();
 
   /// Convert the global transformation from a matrix representation to a
@@ -154,6 +164,7 @@ public:
   // Do not hide base class methods
   using irtkMultiLevelTransformation::LocalTransform;
   using irtkMultiLevelTransformation::Transform;
+  using irtkMultiLevelTransformation::TransformBatch;
   using irtkMultiLevelTransformation::Displacement;
   using irtkMultiLevelTransformation::InverseDisplacement;
 
@@ -163,6 +174,12 @@ public:
   /// Transforms a single point
   virtual void Transform(int, int, double &, double &, double &, double = 0, double = -1) const;
 
+  /// Transforms a batch of points in the calling thread
+  ///
+  /// The displacements of each level are evaluated for chunks of points using
+  /// irtkTransformation::TransformBatch of the respective local transformation.
+  virtual void TransformBatch(int, int, int, double *, double *, double *, double = 0, double = -1) const;
+
   /// Calculates the displacement vectors for a whole image domain
   ///
   /// \attention The displacements are computed at the positions after applying the
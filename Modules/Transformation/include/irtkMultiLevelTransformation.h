@@ -329,6 +329,12 @@ public:
   /// Transforms a single point
   virtual void Transform(double &, double &, double &, double = 0, double = -1) const;
 
+  /// Transforms a batch of points in the calling thread
+  virtual void TransformBatch(int, int, int, double *, double *, double *, double = 0, double = -1) const;
+
+  /// Transforms a batch of points in the calling thread
+  virtual void TransformBatch(int, double *, double *, double *, double = 0, double = -1) const;
+
   /// Transforms a single point
   virtual void Transform(int, int, irtkPoint &, double = 0, double = -1) const;
 
@@ -525,6 +531,7 @@ public:
   using irtkTransformation::GlobalJacobian;
   using irtkTransformation::LocalJacobian;
   using irtkTransformation::Jacobian;
+  using irtkTransformation::DeriveJacobianWrtDOF;
 
   /// Calculates the Jacobian of the global transformation w.r.t world coordinates
   virtual void GlobalJacobian(irtkMatrix &, double, double, double, double = 0, double = -1) const;
@@ -784,6 +791,18 @@ inline void irtkMultiLevelTransformation::Transform(double &x, double &y, double
   this->Transform(-1, x, y, z, t, t0);
 }
 
+// -----------------------------------------------------------------------------
+inline void irtkMultiLevelTransformation::TransformBatch(int m, int n, int no, double *x, double *y, double *z, double t, double t0) const
+{
+  for (int i = 0; i < no; ++i) this->Transform(m, n, x[i], y[i], z[i], t, t0);
+}
+
+// -----------------------------------------------------------------------------
+inline void irtkMultiLevelTransformation::TransformBatch(int no, double *x, double *y, double *z, double t, double t0) const
+{
+  this->TransformBatch(-1, -1, no, x, y, z, t, t0);
+}
+
 // -----------------------------------------------------------------------------
 inline void irtkMultiLevelTransformation::Transform(int l, int n, irtkPoint &p, double t, double t0) const
 {
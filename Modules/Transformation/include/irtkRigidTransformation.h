@@ -158,6 +158,7 @@ public:
 
   // Do not overwrite other base class overloads
   using irtkTransformation::JacobianDOFs;
+  using irtkHomogeneousTransformation::DeriveJacobianWrtDOF;
 
   /// Calculates the Jacobian of the transformation w.r.t the parameters
   virtual void JacobianDOFs(double [3], int, double, double, double, double = 0, double = -1) const;
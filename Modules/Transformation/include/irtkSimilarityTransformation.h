@@ -96,6 +96,7 @@ public:
 
   // Do not overwrite other base class overloads
   using irtkTransformation::JacobianDOFs;
+  using irtkRigidTransformation::DeriveJacobianWrtDOF;
 
   /// Calculates the Jacobian of the transformation w.r.t the parameters
   virtual void JacobianDOFs(double [3], int, double, double, double, double = 0, double = -1) const;
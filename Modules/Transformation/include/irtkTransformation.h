@@ -19,6 +19,7 @@
 
 #include <irtkBSpline.h>
 #include <irtkGeometry.h>
+#include <irtkMatrix3x3.h>
 #include <irtkImage.h>
 #include <irtkIndent.h>
 #include <irtkTransformationJacobian.h>
@@ -197,6 +198,11 @@ public:
   /// and creating the appropriate transformation.
   static irtkTransformation *New(const char *);
 
+  /// Whether the named file exists and starts with the magic number of
+  /// a transformation file. Unlike New(), this function does not terminate
+  /// the program when the file cannot be read.
+  static bool CheckHeader(const char *);
+
   /// Default destructor.
   virtual ~irtkTransformation();
 
@@ -434,6 +440,16 @@ public:
   /// Transforms world coordinates of image voxels
   virtual void Transform(irtkWorldCoordsImage &, double = -1) const;
 
+  /// Transforms a batch of points in the calling thread
+  ///
+  /// Unlike Transform(int, double *, double *, double *, ...), this function
+  /// does not spawn any threads. It is intended to be called by the body of
+  /// a parallel loop for each chunk of points (e.g., an image row) such that
+  /// subclasses can amortize the cost of the virtual function call and
+  /// evaluate the transformation using a tight, inlined inner loop.
+  /// The default implementation calls Transform for each point.
+  virtual void TransformBatch(int, double *, double *, double *, double = 0, double = -1) const;
+
   /// Calculates the displacement of a single point using the global transformation component only
   virtual void GlobalDisplacement(double &, double &, double &, double = 0, double = -1) const;
 
@@ -443,6 +459,14 @@ public:
   /// Calculates the displacement of a single point
   virtual void Displacement(double &, double &, double &, double = 0, double = -1) const;
 
+  /// Calculates the displacements of a batch of points in the calling thread
+  ///
+  /// The input point coordinates are replaced by the respective displacements.
+  /// The default implementation uses TransformBatch on chunks of points.
+  ///
+  /// \sa TransformBatch
+  virtual void DisplacementBatch(int, double *, double *, double *, double = 0, double = -1) const;
+
   /// Calculates the displacement at specified lattice points
   ///
   /// \attention The displacements are computed at the positions after applying the
@@ -562,6 +586,39 @@ public:
   /// \returns Number of points at which transformation is non-invertible.
   virtual int InverseDisplacement(irtkGenericImage<float> &, double, double, const irtkWorldCoordsImage * = NULL) const;
 
+  /// Calculates the inverse displacement vectors for a whole image domain
+  /// using a fixed-point iteration on all voxels of the displacement field
+  ///
+  /// The inverse at each point y is found as fixed point of x = y - u(x),
+  /// where u is the displacement of this transformation. The displacements
+  /// are evaluated in batches of image rows using DisplacementBatch and the
+  /// iteration of each row is started at the solution of the previous row.
+  /// Points at which the residual |T(x) - y| is not below the given tolerance
+  /// (in mm) after the maximum number of iterations are refined by Newton's
+  /// method and, if this fails as well, inverted using Inverse.
+  ///
+  /// \attention The displacements are computed at the positions after applying the
+  ///            current displacements at each voxel. These displacements are then
+  ///            added to the current displacements. Therefore, set the input
+  ///            displacements to zero if only interested in the displacements of
+  ///            this transformation at the voxel positions.
+  ///
+  /// \returns Number of points at which transformation is non-invertible.
+  int FixedPointInverseDisplacement(irtkGenericImage<double> &, double, double,
+                                    const irtkWorldCoordsImage * = NULL,
+                                    double = 1e-2, int = 20) const;
+
+  /// Calculates the inverse displacement vectors for a whole image domain
+  /// using a fixed-point iteration on all voxels of the displacement field
+  ///
+  /// \sa FixedPointInverseDisplacement(irtkGenericImage<double> &, double, double,
+  ///                                   const irtkWorldCoordsImage *, double, int)
+  ///
+  /// \returns Number of points at which transformation is non-invertible.
+  int FixedPointInverseDisplacement(irtkGenericImage<float> &, double, double,
+                                    const irtkWorldCoordsImage * = NULL,
+                                    double = 1e-2, int = 20) const;
+
   // ---------------------------------------------------------------------------
   // Derivatives
 
@@ -574,6 +631,18 @@ public:
   /// Calculates the Jacobian of the transformation w.r.t world coordinates
   virtual void Jacobian(irtkMatrix &, double, double, double, double = 0, double = -1) const;
 
+  /// Calculates the Jacobian of the local transformation w.r.t world coordinates
+  ///
+  /// The default implementation copies the result of the irtkMatrix overload.
+  /// Subclasses override this function to avoid the heap allocated matrix.
+  virtual void LocalJacobian(irtkMatrix3x3 &, double, double, double, double = 0, double = -1) const;
+
+  /// Calculates the Jacobian of the transformation w.r.t world coordinates
+  ///
+  /// The default implementation copies the result of the irtkMatrix overload.
+  /// Subclasses override this function to avoid the heap allocated matrix.
+  virtual void Jacobian(irtkMatrix3x3 &, double, double, double, double = 0, double = -1) const;
+
   /// Calculates the determinant of the Jacobian of the global transformation w.r.t world coordinates
   virtual double GlobalJacobian(double, double, double, double = 0, double = -1) const;
 
@@ -598,6 +667,11 @@ public:
   /// Calculates the derivative of the Jacobian of the transformation (w.r.t. world coordinates) w.r.t. a transformation parameter
   virtual void DeriveJacobianWrtDOF(irtkMatrix &, int, double, double, double, double = 0, double = -1) const;
 
+  /// Calculates the derivative of the Jacobian of the transformation (w.r.t. world coordinates) w.r.t. a transformation parameter
+  ///
+  /// The default implementation copies the result of the irtkMatrix overload.
+  virtual void DeriveJacobianWrtDOF(irtkMatrix3x3 &, int, double, double, double, double = 0, double = -1) const;
+
   /// Applies the chain rule to convert spatial non-parametric gradient
   /// to a gradient w.r.t the parameters of this transformation.
   ///
@@ -1016,6 +1090,41 @@ inline void irtkTransformation::DeriveJacobianWrtDOF(irtkMatrix &, int, double,
   exit(1);
 }
 
+// -----------------------------------------------------------------------------
+/// Copy 3x3 (or 2x2) irtkMatrix to irtkMatrix3x3
+inline void irtkCopyJacobian(irtkMatrix3x3 &jac, const irtkMatrix &m)
+{
+  jac = .0;
+  for (int r = 0; r < m.Rows() && r < 3; ++r)
+  for (int c = 0; c < m.Cols() && c < 3; ++c) {
+    jac(r, c) = m(r, c);
+  }
+}
+
+// -----------------------------------------------------------------------------
+inline void irtkTransformation::LocalJacobian(irtkMatrix3x3 &jac, double x, double y, double z, double t, double t0) const
+{
+  irtkMatrix m(3, 3);
+  this->LocalJacobian(m, x, y, z, t, t0);
+  irtkCopyJacobian(jac, m);
+}
+
+// -----------------------------------------------------------------------------
+inline void irtkTransformation::Jacobian(irtkMatrix3x3 &jac, double x, double y, double z, double t, double t0) const
+{
+  irtkMatrix m(3, 3);
+  this->Jacobian(m, x, y, z, t, t0);
+  irtkCopyJacobian(jac, m);
+}
+
+// -----------------------------------------------------------------------------
+inline void irtkTransformation::DeriveJacobianWrtDOF(irtkMatrix3x3 &dJdp, int dof, double x, double y, double z, double t, double t0) const
+{
+  irtkMatrix m(3, 3);
+  this->DeriveJacobianWrtDOF(m, dof, x, y, z, t, t0);
+  irtkCopyJacobian(dJdp, m);
+}
+
 // -----------------------------------------------------------------------------
 inline double irtkTransformation::GlobalJacobian(double x, double y, double z, double t, double t0) const
 {
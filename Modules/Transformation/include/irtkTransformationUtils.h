@@ -21,6 +21,11 @@
 namespace irtkTransformationUtils {
 
 
+// -----------------------------------------------------------------------------
+/// Maximum number of points processed at once by batch evaluation helpers
+/// which need temporary storage on the stack
+const int BatchSize = 256;
+
 // -----------------------------------------------------------------------------
 /// Parallel helper for irtkTransformation::Approximate implementations
 class SubDisplacements
@@ -84,8 +89,12 @@ public:
     double *x = _x + idx.begin();
     double *y = _y + idx.begin();
     double *z = _z + idx.begin();
-    for (int i = idx.begin(); i != idx.end(); ++i, ++x, ++y, ++z) {
-      _Transformation->Transform(*x, *y, *z, (_t ? _t[i] : _t1), _t0);
+    if (_t) {
+      for (int i = idx.begin(); i != idx.end(); ++i, ++x, ++y, ++z) {
+        _Transformation->Transform(*x, *y, *z, _t[i], _t0);
+      }
+    } else {
+      _Transformation->TransformBatch(idx.end() - idx.begin(), x, y, z, _t1, _t0);
     }
   }
 };
@@ -115,9 +124,7 @@ public:
     wx = _Coords->Data() + idx.begin();
     wy = wx + _NumberOfPoints;
     wz = wy + _NumberOfPoints;
-    for (int i = idx.begin(); i != idx.end(); ++i, ++wx, ++wy, ++wz) {
-      _Transformation->Transform(*wx, *wy, *wz, _t, _t0);
-    }
+    _Transformation->TransformBatch(idx.end() - idx.begin(), wx, wy, wz, _t, _t0);
   }
 };
 
@@ -609,8 +609,20 @@ void irtkBSplineFreeFormTransformation3D
 }
 
 // -----------------------------------------------------------------------------
-template <class CPImage>
-void EvaluateJacobian(const CPImage *coeff, irtkMatrix &jac, double x, double y)
+inline void InitializeJacobian(irtkMatrix &jac)
+{
+  jac.Initialize(3, 3);
+}
+
+// -----------------------------------------------------------------------------
+inline void InitializeJacobian(irtkMatrix3x3 &jac)
+{
+  jac = .0;
+}
+
+// -----------------------------------------------------------------------------
+template <class CPImage, class Matrix>
+void EvaluateJacobian(const CPImage *coeff, Matrix &jac, double x, double y)
 {
   typedef irtkBSplineFreeFormTransformation3D::Kernel Kernel;
 
@@ -638,7 +650,7 @@ void EvaluateJacobian(const CPImage *coeff, irtkMatrix &jac, double x, double y)
     }
   }
 
-  jac.Initialize(3, 3);
+  InitializeJacobian(jac);
   jac(0, 0) = dx._x; jac(0, 1) = dy._x;
   jac(1, 0) = dx._y; jac(1, 1) = dy._y;
   jac(2, 0) = dx._z; jac(2, 1) = dy._z;
@@ -653,8 +665,16 @@ void irtkBSplineFreeFormTransformation3D
 }
 
 // -----------------------------------------------------------------------------
-template <class CPImage>
-void EvaluateJacobian(const CPImage *coeff, irtkMatrix &jac, double x, double y, double z)
+void irtkBSplineFreeFormTransformation3D
+::EvaluateJacobian(irtkMatrix3x3 &jac, double x, double y) const
+{
+  if (_FFD.IsInside(x, y)) ::EvaluateJacobian(&_CPImage, jac, x, y);
+  else                     ::EvaluateJacobian( _CPValue, jac, x, y);
+}
+
+// -----------------------------------------------------------------------------
+template <class CPImage, class Matrix>
+void EvaluateJacobian(const CPImage *coeff, Matrix &jac, double x, double y, double z)
 {
   typedef irtkBSplineFreeFormTransformation3D::Kernel Kernel;
 
@@ -690,7 +710,7 @@ void EvaluateJacobian(const CPImage *coeff, irtkMatrix &jac, double x, double y,
     }
   }
 
-  jac.Initialize(3, 3);
+  InitializeJacobian(jac);
   jac(0, 0) = dx._x; jac(0, 1) = dy._x; jac(0, 2) = dz._x;
   jac(1, 0) = dx._y; jac(1, 1) = dy._y; jac(1, 2) = dz._y;
   jac(2, 0) = dx._z; jac(2, 1) = dy._z; jac(2, 2) = dz._z;
@@ -704,6 +724,14 @@ void irtkBSplineFreeFormTransformation3D
   else                        ::EvaluateJacobian( _CPValue, jac, x, y, z);
 }
 
+// -----------------------------------------------------------------------------
+void irtkBSplineFreeFormTransformation3D
+::EvaluateJacobian(irtkMatrix3x3 &jac, double x, double y, double z) const
+{
+  if (_FFD.IsInside(x, y, z)) ::EvaluateJacobian(&_CPImage, jac, x, y, z);
+  else                        ::EvaluateJacobian( _CPValue, jac, x, y, z);
+}
+
 // -----------------------------------------------------------------------------
 template <class CPImage>
 void EvaluateHessian(const CPImage *coeff, irtkMatrix hessian[3], int i, int j)
@@ -1106,9 +1134,12 @@ void irtkBSplineFreeFormTransformation3D
 // =============================================================================
 
 // -----------------------------------------------------------------------------
-void irtkBSplineFreeFormTransformation3D
-::JacobianDetDerivative(irtkMatrix *detdev, int x, int y, int z) const
+template <class Matrix>
+void JacobianDetDerivative(const irtkBSplineFreeFormTransformation3D *ffd,
+                           Matrix *detdev, int x, int y, int z)
 {
+  typedef irtkBSplineFreeFormTransformation3D::Kernel Kernel;
+
   // Values of the B-spline basis functions and its 1st derivative
   const double *w[2] = {
     Kernel::LatticeWeights,
@@ -1139,20 +1170,46 @@ void irtkBSplineFreeFormTransformation3D
 
   // Return
   for (int i = 0; i < 3; ++i) {
-    detdev[i].Initialize(3, 3);
+    InitializeJacobian(detdev[i]);
     // w.r.t lattice coordinates
     detdev[i](i, 0) = b_i;
     detdev[i](i, 1) = b_j;
     detdev[i](i, 2) = b_k;
     // w.r.t world coordinates
-    JacobianToWorld(detdev[i]);
+    ffd->JacobianToWorld(detdev[i]);
   }
 }
 
+// -----------------------------------------------------------------------------
+void irtkBSplineFreeFormTransformation3D
+::JacobianDetDerivative(irtkMatrix *detdev, int x, int y, int z) const
+{
+  ::JacobianDetDerivative(this, detdev, x, y, z);
+}
+
+// -----------------------------------------------------------------------------
+void irtkBSplineFreeFormTransformation3D
+::JacobianDetDerivative(irtkMatrix3x3 *detdev, int x, int y, int z) const
+{
+  ::JacobianDetDerivative(this, detdev, x, y, z);
+}
+
 // =============================================================================
 // Properties
 // =============================================================================
 
+// -----------------------------------------------------------------------------
+bool irtkBSplineFreeFormTransformation3D::IsDisplacementParameterized() const
+{
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+bool irtkBSplineFreeFormTransformation3D::CanSubdivide() const
+{
+  return true;
+}
+
 // -----------------------------------------------------------------------------
 int irtkBSplineFreeFormTransformation3D::KernelSize() const
 {
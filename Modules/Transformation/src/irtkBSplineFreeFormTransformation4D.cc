@@ -462,6 +462,73 @@ void irtkBSplineFreeFormTransformation4D
 // Evaluation
 // =============================================================================
 
+// -----------------------------------------------------------------------------
+void irtkBSplineFreeFormTransformation4D
+::EvaluateBatch(int no, double *x, double *y, double *z, double t) const
+{
+  // Nearest neighbor extrapolation of the control point coefficients
+  // amounts to clamping the indices of the B-spline kernel support
+  const bool clamp = (_FFD.ExtrapolationMode() == Extrapolation_NN);
+
+  // Temporal kernel weights and control point frames shared by all points
+  int l = static_cast<int>(floor(t));
+  const int D = Kernel::VariableToIndex(t - l);
+  --l;
+
+  const bool tinside = (0 <= l && l + 3 < _t);
+  if (!clamp && !tinside) {
+    for (int n = 0; n < no; ++n) Evaluate(x[n], y[n], z[n], t);
+    return;
+  }
+
+  const int xyz = _x * _y * _z;
+  int toff[4];
+  for (int d = 0; d < 4; ++d) {
+    toff[d] = max(0, min(l + d, _t - 1)) * xyz;
+  }
+
+  // Evaluate B-spline at each point using direct access to the coefficients
+  const Vector *coeff = _CPImage.Data();
+  int    i, j, k, A, B, C, a, b, c, d;
+  int    xoff[4], yoff[4], zoff[4];
+  double wzt, wyzt;
+  Vector val;
+
+  for (int n = 0; n < no; ++n) {
+    i = static_cast<int>(floor(x[n]));
+    j = static_cast<int>(floor(y[n]));
+    k = static_cast<int>(floor(z[n]));
+    A = Kernel::VariableToIndex(x[n] - i);
+    B = Kernel::VariableToIndex(y[n] - j);
+    C = Kernel::VariableToIndex(z[n] - k);
+    --i, --j, --k;
+    if (!clamp && (i < 0 || i + 3 >= _x || j < 0 || j + 3 >= _y || k < 0 || k + 3 >= _z)) {
+      Evaluate(x[n], y[n], z[n], t);
+      continue;
+    }
+    for (a = 0; a < 4; ++a) {
+      xoff[a] =  max(0, min(i + a, _x - 1));
+      yoff[a] =  max(0, min(j + a, _y - 1)) * _x;
+      zoff[a] =  max(0, min(k + a, _z - 1)) * _x * _y;
+    }
+    val = .0;
+    for (d = 0; d < 4; ++d) {
+      for (c = 0; c < 4; ++c) {
+        wzt = Kernel::LookupTable[C][c] * Kernel::LookupTable[D][d];
+        for (b = 0; b < 4; ++b) {
+          wyzt = Kernel::LookupTable[B][b] * wzt;
+          const Vector *v = coeff + toff[d] + zoff[c] + yoff[b];
+          val += Kernel::LookupTable[A][0] * wyzt * v[xoff[0]];
+          val += Kernel::LookupTable[A][1] * wyzt * v[xoff[1]];
+          val += Kernel::LookupTable[A][2] * wyzt * v[xoff[2]];
+          val += Kernel::LookupTable[A][3] * wyzt * v[xoff[3]];
+        }
+      }
+    }
+    x[n] = val._x, y[n] = val._y, z[n] = val._z;
+  }
+}
+
 // -----------------------------------------------------------------------------
 // Note: We are only returning the first three columns of the Jacobian
 //       (the full Jacobian is a 3x4 matrix and we return a 3x3 one)
@@ -1097,6 +1164,12 @@ void irtkBSplineFreeFormTransformation4D
 // Properties
 // =============================================================================
 
+// -----------------------------------------------------------------------------
+bool irtkBSplineFreeFormTransformation4D::IsDisplacementParameterized() const
+{
+  return true;
+}
+
 // -----------------------------------------------------------------------------
 int irtkBSplineFreeFormTransformation4D::KernelSize() const
 {
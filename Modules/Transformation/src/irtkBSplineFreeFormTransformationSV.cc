@@ -68,7 +68,9 @@ irtkBSplineFreeFormTransformationSV
   _LieDerivative    (false),
   _NumberOfBCHTerms (4),
   _JacobianDOFs     (NULL),
-  _JacobianDOFsIntervalLength(.0)
+  _JacobianDOFsIntervalLength(.0),
+  _ScalingAndSquaring(NULL),
+  _ScalingAndSquaringInUse(false)
 {
   _ExtrapolationMode = Extrapolation_NN;
 }
@@ -86,7 +88,9 @@ irtkBSplineFreeFormTransformationSV
   _LieDerivative    (false),
   _NumberOfBCHTerms (4),
   _JacobianDOFs     (NULL),
-  _JacobianDOFsIntervalLength(.0)
+  _JacobianDOFsIntervalLength(.0),
+  _ScalingAndSquaring(NULL),
+  _ScalingAndSquaringInUse(false)
 {
   _ExtrapolationMode = Extrapolation_NN;
   Initialize(attr, dx, dy, dz);
@@ -105,7 +109,9 @@ irtkBSplineFreeFormTransformationSV
   _LieDerivative    (false),
   _NumberOfBCHTerms (4),
   _JacobianDOFs     (NULL),
-  _JacobianDOFsIntervalLength(.0)
+  _JacobianDOFsIntervalLength(.0),
+  _ScalingAndSquaring(NULL),
+  _ScalingAndSquaringInUse(false)
 {
   _ExtrapolationMode = Extrapolation_NN;
   Initialize(target.Attributes(), dx, dy, dz);
@@ -123,7 +129,9 @@ irtkBSplineFreeFormTransformationSV
   _LieDerivative    (false),
   _NumberOfBCHTerms (4),
   _JacobianDOFs     (NULL),
-  _JacobianDOFsIntervalLength(.0)
+  _JacobianDOFsIntervalLength(.0),
+  _ScalingAndSquaring(NULL),
+  _ScalingAndSquaringInUse(false)
 {
   Initialize(image, disp);
 }
@@ -141,7 +149,9 @@ irtkBSplineFreeFormTransformationSV
   _LieDerivative    (ffd._LieDerivative),
   _NumberOfBCHTerms (ffd._NumberOfBCHTerms),
   _JacobianDOFs     (NULL),
-  _JacobianDOFsIntervalLength(.0)
+  _JacobianDOFsIntervalLength(.0),
+  _ScalingAndSquaring(NULL),
+  _ScalingAndSquaringInUse(false)
 {
 }
 
@@ -150,6 +160,7 @@ irtkBSplineFreeFormTransformationSV
 ::~irtkBSplineFreeFormTransformationSV()
 {
   delete _JacobianDOFs;
+  delete _ScalingAndSquaring;
 }
 
 // -----------------------------------------------------------------------------
@@ -951,6 +962,30 @@ void irtkBSplineFreeFormTransformationSV::IntegrateVelocities(double &x, double
   }
 }
 
+// -----------------------------------------------------------------------------
+void irtkBSplineFreeFormTransformationSV
+::IntegrateVelocities(int no, double *x, double *y, double *z, double T) const
+{
+  const double dt = StepLengthForIntervalLength(T);
+  if (dt) {
+    if      (_IntegrationMethod == FFDIM_FastSS ||
+             _IntegrationMethod == FFDIM_SS     ||
+             _IntegrationMethod == FFDIM_RKE1)   RKE1  ::TransformBatch(this, no, x, y, z, .0, T, dt);
+    else if (_IntegrationMethod == FFDIM_RKE2)   RKE2  ::TransformBatch(this, no, x, y, z, .0, T, dt);
+    else if (_IntegrationMethod == FFDIM_RKH2)   RKH2  ::TransformBatch(this, no, x, y, z, .0, T, dt);
+    else if (_IntegrationMethod == FFDIM_RK4)    RK4   ::TransformBatch(this, no, x, y, z, .0, T, dt);
+    else if (_IntegrationMethod == FFDIM_RKEH12) RKEH12::TransformBatch(this, no, x, y, z, .0, T, 0.5 * dt, 2.0 * dt, SVFFD_RKTOL);
+    else if (_IntegrationMethod == FFDIM_RKBS23) RKBS23::TransformBatch(this, no, x, y, z, .0, T, 0.5 * dt, 2.0 * dt, SVFFD_RKTOL);
+    else if (_IntegrationMethod == FFDIM_RKF45)  RKF45 ::TransformBatch(this, no, x, y, z, .0, T, 0.5 * dt, 2.0 * dt, SVFFD_RKTOL);
+    else if (_IntegrationMethod == FFDIM_RKCK45) RKCK45::TransformBatch(this, no, x, y, z, .0, T, 0.5 * dt, 2.0 * dt, SVFFD_RKTOL);
+    else if (_IntegrationMethod == FFDIM_RKDP45) RKDP45::TransformBatch(this, no, x, y, z, .0, T, 0.5 * dt, 2.0 * dt, SVFFD_RKTOL);
+    else {
+      cerr << "irtkBSplineFreeFormTransformationSV::IntegrateVelocities: Unknown integration method: " << _IntegrationMethod << endl;
+      exit(1);
+    }
+  }
+}
+
 // -----------------------------------------------------------------------------
 void irtkBSplineFreeFormTransformationSV
 ::LocalTransform(double &x, double &y, double &z, double t, double t0) const
@@ -958,6 +993,13 @@ void irtkBSplineFreeFormTransformationSV
   IntegrateVelocities(x, y, z, + UpperIntegrationLimit(t, t0));
 }
 
+// -----------------------------------------------------------------------------
+void irtkBSplineFreeFormTransformationSV
+::TransformBatch(int no, double *x, double *y, double *z, double t, double t0) const
+{
+  IntegrateVelocities(no, x, y, z, UpperIntegrationLimit(t, t0));
+}
+
 // -----------------------------------------------------------------------------
 bool irtkBSplineFreeFormTransformationSV
 ::LocalInverse(double &x, double &y, double &z, double t, double t0) const
@@ -966,6 +1008,48 @@ bool irtkBSplineFreeFormTransformationSV
   return true;
 }
 
+// -----------------------------------------------------------------------------
+/// Releases the claim of the shared scaling and squaring filter when the
+/// exponentiation is done
+struct ScalingAndSquaringClaim
+{
+  std::atomic<bool> *_InUse;
+
+  ScalingAndSquaringClaim() : _InUse(NULL) {}
+  ~ScalingAndSquaringClaim() { if (_InUse) _InUse->store(false); }
+};
+
+// -----------------------------------------------------------------------------
+/// Get scaling and squaring filter for single precision vector fields
+template <class VoxelType>
+inline irtkScalingAndSquaring<VoxelType> &
+ScalingAndSquaringFilter(irtkScalingAndSquaring<double> *&, std::atomic<bool> &,
+                         ScalingAndSquaringClaim &,
+                         irtkScalingAndSquaring<VoxelType> &local)
+{
+  return local;
+}
+
+// -----------------------------------------------------------------------------
+/// Get scaling and squaring filter for double precision vector fields,
+/// whose workspace is kept for the next exponentiation of the velocities
+///
+/// The shared filter is only used when it is not in use already. Otherwise,
+/// the local filter is returned. This is also the case when the thread which
+/// uses the shared filter steals another exponentiation task while it waits
+/// for its own parallel loops, which must not use the same workspace.
+inline irtkScalingAndSquaring<double> &
+ScalingAndSquaringFilter(irtkScalingAndSquaring<double> *&filter, std::atomic<bool> &in_use,
+                         ScalingAndSquaringClaim &claim,
+                         irtkScalingAndSquaring<double> &local)
+{
+  bool expected = false;
+  if (!in_use.compare_exchange_strong(expected, true)) return local;
+  claim._InUse = &in_use;
+  if (!filter) filter = new irtkScalingAndSquaring<double>;
+  return *filter;
+}
+
 // -----------------------------------------------------------------------------
 template <class VoxelType>
 void irtkBSplineFreeFormTransformationSV
@@ -1067,7 +1151,11 @@ void irtkBSplineFreeFormTransformationSV
       *vz = static_cast<VoxelType>(vp->_z);
     }
     // Exponentiate velocity field
-    irtkScalingAndSquaring<VoxelType> exp;
+    irtkScalingAndSquaring<VoxelType>  filter;
+    ScalingAndSquaringClaim            claim;
+    irtkScalingAndSquaring<VoxelType> &exp = ScalingAndSquaringFilter(_ScalingAndSquaring,
+                                                                      _ScalingAndSquaringInUse,
+                                                                      claim, filter);
     exp.IntegrationLimit  (T);
     exp.NumberOfSteps     (NumberOfStepsForIntervalLength(T));
     exp.MaxScaledVelocity (_MaxScaledVelocity);
@@ -1215,6 +1303,13 @@ void irtkBSplineFreeFormTransformationSV::LocalJacobian(irtkMatrix &jac, double
   }
 }
 
+// -----------------------------------------------------------------------------
+void irtkBSplineFreeFormTransformationSV::LocalJacobian(irtkMatrix3x3 &jac, double x, double y, double z, double t, double t0) const
+{
+  // Jacobian of integrated velocity field
+  irtkTransformation::LocalJacobian(jac, x, y, z, t, t0);
+}
+
 // -----------------------------------------------------------------------------
 void irtkBSplineFreeFormTransformationSV::LocalHessian(irtkMatrix [3], double, double, double, double, double) const
 {
@@ -451,6 +451,11 @@ void irtkBSplineFreeFormTransformationStatistical::WriteSDM(const char *file)
 
   // Write statistical deformation model data
   to << _BasisVectors << _MeanVector;
+
+  if (!to.Close()) {
+    cerr << this->NameOfClass() << "::WriteSDM: Failed to write file " << file << endl;
+    exit(1);
+  }
 }
 
 // -----------------------------------------------------------------------------
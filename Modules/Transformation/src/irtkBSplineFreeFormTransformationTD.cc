@@ -364,6 +364,24 @@ void irtkBSplineFreeFormTransformationTD::LocalTransform(double &x, double &y, d
   }
 }
 
+// -----------------------------------------------------------------------------
+void irtkBSplineFreeFormTransformationTD::TransformBatch(int no, double *x, double *y, double *z, double t, double t0) const
+{
+  if      (_IntegrationMethod == FFDIM_RKE1)   RKE1  ::TransformBatch(this, no, x, y, z, t0, t, _MinTimeStep);
+  else if (_IntegrationMethod == FFDIM_RKE2)   RKE2  ::TransformBatch(this, no, x, y, z, t0, t, _MinTimeStep);
+  else if (_IntegrationMethod == FFDIM_RKH2)   RKH2  ::TransformBatch(this, no, x, y, z, t0, t, _MinTimeStep);
+  else if (_IntegrationMethod == FFDIM_RK4)    RK4   ::TransformBatch(this, no, x, y, z, t0, t, _MinTimeStep);
+  else if (_IntegrationMethod == FFDIM_RKEH12) RKEH12::TransformBatch(this, no, x, y, z, t0, t, _MinTimeStep, _MaxTimeStep, _Tolerance);
+  else if (_IntegrationMethod == FFDIM_RKBS23) RKBS23::TransformBatch(this, no, x, y, z, t0, t, _MinTimeStep, _MaxTimeStep, _Tolerance);
+  else if (_IntegrationMethod == FFDIM_RKF45)  RKF45 ::TransformBatch(this, no, x, y, z, t0, t, _MinTimeStep, _MaxTimeStep, _Tolerance);
+  else if (_IntegrationMethod == FFDIM_RKCK45) RKCK45::TransformBatch(this, no, x, y, z, t0, t, _MinTimeStep, _MaxTimeStep, _Tolerance);
+  else if (_IntegrationMethod == FFDIM_RKDP45) RKDP45::TransformBatch(this, no, x, y, z, t0, t, _MinTimeStep, _MaxTimeStep, _Tolerance);
+  else {
+    cerr << "irtkBSplineFreeFormTransformationTD::TransformBatch: Unknown integration method: " << _IntegrationMethod << endl;
+    exit(1);
+  }
+}
+
 // -----------------------------------------------------------------------------
 void irtkBSplineFreeFormTransformationTD::TransformAndJacobian(irtkMatrix &jac, double &x, double &y, double &z, double t, double t0) const
 {
@@ -17,6 +17,251 @@
 
 #include <irtkImageFastFourierTransform.h>
 
+#include <complex>
+#include <vector>
+#include <map>
+#include <mutex>
+
+// =============================================================================
+// Auxiliary functions and functors
+// =============================================================================
+
+namespace irtkImageFastFourierTransformUtils {
+
+typedef complex<double> Complex;
+
+
+// -----------------------------------------------------------------------------
+/// Precomputed tables for the 1D discrete Fourier transform of a given length
+///
+/// Lengths which are a power of two are transformed by an iterative radix-2
+/// FFT with tabulated bit reversal permutation and twiddle factors. Other
+/// lengths are reduced to a cyclic convolution of power of two length using
+/// Bluestein's chirp z-transform. Plans are immutable after construction and
+/// can thus be shared by all threads.
+class FFTPlan
+{
+  int             _N;        ///< Length of transform
+  vector<int>     _Reverse;  ///< Bit reversal permutation
+  vector<Complex> _Twiddle;  ///< exp(2 pi i k / N) for k < N/2
+  const FFTPlan  *_Inner;    ///< Power of two plan used by Bluestein algorithm
+  vector<Complex> _Chirp;    ///< exp(pi i k^2 / N)
+  vector<Complex> _Kernel;   ///< Transform of conjugate chirp
+
+public:
+
+  // ---------------------------------------------------------------------------
+  FFTPlan(int n) : _N(n), _Inner(NULL)
+  {
+    if ((n & (n - 1)) == 0) {
+      int bits = 0;
+      while ((1 << bits) < n) ++bits;
+      _Reverse.resize(n);
+      for (int i = 0; i < n; ++i) {
+        int r = 0;
+        for (int b = 0; b < bits; ++b) if (i & (1 << b)) r |= 1 << (bits - 1 - b);
+        _Reverse[i] = r;
+      }
+      _Twiddle.resize(n / 2);
+      for (int k = 0; k < n / 2; ++k) _Twiddle[k] = polar(1.0, 2.0 * M_PI * k / n);
+    } else {
+      int m = 1;
+      while (m < 2 * n - 1) m *= 2;
+      _Inner = Instance(m);
+      _Chirp.resize(n);
+      for (int k = 0; k < n; ++k) {
+        // Reduce k^2 modulo 2n to preserve accuracy of the phase angle
+        const long long k2 = (static_cast<long long>(k) * k) % (2LL * n);
+        _Chirp[k] = polar(1.0, M_PI * k2 / n);
+      }
+      _Kernel.assign(m, Complex(0., 0.));
+      _Kernel[0] = conj(_Chirp[0]);
+      for (int k = 1; k < n; ++k) _Kernel[k] = _Kernel[m - k] = conj(_Chirp[k]);
+      _Inner->Execute(&_Kernel[0], +1, NULL);
+    }
+  }
+
+  // ---------------------------------------------------------------------------
+  /// Get shared plan for transforms of length n
+  static const FFTPlan *Instance(int n)
+  {
+    // Recursive mutex because constructor of plan for Bluestein algorithm
+    // requests the inner power of two plan
+    static map<int, FFTPlan *> plans;
+    static recursive_mutex     plans_mutex;
+    lock_guard<recursive_mutex> lock(plans_mutex);
+    FFTPlan *&plan = plans[n];
+    if (plan == NULL) plan = new FFTPlan(n);
+    return plan;
+  }
+
+  // ---------------------------------------------------------------------------
+  /// Number of complex values of scratch memory required by Execute
+  int ScratchSize() const
+  {
+    return _Inner ? static_cast<int>(_Kernel.size()) : 0;
+  }
+
+  // ---------------------------------------------------------------------------
+  /// Replace data by sum_j data[j] exp(isign 2 pi i j k / N) (unnormalized)
+  void Execute(Complex *data, int isign, Complex *scratch) const
+  {
+    if (_Inner) {
+      // Bluestein's algorithm, where the transform with negative sign is
+      // obtained by conjugating the input and output of the positive one
+      const int m = static_cast<int>(_Kernel.size());
+      for (int k = 0; k < _N; ++k) {
+        scratch[k] = (isign < 0 ? conj(data[k]) : data[k]) * _Chirp[k];
+      }
+      for (int k = _N; k < m; ++k) scratch[k] = Complex(0., 0.);
+      _Inner->Execute(scratch, +1, NULL);
+      for (int k = 0; k < m; ++k) scratch[k] = conj(scratch[k] * _Kernel[k]);
+      _Inner->Execute(scratch, +1, NULL);
+      for (int k = 0; k < _N; ++k) {
+        data[k] = conj(scratch[k]) * _Chirp[k] / static_cast<double>(m);
+        if (isign < 0) data[k] = conj(data[k]);
+      }
+    } else {
+      for (int i = 0; i < _N; ++i) {
+        if (i < _Reverse[i]) swap(data[i], data[_Reverse[i]]);
+      }
+      for (int len = 2; len <= _N; len *= 2) {
+        const int half = len / 2, step = _N / len;
+        for (int i = 0; i < _N; i += len) {
+          for (int k = 0; k < half; ++k) {
+            const Complex &w = _Twiddle[k * step];
+            const Complex  t = data[i + k + half] * (isign < 0 ? conj(w) : w);
+            data[i + k + half] = data[i + k] - t;
+            data[i + k]       += t;
+          }
+        }
+      }
+    }
+  }
+};
+
+// -----------------------------------------------------------------------------
+/// Batched 1D transforms of the pencils of a complex image along one axis
+///
+/// The line with index l starts at the voxel with index
+/// (l / _Lines) * _Block + (l % _Lines), and its _Length voxels are _Stride
+/// voxels apart. Each range of lines uses its own line buffer and scratch.
+class FFTPencils
+{
+public:
+
+  float         *_Real;
+  float         *_Imag;
+  long           _Lines;
+  long           _Block;
+  long           _Length;
+  long           _Stride;
+  const FFTPlan *_Plan;
+  int            _Sign;
+  double         _Norm;
+
+  void operator ()(const blocked_range<int> &re) const
+  {
+    vector<Complex> line(_Length), scratch(_Plan->ScratchSize());
+    Complex *tmp = (scratch.empty() ? NULL : &scratch[0]);
+    long i, idx;
+    for (int l = re.begin(); l != re.end(); ++l) {
+      idx = (l / _Lines) * _Block + (l % _Lines);
+      for (i = 0; i < _Length; ++i, idx += _Stride) {
+        line[i] = Complex(_Real[idx], _Imag[idx]);
+      }
+      _Plan->Execute(&line[0], _Sign, tmp);
+      idx = (l / _Lines) * _Block + (l % _Lines);
+      for (i = 0; i < _Length; ++i, idx += _Stride) {
+        _Real[idx] = static_cast<float>(line[i].real() * _Norm);
+        _Imag[idx] = static_cast<float>(line[i].imag() * _Norm);
+      }
+    }
+  }
+};
+
+// -----------------------------------------------------------------------------
+/// Normalized 3D transform of the first frame of a complex image
+void FFT3D(irtkGenericImage<float> *re, irtkGenericImage<float> *im, int isign)
+{
+  const long nx = re->GetX(), ny = re->GetY(), nz = re->GetZ();
+
+  FFTPencils body;
+  body._Real = re->GetPointerToVoxels();
+  body._Imag = im->GetPointerToVoxels();
+  body._Sign = isign;
+
+  // The forward transform proceeds along x, y, z, the inverse along z, y, x
+  for (int i = 0; i < 3; ++i) {
+    const int dim = (isign > 0 ? i : 2 - i);
+    if (dim == 0) {
+      body._Lines = 1;       body._Block = nx;           body._Length = nx; body._Stride = 1;
+    } else if (dim == 1) {
+      body._Lines = nx;      body._Block = nx * ny;      body._Length = ny; body._Stride = nx;
+    } else {
+      body._Lines = nx * ny; body._Block = nx * ny * nz; body._Length = nz; body._Stride = nx * ny;
+    }
+    body._Plan = FFTPlan::Instance(static_cast<int>(body._Length));
+    body._Norm = 1.0 / sqrt(static_cast<double>(body._Length));
+    parallel_for(blocked_range<int>(0, static_cast<int>(nx * ny * nz / body._Length)), body);
+  }
+}
+
+// -----------------------------------------------------------------------------
+/// Multiply (or divide) complex signal by complex filter in Fourier space
+class MultiplySpectra
+{
+public:
+
+  float       *_SignalRe;
+  float       *_SignalIm;
+  const float *_FilterRe;
+  const float *_FilterIm;
+  float        _Scale;
+  bool         _Divide;
+
+  void operator ()(const blocked_range<int> &re) const
+  {
+    float a, b, c, d;
+    for (int idx = re.begin(); idx != re.end(); ++idx) {
+      a = _SignalRe[idx];
+      b = _SignalIm[idx];
+      c = _FilterRe[idx] * _Scale;
+      d = _FilterIm[idx] * _Scale;
+      if (_Divide) {
+        _SignalRe[idx] = (a*c+b*d)/(c*c+d*d);
+        _SignalIm[idx] = (c*b-a*d)/(c*c+d*d);
+      } else {
+        _SignalRe[idx] = a*c-b*d;
+        _SignalIm[idx] = c*b+a*d;
+      }
+    }
+  }
+
+  static void Run(irtkGenericImage<float> *sre, irtkGenericImage<float> *sim,
+                  irtkGenericImage<float> *fre, irtkGenericImage<float> *fim,
+                  bool divide)
+  {
+    MultiplySpectra body;
+    body._SignalRe = sre->GetPointerToVoxels();
+    body._SignalIm = sim->GetPointerToVoxels();
+    body._FilterRe = fre->GetPointerToVoxels();
+    body._FilterIm = fim->GetPointerToVoxels();
+    body._Scale    = (float)(sqrt((double)sre->GetX())*sqrt((double)sre->GetY())*sqrt((double)sre->GetZ()));
+    body._Divide   = divide;
+    parallel_for(blocked_range<int>(0, sre->GetX() * sre->GetY() * sre->GetZ()), body);
+  }
+};
+
+
+} // namespace irtkImageFastFourierTransformUtils
+using namespace irtkImageFastFourierTransformUtils;
+
+// =============================================================================
+// Fast Fourier transform
+// =============================================================================
+
+// -----------------------------------------------------------------------------
 void four1NR(float * data, unsigned long nn, int isign)
 {
   unsigned long n,mmax,m,j,istep,i;
@@ -63,261 +308,75 @@ void four1NR(float * data, unsigned long nn, int isign)
   }
 }
 
-
-
+// -----------------------------------------------------------------------------
 void DirectFFT(irtkGenericImage<float> * RealSignal,irtkGenericImage<float> * ImaginarySignal){
-  int SizeX,SizeY,SizeZ;
-  float SqrtSizeX,SqrtSizeY,SqrtSizeZ;
-  int x,y,z;
-  float * dataX;
-  float * dataY;
-  float * dataZ;
-  
-  //1) extract the size of the images
-  SizeX=RealSignal->GetX();
-  SizeY=RealSignal->GetY();
-  SizeZ=RealSignal->GetZ();
-  
-  SqrtSizeX=static_cast<float>(sqrt(static_cast<double>(SizeX)));
-  SqrtSizeY=static_cast<float>(sqrt(static_cast<double>(SizeY)));
-  SqrtSizeZ=static_cast<float>(sqrt(static_cast<double>(SizeZ)));
-
-  
-  //2) perform the fft along x axis
-  dataX = new float [SizeX*2+1];
-  for (z = 0; z < SizeZ; z++) for (y = 0; y < SizeY; y++){
-    for (x = 0; x < SizeX; x++){
-      dataX[2*x+1]=RealSignal->Get(x, y, z, 0);
-      dataX[2*x+2]=ImaginarySignal->Get(x, y, z, 0);
-    }
-    four1NR(dataX, (unsigned long)SizeX, 1);
-    for (x = 0; x < SizeX; x++){
-      RealSignal->Put(x, y, z, 0,dataX[2*x+1]/SqrtSizeX);
-      ImaginarySignal->Put(x, y, z, 0,dataX[2*x+2]/SqrtSizeX);
-    }
-  }
-  delete dataX;
-  
-  //3) perform the fft along y axis
-  dataY = new float [SizeY*2+1];
-  for (z = 0; z < SizeZ; z++) for (x = 0; x < SizeX; x++){
-    for (y = 0; y < SizeY; y++){
-      dataY[2*y+1]=RealSignal->Get(x, y, z, 0);
-      dataY[2*y+2]=ImaginarySignal->Get(x, y, z, 0);
-    }
-    four1NR(dataY, (unsigned long)SizeY, 1);
-    for (y = 0; y < SizeY; y++){
-      RealSignal->Put(x, y, z, 0,dataY[2*y+1]/SqrtSizeY);
-      ImaginarySignal->Put(x, y, z, 0,dataY[2*y+2]/SqrtSizeY);
-    }
-  }
-  delete dataY;
-  
-  
-  //4) perform the fft along z axis
-  dataZ = new float [SizeZ*2+1];
-  for (y = 0; y < SizeY; y++) for (x = 0; x < SizeX; x++){
-    for (z = 0; z < SizeZ; z++){
-      dataZ[2*z+1]=RealSignal->Get(x, y, z, 0);
-      dataZ[2*z+2]=ImaginarySignal->Get(x, y, z, 0);
-    }
-    four1NR(dataZ, (unsigned long)SizeZ, 1);
-    for (z = 0; z < SizeZ; z++){
-      RealSignal->Put(x, y, z, 0,dataZ[2*z+1]/SqrtSizeZ);
-      ImaginarySignal->Put(x, y, z, 0,dataZ[2*z+2]/SqrtSizeZ);
-    }
-  }
-  delete dataZ;
+  FFT3D(RealSignal, ImaginarySignal, 1);
 }
 
-
+// -----------------------------------------------------------------------------
 void InverseFFT(irtkGenericImage<float> * RealSignal,irtkGenericImage<float> * ImaginarySignal){
-  int SizeX,SizeY,SizeZ;
-  float SqrtSizeX,SqrtSizeY,SqrtSizeZ;
-  int x,y,z;
-  float * dataX;
-  float * dataY;
-  float * dataZ;
-  
-  //1) extract the size of the images
-  SizeX=RealSignal->GetX();
-  SizeY=RealSignal->GetY();
-  SizeZ=RealSignal->GetZ();
-  
-  SqrtSizeX=static_cast<float>(sqrt(static_cast<double>(SizeX)));
-  SqrtSizeY=static_cast<float>(sqrt(static_cast<double>(SizeY)));
-  SqrtSizeZ=static_cast<float>(sqrt(static_cast<double>(SizeZ)));
-  
-  
-  //2) perform the ifft along z axis
-  dataZ = new float [SizeZ*2+1];
-  for (y = 0; y < SizeY; y++) for (x = 0; x < SizeX; x++){
-    for (z = 0; z < SizeZ; z++){
-      dataZ[2*z+1]=RealSignal->Get(x, y, z, 0);
-      dataZ[2*z+2]=ImaginarySignal->Get(x, y, z, 0);
-    }
-    four1NR(dataZ, (unsigned long)SizeZ, -1);
-    for (z = 0; z < SizeZ; z++){
-      RealSignal->Put(x, y, z, 0,dataZ[2*z+1]/SqrtSizeZ);
-      ImaginarySignal->Put(x, y, z, 0,dataZ[2*z+2]/SqrtSizeZ);
-    }
-  }
-  delete dataZ;
-  
-  //3) perform the ifft along y axis
-  dataY = new float [SizeY*2+1];
-  for (z = 0; z < SizeZ; z++) for (x = 0; x < SizeX; x++){
-    for (y = 0; y < SizeY; y++){
-      dataY[2*y+1]=RealSignal->Get(x, y, z, 0);
-      dataY[2*y+2]=ImaginarySignal->Get(x, y, z, 0);
-    }
-    four1NR(dataY, (unsigned long)SizeY, -1);
-    for (y = 0; y < SizeY; y++){
-      RealSignal->Put(x, y, z, 0,dataY[2*y+1]/SqrtSizeY);
-      ImaginarySignal->Put(x, y, z, 0,dataY[2*y+2]/SqrtSizeY);
-    }
-  }
-  delete dataY;
-  
-  //4) perform the ifft along x axis
-  dataX = new float [SizeX*2+1];
-  for (z = 0; z < SizeZ; z++) for (y = 0; y < SizeY; y++){
-    for (x = 0; x < SizeX; x++){
-      dataX[2*x+1]=RealSignal->Get(x, y, z, 0);
-      dataX[2*x+2]=ImaginarySignal->Get(x, y, z, 0);
-    }
-    four1NR(dataX, (unsigned long)SizeX, -1);
-    for (x = 0; x < SizeX; x++){
-      RealSignal->Put(x, y, z, 0,dataX[2*x+1]/SqrtSizeX);
-      ImaginarySignal->Put(x, y, z, 0,dataX[2*x+2]/SqrtSizeX);
-    }
-  }
-  delete dataX;
+  FFT3D(RealSignal, ImaginarySignal, -1);
 }
 
+// =============================================================================
+// Convolution in Fourier space
+// =============================================================================
+
+// -----------------------------------------------------------------------------
 void ConvolutionInFourier(irtkGenericImage<float> * RealPartSignal,irtkGenericImage<float> * ImaginaryPartSignal,irtkGenericImage<float> * RealPartFilter,irtkGenericImage<float> * ImaginaryPartFilter){
-  int x,y,z;
-  float a,b,c,d;
-  float CoefMult;
-  
-  
   //1) FFT
   DirectFFT(RealPartSignal,ImaginaryPartSignal);
   DirectFFT(RealPartFilter,ImaginaryPartFilter);
-  
+
   //2) filtering in Fourier spaces
-  CoefMult=(float)(sqrt((double)RealPartSignal->GetX())*sqrt((double)RealPartSignal->GetY())*sqrt((double)RealPartSignal->GetZ()));
-  
-  for (z = 0; z < RealPartSignal->GetZ(); z++) for (y = 0; y < RealPartSignal->GetY(); y++) for (x = 0; x < RealPartSignal->GetX(); x++){
-    a=RealPartSignal->Get(x, y, z, 0);
-    b=ImaginaryPartSignal->Get(x, y, z, 0);
-    c=RealPartFilter->Get(x, y, z, 0)*CoefMult;
-    d=ImaginaryPartFilter->Get(x, y, z, 0)*CoefMult;
-    
-    RealPartSignal->Put(x, y, z, 0, a*c-b*d);
-    ImaginaryPartSignal->Put(x, y, z, 0, c*b+a*d);
-  }
-  
+  MultiplySpectra::Run(RealPartSignal,ImaginaryPartSignal,RealPartFilter,ImaginaryPartFilter,false);
+
   //3) IFFT
   InverseFFT(RealPartSignal,ImaginaryPartSignal);
   InverseFFT(RealPartFilter,ImaginaryPartFilter);
 }
 
-
+// -----------------------------------------------------------------------------
 void ConvolutionInFourierNoFilterTransfo(irtkGenericImage<float> * RealPartSignal,irtkGenericImage<float> * ImaginaryPartSignal,irtkGenericImage<float> * RealPartFilterTransformedFrSpace,irtkGenericImage<float> * ImaginaryPartFilterTransformedFrSpace){
-  int x,y,z;
-  float a,b,c,d;
-  float CoefMult;
-  
-  
   //1) FFT
   DirectFFT(RealPartSignal,ImaginaryPartSignal);
-  
+
   //2) filtering in Fourier spaces
-  CoefMult=(float)(sqrt((double)RealPartSignal->GetX())*sqrt((double)RealPartSignal->GetY())*sqrt((double)RealPartSignal->GetZ()));
-  
-  for (z = 0; z < RealPartSignal->GetZ(); z++) for (y = 0; y < RealPartSignal->GetY(); y++) for (x = 0; x < RealPartSignal->GetX(); x++){
-    a=RealPartSignal->Get(x, y, z, 0);
-    b=ImaginaryPartSignal->Get(x, y, z, 0);
-    c=RealPartFilterTransformedFrSpace->Get(x, y, z, 0)*CoefMult;
-    d=ImaginaryPartFilterTransformedFrSpace->Get(x, y, z, 0)*CoefMult;
-    
-    RealPartSignal->Put(x, y, z, 0, a*c-b*d);
-    ImaginaryPartSignal->Put(x, y, z, 0, c*b+a*d);
-  }
-  
+  MultiplySpectra::Run(RealPartSignal,ImaginaryPartSignal,RealPartFilterTransformedFrSpace,ImaginaryPartFilterTransformedFrSpace,false);
+
   //3) IFFT
   InverseFFT(RealPartSignal,ImaginaryPartSignal);
 }
 
-
-
-
-
-
-
+// -----------------------------------------------------------------------------
 void DeconvolutionInFourier(irtkGenericImage<float> * RealPartSignal,irtkGenericImage<float> * ImaginaryPartSignal,irtkGenericImage<float> * RealPartFilter,irtkGenericImage<float> * ImaginaryPartFilter){
-  int x,y,z;
-  float a,b,c,d;
-  float CoefMult;
-  
-  
   //1) FFT
   DirectFFT(RealPartSignal,ImaginaryPartSignal);
   DirectFFT(RealPartFilter,ImaginaryPartFilter);
-  
+
   //2) filtering in Fourier spaces
-  CoefMult=(float)(sqrt((double)RealPartSignal->GetX())*sqrt((double)RealPartSignal->GetY())*sqrt((double)RealPartSignal->GetZ()));
-  
-  for (z = 0; z < RealPartSignal->GetZ(); z++) for (y = 0; y < RealPartSignal->GetY(); y++) for (x = 0; x < RealPartSignal->GetX(); x++){
-    a=RealPartSignal->Get(x, y, z, 0);
-    b=ImaginaryPartSignal->Get(x, y, z, 0);
-    c=RealPartFilter->Get(x, y, z, 0)*CoefMult;
-    d=ImaginaryPartFilter->Get(x, y, z, 0)*CoefMult;
-    
-    RealPartSignal->Put(x, y, z, 0, (a*c+b*d)/(c*c+d*d));
-    ImaginaryPartSignal->Put(x, y, z, 0, (c*b-a*d)/(c*c+d*d));
-  }
-  
+  MultiplySpectra::Run(RealPartSignal,ImaginaryPartSignal,RealPartFilter,ImaginaryPartFilter,true);
+
   //3) IFFT
   InverseFFT(RealPartSignal,ImaginaryPartSignal);
   InverseFFT(RealPartFilter,ImaginaryPartFilter);
 }
 
-
-
-
-
+// -----------------------------------------------------------------------------
 void DeconvolutionInFourierNoFilterTransfo(irtkGenericImage<float> * RealPartSignal,irtkGenericImage<float> * ImaginaryPartSignal,irtkGenericImage<float> * RealPartFilterTransformedFrSpace,irtkGenericImage<float> * ImaginaryPartFilterTransformedFrSpace){
-  int x,y,z;
-  float a,b,c,d;
-  float CoefMult;
-  
-  
   //1) FFT
   DirectFFT(RealPartSignal,ImaginaryPartSignal);
-  
+
   //2) filtering in Fourier spaces
-  CoefMult=(float)(sqrt((double)RealPartSignal->GetX())*sqrt((double)RealPartSignal->GetY())*sqrt((double)RealPartSignal->GetZ()));
-  
-  for (z = 0; z < RealPartSignal->GetZ(); z++) for (y = 0; y < RealPartSignal->GetY(); y++) for (x = 0; x < RealPartSignal->GetX(); x++){
-    a=RealPartSignal->Get(x, y, z, 0);
-    b=ImaginaryPartSignal->Get(x, y, z, 0);
-    c=RealPartFilterTransformedFrSpace->Get(x, y, z, 0)*CoefMult;
-    d=ImaginaryPartFilterTransformedFrSpace->Get(x, y, z, 0)*CoefMult;
-    
-    RealPartSignal->Put(x, y, z, 0, (a*c+b*d)/(c*c+d*d));
-    ImaginaryPartSignal->Put(x, y, z, 0, (c*b-a*d)/(c*c+d*d));
-  }
-  
+  MultiplySpectra::Run(RealPartSignal,ImaginaryPartSignal,RealPartFilterTransformedFrSpace,ImaginaryPartFilterTransformedFrSpace,true);
+
   //3) IFFT
   InverseFFT(RealPartSignal,ImaginaryPartSignal);
 }
 
-
-
-
-
+// =============================================================================
+// Filters
+// =============================================================================
 
 void MakeGaussianFilter(float sigma,irtkGenericImage<float> * RealPartFilter,irtkGenericImage<float> * ImaginaryPartFilter){
   int x,y,z;
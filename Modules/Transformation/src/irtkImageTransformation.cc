@@ -51,7 +51,8 @@ irtkImageTransformation::irtkImageTransformation()
   _InputTimeOffset  = .0;
 
   // Set invert mode
-  _Invert = false;
+  _Invert              = false;
+  _FixedPointInversion = false;
 
   // Set 2D mode
   _2D = false;
@@ -236,6 +237,15 @@ void irtkImageTransformation::InvertOff()
   }
 }
 
+// -----------------------------------------------------------------------------
+void irtkImageTransformation::FixedPointInversion(bool fixed_point)
+{
+  if (_FixedPointInversion != fixed_point) {
+    if (_Cache && _Invert) _Cache->Modified(true);
+    _FixedPointInversion = fixed_point;
+  }
+}
+
 // -----------------------------------------------------------------------------
 void irtkImageTransformation::TwoDOn()
 {
@@ -282,7 +292,8 @@ void irtkImageTransformation::Initialize()
 
   _NumberOfSingularPoints = 0;
 
-  if (_transformation->RequiresCachingOfDisplacements() && !_Cache) {
+  if ((_transformation->RequiresCachingOfDisplacements() ||
+       (_Invert && _FixedPointInversion)) && !_Cache) {
     _CacheOwner = true;
     _Cache      = new irtkImageTransformationCache();
     _Cache->Initialize(_output->GetImageAttributes(), 3);
@@ -297,7 +308,9 @@ void irtkImageTransformation::Initialize()
       const double t  = _input->GetTOrigin();
 
       _Cache->Initialize();
-      if (_Invert) {
+      if (_Invert && _FixedPointInversion) {
+        _NumberOfSingularPoints = _transformation->FixedPointInverseDisplacement(*_Cache, t, t0);
+      } else if (_Invert) {
         _NumberOfSingularPoints = _transformation->InverseDisplacement(*_Cache, t, t0);
       } else {
         _transformation->Displacement(*_Cache, t, t0);
@@ -332,6 +332,12 @@ void irtkLinearFreeFormTransformation3D
 // Properties
 // =============================================================================
 
+// -----------------------------------------------------------------------------
+bool irtkLinearFreeFormTransformation3D::IsDisplacementParameterized() const
+{
+  return true;
+}
+
 // -----------------------------------------------------------------------------
 int irtkLinearFreeFormTransformation3D::KernelSize() const
 {
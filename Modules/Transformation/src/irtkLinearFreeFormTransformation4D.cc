@@ -391,6 +391,12 @@ void irtkLinearFreeFormTransformation4D
 // Properties
 // =============================================================================
 
+// -----------------------------------------------------------------------------
+bool irtkLinearFreeFormTransformation4D::IsDisplacementParameterized() const
+{
+  return true;
+}
+
 // -----------------------------------------------------------------------------
 int irtkLinearFreeFormTransformation4D::KernelSize() const
 {
@@ -57,24 +57,180 @@ irtkMultiLevelFreeFormTransformation::~irtkMultiLevelFreeFormTransformation()
 // Levels
 // =============================================================================
 
+// -----------------------------------------------------------------------------
+namespace irtkMultiLevelFreeFormTransformationUtils {
+
+// -----------------------------------------------------------------------------
+/// Determine in which dimensions a lattice must be subdivided next
+/// in order to approach the control point spacing of the target lattice
+inline bool NextSubdivision(const irtkImageAttributes &attr,
+                            const irtkImageAttributes &target,
+                            bool &sx, bool &sy, bool &sz)
+{
+  sx = (attr._x > 1 && attr._dx > target._dx && !fequal(attr._dx, target._dx));
+  sy = (attr._y > 1 && attr._dy > target._dy && !fequal(attr._dy, target._dy));
+  sz = (attr._z > 1 && attr._dz > target._dz && !fequal(attr._dz, target._dz));
+  return sx || sy || sz;
+}
+
+// -----------------------------------------------------------------------------
+/// Whether repeated subdivision of the first lattice yields the second lattice
+bool IsSubdivisionOf(irtkImageAttributes attr, const irtkImageAttributes &target)
+{
+  bool sx, sy, sz;
+  while (NextSubdivision(attr, target, sx, sy, sz)) {
+    if (sx) attr._x = 2 * attr._x - 1, attr._dx *= .5;
+    if (sy) attr._y = 2 * attr._y - 1, attr._dy *= .5;
+    if (sz) attr._z = 2 * attr._z - 1, attr._dz *= .5;
+  }
+  return attr == target;
+}
+
+// -----------------------------------------------------------------------------
+/// Extend lattice by the given number of control points on each side
+inline irtkImageAttributes PadLattice(irtkImageAttributes attr, int n)
+{
+  if (attr._x > 1) attr._x += 2 * n;
+  if (attr._y > 1) attr._y += 2 * n;
+  if (attr._z > 1) attr._z += 2 * n;
+  return attr;
+}
+
+// -----------------------------------------------------------------------------
+/// Copy coefficients to a lattice with same spacing and center, but different
+/// size, where coefficients outside the input lattice are extrapolated
+void ResizeLattice(const irtkFreeFormTransformation *input,
+                   irtkFreeFormTransformation       *output)
+{
+  typedef irtkFreeFormTransformation::CPExtrapolator CPExtrapolator;
+  typedef irtkFreeFormTransformation::Vector         Vector;
+  const CPExtrapolator *cp = input->Extrapolator();
+  const int di = (output->X() - input->X()) / 2;
+  const int dj = (output->Y() - input->Y()) / 2;
+  const int dk = (output->Z() - input->Z()) / 2;
+  Vector v;
+  int     ci, cj, ck;
+  double  x, y, z;
+  for (int k = 0; k < output->Z(); ++k)
+  for (int j = 0; j < output->Y(); ++j)
+  for (int i = 0; i < output->X(); ++i) {
+    ci = i - di, cj = j - dj, ck = k - dk;
+    if (0 <= ci && ci < input->X() &&
+        0 <= cj && cj < input->Y() &&
+        0 <= ck && ck < input->Z()) {
+      input->Get(ci, cj, ck, x, y, z);
+    } else if (cp) {
+      v = cp->Get(ci, cj, ck);
+      x = v._x, y = v._y, z = v._z;
+    } else {
+      x = y = z = .0;
+    }
+    output->Put(i, j, k, x, y, z);
+  }
+}
+
+// -----------------------------------------------------------------------------
+/// Whether the coefficients of two local transformations can be summed
+/// after subdividing the lattice of the first one as needed
+bool CanAddTo(const irtkFreeFormTransformation *ffd,
+              const irtkFreeFormTransformation *target)
+{
+  if (strcmp(ffd->NameOfClass(), target->NameOfClass()) != 0) return false;
+  if (!ffd->IsDisplacementParameterized()) return false;
+  if (ffd->Attributes() == target->Attributes()) return true;
+  return ffd->CanSubdivide() && IsSubdivisionOf(ffd->Attributes(), target->Attributes());
+}
+
+// -----------------------------------------------------------------------------
+/// Add coefficients of one local transformation to those of another
+class AddDOFs
+{
+  const irtkFreeFormTransformation *_Input;
+  irtkFreeFormTransformation       *_Output;
+
+public:
+
+  AddDOFs(const irtkFreeFormTransformation *input, irtkFreeFormTransformation *output)
+  :
+    _Input(input), _Output(output)
+  {}
+
+  void operator ()(const blocked_range<int> &re) const
+  {
+    for (int dof = re.begin(); dof != re.end(); ++dof) {
+      _Output->Put(dof, _Output->Get(dof) + _Input->Get(dof));
+    }
+  }
+};
+
+
+} // namespace irtkMultiLevelFreeFormTransformationUtils
+using namespace irtkMultiLevelFreeFormTransformationUtils;
+
+// -----------------------------------------------------------------------------
+bool irtkMultiLevelFreeFormTransformation::CanCombineLocalTransformation() const
+{
+  if (_NumberOfLevels < 2) return true;
+  const irtkFreeFormTransformation *finest = _LocalTransformation[_NumberOfLevels-1];
+  if (!finest->IsDisplacementParameterized()) return false;
+  for (int l = 0; l < _NumberOfLevels - 1; ++l) {
+    if (!CanAddTo(_LocalTransformation[l], finest)) return false;
+  }
+  return true;
+}
+
 // -----------------------------------------------------------------------------
 void irtkMultiLevelFreeFormTransformation::CombineLocalTransformation()
 {
-  irtkFreeFormTransformation *first = NULL, *second = NULL;
-  while (_NumberOfLevels > 1) {
-    first  = this->PopLocalTransformation();
-    second = this->PopLocalTransformation();
-    if (first->NumberOfDOFs() == second->NumberOfDOFs()) {
-      for (int i = 0; i < first->NumberOfDOFs(); ++i) {
-        second->Put(i, first->Get(i) + second->Get(i));
-      }
+  if (_NumberOfLevels < 2) return;
+  if (!this->CanCombineLocalTransformation()) {
+    cerr << this->NameOfClass() << "::CombineLocalTransformation: Only implemented for displacement"
+            " FFDs of the same type whose lattices are equal or subdivisions of each other" << endl;
+    exit(1);
+  }
+  const irtkImageAttributes &finest = _LocalTransformation[_NumberOfLevels-1]->Attributes();
+  bool subdivide = false;
+  for (int l = 0; l < _NumberOfLevels - 1; ++l) {
+    if (_LocalTransformation[l]->Attributes() != finest) subdivide = true;
+  }
+  // Sum coefficients of local transformations defined on the same lattice
+  if (!subdivide) {
+    irtkFreeFormTransformation *first = NULL, *second = NULL;
+    while (_NumberOfLevels > 1) {
+      first  = this->PopLocalTransformation();
+      second = this->PopLocalTransformation();
+      parallel_for(blocked_range<int>(0, second->NumberOfDOFs()), AddDOFs(first, second));
+      this->PushLocalTransformation(second);
+      delete first;
+    }
+    return;
+  }
+  // Otherwise, subdivide coarser levels to the finest control point spacing.
+  // The merged lattice is extended by one control point on each side such that
+  // the coefficients which are extrapolated by the individual levels near the
+  // boundary are represented exactly by the merged free-form deformation.
+  const irtkImageAttributes lattice = PadLattice(finest, 1);
+  irtkFreeFormTransformation *merged = NULL, *level = NULL, *padded = NULL;
+  bool sx, sy, sz;
+  while (_NumberOfLevels > 0) {
+    level  = this->PopLocalTransformation();
+    padded = dynamic_cast<irtkFreeFormTransformation *>(irtkTransformation::New(level));
+    padded->Initialize(PadLattice(level->Attributes(), 1));
+    ResizeLattice(level, padded);
+    while (NextSubdivision(padded->Attributes(), lattice, sx, sy, sz)) {
+      padded->Subdivide(sx, sy, sz, false);
+    }
+    level->Initialize(lattice);
+    ResizeLattice(padded, level);
+    if (merged) {
+      parallel_for(blocked_range<int>(0, merged->NumberOfDOFs()), AddDOFs(level, merged));
+      delete level;
     } else {
-      cerr << this->NameOfClass() << "::CombineLocalTransformation: Only implemented for transformations with equal number of DOFs" << endl;
-      exit(1);
+      merged = level;
     }
-    this->PushLocalTransformation(second);
-    delete first;
+    delete padded;
   }
+  this->PushLocalTransformation(merged);
 }
 
 // -----------------------------------------------------------------------------
@@ -501,6 +657,44 @@ void irtkMultiLevelFreeFormTransformation::Transform(int m, int n, double &x, do
   x += dx, y += dy, z += dz;
 }
 
+// -----------------------------------------------------------------------------
+void irtkMultiLevelFreeFormTransformation
+::TransformBatch(int m, int n, int no, double *x, double *y, double *z, double t, double t0) const
+{
+  using irtkTransformationUtils::BatchSize;
+
+  if (n < 0 || n > _NumberOfLevels) n = _NumberOfLevels;
+  const int l1 = (m < 0 ? 0 : m);
+
+  double u [BatchSize], v [BatchSize], w [BatchSize];
+  double dx[BatchSize], dy[BatchSize], dz[BatchSize];
+
+  for (int i = 0, b; i < no; i += b, x += b, y += b, z += b) {
+    b = min(no - i, BatchSize);
+    // Sum displacements of local transformations
+    memset(dx, 0, b * sizeof(double));
+    memset(dy, 0, b * sizeof(double));
+    memset(dz, 0, b * sizeof(double));
+    for (int l = l1; l < n; ++l) {
+      memcpy(u, x, b * sizeof(double));
+      memcpy(v, y, b * sizeof(double));
+      memcpy(w, z, b * sizeof(double));
+      _LocalTransformation[l]->TransformBatch(b, u, v, w, t, t0);
+      for (int j = 0; j < b; ++j) {
+        dx[j] += (u[j] - x[j]);
+        dy[j] += (v[j] - y[j]);
+        dz[j] += (w[j] - z[j]);
+      }
+    }
+    // Global transformation
+    if (m < 0) _GlobalTransformation.TransformBatch(b, x, y, z, t, t0);
+    // Apply local displacements
+    for (int j = 0; j < b; ++j) {
+      x[j] += dx[j], y[j] += dy[j], z[j] += dz[j];
+    }
+  }
+}
+
 // -----------------------------------------------------------------------------
 void irtkMultiLevelFreeFormTransformation::Displacement(int m, int n, irtkGenericImage<double> &disp, double t, double t0, const irtkWorldCoordsImage *wc) const
 {
@@ -655,55 +655,60 @@ public:
   double                              _SourceTime;
   int                                 _M, _N;
 
+  // ---------------------------------------------------------------------------
+  /// Evaluate transformation at displacement field voxels in one image row
+  void EvaluateRow(int i1, int i2, int j, int k, bool is3D,
+                   double *x, double *y, double *z,
+                   double *u, double *v, double *w) const
+  {
+    const int n = i2 - i1;
+    // Transform points into world coordinates and apply current displacement
+    for (int i = i1, idx = 0; i < i2; ++i, ++idx) {
+      x[idx] = i, y[idx] = j, z[idx] = k;
+      _Output->ImageToWorld(x[idx], y[idx], z[idx]);
+      u[idx] = x[idx] + _Output->Get(i, j, k, 0);
+      v[idx] = y[idx] + _Output->Get(i, j, k, 1);
+      w[idx] = z[idx] + (is3D ? _Output->Get(i, j, k, 2) : .0);
+    }
+    // Transform points
+    _Transformation->TransformBatch(_M, _N, n, u, v, w, _SourceTime, _TargetTime);
+    // Update displacement
+    for (int i = i1, idx = 0; i < i2; ++i, ++idx) {
+      _Output->Put(i, j, k, 0, u[idx] - x[idx]);
+      _Output->Put(i, j, k, 1, v[idx] - y[idx]);
+      if (is3D) _Output->Put(i, j, k, 2, w[idx] - z[idx]);
+    }
+  }
+
   // ---------------------------------------------------------------------------
   /// Evaluate transformation at displacement field voxels in 2D
   void operator() (const blocked_range2d<int>& r) const
   {
-    double x,  y, z;
-    double dx, dy;
-
-    for (int j = r.rows().begin(); j != r.rows().end(); ++j)
-    for (int i = r.cols().begin(); i != r.cols().end(); ++i) {
-      // Transform point into world coordinates
-      x = i, y = j, z = 0;
-      _Output->ImageToWorld(x, y, z);
-      // Apply current displacement
-      dx = _Output->Get(i, j, 0, 0);
-      dy = _Output->Get(i, j, 0, 1);
-      x += dx, y += dy;
-      // Calculate displacement
-      _Transformation->Displacement(_M, _N, x, y, z, _SourceTime, _TargetTime);
-      // Update displacement
-      _Output->Put(i, j, 0, 0, x + dx);
-      _Output->Put(i, j, 0, 1, y + dy);
+    const int i1 = r.cols().begin();
+    const int i2 = r.cols().end();
+    double *x = new double[6 * (i2 - i1)];
+    double *y = x + (i2 - i1), *z = y + (i2 - i1);
+    double *u = z + (i2 - i1), *v = u + (i2 - i1), *w = v + (i2 - i1);
+    for (int j = r.rows().begin(); j != r.rows().end(); ++j) {
+      EvaluateRow(i1, i2, j, 0, false, x, y, z, u, v, w);
     }
+    delete[] x;
   }
 
   // ---------------------------------------------------------------------------
   /// Evaluate transformation at displacement field voxels in 3D
   void operator() (const blocked_range3d<int>& r) const
   {
-    double x,  y,  z;
-    double dx, dy, dz;
-
+    const int i1 = r.cols().begin();
+    const int i2 = r.cols().end();
+    double *x = new double[6 * (i2 - i1)];
+    double *y = x + (i2 - i1), *z = y + (i2 - i1);
+    double *u = z + (i2 - i1), *v = u + (i2 - i1), *w = v + (i2 - i1);
     for (int k = r.pages().begin(); k != r.pages().end(); ++k)
-    for (int j = r.rows ().begin(); j != r.rows ().end(); ++j)
-    for (int i = r.cols ().begin(); i != r.cols ().end(); ++i) {
-      // Transform point into world coordinates
-      x = i, y = j, z = k;
-      _Output->ImageToWorld(x, y, z);
-      // Apply current displacement
-      dx = _Output->Get(i, j, k, 0);
-      dy = _Output->Get(i, j, k, 1);
-      dz = _Output->Get(i, j, k, 2);
-      x += dx, y += dy, z += dz;
-      // Calculate displacement
-      _Transformation->Displacement(_M, _N, x, y, z, _SourceTime, _TargetTime);
-      // Update displacement
-      _Output->Put(i, j, k, 0, x + dx);
-      _Output->Put(i, j, k, 1, y + dy);
-      _Output->Put(i, j, k, 2, z + dz);
+    for (int j = r.rows ().begin(); j != r.rows ().end(); ++j) {
+      EvaluateRow(i1, i2, j, k, _Output->GetT() > 2, x, y, z, u, v, w);
     }
+    delete[] x;
   }
 
 };
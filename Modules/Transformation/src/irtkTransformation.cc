@@ -293,6 +293,23 @@ irtkTransformation *irtkTransformation::New(const irtkTransformation *t)
   }
 }
 
+// -----------------------------------------------------------------------------
+bool irtkTransformation::CheckHeader(const char *name)
+{
+  // irtkCifstream::Open exits if the file cannot be opened
+  FILE *fp = fopen(name, "rb");
+  if (fp == NULL) return false;
+  fclose(fp);
+
+  irtkCifstream from;
+  from.Open(name);
+  unsigned int magic_no = 0;
+  const bool ok = from.ReadAsUInt(&magic_no, 1);
+  from.Close();
+
+  return ok && magic_no == IRTKTRANSFORMATION_MAGIC;
+}
+
 // -----------------------------------------------------------------------------
 irtkTransformation *irtkTransformation::New(const char *name)
 {
@@ -1168,6 +1185,29 @@ void irtkTransformation::Transform(irtkWorldCoordsImage &coords, double t0) cons
   parallel_for(blocked_range<int>(0, coords.NumberOfSpatialVoxels()), transform);
 }
 
+// -----------------------------------------------------------------------------
+void irtkTransformation::TransformBatch(int no, double *x, double *y, double *z, double t, double t0) const
+{
+  for (int i = 0; i < no; ++i) this->Transform(x[i], y[i], z[i], t, t0);
+}
+
+// -----------------------------------------------------------------------------
+void irtkTransformation::DisplacementBatch(int no, double *x, double *y, double *z, double t, double t0) const
+{
+  using irtkTransformationUtils::BatchSize;
+  double u[BatchSize], v[BatchSize], w[BatchSize];
+  for (int i = 0, n; i < no; i += n, x += n, y += n, z += n) {
+    n = min(no - i, BatchSize);
+    memcpy(u, x, n * sizeof(double));
+    memcpy(v, y, n * sizeof(double));
+    memcpy(w, z, n * sizeof(double));
+    this->TransformBatch(n, x, y, z, t, t0);
+    for (int j = 0; j < n; ++j) {
+      x[j] -= u[j], y[j] -= v[j], z[j] -= w[j];
+    }
+  }
+}
+
 // -----------------------------------------------------------------------------
 /// Voxel function used to convert transformation to dense displacement field
 class irtkTransformationToDisplacementField : public irtkVoxelFunction
@@ -1246,59 +1286,87 @@ void irtkTransformation::Displacement(const irtkImageAttributes &domain,
 }
 
 // -----------------------------------------------------------------------------
-/// Voxel function used to convert transformation to dense 3D displacement field
-struct irtkTransformationToDisplacementImage : public irtkVoxelFunction
+/// Body of irtkTransformation::Displacement for dense 2D/3D displacement fields
+///
+/// The displacements are evaluated one image row at a time using
+/// irtkTransformation::DisplacementBatch such that the transformation is
+/// only looked up once per row instead of once per voxel.
+template <class TReal>
+class irtkTransformationToDisplacementImage
 {
-  const irtkTransformation *_Transformation;
-  irtkBaseImage            *_Displacement;
-  double                    _TargetTime;
-  double                    _SourceTime;
+  const irtkTransformation   *_Transformation;
+  irtkGenericImage<TReal>    *_Displacement;
+  const irtkWorldCoordsImage *_WorldCoords;
+  double                      _TargetTime;
+  double                      _SourceTime;
 
-  void Initialize()
-  {
-    _x = 0;
-    _y = _Displacement->GetX() * _Displacement->GetY() * _Displacement->GetZ();
-    if (_Displacement->GetT() == 2) _z = 0;       // 2D vectors only
-    else                            _z = _y + _y; // 2 * number of voxels
-  }
+public:
 
-  template <class TReal>
-  void operator ()(int i, int j, int k, int, TReal *disp)
-  {
-    // Transform point into world coordinates
-    double x = i, y = j, z = (_z != 0 ? k : .0);
-    _Displacement->ImageToWorld(x, y, z);
-    // Apply current displacement
-    x += disp[_x];
-    y += disp[_y];
-    if (_z != 0) z += disp[_z];
-    // Calculate displacement
-    _Transformation->Displacement(x, y, z, _SourceTime, _TargetTime);
-    // Update displacement
-    disp[_x] += x;
-    disp[_y] += y;
-    if (_z != 0) disp[_z] += z;
-  }
+  irtkTransformationToDisplacementImage(const irtkTransformation   *transformation,
+                                        irtkGenericImage<TReal>    &disp,
+                                        const irtkWorldCoordsImage *i2w,
+                                        double t, double t0)
+  :
+    _Transformation(transformation),
+    _Displacement  (&disp),
+    _WorldCoords   (i2w),
+    _TargetTime    (t0),
+    _SourceTime    (t)
+  {}
 
-  template <class TCoord, class TReal>
-  void operator ()(int, int, int k, int, TCoord *wc, TReal *disp)
+  void operator ()(const blocked_range<int> &re) const
   {
-    // Transform point into world coordinates
-    double x = wc[_x], y = wc[_y], z = (_z != 0 ? wc[_z] : .0);
-    // Apply current displacement
-    x += disp[_x];
-    y += disp[_y];
-    if (_z != 0) z += disp[_z];
-    // Calculate displacement
-    _Transformation->Displacement(x, y, z, _SourceTime, _TargetTime);
-    // Update displacement
-    disp[_x] += x;
-    disp[_y] += y;
-    if (_z != 0) disp[_z] += z;
-  }
+    const int  nx    = _Displacement->X();
+    const int  ny    = _Displacement->Y();
+    const int  nvox  = _Displacement->NumberOfSpatialVoxels();
+    const bool is2D  = (_Displacement->T() == 2); // 2D vectors only
+
+    double *x = new double[3 * nx];
+    double *y = x + nx;
+    double *z = y + nx;
+
+    TReal        *dx, *dy, *dz;
+    const double *wx, *wy, *wz;
+
+    for (int r = re.begin(); r != re.end(); ++r) {
+      const int j = r % ny;
+      const int k = r / ny;
+      dx = _Displacement->Data(0, j, k);
+      dy = dx + nvox;
+      dz = (is2D ? NULL : dy + nvox);
+      // Transform points into world coordinates and apply current displacement
+      if (_WorldCoords) {
+        wx = _WorldCoords->Data(0, j, k);
+        wy = wx + nvox;
+        wz = wy + nvox;
+        for (int i = 0; i < nx; ++i) {
+          x[i] = wx[i] + dx[i];
+          y[i] = wy[i] + dy[i];
+          z[i] = (dz ? wz[i] + dz[i] : .0);
+        }
+      } else {
+        for (int i = 0; i < nx; ++i) {
+          x[i] = i, y[i] = j, z[i] = (dz ? k : .0);
+          _Displacement->ImageToWorld(x[i], y[i], z[i]);
+          x[i] += dx[i];
+          y[i] += dy[i];
+          if (dz) z[i] += dz[i];
+        }
+      }
+      // Calculate displacements
+      _Transformation->DisplacementBatch(nx, x, y, z, _SourceTime, _TargetTime);
+      // Update displacements
+      for (int i = 0; i < nx; ++i) {
+        dx[i] += x[i];
+        dy[i] += y[i];
+      }
+      if (dz) {
+        for (int i = 0; i < nx; ++i) dz[i] += z[i];
+      }
+    }
 
-private:
-  int _x, _y, _z;
+    delete[] x;
+  }
 };
 
 // -----------------------------------------------------------------------------
@@ -1333,15 +1401,8 @@ void irtkTransformation::Displacement(irtkGenericImage<double> &disp, double t,
     }
   }
 
-  irtkTransformationToDisplacementImage vf;
-  vf._Displacement   = &disp;
-  vf._Transformation = this;
-  vf._TargetTime     = t0;
-  vf._SourceTime     = t;
-  vf.Initialize();
-
-  if (i2w) ParallelForEachVoxel(disp.GetImageAttributes(), *i2w, disp, vf);
-  else     ParallelForEachVoxel(disp.GetImageAttributes(),       disp, vf);
+  irtkTransformationToDisplacementImage<double> body(this, disp, i2w, t, t0);
+  parallel_for(blocked_range<int>(0, disp.Y() * disp.Z()), body);
 }
 
 // -----------------------------------------------------------------------------
@@ -1362,15 +1423,8 @@ void irtkTransformation::Displacement(irtkGenericImage<float> &disp, double t, d
     }
   }
 
-  irtkTransformationToDisplacementImage vf;
-  vf._Displacement   = &disp;
-  vf._Transformation = this;
-  vf._TargetTime     = t0;
-  vf._SourceTime     = t;
-  vf.Initialize();
-
-  if (i2w) ParallelForEachVoxel(disp.GetImageAttributes(), *i2w, disp, vf);
-  else     ParallelForEachVoxel(disp.GetImageAttributes(),       disp, vf);
+  irtkTransformationToDisplacementImage<float> body(this, disp, i2w, t, t0);
+  parallel_for(blocked_range<int>(0, disp.Y() * disp.Z()), body);
 }
 
 // -----------------------------------------------------------------------------
@@ -1636,6 +1690,238 @@ int irtkTransformation::InverseDisplacement(irtkGenericImage<float> &disp, doubl
   return vf._NumberOfSingularPoints;
 }
 
+// -----------------------------------------------------------------------------
+/// Body of irtkTransformation::FixedPointInverseDisplacement
+///
+/// For each point y, the inverse is the fixed point of x = y - u(x), where
+/// u is the displacement of the transformation. The iteration is carried out
+/// for one image row at a time, such that the displacements of all points of
+/// the row which have not converged yet are evaluated by a single call of
+/// irtkTransformation::DisplacementBatch. The iteration for each row is started
+/// at the inverse displacements of the previous row. Points for which the
+/// iteration did not converge, i.e., where the displacement is locally not a
+/// contraction, are refined using Newton's method with the 3x3 Jacobian and,
+/// if this fails as well, inverted by irtkTransformation::Inverse.
+template <class TReal>
+class irtkTransformationToFixedPointInverseDisplacementImage
+{
+  const irtkTransformation   *_Transformation;
+  irtkGenericImage<TReal>    *_Displacement;
+  const irtkWorldCoordsImage *_WorldCoords;
+  double                      _TargetTime;
+  double                      _SourceTime;
+  double                      _Tolerance;
+  int                         _MaxNumberOfIterations;
+
+public:
+
+  int _NumberOfSingularPoints;
+
+  irtkTransformationToFixedPointInverseDisplacementImage(
+    const irtkTransformation   *transformation,
+    irtkGenericImage<TReal>    &disp,
+    const irtkWorldCoordsImage *i2w,
+    double t, double t0, double tol, int maxiter
+  ) :
+    _Transformation(transformation),
+    _Displacement  (&disp),
+    _WorldCoords   (i2w),
+    _TargetTime    (t0),
+    _SourceTime    (t),
+    _Tolerance     (tol),
+    _MaxNumberOfIterations(maxiter),
+    _NumberOfSingularPoints(0)
+  {}
+
+  irtkTransformationToFixedPointInverseDisplacementImage(
+    const irtkTransformationToFixedPointInverseDisplacementImage &other, split
+  ) :
+    _Transformation(other._Transformation),
+    _Displacement  (other._Displacement),
+    _WorldCoords   (other._WorldCoords),
+    _TargetTime    (other._TargetTime),
+    _SourceTime    (other._SourceTime),
+    _Tolerance     (other._Tolerance),
+    _MaxNumberOfIterations(other._MaxNumberOfIterations),
+    _NumberOfSingularPoints(0)
+  {}
+
+  void join(const irtkTransformationToFixedPointInverseDisplacementImage &other)
+  {
+    _NumberOfSingularPoints += other._NumberOfSingularPoints;
+  }
+
+  /// Newton iteration for points at which the displacement is not contractive
+  bool Newton(double px, double py, double pz,
+              double &qx, double &qy, double &qz, bool is2D, double tol2) const
+  {
+    irtkMatrix3x3 adj;
+    double        ux, uy, uz, rx, ry, rz, det;
+    for (int iter = 0; iter < _MaxNumberOfIterations; ++iter) {
+      ux = qx, uy = qy, uz = qz;
+      _Transformation->Displacement(ux, uy, uz, _SourceTime, _TargetTime);
+      rx = qx + ux - px;
+      ry = qy + uy - py;
+      rz = (is2D ? .0 : qz + uz - pz);
+      if (rx * rx + ry * ry + rz * rz <= tol2) return true;
+      _Transformation->Jacobian(adj, qx, qy, qz, _SourceTime, _TargetTime);
+      adj.Adjugate(det);
+      if (fabs(det) < 1e-12) break;
+      qx -= (adj(0, 0) * rx + adj(0, 1) * ry + adj(0, 2) * rz) / det;
+      qy -= (adj(1, 0) * rx + adj(1, 1) * ry + adj(1, 2) * rz) / det;
+      if (!is2D) qz -= (adj(2, 0) * rx + adj(2, 1) * ry + adj(2, 2) * rz) / det;
+    }
+    qx = px, qy = py, qz = pz;
+    return false;
+  }
+
+  void operator ()(const blocked_range<int> &re)
+  {
+    const int    nx   = _Displacement->X();
+    const int    ny   = _Displacement->Y();
+    const int    nvox = _Displacement->NumberOfSpatialVoxels();
+    const bool   is2D = (_Displacement->T() == 2); // 2D vectors only
+    const double tol2 = _Tolerance * _Tolerance;
+
+    // Target points, current estimates of the inverse, batch of points whose
+    // displacement is evaluated and indices of the not yet converged points
+    double *px = new double[9 * nx];
+    double *py = px + nx;
+    double *pz = py + nx;
+    double *qx = pz + nx;
+    double *qy = qx + nx;
+    double *qz = qy + nx;
+    double *ux = qz + nx;
+    double *uy = ux + nx;
+    double *uz = uy + nx;
+    int    *active = new int[nx];
+
+    TReal        *dx, *dy, *dz;
+    const double *wx, *wy, *wz;
+    double        rx, ry, rz;
+    int           n, m, idx;
+    bool          seed = false;
+
+    for (int r = re.begin(); r != re.end(); ++r) {
+      const int j = r % ny;
+      const int k = r / ny;
+      dx = _Displacement->Data(0, j, k);
+      dy = dx + nvox;
+      dz = (is2D ? NULL : dy + nvox);
+      // Transform points into world coordinates and apply current displacement
+      if (_WorldCoords) {
+        wx = _WorldCoords->Data(0, j, k);
+        wy = wx + nvox;
+        wz = wy + nvox;
+        for (int i = 0; i < nx; ++i) {
+          px[i] = wx[i] + dx[i];
+          py[i] = wy[i] + dy[i];
+          pz[i] = (dz ? wz[i] + dz[i] : .0);
+        }
+      } else {
+        for (int i = 0; i < nx; ++i) {
+          px[i] = i, py[i] = j, pz[i] = (dz ? k : .0);
+          _Displacement->ImageToWorld(px[i], py[i], pz[i]);
+          px[i] += dx[i];
+          py[i] += dy[i];
+          if (dz) pz[i] += dz[i];
+        }
+      }
+      // Start at inverse displacements of previous row if it is a neighbor
+      if (!seed || j == 0) {
+        for (int i = 0; i < nx; ++i) {
+          qx[i] = px[i], qy[i] = py[i], qz[i] = pz[i];
+        }
+      } else {
+        for (int i = 0; i < nx; ++i) {
+          qx[i] += px[i], qy[i] += py[i], qz[i] += pz[i];
+        }
+      }
+      // Fixed-point iteration
+      n = nx;
+      for (int i = 0; i < nx; ++i) active[i] = i;
+      for (int iter = 0; n > 0 && iter < _MaxNumberOfIterations; ++iter) {
+        for (int a = 0; a < n; ++a) {
+          idx = active[a];
+          ux[a] = qx[idx], uy[a] = qy[idx], uz[a] = qz[idx];
+        }
+        _Transformation->DisplacementBatch(n, ux, uy, uz, _SourceTime, _TargetTime);
+        m = 0;
+        for (int a = 0; a < n; ++a) {
+          idx = active[a];
+          // Residual T(x) - y of current estimate
+          rx = qx[idx] + ux[a] - px[idx];
+          ry = qy[idx] + uy[a] - py[idx];
+          rz = (dz ? qz[idx] + uz[a] - pz[idx] : .0);
+          qx[idx] -= rx, qy[idx] -= ry, qz[idx] -= rz;
+          if (rx * rx + ry * ry + rz * rz > tol2) active[m++] = idx;
+        }
+        n = m;
+      }
+      // Invert remaining points using Newton's method
+      for (int a = 0; a < n; ++a) {
+        idx = active[a];
+        qx[idx] = px[idx], qy[idx] = py[idx], qz[idx] = pz[idx];
+        if (!Newton(px[idx], py[idx], pz[idx], qx[idx], qy[idx], qz[idx], is2D, tol2) &&
+            !_Transformation->Inverse(qx[idx], qy[idx], qz[idx], _SourceTime, _TargetTime)) {
+          ++_NumberOfSingularPoints;
+        }
+      }
+      // Update displacements and keep inverse displacements as next start
+      for (int i = 0; i < nx; ++i) {
+        qx[i] -= px[i], qy[i] -= py[i], qz[i] -= pz[i];
+        dx[i] += qx[i];
+        dy[i] += qy[i];
+      }
+      if (dz) {
+        for (int i = 0; i < nx; ++i) dz[i] += qz[i];
+      }
+      seed = true;
+    }
+
+    delete[] px;
+    delete[] active;
+  }
+};
+
+// -----------------------------------------------------------------------------
+template <class TReal>
+int FixedPointInverseDisplacement(const irtkTransformation *T, irtkGenericImage<TReal> &disp,
+                                  double t, double t0, const irtkWorldCoordsImage *i2w,
+                                  double tol, int maxiter)
+{
+  if (disp.T() < 2 || disp.T() > 3) {
+    cerr << "irtkTransformation::FixedPointInverseDisplacement: Input/output image must have either 2 or 3 vector components (_t)" << endl;
+    exit(1);
+  }
+  if (i2w) {
+    if (i2w->T() < 2 || i2w->T() > 3) {
+      cerr << "irtkTransformation::FixedPointInverseDisplacement: Coordinate map must have either 2 or 3 vector components (_t)" << endl;
+      exit(1);
+    }
+    if (i2w->X() != disp.X() || i2w->Y() != disp.Y() || i2w->Z() != disp.Z()) {
+      cerr << "irtkTransformation::FixedPointInverseDisplacement: Coordinate map must have the same size as the input/output image" << endl;
+      exit(1);
+    }
+  }
+
+  irtkTransformationToFixedPointInverseDisplacementImage<TReal> body(T, disp, i2w, t, t0, tol, maxiter);
+  parallel_reduce(blocked_range<int>(0, disp.Y() * disp.Z()), body);
+  return body._NumberOfSingularPoints;
+}
+
+// -----------------------------------------------------------------------------
+int irtkTransformation::FixedPointInverseDisplacement(irtkGenericImage<double> &disp, double t, double t0, const irtkWorldCoordsImage *i2w, double tol, int maxiter) const
+{
+  return ::FixedPointInverseDisplacement(this, disp, t, t0, i2w, tol, maxiter);
+}
+
+// -----------------------------------------------------------------------------
+int irtkTransformation::FixedPointInverseDisplacement(irtkGenericImage<float> &disp, double t, double t0, const irtkWorldCoordsImage *i2w, double tol, int maxiter) const
+{
+  return ::FixedPointInverseDisplacement(this, disp, t, t0, i2w, tol, maxiter);
+}
+
 // =============================================================================
 // Derivatives
 // =============================================================================
@@ -1947,7 +2233,10 @@ void irtkTransformation::Write(const char *name) const
   irtkCofstream to;
   to.Open(name);
   Write(to);
-  to.Close();
+  if (!to.Close()) {
+    cerr << this->NameOfClass() << "::Write: Failed to write file " << name << endl;
+    exit(1);
+  }
 }
 
 // -----------------------------------------------------------------------------
@@ -0,0 +1,184 @@
+/* The Image Registration Toolkit (IRTK)
+ *
+ * Copyright 2008-2015 Imperial College London
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include <gtest/gtest.h>
+
+#include <irtkImage.h>
+#include <irtkImageFastFourierTransform.h>
+
+// Single precision images, error relative to the maximum magnitude
+static const double tol = 1e-5;
+
+// ===========================================================================
+// Auxiliary functions
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+/// Image with random values in [-1, 1]
+irtkGenericImage<float> RandomImage(int x, int y, int z)
+{
+  irtkGenericImage<float> image(x, y, z);
+  float *p = image.GetPointerToVoxels();
+  for (int idx = 0; idx < image.NumberOfVoxels(); ++idx, ++p) {
+    *p = static_cast<float>(2.0 * rand() / RAND_MAX - 1.0);
+  }
+  return image;
+}
+
+// ---------------------------------------------------------------------------
+/// Transform all lines along one axis using the Numerical Recipes FFT as
+/// done by the former implementation of DirectFFT and InverseFFT
+void LineFFT(irtkGenericImage<float> &re, irtkGenericImage<float> &im, int dim, int isign)
+{
+  const int size[3] = {re.X(), re.Y(), re.Z()};
+  const int n = size[dim];
+  const float norm = static_cast<float>(sqrt(static_cast<double>(n)));
+  vector<float> data(2 * n + 1);
+  int p[3];
+  for (p[2] = 0; p[2] < (dim == 2 ? 1 : size[2]); ++p[2])
+  for (p[1] = 0; p[1] < (dim == 1 ? 1 : size[1]); ++p[1])
+  for (p[0] = 0; p[0] < (dim == 0 ? 1 : size[0]); ++p[0]) {
+    int q[3] = {p[0], p[1], p[2]};
+    for (q[dim] = 0; q[dim] < n; ++q[dim]) {
+      data[2 * q[dim] + 1] = re(q[0], q[1], q[2]);
+      data[2 * q[dim] + 2] = im(q[0], q[1], q[2]);
+    }
+    four1NR(&data[0], static_cast<unsigned long>(n), isign);
+    for (q[dim] = 0; q[dim] < n; ++q[dim]) {
+      re(q[0], q[1], q[2]) = data[2 * q[dim] + 1] / norm;
+      im(q[0], q[1], q[2]) = data[2 * q[dim] + 2] / norm;
+    }
+  }
+}
+
+// ---------------------------------------------------------------------------
+/// Former implementation of DirectFFT (isign=1) and InverseFFT (isign=-1)
+void OldFFT(irtkGenericImage<float> &re, irtkGenericImage<float> &im, int isign)
+{
+  for (int dim = 0; dim < 3; ++dim) LineFFT(re, im, dim, isign);
+}
+
+// ---------------------------------------------------------------------------
+/// Naive unitary discrete Fourier transform for any image size
+void NaiveDFT(irtkGenericImage<float> &re, irtkGenericImage<float> &im, int isign)
+{
+  const int nx = re.X(), ny = re.Y(), nz = re.Z();
+  irtkGenericImage<float> out_re(re.Attributes()), out_im(im.Attributes());
+  const double norm = sqrt(static_cast<double>(nx * ny * nz));
+  for (int w = 0; w < nz; ++w)
+  for (int v = 0; v < ny; ++v)
+  for (int u = 0; u < nx; ++u) {
+    double sr = .0, si = .0;
+    for (int k = 0; k < nz; ++k)
+    for (int j = 0; j < ny; ++j)
+    for (int i = 0; i < nx; ++i) {
+      const double a = isign * 2.0 * M_PI * (static_cast<double>(u * i) / nx +
+                                             static_cast<double>(v * j) / ny +
+                                             static_cast<double>(w * k) / nz);
+      sr += re(i, j, k) * cos(a) - im(i, j, k) * sin(a);
+      si += re(i, j, k) * sin(a) + im(i, j, k) * cos(a);
+    }
+    out_re(u, v, w) = static_cast<float>(sr / norm);
+    out_im(u, v, w) = static_cast<float>(si / norm);
+  }
+  re = out_re, im = out_im;
+}
+
+// ---------------------------------------------------------------------------
+/// Maximum difference of complex images relative to maximum magnitude
+double MaxRelativeError(const irtkGenericImage<float> &re1, const irtkGenericImage<float> &im1,
+                        const irtkGenericImage<float> &re2, const irtkGenericImage<float> &im2)
+{
+  double max_mag = .0, max_err = .0;
+  for (int idx = 0; idx < re1.NumberOfVoxels(); ++idx) {
+    max_mag = max(max_mag, sqrt(pow(re1(idx), 2) + pow(im1(idx), 2)));
+    max_err = max(max_err, sqrt(pow(re2(idx) - re1(idx), 2) + pow(im2(idx) - im1(idx), 2)));
+  }
+  return max_err / max_mag;
+}
+
+// ---------------------------------------------------------------------------
+/// Compare transform of random complex image with reference implementation
+void TestFFT(int x, int y, int z, bool inverse, bool naive)
+{
+  irtkGenericImage<float> re = RandomImage(x, y, z), expected_re(re);
+  irtkGenericImage<float> im = RandomImage(x, y, z), expected_im(im);
+  const int isign = (inverse ? -1 : 1);
+  if (naive) NaiveDFT(expected_re, expected_im, isign);
+  else       OldFFT  (expected_re, expected_im, isign);
+  if (inverse) InverseFFT(&re, &im);
+  else         DirectFFT (&re, &im);
+  EXPECT_LT(MaxRelativeError(expected_re, expected_im, re, im), tol)
+      << "size=" << x << "x" << y << "x" << z;
+}
+
+// ===========================================================================
+// Tests
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+TEST(irtkImageFastFourierTransform, DirectFFTPowerOfTwo)
+{
+  srand(42);
+  TestFFT(16, 8, 4, false, false);
+  TestFFT(32, 1, 1, false, false);
+}
+
+// ---------------------------------------------------------------------------
+TEST(irtkImageFastFourierTransform, InverseFFTPowerOfTwo)
+{
+  srand(42);
+  TestFFT(16, 8, 4, true, false);
+  TestFFT(32, 1, 1, true, false);
+}
+
+// ---------------------------------------------------------------------------
+TEST(irtkImageFastFourierTransform, DirectFFTAnySize)
+{
+  srand(42);
+  TestFFT(12, 10, 7, false, true);
+  TestFFT(9, 16, 3, false, true);
+}
+
+// ---------------------------------------------------------------------------
+TEST(irtkImageFastFourierTransform, InverseFFTAnySize)
+{
+  srand(42);
+  TestFFT(12, 10, 7, true, true);
+  TestFFT(9, 16, 3, true, true);
+}
+
+// ---------------------------------------------------------------------------
+TEST(irtkImageFastFourierTransform, RoundTrip)
+{
+  srand(42);
+  irtkGenericImage<float> re = RandomImage(24, 20, 13), input_re(re);
+  irtkGenericImage<float> im = RandomImage(24, 20, 13), input_im(im);
+  DirectFFT (&re, &im);
+  InverseFFT(&re, &im);
+  EXPECT_LT(MaxRelativeError(input_re, input_im, re, im), tol);
+}
+
+// ===========================================================================
+// Main
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,170 @@
+/* The Image Registration Toolkit (IRTK)
+ *
+ * Copyright 2008-2015 Imperial College London
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include <gtest/gtest.h>
+
+#include <irtkTransformation.h>
+
+#include "irtkTransformationTestUtils.h"
+
+static const int    number_of_points = 1000;
+static const double tol              = 1e-2;
+
+// ===========================================================================
+// Auxiliary functions
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+/// Multi-level FFD whose levels are successive subdivisions of the first level
+irtkMultiLevelFreeFormTransformation *SubdividedLevels(int nlevels)
+{
+  irtkMultiLevelFreeFormTransformation *mffd = new irtkMultiLevelFreeFormTransformation;
+  irtkBSplineFreeFormTransformation3D  *ffd;
+  ffd = new irtkBSplineFreeFormTransformation3D(DeformationDomain(), 8.0, 8.0, 8.0);
+  for (int l = 0; l < nlevels; ++l) {
+    if (l > 0) {
+      ffd = new irtkBSplineFreeFormTransformation3D(*ffd);
+      ffd->Subdivide();
+    }
+    Randomize(ffd, 2.0 / (l + 1));
+    mffd->PushLocalTransformation(ffd);
+  }
+  return mffd;
+}
+
+// ---------------------------------------------------------------------------
+/// Copy levels of multi-level FFD with cubic B-spline displacement fields
+irtkMultiLevelFreeFormTransformation *Copy(const irtkMultiLevelFreeFormTransformation &mffd)
+{
+  irtkMultiLevelFreeFormTransformation *copy = new irtkMultiLevelFreeFormTransformation;
+  for (int l = 0; l < mffd.NumberOfLevels(); ++l) {
+    const irtkBSplineFreeFormTransformation3D *ffd;
+    ffd = dynamic_cast<const irtkBSplineFreeFormTransformation3D *>(mffd.GetLocalTransformation(l));
+    copy->PushLocalTransformation(new irtkBSplineFreeFormTransformation3D(*ffd));
+  }
+  return copy;
+}
+
+// ---------------------------------------------------------------------------
+/// Maximum distance between points transformed by the two transformations
+/// at random points inside the image domain
+double MaxDifference(const irtkTransformation *t1, const irtkTransformation *t2)
+{
+  const irtkImageAttributes domain = DeformationDomain();
+  double x1, y1, z1, x2, y2, z2, d, max_d = .0;
+  for (int n = 0; n < number_of_points; ++n) {
+    x1 = (domain._x - 1) * static_cast<double>(rand()) / RAND_MAX;
+    y1 = (domain._y - 1) * static_cast<double>(rand()) / RAND_MAX;
+    z1 = (domain._z - 1) * static_cast<double>(rand()) / RAND_MAX;
+    domain.LatticeToWorld(x1, y1, z1);
+    x2 = x1, y2 = y1, z2 = z1;
+    t1->Transform(x1, y1, z1);
+    t2->Transform(x2, y2, z2);
+    d = sqrt(pow(x2 - x1, 2) + pow(y2 - y1, 2) + pow(z2 - z1, 2));
+    if (d > max_d) max_d = d;
+  }
+  return max_d;
+}
+
+// ===========================================================================
+// Tests
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+TEST(irtkMultiLevelFreeFormTransformation, CombineSameLattice)
+{
+  srand(42);
+  irtkMultiLevelFreeFormTransformation mffd;
+  for (int l = 0; l < 3; ++l) {
+    irtkBSplineFreeFormTransformation3D *ffd;
+    ffd = new irtkBSplineFreeFormTransformation3D(DeformationDomain(), 4.0, 4.0, 4.0);
+    Randomize(ffd, 2.0);
+    mffd.PushLocalTransformation(ffd);
+  }
+  std::unique_ptr<irtkMultiLevelFreeFormTransformation> flat(Copy(mffd));
+  ASSERT_TRUE(flat->CanCombineLocalTransformation());
+  flat->CombineLocalTransformation();
+  EXPECT_EQ(1, flat->NumberOfLevels());
+  EXPECT_LT(MaxDifference(&mffd, flat.get()), tol);
+}
+
+// ---------------------------------------------------------------------------
+TEST(irtkMultiLevelFreeFormTransformation, CombineSubdividedLattices)
+{
+  srand(42);
+  std::unique_ptr<irtkMultiLevelFreeFormTransformation> mffd(SubdividedLevels(3));
+  std::unique_ptr<irtkMultiLevelFreeFormTransformation> flat(Copy(*mffd));
+  ASSERT_TRUE(flat->CanCombineLocalTransformation());
+  flat->CombineLocalTransformation();
+  EXPECT_EQ(1, flat->NumberOfLevels());
+  EXPECT_LT(MaxDifference(mffd.get(), flat.get()), tol);
+}
+
+// ---------------------------------------------------------------------------
+TEST(irtkMultiLevelFreeFormTransformation, CannotCombineVelocityLevels)
+{
+  srand(42);
+  irtkMultiLevelFreeFormTransformation mffd;
+  for (int l = 0; l < 2; ++l) {
+    irtkBSplineFreeFormTransformationSV *ffd;
+    ffd = new irtkBSplineFreeFormTransformationSV(DeformationDomain(), 4.0, 4.0, 4.0);
+    Randomize(ffd, 1.0);
+    mffd.PushLocalTransformation(ffd);
+  }
+  EXPECT_FALSE(mffd.CanCombineLocalTransformation());
+}
+
+// ---------------------------------------------------------------------------
+TEST(irtkMultiLevelFreeFormTransformation, CannotCombineDifferentLattices)
+{
+  irtkMultiLevelFreeFormTransformation mffd;
+  mffd.PushLocalTransformation(new irtkBSplineFreeFormTransformation3D(DeformationDomain(), 8.0, 8.0, 8.0));
+  mffd.PushLocalTransformation(new irtkBSplineFreeFormTransformation3D(DeformationDomain(), 3.0, 3.0, 3.0));
+  EXPECT_FALSE(mffd.CanCombineLocalTransformation());
+}
+
+// ---------------------------------------------------------------------------
+TEST(irtkMultiLevelFreeFormTransformation, OnlyCombineSubdividableLevelsOnDifferentLattices)
+{
+  srand(42);
+  irtkBSplineFreeFormTransformation3D coarse(DeformationDomain(), 8.0, 8.0, 8.0);
+  Randomize(&coarse, 2.0);
+  irtkBSplineFreeFormTransformation3D fine(coarse);
+  fine.Subdivide();
+  EXPECT_TRUE (coarse.CanSubdivide());
+  EXPECT_FALSE(irtkBSplineFreeFormTransformationSV(DeformationDomain(), 8.0, 8.0, 8.0).CanSubdivide());
+  // Linear FFD coefficients can be summed on the same lattice only
+  irtkMultiLevelFreeFormTransformation same;
+  same.PushLocalTransformation(new irtkLinearFreeFormTransformation3D(fine));
+  same.PushLocalTransformation(new irtkLinearFreeFormTransformation3D(fine));
+  EXPECT_FALSE(same.GetLocalTransformation(0)->CanSubdivide());
+  EXPECT_TRUE (same.CanCombineLocalTransformation());
+  irtkMultiLevelFreeFormTransformation subdivided;
+  subdivided.PushLocalTransformation(new irtkLinearFreeFormTransformation3D(coarse));
+  subdivided.PushLocalTransformation(new irtkLinearFreeFormTransformation3D(fine));
+  EXPECT_FALSE(subdivided.CanCombineLocalTransformation());
+}
+
+// ===========================================================================
+// Main
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
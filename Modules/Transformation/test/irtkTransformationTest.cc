@@ -0,0 +1,377 @@
+/* The Image Registration Toolkit (IRTK)
+ *
+ * Copyright 2008-2015 Imperial College London
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include <gtest/gtest.h>
+
+#include <irtkTransformation.h>
+#include <irtkImageTransformation.h>
+
+#include "irtkTransformationTestUtils.h"
+
+#include <thread>
+
+static const double tol = 1e-2;
+
+// ===========================================================================
+// Auxiliary functions
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+/// Zero displacement field with three vector components
+irtkGenericImage<double> ZeroDisplacement()
+{
+  irtkImageAttributes attr = DeformationDomain();
+  attr._t  = 3;
+  attr._dt = .0;
+  return irtkGenericImage<double>(attr);
+}
+
+// ---------------------------------------------------------------------------
+/// Maximum residual |T(y + d(y)) - y| of inverse displacements d at voxels y
+double MaxResidual(const irtkTransformation &T, const irtkGenericImage<double> &disp)
+{
+  double x, y, z, wx, wy, wz, r, max_r = .0;
+  for (int k = 0; k < disp.Z(); ++k)
+  for (int j = 0; j < disp.Y(); ++j)
+  for (int i = 0; i < disp.X(); ++i) {
+    wx = i, wy = j, wz = k;
+    disp.ImageToWorld(wx, wy, wz);
+    x = wx + disp(i, j, k, 0);
+    y = wy + disp(i, j, k, 1);
+    z = wz + disp(i, j, k, 2);
+    T.Transform(x, y, z);
+    r = sqrt(pow(x - wx, 2) + pow(y - wy, 2) + pow(z - wz, 2));
+    if (r > max_r) max_r = r;
+  }
+  return max_r;
+}
+
+// ---------------------------------------------------------------------------
+/// Random point within the domain in world coordinates
+void RandomPoint(const irtkImageAttributes &domain, double &x, double &y, double &z)
+{
+  x = (domain._x - 1) * static_cast<double>(rand()) / RAND_MAX;
+  y = (domain._y - 1) * static_cast<double>(rand()) / RAND_MAX;
+  z = (domain._z - 1) * static_cast<double>(rand()) / RAND_MAX;
+  domain.LatticeToWorld(x, y, z);
+}
+
+// ---------------------------------------------------------------------------
+/// Compare 3x3 matrix with irtkMatrix, where missing entries must be zero
+void ExpectEqualMatrix(const irtkMatrix3x3 &a, const irtkMatrix &b, double eps)
+{
+  for (int r = 0; r < 3; ++r)
+  for (int c = 0; c < 3; ++c) {
+    const double v = (r < b.Rows() && c < b.Cols() ? b(r, c) : .0);
+    EXPECT_NEAR(v, a(r, c), eps) << "entry (" << r << ", " << c << ")";
+  }
+}
+
+// ---------------------------------------------------------------------------
+/// Compare derivatives evaluated by 3x3 and irtkMatrix overloads
+void TestBSplineJacobian3x3(const irtkImageAttributes &domain)
+{
+  irtkBSplineFreeFormTransformation3D ffd(domain, 5.0, 5.0, 5.0);
+  Randomize(&ffd, 2.0);
+  const double eps = 1e-12;
+
+  irtkMatrix    m, mdetdev[3];
+  irtkMatrix3x3 a, adetdev[3];
+  double        x, y, z;
+
+  for (int n = 0; n < 20; ++n) {
+    RandomPoint(domain, x, y, z);
+    SCOPED_TRACE(::testing::Message() << "point (" << x << ", " << y << ", " << z << ")");
+    ffd.LocalJacobian(m, x, y, z);
+    ffd.LocalJacobian(a, x, y, z);
+    ExpectEqualMatrix(a, m, eps);
+    ffd.Jacobian(m, x, y, z);
+    ffd.Jacobian(a, x, y, z);
+    ExpectEqualMatrix(a, m, eps);
+    for (int dof = 0; dof < ffd.NumberOfDOFs(); dof += 7) {
+      ffd.DeriveJacobianWrtDOF(m, dof, x, y, z);
+      ffd.DeriveJacobianWrtDOF(a, dof, x, y, z);
+      ExpectEqualMatrix(a, m, eps);
+    }
+  }
+  // Offsets beyond the support of the B-spline kernel yield zero derivatives
+  for (int k = -2; k <= 2; ++k)
+  for (int j = -2; j <= 2; ++j)
+  for (int i = -2; i <= 2; ++i) {
+    ffd.JacobianDetDerivative(mdetdev, i, j, k);
+    ffd.JacobianDetDerivative(adetdev, i, j, k);
+    for (int d = 0; d < 3; ++d) {
+      SCOPED_TRACE(::testing::Message() << "offset (" << i << ", " << j << ", " << k << "), component " << d);
+      ExpectEqualMatrix(adetdev[d], mdetdev[d], eps);
+    }
+  }
+}
+
+// ===========================================================================
+// Tests
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+TEST(irtkTransformation, FixedPointInverseDisplacement)
+{
+  srand(42);
+  irtkBSplineFreeFormTransformation3D ffd(DeformationDomain(), 5.0, 5.0, 5.0);
+  Randomize(&ffd, 1.0);
+  irtkGenericImage<double> disp = ZeroDisplacement();
+  EXPECT_EQ(0, ffd.FixedPointInverseDisplacement(disp, .0, .0, NULL, tol));
+  EXPECT_LT(MaxResidual(ffd, disp), tol);
+}
+
+// ---------------------------------------------------------------------------
+TEST(irtkTransformation, FixedPointInverseDisplacementEqualsInverseDisplacement)
+{
+  srand(42);
+  irtkBSplineFreeFormTransformation3D ffd(DeformationDomain(), 5.0, 5.0, 5.0);
+  Randomize(&ffd, 1.0);
+  irtkGenericImage<double> disp1 = ZeroDisplacement();
+  irtkGenericImage<double> disp2 = ZeroDisplacement();
+  const int n1 = ffd.InverseDisplacement(disp1, .0, .0);
+  const int n2 = ffd.FixedPointInverseDisplacement(disp2, .0, .0, NULL, tol);
+  EXPECT_EQ(n1, n2);
+  double d, max_d = .0;
+  for (int idx = 0; idx < disp1.NumberOfVoxels(); ++idx) {
+    d = fabs(disp1(idx) - disp2(idx));
+    if (d > max_d) max_d = d;
+  }
+  // Each inverse is within its own tolerance of the exact solution and the
+  // inverse Jacobian of this deformation is close to identity
+  EXPECT_LT(max_d, 10.0 * tol);
+}
+
+// ---------------------------------------------------------------------------
+TEST(irtkTransformation, FixedPointInverseDisplacementAddsToInput)
+{
+  srand(42);
+  irtkBSplineFreeFormTransformation3D ffd(DeformationDomain(), 5.0, 5.0, 5.0);
+  Randomize(&ffd, 1.0);
+  irtkGenericImage<double> disp = ZeroDisplacement();
+  ffd.FixedPointInverseDisplacement(disp, .0, .0, NULL, tol);
+  // Inverting the identity adds nothing to the input displacements
+  irtkBSplineFreeFormTransformation3D identity(DeformationDomain(), 5.0, 5.0, 5.0);
+  irtkGenericImage<double> copy(disp);
+  EXPECT_EQ(0, identity.FixedPointInverseDisplacement(copy, .0, .0, NULL, tol));
+  for (int idx = 0; idx < disp.NumberOfVoxels(); ++idx) {
+    ASSERT_NEAR(disp(idx), copy(idx), 1e-9);
+  }
+}
+
+// ---------------------------------------------------------------------------
+TEST(irtkImageTransformation, FixedPointInversionModifiesCache)
+{
+  irtkImageTransformationCache cache;
+  cache.Initialize(DeformationDomain(), 3);
+  irtkImageTransformation filter;
+  filter.SetCache(&cache);
+  // Forward displacements do not depend on the inversion method
+  cache.Modified(false);
+  filter.FixedPointInversion(true);
+  EXPECT_FALSE(cache.Modified());
+  // Inverse displacements do
+  filter.InvertOn();
+  cache.Modified(false);
+  filter.FixedPointInversion(false);
+  EXPECT_TRUE(cache.Modified());
+  cache.Modified(false);
+  filter.FixedPointInversion(false);
+  EXPECT_FALSE(cache.Modified());
+  filter.FixedPointInversion(true);
+  EXPECT_TRUE(cache.Modified());
+}
+
+// ---------------------------------------------------------------------------
+TEST(irtkBSplineFreeFormTransformationSV, ConcurrentScalingAndSquaring)
+{
+  srand(42);
+  irtkBSplineFreeFormTransformationSV ffd(DeformationDomain(), 5.0, 5.0, 5.0);
+  Randomize(&ffd, 1.0);
+  const irtkImageAttributes attr = DeformationDomain();
+  // Serial exponentiations, the second one reuses the shared workspace,
+  // where the output displacements are composed with the zero input
+  irtkGenericImage<double> d0(attr, 3), jac0, lj0;
+  ffd.ScalingAndSquaring<double>(attr, &d0, &jac0, NULL, &lj0);
+  irtkGenericImage<double> d1(attr, 3), jac1, lj1;
+  ffd.ScalingAndSquaring<double>(attr, &d1, &jac1, NULL, &lj1);
+  for (int idx = 0; idx < d0  .NumberOfVoxels(); ++idx) ASSERT_EQ(d0  (idx), d1  (idx));
+  for (int idx = 0; idx < jac0.NumberOfVoxels(); ++idx) ASSERT_EQ(jac0(idx), jac1(idx));
+  for (int idx = 0; idx < lj0 .NumberOfVoxels(); ++idx) ASSERT_EQ(lj0 (idx), lj1 (idx));
+  // Concurrent exponentiations of the same velocity field, of which only
+  // one at a time can use the shared workspace
+  const int n = 4;
+  irtkGenericImage<double> d[n], jac[n], lj[n];
+  std::thread threads[n];
+  for (int t = 0; t < n; ++t) {
+    d[t].Initialize(attr, 3);
+    threads[t] = std::thread([&, t]() {
+      ffd.ScalingAndSquaring<double>(attr, &d[t], &jac[t], NULL, &lj[t]);
+    });
+  }
+  for (int t = 0; t < n; ++t) threads[t].join();
+  for (int t = 0; t < n; ++t) {
+    for (int idx = 0; idx < d0  .NumberOfVoxels(); ++idx) ASSERT_EQ(d0  (idx), d  [t](idx));
+    for (int idx = 0; idx < jac0.NumberOfVoxels(); ++idx) ASSERT_EQ(jac0(idx), jac[t](idx));
+    for (int idx = 0; idx < lj0 .NumberOfVoxels(); ++idx) ASSERT_EQ(lj0 (idx), lj [t](idx));
+  }
+}
+
+// ---------------------------------------------------------------------------
+TEST(irtkFreeFormTransformationRungeKutta, TransformBatchEqualsTransform)
+{
+  // Integration methods with fixed step size integrate each block of points
+  // exactly like each single point. Embedded methods adapt the step size per
+  // block, so the result may differ by the local error tolerance of each step.
+  const FFDIntegrationMethod fixed[] = {
+    FFDIM_RKE1, FFDIM_RKE2, FFDIM_RKH2, FFDIM_RK4
+  };
+  const FFDIntegrationMethod adaptive[] = {
+    FFDIM_RKEH12, FFDIM_RKBS23, FFDIM_RKF45, FFDIM_RKCK45, FFDIM_RKDP45
+  };
+  srand(42);
+  irtkBSplineFreeFormTransformationSV ffd(DeformationDomain(), 5.0, 5.0, 5.0);
+  Randomize(&ffd, 2.0);
+  // Points of several blocks, where the last block is incomplete
+  const int n = 200;
+  const irtkImageAttributes domain = DeformationDomain();
+  double x0[n], y0[n], z0[n], x[n], y[n], z[n];
+  for (int i = 0; i < n; ++i) {
+    x0[i] = (domain._x - 1) * static_cast<double>(rand()) / RAND_MAX;
+    y0[i] = (domain._y - 1) * static_cast<double>(rand()) / RAND_MAX;
+    z0[i] = (domain._z - 1) * static_cast<double>(rand()) / RAND_MAX;
+    domain.LatticeToWorld(x0[i], y0[i], z0[i]);
+  }
+  for (int m = 0; m < 9; ++m) {
+    const bool                 fsteps = (m < 4);
+    const FFDIntegrationMethod method = (fsteps ? fixed[m] : adaptive[m - 4]);
+    ffd.IntegrationMethod(method);
+    // Local error tolerance of each integration step times maximum number of steps
+    const double maxerr = (fsteps ? .0 : 1e-3 * 2.0 * ffd.NumberOfSteps());
+    memcpy(x, x0, n * sizeof(double));
+    memcpy(y, y0, n * sizeof(double));
+    memcpy(z, z0, n * sizeof(double));
+    ffd.TransformBatch(n, x, y, z, 1.0, .0);
+    double px, py, pz, err = .0;
+    for (int i = 0; i < n; ++i) {
+      px = x0[i], py = y0[i], pz = z0[i];
+      ffd.Transform(px, py, pz, 1.0, .0);
+      err = max(err, max(max(fabs(px - x[i]), fabs(py - y[i])), fabs(pz - z[i])));
+    }
+    if (fsteps) EXPECT_EQ(.0, err) << "integration method " << ToString(method);
+    else        EXPECT_LE(err, maxerr) << "integration method " << ToString(method);
+  }
+}
+
+// ---------------------------------------------------------------------------
+TEST(irtkMatrix3x3, Adjugate)
+{
+  srand(42);
+  for (int n = 0; n < 10; ++n) {
+    irtkMatrix3x3 a;
+    irtkMatrix    m(3, 3);
+    for (int r = 0; r < 3; ++r)
+    for (int c = 0; c < 3; ++c) {
+      a(r, c) = m(r, c) = 2.0 * rand() / RAND_MAX - 1.0;
+    }
+    double adet, mdet;
+    a.Adjugate(adet);
+    m.Adjugate(mdet);
+    EXPECT_NEAR(mdet, adet, 1e-12);
+    ExpectEqualMatrix(a, m, 1e-12);
+  }
+  // Unlike irtkMatrix::Adjugate, a singular matrix is valid input
+  const irtkMatrix3x3 s(1.0, 2.0, 3.0,
+                        4.0, 5.0, 6.0,
+                        7.0, 8.0, 9.0);
+  irtkMatrix3x3 adj(s);
+  double        det;
+  adj.Adjugate(det);
+  EXPECT_EQ(.0, det);
+  EXPECT_TRUE(adj == irtkMatrix3x3(-3.0,   6.0, -3.0,
+                                    6.0, -12.0,  6.0,
+                                   -3.0,   6.0, -3.0));
+  EXPECT_TRUE(s * adj == irtkMatrix3x3(.0));
+}
+
+// ---------------------------------------------------------------------------
+TEST(irtkBSplineFreeFormTransformation3D, Jacobian3x3EqualsJacobian)
+{
+  srand(42);
+  irtkImageAttributes domain = DeformationDomain();
+  TestBSplineJacobian3x3(domain);
+  domain._z = 1;
+  TestBSplineJacobian3x3(domain);
+}
+
+// ---------------------------------------------------------------------------
+TEST(irtkTransformation, Jacobian3x3OverloadsNotHidden)
+{
+  // Calls through the static type of each transformation, where a subclass
+  // which declares only the irtkMatrix overload would hide the 3x3 ones
+  srand(42);
+  const irtkImageAttributes domain = DeformationDomain();
+  irtkMatrix    m;
+  irtkMatrix3x3 a;
+  double        x, y, z;
+  RandomPoint(domain, x, y, z);
+
+  irtkAffineTransformation affine;
+  affine.PutRotationX(10.0);
+  affine.PutTranslationX(2.0);
+  affine.PutScaleX(110.0);
+  affine.PutShearXY(5.0);
+  affine.LocalJacobian(m, x, y, z);
+  affine.LocalJacobian(a, x, y, z);
+  ExpectEqualMatrix(a, m, 1e-12);
+  affine.Jacobian(m, x, y, z);
+  affine.Jacobian(a, x, y, z);
+  ExpectEqualMatrix(a, m, 1e-12);
+  for (int dof = 0; dof < affine.NumberOfDOFs(); ++dof) {
+    affine.DeriveJacobianWrtDOF(m, dof, x, y, z);
+    affine.DeriveJacobianWrtDOF(a, dof, x, y, z);
+    ExpectEqualMatrix(a, m, 1e-12);
+  }
+
+  irtkBSplineFreeFormTransformation3D *ffd;
+  ffd = new irtkBSplineFreeFormTransformation3D(domain, 5.0, 5.0, 5.0);
+  Randomize(ffd, 2.0);
+  irtkMultiLevelFreeFormTransformation mffd(affine);
+  mffd.PushLocalTransformation(ffd);
+  mffd.LocalJacobian(m, x, y, z);
+  mffd.LocalJacobian(a, x, y, z);
+  ExpectEqualMatrix(a, m, 1e-12);
+  mffd.Jacobian(m, x, y, z);
+  mffd.Jacobian(a, x, y, z);
+  ExpectEqualMatrix(a, m, 1e-12);
+  for (int dof = 0; dof < mffd.NumberOfDOFs(); dof += 7) {
+    mffd.DeriveJacobianWrtDOF(m, dof, x, y, z);
+    mffd.DeriveJacobianWrtDOF(a, dof, x, y, z);
+    ExpectEqualMatrix(a, m, 1e-12);
+  }
+}
+
+// ===========================================================================
+// Main
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,47 @@
+/* The Image Registration Toolkit (IRTK)
+ *
+ * Copyright 2008-2015 Imperial College London
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#ifndef _IRTKTRANSFORMATIONTESTUTILS_H
+
+#define _IRTKTRANSFORMATIONTESTUTILS_H
+
+#include <irtkTransformation.h>
+
+// ===========================================================================
+// Auxiliary functions shared by transformation and registration tests
+// ===========================================================================
+
+// ---------------------------------------------------------------------------
+/// Anisotropic image domain of free-form deformations and displacement fields
+inline irtkImageAttributes DeformationDomain()
+{
+  irtkImageAttributes domain;
+  domain._x  = 32,  domain._y  = 28,  domain._z  = 24;
+  domain._dx = 1.0, domain._dy = 1.2, domain._dz = 1.5;
+  return domain;
+}
+
+// ---------------------------------------------------------------------------
+/// Set control point coefficients of free-form deformation to random values
+/// in [-max, max]
+inline void Randomize(irtkFreeFormTransformation *ffd, double max)
+{
+  for (int dof = 0; dof < ffd->NumberOfDOFs(); ++dof) {
+    ffd->Put(dof, max * (2.0 * rand() / RAND_MAX - 1.0));
+  }
+}
+
+#endif